@@ -40,6 +40,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define IPA_CONNTRACK_MESSAGE_H
 
 #include <pthread.h>
+#include <time.h>
 #include "IPACM_Defs.h"
 
 
@@ -67,11 +68,14 @@ private:
 
 public:
 	cmd_t evt;
+	struct timespec enq_ts;
 
 	Message()
 	{
 		m_next = NULL;
 		evt.callback_ptr = NULL;
+		enq_ts.tv_sec = 0;
+		enq_ts.tv_nsec = 0;
 	}
 	~Message() { }
 	void setnext(Message *item) { m_next = item; }
@@ -84,6 +88,7 @@ class MessageQueue
 private:
 	Message *Head;
 	Message *Tail;
+	int depth;
 	Message* dequeue(void);
 	static MessageQueue *inst_internal;
 	static MessageQueue *inst_external;
@@ -92,6 +97,7 @@ private:
 	{
 		Head = NULL;
 		Tail = NULL;
+		depth = 0;
 	}
 
 public:
@@ -99,7 +105,18 @@ public:
 	~MessageQueue() { }
 	void enqueue(Message *item);
 
+	/* number of queued messages, caller holds the queue mutex */
+	int getDepth(void) { return depth; }
+
 	static void* Process(void *);
+
+	/* process queued messages in the calling thread until both queues
+	   are empty, returns the number processed (used by ipacm_replay) */
+	static int Drain(void);
+
+	/* start the event recording, events already queued while ipacm
+	   was starting up are recorded first */
+	static int StartRecording(const char *path);
 	static MessageQueue* getInstanceInternal();
 	static MessageQueue* getInstanceExternal();
 
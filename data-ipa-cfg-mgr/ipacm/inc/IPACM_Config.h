@@ -43,12 +43,16 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Defs.h"
 #include "IPACM_Xml.h"
 #include "IPACM_EvtDispatcher.h"
+#include "IPACM_FlowClassifier.h"
 
 typedef struct
 {
   char iface_name[IPA_IFACE_NAME_LEN];
 }NatIfaces;
 
+/* linux ifindex values below this are mapped to iface_table directly */
+#define IPA_MAX_NETLINK_IFINDEX 256
+
 /* for IPACM rm dependency use*/
 typedef struct _ipa_rm_client
 {
@@ -109,6 +113,19 @@ public:
 
 	int ipa_nat_max_entries;
 
+	int ipa_nat_pending_max_entries;
+
+	/* Max clients per interface and max interfaces of the lan2lan controller, 0 uses the defaults */
+	int ipa_lan2lan_max_client;
+
+	int ipa_lan2lan_max_iface;
+
+	/* Size of the IPv6 conntrack flow table, 0 uses the default, negative disables it */
+	int ipa_v6flow_max_flows;
+
+	/* Size of the neighbor client cache, 0 uses the default */
+	int ipa_neighbor_max_client;
+
 	bool ipacm_odu_router_mode;
 
 	bool ipacm_odu_enable;
@@ -117,6 +134,12 @@ public:
 
 	bool ipacm_ip_passthrough_mode;
 
+	/* Record posted events to IPACM_EVT_RECORD_FILE for ipacm_replay */
+	bool ipacm_record_events;
+
+	/* Number of per-interface event worker threads, 0 processes all events inline */
+	int ipa_event_workers;
+
 	int ipa_nat_iface_entries;
 
 	/* Store the total number of wlan guest ap configured */
@@ -159,12 +182,12 @@ public:
 		}
 		if(iptype == IPA_IP_v4)
 		{
-			flt_rule_count_v4[index] += increment;
+			__sync_fetch_and_add(&flt_rule_count_v4[index], increment);
 			IPACMDBG_H("Now num of v4 flt rules on client %d is %d.\n", index, flt_rule_count_v4[index]);
 		}
 		else
 		{
-			flt_rule_count_v6[index] += increment;
+			__sync_fetch_and_add(&flt_rule_count_v6[index], increment);
 			IPACMDBG_H("Now num of v6 flt rules on client %d is %d.\n", index, flt_rule_count_v6[index]);
 		}
 		return;
@@ -179,12 +202,12 @@ public:
 		}
 		if(iptype == IPA_IP_v4)
 		{
-			flt_rule_count_v4[index] -= decrement;
+			__sync_fetch_and_sub(&flt_rule_count_v4[index], decrement);
 			IPACMDBG_H("Now num of v4 flt rules on client %d is %d.\n", index, flt_rule_count_v4[index]);
 		}
 		else
 		{
-			flt_rule_count_v6[index] -= decrement;
+			__sync_fetch_and_sub(&flt_rule_count_v6[index], decrement);
 			IPACMDBG_H("Now num of v6 flt rules on client %d is %d.\n", index, flt_rule_count_v6[index]);
 		}
 		return;
@@ -219,12 +242,65 @@ public:
 		return ipa_nat_max_entries;
 	}
 
+	inline int GetNatPendingMaxEntries(void)
+	{
+		return ipa_nat_pending_max_entries;
+	}
+
+	inline int GetLan2LanMaxClients(void)
+	{
+		return ipa_lan2lan_max_client;
+	}
+
+	inline int GetLan2LanMaxIfaces(void)
+	{
+		return ipa_lan2lan_max_iface;
+	}
+
+	inline int GetV6FlowMaxFlows(void)
+	{
+		return ipa_v6flow_max_flows;
+	}
+
+	inline int GetNeighborMaxClients(void)
+	{
+		return ipa_neighbor_max_client;
+	}
+
 	inline int GetNatIfacesCnt()
 	{
 		return ipa_nat_iface_entries;
 	}
 	int GetNatIfaces(int nPorts, NatIfaces *ifaces);
 
+	/* iface_table index of a linux ifindex, -1 if it is not mapped yet */
+	inline int GetIfaceByNetlinkIndex(int netlink_index)
+	{
+		int i;
+
+		if(netlink_index > 0 && netlink_index < IPA_MAX_NETLINK_IFINDEX)
+		{
+			i = ifindex_map[netlink_index];
+			if(i >= 0 && i < ipa_num_ipa_interfaces &&
+				iface_table[i].netlink_interface_index == netlink_index)
+			{
+				return i;
+			}
+			return -1;
+		}
+
+		for(i = 0; i < ipa_num_ipa_interfaces; i++)
+		{
+			if(iface_table[i].netlink_interface_index == netlink_index)
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	void SetIfaceNetlinkIndex(int ipa_index, int netlink_index);
+
 	/* for IPACM resource manager dependency usage */
 	void AddRmDepend(ipa_rm_resource_name rm1,bool rx_bypass_ipa);
 
@@ -286,6 +362,7 @@ public:
 			private_subnet_table[ipa_num_private_subnet].subnet_addr = ip_addr;
 			private_subnet_table[ipa_num_private_subnet].subnet_mask = (subnet_mask >> 8) << 8;
 			ipa_num_private_subnet++;
+			IPACM_FlowClassifier::Rebuild();
 
 			/* IPACM private subnet set changes */
 			data_fid = (ipacm_event_data_fid *)malloc(sizeof(ipacm_event_data_fid));
@@ -320,6 +397,7 @@ public:
 					private_subnet_table[cnt].subnet_addr = private_subnet_table[cnt+1].subnet_addr;
 				}
 				ipa_num_private_subnet = ipa_num_private_subnet - 1;
+				IPACM_FlowClassifier::Rebuild();
 
 				/* IPACM private subnet set changes */
 				data_fid = (ipacm_event_data_fid *)malloc(sizeof(ipacm_event_data_fid));
@@ -344,12 +422,17 @@ public:
 
 	static const char *DEVICE_NAME_ODU;
 
+	/* XML configuration file, ipacm_replay points it to a local copy */
+	static const char *config_file;
+
 private:
 	static IPACM_Config *pInstance;
 	static const char *DEVICE_NAME;
 	IPACM_Config(void);
 	int m_fd; /* File descriptor of the IPA device node /dev/ipa */
 	uint8_t qmap_id;
+	/* iface_table index by linux ifindex, checked against netlink_interface_index */
+	int ifindex_map[IPA_MAX_NETLINK_IFINDEX];
 	ipacm_ext_prop ext_prop_v4;
 	ipacm_ext_prop ext_prop_v6;
 };
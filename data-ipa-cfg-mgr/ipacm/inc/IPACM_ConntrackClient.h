@@ -52,6 +52,7 @@ extern "C"
 #include <libnetfilter_conntrack/libnetfilter_conntrack.h>
 #include <libnetfilter_conntrack/libnetfilter_conntrack_tcp.h>
 #include <sys/inotify.h>
+#include <linux/filter.h>
 }
 
 using namespace std;
@@ -59,6 +60,11 @@ using namespace std;
 #define UDP_TIMEOUT_UPDATE 20
 #define BROADCAST_IPV4_ADDR 0xFFFFFFFF
 
+/* local addresses whose connections the kernel filter drops */
+#define IPACM_CT_MAX_IGNORE_ADDR 64
+/* upper bound of the generated conntrack socket filter */
+#define IPACM_CT_MAX_FILTER_INSN (96 + 2 * IPACM_CT_MAX_IGNORE_ADDR)
+
 class IPACM_ConntrackClient
 {
 
@@ -69,6 +75,15 @@ private:
    struct nfct_handle *udp_hdl;
    struct nfct_filter *tcp_filter;
    struct nfct_filter *udp_filter;
+
+   /* state compiled into the kernel socket filters, host byte order */
+   pthread_mutex_t filter_lock;
+   uint32_t ignore_addr[IPACM_CT_MAX_IGNORE_ADDR];
+   int num_ignore_addr;
+   uint32_t wan_addr;
+
+   static int BuildKernelFilter(struct sock_filter *insn, int max_insn, uint8_t l4proto);
+   static int AttachFilter(struct nfct_handle *hdl, struct nfct_filter *filter, uint8_t l4proto);
    static int IPA_Conntrack_Filters_Ignore_Local_Addrs(struct nfct_filter *filter);
    static int IPA_Conntrack_Filters_Ignore_Bridge_Addrs(struct nfct_filter *filter);
    static int IPA_Conntrack_Filters_Ignore_Local_Iface(struct nfct_filter *, ipacm_event_iface_up *);
@@ -87,6 +102,10 @@ public:
 
    static void UpdateUDPFilters(void *, bool);
    static void UpdateTCPFilters(void *, bool);
+   static void UpdateWanAddr(uint32_t);
+   static void AddIgnoreAddr(uint32_t addr);
+   /* ipacm_replay -k: 1 if the kernel filter passes msg, 0 if not */
+   static int RunKernelFilter(uint8_t l4proto, const void *msg, int len);
    static void Read_TcpUdp_Timeout(char *in, int len);
 
    static IPACM_ConntrackClient* GetInstance();
@@ -42,6 +42,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_CmdQueue.h"
 #include "IPACM_Conntrack_NATApp.h"
 #include "IPACM_Listener.h"
+#include "IPACM_EvtExecutor.h"
 #ifdef CT_OPT
 #include "IPACM_LanToLan.h"
 #endif
@@ -70,9 +71,7 @@ private:
 	bool WanUp;
 	NatApp *nat_inst;
 
-	int NatIfaceCnt;
 	int StaClntCnt;
-	NatIfaces *pNatIfaces;
 	uint32_t nat_iface_ipv4_addr[MAX_IFACE_ADDRESS];
 	uint32_t nonnat_iface_ipv4_addr[MAX_IFACE_ADDRESS];
 	uint32_t sta_clnt_ipv4_addr[MAX_STA_CLNT_IFACES];
@@ -81,22 +80,35 @@ private:
 	IPACM_LanToLan *p_lan2lan;
 #endif
 
+	/* connections found by the conntrack dump on wan up */
+	nat_table_entry *sync_entries;
+	int sync_max, sync_cnt, sync_temp;
+
 	void ProcessCTMessage(void *);
 	void ProcessTCPorUDPMsg(struct nf_conntrack *,
 	enum nf_conntrack_msg_type, u_int8_t);
+	bool BuildNatEntry(struct nf_conntrack *,
+	enum nf_conntrack_msg_type, nat_table_entry *, bool *);
+	void SyncConntrackTable(void);
+	static int ConntrackDumpCB(enum nf_conntrack_msg_type,
+	struct nf_conntrack *, void *);
+	void ImportCTEntry(struct nf_conntrack *);
 	void TriggerWANUp(void *);
 	void TriggerWANDown(uint32_t);
 	int  CreateNatThreads(void);
 	int  CreateConnTrackThreads(void);
 	bool AddIface(nat_table_entry *, bool *);
-	void AddORDeleteNatEntry(const nat_entry_bundle *);
+	bool AddORDeleteNatEntry(const nat_entry_bundle *);
 	void PopulateTCPorUDPEntry(struct nf_conntrack *, uint32_t, nat_table_entry *);
 	void CheckSTAClient(const nat_table_entry *, bool *);
 	int CheckNatIface(ipacm_event_data_all *, bool *);
 	void HandleNonNatIPAddr(void *, bool);
+	void UpdateClassifierClients(void);
+	void ProcessCTV6Message(void *);
+	void TrackV6Flow(struct nf_conntrack *, enum nf_conntrack_msg_type);
 
 #ifdef CT_OPT
-	void ProcessCTV6Message(void *);
+	void HandleLan2LanV6(void *);
 	void HandleLan2Lan(struct nf_conntrack *,
 		enum nf_conntrack_msg_type, nat_table_entry* );
 #endif
@@ -107,6 +119,8 @@ public:
 	bool isStaMode;
 	IPACM_ConntrackListener();
 	void event_callback(ipa_cm_event_id, void *data);
+	const char* get_listener_name(void) { return "conntrack"; }
+	int get_executor(void) { return IPACM_EXEC_CONNTRACK; }
 	inline bool isWanUp()
 	{
 		return WanUp;
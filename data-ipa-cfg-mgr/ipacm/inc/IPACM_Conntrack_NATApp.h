@@ -42,7 +42,18 @@ extern "C"
 #include <ipa_nat_drv.h>
 }
 
-#define MAX_TEMP_ENTRIES 25
+#define NAT_PENDING_DEFAULT_ENTRIES 100
+/* flushes a pending entry may fail before it is dropped */
+#define NAT_PENDING_MAX_RETRIES 3
+
+/* checkpoint of the nat cache, the cache itself is mapped from this file */
+#ifdef FEATURE_IPA_ANDROID
+#define IPACM_NAT_CACHE_FILE "/data/misc/ipa/ipacm_nat.cache"
+#else/* defined(FEATURE_IPA_ANDROID) */
+#define IPACM_NAT_CACHE_FILE "/etc/ipacm_nat.cache"
+#endif /* defined(NOT FEATURE_IPA_ANDROID)*/
+#define NAT_CACHE_MAGIC 0x4e415443 /* "NATC" */
+#define NAT_CACHE_VERSION 1
 
 #define IPACM_TCP_FULL_FILE_NAME  "/proc/sys/net/ipv4/netfilter/ip_conntrack_tcp_timeout_established"
 #define IPACM_UDP_FULL_FILE_NAME   "/proc/sys/net/ipv4/netfilter/ip_conntrack_udp_timeout_stream"
@@ -65,10 +76,97 @@ typedef struct _nat_table_entry
 	bool enabled;
 	uint32_t rule_hdl;
 
+	bool adopted;	/* restored from the checkpoint, not yet seen in conntrack */
+
 }nat_table_entry;
 
+/* IPACM_NAT_CACHE_FILE layout: this header followed by max_entries nat_table_entry */
+typedef struct _nat_cache_hdr
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t max_entries;
+	uint32_t entry_size;
+	uint32_t pub_ip_addr;	/* public ip of the last nat table */
+	uint32_t reserved[3];
+}nat_cache_hdr;
+
 #define CHK_TBL_HDL()  if(nat_table_hdl == 0){ return -1; }
 
+/* Bounded queue of connections waiting for their client interface,
+   indexed by 5-tuple and by client ip address. All storage is
+   allocated once at Init(); when full the oldest entry is evicted. */
+class NatPendingQueue
+{
+private:
+
+	enum
+	{
+		LINK_AGE = 0,  /* insertion order, oldest at head */
+		LINK_TUPLE,    /* 5-tuple hash chain */
+		LINK_PRIV,     /* private ip hash chain */
+		LINK_TRGT,     /* target ip hash chain */
+		LINK_MAX
+	};
+
+	typedef struct _pending_link
+	{
+		int prev;
+		int next;
+	}pending_link;
+
+	typedef struct _pending_node
+	{
+		nat_table_entry rule;
+		int retries;	/* failed attempts to add the rule */
+		pending_link link[LINK_MAX];
+	}pending_node;
+
+	pending_node *nodes;
+	int *tuple_head;
+	int *priv_head;
+	int *trgt_head;
+	int age_head, age_tail;
+	int free_head;
+
+	int capacity, count;
+	uint32_t bucket_mask;
+	uint32_t evictions;
+
+	static uint32_t HashIp(uint32_t);
+	static uint32_t HashTuple(const nat_table_entry *);
+	static bool isSameTuple(const nat_table_entry *, const nat_table_entry *);
+
+	int Find(const nat_table_entry *);
+	void Link(int *, int, int);
+	void Unlink(int *, int, int);
+	void Remove(int);
+
+public:
+	NatPendingQueue();
+	~NatPendingQueue();
+
+	int Init(int);
+	bool Add(const nat_table_entry *, bool *, int retries = 0);
+	bool Delete(const nat_table_entry *);
+	int Flush(uint32_t, nat_table_entry *, int *, int);
+
+	inline int GetCount()
+	{
+		return count;
+	}
+
+	inline int GetCapacity()
+	{
+		return capacity;
+	}
+
+	inline uint32_t GetEvictions()
+	{
+		return evictions;
+	}
+};
+
 class NatApp
 {
 private:
@@ -76,16 +174,24 @@ private:
 	static NatApp *pInstance;
 
 	nat_table_entry *cache;
-	nat_table_entry temp[MAX_TEMP_ENTRIES];
+	nat_cache_hdr *cache_hdr;	/* NULL if the cache is not backed by the checkpoint file */
+	size_t cache_map_size;
+	uint64_t adopt_usec;	/* time the checkpoint was adopted, 0 once restored */
+	NatPendingQueue temp;
+
+	/* scratch space for flushing pending entries in one batch */
+	nat_table_entry *flush_entries;
+	nat_table_entry *flush_pending;	/* flush_entries as they were queued */
+	int *flush_retries;
+	ipa_nat_ipv4_rule *flush_rules;
+	uint32_t *flush_hdls;
+	int *flush_slots;
 	uint32_t pub_ip_addr;
 	uint32_t pub_ip_addr_pre;
 	uint32_t nat_table_hdl;
 
 	int curCnt, max_entries;
 
-	ipacm_alg *pALGPorts;
-	uint16_t nALGPort;
-
 	uint32_t tcp_timeout;
 	uint32_t udp_timeout;
 
@@ -99,9 +205,13 @@ private:
 
 	void UpdateCTUdpTs(nat_table_entry *, uint32_t);
 	bool ChkForDup(const nat_table_entry *);
-	bool isAlgPort(uint8_t, uint16_t);
+	bool isCached(const nat_table_entry *);
 	void Reset();
 	bool isPwrSaveIf(uint32_t);
+	int AddEntryBatch(const nat_table_entry *, int);
+	int MapCache(void);
+	void RestoreCache(void);
+	int RestoreBatch(int);
 
 public:
 	static NatApp* GetInstance();
@@ -111,6 +221,7 @@ public:
 	int DeleteTable(uint32_t);
 
 	int AddEntry(const nat_table_entry *);
+	int AddEntries(const nat_table_entry *, int);
 	int DeleteEntry(const nat_table_entry *);
 
 	void UpdateUDPTimeStamp();
@@ -119,6 +230,7 @@ public:
 	int ResetPwrSaveIf(uint32_t);
 	int DelEntriesOnClntDiscon(uint32_t);
 	int DelEntriesOnSTAClntDiscon(uint32_t);
+	int DelStaleAdoptedEntries(void);
 
 	void Read_TcpUdp_Timeout(void);
 
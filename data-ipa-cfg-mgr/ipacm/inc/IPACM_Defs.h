@@ -79,6 +79,7 @@ extern "C"
 #define IPA_MAX_PRIVATE_SUBNET_ENTRIES 3
 #define IPA_MAX_ALG_ENTRIES 20
 #define IPA_MAX_RM_ENTRY 6
+#define IPA_MAX_DEL_HDLS 255 /* num_hdls of the del ioctls is 8 bits */
 
 #define IPV4_ADDR_LINKLOCAL 0xA9FE0000
 #define IPV4_ADDR_LINKLOCAL_MASK 0xFFFF0000
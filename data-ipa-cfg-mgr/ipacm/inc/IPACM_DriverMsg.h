@@ -0,0 +1,122 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_DriverMsg.h
+
+	@brief
+	This file implements the IPA driver message arena definitions
+
+	@Author
+
+*/
+#ifndef IPACM_DRIVERMSG_H
+#define IPACM_DRIVERMSG_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <linux/msm_ipa.h>
+#include "linux/ipa_qmi_service_v01.h"
+#include "IPACM_Defs.h"
+
+#define IPA_DRIVER_MSG_SLOTS 32
+
+/* largest message the driver sends is one of the tethering stats responses */
+#define IPA_DRIVER_MSG_PAYLOAD_LEN \
+	(sizeof(struct ipa_get_data_stats_resp_msg_v01) > sizeof(struct ipa_get_apn_data_stats_resp_msg_v01) ? \
+	 sizeof(struct ipa_get_data_stats_resp_msg_v01) : sizeof(struct ipa_get_apn_data_stats_resp_msg_v01))
+
+/* one read() lands in the front of a slot, event data carved out of the
+   slot follows it, rounded so every slice stays 8 byte aligned */
+#define IPA_DRIVER_MSG_SLOT_LEN \
+	((sizeof(struct ipa_msg_meta) + IPA_DRIVER_MSG_PAYLOAD_LEN + 1024 + 7) & ~((size_t)7))
+
+typedef struct _ipacm_drv_msg_slot
+{
+	char *buf;
+	int len;          /* bytes returned by read() */
+	uint32_t used;    /* bytes handed out, read data included */
+	int refcnt;       /* notifier reference plus one per slice */
+	struct _ipacm_drv_msg_slot *next;
+}ipacm_drv_msg_slot;
+
+typedef struct _ipacm_drv_msg_stats
+{
+	uint64_t msgs;
+	uint64_t wakeups;
+	uint32_t max_batch;
+	uint32_t slices;
+	uint32_t heap_slices;
+	uint32_t stalls;
+	uint32_t in_use;
+	uint32_t peak;
+}ipacm_drv_msg_stats;
+
+class IPACM_DriverMsg
+{
+public:
+
+	static int Init(void);
+
+	/* take a free slot for the next read(), wait for one if every slot
+	   is still owned by queued events unless nowait is set */
+	static ipacm_drv_msg_slot* Get(bool nowait);
+
+	/* drop the notifier reference once the message has been posted */
+	static void Put(ipacm_drv_msg_slot *slot);
+
+	/* hand out size zeroed bytes owned by the event they are posted with,
+	   falls back to the heap when the slot is full */
+	static void* Carve(ipacm_drv_msg_slot *slot, uint32_t size);
+
+	/* hand out the driver payload itself, no copy */
+	static void* Adopt(ipacm_drv_msg_slot *slot, uint32_t size);
+
+	/* release event data, slices go back to their slot, anything else
+	   was malloc()ed and is freed */
+	static void Free(void *evt_data);
+
+	static void RecordWakeup(int batch);
+
+	/* text dump of the arena counters */
+	static int dump(char *buf, int len);
+
+private:
+	static char *arena;
+	static ipacm_drv_msg_slot slots[IPA_DRIVER_MSG_SLOTS];
+	static ipacm_drv_msg_slot *free_list;
+	static pthread_mutex_t lock;
+	static pthread_cond_t cond;
+	static ipacm_drv_msg_stats stats;
+
+	static ipacm_drv_msg_slot* slot_of(void *ptr);
+	static void release(ipacm_drv_msg_slot *slot);
+};
+
+#endif /* IPACM_DRIVERMSG_H */
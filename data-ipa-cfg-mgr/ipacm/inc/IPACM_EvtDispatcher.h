@@ -41,6 +41,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define IPACM_EvtDispatcher_H
 
 #include <stdio.h>
+#include <pthread.h>
 #include <IPACM_CmdQueue.h>
 #include "IPACM_Defs.h"
 #include "IPACM_Listener.h"
@@ -69,8 +70,18 @@ public:
 	static int PostEvt(ipacm_cmd_q_data *);
 	static void ProcessEvt(ipacm_cmd_q_data *);
 
+	/* run one listener callback and account it in the event statistics */
+	static void Notify(ipa_cm_event_id event, IPACM_Listener *obj, void *evt_data);
+
 private:
-	static cmd_evts *head;
+	/* listeners of each event in registration order */
+	static cmd_evts *head[IPACM_EVENT_MAX];
+	static cmd_evts *tail[IPACM_EVENT_MAX];
+
+	/* set while ProcessEvt runs listener callbacks, used to tell
+	   listener generated events apart in the event recording */
+	static bool dispatching;
+	static pthread_t dispatch_thread;
 };
 
 #endif /* IPACM_EvtDispatcher_H */
@@ -0,0 +1,121 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_EvtExecutor.h
+
+	@brief
+	This file implements the IPACM per-interface event executor definitions
+
+	@Author
+
+*/
+#ifndef IPACM_EVTEXECUTOR_H
+#define IPACM_EVTEXECUTOR_H
+
+#include <pthread.h>
+#include "IPACM_Defs.h"
+#include "IPACM_CmdQueue.h"
+#include "IPACM_Listener.h"
+
+#define IPACM_MAX_EVT_WORKERS 8
+
+/* executor keys of listeners which are not bound to one ipa interface,
+   IPACM_Iface instances use their ipa_if_num */
+#define IPACM_EXEC_CONNTRACK (IPA_MAX_IFACE_ENTRIES)
+#define IPACM_EXEC_WAN (IPA_MAX_IFACE_ENTRIES + 1)
+
+/* event shared by all listener callbacks submitted for it */
+typedef struct _ipacm_exec_evt
+{
+	ipa_cm_event_id event;
+	void *evt_data;
+	int refcnt;
+}ipacm_exec_evt;
+
+typedef struct _ipacm_exec_job
+{
+	ipacm_exec_evt *evt;
+	IPACM_Listener *obj;
+	struct _ipacm_exec_job *next;
+}ipacm_exec_job;
+
+typedef struct _ipacm_exec_worker
+{
+	pthread_t thread;
+	pthread_cond_t cond;
+	ipacm_exec_job *head;
+	ipacm_exec_job *tail;
+}ipacm_exec_worker;
+
+class IPACM_EvtExecutor
+{
+public:
+
+	/* start the worker pool, 0 workers keeps every callback on the command queue thread */
+	static int Start(int workers);
+
+	static inline bool IsEnabled(void)
+	{
+		return (num_workers > 0);
+	}
+
+	/* true if the event may run on the per-interface workers */
+	static bool IsIfaceOrdered(ipa_cm_event_id event);
+
+	static ipacm_exec_evt* NewEvt(ipacm_cmd_q_data *data);
+
+	/* queue the callback on the worker owning the executor key */
+	static void Submit(ipacm_exec_evt *evt, IPACM_Listener *obj, int key);
+
+	/* drop one reference, the last one frees the event data */
+	static void Release(ipacm_exec_evt *evt);
+
+	/* wait until every submitted callback has returned */
+	static void Barrier(void);
+
+	static bool InWorker(void);
+
+	/* protects state shared between interfaces (NAT/conntrack tables,
+	   RM dependencies, wifi client budget), recursive */
+	static void LockShared(void);
+	static void UnlockShared(void);
+
+private:
+	static int num_workers;
+	static int pending;
+	static ipacm_exec_worker workers[IPACM_MAX_EVT_WORKERS];
+	static pthread_mutex_t exec_lock;
+	static pthread_cond_t idle_cond;
+	static pthread_mutex_t shared_lock;
+
+	static void* worker_thread(void *param);
+};
+
+#endif /* IPACM_EVTEXECUTOR_H */
@@ -0,0 +1,124 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_EvtRecord.h
+
+	@brief
+	This file implements the IPACM event recording definitions, the
+	recording is consumed by ipacm_replay
+
+	@Author
+
+*/
+#ifndef IPACM_EVTRECORD_H
+#define IPACM_EVTRECORD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <net/if.h>
+#include "IPACM_Defs.h"
+#include "IPACM_CmdQueue.h"
+
+#ifdef FEATURE_IPA_ANDROID
+#define IPACM_EVT_RECORD_FILE "/data/misc/ipa/ipacm_events.rec"
+#else/* defined(FEATURE_IPA_ANDROID) */
+#define IPACM_EVT_RECORD_FILE "/etc/ipacm_events.rec"
+#endif /* defined(NOT FEATURE_IPA_ANDROID)*/
+
+#define IPACM_EVT_REC_MAGIC 0x52455049 /* "IPER" */
+#define IPACM_EVT_REC_VERSION 1
+#define IPACM_EVT_REC_MAX_PAYLOAD 4096
+#define IPACM_EVT_REC_MAX_IFACE 64
+
+/* record types */
+#define IPACM_EVT_REC_EVENT 1   /* posted ipacm_cmd_q_data */
+#define IPACM_EVT_REC_IFACE 2   /* ipacm_evt_rec_iface, linux if_index to name */
+
+/* event record flags */
+#define IPACM_EVT_REC_F_DERIVED    0x1  /* posted by a listener while dispatching */
+#define IPACM_EVT_REC_F_NO_PAYLOAD 0x2  /* payload present but not serializable */
+
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t event_max;
+} ipacm_evt_rec_file_hdr;
+
+typedef struct
+{
+	uint64_t ts_usec;
+	uint16_t type;
+	uint16_t event;
+	uint16_t flags;
+	uint16_t len;
+} ipacm_evt_rec_hdr;
+
+typedef struct
+{
+	int32_t if_index;
+	char if_name[IF_NAMESIZE];
+} ipacm_evt_rec_iface;
+
+class IPACM_EvtRecord
+{
+public:
+
+	/* start appending every posted event to the given file */
+	static int Start(const char *path);
+
+	static void Stop(void);
+
+	static inline bool IsEnabled(void)
+	{
+		return fp != NULL;
+	}
+
+	/* called by IPACM_EvtDispatcher::PostEvt */
+	static void Record(const ipacm_cmd_q_data *data, bool derived);
+
+	/* rebuild the evt_data of an event record, caller owns the result */
+	static int Decode(const ipacm_evt_rec_hdr *rec, const uint8_t *payload, void **evt_data);
+
+private:
+	static FILE *fp;
+	static pthread_mutex_t rec_mutex;
+	static uint64_t start_usec;
+	static int num_iface;
+	static int iface_seen[IPACM_EVT_REC_MAX_IFACE];
+	static uint8_t payload_buf[IPACM_EVT_REC_MAX_PAYLOAD];
+
+	static int Encode(const ipacm_cmd_q_data *data, uint8_t *buf, int len, int *if_index);
+	static void RecordIface(int if_index, uint64_t ts);
+	static int Write(uint16_t type, uint16_t event, uint16_t flags, uint64_t ts, const void *payload, uint16_t len);
+};
+
+#endif /* IPACM_EVTRECORD_H */
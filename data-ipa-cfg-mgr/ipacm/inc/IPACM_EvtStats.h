@@ -0,0 +1,128 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_EvtStats.h
+
+	@brief
+	This file implements the IPACM event latency statistics definitions
+
+	@Author
+
+*/
+#ifndef IPACM_EVTSTATS_H
+#define IPACM_EVTSTATS_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include "IPACM_Defs.h"
+
+#ifdef FEATURE_IPA_ANDROID
+#define IPACM_STATS_SOCKET "/data/misc/ipa/ipacm_stats"
+#else/* defined(FEATURE_IPA_ANDROID) */
+#define IPACM_STATS_SOCKET "/etc/ipacm_stats"
+#endif /* defined(NOT FEATURE_IPA_ANDROID)*/
+
+/* log-linear histogram: each power of two (in usec) is split into
+   IPACM_HIST_SUB_BUCKETS linear buckets */
+#define IPACM_HIST_SUB_SHIFT 2
+#define IPACM_HIST_SUB_BUCKETS (1 << IPACM_HIST_SUB_SHIFT)
+#define IPACM_HIST_BUCKETS (IPACM_HIST_SUB_BUCKETS * 31)
+
+#define IPACM_STATS_NAME_LEN 32
+
+/* conntrack event counters are kept per layer 4 protocol */
+enum
+{
+	IPACM_CT_STAT_TCP = 0,
+	IPACM_CT_STAT_UDP,
+	IPACM_CT_STAT_OTHER,
+	IPACM_CT_STAT_MAX
+};
+
+class IPACM_Histogram
+{
+public:
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint32_t buckets[IPACM_HIST_BUCKETS];
+
+	void record(uint64_t usec);
+	uint64_t percentile(int pct);
+	int dump(char *buf, int len);
+
+	static int bucket_index(uint64_t usec);
+	static uint64_t bucket_low(int idx);
+};
+
+typedef struct _ipacm_evt_stat
+{
+	IPACM_Histogram queue_delay;
+	IPACM_Histogram handler;
+	uint64_t slowest_usec;
+	char slowest_listener[IPACM_STATS_NAME_LEN];
+}ipacm_evt_stat;
+
+class IPACM_EvtStats
+{
+public:
+
+	static uint64_t now_usec(void);
+	static uint64_t elapsed_usec(const struct timespec *since);
+
+	/* time spent by the event in the MessageQueue */
+	static void record_queue_delay(ipa_cm_event_id event, const struct timespec *enq_ts);
+
+	/* time spent in one listener event_callback */
+	static void record_handler(ipa_cm_event_id event, const char *listener, uint64_t start_usec);
+
+	/* conntrack event which passed the kernel filter and reached ipacm */
+	static void record_ct_event(uint8_t l4proto);
+
+	/* conntrack event which reached ipacm but did not change any rule */
+	static void record_ct_ignored(uint8_t l4proto);
+
+	/* text dump of all histograms and queue depths */
+	static void dump(int fd);
+
+	/* thread serving IPACM_STATS_SOCKET */
+	static void* stats_server(void *param);
+
+private:
+	static ipacm_evt_stat stats[IPACM_EVENT_MAX];
+	static pthread_mutex_t stats_mutex;
+	static uint32_t ct_received[IPACM_CT_STAT_MAX];
+	static uint32_t ct_ignored[IPACM_CT_STAT_MAX];
+
+	static int ct_stat_index(uint8_t l4proto);
+};
+
+#endif /* IPACM_EVTSTATS_H */
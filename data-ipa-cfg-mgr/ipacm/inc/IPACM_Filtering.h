@@ -60,7 +60,7 @@ public:
 	bool DeviceNodeIsOpened();
 	bool DeleteFilteringHdls(uint32_t *flt_rule_hdls,
 													 ipa_ip_type ip,
-													 uint8_t num_rules);
+													 int num_rules);
 
 	bool AddWanDLFilteringRule(struct ipa_ioc_add_flt_rule const *rule_table_v4, struct ipa_ioc_add_flt_rule const * rule_table_v6, uint8_t mux_id);
 	bool SendFilteringRuleIndex(struct ipa_fltr_installed_notif_req_msg_v01* table);
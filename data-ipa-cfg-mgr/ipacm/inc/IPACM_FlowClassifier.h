@@ -0,0 +1,135 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_FlowClassifier.h
+
+	@brief
+	This file implements the IPACM NAT eligibility classifier definitions
+
+	@Author
+
+*/
+#ifndef IPACM_FLOWCLASSIFIER_H
+#define IPACM_FLOWCLASSIFIER_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "IPACM_Defs.h"
+
+#define IPACM_CLS_PORT_WORDS (65536 / 32)
+
+/* open addressing slots of the client address set, power of 2 */
+#define IPACM_CLS_CLIENT_SHIFT 8
+#define IPACM_CLS_CLIENT_SLOTS (1 << IPACM_CLS_CLIENT_SHIFT)
+
+enum
+{
+	IPACM_CLS_PROTO_TCP = 0,
+	IPACM_CLS_PROTO_UDP,
+	IPACM_CLS_PROTO_MAX
+};
+
+/* what a flow endpoint matched, in the order AddIface checks them */
+typedef enum
+{
+	IPACM_FLOW_NONE = 0,
+	IPACM_FLOW_NAT_CLIENT,
+	IPACM_FLOW_NONNAT_CLIENT,
+	IPACM_FLOW_PRIVATE_SUBNET
+}ipacm_flow_class;
+
+/* Immutable snapshot, replaced as a whole on every change */
+typedef struct _ipacm_flow_cls
+{
+	/* alg ports per protocol */
+	uint32_t alg_port_map[IPACM_CLS_PROTO_MAX][IPACM_CLS_PORT_WORDS];
+
+	/* private subnets grouped by mask, longest mask first,
+	   addresses of one group sorted */
+	int num_mask;
+	uint32_t mask[IPA_MAX_PRIVATE_SUBNET_ENTRIES];
+	int mask_first[IPA_MAX_PRIVATE_SUBNET_ENTRIES];
+	int mask_cnt[IPA_MAX_PRIVATE_SUBNET_ENTRIES];
+	uint32_t subnet[IPA_MAX_PRIVATE_SUBNET_ENTRIES];
+
+	/* nat and non nat client addresses, 0 is a free slot */
+	uint32_t client_addr[IPACM_CLS_CLIENT_SLOTS];
+	uint8_t client_type[IPACM_CLS_CLIENT_SLOTS];
+
+	/* nat ifaces, ifindex 0 if the iface did not exist at build time */
+	int num_nat_iface;
+	char nat_iface_name[IPA_MAX_IFACE_ENTRIES][IPA_IFACE_NAME_LEN];
+	int nat_ifindex[IPA_MAX_IFACE_ENTRIES];
+}ipacm_flow_cls;
+
+class IPACM_FlowClassifier
+{
+public:
+
+	/* alg ports, private subnets or nat ifaces changed in IPACM_Config */
+	static void Rebuild(void);
+
+	/* nat and non nat client addresses changed, 0 entries are skipped */
+	static void SetClients(const uint32_t *nat_addr, const uint32_t *nonnat_addr, int cnt);
+
+	/* true if either port of the flow is an alg port */
+	static bool IsAlgFlow(uint8_t proto, uint16_t port1, uint16_t port2);
+
+	/* strongest match of the two flow endpoints */
+	static ipacm_flow_class ClassifyFlow(uint32_t ip1, uint32_t ip2, bool skip_nonnat);
+
+	static bool IsNatIface(int if_index);
+
+private:
+	static ipacm_flow_cls *current;
+
+	/* readers announce themselves in the counter of the current phase,
+	   the writer flips the phase and waits for the old one to drain */
+	static int phase;
+	static int readers[2];
+	static pthread_mutex_t update_lock;
+
+	/* clients of the last SetClients, carried into config rebuilds */
+	static uint32_t *nat_clients;
+	static uint32_t *nonnat_clients;
+	static int num_clients;
+
+	static ipacm_flow_cls* ReadLock(int *ph);
+	static void ReadUnlock(int ph);
+	static void Publish(ipacm_flow_cls *cls);
+
+	static void BuildConfig(ipacm_flow_cls *cls);
+	static void BuildClients(ipacm_flow_cls *cls);
+	static void AddClient(ipacm_flow_cls *cls, uint32_t addr, ipacm_flow_class type);
+	static ipacm_flow_class FindClient(const ipacm_flow_cls *cls, uint32_t addr);
+	static bool MatchSubnet(const ipacm_flow_cls *cls, uint32_t addr);
+};
+
+#endif /* IPACM_FLOWCLASSIFIER_H */
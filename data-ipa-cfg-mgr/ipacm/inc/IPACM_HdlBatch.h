@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_HdlBatch.h
+
+	@brief
+	This file implements the deferred rule handle delete batch definitions
+
+	@Author
+
+*/
+#ifndef IPACM_HDLBATCH_H
+#define IPACM_HDLBATCH_H
+
+#include <stdint.h>
+#include <linux/msm_ipa.h>
+#include "IPACM_Routing.h"
+#include "IPACM_Filtering.h"
+#include "IPACM_Header.h"
+
+/* handle owners, clients are keyed by their index in the client cache */
+#define IPACM_HDL_OWNER_ANY (-1)
+#define IPACM_HDL_OWNER_IFACE 0
+#define IPACM_HDL_OWNER_CLIENT(idx) ((idx) + 1)
+
+#define IPACM_HDL_BATCH_INIT_SIZE 16
+
+/* kept in delete order, filter rules point at routing tables and
+   routing rules point at headers */
+typedef enum
+{
+	IPACM_HDL_FLT = 0,
+	IPACM_HDL_RT,
+	IPACM_HDL_PROC_CTX,
+	IPACM_HDL_HDR,
+	IPACM_HDL_TYPE_MAX
+}ipacm_hdl_type;
+
+typedef struct _ipacm_hdl_entry
+{
+	int owner;
+	uint8_t type;
+	uint8_t ip;
+	uint32_t hdl;
+}ipacm_hdl_entry;
+
+typedef struct _ipacm_hdl_stats
+{
+	uint64_t queued;
+	uint64_t deleted;	/* handles of deletes the driver accepted */
+	uint64_t failed;	/* handles of deletes the driver refused */
+	uint64_t ioctls;
+	uint32_t failures;
+	uint32_t fallbacks;
+}ipacm_hdl_stats;
+
+class IPACM_HdlBatch
+{
+public:
+
+	IPACM_HdlBatch(IPACM_Filtering *flt, IPACM_Routing *rt, IPACM_Header *hdr);
+	~IPACM_HdlBatch();
+
+	/* queue a handle the caller is done with for the next flush(), zero
+	   handles are ignored, ip is only used for filter and routing rules */
+	void add(int owner, ipacm_hdl_type type, ipa_ip_type ip, uint32_t hdl);
+	void add(int owner, ipacm_hdl_type type, ipa_ip_type ip, const uint32_t *hdls, int num);
+
+	/* delete the queued handles of owner (or all of them for
+	   IPACM_HDL_OWNER_ANY) with one delete per handle type and ip type.
+	   The handles leave the queue even when the driver refuses them, the
+	   caller keeps its own record of them until flush() succeeds */
+	int flush(int owner);
+
+	/* text dump of the batch counters */
+	static int dump(char *buf, int len);
+
+private:
+	IPACM_Filtering *m_flt;
+	IPACM_Routing *m_rt;
+	IPACM_Header *m_hdr;
+
+	ipacm_hdl_entry *entries;
+	int num_entries;
+	int size;
+
+	static ipacm_hdl_stats stats;
+
+	bool delete_hdls(ipacm_hdl_type type, ipa_ip_type ip, uint32_t *hdls, int num);
+};
+
+#endif /* IPACM_HDLBATCH_H */
@@ -58,6 +58,8 @@ public:
 	bool DeleteHeaderHdl(uint32_t hdr_hdl);
 	bool AddHeaderProcCtx(struct ipa_ioc_add_hdr_proc_ctx* pHeader);
 	bool DeleteHeaderProcCtx(uint32_t hdl);
+	bool DeleteHeaderHdls(uint32_t *hdr_hdls, int num_hdls);
+	bool DeleteHeaderProcCtxs(uint32_t *hdls, int num_hdls);
 
 	IPACM_Header();
 	~IPACM_Header();
@@ -46,6 +46,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Routing.h"
 #include "IPACM_Filtering.h"
 #include "IPACM_Header.h"
+#include "IPACM_HdlBatch.h"
 #include "IPACM_EvtDispatcher.h"
 #include "IPACM_Xml.h"
 #include "IPACM_Log.h"
@@ -117,6 +118,10 @@ public:
 	virtual void event_callback(ipa_cm_event_id event,
 															void *data) = 0;
 
+	const char* get_listener_name(void) { return dev_name; }
+
+	int get_executor(void) { return ipa_if_num; }
+
 	/* Query ipa_interface_index by given linux interface_index */
 	static int iface_ipa_index_query(int interface_index);
 
@@ -139,6 +144,9 @@ public:
 	static IPACM_Filtering m_filtering;
 	static IPACM_Header m_header;
 
+	/* rule handles waiting to be deleted in bulk on teardown */
+	IPACM_HdlBatch hdl_batch;
+
 	/* software routing enable */
 	virtual int handle_software_routing_enable(void);
 
@@ -51,15 +51,6 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define IPA_INSTANCE_NOT_FOUND  0
 #define IPA_INSTANCE_FOUND  1
 
-/* queue */
-typedef struct _iface_instances
-{
-    /* Linux interface id */
-	int ipa_if_index;
-	IPACM_Listener *obj;
-	_iface_instances *next;
-}  iface_instances;
-
 
 class IPACM_IfaceManager : public IPACM_Listener
 {
@@ -71,19 +62,22 @@ public:
   void event_callback(ipa_cm_event_id event,
                       void *data);
 
+  const char* get_listener_name(void) { return "iface_manager"; }
+
   /* api for all iface instances to de-register instances */
-  static int deregistr(IPACM_Listener *param);
+  static int deregistr(IPACM_Iface *param);
 
 
 private:
 	int create_iface_instance(ipacm_ifacemgr_data *);
 
     /* api to register instances */
-	int registr(int ipa_if_index, IPACM_Listener *obj);
+	int registr(int ipa_if_index, IPACM_Iface *obj);
 
 	int SearchInstance(int ipa_if_index);
 
-	static iface_instances *head;
+	/* iface instance of each ipa interface index, one at most */
+	static IPACM_Iface *instances[IPA_MAX_IFACE_ENTRIES];
 
 };
 
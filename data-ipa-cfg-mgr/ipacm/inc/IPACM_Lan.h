@@ -49,6 +49,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Filtering.h"
 #include "IPACM_Config.h"
 #include "IPACM_Conntrack_NATApp.h"
+#include "IPACM_V6FlowTable.h"
 
 #define IPA_WAN_DEFAULT_FILTER_RULE_HANDLES  1
 #define IPA_PRIV_SUBNET_FILTER_RULE_HANDLES  3
@@ -56,6 +57,8 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define MAX_WAN_UL_FILTER_RULES MAX_NUM_EXT_PROPS
 #define NUM_IPV4_ICMP_FLT_RULE 1
 #define NUM_IPV6_ICMP_FLT_RULE 1
+/* rule count of one add rt/flt rule ioctl is 8 bits wide */
+#define IPA_ETH_BRIDGE_MAX_RULES_PER_IOCTL 255
 
 /* ndc bandwidth ipatetherstats <ifaceIn> <ifaceOut> */
 /* <in->out_bytes> <in->out_pkts> <out->in_bytes> <out->in_pkts */
@@ -149,16 +152,18 @@ public:
 	/* add header processing context and return handle to lan2lan controller */
 	int eth_bridge_add_hdr_proc_ctx(ipa_hdr_l2_type peer_l2_hdr_type, uint32_t *hdl);
 
-	/* add routing rule and return handle to lan2lan controller */
-	int eth_bridge_add_rt_rule(uint8_t *mac, char *rt_tbl_name, uint32_t hdr_proc_ctx_hdl,
+	/* add routing rules for num_client clients in one ioctl and return handles to lan2lan controller,
+	   rt_rule_count rules per client are returned client by client in rt_rule_hdl */
+	int eth_bridge_add_rt_rule(uint8_t (*mac)[IPA_MAC_ADDR_SIZE], int num_client, char *rt_tbl_name, uint32_t hdr_proc_ctx_hdl,
 		ipa_hdr_l2_type peer_l2_hdr_type, ipa_ip_type iptype, uint32_t *rt_rule_hdl, int *rt_rule_count);
 
 	/* modify routing rule*/
 	int eth_bridge_modify_rt_rule(uint8_t *mac, uint32_t hdr_proc_ctx_hdl,
 		ipa_hdr_l2_type peer_l2_hdr_type, ipa_ip_type iptype, uint32_t *rt_rule_hdl, int rt_rule_count);
 
-	/* add filtering rule and return handle to lan2lan controller */
-	int eth_bridge_add_flt_rule(uint8_t *mac, uint32_t rt_tbl_hdl, ipa_ip_type iptype, uint32_t *flt_rule_hdl);
+	/* add filtering rules for num_client clients in one ioctl and return handles to lan2lan controller */
+	int eth_bridge_add_flt_rule(uint8_t (*mac)[IPA_MAC_ADDR_SIZE], int num_client, uint32_t rt_tbl_hdl,
+		ipa_ip_type iptype, uint32_t *flt_rule_hdl);
 
 	/* delete filtering rule */
 	int eth_bridge_del_flt_rule(uint32_t flt_rule_hdl, ipa_ip_type iptype);
@@ -296,7 +301,7 @@ private:
 		return IPACM_INVALID_INDEX;
 	}
 
-	inline int delete_eth_rtrules(int clt_indx, ipa_ip_type iptype)
+	inline int delete_eth_rtrules(int clt_indx, ipa_ip_type iptype, bool defer = false)
 	{
 		uint32_t tx_index;
 		uint32_t rt_hdl;
@@ -311,18 +316,9 @@ private:
 					IPACMDBG_H("Delete client index %d ipv4 RT-rules for tx:%d\n",clt_indx,tx_index);
 					rt_hdl = get_client_memptr(eth_client, clt_indx)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v4;
 
-					if(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v4) == false)
-					{
-						return IPACM_FAILURE;
-					}
+					hdl_batch.add(IPACM_HDL_OWNER_CLIENT(clt_indx), IPACM_HDL_RT, IPA_IP_v4, rt_hdl);
 				}
 		    } /* end of for loop */
-
-		     /* clean the ipv4 RT rules for eth-client:clt_indx */
-		     if(get_client_memptr(eth_client, clt_indx)->route_rule_set_v4==true) /* for ipv4 */
-		     {
-				get_client_memptr(eth_client, clt_indx)->route_rule_set_v4 = false;
-		     }
 		}
 
 		if(iptype == IPA_IP_v6)
@@ -335,28 +331,56 @@ private:
 					{
 						IPACMDBG_H("Delete client index %d ipv6 RT-rules for %d-st ipv6 for tx:%d\n", clt_indx,num_v6,tx_index);
 						rt_hdl = get_client_memptr(eth_client, clt_indx)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6[num_v6];
-						if(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v6) == false)
-							{
-								return IPACM_FAILURE;
-							}
+						hdl_batch.add(IPACM_HDL_OWNER_CLIENT(clt_indx), IPACM_HDL_RT, IPA_IP_v6, rt_hdl);
 
 							rt_hdl = get_client_memptr(eth_client, clt_indx)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6_wan[num_v6];
-							if(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v6) == false)
-							{
-								return IPACM_FAILURE;
-							}
+							hdl_batch.add(IPACM_HDL_OWNER_CLIENT(clt_indx), IPACM_HDL_RT, IPA_IP_v6, rt_hdl);
 						}
                     }
 		    } /* end of for loop */
+		}
 
+		/* a deferring caller flushes the client's handles together and calls
+		   clear_eth_rtrules() once that worked, the route rule state is
+		   kept until the handles are gone */
+		if(defer == true)
+		{
+			return IPACM_SUCCESS;
+		}
+		if(hdl_batch.flush(IPACM_HDL_OWNER_CLIENT(clt_indx)))
+		{
+			return IPACM_FAILURE;
+		}
+		clear_eth_rtrules(clt_indx, iptype);
+		return IPACM_SUCCESS;
+	}
+
+	/* forget the route rules of client clt_indx once their handles are deleted */
+	inline void clear_eth_rtrules(int clt_indx, ipa_ip_type iptype)
+	{
+		int num_v6;
+
+		if(iptype == IPA_IP_v4)
+		{
+		     /* clean the ipv4 RT rules for eth-client:clt_indx */
+		     if(get_client_memptr(eth_client, clt_indx)->route_rule_set_v4==true) /* for ipv4 */
+		     {
+				get_client_memptr(eth_client, clt_indx)->route_rule_set_v4 = false;
+		     }
+		}
+
+		if(iptype == IPA_IP_v6)
+		{
 		    /* clean the ipv6 RT rules for eth-client:clt_indx */
 		    if(get_client_memptr(eth_client, clt_indx)->route_rule_set_v6 != 0) /* for ipv6 */
 		    {
+				for(num_v6 = 0; num_v6 < get_client_memptr(eth_client, clt_indx)->route_rule_set_v6; num_v6++)
+				{
+					IPACM_V6FlowTable::DelRoutedAddr(get_client_memptr(eth_client, clt_indx)->v6_addr[num_v6]);
+				}
 		        get_client_memptr(eth_client, clt_indx)->route_rule_set_v6 = 0;
             }
 		}
-
-		return IPACM_SUCCESS;
 	}
 
 	/* handle eth client initial, construct full headers (tx property) */
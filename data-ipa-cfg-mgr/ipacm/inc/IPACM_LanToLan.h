@@ -48,10 +48,13 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #else/* defined(FEATURE_IPA_ANDROID) */
 #include <list>
 #endif /* ndefined(FEATURE_IPA_ANDROID)*/
+#include <vector>
 
 #define MAX_NUM_CACHED_CLIENT_ADD_EVENT 10
+/* defaults, overridden by MaxIfaces/MaxClients in IPACM_cfg.xml */
 #define MAX_NUM_IFACE 10
 #define MAX_NUM_CLIENT 16
+#define L2L_CLIENT_SLOT_INVALID -1
 
 struct rt_rule_info
 {
@@ -62,13 +65,15 @@ struct rt_rule_info
 struct client_info
 {
 	uint8_t mac_addr[6];
+	bool in_use;
+	int slot;	/* index in the owning interface client table */
 	rt_rule_info inter_iface_rt_rule_hdl[IPA_HDR_L2_MAX];	/* routing rule handles of inter interface communication based on source l2 header type */
 	rt_rule_info intra_iface_rt_rule_hdl;	/* routing rule handles of inter interface communication */
 };
 
 struct flt_rule_info
 {
-	client_info *p_client;
+	client_info *p_client;	/* NULL if no rule is installed for the slot */
 	uint32_t flt_rule_hdl[IPA_IP_MAX];
 };
 
@@ -77,7 +82,7 @@ struct peer_iface_info
 	class IPACM_LanToLan_Iface *peer;
 	char rt_tbl_name_for_rt[IPA_IP_MAX][IPA_RESOURCE_NAME_MAX];
 	char rt_tbl_name_for_flt[IPA_IP_MAX][IPA_RESOURCE_NAME_MAX];
-	list<flt_rule_info> flt_rule;
+	vector<flt_rule_info> flt_rule;	/* indexed by the client slot of the peer */
 };
 
 class IPACM_LanToLan_Iface
@@ -132,21 +137,35 @@ private:
 	uint32_t hdr_proc_ctx_for_inter_interface[IPA_HDR_L2_MAX];
 	uint32_t hdr_proc_ctx_for_intra_interface;
 
-	list<client_info> m_client_info;	/* client list */
-	list<peer_iface_info> m_peer_iface_info;	/* peer information list */
+	/* client table: fixed slots so client pointers stay valid, plus an
+	   open addressing hash of the client MAC to its slot */
+	vector<client_info> m_client_info;
+	vector<int> m_client_hash;
+	int m_num_client;
+	vector<peer_iface_info> m_peer_iface_info;	/* peer information, newest peer last */
 
 	/* The following members are for intra-interface communication*/
 	peer_iface_info m_intra_interface_info;
 
+	client_info* find_client(uint8_t *mac);
+
+	client_info* insert_client(uint8_t *mac);
+
+	void erase_client(client_info *client);
+
+	void clear_client_table();
+
+	int get_client_list(client_info **clients);
+
 	void add_one_client_flt_rule(IPACM_LanToLan_Iface *peer_iface, client_info *client);
 
-	void add_client_flt_rule(peer_iface_info *peer, client_info *client, ipa_ip_type iptype);
+	void add_client_flt_rule(peer_iface_info *peer, client_info **clients, int num_client, ipa_ip_type iptype);
 
 	void del_one_client_flt_rule(IPACM_LanToLan_Iface *peer_iface, client_info *client);
 
 	void del_client_flt_rule(peer_iface_info *peer, client_info *client);
 
-	void add_client_rt_rule(peer_iface_info *peer, client_info *client);
+	void add_client_rt_rule(peer_iface_info *peer, client_info **clients, int num_client);
 
 	void del_client_rt_rule(peer_iface_info *peer, client_info *client);
 
@@ -191,6 +210,8 @@ private:
 
 	void event_callback(ipa_cm_event_id event, void* param);
 
+	const char* get_listener_name(void) { return "lan2lan"; }
+
 	void handle_cached_client_add_event(IPACM_Lan *p_iface);
 
 	void clear_cached_client_add_event(IPACM_Lan *p_iface);
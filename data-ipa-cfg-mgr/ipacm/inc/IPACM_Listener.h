@@ -43,11 +43,18 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Defs.h"
 #include "IPACM_CmdQueue.h"
 
+/* executor key of listeners which must stay on the command queue thread */
+#define IPACM_EXEC_COORDINATOR (-1)
+
 /* abstract class notifier */
 class IPACM_Listener
 {
 public:
 	virtual void event_callback(ipa_cm_event_id event,															void *data) = 0;
+	/* name reported in the event latency statistics */
+	virtual const char* get_listener_name(void) { return "listener"; }
+	/* listeners with the same key never run concurrently, see IPACM_EvtExecutor */
+	virtual int get_executor(void) { return IPACM_EXEC_COORDINATOR; }
 	virtual ~IPACM_Listener(void) {};
 };
 
@@ -48,7 +48,9 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Listener.h"
 #include "IPACM_Iface.h"
 
+/* cached clients when MaxClients is 0 */
 #define IPA_MAX_NUM_NEIGHBOR_CLIENTS  100
+#define IPA_NEIGHBOR_INVALID -1
 
 struct ipa_neighbor_client
 {
@@ -56,8 +58,25 @@ struct ipa_neighbor_client
 	int iface_index;
 	uint32_t v4_addr;
 	int ipa_if_num;
+	int hash_next;		/* bucket chain, free list while unused */
+	int lru_prev;
+	int lru_next;
+	uint64_t first_usec;	/* cached at */
+	uint64_t last_usec;	/* last looked up or updated */
 };
 
+typedef struct _ipa_neighbor_stats
+{
+	uint32_t capacity;
+	uint32_t active;
+	uint32_t peak;
+	uint64_t lookups;
+	uint64_t hits;
+	uint32_t inserted;
+	uint32_t deleted;
+	uint32_t evicted;
+}ipa_neighbor_stats;
+
 class IPACM_Neighbor : public IPACM_Listener
 {
 
@@ -68,13 +87,42 @@ public:
 	void event_callback(ipa_cm_event_id event,
 											void *data);
 
+	const char* get_listener_name(void) { return "neighbor"; }
+
+	/* text dump of the client cache counters */
+	static int dump(char *buf, int len);
+
 private:
 
-	int num_neighbor_client;
+	/* client cache: fixed pool hashed by client MAC, least recently
+	   seen client is replaced when the pool is full */
+	ipa_neighbor_client *neighbor_client;
+
+	int max_neighbor_client;
+
+	int *neighbor_hash;
+
+	int hash_mask;
+
+	int free_head;
+
+	int lru_head;
+
+	int lru_tail;
+
+	static ipa_neighbor_stats stats;
+
+	ipa_neighbor_client* find_client(uint8_t *mac_addr);
+
+	ipa_neighbor_client* insert_client(uint8_t *mac_addr);
+
+	void delete_client(ipa_neighbor_client *client);
+
+	void lru_unlink(int idx);
 
-	int circular_index;
+	void lru_push_head(int idx);
 
-	ipa_neighbor_client neighbor_client[IPA_MAX_NUM_NEIGHBOR_CLIENTS];
+	void hash_unlink(int idx);
 
 };
 
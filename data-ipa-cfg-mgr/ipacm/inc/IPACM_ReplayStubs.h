@@ -0,0 +1,67 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_ReplayStubs.h
+
+	@brief
+	This file implements the ipacm_replay device stubs definitions,
+	/dev/ipa and the other IPA device nodes are emulated so the replay
+	runs on a host without IPA hardware
+
+	@Author
+
+*/
+#ifndef IPACM_REPLAYSTUBS_H
+#define IPACM_REPLAYSTUBS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define IPACM_STUB_MAX_IFACE 64
+#define IPACM_STUB_MAX_FD 32
+#define IPACM_STUB_IOC_NR_MAX 256
+
+typedef struct
+{
+	uint32_t ipa;                            /* ioctls on emulated IPA devices */
+	uint32_t other;                          /* passed through to the kernel */
+	uint32_t nr[IPACM_STUB_IOC_NR_MAX];      /* per IPA ioctl number */
+} ipacm_stub_ioctl_stats;
+
+/* linux if_index to name answers for SIOCGIFNAME/SIOCGIFINDEX */
+int ipacm_stub_add_iface(int if_index, const char *if_name);
+
+void ipacm_stub_get_stats(ipacm_stub_ioctl_stats *stats);
+
+void ipacm_stub_reset_stats(void);
+
+void ipacm_stub_dump_stats(FILE *fp, uint32_t events);
+
+#endif /* IPACM_REPLAYSTUBS_H */
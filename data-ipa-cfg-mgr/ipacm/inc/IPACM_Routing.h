@@ -64,6 +64,7 @@ public:
 
 	bool DeviceNodeIsOpened();
 	bool DeleteRoutingHdl(uint32_t rt_rule_hdl, ipa_ip_type ip);
+	bool DeleteRoutingHdls(uint32_t *rt_rule_hdls, ipa_ip_type ip, int num_rules);
 
 	bool ModifyRoutingRule(struct ipa_ioc_mdfy_rt_rule *);
 
@@ -0,0 +1,104 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_Startup.h
+
+	@brief
+	This file implements the IPACM startup profiler and readiness gate
+	definitions
+
+	@Author
+
+*/
+#ifndef IPACM_STARTUP_H
+#define IPACM_STARTUP_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#define IPACM_STARTUP_MAX_STAGES 16
+#define IPACM_STARTUP_NAME_LEN 24
+
+typedef enum
+{
+	IPACM_STARTUP_FIRST_WAN_UP = 0,
+	IPACM_STARTUP_FIRST_NAT_RULE,
+	IPACM_STARTUP_MILESTONE_MAX
+}ipacm_startup_milestone;
+
+typedef struct _ipacm_startup_stage
+{
+	char name[IPACM_STARTUP_NAME_LEN];
+	char thread[IPACM_STARTUP_NAME_LEN];
+	uint64_t start_usec;   /* relative to Begin() */
+	uint64_t end_usec;
+}ipacm_startup_stage;
+
+class IPACM_Startup
+{
+public:
+
+	/* take the reference time, called first thing in main() */
+	static void Begin(void);
+
+	/* account one init stage that ran from start_usec until now */
+	static void Stage(const char *name, uint64_t start_usec);
+
+	/* configuration and listeners are in place, log the stage breakdown
+	   and let threads parked in WaitReady() go */
+	static void Ready(void);
+
+	/* block until Ready(), events raised meanwhile stay queued */
+	static void WaitReady(void);
+
+	static inline bool IsReady(void)
+	{
+		return ready;
+	}
+
+	/* log the time to the first occurrence of the milestone */
+	static void Milestone(ipacm_startup_milestone id);
+
+	/* text dump of the stage breakdown and milestones */
+	static int dump(char *buf, int len);
+
+private:
+	static uint64_t begin_usec;
+	static uint64_t boot_usec;
+	static int num_stages;
+	static ipacm_startup_stage stages[IPACM_STARTUP_MAX_STAGES];
+	static uint64_t milestones[IPACM_STARTUP_MILESTONE_MAX];
+	static volatile bool ready;
+	static uint64_t ready_usec;
+	static pthread_mutex_t lock;
+	static pthread_cond_t cond;
+};
+
+#endif /* IPACM_STARTUP_H */
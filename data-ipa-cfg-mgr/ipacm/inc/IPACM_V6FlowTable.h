@@ -0,0 +1,173 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_V6FlowTable.h
+
+	@brief
+	This file implements the IPACM IPv6 conntrack flow table definitions
+
+	@Author
+
+*/
+#ifndef IPACM_V6FLOWTABLE_H
+#define IPACM_V6FLOWTABLE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "IPACM_Defs.h"
+#include "IPACM_Xml.h"
+
+/* open addressing slots of the routed client address set, power of 2 */
+#define IPACM_V6FLOW_ROUTED_SHIFT 8
+#define IPACM_V6FLOW_ROUTED_SLOTS (1 << IPACM_V6FLOW_ROUTED_SHIFT)
+#define IPACM_V6FLOW_ROUTED_MAX (IPACM_V6FLOW_ROUTED_SLOTS * 3 / 4)
+
+/* flows listed on the stats socket, most recently seen first */
+#define IPACM_V6FLOW_DUMP_FLOWS 16
+
+typedef enum
+{
+	IPACM_V6FLOW_EVT_NEW = 0,
+	IPACM_V6FLOW_EVT_UPDATE,
+	IPACM_V6FLOW_EVT_DESTROY
+}ipacm_v6flow_evt;
+
+/* where the downlink of a flow is handled */
+typedef enum
+{
+	IPACM_V6FLOW_SLOW = 0,		/* no client routing rule, or lan to lan */
+	IPACM_V6FLOW_FILTERED,		/* client routed, wan firewall passes it to exception */
+	IPACM_V6FLOW_OFFLOADED,		/* client routed and let through by the wan firewall */
+	IPACM_V6FLOW_CLASS_MAX
+}ipacm_v6flow_class;
+
+/* original direction 5-tuple, host byte order */
+typedef struct _ipacm_v6flow_key
+{
+	uint32_t src[4];
+	uint32_t dst[4];
+	uint16_t sport;
+	uint16_t dport;
+	uint8_t proto;
+}ipacm_v6flow_key;
+
+typedef struct _ipacm_v6flow
+{
+	ipacm_v6flow_key key;
+	int hash_next;		/* bucket chain, free list while unused */
+	int lru_prev;
+	int lru_next;
+	uint32_t rule_gen;	/* rule generation cls was computed at */
+	uint8_t cls;
+	uint32_t events;
+	uint32_t hit_events;
+	uint64_t first_usec;
+	uint64_t last_usec;
+}ipacm_v6flow;
+
+typedef struct _ipacm_v6flow_stats
+{
+	uint64_t events;
+	uint64_t hit_events;
+	uint32_t created;
+	uint32_t destroyed;
+	uint32_t evicted;
+	uint32_t untracked;	/* destroy of a flow which was not tracked */
+	uint32_t reclassified;
+	uint32_t active;
+	uint32_t peak;
+	uint32_t active_cls[IPACM_V6FLOW_CLASS_MAX];
+}ipacm_v6flow_stats;
+
+class IPACM_V6FlowTable
+{
+public:
+
+	/* allocate the flow pool, max_flows as configured by MaxFlows,
+	   tracking stays off when it is 0 or not configured */
+	static int Init(int max_flows);
+
+	static inline bool IsEnabled(void)
+	{
+		return (pool != NULL);
+	}
+
+	/* account one conntrack event, returns the class of the flow */
+	static ipacm_v6flow_class Track(const ipacm_v6flow_key *key, ipacm_v6flow_evt evt);
+
+	/* client address with installed v6 routing rules, host byte order */
+	static void AddRoutedAddr(const uint32_t *addr);
+	static void DelRoutedAddr(const uint32_t *addr);
+
+	/* v6 part of the wan firewall configuration */
+	static void SetFirewall(const IPACM_firewall_conf_t *fw);
+
+	/* text dump of the counters and the most recent flows */
+	static int dump(char *buf, int len);
+
+private:
+	static pthread_mutex_t table_lock;
+
+	static ipacm_v6flow *pool;
+	static int max_flows;
+	static int *bucket;
+	static int bucket_shift;
+	static int free_head;
+	static int lru_head;
+	static int lru_tail;
+	static ipacm_v6flow_stats stats;
+
+	/* bumped on every routed address or firewall change, flows
+	   classified at an older generation are classified again */
+	static uint32_t rule_gen;
+
+	static uint32_t routed_addr[IPACM_V6FLOW_ROUTED_SLOTS][4];
+	static int num_routed;
+
+	static bool fw_enable;
+	static bool fw_accept;
+	static int num_fw_rules;
+	static struct ipa_rule_attrib fw_rules[IPACM_MAX_FIREWALL_ENTRIES];
+
+	static uint32_t HashKey(const ipacm_v6flow_key *key);
+	static int Find(const ipacm_v6flow_key *key, uint32_t hash);
+	static int Alloc(void);
+	static void Remove(int idx);
+	static void LruUnlink(int idx);
+	static void LruPushHead(int idx);
+
+	static int FindRouted(const uint32_t *addr);
+	static bool IsRouted(const uint32_t *addr);
+	static bool MatchFirewall(const struct ipa_rule_attrib *attrib, const ipacm_v6flow_key *dl);
+	static ipacm_v6flow_class Classify(const ipacm_v6flow_key *key);
+	static void Refresh(ipacm_v6flow *flow);
+};
+
+#endif /* IPACM_V6FLOWTABLE_H */
@@ -48,6 +48,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <IPACM_Iface.h>
 #include <IPACM_Defs.h>
 #include <IPACM_Xml.h>
+#include "IPACM_EvtExecutor.h"
 
 #define IPA_NUM_DEFAULT_WAN_FILTER_RULES 3 /*1 for v4, 2 for v6*/
 #define IPA_V2_NUM_DEFAULT_WAN_FILTER_RULE_IPV4 2
@@ -154,6 +155,9 @@ public:
 	void event_callback(ipa_cm_event_id event,
 											void *data);
 
+	/* WAN instances share the static firewall rule tables below */
+	int get_executor(void) { return IPACM_EXEC_WAN; }
+
 	static struct ipa_flt_rule_add flt_rule_v4[IPA_MAX_FLT_RULE];
 	static struct ipa_flt_rule_add flt_rule_v6[IPA_MAX_FLT_RULE];
 
@@ -352,7 +356,7 @@ private:
 		return IPACM_INVALID_INDEX;
 	}
 
-	inline int delete_wan_rtrules(int clt_indx, ipa_ip_type iptype)
+	inline int delete_wan_rtrules(int clt_indx, ipa_ip_type iptype, bool defer = false)
 	{
 		uint32_t tx_index;
 		uint32_t rt_hdl;
@@ -367,18 +371,9 @@ private:
 				IPACMDBG_H("Delete client index %d ipv4 Qos rules for tx:%d \n",clt_indx,tx_index);
 				rt_hdl = get_client_memptr(wan_client, clt_indx)->wan_rt_hdl[tx_index].wan_rt_rule_hdl_v4;
 
-				if(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v4) == false)
-				{
-					return IPACM_FAILURE;
-				}
+				hdl_batch.add(IPACM_HDL_OWNER_CLIENT(clt_indx), IPACM_HDL_RT, IPA_IP_v4, rt_hdl);
 			}
 		     } /* end of for loop */
-
-		     /* clean the 4 Qos ipv4 RT rules for client:clt_indx */
-		     if(get_client_memptr(wan_client, clt_indx)->route_rule_set_v4==true) /* for ipv4 */
-		     {
-				get_client_memptr(wan_client, clt_indx)->route_rule_set_v4 = false;
-		     }
 		}
 
 		if(iptype == IPA_IP_v6)
@@ -392,29 +387,51 @@ private:
 					{
 						IPACMDBG_H("Delete client index %d ipv6 Qos rules for %d-st ipv6 for tx:%d\n", clt_indx,num_v6,tx_index);
 						rt_hdl = get_client_memptr(wan_client, clt_indx)->wan_rt_hdl[tx_index].wan_rt_rule_hdl_v6[num_v6];
-						if(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v6) == false)
-						{
-							return IPACM_FAILURE;
-						}
+						hdl_batch.add(IPACM_HDL_OWNER_CLIENT(clt_indx), IPACM_HDL_RT, IPA_IP_v6, rt_hdl);
 
 						rt_hdl = get_client_memptr(wan_client, clt_indx)->wan_rt_hdl[tx_index].wan_rt_rule_hdl_v6_wan[num_v6];
-						if(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v6) == false)
-						{
-							return IPACM_FAILURE;
-						}
+						hdl_batch.add(IPACM_HDL_OWNER_CLIENT(clt_indx), IPACM_HDL_RT, IPA_IP_v6, rt_hdl);
 					}
 
 				}
 			} /* end of for loop */
+		}
 
+		/* a deferring caller flushes the client's handles together and calls
+		   clear_wan_rtrules() once that worked, the route rule state is
+		   kept until the handles are gone */
+		if(defer == true)
+		{
+			return IPACM_SUCCESS;
+		}
+		if(hdl_batch.flush(IPACM_HDL_OWNER_CLIENT(clt_indx)))
+		{
+			return IPACM_FAILURE;
+		}
+		clear_wan_rtrules(clt_indx, iptype);
+		return IPACM_SUCCESS;
+	}
+
+	/* forget the route rules of client clt_indx once their handles are deleted */
+	inline void clear_wan_rtrules(int clt_indx, ipa_ip_type iptype)
+	{
+		if(iptype == IPA_IP_v4)
+		{
+		     /* clean the 4 Qos ipv4 RT rules for client:clt_indx */
+		     if(get_client_memptr(wan_client, clt_indx)->route_rule_set_v4==true) /* for ipv4 */
+		     {
+				get_client_memptr(wan_client, clt_indx)->route_rule_set_v4 = false;
+		     }
+		}
+
+		if(iptype == IPA_IP_v6)
+		{
 		    /* clean the 4 Qos ipv6 RT rules for client:clt_indx */
 		    if(get_client_memptr(wan_client, clt_indx)->route_rule_set_v6 != 0) /* for ipv6 */
 		    {
 		                 get_client_memptr(wan_client, clt_indx)->route_rule_set_v6 = 0;
                     }
 		}
-
-		return IPACM_SUCCESS;
 	}
 
 	int handle_wan_hdr_init(uint8_t *mac_addr);
@@ -146,7 +146,7 @@ private:
 		return IPACM_INVALID_INDEX;
 	}
 
-	inline int delete_default_qos_rtrules(int clt_indx, ipa_ip_type iptype)
+	inline int delete_default_qos_rtrules(int clt_indx, ipa_ip_type iptype, bool defer = false)
 	{
 		uint32_t tx_index;
 		uint32_t rt_hdl;
@@ -161,18 +161,9 @@ private:
 				IPACMDBG_H("Delete client index %d ipv4 Qos rules for tx:%d \n",clt_indx,tx_index);
 				rt_hdl = get_client_memptr(wlan_client, clt_indx)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v4;
 
-				if(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v4) == false)
-				{
-					return IPACM_FAILURE;
-				}
+				hdl_batch.add(IPACM_HDL_OWNER_CLIENT(clt_indx), IPACM_HDL_RT, IPA_IP_v4, rt_hdl);
 			}
 		     } /* end of for loop */
-
-		     /* clean the 4 Qos ipv4 RT rules for client:clt_indx */
-		     if(get_client_memptr(wlan_client, clt_indx)->route_rule_set_v4==true) /* for ipv4 */
-		     {
-				get_client_memptr(wlan_client, clt_indx)->route_rule_set_v4 = false;
-		     }
 		}
 
 		if(iptype == IPA_IP_v6)
@@ -186,29 +177,57 @@ private:
 					{
 						IPACMDBG_H("Delete client index %d ipv6 Qos rules for %d-st ipv6 for tx:%d\n", clt_indx,num_v6,tx_index);
 						rt_hdl = get_client_memptr(wlan_client, clt_indx)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6[num_v6];
-						if(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v6) == false)
-						{
-							return IPACM_FAILURE;
-						}
+						hdl_batch.add(IPACM_HDL_OWNER_CLIENT(clt_indx), IPACM_HDL_RT, IPA_IP_v6, rt_hdl);
 
 						rt_hdl = get_client_memptr(wlan_client, clt_indx)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6_wan[num_v6];
-						if(m_routing.DeleteRoutingHdl(rt_hdl, IPA_IP_v6) == false)
-						{
-							return IPACM_FAILURE;
-						}
+						hdl_batch.add(IPACM_HDL_OWNER_CLIENT(clt_indx), IPACM_HDL_RT, IPA_IP_v6, rt_hdl);
 					}
 
 				}
 			} /* end of for loop */
+		}
+
+		/* a deferring caller flushes the client's handles together and calls
+		   clear_default_qos_rtrules() once that worked, the route rule state is
+		   kept until the handles are gone */
+		if(defer == true)
+		{
+			return IPACM_SUCCESS;
+		}
+		if(hdl_batch.flush(IPACM_HDL_OWNER_CLIENT(clt_indx)))
+		{
+			return IPACM_FAILURE;
+		}
+		clear_default_qos_rtrules(clt_indx, iptype);
+		return IPACM_SUCCESS;
+	}
+
+	/* forget the route rules of client clt_indx once their handles are deleted */
+	inline void clear_default_qos_rtrules(int clt_indx, ipa_ip_type iptype)
+	{
+		int num_v6;
 
+		if(iptype == IPA_IP_v4)
+		{
+		     /* clean the 4 Qos ipv4 RT rules for client:clt_indx */
+		     if(get_client_memptr(wlan_client, clt_indx)->route_rule_set_v4==true) /* for ipv4 */
+		     {
+				get_client_memptr(wlan_client, clt_indx)->route_rule_set_v4 = false;
+		     }
+		}
+
+		if(iptype == IPA_IP_v6)
+		{
 		    /* clean the 4 Qos ipv6 RT rules for client:clt_indx */
 		    if(get_client_memptr(wlan_client, clt_indx)->route_rule_set_v6 != 0) /* for ipv6 */
 		    {
+				for(num_v6 = 0; num_v6 < get_client_memptr(wlan_client, clt_indx)->route_rule_set_v6; num_v6++)
+				{
+					IPACM_V6FlowTable::DelRoutedAddr(get_client_memptr(wlan_client, clt_indx)->v6_addr[num_v6]);
+				}
 		                 get_client_memptr(wlan_client, clt_indx)->route_rule_set_v6 = 0;
                     }
 		}
-
-		return IPACM_SUCCESS;
 	}
 
 	/* for handle wifi client initial,copy all partial headers (tx property) */
@@ -177,10 +177,27 @@ if (!(a)) {                                                 \
 
 #define IPACMNat_TAG                         "IPACMNAT"
 #define NAT_MaxEntries_TAG                   "MaxNatEntries"
+#define NAT_MaxPendingEntries_TAG            "MaxPendingNatEntries"
 
 #define IP_PassthroughFlag_TAG               "IPPassthroughFlag"
 #define IP_PassthroughMode_TAG               "IPPassthroughMode"
 
+#define IPACMDebug_TAG                       "IPACMDebug"
+#define RecordEvents_TAG                     "RecordEvents"
+
+#define IPACMLanToLan_TAG                    "IPACMLanToLan"
+#define L2L_MaxClients_TAG                   "MaxClients"
+#define L2L_MaxIfaces_TAG                    "MaxIfaces"
+
+#define IPACMEvent_TAG                       "IPACMEvent"
+#define WorkerThreads_TAG                    "WorkerThreads"
+
+#define IPACMV6Flow_TAG                      "IPACMV6Flow"
+#define V6Flow_MaxFlows_TAG                  "MaxFlows"
+
+#define IPACMNeighbor_TAG                    "IPACMNeighbor"
+#define Neighbor_MaxNeighbors_TAG            "MaxNeighbors"
+
 /*---------------------------------------------------------------------------
       IP protocol numbers - use in dss_socket() to identify protocols.
       Also contains the extension header types for IPv6.
@@ -241,6 +258,8 @@ typedef struct
 	bool rule_action_accept;
 	bool firewall_enable;
 } IPACM_firewall_conf_t;
+
+#define IPACM_FIREWALL_XML_FILE "/etc/mobileap_firewall.xml"
   
 
 
@@ -275,11 +294,18 @@ typedef struct  _IPACM_conf_t
 	ipacm_private_subnet_conf_t private_subnet_config;
 	ipacm_alg_conf_t alg_config;
 	int nat_max_entries;
+	int nat_pending_max_entries;
 	bool odu_enable;
 	bool router_mode_enable;
 	bool odu_embms_enable;
 	int num_wlan_guest_ap;
 	bool ip_passthrough_mode;
+	bool record_events;
+	int event_workers;
+	int lan2lan_max_client;
+	int lan2lan_max_iface;
+	int v6flow_max_flows;
+	int neighbor_max_client;
 } IPACM_conf_t;  
 
 /* This function read IPACM XML configuration*/
@@ -296,6 +322,14 @@ int IPACM_read_firewall_xml
 	IPACM_firewall_conf_t *config                   /* Mobile AP config data */
 );
 
+/* Same as IPACM_read_firewall_xml, the last good parse is kept in memory
+   and served until the file changes on disk */
+int IPACM_read_firewall_xml_cached
+(
+	char *xml_file,                                 /* Filename and path     */
+	IPACM_firewall_conf_t *config                   /* Mobile AP config data */
+);
+
 #ifdef __cplusplus
 }
 #endif
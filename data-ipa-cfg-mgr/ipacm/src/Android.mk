@@ -57,6 +57,14 @@ LOCAL_SRC_FILES := IPACM_Main.cpp \
 		IPACM_Conntrack_NATApp.cpp\
 		IPACM_ConntrackClient.cpp \
 		IPACM_ConntrackListener.cpp \
+		IPACM_EvtStats.cpp \
+		IPACM_EvtRecord.cpp \
+		IPACM_EvtExecutor.cpp \
+		IPACM_FlowClassifier.cpp \
+		IPACM_V6FlowTable.cpp \
+		IPACM_DriverMsg.cpp \
+		IPACM_Startup.cpp \
+		IPACM_HdlBatch.cpp \
                 IPACM_Log.cpp
 
 LOCAL_MODULE := ipacm
@@ -41,6 +41,9 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_CmdQueue.h"
 #include "IPACM_Log.h"
 #include "IPACM_Iface.h"
+#include "IPACM_EvtStats.h"
+#include "IPACM_EvtRecord.h"
+#include "IPACM_Startup.h"
 
 pthread_mutex_t mutex    = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t  cond_var = PTHREAD_COND_INITIALIZER;
@@ -80,6 +83,9 @@ MessageQueue* MessageQueue::getInstanceExternal()
 
 void MessageQueue::enqueue(Message *item)
 {
+	clock_gettime(CLOCK_MONOTONIC, &item->enq_ts);
+	depth++;
+
 	if(!Head)
 	{
 		Tail = item;
@@ -111,6 +117,7 @@ Message* MessageQueue::dequeue(void)
 	{
 		Message *tmp = Head;
 		Head = Head->getnext();
+		depth--;
 
 		return tmp;
 	}
@@ -138,6 +145,9 @@ void* MessageQueue::Process(void *param)
 		return NULL;
 	}
 
+	/* listeners need the configuration, early events wait in the queues */
+	IPACM_Startup::WaitReady();
+
 	while(1)
 	{
 		if(pthread_mutex_lock(&mutex) != 0)
@@ -195,6 +205,7 @@ void* MessageQueue::Process(void *param)
 			}
 
 			IPACMDBG("Processing item %p event ID: %d\n",item,item->evt.data.event);
+			IPACM_EvtStats::record_queue_delay(item->evt.data.event, &item->enq_ts);
 			item->evt.callback_ptr(&item->evt.data);
 			delete item;
 			item = NULL;
@@ -203,3 +214,91 @@ void* MessageQueue::Process(void *param)
 	} /* Go forever until a termination indication is received */
 
 }
+
+int MessageQueue::Drain(void)
+{
+	MessageQueue *MsgQueueInternal = MessageQueue::getInstanceInternal();
+	MessageQueue *MsgQueueExternal = MessageQueue::getInstanceExternal();
+	Message *item = NULL;
+	int processed = 0;
+
+	if(MsgQueueInternal == NULL || MsgQueueExternal == NULL)
+	{
+		IPACMERR("unable to get cmd queue instance\n");
+		return 0;
+	}
+
+	while(1)
+	{
+		if(pthread_mutex_lock(&mutex) != 0)
+		{
+			IPACMERR("unable to lock the mutex\n");
+			return processed;
+		}
+
+		item = MsgQueueInternal->dequeue();
+		if(item == NULL)
+		{
+			item = MsgQueueExternal->dequeue();
+		}
+
+		if(pthread_mutex_unlock(&mutex) != 0)
+		{
+			IPACMERR("unable to unlock the mutex\n");
+			return processed;
+		}
+
+		if(item == NULL)
+		{
+			break;
+		}
+
+		IPACM_EvtStats::record_queue_delay(item->evt.data.event, &item->enq_ts);
+		item->evt.callback_ptr(&item->evt.data);
+		delete item;
+		processed++;
+	}
+
+	return processed;
+}
+
+int MessageQueue::StartRecording(const char *path)
+{
+	MessageQueue *queues[2];
+	Message *item;
+	int i, ret;
+
+	queues[0] = MessageQueue::getInstanceExternal();
+	queues[1] = MessageQueue::getInstanceInternal();
+	if(queues[0] == NULL || queues[1] == NULL)
+	{
+		IPACMERR("unable to get cmd queue instance\n");
+		return IPACM_FAILURE;
+	}
+
+	/* PostEvt records under the same mutex, no event is missed or doubled */
+	if(pthread_mutex_lock(&mutex) != 0)
+	{
+		IPACMERR("unable to lock the mutex\n");
+		return IPACM_FAILURE;
+	}
+
+	ret = IPACM_EvtRecord::Start(path);
+	if(ret == IPACM_SUCCESS)
+	{
+		for(i = 0; i < 2; i++)
+		{
+			for(item = queues[i]->Head; item != NULL; item = item->getnext())
+			{
+				IPACM_EvtRecord::Record(&item->evt.data, false);
+			}
+		}
+	}
+
+	if(pthread_mutex_unlock(&mutex) != 0)
+	{
+		IPACMERR("unable to unlock the mutex\n");
+		return IPACM_FAILURE;
+	}
+	return ret;
+}
@@ -40,12 +40,14 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <IPACM_Config.h>
 #include <IPACM_Log.h>
 #include <IPACM_Iface.h>
+#include <IPACM_EvtExecutor.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
 
 IPACM_Config *IPACM_Config::pInstance = NULL;
 const char *IPACM_Config::DEVICE_NAME = "/dev/ipa";
 const char *IPACM_Config::DEVICE_NAME_ODU = "/dev/odu_ipa_bridge";
+const char *IPACM_Config::config_file = "/etc/IPACM_cfg.xml";
 
 #define __stringify(x...) #x
 
@@ -118,12 +120,19 @@ IPACM_Config::IPACM_Config()
 	ipa_rm_a2_check=0;
 	ipacm_odu_enable = false;
 	ipacm_odu_router_mode = false;
+	ipacm_record_events = false;
+	ipa_event_workers = 0;
 	ipa_num_wlan_guest_ap = 0;
 
 	ipa_num_ipa_interfaces = 0;
 	ipa_num_private_subnet = 0;
 	ipa_num_alg_ports = 0;
 	ipa_nat_max_entries = 0;
+	ipa_nat_pending_max_entries = 0;
+	ipa_lan2lan_max_client = 0;
+	ipa_lan2lan_max_iface = 0;
+	ipa_v6flow_max_flows = 0;
+	ipa_neighbor_max_client = 0;
 	ipa_nat_iface_entries = 0;
 	ipa_sw_rt_enable = false;
 	ipa_bridge_enable = false;
@@ -147,6 +156,7 @@ IPACM_Config::IPACM_Config()
 	memset(flt_rule_count_v4, 0, (IPA_CLIENT_CONS - IPA_CLIENT_PROD)*sizeof(int));
 	memset(flt_rule_count_v6, 0, (IPA_CLIENT_CONS - IPA_CLIENT_PROD)*sizeof(int));
 	memset(bridge_mac, 0, IPA_MAC_ADDR_SIZE*sizeof(uint8_t));
+	memset(ifindex_map, -1, sizeof(ifindex_map));
 
 	IPACMDBG_H(" create IPACM_Config constructor\n");
 	return;
@@ -173,7 +183,7 @@ int IPACM_Config::Init(void)
 	{
 		IPACMERR("Failed opening %s.\n", DEVICE_NAME);
 	}
-	strncpy(IPACM_config_file, "/etc/IPACM_cfg.xml", sizeof(IPACM_config_file));
+	strlcpy(IPACM_config_file, config_file, sizeof(IPACM_config_file));
 
 	IPACMDBG_H("\n IPACM XML file is %s \n", IPACM_config_file);
 	if (IPACM_SUCCESS == ipacm_read_cfg_xml(IPACM_config_file, cfg))
@@ -203,6 +213,7 @@ int IPACM_Config::Init(void)
 		iface_table = NULL;
 		IPACMDBG_H("RESET IPACM_Config::iface_table\n");
 	}
+	memset(ifindex_map, -1, sizeof(ifindex_map));
 	iface_table = (ipa_ifi_dev_name_t *)calloc(ipa_num_ipa_interfaces,
 					sizeof(ipa_ifi_dev_name_t));
 	if(iface_table == NULL)
@@ -280,6 +291,18 @@ int IPACM_Config::Init(void)
 	ipa_nat_max_entries = cfg->nat_max_entries;
 	IPACMDBG_H("Nat Maximum Entries %d\n", ipa_nat_max_entries);
 
+	ipa_nat_pending_max_entries = cfg->nat_pending_max_entries;
+	IPACMDBG_H("Nat Pending Maximum Entries %d\n", ipa_nat_pending_max_entries);
+
+	ipa_lan2lan_max_client = cfg->lan2lan_max_client;
+	ipa_lan2lan_max_iface = cfg->lan2lan_max_iface;
+	IPACMDBG_H("LanToLan max clients %d, max ifaces %d\n", ipa_lan2lan_max_client, ipa_lan2lan_max_iface);
+
+	ipa_v6flow_max_flows = cfg->v6flow_max_flows;
+	IPACMDBG_H("IPv6 flow table max flows %d\n", ipa_v6flow_max_flows);
+	ipa_neighbor_max_client = cfg->neighbor_max_client;
+	IPACMDBG_H("neighbor cache max clients %d\n", ipa_neighbor_max_client);
+
 	/* Find ODU is either router mode or bridge mode*/
 	ipacm_odu_enable = cfg->odu_enable;
 	ipacm_odu_router_mode = cfg->router_mode_enable;
@@ -291,6 +314,12 @@ int IPACM_Config::Init(void)
 	ipacm_ip_passthrough_mode = cfg->ip_passthrough_mode;
 	IPACMDBG_H("ipacm_ip_passthrough_mode %d. \n", ipacm_ip_passthrough_mode);
 
+	ipacm_record_events = cfg->record_events;
+	IPACMDBG_H("ipacm_record_events %d\n", ipacm_record_events);
+
+	ipa_event_workers = cfg->event_workers;
+	IPACMDBG_H("ipa_event_workers %d\n", ipa_event_workers);
+
 	ipa_num_wlan_guest_ap = cfg->num_wlan_guest_ap;
 	IPACMDBG_H("ipa_num_wlan_guest_ap %d\n",ipa_num_wlan_guest_ap);
 
@@ -395,6 +424,9 @@ int IPACM_Config::Init(void)
 	IPACMDBG_H(" depend MAP-4 rm index %d to rm index: %d \n", IPA_RM_RESOURCE_WLAN_PROD, IPA_RM_RESOURCE_ODU_ADAPT_CONS);
 	IPACMDBG_H(" depend MAP-5 rm index %d to rm index: %d \n", IPA_RM_RESOURCE_ODU_ADAPT_PROD, IPA_RM_RESOURCE_USB_CONS);
 
+	/* alg ports, private subnets and nat ifaces may have changed */
+	IPACM_FlowClassifier::Rebuild();
+
 fail:
 	if (cfg != NULL)
 	{
@@ -417,6 +449,7 @@ IPACM_Config* IPACM_Config::GetInstance()
 		if (res != IPACM_SUCCESS)
 		{
 			delete pInstance;
+			pInstance = NULL;
 			IPACMERR("unable to initialize config instance\n");
 			return NULL;
 		}
@@ -461,6 +494,23 @@ int IPACM_Config::GetNatIfaces(int nIfaces, NatIfaces *pIfaces)
 }
 
 
+void IPACM_Config::SetIfaceNetlinkIndex(int ipa_index, int netlink_index)
+{
+	if(ipa_index < 0 || ipa_index >= ipa_num_ipa_interfaces)
+	{
+		IPACMERR("Invalid ipa iface index %d\n", ipa_index);
+		return;
+	}
+
+	iface_table[ipa_index].netlink_interface_index = netlink_index;
+	if(netlink_index > 0 && netlink_index < IPA_MAX_NETLINK_IFINDEX)
+	{
+		/* a stale slot of the old ifindex fails the check in GetIfaceByNetlinkIndex */
+		ifindex_map[netlink_index] = ipa_index;
+	}
+	return;
+}
+
 int IPACM_Config::AddNatIfaces(char *dev_name)
 {
 	int i;
@@ -489,6 +539,7 @@ int IPACM_Config::AddNatIfaces(char *dev_name)
 						 pNatIfaces[ipa_nat_iface_entries - 1].iface_name,
 						 ipa_nat_iface_entries);
 	}
+	IPACM_FlowClassifier::Rebuild();
 
 	return 0;
 }
@@ -519,6 +570,7 @@ int IPACM_Config::DelNatIfaces(char *dev_name)
 			}
 			ipa_nat_iface_entries--;
 			IPACMDBG_H("Update nat-ifaces number: %d\n", ipa_nat_iface_entries);
+			IPACM_FlowClassifier::Rebuild();
 			return 0;
 		}
 	}
@@ -537,6 +589,8 @@ void IPACM_Config::AddRmDepend(ipa_rm_resource_name rm1,bool rx_bypass_ipa)
 	struct ipa_ioc_rm_dependency dep;
 
 	IPACMDBG_H(" Got rm add-depend index : %d \n", rm1);
+	/* RM table is shared by all interfaces */
+	IPACM_EvtExecutor::LockShared();
 	/* ipa_rm_a2_check: IPA_RM_RESOURCE_Q6_CONS*/
 	if(rm1 == IPA_RM_RESOURCE_Q6_CONS)
 	{
@@ -633,6 +687,7 @@ void IPACM_Config::AddRmDepend(ipa_rm_resource_name rm1,bool rx_bypass_ipa)
 			}
 	   }
    }
+   IPACM_EvtExecutor::UnlockShared();
    return ;
 }
 
@@ -645,6 +700,7 @@ void IPACM_Config::DelRmDepend(ipa_rm_resource_name rm1)
 	struct ipa_ioc_rm_dependency dep;
 
 	IPACMDBG_H(" Got rm del-depend index : %d \n", rm1);
+	IPACM_EvtExecutor::LockShared();
 	/* ipa_rm_a2_check: IPA_RM_RESOURCE_Q6_CONS*/
 	if(rm1 == IPA_RM_RESOURCE_Q6_CONS)
 	{
@@ -736,6 +792,7 @@ void IPACM_Config::DelRmDepend(ipa_rm_resource_name rm1)
 			ipa_rm_tbl[i].consumer1_up = false;
 		}
 	}
+	IPACM_EvtExecutor::UnlockShared();
 	return ;
 }
 
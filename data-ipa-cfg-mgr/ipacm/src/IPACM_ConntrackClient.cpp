@@ -31,17 +31,60 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <endian.h>
 #include <net/if.h>
 #include "IPACM_Iface.h"
 #include "IPACM_ConntrackListener.h"
 #include "IPACM_ConntrackClient.h"
+#include "IPACM_EvtStats.h"
+#include "IPACM_V6FlowTable.h"
 #include "IPACM_Log.h"
 
 #define LO_NAME "lo"
 
+/* ctnetlink event layout: nlmsghdr(16) + nfgenmsg(4) + attributes */
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+#define CT_NLMSG_TYPE_OFFSET 4
+#else
+#define CT_NLMSG_TYPE_OFFSET 5
+#endif
+#define CT_NFGEN_FAMILY_OFFSET 16
+#define CT_NLATTR_OFFSET 20
+#define CT_NLATTR_HDRLEN 4
+
+/* scratch memory of the socket filter */
+#define CT_MEM_TUPLE 0
+#define CT_MEM_TUPLE_IP 1
+#define CT_MEM_SRC 2
+#define CT_MEM_DST 3
+
+/* jump targets of the socket filter, CT_LBL_NEXT falls through */
+#define CT_LBL_NEXT (-1)
+enum
+{
+	CT_LBL_TUPLE = 0,
+	CT_LBL_FAMILY,
+	CT_LBL_ADDR,
+	CT_LBL_DROP,
+	CT_LBL_ACCEPT,
+	CT_LBL_MAX
+};
+
+typedef struct _ct_bpf_prog
+{
+	struct sock_filter *insn;
+	int max;
+	int len;
+	int jt_lbl[IPACM_CT_MAX_FILTER_INSN];
+	int jf_lbl[IPACM_CT_MAX_FILTER_INSN];
+	int lbl_pos[CT_LBL_MAX];
+}ct_bpf_prog;
+
 extern IPACM_EvtDispatcher cm_dis;
 extern void ParseCTMessage(struct nf_conntrack *ct);
 
@@ -60,6 +103,11 @@ IPACM_ConntrackClient::IPACM_ConntrackClient()
 	udp_hdl = NULL;
 	tcp_filter = NULL;
 	udp_filter = NULL;
+
+	pthread_mutex_init(&filter_lock, NULL);
+	memset(ignore_addr, 0, sizeof(ignore_addr));
+	num_ignore_addr = 0;
+	wan_addr = 0;
 }
 
 IPACM_ConntrackClient* IPACM_ConntrackClient::GetInstance()
@@ -102,14 +150,16 @@ int IPACM_ConntrackClient::IPAConntrackEventCB
 	uint8_t ip_type = 0;
 
 	IPACMDBG("Event callback called with msgtype: %d\n",type);
+	IPACM_EvtStats::record_ct_event(nfct_get_attr_u8(ct, ATTR_ORIG_L4PROTO));
 
 	/* Retrieve ip type */
 	ip_type = nfct_get_attr_u8(ct, ATTR_REPL_L3PROTO);
 
 #ifndef CT_OPT
-	if(AF_INET6 == ip_type)
+	if(AF_INET6 == ip_type && !IPACM_V6FlowTable::IsEnabled())
 	{
 		IPACMDBG("Ignoring ipv6(%d) connections\n", ip_type);
+		IPACM_EvtStats::record_ct_ignored(nfct_get_attr_u8(ct, ATTR_ORIG_L4PROTO));
 		goto IGNORE;
 	}
 
@@ -128,12 +178,10 @@ int IPACM_ConntrackClient::IPAConntrackEventCB
 	evt_data.event = IPA_PROCESS_CT_MESSAGE;
 	evt_data.evt_data = (void *)ct_data;
 
-#ifdef CT_OPT
 	if(AF_INET6 == ip_type)
 	{
 		evt_data.event = IPA_PROCESS_CT_MESSAGE_V6;
 	}
-#endif
 
 	if(0 != IPACM_EvtDispatcher::PostEvt(&evt_data))
 	{
@@ -185,6 +233,7 @@ int IPACM_ConntrackClient::IPA_Conntrack_Filters_Ignore_Bridge_Addrs
 	IPACMDBG("Interface (%s) address %s\n", ifr.ifr_name, inet_ntoa(((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr));
 	ipv4_addr = ntohl(((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr.s_addr);
 	close(fd);
+	AddIgnoreAddr(ipv4_addr);
 
 	/* ignore whatever is destined to or originates from broadcast ip address */
 	struct nfct_filter_ipv4 filter_ipv4;
@@ -217,6 +266,7 @@ int IPACM_ConntrackClient::IPA_Conntrack_Filters_Ignore_Local_Iface
 
 	filter_ipv4.addr = param->ipv4_addr;
 	filter_ipv4.mask = 0xffffffff;
+	AddIgnoreAddr(param->ipv4_addr);
 
 	/* ignore whatever is destined to local interfaces */
 	IPACMDBG("Ignore connections destinated to interface %s", param->ifname);
@@ -245,6 +295,7 @@ int IPACM_ConntrackClient::IPA_Conntrack_Filters_Ignore_Local_Iface
 
 	/* netfitler expecting in host-byte order */
 	filter_ipv4.addr = bc_ip_addr;
+	AddIgnoreAddr(bc_ip_addr);
 	filter_ipv4.mask = 0xffffffff;
 
 	iptodot("with broadcast address", filter_ipv4.addr);
@@ -269,6 +320,7 @@ int IPACM_ConntrackClient::IPA_Conntrack_Filters_Ignore_Local_Addrs
 	/* ignore whatever is destined to or originates from broadcast ip address */
 	filter_ipv4.addr = 0xffffffff;
 	filter_ipv4.mask = 0xffffffff;
+	AddIgnoreAddr(BROADCAST_IPV4_ADDR);
 
 	nfct_filter_set_logic(filter,
 												NFCT_FILTER_DST_IPV4,
@@ -285,6 +337,346 @@ int IPACM_ConntrackClient::IPA_Conntrack_Filters_Ignore_Local_Addrs
 	return 0;
 } /* IPA_Conntrack_Filters_Ignore_Local_Addrs() */
 
+/* Remember a local address for the kernel socket filters */
+void IPACM_ConntrackClient::AddIgnoreAddr(uint32_t addr)
+{
+	int cnt;
+	IPACM_ConntrackClient *pClient = IPACM_ConntrackClient::GetInstance();
+
+	if(pClient == NULL || addr == 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&pClient->filter_lock);
+	for(cnt = 0; cnt < pClient->num_ignore_addr; cnt++)
+	{
+		if(pClient->ignore_addr[cnt] == addr)
+		{
+			pthread_mutex_unlock(&pClient->filter_lock);
+			return;
+		}
+	}
+
+	if(pClient->num_ignore_addr >= IPACM_CT_MAX_IGNORE_ADDR)
+	{
+		IPACMERR("ignore list full, 0x%x is filtered in userspace only\n", addr);
+		pthread_mutex_unlock(&pClient->filter_lock);
+		return;
+	}
+	pClient->ignore_addr[pClient->num_ignore_addr++] = addr;
+	pthread_mutex_unlock(&pClient->filter_lock);
+	return;
+}
+
+static void ct_bpf_jump(ct_bpf_prog *prog, uint16_t code, uint32_t k, int jt, int jf)
+{
+	if(prog->len < prog->max)
+	{
+		prog->insn[prog->len].code = code;
+		prog->insn[prog->len].jt = 0;
+		prog->insn[prog->len].jf = 0;
+		prog->insn[prog->len].k = k;
+		prog->jt_lbl[prog->len] = jt;
+		prog->jf_lbl[prog->len] = jf;
+	}
+	prog->len++;
+}
+
+static void ct_bpf_stmt(ct_bpf_prog *prog, uint16_t code, uint32_t k)
+{
+	ct_bpf_jump(prog, code, k, CT_LBL_NEXT, CT_LBL_NEXT);
+}
+
+/* A = offset of attribute 'type' searched from offset A (top level) or
+   inside the attribute at offset A (nested), jumps to 'missing' if not
+   present. The kernel takes the offset from A and the type from X, so
+   X is clobbered. */
+static void ct_bpf_find_attr(ct_bpf_prog *prog, uint32_t type, bool nested, int missing)
+{
+	ct_bpf_stmt(prog, BPF_LDX | BPF_IMM, type);
+	ct_bpf_stmt(prog, BPF_LD | BPF_W | BPF_ABS,
+		SKF_AD_OFF + (nested ? SKF_AD_NLATTR_NEST : SKF_AD_NLATTR));
+	ct_bpf_jump(prog, BPF_JMP | BPF_JEQ | BPF_K, 0, missing, CT_LBL_NEXT);
+}
+
+/* Patch label jumps into relative offsets, -1 if the program does not fit */
+static int ct_bpf_resolve(ct_bpf_prog *prog)
+{
+	int cnt, off;
+
+	if(prog->len > prog->max)
+	{
+		return -1;
+	}
+
+	for(cnt = 0; cnt < prog->len; cnt++)
+	{
+		if(prog->jt_lbl[cnt] != CT_LBL_NEXT)
+		{
+			off = prog->lbl_pos[prog->jt_lbl[cnt]] - cnt - 1;
+			if(off < 0 || off > 255)
+			{
+				return -1;
+			}
+			prog->insn[cnt].jt = off;
+		}
+		if(prog->jf_lbl[cnt] != CT_LBL_NEXT)
+		{
+			off = prog->lbl_pos[prog->jf_lbl[cnt]] - cnt - 1;
+			if(off < 0 || off > 255)
+			{
+				return -1;
+			}
+			prog->insn[cnt].jf = off;
+		}
+	}
+	return prog->len;
+}
+
+/* Compile the userspace offload checks into a classic BPF program run on
+   every ctnetlink event: protocol of the handle, tcp state, then for ipv4
+   not a local address and either nat status bits or the wan address.
+   ipv6 events pass when the IPv6 flow table tracks them.
+   Caller holds filter_lock. Returns the program length or -1. */
+int IPACM_ConntrackClient::BuildKernelFilter(struct sock_filter *insn, int max_insn, uint8_t l4proto)
+{
+	ct_bpf_prog prog;
+	int cnt;
+
+	memset(&prog, 0, sizeof(prog));
+	prog.insn = insn;
+	prog.max = (max_insn < IPACM_CT_MAX_FILTER_INSN) ? max_insn : IPACM_CT_MAX_FILTER_INSN;
+
+	/* ipv4, and ipv6 for the flow table */
+	ct_bpf_stmt(&prog, BPF_LD | BPF_B | BPF_ABS, CT_NFGEN_FAMILY_OFFSET);
+	if(IPACM_V6FlowTable::IsEnabled())
+	{
+		ct_bpf_jump(&prog, BPF_JMP | BPF_JEQ | BPF_K, AF_INET, CT_LBL_TUPLE, CT_LBL_NEXT);
+		ct_bpf_jump(&prog, BPF_JMP | BPF_JEQ | BPF_K, AF_INET6, CT_LBL_NEXT, CT_LBL_DROP);
+	}
+	else
+	{
+		ct_bpf_jump(&prog, BPF_JMP | BPF_JEQ | BPF_K, AF_INET, CT_LBL_NEXT, CT_LBL_DROP);
+	}
+
+	/* original direction tuple */
+	prog.lbl_pos[CT_LBL_TUPLE] = prog.len;
+	ct_bpf_stmt(&prog, BPF_LD | BPF_IMM, CT_NLATTR_OFFSET);
+	ct_bpf_find_attr(&prog, CTA_TUPLE_ORIG, false, CT_LBL_DROP);
+	ct_bpf_stmt(&prog, BPF_ST, CT_MEM_TUPLE);
+
+	/* layer 4 protocol of this handle */
+	ct_bpf_find_attr(&prog, CTA_TUPLE_PROTO, true, CT_LBL_DROP);
+	ct_bpf_find_attr(&prog, CTA_PROTO_NUM, true, CT_LBL_DROP);
+	ct_bpf_stmt(&prog, BPF_MISC | BPF_TAX, 0);
+	ct_bpf_stmt(&prog, BPF_LD | BPF_B | BPF_IND, CT_NLATTR_HDRLEN);
+	ct_bpf_jump(&prog, BPF_JMP | BPF_JEQ | BPF_K, l4proto, CT_LBL_NEXT, CT_LBL_DROP);
+
+	/* tcp updates are only of use in established or fin wait state,
+	   destroy events carry no protocol info */
+	if(l4proto == IPPROTO_TCP)
+	{
+		ct_bpf_stmt(&prog, BPF_LD | BPF_B | BPF_ABS, CT_NLMSG_TYPE_OFFSET);
+		ct_bpf_jump(&prog, BPF_JMP | BPF_JEQ | BPF_K, IPCTNL_MSG_CT_DELETE, CT_LBL_FAMILY, CT_LBL_NEXT);
+		ct_bpf_stmt(&prog, BPF_LD | BPF_IMM, CT_NLATTR_OFFSET);
+		ct_bpf_find_attr(&prog, CTA_PROTOINFO, false, CT_LBL_DROP);
+		ct_bpf_find_attr(&prog, CTA_PROTOINFO_TCP, true, CT_LBL_DROP);
+		ct_bpf_find_attr(&prog, CTA_PROTOINFO_TCP_STATE, true, CT_LBL_DROP);
+		ct_bpf_stmt(&prog, BPF_MISC | BPF_TAX, 0);
+		ct_bpf_stmt(&prog, BPF_LD | BPF_B | BPF_IND, CT_NLATTR_HDRLEN);
+		ct_bpf_jump(&prog, BPF_JMP | BPF_JEQ | BPF_K, TCP_CONNTRACK_ESTABLISHED, CT_LBL_FAMILY, CT_LBL_NEXT);
+		ct_bpf_jump(&prog, BPF_JMP | BPF_JEQ | BPF_K, TCP_CONNTRACK_FIN_WAIT, CT_LBL_NEXT, CT_LBL_DROP);
+	}
+
+	/* ipv6 is accounted by the flow table only */
+	prog.lbl_pos[CT_LBL_FAMILY] = prog.len;
+	if(IPACM_V6FlowTable::IsEnabled())
+	{
+		ct_bpf_stmt(&prog, BPF_LD | BPF_B | BPF_ABS, CT_NFGEN_FAMILY_OFFSET);
+		ct_bpf_jump(&prog, BPF_JMP | BPF_JEQ | BPF_K, AF_INET6, CT_LBL_ACCEPT, CT_LBL_NEXT);
+	}
+
+	/* original source and destination address */
+	ct_bpf_stmt(&prog, BPF_LD | BPF_MEM, CT_MEM_TUPLE);
+	ct_bpf_find_attr(&prog, CTA_TUPLE_IP, true, CT_LBL_DROP);
+	ct_bpf_stmt(&prog, BPF_ST, CT_MEM_TUPLE_IP);
+	ct_bpf_find_attr(&prog, CTA_IP_V4_SRC, true, CT_LBL_DROP);
+	ct_bpf_stmt(&prog, BPF_MISC | BPF_TAX, 0);
+	ct_bpf_stmt(&prog, BPF_LD | BPF_W | BPF_IND, CT_NLATTR_HDRLEN);
+	ct_bpf_stmt(&prog, BPF_ST, CT_MEM_SRC);
+	ct_bpf_stmt(&prog, BPF_LD | BPF_MEM, CT_MEM_TUPLE_IP);
+	ct_bpf_find_attr(&prog, CTA_IP_V4_DST, true, CT_LBL_DROP);
+	ct_bpf_stmt(&prog, BPF_MISC | BPF_TAX, 0);
+	ct_bpf_stmt(&prog, BPF_LD | BPF_W | BPF_IND, CT_NLATTR_HDRLEN);
+	ct_bpf_stmt(&prog, BPF_ST, CT_MEM_DST);
+
+	/* connections to and from local addresses */
+	if(pInstance->num_ignore_addr > 0)
+	{
+		ct_bpf_stmt(&prog, BPF_LD | BPF_MEM, CT_MEM_SRC);
+		for(cnt = 0; cnt < pInstance->num_ignore_addr; cnt++)
+		{
+			ct_bpf_jump(&prog, BPF_JMP | BPF_JEQ | BPF_K, pInstance->ignore_addr[cnt], CT_LBL_DROP, CT_LBL_NEXT);
+		}
+		ct_bpf_stmt(&prog, BPF_LD | BPF_MEM, CT_MEM_DST);
+		for(cnt = 0; cnt < pInstance->num_ignore_addr; cnt++)
+		{
+			ct_bpf_jump(&prog, BPF_JMP | BPF_JEQ | BPF_K, pInstance->ignore_addr[cnt], CT_LBL_DROP, CT_LBL_NEXT);
+		}
+	}
+
+	/* source or destination nat */
+	ct_bpf_stmt(&prog, BPF_LD | BPF_IMM, CT_NLATTR_OFFSET);
+	ct_bpf_find_attr(&prog, CTA_STATUS, false, CT_LBL_ADDR);
+	ct_bpf_stmt(&prog, BPF_MISC | BPF_TAX, 0);
+	ct_bpf_stmt(&prog, BPF_LD | BPF_W | BPF_IND, CT_NLATTR_HDRLEN);
+	ct_bpf_jump(&prog, BPF_JMP | BPF_JSET | BPF_K, IPS_SRC_NAT | IPS_DST_NAT, CT_LBL_ACCEPT, CT_LBL_NEXT);
+
+	/* embedded connections of the wan address */
+	prog.lbl_pos[CT_LBL_ADDR] = prog.len;
+	if(pInstance->wan_addr != 0)
+	{
+		ct_bpf_stmt(&prog, BPF_LD | BPF_MEM, CT_MEM_SRC);
+		ct_bpf_jump(&prog, BPF_JMP | BPF_JEQ | BPF_K, pInstance->wan_addr, CT_LBL_ACCEPT, CT_LBL_NEXT);
+		ct_bpf_stmt(&prog, BPF_LD | BPF_MEM, CT_MEM_DST);
+		ct_bpf_jump(&prog, BPF_JMP | BPF_JEQ | BPF_K, pInstance->wan_addr, CT_LBL_ACCEPT, CT_LBL_NEXT);
+	}
+
+	prog.lbl_pos[CT_LBL_DROP] = prog.len;
+	ct_bpf_stmt(&prog, BPF_RET | BPF_K, 0);
+	prog.lbl_pos[CT_LBL_ACCEPT] = prog.len;
+	ct_bpf_stmt(&prog, BPF_RET | BPF_K, 0xffffffff);
+
+	return ct_bpf_resolve(&prog);
+}
+
+/* Attach the compiled kernel filter to the handle. Builds with CT_OPT
+   need non nat and ipv6 connections for lan2lan, they and kernels
+   rejecting the program keep the libnetfilter_conntrack filter. */
+int IPACM_ConntrackClient::AttachFilter(struct nfct_handle *hdl, struct nfct_filter *filter, uint8_t l4proto)
+{
+	int ret;
+#ifndef CT_OPT
+	IPACM_ConntrackClient *pClient = IPACM_ConntrackClient::GetInstance();
+	struct sock_filter insn[IPACM_CT_MAX_FILTER_INSN];
+	struct sock_fprog fprog;
+	int len;
+
+	if(pClient != NULL)
+	{
+		pthread_mutex_lock(&pClient->filter_lock);
+		len = BuildKernelFilter(insn, IPACM_CT_MAX_FILTER_INSN, l4proto);
+		if(len > 0)
+		{
+			fprog.len = len;
+			fprog.filter = insn;
+			ret = setsockopt(nfct_fd(hdl), SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog));
+			if(ret == 0)
+			{
+				IPACMDBG_H("attached %d insn kernel filter for proto %d, wan 0x%x, %d local addrs\n",
+					len, l4proto, pClient->wan_addr, pClient->num_ignore_addr);
+				pthread_mutex_unlock(&pClient->filter_lock);
+				return 0;
+			}
+			IPACMERR("kernel rejected conntrack filter for proto %d (%s)\n", l4proto, strerror(errno));
+		}
+		else
+		{
+			IPACMERR("unable to build conntrack filter for proto %d\n", l4proto);
+		}
+		pthread_mutex_unlock(&pClient->filter_lock);
+	}
+#endif
+
+	ret = nfct_filter_attach(nfct_fd(hdl), filter);
+	return ret;
+}
+
+/* Wan address changed, only connections of it or with nat status
+   reach userspace from now on */
+void IPACM_ConntrackClient::UpdateWanAddr(uint32_t addr)
+{
+	IPACM_ConntrackClient *pClient = IPACM_ConntrackClient::GetInstance();
+
+	if(pClient == NULL)
+	{
+		IPACMERR("unable to retrieve conntrack client instance\n");
+		return;
+	}
+
+	pthread_mutex_lock(&pClient->filter_lock);
+	pClient->wan_addr = addr;
+	pthread_mutex_unlock(&pClient->filter_lock);
+
+#ifndef CT_OPT
+	if(pClient->tcp_hdl != NULL && pClient->tcp_filter != NULL &&
+		 AttachFilter(pClient->tcp_hdl, pClient->tcp_filter, IPPROTO_TCP) == -1)
+	{
+		IPACMERR("unable to attach the filter to tcp handle\n");
+	}
+	if(pClient->udp_hdl != NULL && pClient->udp_filter != NULL &&
+		 AttachFilter(pClient->udp_hdl, pClient->udp_filter, IPPROTO_UDP) == -1)
+	{
+		IPACMERR("unable to attach the filter to udp handle\n");
+	}
+#endif
+	return;
+}
+
+/* Run the kernel filter for l4proto over one ctnetlink message through a
+   socketpair, the kernel interprets the program as on the conntrack handle.
+   Returns 1 if the message passes, 0 if it is dropped, -1 on error. */
+int IPACM_ConntrackClient::RunKernelFilter(uint8_t l4proto, const void *msg, int len)
+{
+	IPACM_ConntrackClient *pClient = IPACM_ConntrackClient::GetInstance();
+	struct sock_filter insn[IPACM_CT_MAX_FILTER_INSN];
+	struct sock_fprog fprog;
+	uint8_t buf[1024];
+	int sv[2], ret;
+
+	if(pClient == NULL)
+	{
+		return -1;
+	}
+
+	pthread_mutex_lock(&pClient->filter_lock);
+	ret = BuildKernelFilter(insn, IPACM_CT_MAX_FILTER_INSN, l4proto);
+	pthread_mutex_unlock(&pClient->filter_lock);
+	if(ret <= 0)
+	{
+		IPACMERR("unable to build conntrack filter for proto %d\n", l4proto);
+		return -1;
+	}
+
+	if(socketpair(AF_UNIX, SOCK_DGRAM, 0, sv) < 0)
+	{
+		IPACMERR("socketpair failed (%s)\n", strerror(errno));
+		return -1;
+	}
+
+	fprog.len = ret;
+	fprog.filter = insn;
+	ret = -1;
+	if(setsockopt(sv[1], SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0)
+	{
+		IPACMERR("kernel rejected conntrack filter for proto %d (%s)\n", l4proto, strerror(errno));
+	}
+	else if(send(sv[0], msg, len, 0) != len)
+	{
+		IPACMERR("unable to send %d bytes (%s)\n", len, strerror(errno));
+	}
+	else
+	{
+		/* a dropped message is discarded on send, nothing is queued */
+		ret = (recv(sv[1], buf, sizeof(buf), MSG_DONTWAIT) > 0) ? 1 : 0;
+	}
+
+	close(sv[0]);
+	close(sv[1]);
+	return ret;
+}
+
 /* Initialize TCP Filter */
 int IPACM_ConntrackClient::IPA_Conntrack_TCP_Filter_Init(void)
 {
@@ -437,7 +829,7 @@ void* IPACM_ConntrackClient::TCPRegisterWithConnTrack(void *)
 	}
 
 	/* Attach the filter to net filter handler */
-	ret = nfct_filter_attach(nfct_fd(pClient->tcp_hdl), pClient->tcp_filter);
+	ret = AttachFilter(pClient->tcp_hdl, pClient->tcp_filter, IPPROTO_TCP);
 	if(ret == -1)
 	{
 		IPACMDBG("unable to attach TCP filter\n");
@@ -514,7 +906,7 @@ void* IPACM_ConntrackClient::UDPRegisterWithConnTrack(void *)
 	}
 
 	/* Attach the filter to net filter handler */
-	ret = nfct_filter_attach(nfct_fd(pClient->udp_hdl), pClient->udp_filter);
+	ret = AttachFilter(pClient->udp_hdl, pClient->udp_filter, IPPROTO_UDP);
 	if(ret == -1)
 	{
 		IPACMDBG("unable to attach the filter\n");
@@ -593,7 +985,7 @@ void IPACM_ConntrackClient::UpdateUDPFilters(void *param, bool isWan)
 	if(pClient->udp_hdl != NULL)
 	{
 		IPACMDBG("attaching the filter to udp handle\n");
-		ret = nfct_filter_attach(nfct_fd(pClient->udp_hdl), pClient->udp_filter);
+		ret = AttachFilter(pClient->udp_hdl, pClient->udp_filter, IPPROTO_UDP);
 		if(ret == -1)
 		{
 			PERROR("unable to attach the filter to udp handle\n");
@@ -628,8 +1020,8 @@ void IPACM_ConntrackClient::UpdateTCPFilters(void *param, bool isWan)
 
 		if(!isIgnore)
 		{
-			IPA_Conntrack_Filters_Ignore_Bridge_Addrs(pClient->udp_filter);
-			IPA_Conntrack_Filters_Ignore_Local_Addrs(pClient->udp_filter);
+			IPA_Conntrack_Filters_Ignore_Bridge_Addrs(pClient->tcp_filter);
+			IPA_Conntrack_Filters_Ignore_Local_Addrs(pClient->tcp_filter);
 			isIgnore = true;
 		}
 	}
@@ -638,7 +1030,7 @@ void IPACM_ConntrackClient::UpdateTCPFilters(void *param, bool isWan)
 	if(pClient->tcp_hdl != NULL)
 	{
 		IPACMDBG("attaching the filter to tcp handle\n");
-		ret = nfct_filter_attach(nfct_fd(pClient->tcp_hdl), pClient->tcp_filter);
+		ret = AttachFilter(pClient->tcp_hdl, pClient->tcp_filter, IPPROTO_TCP);
 		if(ret == -1)
 		{
 			PERROR("unable to attach the filter to tcp handle\n");
@@ -35,6 +35,8 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_EvtDispatcher.h"
 #include "IPACM_Iface.h"
 #include "IPACM_Wan.h"
+#include "IPACM_EvtStats.h"
+#include "IPACM_V6FlowTable.h"
 
 IPACM_ConntrackListener::IPACM_ConntrackListener()
 {
@@ -45,15 +47,23 @@ IPACM_ConntrackListener::IPACM_ConntrackListener()
 	 WanUp = false;
 	 nat_inst = NatApp::GetInstance();
 
-	 NatIfaceCnt = 0;
 	 StaClntCnt = 0;
-	 pNatIfaces = NULL;
 	 pConfig = IPACM_Config::GetInstance();;
 
+	 sync_entries = NULL;
+	 sync_max = 0;
+	 sync_cnt = 0;
+	 sync_temp = 0;
+
 	 memset(nat_iface_ipv4_addr, 0, sizeof(nat_iface_ipv4_addr));
 	 memset(nonnat_iface_ipv4_addr, 0, sizeof(nonnat_iface_ipv4_addr));
 	 memset(sta_clnt_ipv4_addr, 0, sizeof(sta_clnt_ipv4_addr));
 
+	 if(pConfig != NULL)
+	 {
+		 IPACM_V6FlowTable::Init(pConfig->GetV6FlowMaxFlows());
+	 }
+
 	 IPACM_EvtDispatcher::registr(IPA_HANDLE_WAN_UP, this);
 	 IPACM_EvtDispatcher::registr(IPA_HANDLE_WAN_DOWN, this);
 	 IPACM_EvtDispatcher::registr(IPA_PROCESS_CT_MESSAGE, this);
@@ -79,6 +89,9 @@ void IPACM_ConntrackListener::event_callback(ipa_cm_event_id evt,
 		 return;
 	 }
 
+	 /* NAT tables are also updated from the interface event workers */
+	 IPACM_EvtExecutor::LockShared();
+
 	 switch(evt)
 	 {
 	 case IPA_PROCESS_CT_MESSAGE:
@@ -86,12 +99,10 @@ void IPACM_ConntrackListener::event_callback(ipa_cm_event_id evt,
 			ProcessCTMessage(data);
 			break;
 
-#ifdef CT_OPT
 	 case IPA_PROCESS_CT_MESSAGE_V6:
 			IPACMDBG("Received IPA_PROCESS_CT_MESSAGE_V6 event\n");
 			ProcessCTV6Message(data);
 			break;
-#endif
 
 	 case IPA_HANDLE_WAN_UP:
 			IPACMDBG_H("Received IPA_HANDLE_WAN_UP event\n");
@@ -119,6 +130,8 @@ void IPACM_ConntrackListener::event_callback(ipa_cm_event_id evt,
 							 evt, ((ipacm_event_iface_up *)data)->ifname,
 							 ((ipacm_event_iface_up *)data)->ipv4_addr);
 			CreateConnTrackThreads();
+			/* resolve nat ifaces which may have just been created */
+			IPACM_FlowClassifier::Rebuild();
 			IPACM_ConntrackClient::UpdateUDPFilters(data, false);
 			IPACM_ConntrackClient::UpdateTCPFilters(data, false);
 			break;
@@ -137,13 +150,13 @@ void IPACM_ConntrackListener::event_callback(ipa_cm_event_id evt,
 			IPACMDBG("Ignore cmd %d\n", evt);
 			break;
 	 }
+
+	 IPACM_EvtExecutor::UnlockShared();
 }
 
 int IPACM_ConntrackListener::CheckNatIface(
    ipacm_event_data_all *data, bool *NatIface)
 {
-	int fd = 0, len = 0, cnt, i, j;
-	struct ifreq ifr;
 	*NatIface = false;
 
 	if (data->ipv4_addr == 0 || data->iptype != IPA_IP_v4)
@@ -155,74 +168,22 @@ int IPACM_ConntrackListener::CheckNatIface(
 	IPACMDBG("Received interface index %d with ip type: %d", data->if_index, data->iptype);
 	iptodot(" and ipv4 address", data->ipv4_addr);
 
-	if (pConfig == NULL)
-	{
-		pConfig = IPACM_Config::GetInstance();
-		if (pConfig == NULL)
-		{
-			IPACMERR("Unable to get Config instance\n");
-			return IPACM_FAILURE;
-		}
-	}
-
-	cnt = pConfig->GetNatIfacesCnt();
-	NatIfaceCnt = cnt;
-	IPACMDBG("Total Nat ifaces: %d\n", NatIfaceCnt);
-	if (pNatIfaces != NULL)
-	{
-		free(pNatIfaces);
-		pNatIfaces = NULL;
-	}
-
-	len = (sizeof(NatIfaces) * NatIfaceCnt);
-	pNatIfaces = (NatIfaces *)malloc(len);
-	if (pNatIfaces == NULL)
-	{
-		IPACMERR("Unable to allocate memory for non nat ifaces\n");
-		return IPACM_FAILURE;
-	}
-
-	memset(pNatIfaces, 0, len);
-	if (pConfig->GetNatIfaces(NatIfaceCnt, pNatIfaces) != 0)
-	{
-		IPACMERR("Unable to retrieve non nat ifaces\n");
-		return IPACM_FAILURE;
-	}
-
-	/* Search/Configure linux interface-index and map it to IPA interface-index */
-	if ((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
-	{
-		PERROR("get interface name socket create failed");
-		return IPACM_FAILURE;
-	}
-
-	memset(&ifr, 0, sizeof(struct ifreq));
-	ifr.ifr_ifindex = data->if_index;
-	if (ioctl(fd, SIOCGIFNAME, &ifr) < 0)
+	*NatIface = IPACM_FlowClassifier::IsNatIface(data->if_index);
+	if (*NatIface)
 	{
-		PERROR("call_ioctl_on_dev: ioctl failed:");
-		close(fd);
-		return IPACM_FAILURE;
-	}
-	close(fd);
-
-	for (i = 0; i < NatIfaceCnt; i++)
-	{
-		if (strncmp(ifr.ifr_name,
-					pNatIfaces[i].iface_name,
-					sizeof(pNatIfaces[i].iface_name)) == 0)
-		{
-			IPACMDBG_H("Nat iface (%s), entry (%d), dont cache",
-						pNatIfaces[i].iface_name, j);
-			iptodot("with ipv4 address: ", nat_iface_ipv4_addr[j]);
-			*NatIface = true;
-			return IPACM_SUCCESS;
-		}
+		IPACMDBG_H("Nat iface index (%d), dont cache\n", data->if_index);
 	}
 
 	return IPACM_SUCCESS;
 }
 
+/* Publish the nat and non nat client addresses to the flow classifier */
+void IPACM_ConntrackListener::UpdateClassifierClients(void)
+{
+	IPACM_FlowClassifier::SetClients(nat_iface_ipv4_addr,
+		nonnat_iface_ipv4_addr, MAX_IFACE_ADDRESS);
+}
+
 void IPACM_ConntrackListener::HandleNonNatIPAddr(
    void *inParam, bool AddOp)
 {
@@ -252,6 +213,7 @@ void IPACM_ConntrackListener::HandleNonNatIPAddr(
 					nonnat_iface_ipv4_addr[cnt] = data->ipv4_addr;
 					IPACMDBG("Add ip addr to non nat list (%d) ", cnt);
 					iptodot("with ipv4 address", nonnat_iface_ipv4_addr[cnt]);
+					UpdateClassifierClients();
 
 					/* Add dummy nat rule for non nat ifaces */
 					nat_inst->FlushTempEntries(data->ipv4_addr, true, true);
@@ -270,6 +232,7 @@ void IPACM_ConntrackListener::HandleNonNatIPAddr(
 				IPACMDBG("Reseting ct filters, entry (%d) ", cnt);
 				iptodot("with ipv4 address", nonnat_iface_ipv4_addr[cnt]);
 				nonnat_iface_ipv4_addr[cnt] = 0;
+				UpdateClassifierClients();
 				nat_inst->FlushTempEntries(data->ipv4_addr, false);
 				nat_inst->DelEntriesOnClntDiscon(data->ipv4_addr);
 				return;
@@ -287,6 +250,7 @@ void IPACM_ConntrackListener::HandleNeighIpAddrAddEvt(
 	bool NatIface = false;
 	int j, ret;
 
+	IPACM_EvtExecutor::LockShared();
 	ret = CheckNatIface(data, &NatIface);
 	if (NatIface && ret == IPACM_SUCCESS)
 	{
@@ -301,6 +265,7 @@ void IPACM_ConntrackListener::HandleNeighIpAddrAddEvt(
 			{
 				nat_iface_ipv4_addr[j] = data->ipv4_addr;
 				iptodot("Nating connections of addr: ", nat_iface_ipv4_addr[j]);
+				UpdateClassifierClients();
 				break;
 			}
 		}
@@ -312,6 +277,7 @@ void IPACM_ConntrackListener::HandleNeighIpAddrAddEvt(
 			nat_inst->FlushTempEntries(data->ipv4_addr, true);
 		}
 	}
+	IPACM_EvtExecutor::UnlockShared();
 	return;
 }
 
@@ -327,6 +293,7 @@ void IPACM_ConntrackListener::HandleNeighIpAddrDelEvt(
 	}
 
 	iptodot("HandleNeighIpAddrDelEvt(): Received ip addr", ipv4_addr);
+	IPACM_EvtExecutor::LockShared();
 	for(cnt = 0; cnt<MAX_IFACE_ADDRESS; cnt++)
 	{
 		if (nat_iface_ipv4_addr[cnt] == ipv4_addr)
@@ -334,10 +301,12 @@ void IPACM_ConntrackListener::HandleNeighIpAddrDelEvt(
 			IPACMDBG("Reseting ct nat iface, entry (%d) ", cnt);
 			iptodot("with ipv4 address", nat_iface_ipv4_addr[cnt]);
 			nat_iface_ipv4_addr[cnt] = 0;
+			UpdateClassifierClients();
 			nat_inst->FlushTempEntries(ipv4_addr, false);
 			nat_inst->DelEntriesOnClntDiscon(ipv4_addr);
 		}
 	}
+	IPACM_EvtExecutor::UnlockShared();
 
 	return;
 }
@@ -363,15 +332,140 @@ void IPACM_ConntrackListener::TriggerWANUp(void *in_param)
 	 wan_ipaddr = wanup_data->ipv4_addr;
 	 memcpy(wan_ifname, wanup_data->ifname, sizeof(wan_ifname));
 
+	 /* let connections to and from the wan address through the kernel filter */
+	 IPACM_ConntrackClient::UpdateWanAddr(wan_ipaddr);
+
 	 if(nat_inst != NULL)
 	 {
-		 nat_inst->AddTable(wanup_data->ipv4_addr);
+		 if(nat_inst->AddTable(wanup_data->ipv4_addr) == 0)
+		 {
+			 /* offload connections which existed before wan came up */
+			 SyncConntrackTable();
+		 }
 	 }
 
 	 IPACMDBG("creating nat threads\n");
 	 CreateNatThreads();
 }
 
+/* Dump the kernel conntrack table and bulk insert every connection
+   eligible for NAT offload, later events for them are deduplicated */
+void IPACM_ConntrackListener::SyncConntrackTable(void)
+{
+	struct nfct_handle *hdl;
+	uint32_t family = AF_INET;
+	uint64_t start_usec;
+	int added = 0, ret;
+
+	start_usec = IPACM_EvtStats::now_usec();
+
+	sync_max = pConfig->GetNatMaxEntries();
+	sync_cnt = 0;
+	sync_temp = 0;
+	if(sync_max <= 0)
+	{
+		return;
+	}
+
+	sync_entries = (nat_table_entry *)malloc(sizeof(nat_table_entry) * sync_max);
+	if(sync_entries == NULL)
+	{
+		IPACMERR("unable to allocate memory for %d conntrack entries\n", sync_max);
+		return;
+	}
+
+	hdl = nfct_open(CONNTRACK, 0);
+	if(hdl == NULL)
+	{
+		PERROR("nfct_open");
+		goto end;
+	}
+
+	nfct_callback_register(hdl, NFCT_T_ALL, ConntrackDumpCB, this);
+	ret = nfct_query(hdl, NFCT_Q_DUMP, &family);
+	if(ret == -1)
+	{
+		/* keep whatever was parsed before the failure */
+		IPACMERR("conntrack dump failed (%s)\n", strerror(errno));
+	}
+	nfct_callback_unregister(hdl);
+	nfct_close(hdl);
+
+	if(sync_cnt > 0)
+	{
+		added = nat_inst->AddEntries(sync_entries, sync_cnt);
+		if(added < 0)
+		{
+			IPACMERR("unable to add %d conntrack entries\n", sync_cnt);
+			added = 0;
+		}
+	}
+
+	/* the dump saw every live connection, checkpointed entries it did not
+	   report were closed while ipacm was down */
+	if(ret != -1)
+	{
+		nat_inst->DelStaleAdoptedEntries();
+	}
+
+end:
+	IPACMDBG_H("Imported %d of %d conntrack entries, %d wait for their client, in %llu usec\n",
+		added, sync_cnt, sync_temp, (unsigned long long)(IPACM_EvtStats::now_usec() - start_usec));
+	free(sync_entries);
+	sync_entries = NULL;
+	return;
+}
+
+int IPACM_ConntrackListener::ConntrackDumpCB(enum nf_conntrack_msg_type type,
+	struct nf_conntrack *ct, void *data)
+{
+	IPACMDBG("Dump callback called with msgtype: %d\n", type);
+	((IPACM_ConntrackListener *)data)->ImportCTEntry(ct);
+	return NFCT_CB_CONTINUE;
+}
+
+void IPACM_ConntrackListener::ImportCTEntry(struct nf_conntrack *ct)
+{
+	nat_table_entry rule;
+	bool isTempEntry = false;
+	u_int8_t l4proto;
+
+	l4proto = nfct_get_attr_u8(ct, ATTR_ORIG_L4PROTO);
+	if(IPPROTO_UDP != l4proto && IPPROTO_TCP != l4proto)
+	{
+		return;
+	}
+
+	/* same as the event path: only established tcp connections are offloaded,
+	   an existing udp connection is treated as a new one */
+	if(IPPROTO_TCP == l4proto &&
+		 nfct_get_attr_u8(ct, ATTR_TCP_STATE) != TCP_CONNTRACK_ESTABLISHED)
+	{
+		return;
+	}
+
+	if(!BuildNatEntry(ct, NFCT_T_NEW, &rule, &isTempEntry))
+	{
+		return;
+	}
+
+	if(isTempEntry)
+	{
+		nat_inst->AddTempEntry(&rule);
+		sync_temp++;
+		return;
+	}
+
+	if(sync_cnt >= sync_max)
+	{
+		IPACMDBG("Conntrack dump has more than %d entries, ignore\n", sync_max);
+		return;
+	}
+	memcpy(&sync_entries[sync_cnt], &rule, sizeof(rule));
+	sync_cnt++;
+	return;
+}
+
 int IPACM_ConntrackListener::CreateConnTrackThreads(void)
 {
 	int ret;
@@ -461,6 +555,7 @@ void IPACM_ConntrackListener::TriggerWANDown(uint32_t wan_addr)
 		    ((wan_addr>>8) & 0xFF), (wan_addr & 0xFF));
 	 
 	 WanUp = false;
+	 IPACM_ConntrackClient::UpdateWanAddr(0);
 
 	 if(nat_inst != NULL)
 	 {
@@ -565,8 +660,75 @@ void ParseCTV6Message(struct nf_conntrack *ct)
 	 return;
 }
 
-#ifdef CT_OPT
+/* Account the event in the IPv6 flow table */
+void IPACM_ConntrackListener::TrackV6Flow(struct nf_conntrack *ct, enum nf_conntrack_msg_type type)
+{
+	struct nfct_attr_grp_ipv6 orig_params;
+	ipacm_v6flow_key key;
+	ipacm_v6flow_evt evt;
+	int cnt;
+
+	if(!IPACM_V6FlowTable::IsEnabled())
+	{
+		return;
+	}
+
+	memset(&key, 0, sizeof(key));
+	key.proto = nfct_get_attr_u8(ct, ATTR_ORIG_L4PROTO);
+	if(key.proto != IPPROTO_TCP && key.proto != IPPROTO_UDP)
+	{
+		return;
+	}
+
+	if(nfct_get_attr_grp(ct, ATTR_GRP_ORIG_IPV6, (void *)&orig_params) < 0)
+	{
+		IPACMDBG("no ipv6 tuple in conntrack message\n");
+		return;
+	}
+	for(cnt = 0; cnt < 4; cnt++)
+	{
+		key.src[cnt] = ntohl(orig_params.src[cnt]);
+		key.dst[cnt] = ntohl(orig_params.dst[cnt]);
+	}
+	key.sport = ntohs(nfct_get_attr_u16(ct, ATTR_ORIG_PORT_SRC));
+	key.dport = ntohs(nfct_get_attr_u16(ct, ATTR_ORIG_PORT_DST));
+
+	switch(type)
+	{
+	case NFCT_T_NEW:
+		evt = IPACM_V6FLOW_EVT_NEW;
+		break;
+	case NFCT_T_DESTROY:
+		evt = IPACM_V6FLOW_EVT_DESTROY;
+		break;
+	default:
+		evt = IPACM_V6FLOW_EVT_UPDATE;
+		break;
+	}
+
+	IPACM_V6FlowTable::Track(&key, evt);
+	return;
+}
+
 void IPACM_ConntrackListener::ProcessCTV6Message(void *param)
+{
+	ipacm_ct_evt_data *evt_data = (ipacm_ct_evt_data *)param;
+
+	TrackV6Flow(evt_data->ct, evt_data->type);
+
+#ifdef CT_OPT
+	HandleLan2LanV6(param);
+#else
+	/* ipv6 connections are only tracked, no rule is changed */
+	IPACM_EvtStats::record_ct_ignored(nfct_get_attr_u8(evt_data->ct, ATTR_ORIG_L4PROTO));
+	/* Cleanup item that was allocated during the original CT callback */
+	nfct_destroy(evt_data->ct);
+#endif
+	return;
+}
+
+#ifdef CT_OPT
+void IPACM_ConntrackListener::HandleLan2LanV6(void *param)
 {
 	ipacm_ct_evt_data *evt_data = (ipacm_ct_evt_data *)param;
 	u_int8_t l4proto = 0;
@@ -645,8 +807,17 @@ void IPACM_ConntrackListener::ProcessCTV6Message(void *param)
 	{
 			p_lan2lan->handle_del_connection(&lan2lan_conn);
 	}
+	else
+	{
+		IPACM_EvtStats::record_ct_ignored(l4proto);
+	}
+
+	/* Cleanup item that was allocated during the original CT callback */
+	nfct_destroy(ct);
+	return;
 
 IGNORE:
+	IPACM_EvtStats::record_ct_ignored(nfct_get_attr_u8(ct, ATTR_ORIG_L4PROTO));
 	/* Cleanup item that was allocated during the original CT callback */
 	nfct_destroy(ct);
 	return;
@@ -675,6 +846,7 @@ void IPACM_ConntrackListener::ProcessCTMessage(void *param)
 	 if(IPPROTO_UDP != l4proto && IPPROTO_TCP != l4proto)
 	 {
 			IPACMDBG("Received unexpected protocl %d conntrack message\n", l4proto);
+			IPACM_EvtStats::record_ct_ignored(l4proto);
 	 }
 	 else
 	 {
@@ -689,8 +861,6 @@ void IPACM_ConntrackListener::ProcessCTMessage(void *param)
 bool IPACM_ConntrackListener::AddIface(
    nat_table_entry *rule, bool *isTempEntry)
 {
-	int cnt;
-
 	*isTempEntry = false;
 
 	/* Special handling for Passthrough IP. */
@@ -704,77 +874,41 @@ bool IPACM_ConntrackListener::AddIface(
 		}
 	}
 
-	/* check whether nat iface or not */
-	for (cnt = 0; cnt < MAX_IFACE_ADDRESS; cnt++)
+	/* in STA mode, don't compare against non nat ifaces */
+	switch (IPACM_FlowClassifier::ClassifyFlow(rule->private_ip, rule->target_ip, isStaMode))
 	{
-		if (nat_iface_ipv4_addr[cnt] != 0)
-		{
-			if (rule->private_ip == nat_iface_ipv4_addr[cnt] ||
-				rule->target_ip == nat_iface_ipv4_addr[cnt])
-			{
-				IPACMDBG("matched nat_iface_ipv4_addr entry(%d)\n", cnt);
-				iptodot("AddIface(): Nat entry match with ip addr",
-						nat_iface_ipv4_addr[cnt]);
-				return true;
-			}
-		}
-	}
-
-	if (!isStaMode)
-	{
-		/* check whether non nat iface or not, on Non Nat iface
-		   add dummy rule by copying public ip to private ip */
-		for (cnt = 0; cnt < MAX_IFACE_ADDRESS; cnt++)
-		{
-			if (nonnat_iface_ipv4_addr[cnt] != 0)
-			{
-				if (rule->private_ip == nonnat_iface_ipv4_addr[cnt] ||
-					rule->target_ip == nonnat_iface_ipv4_addr[cnt])
-				{
-					IPACMDBG("matched non_nat_iface_ipv4_addr entry(%d)\n", cnt);
-					iptodot("AddIface(): Non Nat entry match with ip addr",
-							nonnat_iface_ipv4_addr[cnt]);
-
-					rule->private_ip = rule->public_ip;
-					rule->private_port = rule->public_port;
-					return true;
-				}
-			}
-		}
-		IPACMDBG_H("Not mtaching with non-nat ifaces\n");
-	}
-	else
-		IPACMDBG("In STA mode, don't compare against non nat ifaces\n");
+	case IPACM_FLOW_NAT_CLIENT:
+		IPACMDBG("matched nat_iface_ipv4_addr entry\n");
+		return true;
 
-	if(pConfig == NULL)
-	{
-		pConfig = IPACM_Config::GetInstance();
-		if(pConfig == NULL)
-		{
-			IPACMERR("Unable to get Config instance\n");
-			return false;
-		}
-	}
+	case IPACM_FLOW_NONNAT_CLIENT:
+		/* on Non Nat iface add dummy rule by copying public ip to private ip */
+		IPACMDBG("matched non_nat_iface_ipv4_addr entry\n");
+		rule->private_ip = rule->public_ip;
+		rule->private_port = rule->public_port;
+		return true;
 
-	if (pConfig->isPrivateSubnet(rule->private_ip) ||
-		pConfig->isPrivateSubnet(rule->target_ip))
-	{
+	case IPACM_FLOW_PRIVATE_SUBNET:
 		IPACMDBG("Matching with Private subnet\n");
 		*isTempEntry = true;
 		return true;
+
+	default:
+		break;
 	}
 
 	return false;
 }
 
-void IPACM_ConntrackListener::AddORDeleteNatEntry(const nat_entry_bundle *input)
+/* returns false if the event did not add or delete any entry */
+bool IPACM_ConntrackListener::AddORDeleteNatEntry(const nat_entry_bundle *input)
 {
 	u_int8_t tcp_state;
 
 	if (nat_inst == NULL)
 	{
 		IPACMERR("Nat instance is NULL, unable to add or delete\n");
-		return;
+		return false;
 	}
 
 	IPACMDBG_H("Below Nat Entry will either be added or deleted\n");
@@ -824,6 +958,7 @@ void IPACM_ConntrackListener::AddORDeleteNatEntry(const nat_entry_bundle *input)
 		{
 			IPACMDBG("Ignore tcp state: %d and type: %d\n",
 					 tcp_state, input->type);
+			return false;
 		}
 
 	}
@@ -852,9 +987,13 @@ void IPACM_ConntrackListener::AddORDeleteNatEntry(const nat_entry_bundle *input)
 			nat_inst->DeleteEntry(input->rule);
 			nat_inst->DeleteTempEntry(input->rule);
 		}
+		else
+		{
+			return false;
+		}
 	}
 
-	return;
+	return true;
 }
 
 void IPACM_ConntrackListener::PopulateTCPorUDPEntry(
@@ -1025,17 +1164,42 @@ void IPACM_ConntrackListener::ProcessTCPorUDPMsg(
 	 u_int8_t l4proto)
 {
 	 nat_table_entry rule;
-	 uint32_t status = 0;
-	 uint32_t orig_src_ip, orig_dst_ip;
-	 bool isAdd = false;
-
 	 nat_entry_bundle nat_entry;
+
 	 nat_entry.isTempEntry = false;
 	 nat_entry.ct = ct;
 	 nat_entry.type = type;
 
- 	 memset(&rule, 0, sizeof(rule));
 	 IPACMDBG("Received type:%d with proto:%d\n", type, l4proto);
+	 if(!BuildNatEntry(ct, type, &rule, &nat_entry.isTempEntry))
+	 {
+		 IPACM_EvtStats::record_ct_ignored(l4proto);
+		 return;
+	 }
+
+	 nat_entry.rule = &rule;
+	 if(!AddORDeleteNatEntry(&nat_entry))
+	 {
+		 IPACM_EvtStats::record_ct_ignored(l4proto);
+	 }
+	 return;
+}
+
+/* Fill the nat entry of a connection, returns false if the connection
+   is not to be offloaded. Shared by conntrack events and the dump on wan up */
+bool IPACM_ConntrackListener::BuildNatEntry(
+	 struct nf_conntrack *ct,
+	 enum nf_conntrack_msg_type type,
+	 nat_table_entry *out,
+	 bool *isTempEntry)
+{
+	 nat_table_entry &rule = *out;
+	 uint32_t status = 0;
+	 uint32_t orig_src_ip, orig_dst_ip;
+	 bool isAdd = false;
+
+	 *isTempEntry = false;
+ 	 memset(&rule, 0, sizeof(rule));
 	 status = nfct_get_attr_u32(ct, ATTR_STATUS);
 
 	 /* Retrieve Protocol */
@@ -1057,7 +1221,7 @@ void IPACM_ConntrackListener::ProcessTCPorUDPMsg(
 		 if(orig_src_ip == 0)
 		 {
 			 IPACMERR("unable to retrieve orig src ip address\n");
-			 return;
+			 return false;
 		 }
 
 		 orig_dst_ip = nfct_get_attr_u32(ct, ATTR_ORIG_IPV4_DST);
@@ -1065,7 +1229,7 @@ void IPACM_ConntrackListener::ProcessTCPorUDPMsg(
 		 if(orig_dst_ip == 0)
 		 {
 			 IPACMERR("unable to retrieve orig dst ip address\n");
-			 return;
+			 return false;
 		 }
 
 		if(orig_src_ip == wan_ipaddr)
@@ -1086,7 +1250,7 @@ void IPACM_ConntrackListener::ProcessTCPorUDPMsg(
 #ifdef CT_OPT
 			HandleLan2Lan(ct, type, &rule);
 #endif
-			return;
+			return false;
 		}
 	 }
 
@@ -1103,7 +1267,7 @@ void IPACM_ConntrackListener::ProcessTCPorUDPMsg(
 
 	 if (rule.private_ip != wan_ipaddr)
 	 {
-		 isAdd = AddIface(&rule, &nat_entry.isTempEntry);
+		 isAdd = AddIface(&rule, isTempEntry);
 		 if (!isAdd)
 		 {
 			 goto IGNORE;
@@ -1123,10 +1287,8 @@ void IPACM_ConntrackListener::ProcessTCPorUDPMsg(
 		 rule.private_port = rule.public_port;
 	 }
 
-	 CheckSTAClient(&rule, &nat_entry.isTempEntry);
-	 nat_entry.rule = &rule;
-	 AddORDeleteNatEntry(&nat_entry);
-	 return;
+	 CheckSTAClient(&rule, isTempEntry);
+	 return true;
 
 IGNORE:
 	IPACMDBG_H("ignoring below Nat Entry\n");
@@ -1136,7 +1298,7 @@ IGNORE:
 	IPACMDBG("private port or src port: 0x%x, Decimal:%d\n", rule.private_port, rule.private_port);
 	IPACMDBG("public port or reply dst port: 0x%x, Decimal:%d\n", rule.public_port, rule.public_port);
 	IPACMDBG("Protocol: %d, destination nat flag: %d\n", rule.protocol, rule.dst_nat);
-	return;
+	return false;
 }
 
 void IPACM_ConntrackListener::HandleSTAClientAddEvt(uint32_t clnt_ip_addr)
@@ -1144,9 +1306,11 @@ void IPACM_ConntrackListener::HandleSTAClientAddEvt(uint32_t clnt_ip_addr)
 	 int cnt;
 	 IPACMDBG_H("Received STA client 0x%x\n", clnt_ip_addr);
 
+	 IPACM_EvtExecutor::LockShared();
 	 if(StaClntCnt >= MAX_STA_CLNT_IFACES)
 	 {
 		IPACMDBG("Max STA client reached, ignore 0x%x\n", clnt_ip_addr);
+		IPACM_EvtExecutor::UnlockShared();
 		return;
 	 }
 
@@ -1172,6 +1336,7 @@ void IPACM_ConntrackListener::HandleSTAClientAddEvt(uint32_t clnt_ip_addr)
 	 }
 
 	 nat_inst->FlushTempEntries(clnt_ip_addr, true);
+	 IPACM_EvtExecutor::UnlockShared();
 	 return;
 }
 
@@ -1180,6 +1345,7 @@ void IPACM_ConntrackListener::HandleSTAClientDelEvt(uint32_t clnt_ip_addr)
 	 int cnt;
 	 IPACMDBG_H("Received STA client 0x%x\n", clnt_ip_addr);
 
+	 IPACM_EvtExecutor::LockShared();
 	 for(cnt=0; cnt<MAX_STA_CLNT_IFACES; cnt++)
 	 {
 		if(sta_clnt_ipv4_addr[cnt] != 0 &&
@@ -1196,5 +1362,6 @@ void IPACM_ConntrackListener::HandleSTAClientDelEvt(uint32_t clnt_ip_addr)
 	 }
 
 	 nat_inst->FlushTempEntries(clnt_ip_addr, false);
+	 IPACM_EvtExecutor::UnlockShared();
    return;
 }
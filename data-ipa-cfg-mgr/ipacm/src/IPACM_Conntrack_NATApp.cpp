@@ -26,10 +26,300 @@ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
 OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
 IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "IPACM_Conntrack_NATApp.h"
 #include "IPACM_ConntrackClient.h"
+#include "IPACM_EvtStats.h"
+#include "IPACM_Startup.h"
 
 #define INVALID_IP_ADDR 0x0
+#define PENDING_INVALID_NODE -1
+
+/* NatPendingQueue class Implementation */
+NatPendingQueue::NatPendingQueue()
+{
+	nodes = NULL;
+	tuple_head = NULL;
+	priv_head = NULL;
+	trgt_head = NULL;
+	age_head = PENDING_INVALID_NODE;
+	age_tail = PENDING_INVALID_NODE;
+	free_head = PENDING_INVALID_NODE;
+
+	capacity = 0;
+	count = 0;
+	bucket_mask = 0;
+	evictions = 0;
+}
+
+NatPendingQueue::~NatPendingQueue()
+{
+	free(nodes);
+	free(tuple_head);
+	free(priv_head);
+	free(trgt_head);
+}
+
+int NatPendingQueue::Init(int max_entries)
+{
+	int cnt;
+	uint32_t buckets = 1;
+
+	if(max_entries <= 0)
+	{
+		IPACMERR("Invalid pending queue size %d\n", max_entries);
+		return -1;
+	}
+
+	/* keep the hash tables at most half loaded */
+	while(buckets < (uint32_t)(2 * max_entries))
+	{
+		buckets <<= 1;
+	}
+
+	nodes = (pending_node *)calloc(max_entries, sizeof(pending_node));
+	tuple_head = (int *)malloc(buckets * sizeof(int));
+	priv_head = (int *)malloc(buckets * sizeof(int));
+	trgt_head = (int *)malloc(buckets * sizeof(int));
+	if(nodes == NULL || tuple_head == NULL ||
+		 priv_head == NULL || trgt_head == NULL)
+	{
+		IPACMERR("Unable to allocate memory for pending queue\n");
+		free(nodes);
+		free(tuple_head);
+		free(priv_head);
+		free(trgt_head);
+		nodes = NULL;
+		tuple_head = priv_head = trgt_head = NULL;
+		return -1;
+	}
+
+	for(cnt = 0; cnt < (int)buckets; cnt++)
+	{
+		tuple_head[cnt] = PENDING_INVALID_NODE;
+		priv_head[cnt] = PENDING_INVALID_NODE;
+		trgt_head[cnt] = PENDING_INVALID_NODE;
+	}
+
+	/* chain all nodes into the free list through the age link */
+	for(cnt = 0; cnt < max_entries; cnt++)
+	{
+		nodes[cnt].link[LINK_AGE].next = (cnt + 1 < max_entries) ? cnt + 1 : PENDING_INVALID_NODE;
+	}
+	free_head = 0;
+
+	capacity = max_entries;
+	bucket_mask = buckets - 1;
+	IPACMDBG("Allocated pending queue with %d entries and %d buckets\n", capacity, buckets);
+	return 0;
+}
+
+uint32_t NatPendingQueue::HashIp(uint32_t ip_addr)
+{
+	ip_addr ^= ip_addr >> 16;
+	ip_addr *= 0x45d9f3b;
+	ip_addr ^= ip_addr >> 16;
+	return ip_addr;
+}
+
+uint32_t NatPendingQueue::HashTuple(const nat_table_entry *rule)
+{
+	uint32_t ports = ((uint32_t)rule->private_port << 16) | rule->target_port;
+
+	return HashIp(rule->private_ip ^ HashIp(rule->target_ip ^ HashIp(ports ^ rule->protocol)));
+}
+
+bool NatPendingQueue::isSameTuple(const nat_table_entry *a, const nat_table_entry *b)
+{
+	return (a->private_ip == b->private_ip &&
+					a->target_ip == b->target_ip &&
+					a->private_port == b->private_port &&
+					a->target_port == b->target_port &&
+					a->protocol == b->protocol);
+}
+
+int NatPendingQueue::Find(const nat_table_entry *rule)
+{
+	int cnt;
+
+	if(nodes == NULL)
+	{
+		return PENDING_INVALID_NODE;
+	}
+
+	cnt = tuple_head[HashTuple(rule) & bucket_mask];
+	while(cnt != PENDING_INVALID_NODE)
+	{
+		if(isSameTuple(&nodes[cnt].rule, rule))
+		{
+			return cnt;
+		}
+		cnt = nodes[cnt].link[LINK_TUPLE].next;
+	}
+
+	return PENDING_INVALID_NODE;
+}
+
+/* insert node at the head of the chain */
+void NatPendingQueue::Link(int *head, int type, int node)
+{
+	nodes[node].link[type].prev = PENDING_INVALID_NODE;
+	nodes[node].link[type].next = *head;
+	if(*head != PENDING_INVALID_NODE)
+	{
+		nodes[*head].link[type].prev = node;
+	}
+	*head = node;
+}
+
+void NatPendingQueue::Unlink(int *head, int type, int node)
+{
+	int prev = nodes[node].link[type].prev;
+	int next = nodes[node].link[type].next;
+
+	if(prev != PENDING_INVALID_NODE)
+	{
+		nodes[prev].link[type].next = next;
+	}
+	else
+	{
+		*head = next;
+	}
+
+	if(next != PENDING_INVALID_NODE)
+	{
+		nodes[next].link[type].prev = prev;
+	}
+}
+
+void NatPendingQueue::Remove(int node)
+{
+	nat_table_entry *rule = &nodes[node].rule;
+
+	/* age list keeps a tail pointer */
+	if(nodes[node].link[LINK_AGE].next == PENDING_INVALID_NODE)
+	{
+		age_tail = nodes[node].link[LINK_AGE].prev;
+	}
+	Unlink(&age_head, LINK_AGE, node);
+
+	Unlink(&tuple_head[HashTuple(rule) & bucket_mask], LINK_TUPLE, node);
+	Unlink(&priv_head[HashIp(rule->private_ip) & bucket_mask], LINK_PRIV, node);
+	if(rule->target_ip != rule->private_ip)
+	{
+		Unlink(&trgt_head[HashIp(rule->target_ip) & bucket_mask], LINK_TRGT, node);
+	}
+
+	memset(rule, 0, sizeof(nat_table_entry));
+	nodes[node].link[LINK_AGE].next = free_head;
+	free_head = node;
+	count--;
+}
+
+/* Returns false on duplicate entry, evicted is set when the
+   oldest entry had to be dropped to make room */
+bool NatPendingQueue::Add(const nat_table_entry *rule, bool *evicted, int retries)
+{
+	int node;
+
+	*evicted = false;
+	if(nodes == NULL || Find(rule) != PENDING_INVALID_NODE)
+	{
+		return false;
+	}
+
+	if(free_head == PENDING_INVALID_NODE)
+	{
+		Remove(age_head);
+		evictions++;
+		*evicted = true;
+	}
+
+	node = free_head;
+	free_head = nodes[node].link[LINK_AGE].next;
+	memcpy(&nodes[node].rule, rule, sizeof(nat_table_entry));
+	nodes[node].retries = retries;
+
+	/* append to the tail of the age list */
+	nodes[node].link[LINK_AGE].prev = age_tail;
+	nodes[node].link[LINK_AGE].next = PENDING_INVALID_NODE;
+	if(age_tail != PENDING_INVALID_NODE)
+	{
+		nodes[age_tail].link[LINK_AGE].next = node;
+	}
+	else
+	{
+		age_head = node;
+	}
+	age_tail = node;
+
+	Link(&tuple_head[HashTuple(rule) & bucket_mask], LINK_TUPLE, node);
+	Link(&priv_head[HashIp(rule->private_ip) & bucket_mask], LINK_PRIV, node);
+	if(rule->target_ip != rule->private_ip)
+	{
+		Link(&trgt_head[HashIp(rule->target_ip) & bucket_mask], LINK_TRGT, node);
+	}
+
+	count++;
+	return true;
+}
+
+bool NatPendingQueue::Delete(const nat_table_entry *rule)
+{
+	int node = Find(rule);
+
+	if(node == PENDING_INVALID_NODE)
+	{
+		return false;
+	}
+
+	Remove(node);
+	return true;
+}
+
+/* Move every entry of the given client into out[] and its failed
+   attempts into retries[], returns the number of entries moved */
+int NatPendingQueue::Flush(uint32_t ip_addr, nat_table_entry *out, int *retries, int max)
+{
+	int node, next, num = 0;
+
+	if(nodes == NULL)
+	{
+		return 0;
+	}
+
+	node = priv_head[HashIp(ip_addr) & bucket_mask];
+	while(node != PENDING_INVALID_NODE && num < max)
+	{
+		next = nodes[node].link[LINK_PRIV].next;
+		if(nodes[node].rule.private_ip == ip_addr)
+		{
+			retries[num] = nodes[node].retries;
+			memcpy(&out[num++], &nodes[node].rule, sizeof(nat_table_entry));
+			Remove(node);
+		}
+		node = next;
+	}
+
+	/* entries matched on private ip are already gone */
+	node = trgt_head[HashIp(ip_addr) & bucket_mask];
+	while(node != PENDING_INVALID_NODE && num < max)
+	{
+		next = nodes[node].link[LINK_TRGT].next;
+		if(nodes[node].rule.target_ip == ip_addr)
+		{
+			retries[num] = nodes[node].retries;
+			memcpy(&out[num++], &nodes[node].rule, sizeof(nat_table_entry));
+			Remove(node);
+		}
+		node = next;
+	}
+
+	return num;
+}
 
 /* NatApp class Implementation */
 NatApp *NatApp::pInstance = NULL;
@@ -37,25 +327,32 @@ NatApp::NatApp()
 {
 	max_entries = 0;
 	cache = NULL;
+	cache_hdr = NULL;
+	cache_map_size = 0;
+	adopt_usec = 0;
 
 	nat_table_hdl = 0;
 	pub_ip_addr = 0;
+	pub_ip_addr_pre = 0;
 
 	curCnt = 0;
 
-	pALGPorts = NULL;
-	nALGPort = 0;
-
 	ct = NULL;
 	ct_hdl = NULL;
 
-	memset(temp, 0, sizeof(temp));
+	flush_entries = NULL;
+	flush_pending = NULL;
+	flush_retries = NULL;
+	flush_rules = NULL;
+	flush_hdls = NULL;
+	flush_slots = NULL;
 }
 
 int NatApp::Init(void)
 {
 	IPACM_Config *pConfig;
 	int size = 0;
+	int pending_entries = 0;
 
 	pConfig = IPACM_Config::GetInstance();
 	if(pConfig == NULL)
@@ -66,46 +363,168 @@ int NatApp::Init(void)
 
 	max_entries = pConfig->GetNatMaxEntries();
 
-	size = (sizeof(nat_table_entry) * max_entries);
-	cache = (nat_table_entry *)malloc(size);
-	if(cache == NULL)
+	if(MapCache() < 0)
+	{
+		/* run without checkpoint */
+		size = (sizeof(nat_table_entry) * max_entries);
+		cache = (nat_table_entry *)malloc(size);
+		if(cache == NULL)
+		{
+			IPACMERR("Unable to allocate memory for cache\n");
+			goto fail;
+		}
+		IPACMDBG("Allocated %d bytes for config manager nat cache\n", size);
+		memset(cache, 0, size);
+	}
+
+	pending_entries = pConfig->GetNatPendingMaxEntries();
+	if(pending_entries <= 0)
+	{
+		pending_entries = NAT_PENDING_DEFAULT_ENTRIES;
+	}
+
+	if(temp.Init(pending_entries) != 0)
 	{
-		IPACMERR("Unable to allocate memory for cache\n");
+		IPACMERR("Unable to allocate pending nat queue\n");
 		goto fail;
 	}
-	IPACMDBG("Allocated %d bytes for config manager nat cache\n", size);
-	memset(cache, 0, size);
 
-	nALGPort = pConfig->GetAlgPortCnt();
-	if(nALGPort > 0)
+	flush_entries = (nat_table_entry *)malloc(sizeof(nat_table_entry) * pending_entries);
+	flush_pending = (nat_table_entry *)malloc(sizeof(nat_table_entry) * pending_entries);
+	flush_retries = (int *)malloc(sizeof(int) * pending_entries);
+	flush_rules = (ipa_nat_ipv4_rule *)malloc(sizeof(ipa_nat_ipv4_rule) * pending_entries);
+	flush_hdls = (uint32_t *)malloc(sizeof(uint32_t) * pending_entries);
+	flush_slots = (int *)malloc(sizeof(int) * pending_entries);
+	if(flush_entries == NULL || flush_pending == NULL ||
+		 flush_retries == NULL || flush_rules == NULL ||
+		 flush_hdls == NULL || flush_slots == NULL)
 	{
-		pALGPorts = (ipacm_alg *)malloc(sizeof(ipacm_alg) * nALGPort);
-		if(pALGPorts == NULL)
-		{
-			IPACMERR("Unable to allocate memory for alg prots\n");
-			goto fail;
-		}
-		memset(pALGPorts, 0, sizeof(ipacm_alg) * nALGPort);
+		IPACMERR("Unable to allocate memory for pending flush\n");
+		goto fail;
+	}
+	IPACMDBG("Pending nat queue holds %d entries\n", pending_entries);
+
+	return 0;
+
+fail:
+	if(cache_hdr != NULL)
+	{
+		munmap(cache_hdr, cache_map_size);
+		cache_hdr = NULL;
+	}
+	else
+	{
+		free(cache);
+	}
+	cache = NULL;
+	free(flush_entries);
+	free(flush_pending);
+	free(flush_retries);
+	free(flush_rules);
+	free(flush_hdls);
+	free(flush_slots);
+	return -1;
+}
+
+/* Map the cache from IPACM_NAT_CACHE_FILE so that every cache update is
+   checkpointed as it happens. Entries left by a previous run are adopted
+   disabled, their rule handles belong to a nat table which no longer
+   exists. Returns the number of adopted entries, -1 if not mapped */
+int NatApp::MapCache(void)
+{
+	struct stat st;
+	void *map;
+	int fd, cnt, adopted = 0;
+	bool valid;
+	uint64_t start_usec;
+
+	start_usec = IPACM_EvtStats::now_usec();
+	cache_map_size = sizeof(nat_cache_hdr) + sizeof(nat_table_entry) * max_entries;
+
+	fd = open(IPACM_NAT_CACHE_FILE, O_RDWR | O_CREAT, 0600);
+	if(fd < 0)
+	{
+		IPACMERR("unable to open %s (%s)\n", IPACM_NAT_CACHE_FILE, strerror(errno));
+		return -1;
+	}
+
+	valid = (fstat(fd, &st) == 0 && st.st_size == (off_t)cache_map_size);
+	if(!valid && ftruncate(fd, cache_map_size) != 0)
+	{
+		IPACMERR("unable to resize %s (%s)\n", IPACM_NAT_CACHE_FILE, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	map = mmap(NULL, cache_map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+	{
+		IPACMERR("unable to map %s (%s)\n", IPACM_NAT_CACHE_FILE, strerror(errno));
+		return -1;
+	}
+
+	cache_hdr = (nat_cache_hdr *)map;
+	cache = (nat_table_entry *)(cache_hdr + 1);
+
+	if(valid)
+	{
+		valid = (cache_hdr->magic == NAT_CACHE_MAGIC &&
+						 cache_hdr->version == NAT_CACHE_VERSION &&
+						 cache_hdr->max_entries == (uint32_t)max_entries &&
+						 cache_hdr->entry_size == sizeof(nat_table_entry));
+	}
+
+	if(!valid)
+	{
+		IPACMDBG_H("No usable nat checkpoint, start with an empty cache\n");
+		memset(map, 0, cache_map_size);
+		cache_hdr->magic = NAT_CACHE_MAGIC;
+		cache_hdr->version = NAT_CACHE_VERSION;
+		cache_hdr->max_entries = max_entries;
+		cache_hdr->entry_size = sizeof(nat_table_entry);
+		return 0;
+	}
 
-		if(pConfig->GetAlgPorts(nALGPort, pALGPorts) != 0)
+	for(cnt = 0; cnt < max_entries; cnt++)
+	{
+		if(cache[cnt].private_ip == 0 &&
+			 cache[cnt].target_ip == 0 &&
+			 cache[cnt].private_port == 0  &&
+			 cache[cnt].target_port == 0 &&
+			 cache[cnt].protocol == 0)
 		{
-			IPACMERR("Unable to retrieve ALG prots\n");
-			goto fail;
+			continue;
 		}
 
-		IPACMDBG("Printing %d alg ports information\n", nALGPort);
-		for(int cnt=0; cnt<nALGPort; cnt++)
+		/* drop entries which were half written when ipacm went down */
+		if(cache[cnt].private_ip == 0 ||
+			 cache[cnt].target_ip == 0 ||
+			 cache[cnt].private_port == 0  ||
+			 cache[cnt].target_port == 0 ||
+			 (cache[cnt].protocol != IPPROTO_TCP && cache[cnt].protocol != IPPROTO_UDP))
 		{
-			IPACMDBG("%d: Proto[%d], port[%d]\n", cnt, pALGPorts[cnt].protocol, pALGPorts[cnt].port);
+			memset(&cache[cnt], 0, sizeof(cache[cnt]));
+			continue;
 		}
+
+		cache[cnt].enabled = false;
+		cache[cnt].rule_hdl = 0;
+		cache[cnt].timestamp = 0;
+		cache[cnt].adopted = true;
+		adopted++;
 	}
 
-	return 0;
+	curCnt = adopted;
+	pub_ip_addr_pre = cache_hdr->pub_ip_addr;
+	if(adopted > 0)
+	{
+		adopt_usec = start_usec;
+	}
 
-fail:
-	free(cache);
-	free(pALGPorts);
-	return -1;
+	IPACMDBG_H("Adopted %d nat entries of public ip 0x%x from checkpoint in %llu usec\n", adopted,
+		pub_ip_addr_pre, (unsigned long long)(IPACM_EvtStats::now_usec() - start_usec));
+	return adopted;
 }
 
 NatApp* NatApp::GetInstance()
@@ -129,8 +548,6 @@ NatApp* NatApp::GetInstance()
 int NatApp::AddTable(uint32_t pub_ip)
 {
 	int ret;
-	int cnt = 0;
-	ipa_nat_ipv4_rule nat_rule;
 	IPACMDBG_H("%s() %d\n", __FUNCTION__, __LINE__);
 
 	/* Not reset the cache wait it timeout by destroy event */
@@ -153,39 +570,104 @@ int NatApp::AddTable(uint32_t pub_ip)
 	if (pub_ip == pub_ip_addr_pre)
 	{
 		IPACMDBG("Restore the cache to ipa NAT-table\n");
-		for(cnt = 0; cnt < max_entries; cnt++)
+		RestoreCache();
+	}
+
+	if(cache_hdr != NULL)
+	{
+		cache_hdr->pub_ip_addr = pub_ip;
+	}
+	pub_ip_addr = pub_ip;
+	return 0;
+}
+
+/* Add back all cached entries to a new nat table, in batches */
+void NatApp::RestoreCache(void)
+{
+	int cnt, nrules = 0, total = 0, added = 0;
+	uint64_t start_usec;
+
+	start_usec = IPACM_EvtStats::now_usec();
+
+	for(cnt = 0; cnt < max_entries; cnt++)
+	{
+		if(cache[cnt].private_ip == 0)
 		{
-			if(cache[cnt].private_ip !=0)
-			{
-				memset(&nat_rule, 0 , sizeof(nat_rule));
-				nat_rule.private_ip = cache[cnt].private_ip;
-				nat_rule.target_ip = cache[cnt].target_ip;
-				nat_rule.target_port = cache[cnt].target_port;
-				nat_rule.private_port = cache[cnt].private_port;
-				nat_rule.public_port = cache[cnt].public_port;
-				nat_rule.protocol = cache[cnt].protocol;
+			continue;
+		}
 
-				if(ipa_nat_add_ipv4_rule(nat_table_hdl, &nat_rule, &cache[cnt].rule_hdl) < 0)
-				{
-					IPACMERR("unable to add the rule delete from cache\n");
-					memset(&cache[cnt], 0, sizeof(cache[cnt]));
-					curCnt--;
-					continue;
-				}
-				cache[cnt].enabled = true;
+		memset(&flush_rules[nrules], 0, sizeof(ipa_nat_ipv4_rule));
+		flush_rules[nrules].private_ip = cache[cnt].private_ip;
+		flush_rules[nrules].target_ip = cache[cnt].target_ip;
+		flush_rules[nrules].target_port = cache[cnt].target_port;
+		flush_rules[nrules].private_port = cache[cnt].private_port;
+		flush_rules[nrules].public_port = cache[cnt].public_port;
+		flush_rules[nrules].protocol = cache[cnt].protocol;
+		flush_slots[nrules] = cnt;
+		nrules++;
+		total++;
+
+		if(nrules == temp.GetCapacity())
+		{
+			added += RestoreBatch(nrules);
+			nrules = 0;
+		}
+	}
 
-				IPACMDBG("On wan-iface reset added below rule successfully\n");
-				iptodot("Private IP", nat_rule.private_ip);
-				iptodot("Target IP", nat_rule.target_ip);
-				IPACMDBG("Private Port:%d \t Target Port: %d\t", nat_rule.private_port, nat_rule.target_port);
-				IPACMDBG("Public Port:%d\n", nat_rule.public_port);
-				IPACMDBG("protocol: %d\n", nat_rule.protocol);
-			}
+	if(nrules > 0)
+	{
+		added += RestoreBatch(nrules);
+	}
+
+	IPACMDBG_H("Restored %d of %d cached rules in %llu usec\n", added, total,
+		(unsigned long long)(IPACM_EvtStats::now_usec() - start_usec));
+	if(adopt_usec != 0)
+	{
+		IPACMDBG_H("Nat state recovered %llu usec after checkpoint adoption\n",
+			(unsigned long long)(IPACM_EvtStats::now_usec() - adopt_usec));
+		adopt_usec = 0;
+	}
+	return;
+}
+
+/* Enable one batch of flush_rules for the cache entries in flush_slots */
+int NatApp::RestoreBatch(int nrules)
+{
+	int i, slot, added = 0, ret;
+
+	/* a failed batch is removed from the table again by ipanat and
+	   leaves every handle 0, so those entries are dropped below */
+	ret = ipa_nat_add_ipv4_rules(nat_table_hdl, flush_rules, nrules, flush_hdls);
+	if(ret < 0)
+	{
+		IPACMERR("unable to add %d rules Error:%d\n", nrules, ret);
+		memset(flush_hdls, 0, sizeof(uint32_t) * nrules);
+	}
+
+	for(i = 0; i < nrules; i++)
+	{
+		slot = flush_slots[i];
+		if(flush_hdls[i] == 0)
+		{
+			IPACMERR("unable to add the rule delete from cache\n");
+			memset(&cache[slot], 0, sizeof(cache[slot]));
+			curCnt--;
+			continue;
 		}
+
+		cache[slot].rule_hdl = flush_hdls[i];
+		cache[slot].enabled = true;
+		added++;
+
+		IPACMDBG("On wan-iface reset added below rule successfully\n");
+		iptodot("Private IP", cache[slot].private_ip);
+		iptodot("Target IP", cache[slot].target_ip);
+		IPACMDBG("Private Port:%d \t Target Port: %d\t", cache[slot].private_port, cache[slot].target_port);
+		IPACMDBG("Public Port:%d\n", cache[slot].public_port);
+		IPACMDBG("protocol: %d\n", cache[slot].protocol);
 	}
 
-	pub_ip_addr = pub_ip;
-	return 0;
+	return added;
 }
 
 void NatApp::Reset()
@@ -243,6 +725,28 @@ bool NatApp::ChkForDup(const nat_table_entry *rule)
 		{
 			log_nat(rule->protocol,rule->private_ip,rule->target_ip,rule->private_port,\
 			rule->target_port,"Duplicate Rule\n");
+			/* the connection is still known to conntrack */
+			cache[cnt].adopted = false;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Unlike ChkForDup() this has no side effects on the cache */
+bool NatApp::isCached(const nat_table_entry *rule)
+{
+	int cnt;
+
+	for(cnt = 0; cnt < max_entries; cnt++)
+	{
+		if(cache[cnt].private_ip == rule->private_ip &&
+			 cache[cnt].target_ip == rule->target_ip &&
+			 cache[cnt].private_port == rule->private_port &&
+			 cache[cnt].target_port == rule->target_port &&
+			 cache[cnt].protocol == rule->protocol)
+		{
 			return true;
 		}
 	}
@@ -303,8 +807,7 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 	CHK_TBL_HDL();
 	log_nat(rule->protocol,rule->private_ip,rule->target_ip,rule->private_port,\
 	rule->target_port,"for addition\n");
-	if(isAlgPort(rule->protocol, rule->private_port) ||
-		 isAlgPort(rule->protocol, rule->target_port))
+	if(IPACM_FlowClassifier::IsAlgFlow(rule->protocol, rule->private_port, rule->target_port))
 	{
 		IPACMERR("connection using ALG Port, ignore\n");
 		return -1;
@@ -365,6 +868,7 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 				}
 
 				cache[cnt].enabled = true;
+				IPACM_Startup::Milestone(IPACM_STARTUP_FIRST_NAT_RULE);
 			}
 
 			cache[cnt].private_ip = rule->private_ip;
@@ -397,6 +901,161 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 	return 0;
 }
 
+/* Add new connections in batches, returns the number of entries added */
+int NatApp::AddEntries(const nat_table_entry *rules, int cnt)
+{
+	int start, num, ret, total = 0;
+
+	IPACMDBG("%s() %d, entries: %d\n", __FUNCTION__, __LINE__, cnt);
+
+	CHK_TBL_HDL();
+
+	/* a batch is bounded by the flush scratch space */
+	for(start = 0; start < cnt; start += num)
+	{
+		num = cnt - start;
+		if(num > temp.GetCapacity())
+		{
+			num = temp.GetCapacity();
+		}
+
+		ret = AddEntryBatch(&rules[start], num);
+		if(ret < 0)
+		{
+			return -1;
+		}
+		total += ret;
+	}
+
+	return total;
+}
+
+/* Add one batch of new connections, all hw rules are enabled together */
+int NatApp::AddEntryBatch(const nat_table_entry *rules, int cnt)
+{
+	int i, slot = 0, nrules = 0, ncached = 0, added, ret;
+	const nat_table_entry *rule;
+
+	for(i = 0; i < cnt; i++)
+	{
+		rule = &rules[i];
+		log_nat(rule->protocol,rule->private_ip,rule->target_ip,rule->private_port,\
+		rule->target_port,"for addition\n");
+
+		if(IPACM_FlowClassifier::IsAlgFlow(rule->protocol, rule->private_port, rule->target_port))
+		{
+			IPACMERR("connection using ALG Port, ignore\n");
+			continue;
+		}
+
+		if(rule->private_ip == 0 ||
+			 rule->target_ip == 0 ||
+			 rule->private_port == 0  ||
+			 rule->target_port == 0 ||
+			 rule->protocol == 0)
+		{
+			IPACMERR("Invalid Connection, ignoring it\n");
+			continue;
+		}
+
+		/* also catches duplicates within the batch, entries are
+		   placed in the cache as soon as a slot is found */
+		if(ChkForDup(rule))
+		{
+			IPACMERR("Duplicate rule. Ignore it\n");
+			continue;
+		}
+
+		for(; slot < max_entries; slot++)
+		{
+			if(cache[slot].private_ip == 0 &&
+				 cache[slot].target_ip == 0 &&
+				 cache[slot].private_port == 0  &&
+				 cache[slot].target_port == 0 &&
+				 cache[slot].protocol == 0)
+			{
+				break;
+			}
+		}
+
+		if(max_entries == slot)
+		{
+			IPACMERR("Error: Unable to add, reached maximum rules\n");
+			break;
+		}
+
+		cache[slot].enabled = false;
+		cache[slot].rule_hdl = 0;
+		cache[slot].private_ip = rule->private_ip;
+		cache[slot].target_ip = rule->target_ip;
+		cache[slot].target_port = rule->target_port;
+		cache[slot].private_port = rule->private_port;
+		cache[slot].protocol = rule->protocol;
+		cache[slot].timestamp = 0;
+		cache[slot].public_port = rule->public_port;
+		cache[slot].dst_nat = rule->dst_nat;
+		curCnt++;
+
+		if(isPwrSaveIf(rule->private_ip) ||
+			 isPwrSaveIf(rule->target_ip))
+		{
+			IPACMDBG("Device is Power Save mode: Dont insert into nat table but cache\n");
+			IPACMDBG_H("Cached rule(%d) successfully\n", slot);
+			ncached++;
+			slot++;
+			continue;
+		}
+
+		memset(&flush_rules[nrules], 0, sizeof(ipa_nat_ipv4_rule));
+		flush_rules[nrules].private_ip = rule->private_ip;
+		flush_rules[nrules].target_ip = rule->target_ip;
+		flush_rules[nrules].target_port = rule->target_port;
+		flush_rules[nrules].private_port = rule->private_port;
+		flush_rules[nrules].public_port = rule->public_port;
+		flush_rules[nrules].protocol = rule->protocol;
+		flush_slots[nrules] = slot;
+		nrules++;
+		slot++;
+	}
+
+	if(nrules == 0)
+	{
+		return ncached;
+	}
+
+	ret = ipa_nat_add_ipv4_rules(nat_table_hdl, flush_rules, nrules, flush_hdls);
+	if(ret < 0)
+	{
+		IPACMERR("unable to add %d rules Error:%d\n", nrules, ret);
+		memset(flush_hdls, 0, sizeof(uint32_t) * nrules);
+	}
+
+	/* only rules that got a handle count as added */
+	added = 0;
+	for(i = 0; i < nrules; i++)
+	{
+		slot = flush_slots[i];
+		if(flush_hdls[i] == 0)
+		{
+			IPACMERR("unable to add the rule(%d)\n", slot);
+			memset(&cache[slot], 0, sizeof(cache[slot]));
+			curCnt--;
+			continue;
+		}
+
+		cache[slot].rule_hdl = flush_hdls[i];
+		cache[slot].enabled = true;
+		added++;
+	}
+
+	if(added > 0)
+	{
+		IPACM_Startup::Milestone(IPACM_STARTUP_FIRST_NAT_RULE);
+	}
+	IPACMDBG_H("Added %d of %d rules in one batch\n", added, nrules);
+	return added + ncached;
+}
+
 void NatApp::UpdateCTUdpTs(nat_table_entry *rule, uint32_t new_ts)
 {
 	int ret;
@@ -519,21 +1178,6 @@ void NatApp::UpdateUDPTimeStamp()
 
 }
 
-bool NatApp::isAlgPort(uint8_t proto, uint16_t port)
-{
-	int cnt;
-	for(cnt = 0; cnt < nALGPort; cnt++)
-	{
-		if(proto == pALGPorts[cnt].protocol &&
-			 port == pALGPorts[cnt].port)
-		{
-			return true;
-		}
-	}
-
-	return false;
-}
-
 bool NatApp::isPwrSaveIf(uint32_t ip_addr)
 {
 	int cnt;
@@ -670,7 +1314,7 @@ uint32_t NatApp::GetTableHdl(uint32_t in_ip_addr)
 
 void NatApp::AddTempEntry(const nat_table_entry *new_entry)
 {
-	int cnt;
+	bool evicted = false;
 
 	IPACMDBG("Received below Temp Nat entry\n");
 	iptodot("Private IP", new_entry->private_ip);
@@ -678,8 +1322,7 @@ void NatApp::AddTempEntry(const nat_table_entry *new_entry)
 	IPACMDBG("Private Port: %d\t Target Port: %d\t", new_entry->private_port, new_entry->target_port);
 	IPACMDBG("protocolcol: %d\n", new_entry->protocol);
 
-	if(isAlgPort(new_entry->protocol, new_entry->private_port) ||
-		 isAlgPort(new_entry->protocol, new_entry->target_port))
+	if(IPACM_FlowClassifier::IsAlgFlow(new_entry->protocol, new_entry->private_port, new_entry->target_port))
 	{
 		IPACMDBG("connection using ALG Port. Dont insert into nat cache\n");
 		return;
@@ -690,56 +1333,34 @@ void NatApp::AddTempEntry(const nat_table_entry *new_entry)
 		return;
 	}
 
-	for(cnt=0; cnt<MAX_TEMP_ENTRIES; cnt++)
+	if(!temp.Add(new_entry, &evicted))
 	{
-		if(temp[cnt].private_ip == new_entry->private_ip &&
-			 temp[cnt].target_ip == new_entry->target_ip &&
-			 temp[cnt].private_port ==  new_entry->private_port  &&
-			 temp[cnt].target_port == new_entry->target_port &&
-			 temp[cnt].protocol == new_entry->protocol)
-		{
-			IPACMDBG("Received duplicate Temp entry\n");
-			return;
-		}
+		IPACMDBG("Received duplicate Temp entry\n");
+		return;
 	}
 
-	for(cnt=0; cnt<MAX_TEMP_ENTRIES; cnt++)
+	if(evicted)
 	{
-		if(temp[cnt].private_ip == 0 &&
-			 temp[cnt].target_ip == 0)
-		{
-			memcpy(&temp[cnt], new_entry, sizeof(nat_table_entry));
-			IPACMDBG("Added Temp Entry\n");
-			return;
-		}
+		IPACMDBG_H("Temp cache full, evicted oldest entry (total evictions %d)\n",
+						 temp.GetEvictions());
 	}
 
-	IPACMDBG("Unable to add temp entry, cache full\n");
+	IPACMDBG("Added Temp Entry, %d pending\n", temp.GetCount());
 	return;
 }
 
 void NatApp::DeleteTempEntry(const nat_table_entry *entry)
 {
-	int cnt;
-
 	IPACMDBG("Received below nat entry\n");
 	iptodot("Private IP", entry->private_ip);
 	iptodot("Target IP", entry->target_ip);
 	IPACMDBG("Private Port: %d\t Target Port: %d\n", entry->private_port, entry->target_port);
 	IPACMDBG("protocol: %d\n", entry->protocol);
 
-	for(cnt=0; cnt<MAX_TEMP_ENTRIES; cnt++)
+	if(temp.Delete(entry))
 	{
-		if(temp[cnt].private_ip == entry->private_ip &&
-			 temp[cnt].target_ip == entry->target_ip &&
-			 temp[cnt].private_port ==  entry->private_port  &&
-			 temp[cnt].target_port == entry->target_port &&
-			 temp[cnt].protocol == entry->protocol)
-		{
-			memset(&temp[cnt], 0, sizeof(nat_table_entry));
-			IPACMDBG("Delete Temp Entry\n");
-			return;
-		}
+		IPACMDBG("Delete Temp Entry\n");
+		return;
 	}
 
 	IPACMDBG("No Such Temp Entry exists\n");
@@ -749,39 +1370,79 @@ void NatApp::DeleteTempEntry(const nat_table_entry *entry)
 void NatApp::FlushTempEntries(uint32_t ip_addr, bool isAdd,
 		bool isDummy)
 {
-	int cnt;
-	int ret;
+	int cnt, num, nflush = 0, nretry = 0, ndrop = 0;
+	bool evicted;
 
 	IPACMDBG_H("Received below with isAdd:%d ", isAdd);
 	iptodot("IP Address: ", ip_addr);
 
-	for(cnt=0; cnt<MAX_TEMP_ENTRIES; cnt++)
+	num = temp.Flush(ip_addr, flush_pending, flush_retries, temp.GetCapacity());
+	if(num == 0 || !isAdd)
+	{
+		IPACMDBG("Removed %d temp entries\n", num);
+		return;
+	}
+
+	for(cnt = 0; cnt < num; cnt++)
 	{
-		if(temp[cnt].private_ip == ip_addr ||
-			 temp[cnt].target_ip == ip_addr)
+		if(flush_pending[cnt].public_ip != pub_ip_addr)
 		{
-			if(isAdd)
-			{
-				if(temp[cnt].public_ip == pub_ip_addr)
-				{
-					if (isDummy) {
-						/* To avoild DL expections for non IPA path */
-						temp[cnt].private_ip = temp[cnt].public_ip;
-						temp[cnt].private_port = temp[cnt].public_port;
-						IPACMDBG("Flushing dummy temp rule");
-						iptodot("Private IP", temp[cnt].private_ip);
-					}
-
-					ret = AddEntry(&temp[cnt]);
-					if(ret)
-					{
-						IPACMERR("unable to add temp entry: %d\n", ret);
-						continue;
-					}
-				}
-			}
-			memset(&temp[cnt], 0, sizeof(nat_table_entry));
+			continue;
+		}
+
+		if(nflush != cnt)
+		{
+			memcpy(&flush_pending[nflush], &flush_pending[cnt], sizeof(nat_table_entry));
+			flush_retries[nflush] = flush_retries[cnt];
+		}
+		memcpy(&flush_entries[nflush], &flush_pending[nflush], sizeof(nat_table_entry));
+
+		if (isDummy) {
+			/* To avoild DL expections for non IPA path */
+			flush_entries[nflush].private_ip = flush_entries[nflush].public_ip;
+			flush_entries[nflush].private_port = flush_entries[nflush].public_port;
+			IPACMDBG("Flushing dummy temp rule");
+			iptodot("Private IP", flush_entries[nflush].private_ip);
+		}
+		nflush++;
+	}
+
+	if(nflush == 0)
+	{
+		return;
+	}
+
+	if(AddEntries(flush_entries, nflush) < 0)
+	{
+		IPACMERR("unable to add %d temp entries\n", nflush);
+	}
+
+	/* an entry missing from the cache failed to be added, queue it
+	   again as it was received so the next flush retries it */
+	for(cnt = 0; cnt < nflush; cnt++)
+	{
+		if(isCached(&flush_entries[cnt]))
+		{
+			continue;
+		}
+
+		if(flush_retries[cnt] + 1 >= NAT_PENDING_MAX_RETRIES)
+		{
+			log_nat(flush_pending[cnt].protocol, flush_pending[cnt].private_ip,
+							flush_pending[cnt].target_ip, flush_pending[cnt].private_port,
+							flush_pending[cnt].target_port, "dropped after retries\n");
+			ndrop++;
+			continue;
 		}
+
+		temp.Add(&flush_pending[cnt], &evicted, flush_retries[cnt] + 1);
+		nretry++;
+	}
+
+	if(nretry > 0 || ndrop > 0)
+	{
+		IPACMERR("%d temp entries queued again, %d dropped after %d attempts\n",
+						 nretry, ndrop, NAT_PENDING_MAX_RETRIES);
 	}
 
 	return;
@@ -834,6 +1495,35 @@ int NatApp::DelEntriesOnClntDiscon(uint32_t ip_addr)
 	return 0;
 }
 
+/* Remove checkpointed entries which conntrack no longer reported
+   after the first conntrack dump, their connections closed while
+   ipacm was down */
+int NatApp::DelStaleAdoptedEntries(void)
+{
+	int cnt, tmp = 0;
+
+	for(cnt = 0; cnt < max_entries; cnt++)
+	{
+		if(cache[cnt].adopted == false)
+		{
+			continue;
+		}
+
+		if(cache[cnt].enabled == true &&
+			 ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl) < 0)
+		{
+			IPACMERR("unable to delete the rule\n");
+		}
+
+		memset(&cache[cnt], 0, sizeof(cache[cnt]));
+		curCnt--;
+		tmp++;
+	}
+
+	IPACMDBG_H("Deleted %d stale checkpointed entries\n", tmp);
+	return tmp;
+}
+
 int NatApp::DelEntriesOnSTAClntDiscon(uint32_t ip_addr)
 {
 	int cnt, tmp = curCnt;
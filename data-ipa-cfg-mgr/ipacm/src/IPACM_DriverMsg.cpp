@@ -0,0 +1,246 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_DriverMsg.cpp
+
+	@brief
+	This file implements the IPA driver message arena.
+
+	The driver notifier reads every message straight into a slot of a
+	preallocated arena. Event data posted for the message is either the
+	driver payload itself or a slice carved out of the same slot, so the
+	event queue owns arena memory instead of a malloc()ed copy. A slot is
+	reused once the notifier and every event holding one of its slices
+	have let go of it.
+
+	@Author
+
+*/
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "IPACM_DriverMsg.h"
+#include "IPACM_Log.h"
+
+#define IPA_DRIVER_MSG_ALIGN(x) (((x) + 7) & ~((uint32_t)7))
+
+char *IPACM_DriverMsg::arena = NULL;
+ipacm_drv_msg_slot IPACM_DriverMsg::slots[IPA_DRIVER_MSG_SLOTS];
+ipacm_drv_msg_slot *IPACM_DriverMsg::free_list = NULL;
+pthread_mutex_t IPACM_DriverMsg::lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t IPACM_DriverMsg::cond = PTHREAD_COND_INITIALIZER;
+ipacm_drv_msg_stats IPACM_DriverMsg::stats;
+
+int IPACM_DriverMsg::Init(void)
+{
+	int i;
+
+	if(arena != NULL)
+	{
+		return IPACM_SUCCESS;
+	}
+
+	arena = (char *)malloc(IPA_DRIVER_MSG_SLOTS * IPA_DRIVER_MSG_SLOT_LEN);
+	if(arena == NULL)
+	{
+		IPACMERR("unable to allocate driver message arena\n");
+		return IPACM_FAILURE;
+	}
+
+	memset(&stats, 0, sizeof(stats));
+	free_list = NULL;
+	for(i = IPA_DRIVER_MSG_SLOTS - 1; i >= 0; i--)
+	{
+		memset(&slots[i], 0, sizeof(slots[i]));
+		slots[i].buf = arena + i * IPA_DRIVER_MSG_SLOT_LEN;
+		slots[i].next = free_list;
+		free_list = &slots[i];
+	}
+	IPACMDBG_H("driver message arena: %d slots of %d bytes\n",
+		IPA_DRIVER_MSG_SLOTS, (int)IPA_DRIVER_MSG_SLOT_LEN);
+	return IPACM_SUCCESS;
+}
+
+ipacm_drv_msg_slot* IPACM_DriverMsg::Get(bool nowait)
+{
+	ipacm_drv_msg_slot *slot;
+
+	pthread_mutex_lock(&lock);
+	if(free_list == NULL)
+	{
+		if(nowait)
+		{
+			pthread_mutex_unlock(&lock);
+			return NULL;
+		}
+		/* the driver keeps queueing, wait for the event queue to catch up */
+		stats.stalls++;
+		IPACMDBG_H("driver message arena exhausted, wait for a slot\n");
+		while(free_list == NULL)
+		{
+			pthread_cond_wait(&cond, &lock);
+		}
+	}
+	slot = free_list;
+	free_list = slot->next;
+	stats.in_use++;
+	if(stats.in_use > stats.peak)
+	{
+		stats.peak = stats.in_use;
+	}
+	pthread_mutex_unlock(&lock);
+
+	slot->next = NULL;
+	slot->len = 0;
+	slot->used = 0;
+	slot->refcnt = 1;
+	return slot;
+}
+
+void IPACM_DriverMsg::Put(ipacm_drv_msg_slot *slot)
+{
+	release(slot);
+	return;
+}
+
+void* IPACM_DriverMsg::Carve(ipacm_drv_msg_slot *slot, uint32_t size)
+{
+	uint32_t off;
+	void *ptr;
+
+	off = IPA_DRIVER_MSG_ALIGN(slot->used > (uint32_t)slot->len ? slot->used : (uint32_t)slot->len);
+	if(off + size > IPA_DRIVER_MSG_SLOT_LEN)
+	{
+		stats.heap_slices++;
+		return calloc(1, size);
+	}
+
+	ptr = slot->buf + off;
+	memset(ptr, 0, size);
+	slot->used = off + size;
+	__sync_fetch_and_add(&slot->refcnt, 1);
+	stats.slices++;
+	return ptr;
+}
+
+void* IPACM_DriverMsg::Adopt(ipacm_drv_msg_slot *slot, uint32_t size)
+{
+	uint32_t end = sizeof(struct ipa_msg_meta) + size;
+
+	if(end > IPA_DRIVER_MSG_SLOT_LEN)
+	{
+		IPACMERR("driver payload of %d bytes does not fit a slot\n", size);
+		return NULL;
+	}
+	/* short message, the old per-read memset left the tail zeroed */
+	if((uint32_t)slot->len < end)
+	{
+		memset(slot->buf + slot->len, 0, end - slot->len);
+	}
+	if(slot->used < end)
+	{
+		slot->used = end;
+	}
+	__sync_fetch_and_add(&slot->refcnt, 1);
+	stats.slices++;
+	return slot->buf + sizeof(struct ipa_msg_meta);
+}
+
+void IPACM_DriverMsg::Free(void *evt_data)
+{
+	ipacm_drv_msg_slot *slot;
+
+	if(evt_data == NULL)
+	{
+		return;
+	}
+
+	slot = slot_of(evt_data);
+	if(slot == NULL)
+	{
+		free(evt_data);
+		return;
+	}
+	release(slot);
+	return;
+}
+
+void IPACM_DriverMsg::RecordWakeup(int batch)
+{
+	stats.wakeups++;
+	stats.msgs += batch;
+	if((uint32_t)batch > stats.max_batch)
+	{
+		stats.max_batch = batch;
+	}
+	return;
+}
+
+int IPACM_DriverMsg::dump(char *buf, int len)
+{
+	int ret;
+
+	ret = snprintf(buf, len, "driver msgs=%llu wakeups=%llu max_batch=%u slots=%d in_use=%u peak=%u "
+		"slices=%u heap_slices=%u stalls=%u\n",
+		(unsigned long long)stats.msgs, (unsigned long long)stats.wakeups, stats.max_batch,
+		IPA_DRIVER_MSG_SLOTS, stats.in_use, stats.peak, stats.slices, stats.heap_slices, stats.stalls);
+	if(ret >= len)
+	{
+		ret = len - 1;
+	}
+	return ret;
+}
+
+ipacm_drv_msg_slot* IPACM_DriverMsg::slot_of(void *ptr)
+{
+	char *p = (char *)ptr;
+
+	if(arena == NULL || p < arena || p >= arena + IPA_DRIVER_MSG_SLOTS * IPA_DRIVER_MSG_SLOT_LEN)
+	{
+		return NULL;
+	}
+	return &slots[(p - arena) / IPA_DRIVER_MSG_SLOT_LEN];
+}
+
+void IPACM_DriverMsg::release(ipacm_drv_msg_slot *slot)
+{
+	if(__sync_sub_and_fetch(&slot->refcnt, 1) != 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&lock);
+	slot->next = free_list;
+	free_list = slot;
+	stats.in_use--;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&lock);
+	return;
+}
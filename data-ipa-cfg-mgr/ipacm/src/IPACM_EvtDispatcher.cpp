@@ -42,12 +42,19 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <IPACM_Neighbor.h>
 #include "IPACM_CmdQueue.h"
 #include "IPACM_Defs.h"
+#include "IPACM_EvtStats.h"
+#include "IPACM_EvtRecord.h"
+#include "IPACM_EvtExecutor.h"
+#include "IPACM_DriverMsg.h"
 
 
 extern pthread_mutex_t mutex;
 extern pthread_cond_t  cond_var;
 
-cmd_evts *IPACM_EvtDispatcher::head = NULL;
+cmd_evts *IPACM_EvtDispatcher::head[IPACM_EVENT_MAX];
+cmd_evts *IPACM_EvtDispatcher::tail[IPACM_EVENT_MAX];
+bool IPACM_EvtDispatcher::dispatching = false;
+pthread_t IPACM_EvtDispatcher::dispatch_thread;
 extern uint32_t ipacm_event_stats[IPACM_EVENT_MAX];
 
 int IPACM_EvtDispatcher::PostEvt
@@ -90,6 +97,13 @@ int IPACM_EvtDispatcher::PostEvt
 		return IPACM_FAILURE;
 	}
 
+	/* under the queue mutex, see MessageQueue::StartRecording */
+	if(IPACM_EvtRecord::IsEnabled())
+	{
+		IPACM_EvtRecord::Record(data, IPACM_EvtExecutor::InWorker() ||
+			(dispatching && pthread_equal(dispatch_thread, pthread_self())));
+	}
+
 	IPACMDBG("Enqueing item\n");
 	MsgQueue->enqueue(item);
 	IPACMDBG("Enqueued item %p\n", item);
@@ -118,38 +132,99 @@ int IPACM_EvtDispatcher::PostEvt
 void IPACM_EvtDispatcher::ProcessEvt(ipacm_cmd_q_data *data)
 {
 
-	cmd_evts *tmp = head, tmp1;
+	cmd_evts *tmp, tmp1;
+	ipacm_exec_evt *evt = NULL;
+	int key;
 
-	if(head == NULL)
+	if(data->event < 0 || data->event >= IPACM_EVENT_MAX)
+	{
+		IPACMERR("Invalid event %d\n", data->event);
+		if(data->evt_data != NULL)
+		{
+			IPACM_DriverMsg::Free(data->evt_data);
+		}
+		return;
+	}
+
+	tmp = head[data->event];
+	if(tmp == NULL)
 	{
 		IPACMDBG("Queue is empty\n");
 	}
 
+	if(IPACM_EvtExecutor::IsEnabled())
+	{
+		if(IPACM_EvtExecutor::IsIfaceOrdered(data->event))
+		{
+			evt = IPACM_EvtExecutor::NewEvt(data);
+		}
+		if(evt == NULL)
+		{
+			/* globally ordered, let every per-interface callback finish first */
+			IPACM_EvtExecutor::Barrier();
+		}
+	}
+
+	dispatch_thread = pthread_self();
+	dispatching = true;
+
 	while(tmp != NULL)
 	{
 	        memcpy(&tmp1, tmp, sizeof(tmp1));
-		if(data->event == tmp1.event)
+		key = tmp1.obj->get_executor();
+		if(evt != NULL && key >= 0)
 		{
-			ipacm_event_stats[data->event]++;
-			tmp1.obj->event_callback(data->event, data->evt_data);
-			IPACMDBG(" Find matched registered events\n");
+			IPACM_EvtExecutor::Submit(evt, tmp1.obj, key);
 		}
+		else
+		{
+			Notify(data->event, tmp1.obj, data->evt_data);
+		}
+		IPACMDBG(" Find matched registered events\n");
 	        tmp = tmp1.next;
 	}
 
+	dispatching = false;
 	IPACMDBG(" Finished process events\n");
-			
+
+	if(evt != NULL)
+	{
+		/* event data is freed once the last worker callback returns */
+		IPACM_EvtExecutor::Release(evt);
+		return;
+	}
+
 	if(data->evt_data != NULL)
 	{
 		IPACMDBG("free the event:%d data: %p\n", data->event, data->evt_data);
-		free(data->evt_data);
+		IPACM_DriverMsg::Free(data->evt_data);
 	}
 	return;
 }
 
+void IPACM_EvtDispatcher::Notify(ipa_cm_event_id event, IPACM_Listener *obj, void *evt_data)
+{
+	char name[IPACM_STATS_NAME_LEN];
+	uint64_t start;
+
+	__sync_fetch_and_add(&ipacm_event_stats[event], 1);
+	/* listener may delete itself in the callback, keep its name */
+	strlcpy(name, obj->get_listener_name(), sizeof(name));
+	start = IPACM_EvtStats::now_usec();
+	obj->event_callback(event, evt_data);
+	IPACM_EvtStats::record_handler(event, name, start);
+	return;
+}
+
 int IPACM_EvtDispatcher::registr(ipa_cm_event_id event, IPACM_Listener *obj)
 {
-	cmd_evts *tmp = head,*nw;
+	cmd_evts *nw;
+
+	if(event < 0 || event >= IPACM_EVENT_MAX)
+	{
+		IPACMERR("Invalid event %d\n", event);
+		return IPACM_FAILURE;
+	}
 
 	nw = (cmd_evts *)malloc(sizeof(cmd_evts));
 	if(nw != NULL)
@@ -163,51 +238,54 @@ int IPACM_EvtDispatcher::registr(ipa_cm_event_id event, IPACM_Listener *obj)
 		return IPACM_FAILURE;
 	}
 
-	if(head == NULL)
+	if(head[event] == NULL)
 	{
-		head = nw;
+		head[event] = nw;
 	}
 	else
 	{
-		while(tmp->next)
-		{
-			tmp = tmp->next;
-		}
-		tmp->next = nw;
+		tail[event]->next = nw;
 	}
+	tail[event] = nw;
 	return IPACM_SUCCESS;
 }
 
 
 int IPACM_EvtDispatcher::deregistr(IPACM_Listener *param)
 {
-	cmd_evts *tmp = head,*tmp1,*prev = head;
+	cmd_evts *tmp, *tmp1, *prev;
+	int event;
 
-	while(tmp != NULL)
+	for(event = 0; event < IPACM_EVENT_MAX; event++)
 	{
-		if(tmp->obj == param)
+		tmp = head[event];
+		prev = NULL;
+		while(tmp != NULL)
 		{
-			tmp1 = tmp;
-			if(tmp == head)
-			{
-				head = head->next;
-			}
-			else if(tmp->next == NULL)
+			if(tmp->obj == param)
 			{
-				prev->next = NULL;
+				tmp1 = tmp;
+				if(prev == NULL)
+				{
+					head[event] = tmp->next;
+				}
+				else
+				{
+					prev->next = tmp->next;
+				}
+				if(tail[event] == tmp)
+				{
+					tail[event] = prev;
+				}
+
+				tmp = tmp->next;
+				free(tmp1);
 			}
 			else
 			{
-				prev->next = tmp->next;
+				prev = tmp;
+				tmp = tmp->next;
 			}
-
-			tmp = tmp->next;
-			free(tmp1);
-		}
-		else
-		{
-			prev = tmp;
-			tmp = tmp->next;
 		}
 	}
 	return IPACM_SUCCESS;
@@ -0,0 +1,282 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_EvtExecutor.cpp
+
+	@brief
+	This file implements the IPACM per-interface event executor functionality.
+
+	Events which only touch the state of the interface they were raised for
+	are handed to a bounded pool of workers; all callbacks of one executor
+	key run on the same worker, in posting order. Every other event is a
+	barrier: the command queue thread waits for the workers to go idle and
+	runs its callbacks inline, exactly as without workers.
+
+	@Author
+
+*/
+#include <string.h>
+#include <stdlib.h>
+#include "IPACM_EvtExecutor.h"
+#include "IPACM_EvtDispatcher.h"
+#include "IPACM_DriverMsg.h"
+#include "IPACM_Log.h"
+
+int IPACM_EvtExecutor::num_workers = 0;
+int IPACM_EvtExecutor::pending = 0;
+ipacm_exec_worker IPACM_EvtExecutor::workers[IPACM_MAX_EVT_WORKERS];
+pthread_mutex_t IPACM_EvtExecutor::exec_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t IPACM_EvtExecutor::idle_cond = PTHREAD_COND_INITIALIZER;
+pthread_mutex_t IPACM_EvtExecutor::shared_lock;
+
+static __thread bool ipacm_in_worker = false;
+
+int IPACM_EvtExecutor::Start(int workers_cnt)
+{
+	pthread_mutexattr_t attr;
+	char name[16];
+	int i;
+
+	if(workers_cnt <= 0)
+	{
+		IPACMDBG_H("event workers disabled\n");
+		return IPACM_SUCCESS;
+	}
+	if(workers_cnt > IPACM_MAX_EVT_WORKERS)
+	{
+		IPACMERR("%d event workers requested, limit to %d\n", workers_cnt, IPACM_MAX_EVT_WORKERS);
+		workers_cnt = IPACM_MAX_EVT_WORKERS;
+	}
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&shared_lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+
+	for(i = 0; i < workers_cnt; i++)
+	{
+		memset(&workers[i], 0, sizeof(workers[i]));
+		pthread_cond_init(&workers[i].cond, NULL);
+		if(pthread_create(&workers[i].thread, NULL, worker_thread, &workers[i]) != 0)
+		{
+			IPACMERR("unable to create event worker %d\n", i);
+			break;
+		}
+		snprintf(name, sizeof(name), "ipacm evt %d", i);
+		if(pthread_setname_np(workers[i].thread, name) != 0)
+		{
+			IPACMERR("unable to set thread name\n");
+		}
+	}
+
+	/* workers already created are idle, use whatever we got */
+	num_workers = i;
+	IPACMDBG_H("started %d event workers\n", num_workers);
+	return (num_workers > 0) ? IPACM_SUCCESS : IPACM_FAILURE;
+}
+
+/* Per-interface ordering rules. An event may only be listed here if every
+   listener registered for it either
+   - keeps to its own interface object, the NAT/conntrack tables behind
+     LockShared() and events it posts itself, and never registers or
+     deregisters listeners from the callback, or
+   - returns IPACM_EXEC_COORDINATOR and is safe to run next to the workers.
+   Link, address, route, WAN up/down, bridge and config events update
+   cross-interface state and stay globally ordered. */
+bool IPACM_EvtExecutor::IsIfaceOrdered(ipa_cm_event_id event)
+{
+	switch(event)
+	{
+	/* wifi client join/leave, IPACM_Wlan and IPACM_Neighbor */
+	case IPA_WLAN_CLIENT_ADD_EVENT:
+	case IPA_WLAN_CLIENT_ADD_EVENT_EX:
+	case IPA_WLAN_CLIENT_DEL_EVENT:
+	case IPA_WLAN_CLIENT_POWER_SAVE_EVENT:
+	case IPA_WLAN_CLIENT_RECOVER_EVENT:
+	/* client address learnt/lost, LAN/WLAN/WAN instances and conntrack */
+	case IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT:
+	case IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT:
+	/* firewall reinstall, IPACM_Wan instances only */
+	case IPA_FIREWALL_CHANGE_EVENT:
+	/* NAT offload, conntrack only */
+	case IPA_PROCESS_CT_MESSAGE:
+	case IPA_PROCESS_CT_MESSAGE_V6:
+		return true;
+	default:
+		return false;
+	}
+}
+
+ipacm_exec_evt* IPACM_EvtExecutor::NewEvt(ipacm_cmd_q_data *data)
+{
+	ipacm_exec_evt *evt;
+
+	evt = (ipacm_exec_evt *)malloc(sizeof(ipacm_exec_evt));
+	if(evt == NULL)
+	{
+		IPACMERR("unable to allocate executor event\n");
+		return NULL;
+	}
+	evt->event = data->event;
+	evt->evt_data = data->evt_data;
+	/* reference held by the dispatcher until all callbacks are submitted */
+	evt->refcnt = 1;
+	return evt;
+}
+
+void IPACM_EvtExecutor::Submit(ipacm_exec_evt *evt, IPACM_Listener *obj, int key)
+{
+	ipacm_exec_job *job;
+	ipacm_exec_worker *worker;
+
+	job = (ipacm_exec_job *)malloc(sizeof(ipacm_exec_job));
+	if(job == NULL)
+	{
+		IPACMERR("unable to allocate executor job, run %s inline\n", obj->get_listener_name());
+		Barrier();
+		IPACM_EvtDispatcher::Notify(evt->event, obj, evt->evt_data);
+		return;
+	}
+	__sync_fetch_and_add(&evt->refcnt, 1);
+	job->evt = evt;
+	job->obj = obj;
+	job->next = NULL;
+
+	worker = &workers[key % num_workers];
+
+	pthread_mutex_lock(&exec_lock);
+	if(worker->tail == NULL)
+	{
+		worker->head = job;
+	}
+	else
+	{
+		worker->tail->next = job;
+	}
+	worker->tail = job;
+	pending++;
+	pthread_cond_signal(&worker->cond);
+	pthread_mutex_unlock(&exec_lock);
+	return;
+}
+
+void IPACM_EvtExecutor::Release(ipacm_exec_evt *evt)
+{
+	if(__sync_sub_and_fetch(&evt->refcnt, 1) != 0)
+	{
+		return;
+	}
+
+	if(evt->evt_data != NULL)
+	{
+		IPACMDBG("free the event:%d data: %p\n", evt->event, evt->evt_data);
+		IPACM_DriverMsg::Free(evt->evt_data);
+	}
+	free(evt);
+	return;
+}
+
+void IPACM_EvtExecutor::Barrier(void)
+{
+	if(num_workers == 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&exec_lock);
+	while(pending > 0)
+	{
+		pthread_cond_wait(&idle_cond, &exec_lock);
+	}
+	pthread_mutex_unlock(&exec_lock);
+	return;
+}
+
+bool IPACM_EvtExecutor::InWorker(void)
+{
+	return ipacm_in_worker;
+}
+
+void IPACM_EvtExecutor::LockShared(void)
+{
+	/* single threaded without workers */
+	if(num_workers > 0)
+	{
+		pthread_mutex_lock(&shared_lock);
+	}
+	return;
+}
+
+void IPACM_EvtExecutor::UnlockShared(void)
+{
+	if(num_workers > 0)
+	{
+		pthread_mutex_unlock(&shared_lock);
+	}
+	return;
+}
+
+void* IPACM_EvtExecutor::worker_thread(void *param)
+{
+	ipacm_exec_worker *worker = (ipacm_exec_worker *)param;
+	ipacm_exec_job *job;
+
+	ipacm_in_worker = true;
+
+	while(1)
+	{
+		pthread_mutex_lock(&exec_lock);
+		while(worker->head == NULL)
+		{
+			pthread_cond_wait(&worker->cond, &exec_lock);
+		}
+		job = worker->head;
+		worker->head = job->next;
+		if(worker->head == NULL)
+		{
+			worker->tail = NULL;
+		}
+		pthread_mutex_unlock(&exec_lock);
+
+		IPACM_EvtDispatcher::Notify(job->evt->event, job->obj, job->evt->evt_data);
+		Release(job->evt);
+		free(job);
+
+		pthread_mutex_lock(&exec_lock);
+		pending--;
+		if(pending == 0)
+		{
+			pthread_cond_broadcast(&idle_cond);
+		}
+		pthread_mutex_unlock(&exec_lock);
+	}
+
+	return NULL;
+}
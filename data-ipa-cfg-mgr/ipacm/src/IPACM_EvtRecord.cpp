@@ -0,0 +1,415 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_EvtRecord.cpp
+
+	@brief
+	This file implements the IPACM event recording.
+
+	@Author
+
+*/
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <linux/netlink.h>
+#include "linux/ipa_qmi_service_v01.h"
+#include "IPACM_EvtRecord.h"
+#include "IPACM_EvtStats.h"
+#include "IPACM_Log.h"
+
+extern "C"
+{
+#include <linux/netfilter/nfnetlink.h>
+#include <linux/netfilter/nfnetlink_conntrack.h>
+#include <libnetfilter_conntrack/libnetfilter_conntrack.h>
+}
+
+FILE *IPACM_EvtRecord::fp = NULL;
+pthread_mutex_t IPACM_EvtRecord::rec_mutex = PTHREAD_MUTEX_INITIALIZER;
+uint64_t IPACM_EvtRecord::start_usec = 0;
+int IPACM_EvtRecord::num_iface = 0;
+int IPACM_EvtRecord::iface_seen[IPACM_EVT_REC_MAX_IFACE];
+uint8_t IPACM_EvtRecord::payload_buf[IPACM_EVT_REC_MAX_PAYLOAD];
+
+/* conntrack payload: message type followed by a ctnetlink message */
+typedef struct
+{
+	uint32_t type;
+	uint32_t nlh[0];
+} ipacm_evt_rec_ct;
+
+int IPACM_EvtRecord::Start(const char *path)
+{
+	ipacm_evt_rec_file_hdr hdr;
+
+	pthread_mutex_lock(&rec_mutex);
+	if(fp != NULL)
+	{
+		pthread_mutex_unlock(&rec_mutex);
+		return IPACM_SUCCESS;
+	}
+
+	fp = fopen(path, "w");
+	if(fp == NULL)
+	{
+		IPACMERR("unable to open event record file %s (%s)\n", path, strerror(errno));
+		pthread_mutex_unlock(&rec_mutex);
+		return IPACM_FAILURE;
+	}
+
+	hdr.magic = IPACM_EVT_REC_MAGIC;
+	hdr.version = IPACM_EVT_REC_VERSION;
+	hdr.event_max = IPACM_EVENT_MAX;
+	if(fwrite(&hdr, sizeof(hdr), 1, fp) != 1)
+	{
+		IPACMERR("unable to write event record header\n");
+		fclose(fp);
+		fp = NULL;
+		pthread_mutex_unlock(&rec_mutex);
+		return IPACM_FAILURE;
+	}
+	fflush(fp);
+
+	start_usec = IPACM_EvtStats::now_usec();
+	num_iface = 0;
+	pthread_mutex_unlock(&rec_mutex);
+
+	IPACMDBG_H("recording events to %s\n", path);
+	return IPACM_SUCCESS;
+}
+
+void IPACM_EvtRecord::Stop(void)
+{
+	pthread_mutex_lock(&rec_mutex);
+	if(fp != NULL)
+	{
+		fclose(fp);
+		fp = NULL;
+	}
+	pthread_mutex_unlock(&rec_mutex);
+}
+
+int IPACM_EvtRecord::Write(uint16_t type, uint16_t event, uint16_t flags, uint64_t ts, const void *payload, uint16_t len)
+{
+	ipacm_evt_rec_hdr rec;
+
+	rec.ts_usec = ts;
+	rec.type = type;
+	rec.event = event;
+	rec.flags = flags;
+	rec.len = len;
+
+	if(fwrite(&rec, sizeof(rec), 1, fp) != 1 ||
+		 (len > 0 && fwrite(payload, len, 1, fp) != 1))
+	{
+		IPACMERR("event record write failed, stop recording\n");
+		fclose(fp);
+		fp = NULL;
+		return IPACM_FAILURE;
+	}
+
+	return IPACM_SUCCESS;
+}
+
+/* write the if_index to name mapping once per interface so the replay
+   can answer SIOCGIFNAME/SIOCGIFINDEX without the real netdevs */
+void IPACM_EvtRecord::RecordIface(int if_index, uint64_t ts)
+{
+	ipacm_evt_rec_iface iface;
+	int i;
+
+	for(i = 0; i < num_iface; i++)
+	{
+		if(iface_seen[i] == if_index)
+		{
+			return;
+		}
+	}
+
+	memset(&iface, 0, sizeof(iface));
+	iface.if_index = if_index;
+	if(if_indextoname(if_index, iface.if_name) == NULL)
+	{
+		return;
+	}
+
+	if(num_iface < IPACM_EVT_REC_MAX_IFACE)
+	{
+		iface_seen[num_iface++] = if_index;
+	}
+	Write(IPACM_EVT_REC_IFACE, 0, 0, ts, &iface, sizeof(iface));
+}
+
+/* returns payload length, -1 if the payload cannot be serialized */
+int IPACM_EvtRecord::Encode(const ipacm_cmd_q_data *data, uint8_t *buf, int len, int *if_index)
+{
+	int size = -1;
+	ipacm_ct_evt_data *ct_data;
+	ipacm_evt_rec_ct *rec_ct;
+	struct nlmsghdr *nlh;
+	struct nfgenmsg *nfh;
+
+	*if_index = -1;
+	if(data->evt_data == NULL)
+	{
+		return 0;
+	}
+
+	switch(data->event)
+	{
+	case IPA_PRIVATE_SUBNET_CHANGE_EVENT:
+	case IPA_LINK_UP_EVENT:
+	case IPA_LINK_DOWN_EVENT:
+	case IPA_USB_LINK_UP_EVENT:
+	case IPA_WAN_EMBMS_LINK_UP_EVENT:
+	case IPA_WLAN_AP_LINK_UP_EVENT:
+	case IPA_WLAN_LINK_DOWN_EVENT:
+	case IPA_WAN_XLAT_CONNECT_EVENT:
+	case IPA_LAN_DELETE_SELF:
+		size = sizeof(ipacm_event_data_fid);
+		*if_index = ((ipacm_event_data_fid *)data->evt_data)->if_index;
+		break;
+
+	case IPA_WLAN_STA_LINK_UP_EVENT:
+	case IPA_WLAN_CLIENT_ADD_EVENT:
+	case IPA_WLAN_CLIENT_DEL_EVENT:
+	case IPA_WLAN_CLIENT_POWER_SAVE_EVENT:
+	case IPA_WLAN_CLIENT_RECOVER_EVENT:
+		size = sizeof(ipacm_event_data_mac);
+		*if_index = ((ipacm_event_data_mac *)data->evt_data)->if_index;
+		break;
+
+	case IPA_WLAN_CLIENT_ADD_EVENT_EX:
+		size = sizeof(ipacm_event_data_wlan_ex) +
+			((ipacm_event_data_wlan_ex *)data->evt_data)->num_of_attribs * sizeof(ipa_wlan_hdr_attrib_val);
+		*if_index = ((ipacm_event_data_wlan_ex *)data->evt_data)->if_index;
+		break;
+
+	case IPA_BRIDGE_LINK_UP_EVENT:
+	case IPA_NEW_NEIGH_EVENT:
+	case IPA_DEL_NEIGH_EVENT:
+	case IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT:
+	case IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT:
+		size = sizeof(ipacm_event_data_all);
+		*if_index = ((ipacm_event_data_all *)data->evt_data)->if_index;
+		break;
+
+	case IPA_ADDR_ADD_EVENT:
+	case IPA_ROUTE_ADD_EVENT:
+	case IPA_ROUTE_DEL_EVENT:
+		size = sizeof(ipacm_event_data_addr);
+		*if_index = ((ipacm_event_data_addr *)data->evt_data)->if_index;
+		break;
+
+	case IPA_WAN_UPSTREAM_ROUTE_ADD_EVENT:
+	case IPA_WAN_UPSTREAM_ROUTE_DEL_EVENT:
+		size = sizeof(ipacm_event_data_iptype);
+		*if_index = ((ipacm_event_data_iptype *)data->evt_data)->if_index;
+		break;
+
+	case IPA_LAN_TO_LAN_NEW_CONNECTION:
+	case IPA_LAN_TO_LAN_DEL_CONNECTION:
+		size = sizeof(ipacm_event_connection);
+		break;
+
+	case IPA_CRADLE_WAN_MODE_SWITCH:
+		size = sizeof(ipacm_event_cradle_wan_mode);
+		break;
+
+	case IPA_TETHERING_STATS_UPDATE_EVENT:
+		size = sizeof(struct ipa_get_data_stats_resp_msg_v01);
+		break;
+
+	case IPA_NETWORK_STATS_UPDATE_EVENT:
+		size = sizeof(struct ipa_get_apn_data_stats_resp_msg_v01);
+		break;
+
+	case IPA_HANDLE_WAN_UP:
+	case IPA_HANDLE_WAN_DOWN:
+	case IPA_HANDLE_WLAN_UP:
+	case IPA_HANDLE_LAN_UP:
+		size = sizeof(ipacm_event_iface_up);
+		break;
+
+	case IPA_HANDLE_WAN_UP_TETHER:
+	case IPA_HANDLE_WAN_DOWN_TETHER:
+	case IPA_HANDLE_WAN_UP_V6_TETHER:
+	case IPA_HANDLE_WAN_DOWN_V6_TETHER:
+		size = sizeof(ipacm_event_iface_up_tehter);
+		break;
+
+	case IPA_PROCESS_CT_MESSAGE:
+	case IPA_PROCESS_CT_MESSAGE_V6:
+		/* ctnetlink attributes are not bounds checked, leave room for the largest entry */
+		ct_data = (ipacm_ct_evt_data *)data->evt_data;
+		if(ct_data->ct == NULL || len < (int)(sizeof(ipacm_evt_rec_ct) + 1024))
+		{
+			return -1;
+		}
+		rec_ct = (ipacm_evt_rec_ct *)buf;
+		rec_ct->type = ct_data->type;
+		nlh = (struct nlmsghdr *)rec_ct->nlh;
+		memset(nlh, 0, NLMSG_HDRLEN + NLMSG_ALIGN(sizeof(struct nfgenmsg)));
+		nlh->nlmsg_len = NLMSG_HDRLEN;
+		nlh->nlmsg_type = (NFNL_SUBSYS_CTNETLINK << 8) | IPCTNL_MSG_CT_NEW;
+		nfh = (struct nfgenmsg *)((uint8_t *)nlh + NLMSG_HDRLEN);
+		nfh->nfgen_family = nfct_get_attr_u8(ct_data->ct, ATTR_ORIG_L3PROTO);
+		nfh->version = NFNETLINK_V0;
+		nlh->nlmsg_len += NLMSG_ALIGN(sizeof(struct nfgenmsg));
+		if(nfct_nlmsg_build(nlh, ct_data->ct) < 0)
+		{
+			return -1;
+		}
+		return sizeof(ipacm_evt_rec_ct) + nlh->nlmsg_len;
+
+	default:
+		/* e.g. ipacm_event_eth_bridge carries an IPACM_Lan pointer */
+		return -1;
+	}
+
+	if(size > len)
+	{
+		return -1;
+	}
+	memcpy(buf, data->evt_data, size);
+	return size;
+}
+
+void IPACM_EvtRecord::Record(const ipacm_cmd_q_data *data, bool derived)
+{
+	int len, if_index;
+	uint16_t flags = 0;
+	uint64_t ts;
+
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&rec_mutex);
+	if(fp == NULL)
+	{
+		pthread_mutex_unlock(&rec_mutex);
+		return;
+	}
+
+	ts = IPACM_EvtStats::now_usec() - start_usec;
+	/* derived events are regenerated by the listeners on replay */
+	if(derived)
+	{
+		len = 0;
+		flags |= IPACM_EVT_REC_F_DERIVED;
+		if(data->evt_data != NULL)
+		{
+			flags |= IPACM_EVT_REC_F_NO_PAYLOAD;
+		}
+	}
+	else
+	{
+		len = Encode(data, payload_buf, sizeof(payload_buf), &if_index);
+		if(len < 0)
+		{
+			len = 0;
+			flags |= IPACM_EVT_REC_F_NO_PAYLOAD;
+		}
+		else if(if_index > 0)
+		{
+			RecordIface(if_index, ts);
+		}
+	}
+
+	if(fp != NULL && Write(IPACM_EVT_REC_EVENT, data->event, flags, ts, payload_buf, len) == IPACM_SUCCESS)
+	{
+		fflush(fp);
+	}
+	pthread_mutex_unlock(&rec_mutex);
+}
+
+int IPACM_EvtRecord::Decode(const ipacm_evt_rec_hdr *rec, const uint8_t *payload, void **evt_data)
+{
+	uint32_t nl_buf[IPACM_EVT_REC_MAX_PAYLOAD / sizeof(uint32_t)];
+	ipacm_ct_evt_data *ct_data;
+	ipacm_evt_rec_ct *rec_ct;
+	struct nlmsghdr *nlh;
+
+	*evt_data = NULL;
+	if(rec->len == 0)
+	{
+		return (rec->flags & IPACM_EVT_REC_F_NO_PAYLOAD) ? IPACM_FAILURE : IPACM_SUCCESS;
+	}
+
+	if(rec->event != IPA_PROCESS_CT_MESSAGE && rec->event != IPA_PROCESS_CT_MESSAGE_V6)
+	{
+		*evt_data = malloc(rec->len);
+		if(*evt_data == NULL)
+		{
+			IPACMERR("unable to allocate memory for event data\n");
+			return IPACM_FAILURE;
+		}
+		memcpy(*evt_data, payload, rec->len);
+		return IPACM_SUCCESS;
+	}
+
+	/* copy out to get the netlink message aligned */
+	if(rec->len < sizeof(ipacm_evt_rec_ct) + NLMSG_HDRLEN || rec->len > sizeof(nl_buf))
+	{
+		return IPACM_FAILURE;
+	}
+	memcpy(nl_buf, payload, rec->len);
+	rec_ct = (ipacm_evt_rec_ct *)nl_buf;
+	nlh = (struct nlmsghdr *)rec_ct->nlh;
+	if(nlh->nlmsg_len > rec->len - sizeof(ipacm_evt_rec_ct))
+	{
+		return IPACM_FAILURE;
+	}
+
+	ct_data = (ipacm_ct_evt_data *)malloc(sizeof(ipacm_ct_evt_data));
+	if(ct_data == NULL)
+	{
+		IPACMERR("unable to allocate memory for ct data\n");
+		return IPACM_FAILURE;
+	}
+	ct_data->type = (enum nf_conntrack_msg_type)rec_ct->type;
+	ct_data->ct = nfct_new();
+	if(ct_data->ct == NULL || nfct_nlmsg_parse(nlh, ct_data->ct) < 0)
+	{
+		IPACMERR("unable to rebuild conntrack entry\n");
+		if(ct_data->ct != NULL)
+		{
+			nfct_destroy(ct_data->ct);
+		}
+		free(ct_data);
+		return IPACM_FAILURE;
+	}
+
+	*evt_data = ct_data;
+	return IPACM_SUCCESS;
+}
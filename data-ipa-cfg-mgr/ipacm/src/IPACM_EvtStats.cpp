@@ -0,0 +1,426 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_EvtStats.cpp
+
+	@brief
+	This file implements the IPACM event latency statistics and the
+	local stats socket.
+
+	@Author
+
+*/
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include "IPACM_EvtStats.h"
+#include "IPACM_CmdQueue.h"
+#include "IPACM_Config.h"
+#include "IPACM_V6FlowTable.h"
+#include "IPACM_Neighbor.h"
+#include "IPACM_DriverMsg.h"
+#include "IPACM_Startup.h"
+#include "IPACM_HdlBatch.h"
+#include "IPACM_Log.h"
+
+#define IPACM_STATS_LINE_LEN 2048
+
+extern pthread_mutex_t mutex;
+extern uint32_t ipacm_event_stats[IPACM_EVENT_MAX];
+
+ipacm_evt_stat IPACM_EvtStats::stats[IPACM_EVENT_MAX];
+pthread_mutex_t IPACM_EvtStats::stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+uint32_t IPACM_EvtStats::ct_received[IPACM_CT_STAT_MAX];
+uint32_t IPACM_EvtStats::ct_ignored[IPACM_CT_STAT_MAX];
+
+int IPACM_Histogram::bucket_index(uint64_t usec)
+{
+	int msb = 0;
+
+	if(usec < IPACM_HIST_SUB_BUCKETS)
+	{
+		return (int)usec;
+	}
+
+	if(usec > 0xFFFFFFFF)
+	{
+		usec = 0xFFFFFFFF;
+	}
+
+	msb = 31 - __builtin_clz((uint32_t)usec);
+	return ((msb - IPACM_HIST_SUB_SHIFT + 1) << IPACM_HIST_SUB_SHIFT) +
+		(int)((usec >> (msb - IPACM_HIST_SUB_SHIFT)) & (IPACM_HIST_SUB_BUCKETS - 1));
+}
+
+uint64_t IPACM_Histogram::bucket_low(int idx)
+{
+	int msb;
+
+	if(idx < IPACM_HIST_SUB_BUCKETS)
+	{
+		return idx;
+	}
+
+	msb = (idx >> IPACM_HIST_SUB_SHIFT) + IPACM_HIST_SUB_SHIFT - 1;
+	return (uint64_t)(IPACM_HIST_SUB_BUCKETS + (idx & (IPACM_HIST_SUB_BUCKETS - 1)))
+		<< (msb - IPACM_HIST_SUB_SHIFT);
+}
+
+void IPACM_Histogram::record(uint64_t usec)
+{
+	buckets[bucket_index(usec)]++;
+	count++;
+	sum += usec;
+	if(usec > max)
+	{
+		max = usec;
+	}
+}
+
+/* upper bound of the bucket holding the given percentile */
+uint64_t IPACM_Histogram::percentile(int pct)
+{
+	uint64_t target, seen = 0;
+	int idx;
+
+	if(count == 0)
+	{
+		return 0;
+	}
+
+	target = (count * pct + 99) / 100;
+	for(idx = 0; idx < IPACM_HIST_BUCKETS; idx++)
+	{
+		seen += buckets[idx];
+		if(seen >= target)
+		{
+			break;
+		}
+	}
+
+	if(idx >= IPACM_HIST_BUCKETS - 1)
+	{
+		return max;
+	}
+
+	target = bucket_low(idx + 1) - 1;
+	return (target < max) ? target : max;
+}
+
+int IPACM_Histogram::dump(char *buf, int len)
+{
+	int idx, off;
+
+	off = snprintf(buf, len, "count=%llu avg=%llu p50=%llu p90=%llu p99=%llu max=%llu\n",
+		(unsigned long long)count,
+		(unsigned long long)(count ? sum / count : 0),
+		(unsigned long long)percentile(50),
+		(unsigned long long)percentile(90),
+		(unsigned long long)percentile(99),
+		(unsigned long long)max);
+
+	for(idx = 0; idx < IPACM_HIST_BUCKETS && off < len; idx++)
+	{
+		if(buckets[idx] == 0)
+		{
+			continue;
+		}
+		off += snprintf(buf + off, len - off, " [%llu]=%u",
+			(unsigned long long)bucket_low(idx), buckets[idx]);
+	}
+
+	if(off < len)
+	{
+		off += snprintf(buf + off, len - off, "\n");
+	}
+
+	return (off < len) ? off : len - 1;
+}
+
+uint64_t IPACM_EvtStats::now_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint64_t IPACM_EvtStats::elapsed_usec(const struct timespec *since)
+{
+	uint64_t start = (uint64_t)since->tv_sec * 1000000 + since->tv_nsec / 1000;
+	uint64_t now = now_usec();
+
+	return (now > start) ? now - start : 0;
+}
+
+void IPACM_EvtStats::record_queue_delay(ipa_cm_event_id event, const struct timespec *enq_ts)
+{
+	uint64_t delay;
+
+	if(event >= IPACM_EVENT_MAX || enq_ts->tv_sec == 0)
+	{
+		return;
+	}
+
+	delay = elapsed_usec(enq_ts);
+	pthread_mutex_lock(&stats_mutex);
+	stats[event].queue_delay.record(delay);
+	pthread_mutex_unlock(&stats_mutex);
+}
+
+void IPACM_EvtStats::record_handler(ipa_cm_event_id event, const char *listener, uint64_t start_usec)
+{
+	uint64_t duration, now = now_usec();
+
+	if(event >= IPACM_EVENT_MAX)
+	{
+		return;
+	}
+
+	duration = (now > start_usec) ? now - start_usec : 0;
+	pthread_mutex_lock(&stats_mutex);
+	stats[event].handler.record(duration);
+	if(duration >= stats[event].slowest_usec)
+	{
+		stats[event].slowest_usec = duration;
+		strlcpy(stats[event].slowest_listener, listener, sizeof(stats[event].slowest_listener));
+	}
+	pthread_mutex_unlock(&stats_mutex);
+}
+
+static int ipacm_stats_write(int fd, const char *buf, int len)
+{
+	int ret, off = 0;
+
+	while(off < len)
+	{
+		/* a client that went away must not raise SIGPIPE in the daemon */
+		ret = send(fd, buf + off, len - off, MSG_NOSIGNAL);
+		if(ret < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			if(errno == EPIPE || errno == ECONNRESET)
+			{
+				IPACMDBG("stats client disconnected\n");
+			}
+			else
+			{
+				IPACMERR("unable to write stats (%s)\n", strerror(errno));
+			}
+			return IPACM_FAILURE;
+		}
+		off += ret;
+	}
+
+	return IPACM_SUCCESS;
+}
+
+int IPACM_EvtStats::ct_stat_index(uint8_t l4proto)
+{
+	if(l4proto == IPPROTO_TCP)
+	{
+		return IPACM_CT_STAT_TCP;
+	}
+	if(l4proto == IPPROTO_UDP)
+	{
+		return IPACM_CT_STAT_UDP;
+	}
+	return IPACM_CT_STAT_OTHER;
+}
+
+/* called from the conntrack netlink threads, hence atomics */
+void IPACM_EvtStats::record_ct_event(uint8_t l4proto)
+{
+	__sync_fetch_and_add(&ct_received[ct_stat_index(l4proto)], 1);
+}
+
+void IPACM_EvtStats::record_ct_ignored(uint8_t l4proto)
+{
+	__sync_fetch_and_add(&ct_ignored[ct_stat_index(l4proto)], 1);
+}
+
+void IPACM_EvtStats::dump(int fd)
+{
+	char buf[IPACM_STATS_LINE_LEN];
+	ipacm_evt_stat snapshot;
+	int evt, len, depth_internal = 0, depth_external = 0;
+	IPACM_Config *cfg = IPACM_Config::GetInstance();
+
+	if(pthread_mutex_lock(&mutex) == 0)
+	{
+		depth_internal = MessageQueue::getInstanceInternal()->getDepth();
+		depth_external = MessageQueue::getInstanceExternal()->getDepth();
+		pthread_mutex_unlock(&mutex);
+	}
+
+	len = snprintf(buf, sizeof(buf), "queue internal depth=%d\nqueue external depth=%d\n",
+		depth_internal, depth_external);
+	len += snprintf(buf + len, sizeof(buf) - len,
+		"conntrack tcp received=%u ignored=%u\nconntrack udp received=%u ignored=%u\n"
+		"conntrack other received=%u ignored=%u\n",
+		ct_received[IPACM_CT_STAT_TCP], ct_ignored[IPACM_CT_STAT_TCP],
+		ct_received[IPACM_CT_STAT_UDP], ct_ignored[IPACM_CT_STAT_UDP],
+		ct_received[IPACM_CT_STAT_OTHER], ct_ignored[IPACM_CT_STAT_OTHER]);
+	if(ipacm_stats_write(fd, buf, len) != IPACM_SUCCESS)
+	{
+		return;
+	}
+
+	len = IPACM_V6FlowTable::dump(buf, sizeof(buf));
+	if(ipacm_stats_write(fd, buf, len) != IPACM_SUCCESS)
+	{
+		return;
+	}
+
+	len = IPACM_Neighbor::dump(buf, sizeof(buf));
+	if(ipacm_stats_write(fd, buf, len) != IPACM_SUCCESS)
+	{
+		return;
+	}
+
+	len = IPACM_DriverMsg::dump(buf, sizeof(buf));
+	if(ipacm_stats_write(fd, buf, len) != IPACM_SUCCESS)
+	{
+		return;
+	}
+
+	len = IPACM_Startup::dump(buf, sizeof(buf));
+	if(ipacm_stats_write(fd, buf, len) != IPACM_SUCCESS)
+	{
+		return;
+	}
+
+	len = IPACM_HdlBatch::dump(buf, sizeof(buf));
+	if(ipacm_stats_write(fd, buf, len) != IPACM_SUCCESS)
+	{
+		return;
+	}
+
+	for(evt = 0; evt < IPACM_EVENT_MAX; evt++)
+	{
+		pthread_mutex_lock(&stats_mutex);
+		memcpy(&snapshot, &stats[evt], sizeof(snapshot));
+		pthread_mutex_unlock(&stats_mutex);
+
+		if(snapshot.queue_delay.count == 0 && snapshot.handler.count == 0)
+		{
+			continue;
+		}
+
+		len = snprintf(buf, sizeof(buf), "event %s dispatched=%u slowest=%s(%llu us)\n",
+			cfg ? cfg->getEventName((ipa_cm_event_id)evt) : "unknown",
+			ipacm_event_stats[evt], snapshot.slowest_listener,
+			(unsigned long long)snapshot.slowest_usec);
+		len += snprintf(buf + len, sizeof(buf) - len, "  queue_delay_us ");
+		len += snapshot.queue_delay.dump(buf + len, sizeof(buf) - len);
+		if(len < (int)sizeof(buf))
+		{
+			len += snprintf(buf + len, sizeof(buf) - len, "  handler_us ");
+			len += snapshot.handler.dump(buf + len, sizeof(buf) - len);
+		}
+		if(len >= (int)sizeof(buf))
+		{
+			len = sizeof(buf) - 1;
+		}
+
+		if(ipacm_stats_write(fd, buf, len) != IPACM_SUCCESS)
+		{
+			return;
+		}
+	}
+}
+
+/* Each connection on the stats socket gets one text dump */
+void* IPACM_EvtStats::stats_server(void *param)
+{
+	int fd, cfd;
+	struct sockaddr_un addr;
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0)
+	{
+		PERROR("unable to create stats socket");
+		return NULL;
+	}
+
+	if(fcntl(fd, F_SETFD, FD_CLOEXEC) < 0)
+	{
+		IPACMERR("Couldn't set stats socket close on exec\n");
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strlcpy(addr.sun_path, IPACM_STATS_SOCKET, sizeof(addr.sun_path));
+	unlink(IPACM_STATS_SOCKET);
+
+	if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+	{
+		IPACMERR("unable to bind %s (%s)\n", IPACM_STATS_SOCKET, strerror(errno));
+		close(fd);
+		return NULL;
+	}
+	chmod(IPACM_STATS_SOCKET, 0660);
+
+	if(listen(fd, 2) < 0)
+	{
+		IPACMERR("unable to listen on %s (%s)\n", IPACM_STATS_SOCKET, strerror(errno));
+		close(fd);
+		return NULL;
+	}
+	IPACMDBG_H("serving event stats on %s\n", IPACM_STATS_SOCKET);
+
+	while(1)
+	{
+		cfd = accept(fd, NULL, NULL);
+		if(cfd < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			IPACMERR("stats socket accept failed (%s)\n", strerror(errno));
+			break;
+		}
+
+		dump(cfd);
+		close(cfd);
+	}
+
+	close(fd);
+	return NULL;
+}
@@ -196,15 +196,20 @@ bool IPACM_Filtering::DeleteFilteringHdls
 (
 	 uint32_t *flt_rule_hdls,
 	 ipa_ip_type ip,
-	 uint8_t num_rules
+	 int num_rules
 )
 {
 	struct ipa_ioc_del_flt_rule *flt_rule;
 	bool res = true;
-	int len = 0, cnt = 0;
-        const uint8_t UNIT_RULES = 1;
+	int len = 0, cnt = 0, batch = 0, i;
 
-	len = (sizeof(struct ipa_ioc_del_flt_rule)) + (UNIT_RULES * sizeof(struct ipa_flt_rule_del));
+	if (num_rules <= 0)
+	{
+		return res;
+	}
+
+	batch = (num_rules < IPA_MAX_DEL_HDLS) ? num_rules : IPA_MAX_DEL_HDLS;
+	len = (sizeof(struct ipa_ioc_del_flt_rule)) + (batch * sizeof(struct ipa_flt_rule_del));
 	flt_rule = (struct ipa_ioc_del_flt_rule *)malloc(len);
 	if (flt_rule == NULL)
 	{
@@ -212,45 +217,53 @@ bool IPACM_Filtering::DeleteFilteringHdls
 		return false;
 	}
 
-	for (cnt = 0; cnt < num_rules; cnt++)
+	/* num_hdls is 8 bits wide in the ioctl, so large sets go in chunks,
+	   each deleted with a single ioctl and committed once */
+	while (cnt < num_rules)
 	{
-	    memset(flt_rule, 0, len);
-	    flt_rule->commit = 1;
-	    flt_rule->num_hdls = UNIT_RULES;
-	    flt_rule->ip = ip;
-
-	    if (flt_rule_hdls[cnt] == 0)
-	    {
-		   IPACMERR("invalid filter handle passed, ignoring it: %d\n", cnt)
-	    }
-            else
-	    {
-
-		   flt_rule->hdl[0].status = -1;
-		   flt_rule->hdl[0].hdl = flt_rule_hdls[cnt];
-		   IPACMDBG("Deleting filter hdl:(0x%x) with ip type: %d\n", flt_rule_hdls[cnt], ip);
-
-	           if (DeleteFilteringRule(flt_rule) == false)
-	           {
-		        PERROR("Filter rule deletion failed!\n");
-		        res = false;
-		        goto fail;
-	           }
-		   else
-	           {
-
-		        if (flt_rule->hdl[0].status != 0)
-		        {
-			     IPACMERR("Filter rule hdl 0x%x deletion failed with error:%d\n",
-		        					 flt_rule->hdl[0].hdl, flt_rule->hdl[0].status);
-			     res = false;
-			     goto fail;
-		        }
-		   }
-	    }
+		memset(flt_rule, 0, len);
+		flt_rule->commit = 1;
+		flt_rule->ip = ip;
+
+		while (cnt < num_rules && flt_rule->num_hdls < batch)
+		{
+			if (flt_rule_hdls[cnt] == 0)
+			{
+				IPACMERR("invalid filter handle passed, ignoring it: %d\n", cnt)
+			}
+			else
+			{
+				flt_rule->hdl[flt_rule->num_hdls].status = -1;
+				flt_rule->hdl[flt_rule->num_hdls].hdl = flt_rule_hdls[cnt];
+				IPACMDBG("Deleting filter hdl:(0x%x) with ip type: %d\n", flt_rule_hdls[cnt], ip);
+				flt_rule->num_hdls++;
+			}
+			cnt++;
+		}
+
+		if (flt_rule->num_hdls == 0)
+		{
+			continue;
+		}
+
+		if (DeleteFilteringRule(flt_rule) == false)
+		{
+			PERROR("Filter rule deletion failed!\n");
+			res = false;
+			continue;
+		}
+
+		for (i = 0; i < flt_rule->num_hdls; i++)
+		{
+			if (flt_rule->hdl[i].status != 0)
+			{
+				IPACMERR("Filter rule hdl 0x%x deletion failed with error:%d\n",
+								 flt_rule->hdl[i].hdl, flt_rule->hdl[i].status);
+				res = false;
+			}
+		}
 	}
 
-fail:
 	free(flt_rule);
 
 	return res;
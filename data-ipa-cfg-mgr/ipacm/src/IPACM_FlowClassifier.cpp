@@ -0,0 +1,479 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_FlowClassifier.cpp
+
+	@brief
+	This file implements the classifier deciding which conntrack flows
+	are NAT offload candidates: alg ports, private subnets, nat and non
+	nat clients and nat ifaces, compiled from IPACM_Config and the
+	conntrack listener state.
+
+	@Author
+
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include "IPACM_FlowClassifier.h"
+#include "IPACM_Config.h"
+#include "IPACM_EvtStats.h"
+#include "IPACM_Log.h"
+
+ipacm_flow_cls *IPACM_FlowClassifier::current = NULL;
+int IPACM_FlowClassifier::phase = 0;
+int IPACM_FlowClassifier::readers[2] = {0, 0};
+pthread_mutex_t IPACM_FlowClassifier::update_lock = PTHREAD_MUTEX_INITIALIZER;
+uint32_t *IPACM_FlowClassifier::nat_clients = NULL;
+uint32_t *IPACM_FlowClassifier::nonnat_clients = NULL;
+int IPACM_FlowClassifier::num_clients = 0;
+
+static inline int cls_proto_index(uint8_t proto)
+{
+	if(proto == IPPROTO_TCP)
+	{
+		return IPACM_CLS_PROTO_TCP;
+	}
+	if(proto == IPPROTO_UDP)
+	{
+		return IPACM_CLS_PROTO_UDP;
+	}
+	return -1;
+}
+
+static inline uint32_t cls_client_hash(uint32_t addr)
+{
+	return (addr * 2654435761U) >> (32 - IPACM_CLS_CLIENT_SHIFT);
+}
+
+ipacm_flow_cls* IPACM_FlowClassifier::ReadLock(int *ph)
+{
+	int p;
+
+	while(1)
+	{
+		p = __atomic_load_n(&phase, __ATOMIC_SEQ_CST);
+		__sync_fetch_and_add(&readers[p], 1);
+		if(__atomic_load_n(&phase, __ATOMIC_SEQ_CST) == p)
+		{
+			break;
+		}
+		/* raced with a writer, join the new phase */
+		__sync_fetch_and_sub(&readers[p], 1);
+	}
+
+	*ph = p;
+	return __atomic_load_n(&current, __ATOMIC_SEQ_CST);
+}
+
+void IPACM_FlowClassifier::ReadUnlock(int ph)
+{
+	__sync_fetch_and_sub(&readers[ph], 1);
+}
+
+/* Swap in the new snapshot, free the old one once no reader can still
+   hold it. Caller holds update_lock. */
+void IPACM_FlowClassifier::Publish(ipacm_flow_cls *cls)
+{
+	ipacm_flow_cls *old;
+	int ph;
+
+	old = __atomic_exchange_n(&current, cls, __ATOMIC_SEQ_CST);
+	if(old == NULL)
+	{
+		return;
+	}
+
+	ph = __atomic_load_n(&phase, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&phase, ph ^ 1, __ATOMIC_SEQ_CST);
+	while(__atomic_load_n(&readers[ph], __ATOMIC_SEQ_CST) != 0)
+	{
+		sched_yield();
+	}
+	free(old);
+}
+
+void IPACM_FlowClassifier::BuildConfig(ipacm_flow_cls *cls)
+{
+	IPACM_Config *cfg = IPACM_Config::GetInstance();
+	uint32_t addr, mask;
+	int i, j, g, idx, cnt;
+
+	if(cfg == NULL)
+	{
+		IPACMERR("Unable to get Config instance\n");
+		return;
+	}
+
+	for(i = 0; i < cfg->ipa_num_alg_ports; i++)
+	{
+		idx = cls_proto_index(cfg->alg_table[i].protocol);
+		if(idx < 0)
+		{
+			IPACMDBG_H("alg port %d of protocol %d is never offloaded, skip\n",
+				cfg->alg_table[i].port, cfg->alg_table[i].protocol);
+			continue;
+		}
+		cls->alg_port_map[idx][cfg->alg_table[i].port >> 5] |= (1U << (cfg->alg_table[i].port & 31));
+	}
+
+	/* group the subnets by mask, longest first */
+	cls->num_mask = 0;
+	for(i = 0; i < cfg->ipa_num_private_subnet && i < IPA_MAX_PRIVATE_SUBNET_ENTRIES; i++)
+	{
+		mask = cfg->private_subnet_table[i].subnet_mask;
+		for(g = 0; g < cls->num_mask; g++)
+		{
+			if(cls->mask[g] == mask)
+			{
+				break;
+			}
+		}
+		if(g == cls->num_mask)
+		{
+			for(; g > 0 && cls->mask[g - 1] < mask; g--)
+			{
+				cls->mask[g] = cls->mask[g - 1];
+			}
+			cls->mask[g] = mask;
+			cls->num_mask++;
+		}
+	}
+
+	cnt = 0;
+	for(g = 0; g < cls->num_mask; g++)
+	{
+		cls->mask_first[g] = cnt;
+		for(i = 0; i < cfg->ipa_num_private_subnet && i < IPA_MAX_PRIVATE_SUBNET_ENTRIES; i++)
+		{
+			if(cfg->private_subnet_table[i].subnet_mask != cls->mask[g])
+			{
+				continue;
+			}
+			addr = cfg->private_subnet_table[i].subnet_addr & cls->mask[g];
+			for(j = cnt; j > cls->mask_first[g] && cls->subnet[j - 1] > addr; j--)
+			{
+				cls->subnet[j] = cls->subnet[j - 1];
+			}
+			cls->subnet[j] = addr;
+			cnt++;
+		}
+		cls->mask_cnt[g] = cnt - cls->mask_first[g];
+	}
+
+	cls->num_nat_iface = 0;
+	cnt = cfg->GetNatIfacesCnt();
+	if(cnt > cfg->ipa_num_ipa_interfaces)
+	{
+		cnt = cfg->ipa_num_ipa_interfaces;
+	}
+	for(i = 0; i < cnt && cls->num_nat_iface < IPA_MAX_IFACE_ENTRIES; i++)
+	{
+		if(cfg->pNatIfaces == NULL || cfg->pNatIfaces[i].iface_name[0] == '\0')
+		{
+			continue;
+		}
+		idx = cls->num_nat_iface++;
+		memcpy(cls->nat_iface_name[idx], cfg->pNatIfaces[i].iface_name, IPA_IFACE_NAME_LEN);
+		cls->nat_iface_name[idx][IPA_IFACE_NAME_LEN - 1] = '\0';
+		cls->nat_ifindex[idx] = if_nametoindex(cls->nat_iface_name[idx]);
+	}
+}
+
+void IPACM_FlowClassifier::AddClient(ipacm_flow_cls *cls, uint32_t addr, ipacm_flow_class type)
+{
+	uint32_t slot = cls_client_hash(addr);
+	int probe;
+
+	for(probe = 0; probe < IPACM_CLS_CLIENT_SLOTS; probe++)
+	{
+		if(cls->client_addr[slot] == 0 || cls->client_addr[slot] == addr)
+		{
+			/* a nat client wins over the same address on a non nat iface */
+			if(cls->client_addr[slot] == 0 || type < cls->client_type[slot])
+			{
+				cls->client_type[slot] = type;
+			}
+			cls->client_addr[slot] = addr;
+			return;
+		}
+		slot = (slot + 1) & (IPACM_CLS_CLIENT_SLOTS - 1);
+	}
+	IPACMERR("client set full, 0x%x not classified\n", addr);
+}
+
+void IPACM_FlowClassifier::BuildClients(ipacm_flow_cls *cls)
+{
+	int i;
+
+	memset(cls->client_addr, 0, sizeof(cls->client_addr));
+	memset(cls->client_type, 0, sizeof(cls->client_type));
+	for(i = 0; i < num_clients; i++)
+	{
+		if(nat_clients[i] != 0)
+		{
+			AddClient(cls, nat_clients[i], IPACM_FLOW_NAT_CLIENT);
+		}
+		if(nonnat_clients[i] != 0)
+		{
+			AddClient(cls, nonnat_clients[i], IPACM_FLOW_NONNAT_CLIENT);
+		}
+	}
+}
+
+void IPACM_FlowClassifier::Rebuild(void)
+{
+	ipacm_flow_cls *cls;
+	int num_mask, num_nat_iface;
+	uint64_t start_usec = IPACM_EvtStats::now_usec();
+
+	cls = (ipacm_flow_cls *)calloc(1, sizeof(ipacm_flow_cls));
+	if(cls == NULL)
+	{
+		IPACMERR("unable to allocate flow classifier, keep the old one\n");
+		return;
+	}
+
+	pthread_mutex_lock(&update_lock);
+	BuildConfig(cls);
+	BuildClients(cls);
+	num_mask = cls->num_mask;
+	num_nat_iface = cls->num_nat_iface;
+	Publish(cls);
+	pthread_mutex_unlock(&update_lock);
+
+	IPACMDBG_H("flow classifier rebuilt: %d subnet masks, %d nat ifaces, %llu us\n",
+		num_mask, num_nat_iface,
+		(unsigned long long)(IPACM_EvtStats::now_usec() - start_usec));
+}
+
+void IPACM_FlowClassifier::SetClients(const uint32_t *nat_addr, const uint32_t *nonnat_addr, int cnt)
+{
+	ipacm_flow_cls *cls;
+	uint32_t *nat_copy, *nonnat_copy;
+
+	cls = (ipacm_flow_cls *)malloc(sizeof(ipacm_flow_cls));
+	if(cls == NULL)
+	{
+		IPACMERR("unable to allocate flow classifier, keep the old one\n");
+		return;
+	}
+
+	pthread_mutex_lock(&update_lock);
+	if(cnt != num_clients)
+	{
+		nat_copy = (uint32_t *)realloc(nat_clients, sizeof(uint32_t) * cnt);
+		if(nat_copy != NULL)
+		{
+			nat_clients = nat_copy;
+		}
+		nonnat_copy = (uint32_t *)realloc(nonnat_clients, sizeof(uint32_t) * cnt);
+		if(nonnat_copy != NULL)
+		{
+			nonnat_clients = nonnat_copy;
+		}
+		if(nat_copy == NULL || nonnat_copy == NULL)
+		{
+			IPACMERR("unable to allocate client list, keep the old one\n");
+			pthread_mutex_unlock(&update_lock);
+			free(cls);
+			return;
+		}
+		num_clients = cnt;
+	}
+	memcpy(nat_clients, nat_addr, sizeof(uint32_t) * cnt);
+	memcpy(nonnat_clients, nonnat_addr, sizeof(uint32_t) * cnt);
+
+	/* only the writer replaces current, the config part can be copied */
+	if(current != NULL)
+	{
+		memcpy(cls, current, sizeof(ipacm_flow_cls));
+	}
+	else
+	{
+		memset(cls, 0, sizeof(ipacm_flow_cls));
+		BuildConfig(cls);
+	}
+	BuildClients(cls);
+	Publish(cls);
+	pthread_mutex_unlock(&update_lock);
+}
+
+ipacm_flow_class IPACM_FlowClassifier::FindClient(const ipacm_flow_cls *cls, uint32_t addr)
+{
+	uint32_t slot;
+	int probe;
+
+	if(addr == 0)
+	{
+		return IPACM_FLOW_NONE;
+	}
+
+	slot = cls_client_hash(addr);
+	for(probe = 0; probe < IPACM_CLS_CLIENT_SLOTS && cls->client_addr[slot] != 0; probe++)
+	{
+		if(cls->client_addr[slot] == addr)
+		{
+			return (ipacm_flow_class)cls->client_type[slot];
+		}
+		slot = (slot + 1) & (IPACM_CLS_CLIENT_SLOTS - 1);
+	}
+	return IPACM_FLOW_NONE;
+}
+
+bool IPACM_FlowClassifier::MatchSubnet(const ipacm_flow_cls *cls, uint32_t addr)
+{
+	int g, lo, hi, mid;
+	uint32_t key;
+
+	for(g = 0; g < cls->num_mask; g++)
+	{
+		key = addr & cls->mask[g];
+		lo = cls->mask_first[g];
+		hi = lo + cls->mask_cnt[g];
+		while(lo < hi)
+		{
+			mid = (lo + hi) >> 1;
+			if(cls->subnet[mid] < key)
+			{
+				lo = mid + 1;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+		if(lo < cls->mask_first[g] + cls->mask_cnt[g] && cls->subnet[lo] == key)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool IPACM_FlowClassifier::IsAlgFlow(uint8_t proto, uint16_t port1, uint16_t port2)
+{
+	ipacm_flow_cls *cls;
+	int ph, idx;
+	bool ret = false;
+
+	idx = cls_proto_index(proto);
+	if(idx < 0)
+	{
+		return false;
+	}
+
+	cls = ReadLock(&ph);
+	if(cls != NULL)
+	{
+		ret = ((cls->alg_port_map[idx][port1 >> 5] >> (port1 & 31)) |
+			(cls->alg_port_map[idx][port2 >> 5] >> (port2 & 31))) & 1;
+	}
+	ReadUnlock(ph);
+	return ret;
+}
+
+ipacm_flow_class IPACM_FlowClassifier::ClassifyFlow(uint32_t ip1, uint32_t ip2, bool skip_nonnat)
+{
+	ipacm_flow_cls *cls;
+	ipacm_flow_class type1, type2, ret = IPACM_FLOW_NONE;
+	int ph;
+
+	cls = ReadLock(&ph);
+	if(cls == NULL)
+	{
+		ReadUnlock(ph);
+		return IPACM_FLOW_NONE;
+	}
+
+	type1 = FindClient(cls, ip1);
+	type2 = FindClient(cls, ip2);
+	if(type1 == IPACM_FLOW_NAT_CLIENT || type2 == IPACM_FLOW_NAT_CLIENT)
+	{
+		ret = IPACM_FLOW_NAT_CLIENT;
+	}
+	else if(!skip_nonnat &&
+		(type1 == IPACM_FLOW_NONNAT_CLIENT || type2 == IPACM_FLOW_NONNAT_CLIENT))
+	{
+		ret = IPACM_FLOW_NONNAT_CLIENT;
+	}
+	else if(MatchSubnet(cls, ip1) || MatchSubnet(cls, ip2))
+	{
+		ret = IPACM_FLOW_PRIVATE_SUBNET;
+	}
+	ReadUnlock(ph);
+	return ret;
+}
+
+bool IPACM_FlowClassifier::IsNatIface(int if_index)
+{
+	ipacm_flow_cls *cls;
+	char name[IF_NAMESIZE];
+	bool unresolved = false, ret = false;
+	int ph, i;
+
+	cls = ReadLock(&ph);
+	if(cls == NULL)
+	{
+		ReadUnlock(ph);
+		return false;
+	}
+
+	for(i = 0; i < cls->num_nat_iface; i++)
+	{
+		if(cls->nat_ifindex[i] == if_index)
+		{
+			ret = true;
+			break;
+		}
+		if(cls->nat_ifindex[i] == 0)
+		{
+			unresolved = true;
+		}
+	}
+
+	/* nat iface configured before its netdev existed, match by name */
+	if(!ret && unresolved && if_indextoname(if_index, name) != NULL)
+	{
+		for(i = 0; i < cls->num_nat_iface; i++)
+		{
+			if(cls->nat_ifindex[i] == 0 &&
+				strncmp(name, cls->nat_iface_name[i], IPA_IFACE_NAME_LEN) == 0)
+			{
+				ret = true;
+				break;
+			}
+		}
+	}
+	ReadUnlock(ph);
+	return ret;
+}
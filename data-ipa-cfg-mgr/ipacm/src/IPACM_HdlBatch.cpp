@@ -0,0 +1,227 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_HdlBatch.cpp
+
+	@brief
+	This file implements the deferred rule handle delete batch.
+
+	Interface and client teardown used to delete every filter rule,
+	routing rule and header with its own ioctl and commit. Teardown paths
+	now queue the handles they would have deleted and flush them at the
+	end, which costs one ioctl and one commit per handle type and ip type.
+	The batch only holds handles between add() and flush(), it does not
+	know about handles that are still installed.
+
+	@Author
+
+*/
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "IPACM_HdlBatch.h"
+#include "IPACM_Log.h"
+#include "IPACM_Defs.h"
+
+ipacm_hdl_stats IPACM_HdlBatch::stats;
+
+IPACM_HdlBatch::IPACM_HdlBatch(IPACM_Filtering *flt, IPACM_Routing *rt, IPACM_Header *hdr)
+{
+	m_flt = flt;
+	m_rt = rt;
+	m_hdr = hdr;
+	entries = NULL;
+	num_entries = 0;
+	size = 0;
+}
+
+IPACM_HdlBatch::~IPACM_HdlBatch()
+{
+	if(num_entries > 0)
+	{
+		IPACMERR("%d rule handles were never flushed\n", num_entries);
+	}
+	free(entries);
+}
+
+void IPACM_HdlBatch::add(int owner, ipacm_hdl_type type, ipa_ip_type ip, uint32_t hdl)
+{
+	ipacm_hdl_entry *tmp;
+	int new_size;
+
+	if(hdl == 0)
+	{
+		return;
+	}
+
+	if(num_entries == size)
+	{
+		new_size = (size == 0) ? IPACM_HDL_BATCH_INIT_SIZE : 2 * size;
+		tmp = (ipacm_hdl_entry *)realloc(entries, new_size * sizeof(ipacm_hdl_entry));
+		if(tmp == NULL)
+		{
+			/* cannot defer it, delete the handle right away */
+			IPACMERR("unable to grow handle batch, deleting hdl 0x%x now\n", hdl);
+			stats.fallbacks++;
+			if(delete_hdls(type, ip, &hdl, 1))
+			{
+				stats.deleted++;
+			}
+			else
+			{
+				stats.failed++;
+			}
+			return;
+		}
+		entries = tmp;
+		size = new_size;
+	}
+
+	entries[num_entries].owner = owner;
+	entries[num_entries].type = type;
+	entries[num_entries].ip = ip;
+	entries[num_entries].hdl = hdl;
+	num_entries++;
+	stats.queued++;
+}
+
+void IPACM_HdlBatch::add(int owner, ipacm_hdl_type type, ipa_ip_type ip, const uint32_t *hdls, int num)
+{
+	int i;
+
+	for(i = 0; i < num; i++)
+	{
+		add(owner, type, ip, hdls[i]);
+	}
+}
+
+bool IPACM_HdlBatch::delete_hdls(ipacm_hdl_type type, ipa_ip_type ip, uint32_t *hdls, int num)
+{
+	bool ret = false;
+
+	switch(type)
+	{
+	case IPACM_HDL_FLT:
+		ret = m_flt->DeleteFilteringHdls(hdls, ip, num);
+		break;
+	case IPACM_HDL_RT:
+		ret = m_rt->DeleteRoutingHdls(hdls, ip, num);
+		break;
+	case IPACM_HDL_PROC_CTX:
+		ret = m_hdr->DeleteHeaderProcCtxs(hdls, num);
+		break;
+	case IPACM_HDL_HDR:
+		ret = m_hdr->DeleteHeaderHdls(hdls, num);
+		break;
+	default:
+		break;
+	}
+	stats.ioctls += (num + IPA_MAX_DEL_HDLS - 1) / IPA_MAX_DEL_HDLS;
+	return ret;
+}
+
+int IPACM_HdlBatch::flush(int owner)
+{
+	uint32_t *hdls;
+	int type, ip, i, kept, num;
+	int res = IPACM_SUCCESS;
+
+	if(num_entries == 0)
+	{
+		return IPACM_SUCCESS;
+	}
+
+	hdls = (uint32_t *)malloc(num_entries * sizeof(uint32_t));
+	if(hdls == NULL)
+	{
+		IPACMERR("unable to allocate memory for handle flush\n");
+		return IPACM_FAILURE;
+	}
+
+	for(type = 0; type < IPACM_HDL_TYPE_MAX; type++)
+	{
+		for(ip = IPA_IP_v4; ip <= IPA_IP_MAX; ip++)
+		{
+			num = 0;
+			for(i = 0; i < num_entries; i++)
+			{
+				if((owner == IPACM_HDL_OWNER_ANY || entries[i].owner == owner)
+					&& entries[i].type == type && entries[i].ip == ip)
+				{
+					hdls[num++] = entries[i].hdl;
+				}
+			}
+			if(num == 0)
+			{
+				continue;
+			}
+
+			IPACMDBG_H("Delete %d handles of type %d ip %d for owner %d\n", num, type, ip, owner);
+			if(delete_hdls((ipacm_hdl_type)type, (ipa_ip_type)ip, hdls, num) == false)
+			{
+				IPACMERR("Failed to delete handles of type %d ip %d for owner %d\n", type, ip, owner);
+				stats.failures++;
+				stats.failed += num;
+				res = IPACM_FAILURE;
+				continue;
+			}
+			stats.deleted += num;
+		}
+	}
+	free(hdls);
+
+	/* drop the flushed handles, keep everybody else's */
+	kept = 0;
+	for(i = 0; i < num_entries; i++)
+	{
+		if(owner != IPACM_HDL_OWNER_ANY && entries[i].owner != owner)
+		{
+			entries[kept++] = entries[i];
+		}
+	}
+	num_entries = kept;
+
+	return res;
+}
+
+int IPACM_HdlBatch::dump(char *buf, int len)
+{
+	int ret;
+
+	ret = snprintf(buf, len, "rule hdls queued=%llu deleted=%llu failed=%llu ioctls=%llu failures=%u fallbacks=%u\n",
+		(unsigned long long)stats.queued, (unsigned long long)stats.deleted,
+		(unsigned long long)stats.failed, (unsigned long long)stats.ioctls,
+		stats.failures, stats.fallbacks);
+	if(ret >= len)
+	{
+		ret = len - 1;
+	}
+	return ret;
+}
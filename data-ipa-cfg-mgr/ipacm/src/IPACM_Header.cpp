@@ -34,6 +34,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "IPACM_Header.h"
 #include "IPACM_Log.h"
+#include "IPACM_Defs.h"
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -234,3 +235,121 @@ bool IPACM_Header::DeleteHeaderProcCtx(uint32_t hdl)
 	return (ret == 0);
 }
 
+bool IPACM_Header::DeleteHeaderHdls(uint32_t *hdr_hdls, int num_hdls)
+{
+	struct ipa_ioc_del_hdr *pHeaderDescriptor = NULL;
+	bool res = true;
+	int len = 0, cnt = 0, batch = 0, i;
+
+	if (num_hdls <= 0)
+	{
+		return res;
+	}
+
+	batch = (num_hdls < IPA_MAX_DEL_HDLS) ? num_hdls : IPA_MAX_DEL_HDLS;
+	len = (sizeof(struct ipa_ioc_del_hdr)) + (batch * sizeof(struct ipa_hdr_del));
+	pHeaderDescriptor = (struct ipa_ioc_del_hdr *)malloc(len);
+	if (pHeaderDescriptor == NULL)
+	{
+		IPACMERR("Unable to allocate memory for del header\n");
+		return false;
+	}
+
+	while (cnt < num_hdls)
+	{
+		memset(pHeaderDescriptor, 0, len);
+		pHeaderDescriptor->commit = true;
+
+		while (cnt < num_hdls && pHeaderDescriptor->num_hdls < batch)
+		{
+			if (hdr_hdls[cnt] != 0)
+			{
+				pHeaderDescriptor->hdl[pHeaderDescriptor->num_hdls].hdl = hdr_hdls[cnt];
+				pHeaderDescriptor->hdl[pHeaderDescriptor->num_hdls].status = -1;
+				pHeaderDescriptor->num_hdls++;
+			}
+			cnt++;
+		}
+
+		if (pHeaderDescriptor->num_hdls == 0)
+		{
+			continue;
+		}
+
+		IPACMDBG("Deleting %d header hdls\n", pHeaderDescriptor->num_hdls);
+		if (false == DeleteHeader(pHeaderDescriptor))
+		{
+			IPACMERR("Header deletion of %d hdls failed!\n", pHeaderDescriptor->num_hdls);
+			res = false;
+			continue;
+		}
+
+		for (i = 0; i < pHeaderDescriptor->num_hdls; i++)
+		{
+			if (pHeaderDescriptor->hdl[i].status)
+			{
+				IPACMERR("Header hdl:(%x) deletion failed!  status: %d\n",
+								 pHeaderDescriptor->hdl[i].hdl, pHeaderDescriptor->hdl[i].status);
+				res = false;
+			}
+		}
+	}
+
+	free(pHeaderDescriptor);
+
+	return res;
+}
+
+bool IPACM_Header::DeleteHeaderProcCtxs(uint32_t *hdls, int num_hdls)
+{
+	struct ipa_ioc_del_hdr_proc_ctx* pHeaderTable = NULL;
+	bool res = true;
+	int len, ret, cnt = 0, batch = 0;
+
+	if (num_hdls <= 0)
+	{
+		return res;
+	}
+
+	batch = (num_hdls < IPA_MAX_DEL_HDLS) ? num_hdls : IPA_MAX_DEL_HDLS;
+	len = sizeof(struct ipa_ioc_del_hdr_proc_ctx) + batch * sizeof(struct ipa_hdr_proc_ctx_del);
+	pHeaderTable = (struct ipa_ioc_del_hdr_proc_ctx*)malloc(len);
+	if(pHeaderTable == NULL)
+	{
+		IPACMERR("Failed to allocate buffer.\n");
+		return false;
+	}
+
+	while (cnt < num_hdls)
+	{
+		memset(pHeaderTable, 0, len);
+		pHeaderTable->commit = 1;
+
+		while (cnt < num_hdls && pHeaderTable->num_hdls < batch)
+		{
+			if (hdls[cnt] != 0)
+			{
+				pHeaderTable->hdl[pHeaderTable->num_hdls].hdl = hdls[cnt];
+				pHeaderTable->num_hdls++;
+			}
+			cnt++;
+		}
+
+		if (pHeaderTable->num_hdls == 0)
+		{
+			continue;
+		}
+
+		ret = ioctl(m_fd, IPA_IOC_DEL_HDR_PROC_CTX, pHeaderTable);
+		if(ret != 0)
+		{
+			IPACMERR("Failed to delete %d hdr proc ctx: return value %d\n",
+				pHeaderTable->num_hdls, ret);
+			res = false;
+		}
+	}
+
+	free(pHeaderTable);
+	return res;
+}
+
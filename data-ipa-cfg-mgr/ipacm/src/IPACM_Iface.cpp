@@ -57,9 +57,11 @@ IPACM_Routing IPACM_Iface::m_routing;
 IPACM_Filtering IPACM_Iface::m_filtering;
 IPACM_Header IPACM_Iface::m_header;
 
-IPACM_Config *IPACM_Iface::ipacmcfg = IPACM_Config::GetInstance();
+/* set by main() once the configuration parse has finished */
+IPACM_Config *IPACM_Iface::ipacmcfg = NULL;
 
 IPACM_Iface::IPACM_Iface(int iface_index)
+	: hdl_batch(&m_filtering, &m_routing, &m_header)
 {
 	ip_type = IPACM_IP_NULL; /* initially set invalid */
 	num_dft_rt_v6 = 0;
@@ -331,18 +333,14 @@ int IPACM_Iface::iface_ipa_index_query
 	}
 
 	/* Search known linux interface-index and map to IPA interface-index*/
-	for (i = 0; i < IPACM_Iface::ipacmcfg->ipa_num_ipa_interfaces; i++)
+	link = IPACM_Iface::ipacmcfg->GetIfaceByNetlinkIndex(interface_index);
+	if (link != INVALID_IFACE)
 	{
-		if (interface_index == IPACM_Iface::ipacmcfg->iface_table[i].netlink_interface_index)
-		{
-			link = i;
-			IPACMDBG("Interface (%s) found: linux(%d) ipa(%d) \n",
-							 IPACM_Iface::ipacmcfg->iface_table[i].iface_name,
-							 IPACM_Iface::ipacmcfg->iface_table[i].netlink_interface_index,
-							 link);
-			return link;
-			break;
-		}
+		IPACMDBG("Interface (%s) found: linux(%d) ipa(%d) \n",
+						 IPACM_Iface::ipacmcfg->iface_table[link].iface_name,
+						 interface_index,
+						 link);
+		return link;
 	}
 
 	/* Search/Configure linux interface-index and map it to IPA interface-index */
@@ -376,7 +374,7 @@ int IPACM_Iface::iface_ipa_index_query
 							 IPACM_Iface::ipacmcfg->iface_table[i].netlink_interface_index, i);
 
 			link = i;
-			IPACM_Iface::ipacmcfg->iface_table[i].netlink_interface_index = interface_index;
+			IPACM_Iface::ipacmcfg->SetIfaceNetlinkIndex(i, interface_index);
 			break;
 		}
 	}
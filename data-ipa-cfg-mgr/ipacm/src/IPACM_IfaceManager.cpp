@@ -49,7 +49,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <IPACM_Iface.h>
 #include <IPACM_Log.h>
 
-iface_instances *IPACM_IfaceManager::head = NULL;
+IPACM_Iface *IPACM_IfaceManager::instances[IPA_MAX_IFACE_ENTRIES];
 
 IPACM_IfaceManager::IPACM_IfaceManager()
 {
@@ -476,86 +476,42 @@ int IPACM_IfaceManager::create_iface_instance(ipacm_ifacemgr_data *param)
 }
 
 
-int IPACM_IfaceManager::registr(int ipa_if_index, IPACM_Listener *obj)
+int IPACM_IfaceManager::registr(int ipa_if_index, IPACM_Iface *obj)
 {
-	iface_instances *tmp = head,*nw;
-
-	nw = (iface_instances *)malloc(sizeof(iface_instances));
-	if(nw != NULL)
-	{
-		nw->ipa_if_index = ipa_if_index;
-		nw->obj = obj;
-		nw->next = NULL;
-	}
-	else
+	if(ipa_if_index < 0 || ipa_if_index >= IPA_MAX_IFACE_ENTRIES)
 	{
+		IPACMERR("Invalid ipa iface index %d\n", ipa_if_index);
 		return IPACM_FAILURE;
 	}
 
-	if(head == NULL)
-	{
-		head = nw;
-	}
-	else
-	{
-		while(tmp->next)
-		{
-			tmp = tmp->next;
-		}
-		tmp->next = nw;
-	}
+	instances[ipa_if_index] = obj;
 	return IPACM_SUCCESS;
 }
 
-int IPACM_IfaceManager::deregistr(IPACM_Listener *param)
+int IPACM_IfaceManager::deregistr(IPACM_Iface *param)
 {
-	iface_instances *tmp = head,*tmp1,*prev = head;
+	int ipa_if_index = param->ipa_if_num;
 
-	while(tmp != NULL)
+	if(ipa_if_index < 0 || ipa_if_index >= IPA_MAX_IFACE_ENTRIES ||
+		instances[ipa_if_index] != param)
 	{
-		if(tmp->obj == param)
-		{
-			tmp1 = tmp;
-			if(tmp == head)
-			{
-				head = head->next;
-			}
-			else if(tmp->next == NULL)
-			{
-				prev->next = NULL;
-			}
-			else
-			{
-				prev->next = tmp->next;
-			}
-
-			tmp = tmp->next;
-			free(tmp1);
-		}
-		else
-		{
-			prev = tmp;
-			tmp = tmp->next;
-		}
+		IPACMDBG_H("iface-instance %p is not registered at ipa index %d\n", param, ipa_if_index);
+		return IPACM_SUCCESS;
 	}
+
+	instances[ipa_if_index] = NULL;
 	return IPACM_SUCCESS;
 }
 
 
 int IPACM_IfaceManager::SearchInstance(int ipa_if_index)
 {
-
-	iface_instances *tmp = head;
-
-	while(tmp != NULL)
+	if(ipa_if_index >= 0 && ipa_if_index < IPA_MAX_IFACE_ENTRIES &&
+		instances[ipa_if_index] != NULL)
 	{
-		if(ipa_if_index == tmp->ipa_if_index)
-		{
-			IPACMDBG_H("Find existed iface-instance name: %s\n",
-							 IPACM_Iface::ipacmcfg->iface_table[ipa_if_index].iface_name);
-			return IPA_INSTANCE_FOUND;
-		}
-		tmp = tmp->next;
+		IPACMDBG_H("Find existed iface-instance name: %s\n",
+						 IPACM_Iface::ipacmcfg->iface_table[ipa_if_index].iface_name);
+		return IPA_INSTANCE_FOUND;
 	}
 
 	IPACMDBG_H("No existed iface-instance name: %s,\n",
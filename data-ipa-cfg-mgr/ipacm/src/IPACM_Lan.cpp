@@ -851,6 +851,7 @@ int IPACM_Lan::handle_del_ipv6_addr(ipacm_event_data_all *data)
 				}
 			}
 		}
+		IPACM_V6FlowTable::DelRoutedAddr(data->ipv6_addr);
 	}
 	return IPACM_SUCCESS;
 }
@@ -1984,6 +1985,12 @@ int IPACM_Lan::handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptyp
 		}
 		else
 		{
+			/* downlink of these addresses is now routed by IPA */
+			for(v6_num = get_client_memptr(eth_client, eth_index)->route_rule_set_v6;
+				v6_num < get_client_memptr(eth_client, eth_index)->ipv6_set; v6_num++)
+			{
+				IPACM_V6FlowTable::AddRoutedAddr(get_client_memptr(eth_client, eth_index)->v6_addr[v6_num]);
+			}
 			get_client_memptr(eth_client, eth_index)->route_rule_set_v6 = get_client_memptr(eth_client, eth_index)->ipv6_set;
 		}
 	}
@@ -2343,39 +2350,33 @@ int IPACM_Lan::handle_eth_client_down_evt(uint8_t *mac_addr)
 			CtList->HandleNeighIpAddrDelEvt(get_client_memptr(eth_client, clt_indx)->v4_addr);
  	}
 
-	if (delete_eth_rtrules(clt_indx, IPA_IP_v4))
-	{
-		IPACMERR("unbale to delete ecm-client v4 route rules for index: %d\n", clt_indx);
-		return IPACM_FAILURE;
-	}
-
-	if (delete_eth_rtrules(clt_indx, IPA_IP_v6))
-	{
-		IPACMERR("unbale to delete ecm-client v6 route rules for index: %d\n", clt_indx);
-		return IPACM_FAILURE;
-	}
+	/* route rules and headers of the client go in one delete per type */
+	delete_eth_rtrules(clt_indx, IPA_IP_v4, true);
+	delete_eth_rtrules(clt_indx, IPA_IP_v6, true);
 
 	/* Delete eth client header */
 	if(get_client_memptr(eth_client, clt_indx)->ipv4_header_set == true)
 	{
-		if (m_header.DeleteHeaderHdl(get_client_memptr(eth_client, clt_indx)->hdr_hdl_v4)
-				== false)
-		{
-			return IPACM_FAILURE;
-		}
-		get_client_memptr(eth_client, clt_indx)->ipv4_header_set = false;
+		hdl_batch.add(IPACM_HDL_OWNER_CLIENT(clt_indx), IPACM_HDL_HDR, IPA_IP_MAX,
+			get_client_memptr(eth_client, clt_indx)->hdr_hdl_v4);
 	}
 
 	if(get_client_memptr(eth_client, clt_indx)->ipv6_header_set == true)
 	{
-		if (m_header.DeleteHeaderHdl(get_client_memptr(eth_client, clt_indx)->hdr_hdl_v6)
-				== false)
-		{
-			return IPACM_FAILURE;
-		}
-		get_client_memptr(eth_client, clt_indx)->ipv6_header_set = false;
+		hdl_batch.add(IPACM_HDL_OWNER_CLIENT(clt_indx), IPACM_HDL_HDR, IPA_IP_MAX,
+			get_client_memptr(eth_client, clt_indx)->hdr_hdl_v6);
 	}
 
+	/* the client keeps its flags if this fails, so that the next down event
+	   deletes the same handles again */
+	if (hdl_batch.flush(IPACM_HDL_OWNER_CLIENT(clt_indx)))
+	{
+		IPACMERR("unable to delete ecm-client route rules and headers for index: %d\n", clt_indx);
+		return IPACM_FAILURE;
+	}
+	clear_eth_rtrules(clt_indx, IPA_IP_v4);
+	clear_eth_rtrules(clt_indx, IPA_IP_v6);
+
 	/* Reset ip_set to 0*/
 	get_client_memptr(eth_client, clt_indx)->ipv4_set = false;
 	get_client_memptr(eth_client, clt_indx)->ipv6_set = 0;
@@ -2463,26 +2464,12 @@ int IPACM_Lan::handle_down_evt()
 		/* delete full header */
 		if (ipv4_header_set)
 		{
-			if (m_header.DeleteHeaderHdl(ODU_hdr_hdl_v4)
-					== false)
-			{
-					IPACMERR("ODU ipv4 header delete fail\n");
-					res = IPACM_FAILURE;
-					goto fail;
-			}
-			IPACMDBG_H("ODU ipv4 header delete success\n");
+			hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_HDR, IPA_IP_MAX, ODU_hdr_hdl_v4);
 		}
 
 		if (ipv6_header_set)
 		{
-			if (m_header.DeleteHeaderHdl(ODU_hdr_hdl_v6)
-					== false)
-			{
-				IPACMERR("ODU ipv6 header delete fail\n");
-				res = IPACM_FAILURE;
-				goto fail;
-			}
-			IPACMERR("ODU ipv6 header delete success\n");
+			hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_HDR, IPA_IP_MAX, ODU_hdr_hdl_v6);
 		}
 	}
 
@@ -2508,20 +2495,10 @@ int IPACM_Lan::handle_down_evt()
 	/* delete default filter rules */
 	if (ip_type != IPA_IP_v6 && rx_prop != NULL)
 	{
-		if(m_filtering.DeleteFilteringHdls(ipv4_icmp_flt_rule_hdl, IPA_IP_v4, NUM_IPV4_ICMP_FLT_RULE) == false)
-		{
-			IPACMERR("Error Deleting ICMPv4 Filtering Rule, aborting...\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v4, ipv4_icmp_flt_rule_hdl, NUM_IPV4_ICMP_FLT_RULE);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v4, NUM_IPV4_ICMP_FLT_RULE);
 
-		if (m_filtering.DeleteFilteringHdls(dft_v4fl_rule_hdl, IPA_IP_v4, IPV4_DEFAULT_FILTERTING_RULES) == false)
-		{
-			IPACMERR("Error Deleting Filtering Rule, aborting...\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v4, dft_v4fl_rule_hdl, IPV4_DEFAULT_FILTERTING_RULES);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v4, IPV4_DEFAULT_FILTERTING_RULES);
 
 		/* free private-subnet ipv4 filter rules */
@@ -2533,75 +2510,43 @@ int IPACM_Lan::handle_down_evt()
 		}
 
 #ifdef FEATURE_IPA_ANDROID
-		if(m_filtering.DeleteFilteringHdls(private_fl_rule_hdl, IPA_IP_v4, IPA_MAX_PRIVATE_SUBNET_ENTRIES) == false)
-		{
-			IPACMERR("Error deleting private subnet IPv4 flt rules.\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v4, private_fl_rule_hdl, IPA_MAX_PRIVATE_SUBNET_ENTRIES);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v4, IPA_MAX_PRIVATE_SUBNET_ENTRIES);
 #else
-		if (m_filtering.DeleteFilteringHdls(private_fl_rule_hdl, IPA_IP_v4, IPACM_Iface::ipacmcfg->ipa_num_private_subnet) == false)
-		{
-			IPACMERR("Error deleting private subnet IPv4 flt rules.\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v4, private_fl_rule_hdl, IPACM_Iface::ipacmcfg->ipa_num_private_subnet);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v4, IPACM_Iface::ipacmcfg->ipa_num_private_subnet);
 #endif
-		IPACMDBG_H("Deleted private subnet v4 filter rules successfully.\n");
 	}
-	IPACMDBG_H("Finished delete default iface ipv4 filtering rules \n ");
 
 	if (ip_type != IPA_IP_v4 && rx_prop != NULL)
 	{
-		if(m_filtering.DeleteFilteringHdls(ipv6_icmp_flt_rule_hdl, IPA_IP_v6, NUM_IPV6_ICMP_FLT_RULE) == false)
-		{
-			IPACMERR("Error Deleting ICMPv6 Filtering Rule, aborting...\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v6, ipv6_icmp_flt_rule_hdl, NUM_IPV6_ICMP_FLT_RULE);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v6, NUM_IPV6_ICMP_FLT_RULE);
 
-		if (m_filtering.DeleteFilteringHdls(dft_v6fl_rule_hdl, IPA_IP_v6, IPV6_DEFAULT_FILTERTING_RULES) == false)
-		{
-			IPACMERR("Error Adding RuleTable(1) to Filtering, aborting...\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v6, dft_v6fl_rule_hdl, IPV6_DEFAULT_FILTERTING_RULES);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v6, IPV6_DEFAULT_FILTERTING_RULES);
 	}
-	IPACMDBG_H("Finished delete default iface ipv6 filtering rules \n ");
 
 	if (ip_type != IPA_IP_v6)
 	{
-		if (m_routing.DeleteRoutingHdl(dft_rt_rule_hdl[0], IPA_IP_v4)
-				== false)
-		{
-			IPACMERR("Routing rule deletion failed!\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_RT, IPA_IP_v4, dft_rt_rule_hdl[0]);
 	}
-	IPACMDBG_H("Finished delete default iface ipv4 rules \n ");
 
 	/* delete default v6 routing rule */
 	if (ip_type != IPA_IP_v4)
 	{
 		/* may have multiple ipv6 iface-RT rules*/
-		for (i = 0; i < 2*num_dft_rt_v6; i++)
-		{
-			if (m_routing.DeleteRoutingHdl(dft_rt_rule_hdl[MAX_DEFAULT_v4_ROUTE_RULES + i], IPA_IP_v6)
-					== false)
-			{
-				IPACMERR("Routing rule deletion failed!\n");
-				res = IPACM_FAILURE;
-				goto fail;
-			}
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_RT, IPA_IP_v6,
+			&dft_rt_rule_hdl[MAX_DEFAULT_v4_ROUTE_RULES], 2*num_dft_rt_v6);
 	}
 
-	IPACMDBG_H("Finished delete default iface ipv6 rules \n ");
+	/* default filter, routing rules and headers go in one delete per type */
+	if (hdl_batch.flush(IPACM_HDL_OWNER_IFACE))
+	{
+		IPACMERR("Failed to delete default iface rules\n");
+		res = IPACM_FAILURE;
+	}
+	IPACMDBG_H("Finished delete default iface rules \n ");
 
 	/* free the edm clients cache */
 	IPACMDBG_H("Free ecm clients cache\n");
@@ -2646,39 +2591,41 @@ fail:
 			CtList->HandleNeighIpAddrDelEvt(get_client_memptr(eth_client, i)->v4_addr);
 		}
 
-		if (delete_eth_rtrules(i, IPA_IP_v4))
-		{
-			IPACMERR("unbale to delete ecm-client v4 route rules for index %d\n", i);
-			res = IPACM_FAILURE;
-		}
-
-		if (delete_eth_rtrules(i, IPA_IP_v6))
-		{
-			IPACMERR("unbale to delete ecm-client v6 route rules for index %d\n", i);
-			res = IPACM_FAILURE;
-		}
+		delete_eth_rtrules(i, IPA_IP_v4, true);
+		delete_eth_rtrules(i, IPA_IP_v6, true);
 
 		IPACMDBG_H("Delete %d client header\n", num_eth_client);
 
 		if(get_client_memptr(eth_client, i)->ipv4_header_set == true)
 		{
-			if (m_header.DeleteHeaderHdl(get_client_memptr(eth_client, i)->hdr_hdl_v4)
-				== false)
-			{
-				res = IPACM_FAILURE;
-			}
+			hdl_batch.add(IPACM_HDL_OWNER_CLIENT(i), IPACM_HDL_HDR, IPA_IP_MAX,
+				get_client_memptr(eth_client, i)->hdr_hdl_v4);
 		}
 
 		if(get_client_memptr(eth_client, i)->ipv6_header_set == true)
 		{
-			if (m_header.DeleteHeaderHdl(get_client_memptr(eth_client, i)->hdr_hdl_v6)
-					== false)
-			{
-				res = IPACM_FAILURE;
-			}
+			hdl_batch.add(IPACM_HDL_OWNER_CLIENT(i), IPACM_HDL_HDR, IPA_IP_MAX,
+				get_client_memptr(eth_client, i)->hdr_hdl_v6);
 		}
 	} /* end of for loop */
 
+	/* every client (and the iface itself after an early exit) at once */
+	if (hdl_batch.flush(IPACM_HDL_OWNER_ANY))
+	{
+		IPACMERR("unable to delete ecm-client route rules and headers\n");
+		res = IPACM_FAILURE;
+	}
+	else
+	{
+		for (i = 0; i < num_eth_client; i++)
+		{
+			clear_eth_rtrules(i, IPA_IP_v4);
+			clear_eth_rtrules(i, IPA_IP_v6);
+			get_client_memptr(eth_client, i)->ipv4_header_set = false;
+			get_client_memptr(eth_client, i)->ipv6_header_set = false;
+		}
+	}
+
 	/* check software routing fl rule hdl */
 	if (softwarerouting_act == true && rx_prop != NULL)
 	{
@@ -3932,33 +3879,44 @@ end:
 }
 
 /* add routing rule and return handle to lan2lan controller */
-int IPACM_Lan::eth_bridge_add_rt_rule(uint8_t *mac, char *rt_tbl_name, uint32_t hdr_proc_ctx_hdl,
-		ipa_hdr_l2_type peer_l2_hdr_type, ipa_ip_type iptype, uint32_t *rt_rule_hdl, int *rt_rule_count)
+int IPACM_Lan::eth_bridge_add_rt_rule(uint8_t (*mac)[IPA_MAC_ADDR_SIZE], int num_client, char *rt_tbl_name,
+		uint32_t hdr_proc_ctx_hdl, ipa_hdr_l2_type peer_l2_hdr_type, ipa_ip_type iptype, uint32_t *rt_rule_hdl, int *rt_rule_count)
 {
-	int i, len, res = IPACM_SUCCESS;
+	int i, j, len, res = IPACM_SUCCESS;
 	struct ipa_ioc_add_rt_rule* rt_rule_table = NULL;
 	struct ipa_rt_rule_add rt_rule;
-	int position, num_rt_rule;
-
-	IPACMDBG_H("Received client MAC 0x%02x%02x%02x%02x%02x%02x.\n",
-			mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+	int position, num_rt_rule, client_per_ioctl, start, cnt;
 
+	*rt_rule_count = 0;
 	num_rt_rule = each_client_rt_rule_count[iptype];
+	if(num_client <= 0 || num_rt_rule == 0)
+	{
+		return IPACM_SUCCESS;
+	}
+	if(num_rt_rule > MAX_NUM_PROP)
+	{
+		IPACMERR("Number of routing rules %d already exceeds limit.\n", num_rt_rule);
+		return IPACM_FAILURE;
+	}
+	IPACMDBG_H("Add %d routing rules for each of %d clients to table %s.\n", num_rt_rule, num_client, rt_tbl_name);
+
+	/* handles of clients not added stay 0, the delete path skips them */
+	memset(rt_rule_hdl, 0, num_client * num_rt_rule * sizeof(uint32_t));
+	*rt_rule_count = num_rt_rule;
+
+	client_per_ioctl = IPA_ETH_BRIDGE_MAX_RULES_PER_IOCTL / num_rt_rule;
+	if(client_per_ioctl > num_client)
+	{
+		client_per_ioctl = num_client;
+	}
 
-	len = sizeof(ipa_ioc_add_rt_rule) + num_rt_rule * sizeof(ipa_rt_rule_add);
+	len = sizeof(ipa_ioc_add_rt_rule) + client_per_ioctl * num_rt_rule * sizeof(ipa_rt_rule_add);
 	rt_rule_table = (ipa_ioc_add_rt_rule*)malloc(len);
 	if (rt_rule_table == NULL)
 	{
 		IPACMERR("Failed to allocate memory.\n");
 		return IPACM_FAILURE;
 	}
-	memset(rt_rule_table, 0, len);
-
-	rt_rule_table->commit = 1;
-	rt_rule_table->ip = iptype;
-	rt_rule_table->num_rules = num_rt_rule;
-	strlcpy(rt_rule_table->rt_tbl_name, rt_tbl_name, sizeof(rt_rule_table->rt_tbl_name));
-	rt_rule_table->rt_tbl_name[IPA_RESOURCE_NAME_MAX-1] = 0;
 
 	memset(&rt_rule, 0, sizeof(ipa_rt_rule_add));
 	rt_rule.at_rear = false;
@@ -3970,54 +3928,64 @@ int IPACM_Lan::eth_bridge_add_rt_rule(uint8_t *mac, char *rt_tbl_name, uint32_t
 	rt_rule.rule.hdr_hdl = 0;
 	rt_rule.rule.hdr_proc_ctx_hdl = hdr_proc_ctx_hdl;
 
-	position = 0;
-	for(i=0; i<iface_query->num_tx_props; i++)
+	for(start = 0; start < num_client; start += cnt)
 	{
-		if(tx_prop->tx[i].ip == iptype)
+		cnt = num_client - start;
+		if(cnt > client_per_ioctl)
 		{
-			if(position >= num_rt_rule || position >= MAX_NUM_PROP)
-			{
-				IPACMERR("Number of routing rules already exceeds limit.\n");
-				res = IPACM_FAILURE;
-				goto end;
-			}
+			cnt = client_per_ioctl;
+		}
 
-			if(ipa_if_cate == WLAN_IF && IPACM_Iface::ipacmcfg->isMCC_Mode)
-			{
-				IPACMDBG_H("In WLAN MCC mode, use alt dst pipe: %d\n",
-						tx_prop->tx[i].alt_dst_pipe);
-				rt_rule.rule.dst = tx_prop->tx[i].alt_dst_pipe;
-			}
-			else
+		memset(rt_rule_table, 0, len);
+		rt_rule_table->commit = 1;
+		rt_rule_table->ip = iptype;
+		rt_rule_table->num_rules = cnt * num_rt_rule;
+		strlcpy(rt_rule_table->rt_tbl_name, rt_tbl_name, sizeof(rt_rule_table->rt_tbl_name));
+		rt_rule_table->rt_tbl_name[IPA_RESOURCE_NAME_MAX-1] = 0;
+
+		position = 0;
+		for(j = start; j < start + cnt; j++)
+		{
+			IPACMDBG_H("Client MAC 0x%02x%02x%02x%02x%02x%02x.\n",
+					mac[j][0], mac[j][1], mac[j][2], mac[j][3], mac[j][4], mac[j][5]);
+			for(i=0; i<iface_query->num_tx_props; i++)
 			{
-				IPACMDBG_H("It is not WLAN MCC mode, use dst pipe: %d\n",
-						tx_prop->tx[i].dst_pipe);
-				rt_rule.rule.dst = tx_prop->tx[i].dst_pipe;
-			}
+				if(tx_prop->tx[i].ip == iptype)
+				{
+					if(ipa_if_cate == WLAN_IF && IPACM_Iface::ipacmcfg->isMCC_Mode)
+					{
+						IPACMDBG_H("In WLAN MCC mode, use alt dst pipe: %d\n",
+								tx_prop->tx[i].alt_dst_pipe);
+						rt_rule.rule.dst = tx_prop->tx[i].alt_dst_pipe;
+					}
+					else
+					{
+						IPACMDBG_H("It is not WLAN MCC mode, use dst pipe: %d\n",
+								tx_prop->tx[i].dst_pipe);
+						rt_rule.rule.dst = tx_prop->tx[i].dst_pipe;
+					}
 
-			memcpy(&rt_rule.rule.attrib, &tx_prop->tx[i].attrib, sizeof(rt_rule.rule.attrib));
-			if(peer_l2_hdr_type == IPA_HDR_L2_ETHERNET_II)
-				rt_rule.rule.attrib.attrib_mask |= IPA_FLT_MAC_DST_ADDR_ETHER_II;
-			else
-				rt_rule.rule.attrib.attrib_mask |= IPA_FLT_MAC_DST_ADDR_802_3;
-			memcpy(rt_rule.rule.attrib.dst_mac_addr, mac, sizeof(rt_rule.rule.attrib.dst_mac_addr));
-			memset(rt_rule.rule.attrib.dst_mac_addr_mask, 0xFF, sizeof(rt_rule.rule.attrib.dst_mac_addr_mask));
+					memcpy(&rt_rule.rule.attrib, &tx_prop->tx[i].attrib, sizeof(rt_rule.rule.attrib));
+					if(peer_l2_hdr_type == IPA_HDR_L2_ETHERNET_II)
+						rt_rule.rule.attrib.attrib_mask |= IPA_FLT_MAC_DST_ADDR_ETHER_II;
+					else
+						rt_rule.rule.attrib.attrib_mask |= IPA_FLT_MAC_DST_ADDR_802_3;
+					memcpy(rt_rule.rule.attrib.dst_mac_addr, mac[j], sizeof(rt_rule.rule.attrib.dst_mac_addr));
+					memset(rt_rule.rule.attrib.dst_mac_addr_mask, 0xFF, sizeof(rt_rule.rule.attrib.dst_mac_addr_mask));
 
-			memcpy(&(rt_rule_table->rules[position]), &rt_rule, sizeof(rt_rule_table->rules[position]));
-			position++;
+					memcpy(&(rt_rule_table->rules[position]), &rt_rule, sizeof(rt_rule_table->rules[position]));
+					position++;
+				}
+			}
+		}
+		if(false == m_routing.AddRoutingRule(rt_rule_table))
+		{
+			IPACMERR("Routing rule addition failed!\n");
+			res = IPACM_FAILURE;
+			goto end;
 		}
-	}
-	if(false == m_routing.AddRoutingRule(rt_rule_table))
-	{
-		IPACMERR("Routing rule addition failed!\n");
-		res = IPACM_FAILURE;
-		goto end;
-	}
-	else
-	{
-		*rt_rule_count = position;
 		for(i=0; i<position; i++)
-			rt_rule_hdl[i] = rt_rule_table->rules[i].rt_rule_hdl;
+			rt_rule_hdl[start * num_rt_rule + i] = rt_rule_table->rules[i].rt_rule_hdl;
 	}
 
 end:
@@ -4128,9 +4096,11 @@ end:
 	return res;
 }
 
-int IPACM_Lan::eth_bridge_add_flt_rule(uint8_t *mac, uint32_t rt_tbl_hdl, ipa_ip_type iptype, uint32_t *flt_rule_hdl)
+int IPACM_Lan::eth_bridge_add_flt_rule(uint8_t (*mac)[IPA_MAC_ADDR_SIZE], int num_client, uint32_t rt_tbl_hdl,
+		ipa_ip_type iptype, uint32_t *flt_rule_hdl)
 {
-	int len, res = IPACM_SUCCESS;
+	int i, len, res = IPACM_SUCCESS;
+	int client_per_ioctl, start, cnt;
 	struct ipa_flt_rule_add flt_rule_entry;
 	struct ipa_ioc_add_flt_rule_after *pFilteringTable = NULL;
 
@@ -4140,24 +4110,25 @@ int IPACM_Lan::eth_bridge_add_flt_rule(uint8_t *mac, uint32_t rt_tbl_hdl, ipa_ip
 		IPACMDBG_H("No rx or tx properties registered for iface %s\n", dev_name);
 		return IPACM_FAILURE;
 	}
+	if (num_client <= 0)
+	{
+		return IPACM_SUCCESS;
+	}
+	memset(flt_rule_hdl, 0, num_client * sizeof(uint32_t));
 
-	IPACMDBG_H("Received client MAC 0x%02x%02x%02x%02x%02x%02x.\n", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+	client_per_ioctl = IPA_ETH_BRIDGE_MAX_RULES_PER_IOCTL;
+	if(client_per_ioctl > num_client)
+	{
+		client_per_ioctl = num_client;
+	}
 
-	len = sizeof(struct ipa_ioc_add_flt_rule_after) + sizeof(struct ipa_flt_rule_add);
+	len = sizeof(struct ipa_ioc_add_flt_rule_after) + client_per_ioctl * sizeof(struct ipa_flt_rule_add);
 	pFilteringTable = (struct ipa_ioc_add_flt_rule_after*)malloc(len);
 	if (!pFilteringTable)
 	{
 		IPACMERR("Failed to allocate ipa_ioc_add_flt_rule_after memory...\n");
 		return IPACM_FAILURE;
 	}
-	memset(pFilteringTable, 0, len);
-
-	/* add mac based rule*/
-	pFilteringTable->commit = 1;
-	pFilteringTable->ep = rx_prop->rx[0].src_pipe;
-	pFilteringTable->ip = iptype;
-	pFilteringTable->num_rules = 1;
-	pFilteringTable->add_after_hdl = eth_bridge_flt_rule_offset[iptype];
 
 	memset(&flt_rule_entry, 0, sizeof(flt_rule_entry));
 	flt_rule_entry.at_rear = 1;
@@ -4178,18 +4149,44 @@ int IPACM_Lan::eth_bridge_add_flt_rule(uint8_t *mac, uint32_t rt_tbl_hdl, ipa_ip
 	{
 		flt_rule_entry.rule.attrib.attrib_mask |= IPA_FLT_MAC_DST_ADDR_802_3;
 	}
-
-	memcpy(flt_rule_entry.rule.attrib.dst_mac_addr, mac, sizeof(flt_rule_entry.rule.attrib.dst_mac_addr));
 	memset(flt_rule_entry.rule.attrib.dst_mac_addr_mask, 0xFF, sizeof(flt_rule_entry.rule.attrib.dst_mac_addr_mask));
 
-	memcpy(&(pFilteringTable->rules[0]), &flt_rule_entry, sizeof(flt_rule_entry));
-	if (false == m_filtering.AddFilteringRuleAfter(pFilteringTable))
+	for(start = 0; start < num_client; start += cnt)
 	{
-		IPACMERR("Failed to add client filtering rules.\n");
-		res = IPACM_FAILURE;
-		goto end;
+		cnt = num_client - start;
+		if(cnt > client_per_ioctl)
+		{
+			cnt = client_per_ioctl;
+		}
+
+		memset(pFilteringTable, 0, len);
+
+		/* add mac based rules */
+		pFilteringTable->commit = 1;
+		pFilteringTable->ep = rx_prop->rx[0].src_pipe;
+		pFilteringTable->ip = iptype;
+		pFilteringTable->num_rules = cnt;
+		pFilteringTable->add_after_hdl = eth_bridge_flt_rule_offset[iptype];
+
+		for(i = 0; i < cnt; i++)
+		{
+			IPACMDBG_H("Client MAC 0x%02x%02x%02x%02x%02x%02x.\n", mac[start + i][0], mac[start + i][1],
+				mac[start + i][2], mac[start + i][3], mac[start + i][4], mac[start + i][5]);
+			memcpy(flt_rule_entry.rule.attrib.dst_mac_addr, mac[start + i], sizeof(flt_rule_entry.rule.attrib.dst_mac_addr));
+			memcpy(&(pFilteringTable->rules[i]), &flt_rule_entry, sizeof(flt_rule_entry));
+		}
+
+		if (false == m_filtering.AddFilteringRuleAfter(pFilteringTable))
+		{
+			IPACMERR("Failed to add client filtering rules.\n");
+			res = IPACM_FAILURE;
+			goto end;
+		}
+		for(i = 0; i < cnt; i++)
+		{
+			flt_rule_hdl[start + i] = pFilteringTable->rules[i].flt_rule_hdl;
+		}
 	}
-	*flt_rule_hdl = pFilteringTable->rules[0].flt_rule_hdl;
 
 end:
 	free(pFilteringTable);
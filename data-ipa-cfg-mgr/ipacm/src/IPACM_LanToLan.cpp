@@ -51,10 +51,26 @@ const char *ipa_l2_hdr_type[] = {
 	__stringify(L2_MAX)
 };
 
-IPACM_LanToLan_Iface::IPACM_LanToLan_Iface(IPACM_Lan *p_iface)
+static const ipa_ip_type l2l_ip_type[] = {IPA_IP_v4, IPA_IP_v6};
+
+/* FNV-1a over the client MAC */
+static uint32_t l2l_hash_mac(uint8_t *mac)
 {
+	uint32_t hash = 2166136261U;
 	int i;
 
+	for(i = 0; i < IPA_MAC_ADDR_SIZE; i++)
+	{
+		hash ^= mac[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+IPACM_LanToLan_Iface::IPACM_LanToLan_Iface(IPACM_Lan *p_iface)
+{
+	int i, max_client, hash_size;
+
 	m_p_iface = p_iface;
 	memset(m_is_ip_addr_assigned, 0, sizeof(m_is_ip_addr_assigned));
 	m_support_inter_iface_offload = true;
@@ -66,6 +82,22 @@ IPACM_LanToLan_Iface::IPACM_LanToLan_Iface(IPACM_Lan *p_iface)
 	}
 	hdr_proc_ctx_for_intra_interface = 0;
 
+	max_client = IPACM_Iface::ipacmcfg->GetLan2LanMaxClients();
+	if(max_client <= 0)
+	{
+		max_client = MAX_NUM_CLIENT;
+	}
+	/* keep the hash at most half full */
+	hash_size = 1;
+	while(hash_size < 2 * max_client)
+	{
+		hash_size <<= 1;
+	}
+	m_client_info.resize(max_client);
+	m_client_hash.resize(hash_size);
+	clear_client_table();
+	m_intra_interface_info.flt_rule.resize(max_client);
+
 	if(p_iface->ipa_if_cate == WLAN_IF)
 	{
 		IPACMDBG_H("Interface %s is WLAN interface.\n", p_iface->dev_name);
@@ -147,6 +179,7 @@ void IPACM_LanToLan::event_callback(ipa_cm_event_id event, void* param)
 void IPACM_LanToLan::handle_iface_up(ipacm_event_eth_bridge *data)
 {
 	list<IPACM_LanToLan_Iface>::iterator it;
+	int max_iface;
 
 	IPACMDBG_H("Interface name: %s IP type: %d\n", data->p_iface->dev_name, data->iptype);
 	for(it = m_iface.begin(); it != m_iface.end(); it++)
@@ -173,9 +206,14 @@ void IPACM_LanToLan::handle_iface_up(ipacm_event_eth_bridge *data)
 
 	if(it == m_iface.end())	//If the interface has not been created before
 	{
-		if(m_iface.size() == MAX_NUM_IFACE)
+		max_iface = IPACM_Iface::ipacmcfg->GetLan2LanMaxIfaces();
+		if(max_iface <= 0)
 		{
-			IPACMERR("The number of interfaces has reached maximum %d.\n", MAX_NUM_IFACE);
+			max_iface = MAX_NUM_IFACE;
+		}
+		if((int)m_iface.size() >= max_iface)
+		{
+			IPACMERR("The number of interfaces has reached maximum %d.\n", max_iface);
 			return;
 		}
 
@@ -444,27 +482,34 @@ void IPACM_LanToLan::print_data_structure_info()
 
 void IPACM_LanToLan_Iface::add_client_rt_rule_for_new_iface()
 {
-	list<client_info>::iterator it;
 	ipa_hdr_l2_type peer_l2_type;
-	peer_iface_info &peer = m_peer_iface_info.front();
+	peer_iface_info &peer = m_peer_iface_info.back();
+	vector<client_info*> clients(m_client_info.size());
+	int num_client;
 
 	peer_l2_type = peer.peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type;
 	if(ref_cnt_peer_l2_hdr_type[peer_l2_type] == 1)
 	{
-		for(it = m_client_info.begin(); it != m_client_info.end(); it++)
-		{
-			add_client_rt_rule(&peer, &(*it));
-		}
+		num_client = get_client_list(&clients[0]);
+		add_client_rt_rule(&peer, &clients[0], num_client);
 	}
 
 	return;
 }
 
-void IPACM_LanToLan_Iface::add_client_rt_rule(peer_iface_info *peer_info, client_info *client)
+void IPACM_LanToLan_Iface::add_client_rt_rule(peer_iface_info *peer_info, client_info **clients, int num_client)
 {
-	int i, num_rt_rule;
-	uint32_t rt_rule_hdl[MAX_NUM_PROP];
+	int i, j, k, num_rt_rule;
+	uint8_t (*mac)[IPA_MAC_ADDR_SIZE];
+	uint32_t *rt_rule_hdl, hdr_proc_ctx_hdl;
 	ipa_hdr_l2_type peer_l2_hdr_type;
+	ipa_ip_type iptype;
+	rt_rule_info *rt_info;
+
+	if(num_client <= 0)
+	{
+		return;
+	}
 
 	peer_l2_hdr_type = peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type;
 
@@ -472,90 +517,91 @@ void IPACM_LanToLan_Iface::add_client_rt_rule(peer_iface_info *peer_info, client
 	if(peer_info->peer != this)
 	{
 		IPACMDBG_H("This is for inter interface communication.\n");
-
-		m_p_iface->eth_bridge_add_rt_rule(client->mac_addr, peer_info->rt_tbl_name_for_rt[IPA_IP_v4], hdr_proc_ctx_for_inter_interface[peer_l2_hdr_type],
-			peer_l2_hdr_type, IPA_IP_v4, rt_rule_hdl, &num_rt_rule);
-
-		client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].num_hdl[IPA_IP_v4] = num_rt_rule;
-		IPACMDBG_H("Number of IPv4 routing rule is %d.\n", num_rt_rule);
-		for(i=0; i<num_rt_rule; i++)
-		{
-			IPACMDBG_H("Routing rule %d handle %d\n", i, rt_rule_hdl[i]);
-			client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].rule_hdl[IPA_IP_v4][i] = rt_rule_hdl[i];
-		}
-
-		m_p_iface->eth_bridge_add_rt_rule(client->mac_addr, peer_info->rt_tbl_name_for_rt[IPA_IP_v6], hdr_proc_ctx_for_inter_interface[peer_l2_hdr_type],
-			peer_l2_hdr_type, IPA_IP_v6, rt_rule_hdl, &num_rt_rule);
-
-		client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].num_hdl[IPA_IP_v6] = num_rt_rule;
-		IPACMDBG_H("Number of IPv6 routing rule is %d.\n", num_rt_rule);
-		for(i=0; i<num_rt_rule; i++)
-		{
-			IPACMDBG_H("Routing rule %d handle %d\n", i, rt_rule_hdl[i]);
-			client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].rule_hdl[IPA_IP_v6][i] = rt_rule_hdl[i];
-		}
+		hdr_proc_ctx_hdl = hdr_proc_ctx_for_inter_interface[peer_l2_hdr_type];
 	}
 	else
 	{
 		IPACMDBG_H("This is for intra interface communication.\n");
-		m_p_iface->eth_bridge_add_rt_rule(client->mac_addr, peer_info->rt_tbl_name_for_rt[IPA_IP_v4], hdr_proc_ctx_for_intra_interface,
-			peer_l2_hdr_type, IPA_IP_v4, rt_rule_hdl, &num_rt_rule);
+		hdr_proc_ctx_hdl = hdr_proc_ctx_for_intra_interface;
+	}
 
-		client->intra_iface_rt_rule_hdl.num_hdl[IPA_IP_v4] = num_rt_rule;
-		IPACMDBG_H("Number of IPv4 routing rule is %d.\n", num_rt_rule);
-		for(i=0; i<num_rt_rule; i++)
-		{
-			IPACMDBG_H("Routing rule %d handle %d\n", i, rt_rule_hdl[i]);
-			client->intra_iface_rt_rule_hdl.rule_hdl[IPA_IP_v4][i] = rt_rule_hdl[i];
-		}
+	mac = (uint8_t (*)[IPA_MAC_ADDR_SIZE])malloc(num_client * IPA_MAC_ADDR_SIZE);
+	rt_rule_hdl = (uint32_t *)malloc(num_client * MAX_NUM_PROP * sizeof(uint32_t));
+	if(mac == NULL || rt_rule_hdl == NULL)
+	{
+		IPACMERR("Failed to allocate memory.\n");
+		free(mac);
+		free(rt_rule_hdl);
+		return;
+	}
+	for(j = 0; j < num_client; j++)
+	{
+		memcpy(mac[j], clients[j]->mac_addr, IPA_MAC_ADDR_SIZE);
+	}
 
-		m_p_iface->eth_bridge_add_rt_rule(client->mac_addr, peer_info->rt_tbl_name_for_rt[IPA_IP_v6], hdr_proc_ctx_for_intra_interface,
-			peer_l2_hdr_type, IPA_IP_v6, rt_rule_hdl, &num_rt_rule);
+	/* all clients go into one rule table per IP type */
+	for(k = 0; k < (int)(sizeof(l2l_ip_type) / sizeof(l2l_ip_type[0])); k++)
+	{
+		iptype = l2l_ip_type[k];
+		m_p_iface->eth_bridge_add_rt_rule(mac, num_client, peer_info->rt_tbl_name_for_rt[iptype], hdr_proc_ctx_hdl,
+			peer_l2_hdr_type, iptype, rt_rule_hdl, &num_rt_rule);
+		IPACMDBG_H("Number of IP type %d routing rule is %d for each of %d clients.\n", iptype, num_rt_rule, num_client);
 
-		client->intra_iface_rt_rule_hdl.num_hdl[IPA_IP_v6] = num_rt_rule;
-		IPACMDBG_H("Number of IPv6 routing rule is %d.\n", num_rt_rule);
-		for(i=0; i<num_rt_rule; i++)
+		for(j = 0; j < num_client; j++)
 		{
-			IPACMDBG_H("Routing rule %d handle %d\n", i, rt_rule_hdl[i]);
-			client->intra_iface_rt_rule_hdl.rule_hdl[IPA_IP_v6][i] = rt_rule_hdl[i];
+			if(peer_info->peer != this)
+			{
+				rt_info = &clients[j]->inter_iface_rt_rule_hdl[peer_l2_hdr_type];
+			}
+			else
+			{
+				rt_info = &clients[j]->intra_iface_rt_rule_hdl;
+			}
+
+			rt_info->num_hdl[iptype] = num_rt_rule;
+			for(i=0; i<num_rt_rule; i++)
+			{
+				rt_info->rule_hdl[iptype][i] = rt_rule_hdl[j * num_rt_rule + i];
+				IPACMDBG_H("Client slot %d routing rule %d handle %d\n", clients[j]->slot, i, rt_info->rule_hdl[iptype][i]);
+			}
 		}
 	}
 
+	free(mac);
+	free(rt_rule_hdl);
 	return;
 }
 
 void IPACM_LanToLan_Iface::add_all_inter_interface_client_flt_rule(ipa_ip_type iptype)
 {
-	list<peer_iface_info>::iterator it_iface;
-	list<client_info>::iterator it_client;
+	vector<peer_iface_info>::iterator it_iface;
+	int num_client;
 
 	for(it_iface = m_peer_iface_info.begin(); it_iface != m_peer_iface_info.end(); it_iface++)
 	{
 		IPACMDBG_H("Add flt rules for clients of interface %s.\n", it_iface->peer->get_iface_pointer()->dev_name);
-		for(it_client = it_iface->peer->m_client_info.begin(); it_client != it_iface->peer->m_client_info.end(); it_client++)
-		{
-			add_client_flt_rule(&(*it_iface), &(*it_client), iptype);
-		}
+		vector<client_info*> clients(it_iface->peer->m_client_info.size());
+		num_client = it_iface->peer->get_client_list(&clients[0]);
+		add_client_flt_rule(&(*it_iface), &clients[0], num_client, iptype);
 	}
 	return;
 }
 
 void IPACM_LanToLan_Iface::add_all_intra_interface_client_flt_rule(ipa_ip_type iptype)
 {
-	list<client_info>::iterator it_client;
+	vector<client_info*> clients(m_client_info.size());
+	int num_client;
 
 	IPACMDBG_H("Add flt rules for own clients.\n");
-	for(it_client = m_client_info.begin(); it_client != m_client_info.end(); it_client++)
-	{
-		add_client_flt_rule(&m_intra_interface_info, &(*it_client), iptype);
-	}
+	num_client = get_client_list(&clients[0]);
+	add_client_flt_rule(&m_intra_interface_info, &clients[0], num_client, iptype);
 
 	return;
 }
 
 void IPACM_LanToLan_Iface::add_one_client_flt_rule(IPACM_LanToLan_Iface *peer_iface, client_info *client)
 {
-	list<peer_iface_info>::iterator it;
+	vector<peer_iface_info>::iterator it;
 
 	for(it = m_peer_iface_info.begin(); it != m_peer_iface_info.end(); it++)
 	{
@@ -564,11 +610,11 @@ void IPACM_LanToLan_Iface::add_one_client_flt_rule(IPACM_LanToLan_Iface *peer_if
 			IPACMDBG_H("Found the peer iface info.\n");
 			if(m_is_ip_addr_assigned[IPA_IP_v4])
 			{
-				add_client_flt_rule(&(*it), client, IPA_IP_v4);
+				add_client_flt_rule(&(*it), &client, 1, IPA_IP_v4);
 			}
 			if(m_is_ip_addr_assigned[IPA_IP_v6])
 			{
-				add_client_flt_rule(&(*it), client, IPA_IP_v6);
+				add_client_flt_rule(&(*it), &client, 1, IPA_IP_v6);
 			}
 
 			break;
@@ -577,12 +623,18 @@ void IPACM_LanToLan_Iface::add_one_client_flt_rule(IPACM_LanToLan_Iface *peer_if
 	return;
 }
 
-void IPACM_LanToLan_Iface::add_client_flt_rule(peer_iface_info *peer, client_info *client, ipa_ip_type iptype)
+void IPACM_LanToLan_Iface::add_client_flt_rule(peer_iface_info *peer, client_info **clients, int num_client, ipa_ip_type iptype)
 {
-	list<flt_rule_info>::iterator it_flt;
-	uint32_t flt_rule_hdl;
-	flt_rule_info new_flt_info;
+	flt_rule_info *flt_info;
+	uint8_t (*mac)[IPA_MAC_ADDR_SIZE];
+	uint32_t *flt_rule_hdl;
 	ipa_ioc_get_rt_tbl rt_tbl;
+	int j;
+
+	if(num_client <= 0)
+	{
+		return;
+	}
 
 	rt_tbl.ip = iptype;
 	memcpy(rt_tbl.name, peer->rt_tbl_name_for_flt[iptype], sizeof(rt_tbl.name));
@@ -594,36 +646,49 @@ void IPACM_LanToLan_Iface::add_client_flt_rule(peer_iface_info *peer, client_inf
 		return;
 	}
 
-	m_p_iface->eth_bridge_add_flt_rule(client->mac_addr, rt_tbl.hdl,
-		iptype, &flt_rule_hdl);
-	IPACMDBG_H("Installed flt rule for IP type %d: handle %d\n", iptype, flt_rule_hdl);
-
-	for(it_flt = peer->flt_rule.begin(); it_flt != peer->flt_rule.end(); it_flt++)
+	mac = (uint8_t (*)[IPA_MAC_ADDR_SIZE])malloc(num_client * IPA_MAC_ADDR_SIZE);
+	flt_rule_hdl = (uint32_t *)malloc(num_client * sizeof(uint32_t));
+	if(mac == NULL || flt_rule_hdl == NULL)
 	{
-		if(it_flt->p_client == client)	//the client is already in the flt info list
-		{
-			IPACMDBG_H("The client is found in flt info list.\n");
-			it_flt->flt_rule_hdl[iptype] = flt_rule_hdl;
-			break;
-		}
+		IPACMERR("Failed to allocate memory.\n");
+		free(mac);
+		free(flt_rule_hdl);
+		return;
+	}
+	for(j = 0; j < num_client; j++)
+	{
+		memcpy(mac[j], clients[j]->mac_addr, IPA_MAC_ADDR_SIZE);
 	}
 
-	if(it_flt == peer->flt_rule.end())	//the client is not in the flt info list
+	m_p_iface->eth_bridge_add_flt_rule(mac, num_client, rt_tbl.hdl, iptype, flt_rule_hdl);
+
+	for(j = 0; j < num_client; j++)
 	{
-		IPACMDBG_H("The client is not found in flt info list, insert a new one.\n");
-		memset(&new_flt_info, 0, sizeof(new_flt_info));
-		new_flt_info.p_client = client;
-		new_flt_info.flt_rule_hdl[iptype] = flt_rule_hdl;
+		if(clients[j]->slot < 0 || clients[j]->slot >= (int)peer->flt_rule.size())
+		{
+			IPACMERR("Client slot %d is out of range.\n", clients[j]->slot);
+			continue;
+		}
+		IPACMDBG_H("Installed flt rule for IP type %d: handle %d\n", iptype, flt_rule_hdl[j]);
 
-		peer->flt_rule.push_front(new_flt_info);
+		flt_info = &peer->flt_rule[clients[j]->slot];
+		if(flt_info->p_client != clients[j])	//the client has no flt info yet
+		{
+			IPACMDBG_H("The client is not found in flt info table, insert a new one.\n");
+			memset(flt_info, 0, sizeof(flt_rule_info));
+			flt_info->p_client = clients[j];
+		}
+		flt_info->flt_rule_hdl[iptype] = flt_rule_hdl[j];
 	}
 
+	free(mac);
+	free(flt_rule_hdl);
 	return;
 }
 
 void IPACM_LanToLan_Iface::del_one_client_flt_rule(IPACM_LanToLan_Iface *peer_iface, client_info *client)
 {
-	list<peer_iface_info>::iterator it;
+	vector<peer_iface_info>::iterator it;
 
 	for(it = m_peer_iface_info.begin(); it != m_peer_iface_info.end(); it++)
 	{
@@ -639,27 +704,29 @@ void IPACM_LanToLan_Iface::del_one_client_flt_rule(IPACM_LanToLan_Iface *peer_if
 
 void IPACM_LanToLan_Iface::del_client_flt_rule(peer_iface_info *peer, client_info *client)
 {
-	list<flt_rule_info>::iterator it_flt;
+	flt_rule_info *flt_info;
 
-	for(it_flt = peer->flt_rule.begin(); it_flt != peer->flt_rule.end(); it_flt++)
+	if(client->slot < 0 || client->slot >= (int)peer->flt_rule.size())
 	{
-		if(it_flt->p_client == client)	//found the client in flt info list
-		{
-			IPACMDBG_H("Found the client in flt info list.\n");
-			if(m_is_ip_addr_assigned[IPA_IP_v4])
-			{
-				m_p_iface->eth_bridge_del_flt_rule(it_flt->flt_rule_hdl[IPA_IP_v4], IPA_IP_v4);
-				IPACMDBG_H("IPv4 flt rule %d is deleted.\n", it_flt->flt_rule_hdl[IPA_IP_v4]);
-			}
-			if(m_is_ip_addr_assigned[IPA_IP_v6])
-			{
-				m_p_iface->eth_bridge_del_flt_rule(it_flt->flt_rule_hdl[IPA_IP_v6], IPA_IP_v6);
-				IPACMDBG_H("IPv6 flt rule %d is deleted.\n", it_flt->flt_rule_hdl[IPA_IP_v6]);
-			}
+		return;
+	}
 
-			peer->flt_rule.erase(it_flt);
-			break;
+	flt_info = &peer->flt_rule[client->slot];
+	if(flt_info->p_client == client)	//found the client in flt info table
+	{
+		IPACMDBG_H("Found the client in flt info table.\n");
+		if(m_is_ip_addr_assigned[IPA_IP_v4])
+		{
+			m_p_iface->eth_bridge_del_flt_rule(flt_info->flt_rule_hdl[IPA_IP_v4], IPA_IP_v4);
+			IPACMDBG_H("IPv4 flt rule %d is deleted.\n", flt_info->flt_rule_hdl[IPA_IP_v4]);
 		}
+		if(m_is_ip_addr_assigned[IPA_IP_v6])
+		{
+			m_p_iface->eth_bridge_del_flt_rule(flt_info->flt_rule_hdl[IPA_IP_v6], IPA_IP_v6);
+			IPACMDBG_H("IPv6 flt rule %d is deleted.\n", flt_info->flt_rule_hdl[IPA_IP_v6]);
+		}
+
+		memset(flt_info, 0, sizeof(flt_rule_info));
 	}
 	return;
 }
@@ -717,7 +784,7 @@ void IPACM_LanToLan_Iface::del_client_rt_rule(peer_iface_info *peer, client_info
 void IPACM_LanToLan_Iface::handle_down_event()
 {
 	list<IPACM_LanToLan_Iface>::iterator it_other_iface;
-	list<peer_iface_info>::iterator it_own_peer_info, it_other_iface_peer_info;
+	vector<peer_iface_info>::iterator it_own_peer_info, it_other_iface_peer_info;
 	IPACM_LanToLan_Iface *other_iface;
 
 	/* clear inter-interface rules */
@@ -772,18 +839,22 @@ void IPACM_LanToLan_Iface::handle_down_event()
 		IPACMDBG_H("Hdr proc ctx with hdl %d is deleted.\n", hdr_proc_ctx_for_intra_interface);
 	}
 
-	/* then clear the client info list */
-	m_client_info.clear();
+	/* then clear the client table */
+	clear_client_table();
 
 	return;
 }
 
 void IPACM_LanToLan_Iface::clear_all_flt_rule_for_one_peer_iface(peer_iface_info *peer)
 {
-	list<flt_rule_info>::iterator it;
+	vector<flt_rule_info>::iterator it;
 
 	for(it = peer->flt_rule.begin(); it != peer->flt_rule.end(); it++)
 	{
+		if(it->p_client == NULL)
+		{
+			continue;
+		}
 		if(m_is_ip_addr_assigned[IPA_IP_v4])
 		{
 			m_p_iface->eth_bridge_del_flt_rule(it->flt_rule_hdl[IPA_IP_v4], IPA_IP_v4);
@@ -794,14 +865,14 @@ void IPACM_LanToLan_Iface::clear_all_flt_rule_for_one_peer_iface(peer_iface_info
 			m_p_iface->eth_bridge_del_flt_rule(it->flt_rule_hdl[IPA_IP_v6], IPA_IP_v6);
 			IPACMDBG_H("IPv6 flt rule %d is deleted.\n", it->flt_rule_hdl[IPA_IP_v6]);
 		}
+		memset(&(*it), 0, sizeof(flt_rule_info));
 	}
-	peer->flt_rule.clear();
 	return;
 }
 
 void IPACM_LanToLan_Iface::clear_all_rt_rule_for_one_peer_iface(peer_iface_info *peer)
 {
-	list<client_info>::iterator it;
+	vector<client_info>::iterator it;
 	ipa_hdr_l2_type peer_l2_type;
 
 	peer_l2_type = peer->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type;
@@ -809,7 +880,10 @@ void IPACM_LanToLan_Iface::clear_all_rt_rule_for_one_peer_iface(peer_iface_info
 	{
 		for(it = m_client_info.begin(); it != m_client_info.end(); it++)
 		{
-			del_client_rt_rule(peer, &(*it));
+			if(it->in_use)
+			{
+				del_client_rt_rule(peer, &(*it));
+			}
 		}
 	}
 
@@ -818,8 +892,8 @@ void IPACM_LanToLan_Iface::clear_all_rt_rule_for_one_peer_iface(peer_iface_info
 
 void IPACM_LanToLan_Iface::handle_wlan_scc_mcc_switch()
 {
-	list<peer_iface_info>::iterator it_peer_info;
-	list<client_info>::iterator it_client;
+	vector<peer_iface_info>::iterator it_peer_info;
+	vector<client_info>::iterator it_client;
 	ipa_hdr_l2_type peer_l2_hdr_type;
 	bool flag[IPA_HDR_L2_MAX];
 	int i;
@@ -837,6 +911,10 @@ void IPACM_LanToLan_Iface::handle_wlan_scc_mcc_switch()
 				flag[peer_l2_hdr_type] = true;
 				for(it_client = m_client_info.begin(); it_client != m_client_info.end(); it_client++)
 				{
+					if(!it_client->in_use)
+					{
+						continue;
+					}
 					m_p_iface->eth_bridge_modify_rt_rule(it_client->mac_addr, hdr_proc_ctx_for_inter_interface[peer_l2_hdr_type],
 						peer_l2_hdr_type, IPA_IP_v4, it_client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].rule_hdl[IPA_IP_v4],
 						it_client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].num_hdl[IPA_IP_v4]);
@@ -865,6 +943,10 @@ void IPACM_LanToLan_Iface::handle_wlan_scc_mcc_switch()
 	{
 		for(it_client = m_client_info.begin(); it_client != m_client_info.end(); it_client++)
 		{
+			if(!it_client->in_use)
+			{
+				continue;
+			}
 			m_p_iface->eth_bridge_modify_rt_rule(it_client->mac_addr, hdr_proc_ctx_for_intra_interface,
 				m_p_iface->tx_prop->tx[0].hdr_l2_type, IPA_IP_v4, it_client->intra_iface_rt_rule_hdl.rule_hdl[IPA_IP_v4],
 				it_client->intra_iface_rt_rule_hdl.num_hdl[IPA_IP_v4]);
@@ -934,42 +1016,42 @@ void IPACM_LanToLan_Iface::handle_new_iface_up(char rt_tbl_name_for_flt[][IPA_RE
 	memcpy(new_peer.rt_tbl_name_for_flt[IPA_IP_v4], rt_tbl_name_for_flt[IPA_IP_v4], IPA_RESOURCE_NAME_MAX);
 	memcpy(new_peer.rt_tbl_name_for_flt[IPA_IP_v6], rt_tbl_name_for_flt[IPA_IP_v6], IPA_RESOURCE_NAME_MAX);
 
+	/* flt rules of the peer clients, indexed by their slot */
+	new_peer.flt_rule.resize(peer_iface->m_client_info.size());
+
 	peer_l2_hdr_type = peer_iface->m_p_iface->tx_prop->tx[0].hdr_l2_type;
 	increment_ref_cnt_peer_l2_hdr_type(peer_l2_hdr_type);
 	add_hdr_proc_ctx(peer_l2_hdr_type);
 
-	/* push the new peer_iface_info into the list */
-	m_peer_iface_info.push_front(new_peer);
+	/* append the new peer_iface_info */
+	m_peer_iface_info.push_back(new_peer);
 
 	return;
 }
 
 void IPACM_LanToLan_Iface::handle_client_add(uint8_t *mac)
 {
-	list<client_info>::iterator it_client;
-	list<peer_iface_info>::iterator it_peer_info;
-	client_info new_client;
+	vector<peer_iface_info>::iterator it_peer_info;
+	client_info *client;
 	bool flag[IPA_HDR_L2_MAX];
 
-	for(it_client = m_client_info.begin(); it_client != m_client_info.end(); it_client++)
+	if(find_client(mac) != NULL)
 	{
-		if(memcmp(it_client->mac_addr, mac, sizeof(it_client->mac_addr)) == 0)
-		{
-			IPACMDBG_H("This client has been added before.\n");
-			return;
-		}
+		IPACMDBG_H("This client has been added before.\n");
+		return;
 	}
 
-	if(m_client_info.size() == MAX_NUM_CLIENT)
+	if(m_num_client == (int)m_client_info.size())
 	{
-		IPACMDBG_H("The number of clients has reached maximum %d.\n", MAX_NUM_CLIENT);
+		IPACMDBG_H("The number of clients has reached maximum %d.\n", m_client_info.size());
 		return;
 	}
 
-	memcpy(new_client.mac_addr, mac, sizeof(new_client.mac_addr));
-	m_client_info.push_front(new_client);
-
-	client_info &front_client = m_client_info.front();
+	client = insert_client(mac);
+	if(client == NULL)
+	{
+		return;
+	}
 
 	/* install inter-interface rules */
 	if(m_support_inter_iface_offload)
@@ -981,12 +1063,12 @@ void IPACM_LanToLan_Iface::handle_client_add(uint8_t *mac)
 			if(flag[it_peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type] == false)
 			{
 				/* add client routing rule for each peer interface */
-				add_client_rt_rule(&(*it_peer_info), &front_client);
+				add_client_rt_rule(&(*it_peer_info), &client, 1);
 				flag[it_peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type] = true;
 			}
 
 			/* add client filtering rule on peer interfaces */
-			it_peer_info->peer->add_one_client_flt_rule(this, &front_client);
+			it_peer_info->peer->add_one_client_flt_rule(this, client);
 		}
 	}
 
@@ -994,16 +1076,16 @@ void IPACM_LanToLan_Iface::handle_client_add(uint8_t *mac)
 	if(m_support_intra_iface_offload)
 	{
 		/* add routing rule first */
-		add_client_rt_rule(&m_intra_interface_info, &front_client);
+		add_client_rt_rule(&m_intra_interface_info, &client, 1);
 
 		/* add filtering rule */
 		if(m_is_ip_addr_assigned[IPA_IP_v4])
 		{
-			add_client_flt_rule(&m_intra_interface_info, &front_client, IPA_IP_v4);
+			add_client_flt_rule(&m_intra_interface_info, &client, 1, IPA_IP_v4);
 		}
 		if(m_is_ip_addr_assigned[IPA_IP_v6])
 		{
-			add_client_flt_rule(&m_intra_interface_info, &front_client, IPA_IP_v6);
+			add_client_flt_rule(&m_intra_interface_info, &client, 1, IPA_IP_v6);
 		}
 	}
 
@@ -1012,21 +1094,15 @@ void IPACM_LanToLan_Iface::handle_client_add(uint8_t *mac)
 
 void IPACM_LanToLan_Iface::handle_client_del(uint8_t *mac)
 {
-	list<client_info>::iterator it_client;
-	list<peer_iface_info>::iterator it_peer_info;
+	vector<peer_iface_info>::iterator it_peer_info;
+	client_info *client;
 	bool flag[IPA_HDR_L2_MAX];
 
-	for(it_client = m_client_info.begin(); it_client != m_client_info.end(); it_client++)
+	client = find_client(mac);
+	if(client != NULL)	//if we found the client
 	{
-		if(memcmp(it_client->mac_addr, mac, sizeof(it_client->mac_addr)) == 0)	//found the client
-		{
-			IPACMDBG_H("Found the client.\n");
-			break;
-		}
-	}
+		IPACMDBG_H("Found the client.\n");
 
-	if(it_client != m_client_info.end())	//if we found the client
-	{
 		/* uninstall inter-interface rules */
 		if(m_support_inter_iface_offload)
 		{
@@ -1035,13 +1111,13 @@ void IPACM_LanToLan_Iface::handle_client_del(uint8_t *mac)
 				it_peer_info++)
 			{
 				IPACMDBG_H("Delete client filtering rule on peer interface.\n");
-				it_peer_info->peer->del_one_client_flt_rule(this, &(*it_client));
+				it_peer_info->peer->del_one_client_flt_rule(this, client);
 
 				/* make sure to delete routing rule only once for each peer l2 header type */
 				if(flag[it_peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type] == false)
 				{
 					IPACMDBG_H("Delete client routing rule for peer interface.\n");
-					del_client_rt_rule(&(*it_peer_info), &(*it_client));
+					del_client_rt_rule(&(*it_peer_info), client);
 					flag[it_peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type] = true;
 				}
 			}
@@ -1052,15 +1128,15 @@ void IPACM_LanToLan_Iface::handle_client_del(uint8_t *mac)
 		{
 			/* delete filtering rule first */
 			IPACMDBG_H("Delete client filtering rule for intra-interface communication.\n");
-			del_client_flt_rule(&m_intra_interface_info, &(*it_client));
+			del_client_flt_rule(&m_intra_interface_info, client);
 
 			/* delete routing rule */
 			IPACMDBG_H("Delete client routing rule for intra-interface communication.\n");
-			del_client_rt_rule(&m_intra_interface_info, &(*it_client));
+			del_client_rt_rule(&m_intra_interface_info, client);
 		}
 
-		/* erase the client from client info list */
-		m_client_info.erase(it_client);
+		/* release the client slot */
+		erase_client(client);
 	}
 	else
 	{
@@ -1070,6 +1146,121 @@ void IPACM_LanToLan_Iface::handle_client_del(uint8_t *mac)
 	return;
 }
 
+client_info* IPACM_LanToLan_Iface::find_client(uint8_t *mac)
+{
+	uint32_t mask = m_client_hash.size() - 1, i;
+	int slot;
+
+	for(i = l2l_hash_mac(mac) & mask; (slot = m_client_hash[i]) != L2L_CLIENT_SLOT_INVALID; i = (i + 1) & mask)
+	{
+		if(memcmp(m_client_info[slot].mac_addr, mac, sizeof(m_client_info[slot].mac_addr)) == 0)
+		{
+			return &m_client_info[slot];
+		}
+	}
+	return NULL;
+}
+
+client_info* IPACM_LanToLan_Iface::insert_client(uint8_t *mac)
+{
+	uint32_t mask = m_client_hash.size() - 1, i;
+	int slot;
+
+	for(slot = 0; slot < (int)m_client_info.size(); slot++)
+	{
+		if(m_client_info[slot].in_use == false)
+		{
+			break;
+		}
+	}
+	if(slot == (int)m_client_info.size())
+	{
+		IPACMERR("No free client slot.\n");
+		return NULL;
+	}
+
+	memset(&m_client_info[slot], 0, sizeof(client_info));
+	memcpy(m_client_info[slot].mac_addr, mac, sizeof(m_client_info[slot].mac_addr));
+	m_client_info[slot].in_use = true;
+	m_client_info[slot].slot = slot;
+
+	for(i = l2l_hash_mac(mac) & mask; m_client_hash[i] != L2L_CLIENT_SLOT_INVALID; i = (i + 1) & mask);
+	m_client_hash[i] = slot;
+	m_num_client++;
+
+	IPACMDBG_H("Client MAC 0x%02x%02x%02x%02x%02x%02x uses slot %d, %d clients in total.\n", mac[0], mac[1],
+		mac[2], mac[3], mac[4], mac[5], slot, m_num_client);
+	return &m_client_info[slot];
+}
+
+void IPACM_LanToLan_Iface::erase_client(client_info *client)
+{
+	uint32_t mask = m_client_hash.size() - 1, i, j, k;
+
+	for(i = l2l_hash_mac(client->mac_addr) & mask; m_client_hash[i] != client->slot; i = (i + 1) & mask)
+	{
+		if(m_client_hash[i] == L2L_CLIENT_SLOT_INVALID)
+		{
+			IPACMERR("Client slot %d is not hashed.\n", client->slot);
+			return;
+		}
+	}
+
+	/* backward shift deletion keeps every probe sequence unbroken */
+	j = i;
+	while(1)
+	{
+		j = (j + 1) & mask;
+		if(m_client_hash[j] == L2L_CLIENT_SLOT_INVALID)
+		{
+			break;
+		}
+		k = l2l_hash_mac(m_client_info[m_client_hash[j]].mac_addr) & mask;
+		/* move the entry at j to i unless its home bucket k lies cyclically in (i, j] */
+		if((i <= j) ? (k <= i || k > j) : (k <= i && k > j))
+		{
+			m_client_hash[i] = m_client_hash[j];
+			i = j;
+		}
+	}
+	m_client_hash[i] = L2L_CLIENT_SLOT_INVALID;
+
+	client->in_use = false;
+	m_num_client--;
+	return;
+}
+
+void IPACM_LanToLan_Iface::clear_client_table()
+{
+	int i;
+
+	for(i = 0; i < (int)m_client_info.size(); i++)
+	{
+		memset(&m_client_info[i], 0, sizeof(client_info));
+		m_client_info[i].slot = i;
+	}
+	for(i = 0; i < (int)m_client_hash.size(); i++)
+	{
+		m_client_hash[i] = L2L_CLIENT_SLOT_INVALID;
+	}
+	m_num_client = 0;
+	return;
+}
+
+int IPACM_LanToLan_Iface::get_client_list(client_info **clients)
+{
+	int i, num_client = 0;
+
+	for(i = 0; i < (int)m_client_info.size(); i++)
+	{
+		if(m_client_info[i].in_use)
+		{
+			clients[num_client++] = &m_client_info[i];
+		}
+	}
+	return num_client;
+}
+
 void IPACM_LanToLan_Iface::add_hdr_proc_ctx(ipa_hdr_l2_type peer_l2_type)
 {
 	uint32_t hdr_proc_ctx_hdl;
@@ -1095,8 +1286,8 @@ void IPACM_LanToLan_Iface::del_hdr_proc_ctx(ipa_hdr_l2_type peer_l2_type)
 
 void IPACM_LanToLan_Iface::print_data_structure_info()
 {
-	list<peer_iface_info>::iterator it_peer;
-	list<client_info>::iterator it_client;
+	vector<peer_iface_info>::iterator it_peer;
+	vector<client_info>::iterator it_client;
 	int i, j, k;
 
 	IPACMDBG_H("\n");
@@ -1124,9 +1315,13 @@ void IPACM_LanToLan_Iface::print_data_structure_info()
 	}
 
 	i = 1;
-	IPACMDBG_H("There are %d clients in total.\n", m_client_info.size());
+	IPACMDBG_H("There are %d clients in total.\n", m_num_client);
 	for(it_client = m_client_info.begin(); it_client != m_client_info.end(); it_client++)
 	{
+		if(!it_client->in_use)
+		{
+			continue;
+		}
 		IPACMDBG_H("Client %d MAC: 0x%02x%02x%02x%02x%02x%02x Pointer: 0x%08x\n", i, it_client->mac_addr[0], it_client->mac_addr[1],
 			it_client->mac_addr[2], it_client->mac_addr[3], it_client->mac_addr[4], it_client->mac_addr[5], &(*it_client));
 
@@ -1188,14 +1383,16 @@ void IPACM_LanToLan_Iface::print_data_structure_info()
 
 void IPACM_LanToLan_Iface::print_peer_info(peer_iface_info *peer_info)
 {
-	list<flt_rule_info>::iterator it_flt;
-	list<rt_rule_info>::iterator it_rt;
+	vector<flt_rule_info>::iterator it_flt;
 
 	IPACMDBG_H("Printing peer info for iface %s:\n", peer_info->peer->m_p_iface->dev_name);
 
-	IPACMDBG_H("There are %d flt info in total.\n", peer_info->flt_rule.size());
 	for(it_flt = peer_info->flt_rule.begin(); it_flt != peer_info->flt_rule.end(); it_flt++)
 	{
+		if(it_flt->p_client == NULL)
+		{
+			continue;
+		}
 		IPACMDBG_H("Flt rule handle for client 0x%08x:\n", it_flt->p_client);
 		if(m_is_ip_addr_assigned[IPA_IP_v4])
 		{
@@ -63,6 +63,12 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Neighbor.h"
 #include "IPACM_IfaceManager.h"
 #include "IPACM_Log.h"
+#include "IPACM_EvtStats.h"
+#include "IPACM_EvtRecord.h"
+#include "IPACM_EvtExecutor.h"
+#include "IPACM_DriverMsg.h"
+#include "IPACM_Startup.h"
+#include "IPACM_Xml.h"
 
 #include "IPACM_ConntrackListener.h"
 #include "IPACM_ConntrackClient.h"
@@ -91,9 +97,10 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define IPA_DRIVER_WLAN_EVENT_MAX_OF_ATTRIBS  3
 #define IPA_DRIVER_WLAN_EVENT_SIZE  (sizeof(struct ipa_wlan_msg_ex)+ IPA_DRIVER_WLAN_EVENT_MAX_OF_ATTRIBS*sizeof(ipa_wlan_hdr_attrib_val))
-#define IPA_DRIVER_PIPE_STATS_EVENT_SIZE  (sizeof(struct ipa_get_data_stats_resp_msg_v01))
 #define IPA_DRIVER_WLAN_META_MSG    (sizeof(struct ipa_msg_meta))
-#define IPA_DRIVER_WLAN_BUF_LEN     (IPA_DRIVER_PIPE_STATS_EVENT_SIZE + IPA_DRIVER_WLAN_META_MSG)
+#define IPA_DRIVER_WLAN_BUF_LEN     (IPA_DRIVER_MSG_PAYLOAD_LEN + IPA_DRIVER_WLAN_META_MSG)
+/* messages read from the driver per wakeup before they are posted */
+#define IPA_DRIVER_MSG_BATCH        16
 
 uint32_t ipacm_event_stats[IPACM_EVENT_MAX];
 bool ipacm_logging = true;
@@ -206,18 +213,26 @@ void* firewall_monitor(void *param)
 
 
 /* start IPACM wan-driver notifier */
-void* ipa_driver_msg_notifier(void *param)
+static void ipa_driver_msg_post(ipacm_cmd_q_data *evt_data)
+{
+	IPACMDBG_H("Posting event:%d\n", evt_data->event);
+	if (IPACM_EvtDispatcher::PostEvt(evt_data) != IPACM_SUCCESS)
+	{
+		IPACMERR("unable to post event:%d\n", evt_data->event);
+		IPACM_DriverMsg::Free(evt_data->evt_data);
+	}
+}
+
+/* convert one driver message, event data is carved out of its slot */
+static void ipa_driver_msg_process(ipacm_drv_msg_slot *slot)
 {
-	int length, fd, cnt;
-	char buffer[IPA_DRIVER_WLAN_BUF_LEN];
-	struct ipa_msg_meta event_hdr;
-	struct ipa_ecm_msg event_ecm;
-	struct ipa_wan_msg event_wan;
-	struct ipa_wlan_msg_ex event_ex_o;
-	struct ipa_wlan_msg *event_wlan=NULL;
-	struct ipa_wlan_msg_ex *event_ex= NULL;
-	struct ipa_get_data_stats_resp_msg_v01 event_data_stats;
-	struct ipa_get_apn_data_stats_resp_msg_v01 event_network_stats;
+	int cnt;
+	struct ipa_msg_meta *event_hdr;
+	char *payload;
+	struct ipa_ecm_msg *event_ecm;
+	struct ipa_wan_msg *event_wan;
+	struct ipa_wlan_msg *event_wlan = NULL;
+	struct ipa_wlan_msg_ex *event_ex = NULL;
 
 	ipacm_cmd_q_data evt_data;
 	ipacm_event_data_mac *data = NULL;
@@ -228,466 +243,512 @@ void* ipa_driver_msg_notifier(void *param)
 	ipa_get_apn_data_stats_resp_msg_v01 *data_network_stats = NULL;
 
 	ipacm_cmd_q_data new_neigh_evt;
-	ipacm_event_data_all* new_neigh_data;
+	ipacm_event_data_all* new_neigh_data = NULL;
 
-	fd = open(IPA_DRIVER, O_RDWR);
-	if (fd < 0)
+	if (slot->len < (int)sizeof(struct ipa_msg_meta))
 	{
-		IPACMERR("Failed opening %s.\n", IPA_DRIVER);
-		return NULL;
+		IPACMERR("short read of %d bytes from IPA driver\n", slot->len);
+		return;
 	}
 
-	while (1)
+	evt_data.event = IPACM_EVENT_MAX;
+	evt_data.evt_data = NULL;
+	event_hdr = (struct ipa_msg_meta *)slot->buf;
+	payload = slot->buf + sizeof(struct ipa_msg_meta);
+	IPACMDBG_H("Message type: %d\n", event_hdr->msg_type);
+	IPACMDBG_H("Event header length received: %d\n",event_hdr->msg_len);
+
+	/* Insert WLAN_DRIVER_EVENT to command queue */
+	switch (event_hdr->msg_type)
 	{
-		IPACMDBG_H("Waiting for nofications from IPA driver \n");
-		memset(buffer, 0, sizeof(buffer));
-		memset(&evt_data, 0, sizeof(evt_data));
-		memset(&new_neigh_evt, 0, sizeof(ipacm_cmd_q_data));
-		new_neigh_data = NULL;
-		data = NULL;
-		data_fid = NULL;
-		data_tethering_stats = NULL;
-		data_network_stats = NULL;
-
-		length = read(fd, buffer, IPA_DRIVER_WLAN_BUF_LEN);
-		if (length < 0)
+
+	case SW_ROUTING_ENABLE:
+		IPACMDBG_H("Received SW_ROUTING_ENABLE\n");
+		IPACMDBG_H("Not supported anymore\n");
+		return;
+
+	case SW_ROUTING_DISABLE:
+		IPACMDBG_H("Received SW_ROUTING_DISABLE\n");
+		IPACMDBG_H("Not supported anymore\n");
+		return;
+
+	case WLAN_AP_CONNECT:
+		event_wlan = (struct ipa_wlan_msg *)payload;
+		IPACMDBG_H("Received WLAN_AP_CONNECT name: %s\n",event_wlan->name);
+		IPACMDBG_H("AP Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
+						 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
+						 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
+		data_fid = (ipacm_event_data_fid *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_fid));
+		if(data_fid == NULL)
 		{
-			PERROR("didn't read IPA_driver correctly");
-			continue;
+			IPACMERR("unable to allocate memory for event_wlan data_fid\n");
+			return;
 		}
-
-		memcpy(&event_hdr, buffer,sizeof(struct ipa_msg_meta));
-		IPACMDBG_H("Message type: %d\n", event_hdr.msg_type);
-		IPACMDBG_H("Event header length received: %d\n",event_hdr.msg_len);
-
-		/* Insert WLAN_DRIVER_EVENT to command queue */
-		switch (event_hdr.msg_type)
+		ipa_get_if_index(event_wlan->name, &(data_fid->if_index));
+		evt_data.event = IPA_WLAN_AP_LINK_UP_EVENT;
+		evt_data.evt_data = data_fid;
+		break;
+
+	case WLAN_AP_DISCONNECT:
+		event_wlan = (struct ipa_wlan_msg *)payload;
+		IPACMDBG_H("Received WLAN_AP_DISCONNECT name: %s\n",event_wlan->name);
+		IPACMDBG_H("AP Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
+						 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
+						 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
+		data_fid = (ipacm_event_data_fid *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_fid));
+		if(data_fid == NULL)
+		{
+			IPACMERR("unable to allocate memory for event_wlan data_fid\n");
+			return;
+		}
+		ipa_get_if_index(event_wlan->name, &(data_fid->if_index));
+		evt_data.event = IPA_WLAN_LINK_DOWN_EVENT;
+		evt_data.evt_data = data_fid;
+		break;
+
+	case WLAN_STA_CONNECT:
+		event_wlan = (struct ipa_wlan_msg *)payload;
+		IPACMDBG_H("Received WLAN_STA_CONNECT name: %s\n",event_wlan->name);
+		IPACMDBG_H("STA Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
+						 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
+						 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
+		data = (ipacm_event_data_mac *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_mac));
+		if(data == NULL)
+		{
+			IPACMERR("unable to allocate memory for event_wlan data_fid\n");
+			return;
+		}
+		memcpy(data->mac_addr,
+			 event_wlan->mac_addr,
+			 sizeof(event_wlan->mac_addr));
+		ipa_get_if_index(event_wlan->name, &(data->if_index));
+		evt_data.event = IPA_WLAN_STA_LINK_UP_EVENT;
+		evt_data.evt_data = data;
+		break;
+
+	case WLAN_STA_DISCONNECT:
+		event_wlan = (struct ipa_wlan_msg *)payload;
+		IPACMDBG_H("Received WLAN_STA_DISCONNECT name: %s\n",event_wlan->name);
+		IPACMDBG_H("STA Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
+						 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
+						 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
+		data_fid = (ipacm_event_data_fid *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_fid));
+		if(data_fid == NULL)
+		{
+			IPACMERR("unable to allocate memory for event_wlan data_fid\n");
+			return;
+		}
+		ipa_get_if_index(event_wlan->name, &(data_fid->if_index));
+		evt_data.event = IPA_WLAN_LINK_DOWN_EVENT;
+		evt_data.evt_data = data_fid;
+		break;
+
+	case WLAN_CLIENT_CONNECT:
+		event_wlan = (struct ipa_wlan_msg *)payload;
+		IPACMDBG_H("Received WLAN_CLIENT_CONNECT\n");
+		IPACMDBG_H("Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
+						 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
+						 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
+		data = (ipacm_event_data_mac *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_mac));
+		if (data == NULL)
+		{
+			IPACMERR("unable to allocate memory for event_wlan data\n");
+			return;
+		}
+		memcpy(data->mac_addr,
+					 event_wlan->mac_addr,
+					 sizeof(event_wlan->mac_addr));
+		ipa_get_if_index(event_wlan->name, &(data->if_index));
+		evt_data.event = IPA_WLAN_CLIENT_ADD_EVENT;
+		evt_data.evt_data = data;
+		break;
+
+	case WLAN_CLIENT_CONNECT_EX:
+		IPACMDBG_H("Received WLAN_CLIENT_CONNECT_EX\n");
+
+		/* attributes are read in place from the slot */
+		event_ex = (struct ipa_wlan_msg_ex *)payload;
+		if(event_ex->num_of_attribs > IPA_DRIVER_WLAN_EVENT_MAX_OF_ATTRIBS)
+		{
+			IPACMERR("buffer size overflow\n");
+			return;
+		}
+		IPACMDBG_H("num_of_attribs %d, length %d\n", event_ex->num_of_attribs,
+			(int)(sizeof(ipa_wlan_msg_ex) + event_ex->num_of_attribs * sizeof(ipa_wlan_hdr_attrib_val)));
+		data_ex = (ipacm_event_data_wlan_ex *)IPACM_DriverMsg::Carve(slot,
+			sizeof(ipacm_event_data_wlan_ex) + event_ex->num_of_attribs * sizeof(ipa_wlan_hdr_attrib_val));
+		if (data_ex == NULL)
 		{
+			IPACMERR("unable to allocate memory for event data\n");
+			return;
+		}
+		data_ex->num_of_attribs = event_ex->num_of_attribs;
 
-		case SW_ROUTING_ENABLE:
-			IPACMDBG_H("Received SW_ROUTING_ENABLE\n");
-			evt_data.event = IPA_SW_ROUTING_ENABLE;
-			IPACMDBG_H("Not supported anymore\n");
-			continue;
+		memcpy(data_ex->attribs,
+					event_ex->attribs,
+					event_ex->num_of_attribs * sizeof(ipa_wlan_hdr_attrib_val));
 
-		case SW_ROUTING_DISABLE:
-			IPACMDBG_H("Received SW_ROUTING_DISABLE\n");
-			evt_data.event = IPA_SW_ROUTING_DISABLE;
-			IPACMDBG_H("Not supported anymore\n");
-			continue;
+		ipa_get_if_index(event_ex->name, &(data_ex->if_index));
+		evt_data.event = IPA_WLAN_CLIENT_ADD_EVENT_EX;
+		evt_data.evt_data = data_ex;
 
-		case WLAN_AP_CONNECT:
-			event_wlan = (struct ipa_wlan_msg *) (buffer + sizeof(struct ipa_msg_meta));
-			IPACMDBG_H("Received WLAN_AP_CONNECT name: %s\n",event_wlan->name);
-			IPACMDBG_H("AP Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
-							 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
-							 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
-                        data_fid = (ipacm_event_data_fid *)malloc(sizeof(ipacm_event_data_fid));
-			if(data_fid == NULL)
+		/* Construct new_neighbor msg with netdev device internally */
+		new_neigh_data = (ipacm_event_data_all*)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_all));
+		if(new_neigh_data == NULL)
+		{
+			IPACMERR("Failed to allocate memory.\n");
+			IPACM_DriverMsg::Free(data_ex);
+			return;
+		}
+		new_neigh_data->iptype = IPA_IP_v6;
+		for(cnt = 0; cnt < event_ex->num_of_attribs; cnt++)
+		{
+			if(event_ex->attribs[cnt].attrib_type == WLAN_HDR_ATTRIB_MAC_ADDR)
 			{
-				IPACMERR("unable to allocate memory for event_wlan data_fid\n");
-				return NULL;
+				memcpy(new_neigh_data->mac_addr, event_ex->attribs[cnt].u.mac_addr, sizeof(new_neigh_data->mac_addr));
+				IPACMDBG_H("Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
+							 event_ex->attribs[cnt].u.mac_addr[0], event_ex->attribs[cnt].u.mac_addr[1], event_ex->attribs[cnt].u.mac_addr[2],
+							 event_ex->attribs[cnt].u.mac_addr[3], event_ex->attribs[cnt].u.mac_addr[4], event_ex->attribs[cnt].u.mac_addr[5]);
 			}
-			ipa_get_if_index(event_wlan->name, &(data_fid->if_index));
-			evt_data.event = IPA_WLAN_AP_LINK_UP_EVENT;
-			evt_data.evt_data = data_fid;
-			break;
-
-		case WLAN_AP_DISCONNECT:
-			event_wlan = (struct ipa_wlan_msg *)(buffer + sizeof(struct ipa_msg_meta));
-			IPACMDBG_H("Received WLAN_AP_DISCONNECT name: %s\n",event_wlan->name);
-			IPACMDBG_H("AP Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
-							 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
-							 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
-                        data_fid = (ipacm_event_data_fid *)malloc(sizeof(ipacm_event_data_fid));
-			if(data_fid == NULL)
+			else if(event_ex->attribs[cnt].attrib_type == WLAN_HDR_ATTRIB_STA_ID)
 			{
-				IPACMERR("unable to allocate memory for event_wlan data_fid\n");
-				return NULL;
+				IPACMDBG_H("Wlan client id %d\n",event_ex->attribs[cnt].u.sta_id);
 			}
-			ipa_get_if_index(event_wlan->name, &(data_fid->if_index));
-			evt_data.event = IPA_WLAN_LINK_DOWN_EVENT;
-			evt_data.evt_data = data_fid;
-			break;
-		case WLAN_STA_CONNECT:
-			event_wlan = (struct ipa_wlan_msg *)(buffer + sizeof(struct ipa_msg_meta));
-			IPACMDBG_H("Received WLAN_STA_CONNECT name: %s\n",event_wlan->name);
-			IPACMDBG_H("STA Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
-							 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
-							 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
-			data = (ipacm_event_data_mac *)malloc(sizeof(ipacm_event_data_mac));
-			if(data == NULL)
+			else
 			{
-				IPACMERR("unable to allocate memory for event_wlan data_fid\n");
-				return NULL;
+				IPACMDBG_H("Wlan message has unexpected type!\n");
 			}
-			memcpy(data->mac_addr,
-				 event_wlan->mac_addr,
-				 sizeof(event_wlan->mac_addr));
-			ipa_get_if_index(event_wlan->name, &(data->if_index));
-			evt_data.event = IPA_WLAN_STA_LINK_UP_EVENT;
-			evt_data.evt_data = data;
+		}
+		new_neigh_data->if_index = data_ex->if_index;
+		new_neigh_evt.evt_data = (void*)new_neigh_data;
+		new_neigh_evt.event = IPA_NEW_NEIGH_EVENT;
+		break;
+
+	case WLAN_CLIENT_DISCONNECT:
+		IPACMDBG_H("Received WLAN_CLIENT_DISCONNECT\n");
+		event_wlan = (struct ipa_wlan_msg *)payload;
+		IPACMDBG_H("Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
+						 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
+						 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
+		data = (ipacm_event_data_mac *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_mac));
+		if (data == NULL)
+		{
+			IPACMERR("unable to allocate memory for event_wlan data\n");
+			return;
+		}
+		memcpy(data->mac_addr,
+					 event_wlan->mac_addr,
+					 sizeof(event_wlan->mac_addr));
+		ipa_get_if_index(event_wlan->name, &(data->if_index));
+		evt_data.event = IPA_WLAN_CLIENT_DEL_EVENT;
+		evt_data.evt_data = data;
+		break;
+
+	case WLAN_CLIENT_POWER_SAVE_MODE:
+		IPACMDBG_H("Received WLAN_CLIENT_POWER_SAVE_MODE\n");
+		event_wlan = (struct ipa_wlan_msg *)payload;
+		IPACMDBG_H("Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
+						 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
+						 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
+		data = (ipacm_event_data_mac *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_mac));
+		if (data == NULL)
+		{
+			IPACMERR("unable to allocate memory for event_wlan data\n");
+			return;
+		}
+		memcpy(data->mac_addr,
+					 event_wlan->mac_addr,
+					 sizeof(event_wlan->mac_addr));
+		ipa_get_if_index(event_wlan->name, &(data->if_index));
+		evt_data.event = IPA_WLAN_CLIENT_POWER_SAVE_EVENT;
+		evt_data.evt_data = data;
+		break;
+
+	case WLAN_CLIENT_NORMAL_MODE:
+		IPACMDBG_H("Received WLAN_CLIENT_NORMAL_MODE\n");
+		event_wlan = (struct ipa_wlan_msg *)payload;
+		IPACMDBG_H("Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
+						 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
+						 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
+		data = (ipacm_event_data_mac *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_mac));
+		if (data == NULL)
+		{
+			IPACMERR("unable to allocate memory for event_wlan data\n");
+			return;
+		}
+		memcpy(data->mac_addr,
+					 event_wlan->mac_addr,
+					 sizeof(event_wlan->mac_addr));
+		ipa_get_if_index(event_wlan->name, &(data->if_index));
+		evt_data.evt_data = data;
+		evt_data.event = IPA_WLAN_CLIENT_RECOVER_EVENT;
+		break;
+
+	case ECM_CONNECT:
+		event_ecm = (struct ipa_ecm_msg *)payload;
+		IPACMDBG_H("Received ECM_CONNECT name: %s\n",event_ecm->name);
+		data_fid = (ipacm_event_data_fid *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_fid));
+		if(data_fid == NULL)
+		{
+			IPACMERR("unable to allocate memory for event_ecm data_fid\n");
+			return;
+		}
+		data_fid->if_index = event_ecm->ifindex;
+		evt_data.event = IPA_USB_LINK_UP_EVENT;
+		evt_data.evt_data = data_fid;
+		break;
+
+	case ECM_DISCONNECT:
+		event_ecm = (struct ipa_ecm_msg *)payload;
+		IPACMDBG_H("Received ECM_DISCONNECT name: %s\n",event_ecm->name);
+		data_fid = (ipacm_event_data_fid *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_fid));
+		if(data_fid == NULL)
+		{
+			IPACMERR("unable to allocate memory for event_ecm data_fid\n");
+			return;
+		}
+		data_fid->if_index = event_ecm->ifindex;
+		evt_data.event = IPA_LINK_DOWN_EVENT;
+		evt_data.evt_data = data_fid;
+		break;
+	/* Add for 8994 Android case */
+	case WAN_UPSTREAM_ROUTE_ADD:
+		event_wan = (struct ipa_wan_msg *)payload;
+		IPACMDBG_H("Received WAN_UPSTREAM_ROUTE_ADD name: %s, tethered name: %s\n", event_wan->upstream_ifname, event_wan->tethered_ifname);
+		data_iptype = (ipacm_event_data_iptype *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_iptype));
+		if(data_iptype == NULL)
+		{
+			IPACMERR("unable to allocate memory for event_ecm data_iptype\n");
+			return;
+		}
+		ipa_get_if_index(event_wan->upstream_ifname, &(data_iptype->if_index));
+		ipa_get_if_index(event_wan->tethered_ifname, &(data_iptype->if_index_tether));
+		data_iptype->iptype = event_wan->ip;
+#ifdef IPA_WAN_MSG_IPv6_ADDR_GW_LEN
+		data_iptype->ipv4_addr_gw = event_wan->ipv4_addr_gw;
+		data_iptype->ipv6_addr_gw[0] = event_wan->ipv6_addr_gw[0];
+		data_iptype->ipv6_addr_gw[1] = event_wan->ipv6_addr_gw[1];
+		data_iptype->ipv6_addr_gw[2] = event_wan->ipv6_addr_gw[2];
+		data_iptype->ipv6_addr_gw[3] = event_wan->ipv6_addr_gw[3];
+		IPACMDBG_H("default gw ipv4 (%x)\n", data_iptype->ipv4_addr_gw);
+		IPACMDBG_H("IPV6 gateway: %08x:%08x:%08x:%08x \n",
+						data_iptype->ipv6_addr_gw[0], data_iptype->ipv6_addr_gw[1], data_iptype->ipv6_addr_gw[2], data_iptype->ipv6_addr_gw[3]);
+#endif
+		IPACMDBG_H("Received WAN_UPSTREAM_ROUTE_ADD: fid(%d) tether_fid(%d) ip-type(%d)\n", data_iptype->if_index,
+				data_iptype->if_index_tether, data_iptype->iptype);
+		evt_data.event = IPA_WAN_UPSTREAM_ROUTE_ADD_EVENT;
+		evt_data.evt_data = data_iptype;
+		break;
+	case WAN_UPSTREAM_ROUTE_DEL:
+		event_wan = (struct ipa_wan_msg *)payload;
+		IPACMDBG_H("Received WAN_UPSTREAM_ROUTE_DEL name: %s, tethered name: %s\n", event_wan->upstream_ifname, event_wan->tethered_ifname);
+		data_iptype = (ipacm_event_data_iptype *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_iptype));
+		if(data_iptype == NULL)
+		{
+			IPACMERR("unable to allocate memory for event_ecm data_iptype\n");
+			return;
+		}
+		ipa_get_if_index(event_wan->upstream_ifname, &(data_iptype->if_index));
+		ipa_get_if_index(event_wan->tethered_ifname, &(data_iptype->if_index_tether));
+		data_iptype->iptype = event_wan->ip;
+		IPACMDBG_H("Received WAN_UPSTREAM_ROUTE_DEL: fid(%d) ip-type(%d)\n", data_iptype->if_index, data_iptype->iptype);
+		evt_data.event = IPA_WAN_UPSTREAM_ROUTE_DEL_EVENT;
+		evt_data.evt_data = data_iptype;
+		break;
+	/* End of adding for 8994 Android case */
+
+	/* Add for embms case */
+	case WAN_EMBMS_CONNECT:
+		event_wan = (struct ipa_wan_msg *)payload;
+		IPACMDBG("Received WAN_EMBMS_CONNECT name: %s\n",event_wan->upstream_ifname);
+		data_fid = (ipacm_event_data_fid *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_fid));
+		if(data_fid == NULL)
+		{
+			IPACMERR("unable to allocate memory for event data_fid\n");
+			return;
+		}
+		ipa_get_if_index(event_wan->upstream_ifname, &(data_fid->if_index));
+		evt_data.event = IPA_WAN_EMBMS_LINK_UP_EVENT;
+		evt_data.evt_data = data_fid;
+		break;
+
+	case WLAN_SWITCH_TO_SCC:
+		IPACMDBG_H("Received WLAN_SWITCH_TO_SCC\n");
+	case WLAN_WDI_ENABLE:
+		IPACMDBG_H("Received WLAN_WDI_ENABLE\n");
+		if (IPACM_Iface::ipacmcfg->isMCC_Mode == true)
+		{
+			IPACM_Iface::ipacmcfg->isMCC_Mode = false;
+			evt_data.event = IPA_WLAN_SWITCH_TO_SCC;
 			break;
-
-		case WLAN_STA_DISCONNECT:
-			event_wlan = (struct ipa_wlan_msg *)(buffer + sizeof(struct ipa_msg_meta));
-			IPACMDBG_H("Received WLAN_STA_DISCONNECT name: %s\n",event_wlan->name);
-			IPACMDBG_H("STA Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
-							 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
-							 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
-                        data_fid = (ipacm_event_data_fid *)malloc(sizeof(ipacm_event_data_fid));
-			if(data_fid == NULL)
-			{
-				IPACMERR("unable to allocate memory for event_wlan data_fid\n");
-				return NULL;
-			}
-			ipa_get_if_index(event_wlan->name, &(data_fid->if_index));
-			evt_data.event = IPA_WLAN_LINK_DOWN_EVENT;
-			evt_data.evt_data = data_fid;
+		}
+		return;
+	case WLAN_SWITCH_TO_MCC:
+		IPACMDBG_H("Received WLAN_SWITCH_TO_MCC\n");
+	case WLAN_WDI_DISABLE:
+		IPACMDBG_H("Received WLAN_WDI_DISABLE\n");
+		if (IPACM_Iface::ipacmcfg->isMCC_Mode == false)
+		{
+			IPACM_Iface::ipacmcfg->isMCC_Mode = true;
+			evt_data.event = IPA_WLAN_SWITCH_TO_MCC;
 			break;
+		}
+		return;
+
+	case WAN_XLAT_CONNECT:
+		event_wan = (struct ipa_wan_msg *)payload;
+		IPACMDBG_H("Received WAN_XLAT_CONNECT name: %s\n",
+				event_wan->upstream_ifname);
+
+		/* post IPA_LINK_UP_EVENT event
+		 * may be WAN interface is not up
+		*/
+		data_fid = (ipacm_event_data_fid *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_fid));
+		if(data_fid == NULL)
+		{
+			IPACMERR("unable to allocate memory for xlat event\n");
+			return;
+		}
+		ipa_get_if_index(event_wan->upstream_ifname, &(data_fid->if_index));
+		evt_data.event = IPA_LINK_UP_EVENT;
+		evt_data.evt_data = data_fid;
+		ipa_driver_msg_post(&evt_data);
+
+		/* post IPA_WAN_XLAT_CONNECT_EVENT event */
+		data_fid = (ipacm_event_data_fid *)IPACM_DriverMsg::Carve(slot, sizeof(ipacm_event_data_fid));
+		if(data_fid == NULL)
+		{
+			IPACMERR("unable to allocate memory for xlat event\n");
+			return;
+		}
+		ipa_get_if_index(event_wan->upstream_ifname, &(data_fid->if_index));
+		evt_data.event = IPA_WAN_XLAT_CONNECT_EVENT;
+		evt_data.evt_data = data_fid;
+		break;
+
+	case IPA_TETHERING_STATS_UPDATE_STATS:
+		/* the stats response is handed over in place */
+		data_tethering_stats = (ipa_get_data_stats_resp_msg_v01 *)IPACM_DriverMsg::Adopt(slot,
+			sizeof(struct ipa_get_data_stats_resp_msg_v01));
+		if(data_tethering_stats == NULL)
+		{
+			IPACMERR("unable to allocate memory for event data_tethering_stats\n");
+			return;
+		}
+		IPACMDBG("Received IPA_TETHERING_STATS_UPDATE_STATS ipa_stats_type: %d\n",data_tethering_stats->ipa_stats_type);
+		IPACMDBG("Received %d UL, %d DL pipe stats\n",data_tethering_stats->ul_src_pipe_stats_list_len, data_tethering_stats->dl_dst_pipe_stats_list_len);
+		evt_data.event = IPA_TETHERING_STATS_UPDATE_EVENT;
+		evt_data.evt_data = data_tethering_stats;
+		break;
+
+	case IPA_TETHERING_STATS_UPDATE_NETWORK_STATS:
+		data_network_stats = (ipa_get_apn_data_stats_resp_msg_v01 *)IPACM_DriverMsg::Adopt(slot,
+			sizeof(struct ipa_get_apn_data_stats_resp_msg_v01));
+		if(data_network_stats == NULL)
+		{
+			IPACMERR("unable to allocate memory for event data_network_stats\n");
+			return;
+		}
+		IPACMDBG("Received %d apn network stats \n", data_network_stats->apn_data_stats_list_len);
+		evt_data.event = IPA_NETWORK_STATS_UPDATE_EVENT;
+		evt_data.evt_data = data_network_stats;
+		break;
 
-		case WLAN_CLIENT_CONNECT:
-			event_wlan = (struct ipa_wlan_msg *)(buffer + sizeof(struct ipa_msg_meta));
-			IPACMDBG_H("Received WLAN_CLIENT_CONNECT\n");
-			IPACMDBG_H("Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
-							 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
-							 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
-		        data = (ipacm_event_data_mac *)malloc(sizeof(ipacm_event_data_mac));
-		        if (data == NULL)
-		        {
-		    	        IPACMERR("unable to allocate memory for event_wlan data\n");
-		    	        return NULL;
-		        }
-			memcpy(data->mac_addr,
-						 event_wlan->mac_addr,
-						 sizeof(event_wlan->mac_addr));
-			ipa_get_if_index(event_wlan->name, &(data->if_index));
-		        evt_data.event = IPA_WLAN_CLIENT_ADD_EVENT;
-			evt_data.evt_data = data;
-			break;
+	default:
+		IPACMDBG_H("Unhandled message type: %d\n", event_hdr->msg_type);
+		return;
 
-		case WLAN_CLIENT_CONNECT_EX:
-			IPACMDBG_H("Received WLAN_CLIENT_CONNECT_EX\n");
+	}
+	/* finish command queue */
+	ipa_driver_msg_post(&evt_data);
+	/* push new_neighbor with netdev device internally */
+	if(new_neigh_data != NULL)
+	{
+		IPACMDBG_H("Internally post event IPA_NEW_NEIGH_EVENT\n");
+		ipa_driver_msg_post(&new_neigh_evt);
+	}
+	return;
+}
 
-			memcpy(&event_ex_o, buffer + sizeof(struct ipa_msg_meta),sizeof(struct ipa_wlan_msg_ex));
-			if(event_ex_o.num_of_attribs > IPA_DRIVER_WLAN_EVENT_MAX_OF_ATTRIBS)
-			{
-				IPACMERR("buffer size overflow\n");
-				return NULL;
-			}
-			length = sizeof(ipa_wlan_msg_ex)+ event_ex_o.num_of_attribs * sizeof(ipa_wlan_hdr_attrib_val);
-			IPACMDBG_H("num_of_attribs %d, length %d\n", event_ex_o.num_of_attribs, length);
-			event_ex = (ipa_wlan_msg_ex *)malloc(length);
-			if(event_ex == NULL )
-			{
-				IPACMERR("Unable to allocate memory\n");
-				return NULL;
-			}
-			memcpy(event_ex, buffer + sizeof(struct ipa_msg_meta), length);
-			data_ex = (ipacm_event_data_wlan_ex *)malloc(sizeof(ipacm_event_data_wlan_ex) + event_ex_o.num_of_attribs * sizeof(ipa_wlan_hdr_attrib_val));
-		    if (data_ex == NULL)
-		    {
-				IPACMERR("unable to allocate memory for event data\n");
-		    	return NULL;
-		    }
-			data_ex->num_of_attribs = event_ex->num_of_attribs;
-
-			memcpy(data_ex->attribs,
-						event_ex->attribs,
-						event_ex->num_of_attribs * sizeof(ipa_wlan_hdr_attrib_val));
-
-			ipa_get_if_index(event_ex->name, &(data_ex->if_index));
-			evt_data.event = IPA_WLAN_CLIENT_ADD_EVENT_EX;
-			evt_data.evt_data = data_ex;
-
-			/* Construct new_neighbor msg with netdev device internally */
-			new_neigh_data = (ipacm_event_data_all*)malloc(sizeof(ipacm_event_data_all));
-			if(new_neigh_data == NULL)
-			{
-				IPACMERR("Failed to allocate memory.\n");
-				return NULL;
-			}
-			memset(new_neigh_data, 0, sizeof(ipacm_event_data_all));
-			new_neigh_data->iptype = IPA_IP_v6;
-			for(cnt = 0; cnt < event_ex->num_of_attribs; cnt++)
-			{
-				if(event_ex->attribs[cnt].attrib_type == WLAN_HDR_ATTRIB_MAC_ADDR)
-				{
-					memcpy(new_neigh_data->mac_addr, event_ex->attribs[cnt].u.mac_addr, sizeof(new_neigh_data->mac_addr));
-					IPACMDBG_H("Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
-								 event_ex->attribs[cnt].u.mac_addr[0], event_ex->attribs[cnt].u.mac_addr[1], event_ex->attribs[cnt].u.mac_addr[2],
-								 event_ex->attribs[cnt].u.mac_addr[3], event_ex->attribs[cnt].u.mac_addr[4], event_ex->attribs[cnt].u.mac_addr[5]);
-				}
-				else if(event_ex->attribs[cnt].attrib_type == WLAN_HDR_ATTRIB_STA_ID)
-				{
-					IPACMDBG_H("Wlan client id %d\n",event_ex->attribs[cnt].u.sta_id);
-				}
-				else
-				{
-					IPACMDBG_H("Wlan message has unexpected type!\n");
-				}
-			}
-			new_neigh_data->if_index = data_ex->if_index;
-			new_neigh_evt.evt_data = (void*)new_neigh_data;
-			new_neigh_evt.event = IPA_NEW_NEIGH_EVENT;
-			free(event_ex);
-			break;
+void* ipa_driver_msg_notifier(void *param)
+{
+	int fd, nb_fd, cnt, i;
+	ipacm_drv_msg_slot *batch[IPA_DRIVER_MSG_BATCH];
+	ipacm_drv_msg_slot *slot;
+	uint64_t start = IPACM_EvtStats::now_usec();
 
-		case WLAN_CLIENT_DISCONNECT:
-			IPACMDBG_H("Received WLAN_CLIENT_DISCONNECT\n");
-			event_wlan = (struct ipa_wlan_msg *)(buffer + sizeof(struct ipa_msg_meta));
-			IPACMDBG_H("Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
-							 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
-							 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
-		        data = (ipacm_event_data_mac *)malloc(sizeof(ipacm_event_data_mac));
-		        if (data == NULL)
-		        {
-		    	        IPACMERR("unable to allocate memory for event_wlan data\n");
-		    	        return NULL;
-		        }
-			memcpy(data->mac_addr,
-						 event_wlan->mac_addr,
-						 sizeof(event_wlan->mac_addr));
-			ipa_get_if_index(event_wlan->name, &(data->if_index));
-			evt_data.event = IPA_WLAN_CLIENT_DEL_EVENT;
-			evt_data.evt_data = data;
-			break;
+	if (IPACM_DriverMsg::Init() != IPACM_SUCCESS)
+	{
+		return NULL;
+	}
 
-		case WLAN_CLIENT_POWER_SAVE_MODE:
-			IPACMDBG_H("Received WLAN_CLIENT_POWER_SAVE_MODE\n");
-			event_wlan = (struct ipa_wlan_msg *)(buffer + sizeof(struct ipa_msg_meta));
-			IPACMDBG_H("Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
-							 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
-							 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
-		        data = (ipacm_event_data_mac *)malloc(sizeof(ipacm_event_data_mac));
-		        if (data == NULL)
-		        {
-		    	        IPACMERR("unable to allocate memory for event_wlan data\n");
-		    	        return NULL;
-		        }
-			memcpy(data->mac_addr,
-						 event_wlan->mac_addr,
-						 sizeof(event_wlan->mac_addr));
-			ipa_get_if_index(event_wlan->name, &(data->if_index));
-			evt_data.event = IPA_WLAN_CLIENT_POWER_SAVE_EVENT;
-			evt_data.evt_data = data;
-			break;
+	fd = open(IPA_DRIVER, O_RDWR);
+	if (fd < 0)
+	{
+		IPACMERR("Failed opening %s.\n", IPA_DRIVER);
+		return NULL;
+	}
 
-		case WLAN_CLIENT_NORMAL_MODE:
-			IPACMDBG_H("Received WLAN_CLIENT_NORMAL_MODE\n");
-			event_wlan = (struct ipa_wlan_msg *)(buffer + sizeof(struct ipa_msg_meta));
-			IPACMDBG_H("Mac Address %02x:%02x:%02x:%02x:%02x:%02x\n",
-							 event_wlan->mac_addr[0], event_wlan->mac_addr[1], event_wlan->mac_addr[2],
-							 event_wlan->mac_addr[3], event_wlan->mac_addr[4], event_wlan->mac_addr[5]);
-		        data = (ipacm_event_data_mac *)malloc(sizeof(ipacm_event_data_mac));
-		        if (data == NULL)
-		        {
-		    	       IPACMERR("unable to allocate memory for event_wlan data\n");
-		    	       return NULL;
-		        }
-			memcpy(data->mac_addr,
-						 event_wlan->mac_addr,
-						 sizeof(event_wlan->mac_addr));
-			ipa_get_if_index(event_wlan->name, &(data->if_index));
-			evt_data.evt_data = data;
-			evt_data.event = IPA_WLAN_CLIENT_RECOVER_EVENT;
-			break;
+	/* second handle on the same driver message list, used to drain
+	   whatever else is pending after each wakeup without blocking */
+	nb_fd = open(IPA_DRIVER, O_RDWR | O_NONBLOCK);
+	if (nb_fd < 0)
+	{
+		IPACMERR("Failed opening %s non-blocking, read one message per wakeup\n", IPA_DRIVER);
+	}
+	IPACM_Startup::Stage("ipa driver open", start);
 
-		case ECM_CONNECT:
-			memcpy(&event_ecm, buffer + sizeof(struct ipa_msg_meta), sizeof(struct ipa_ecm_msg));
-			IPACMDBG_H("Received ECM_CONNECT name: %s\n",event_ecm.name);
-			data_fid = (ipacm_event_data_fid *)malloc(sizeof(ipacm_event_data_fid));
-			if(data_fid == NULL)
-			{
-				IPACMERR("unable to allocate memory for event_ecm data_fid\n");
-				return NULL;
-			}
-			data_fid->if_index = event_ecm.ifindex;
-			evt_data.event = IPA_USB_LINK_UP_EVENT;
-			evt_data.evt_data = data_fid;
-			break;
+	/* messages need the configuration, the driver keeps them queued until then */
+	IPACM_Startup::WaitReady();
 
-		case ECM_DISCONNECT:
-			memcpy(&event_ecm, buffer + sizeof(struct ipa_msg_meta), sizeof(struct ipa_ecm_msg));
-			IPACMDBG_H("Received ECM_DISCONNECT name: %s\n",event_ecm.name);
-			data_fid = (ipacm_event_data_fid *)malloc(sizeof(ipacm_event_data_fid));
-			if(data_fid == NULL)
-			{
-				IPACMERR("unable to allocate memory for event_ecm data_fid\n");
-				return NULL;
-			}
-			data_fid->if_index = event_ecm.ifindex;
-			evt_data.event = IPA_LINK_DOWN_EVENT;
-			evt_data.evt_data = data_fid;
-			break;
-		/* Add for 8994 Android case */
-		case WAN_UPSTREAM_ROUTE_ADD:
-			memcpy(&event_wan, buffer + sizeof(struct ipa_msg_meta), sizeof(struct ipa_wan_msg));
-			IPACMDBG_H("Received WAN_UPSTREAM_ROUTE_ADD name: %s, tethered name: %s\n", event_wan.upstream_ifname, event_wan.tethered_ifname);
-			data_iptype = (ipacm_event_data_iptype *)malloc(sizeof(ipacm_event_data_iptype));
-			if(data_iptype == NULL)
-			{
-				IPACMERR("unable to allocate memory for event_ecm data_iptype\n");
-				return NULL;
-			}
-			ipa_get_if_index(event_wan.upstream_ifname, &(data_iptype->if_index));
-			ipa_get_if_index(event_wan.tethered_ifname, &(data_iptype->if_index_tether));
-			data_iptype->iptype = event_wan.ip;
-#ifdef IPA_WAN_MSG_IPv6_ADDR_GW_LEN
-			data_iptype->ipv4_addr_gw = event_wan.ipv4_addr_gw;
-			data_iptype->ipv6_addr_gw[0] = event_wan.ipv6_addr_gw[0];
-			data_iptype->ipv6_addr_gw[1] = event_wan.ipv6_addr_gw[1];
-			data_iptype->ipv6_addr_gw[2] = event_wan.ipv6_addr_gw[2];
-			data_iptype->ipv6_addr_gw[3] = event_wan.ipv6_addr_gw[3];
-			IPACMDBG_H("default gw ipv4 (%x)\n", data_iptype->ipv4_addr_gw);
-			IPACMDBG_H("IPV6 gateway: %08x:%08x:%08x:%08x \n",
-							data_iptype->ipv6_addr_gw[0], data_iptype->ipv6_addr_gw[1], data_iptype->ipv6_addr_gw[2], data_iptype->ipv6_addr_gw[3]);
-#endif
-			IPACMDBG_H("Received WAN_UPSTREAM_ROUTE_ADD: fid(%d) tether_fid(%d) ip-type(%d)\n", data_iptype->if_index,
-					data_iptype->if_index_tether, data_iptype->iptype);
-			evt_data.event = IPA_WAN_UPSTREAM_ROUTE_ADD_EVENT;
-			evt_data.evt_data = data_iptype;
-			break;
-		case WAN_UPSTREAM_ROUTE_DEL:
-			memcpy(&event_wan, buffer + sizeof(struct ipa_msg_meta), sizeof(struct ipa_wan_msg));
-			IPACMDBG_H("Received WAN_UPSTREAM_ROUTE_DEL name: %s, tethered name: %s\n", event_wan.upstream_ifname, event_wan.tethered_ifname);
-			data_iptype = (ipacm_event_data_iptype *)malloc(sizeof(ipacm_event_data_iptype));
-			if(data_iptype == NULL)
-			{
-				IPACMERR("unable to allocate memory for event_ecm data_iptype\n");
-				return NULL;
-			}
-			ipa_get_if_index(event_wan.upstream_ifname, &(data_iptype->if_index));
-			ipa_get_if_index(event_wan.tethered_ifname, &(data_iptype->if_index_tether));
-			data_iptype->iptype = event_wan.ip;
-			IPACMDBG_H("Received WAN_UPSTREAM_ROUTE_DEL: fid(%d) ip-type(%d)\n", data_iptype->if_index, data_iptype->iptype);
-			evt_data.event = IPA_WAN_UPSTREAM_ROUTE_DEL_EVENT;
-			evt_data.evt_data = data_iptype;
-			break;
-		/* End of adding for 8994 Android case */
-
-		/* Add for embms case */
-		case WAN_EMBMS_CONNECT:
-			memcpy(&event_wan, buffer + sizeof(struct ipa_msg_meta), sizeof(struct ipa_wan_msg));
-			IPACMDBG("Received WAN_EMBMS_CONNECT name: %s\n",event_wan.upstream_ifname);
-			data_fid = (ipacm_event_data_fid *)malloc(sizeof(ipacm_event_data_fid));
-			if(data_fid == NULL)
-			{
-				IPACMERR("unable to allocate memory for event data_fid\n");
-				return NULL;
-			}
-			ipa_get_if_index(event_wan.upstream_ifname, &(data_fid->if_index));
-			evt_data.event = IPA_WAN_EMBMS_LINK_UP_EVENT;
-			evt_data.evt_data = data_fid;
-			break;
+	while (1)
+	{
+		IPACMDBG_H("Waiting for nofications from IPA driver \n");
+		slot = IPACM_DriverMsg::Get(false);
+		slot->len = read(fd, slot->buf, IPA_DRIVER_WLAN_BUF_LEN);
+		if (slot->len < 0)
+		{
+			PERROR("didn't read IPA_driver correctly");
+			IPACM_DriverMsg::Put(slot);
+			continue;
+		}
+		batch[0] = slot;
+		cnt = 1;
 
-		case WLAN_SWITCH_TO_SCC:
-			IPACMDBG_H("Received WLAN_SWITCH_TO_SCC\n");
-		case WLAN_WDI_ENABLE:
-			IPACMDBG_H("Received WLAN_WDI_ENABLE\n");
-			if (IPACM_Iface::ipacmcfg->isMCC_Mode == true)
+		while (nb_fd >= 0 && cnt < IPA_DRIVER_MSG_BATCH)
+		{
+			slot = IPACM_DriverMsg::Get(true);
+			if (slot == NULL)
 			{
-				IPACM_Iface::ipacmcfg->isMCC_Mode = false;
-				evt_data.event = IPA_WLAN_SWITCH_TO_SCC;
 				break;
 			}
-			continue;
-		case WLAN_SWITCH_TO_MCC:
-			IPACMDBG_H("Received WLAN_SWITCH_TO_MCC\n");
-		case WLAN_WDI_DISABLE:
-			IPACMDBG_H("Received WLAN_WDI_DISABLE\n");
-			if (IPACM_Iface::ipacmcfg->isMCC_Mode == false)
+			slot->len = read(nb_fd, slot->buf, IPA_DRIVER_WLAN_BUF_LEN);
+			if (slot->len <= 0)
 			{
-				IPACM_Iface::ipacmcfg->isMCC_Mode = true;
-				evt_data.event = IPA_WLAN_SWITCH_TO_MCC;
+				if (slot->len < 0 && errno != EAGAIN)
+				{
+					PERROR("didn't drain IPA_driver correctly");
+				}
+				IPACM_DriverMsg::Put(slot);
 				break;
 			}
-			continue;
-
-		case WAN_XLAT_CONNECT:
-			memcpy(&event_wan, buffer + sizeof(struct ipa_msg_meta),
-				sizeof(struct ipa_wan_msg));
-			IPACMDBG_H("Received WAN_XLAT_CONNECT name: %s\n",
-					event_wan.upstream_ifname);
-
-			/* post IPA_LINK_UP_EVENT event
-			 * may be WAN interface is not up
-			*/
-			data_fid = (ipacm_event_data_fid *)calloc(1, sizeof(ipacm_event_data_fid));
-			if(data_fid == NULL)
-			{
-				IPACMERR("unable to allocate memory for xlat event\n");
-				return NULL;
-			}
-			ipa_get_if_index(event_wan.upstream_ifname, &(data_fid->if_index));
-			evt_data.event = IPA_LINK_UP_EVENT;
-			evt_data.evt_data = data_fid;
-			IPACMDBG_H("Posting IPA_LINK_UP_EVENT event:%d\n", evt_data.event);
-			IPACM_EvtDispatcher::PostEvt(&evt_data);
-
-			/* post IPA_WAN_XLAT_CONNECT_EVENT event */
-			memset(&evt_data, 0, sizeof(evt_data));
-			data_fid = (ipacm_event_data_fid *)calloc(1, sizeof(ipacm_event_data_fid));
-			if(data_fid == NULL)
-			{
-				IPACMERR("unable to allocate memory for xlat event\n");
-				return NULL;
-			}
-			ipa_get_if_index(event_wan.upstream_ifname, &(data_fid->if_index));
-			evt_data.event = IPA_WAN_XLAT_CONNECT_EVENT;
-			evt_data.evt_data = data_fid;
-			IPACMDBG_H("Posting IPA_WAN_XLAT_CONNECT_EVENT event:%d\n", evt_data.event);
-			break;
-
-		case IPA_TETHERING_STATS_UPDATE_STATS:
-			memcpy(&event_data_stats, buffer + sizeof(struct ipa_msg_meta), sizeof(struct ipa_get_data_stats_resp_msg_v01));
-			data_tethering_stats = (ipa_get_data_stats_resp_msg_v01 *)malloc(sizeof(struct ipa_get_data_stats_resp_msg_v01));
-			if(data_tethering_stats == NULL)
-			{
-				IPACMERR("unable to allocate memory for event data_tethering_stats\n");
-				return NULL;
-			}
-			memcpy(data_tethering_stats,
-					 &event_data_stats,
-						 sizeof(struct ipa_get_data_stats_resp_msg_v01));
-			IPACMDBG("Received IPA_TETHERING_STATS_UPDATE_STATS ipa_stats_type: %d\n",data_tethering_stats->ipa_stats_type);
-			IPACMDBG("Received %d UL, %d DL pipe stats\n",data_tethering_stats->ul_src_pipe_stats_list_len, data_tethering_stats->dl_dst_pipe_stats_list_len);
-			evt_data.event = IPA_TETHERING_STATS_UPDATE_EVENT;
-			evt_data.evt_data = data_tethering_stats;
-			break;
-
-		case IPA_TETHERING_STATS_UPDATE_NETWORK_STATS:
-			memcpy(&event_network_stats, buffer + sizeof(struct ipa_msg_meta), sizeof(struct ipa_get_apn_data_stats_resp_msg_v01));
-			data_network_stats = (ipa_get_apn_data_stats_resp_msg_v01 *)malloc(sizeof(ipa_get_apn_data_stats_resp_msg_v01));
-			if(data_network_stats == NULL)
-			{
-				IPACMERR("unable to allocate memory for event data_network_stats\n");
-				return NULL;
-			}
-			memcpy(data_network_stats,
-					 &event_network_stats,
-						 sizeof(struct ipa_get_apn_data_stats_resp_msg_v01));
-			IPACMDBG("Received %d apn network stats \n", data_network_stats->apn_data_stats_list_len);
-			evt_data.event = IPA_NETWORK_STATS_UPDATE_EVENT;
-			evt_data.evt_data = data_network_stats;
-			break;
-
-		default:
-			IPACMDBG_H("Unhandled message type: %d\n", event_hdr.msg_type);
-			continue;
-
+			batch[cnt++] = slot;
 		}
-		/* finish command queue */
-		IPACMDBG_H("Posting event:%d\n", evt_data.event);
-		IPACM_EvtDispatcher::PostEvt(&evt_data);
-		/* push new_neighbor with netdev device internally */
-		if(new_neigh_data != NULL)
+		IPACM_DriverMsg::RecordWakeup(cnt);
+		IPACMDBG_H("Read %d messages from IPA driver\n", cnt);
+
+		for (i = 0; i < cnt; i++)
 		{
-			IPACMDBG_H("Internally post event IPA_NEW_NEIGH_EVENT\n");
-			IPACM_EvtDispatcher::PostEvt(&new_neigh_evt);
+			ipa_driver_msg_process(batch[i]);
+			/* slices posted with the events keep the slot alive */
+			IPACM_DriverMsg::Put(batch[i]);
 		}
 	}
 
+	if (nb_fd >= 0)
+	{
+		(void)close(nb_fd);
+	}
 	(void)close(fd);
 	return NULL;
 }
@@ -728,32 +789,85 @@ void RegisterForSignals(void)
 }
 
 
+/* parse IPACM_cfg.xml, everything which needs it waits for IPACM_Startup::Ready */
+void* ipacm_config_start(void *param)
+{
+	uint64_t start = IPACM_EvtStats::now_usec();
+
+	if(pthread_setname_np(pthread_self(), "ipacm cfg") != 0)
+	{
+		IPACMERR("unable to set thread name\n");
+	}
+	IPACM_Iface::ipacmcfg = IPACM_Config::GetInstance();
+	IPACM_Startup::Stage("config xml", start);
+	return NULL;
+}
+
+/* parse the firewall file ahead of the first WAN up */
+void* ipacm_firewall_prefetch(void *param)
+{
+	IPACM_firewall_conf_t *firewall_config;
+	uint64_t start = IPACM_EvtStats::now_usec();
+
+	if(pthread_setname_np(pthread_self(), "ipacm fw prefetch") != 0)
+	{
+		IPACMERR("unable to set thread name\n");
+	}
+	firewall_config = (IPACM_firewall_conf_t *)calloc(1, sizeof(IPACM_firewall_conf_t));
+	if(firewall_config == NULL)
+	{
+		IPACMERR("unable to allocate firewall config\n");
+		return NULL;
+	}
+	strlcpy(firewall_config->firewall_config_file, IPACM_FIREWALL_XML_FILE, sizeof(firewall_config->firewall_config_file));
+	if(IPACM_read_firewall_xml_cached(firewall_config->firewall_config_file, firewall_config) != IPACM_SUCCESS)
+	{
+		IPACMDBG_H("no firewall file to prefetch\n");
+	}
+	free(firewall_config);
+	IPACM_Startup::Stage("firewall xml", start);
+	return NULL;
+}
+
 int main(int argc, char **argv)
 {
 	int ret;
+	uint64_t start;
 	pthread_t netlink_thread = 0, monitor_thread = 0, ipa_driver_thread = 0;
-	pthread_t cmd_queue_thread = 0;
+	pthread_t cmd_queue_thread = 0, stats_thread = 0;
+	pthread_t config_thread = 0, firewall_thread = 0;
+
+	IPACM_Startup::Begin();
 
 	/* check if ipacm is already running or not */
+	start = IPACM_EvtStats::now_usec();
 	ipa_is_ipacm_running();
+	IPACM_Startup::Stage("pid lock", start);
 
 	IPACMDBG_H("In main()\n");
-	IPACM_Neighbor *neigh = new IPACM_Neighbor();
-	IPACM_IfaceManager *ifacemgr = new IPACM_IfaceManager();
 
-#ifdef FEATURE_ETH_BRIDGE_LE
-	IPACM_LanToLan* lan2lan = new IPACM_LanToLan();
-#endif
-
-	IPACM_ConntrackClient *cc = IPACM_ConntrackClient::GetInstance();
-	CtList = new IPACM_ConntrackListener();
-
-	IPACMDBG_H("Staring IPA main\n");
-	IPACMDBG_H("ipa_cmdq_successful\n");
+	/* libxml2 has to be set up before two threads parse at the same time */
+	xmlInitParser();
 
+	ret = pthread_create(&config_thread, NULL, ipacm_config_start, NULL);
+	if (IPACM_SUCCESS != ret)
+	{
+		IPACMERR("unable to create config thread, parse inline\n");
+		config_thread = 0;
+		ipacm_config_start(NULL);
+	}
 
-	RegisterForSignals();
+	ret = pthread_create(&firewall_thread, NULL, ipacm_firewall_prefetch, NULL);
+	if (IPACM_SUCCESS != ret)
+	{
+		/* the first WAN up parses the file itself */
+		IPACMERR("unable to create firewall prefetch thread\n");
+		firewall_thread = 0;
+	}
 
+	/* the remaining threads start while the configuration is parsed,
+	   events they raise are queued until IPACM_Startup::Ready */
+	start = IPACM_EvtStats::now_usec();
 	if (IPACM_SUCCESS == cmd_queue_thread)
 	{
 		ret = pthread_create(&cmd_queue_thread, NULL, MessageQueue::Process, NULL);
@@ -816,7 +930,68 @@ int main(int argc, char **argv)
 			IPACMERR("unable to set thread name\n");
 		}
 	}
+	IPACM_Startup::Stage("thread spawn", start);
 
+	if (config_thread != 0)
+	{
+		pthread_join(config_thread, NULL);
+	}
+	if (IPACM_Iface::ipacmcfg == NULL)
+	{
+		IPACMERR("unable to read ipacm configuration\n");
+		return IPACM_FAILURE;
+	}
+
+	start = IPACM_EvtStats::now_usec();
+	if (IPACM_EvtExecutor::Start(IPACM_Iface::ipacmcfg->ipa_event_workers) != IPACM_SUCCESS)
+	{
+		IPACMERR("unable to start event workers, process all events inline\n");
+	}
+
+	IPACM_Neighbor *neigh = new IPACM_Neighbor();
+	IPACM_IfaceManager *ifacemgr = new IPACM_IfaceManager();
+
+#ifdef FEATURE_ETH_BRIDGE_LE
+	IPACM_LanToLan* lan2lan = new IPACM_LanToLan();
+#endif
+
+	IPACM_ConntrackClient *cc = IPACM_ConntrackClient::GetInstance();
+	CtList = new IPACM_ConntrackListener();
+
+	IPACMDBG_H("Staring IPA main\n");
+	IPACMDBG_H("ipa_cmdq_successful\n");
+
+
+	RegisterForSignals();
+	IPACM_Startup::Stage("listeners", start);
+
+	if (IPACM_Iface::ipacmcfg->ipacm_record_events)
+	{
+		MessageQueue::StartRecording(IPACM_EVT_RECORD_FILE);
+	}
+
+	/* release the command queue and the driver notifier */
+	IPACM_Startup::Ready();
+
+	/* stats endpoint is diagnostic only, ipacm keeps running without it */
+	ret = pthread_create(&stats_thread, NULL, IPACM_EvtStats::stats_server, NULL);
+	if (IPACM_SUCCESS != ret)
+	{
+		IPACMERR("unable to create event stats thread\n");
+	}
+	else
+	{
+		IPACMDBG_H("created event stats thread\n");
+		if(pthread_setname_np(stats_thread, "ipacm stats") != 0)
+		{
+			IPACMERR("unable to set thread name\n");
+		}
+	}
+
+	if (firewall_thread != 0)
+	{
+		pthread_join(firewall_thread, NULL);
+	}
 	pthread_join(cmd_queue_thread, NULL);
 	pthread_join(netlink_thread, NULL);
 	pthread_join(monitor_thread, NULL);
@@ -43,25 +43,243 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <IPACM_EvtDispatcher.h>
 #include "IPACM_Defs.h"
 #include "IPACM_Log.h"
+#include "IPACM_EvtStats.h"
 
+ipa_neighbor_stats IPACM_Neighbor::stats;
+
+static uint32_t neigh_hash_mac(uint8_t *mac)
+{
+	uint32_t hash = 2166136261U;
+	int i;
+
+	for(i = 0; i < IPA_MAC_ADDR_SIZE; i++)
+	{
+		hash ^= mac[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
 
 IPACM_Neighbor::IPACM_Neighbor()
 {
-	num_neighbor_client = 0;
-	circular_index = 0;
-	memset(neighbor_client, 0, IPA_MAX_NUM_NEIGHBOR_CLIENTS * sizeof(ipa_neighbor_client));
+	int i, hash_size;
+
+	max_neighbor_client = IPACM_Iface::ipacmcfg->GetNeighborMaxClients();
+	if(max_neighbor_client <= 0)
+	{
+		max_neighbor_client = IPA_MAX_NUM_NEIGHBOR_CLIENTS;
+	}
+
+	hash_size = 1;
+	while(hash_size < max_neighbor_client)
+	{
+		hash_size <<= 1;
+	}
+	hash_mask = hash_size - 1;
+
+	neighbor_client = (ipa_neighbor_client *)calloc(max_neighbor_client, sizeof(ipa_neighbor_client));
+	neighbor_hash = (int *)malloc(hash_size * sizeof(int));
+	if(neighbor_client == NULL || neighbor_hash == NULL)
+	{
+		IPACMERR("unable to allocate neighbor cache of %d clients\n", max_neighbor_client);
+		free(neighbor_client);
+		free(neighbor_hash);
+		neighbor_client = NULL;
+		neighbor_hash = NULL;
+		max_neighbor_client = 0;
+		hash_mask = -1;
+	}
+
+	for(i = 0; i <= hash_mask; i++)
+	{
+		neighbor_hash[i] = IPA_NEIGHBOR_INVALID;
+	}
+	for(i = 0; i < max_neighbor_client; i++)
+	{
+		neighbor_client[i].hash_next = (i + 1 < max_neighbor_client) ? i + 1 : IPA_NEIGHBOR_INVALID;
+	}
+	free_head = (max_neighbor_client > 0) ? 0 : IPA_NEIGHBOR_INVALID;
+	lru_head = IPA_NEIGHBOR_INVALID;
+	lru_tail = IPA_NEIGHBOR_INVALID;
+
+	memset(&stats, 0, sizeof(stats));
+	stats.capacity = max_neighbor_client;
+	IPACMDBG_H("neighbor cache of %d clients, %d buckets\n", max_neighbor_client, hash_mask + 1);
+
 	IPACM_EvtDispatcher::registr(IPA_WLAN_CLIENT_ADD_EVENT_EX, this);
 	IPACM_EvtDispatcher::registr(IPA_NEW_NEIGH_EVENT, this);
 	IPACM_EvtDispatcher::registr(IPA_DEL_NEIGH_EVENT, this);
 	return;
 }
 
+void IPACM_Neighbor::lru_unlink(int idx)
+{
+	ipa_neighbor_client *client = &neighbor_client[idx];
+
+	if(client->lru_prev != IPA_NEIGHBOR_INVALID)
+	{
+		neighbor_client[client->lru_prev].lru_next = client->lru_next;
+	}
+	else
+	{
+		lru_head = client->lru_next;
+	}
+	if(client->lru_next != IPA_NEIGHBOR_INVALID)
+	{
+		neighbor_client[client->lru_next].lru_prev = client->lru_prev;
+	}
+	else
+	{
+		lru_tail = client->lru_prev;
+	}
+	return;
+}
+
+void IPACM_Neighbor::lru_push_head(int idx)
+{
+	ipa_neighbor_client *client = &neighbor_client[idx];
+
+	client->lru_prev = IPA_NEIGHBOR_INVALID;
+	client->lru_next = lru_head;
+	if(lru_head != IPA_NEIGHBOR_INVALID)
+	{
+		neighbor_client[lru_head].lru_prev = idx;
+	}
+	else
+	{
+		lru_tail = idx;
+	}
+	lru_head = idx;
+	return;
+}
+
+void IPACM_Neighbor::hash_unlink(int idx)
+{
+	int *link = &neighbor_hash[neigh_hash_mac(neighbor_client[idx].mac_addr) & hash_mask];
+
+	while(*link != IPA_NEIGHBOR_INVALID)
+	{
+		if(*link == idx)
+		{
+			*link = neighbor_client[idx].hash_next;
+			return;
+		}
+		link = &neighbor_client[*link].hash_next;
+	}
+	IPACMERR("neighbor client %d is not hashed\n", idx);
+	return;
+}
+
+/* cached client of the MAC, refreshes its LRU position */
+ipa_neighbor_client* IPACM_Neighbor::find_client(uint8_t *mac_addr)
+{
+	int idx;
+
+	if(neighbor_hash == NULL)
+	{
+		return NULL;
+	}
+
+	stats.lookups++;
+	for(idx = neighbor_hash[neigh_hash_mac(mac_addr) & hash_mask]; idx != IPA_NEIGHBOR_INVALID;
+		idx = neighbor_client[idx].hash_next)
+	{
+		if(memcmp(neighbor_client[idx].mac_addr, mac_addr, sizeof(neighbor_client[idx].mac_addr)) == 0)
+		{
+			stats.hits++;
+			neighbor_client[idx].last_usec = IPACM_EvtStats::now_usec();
+			if(idx != lru_head)
+			{
+				lru_unlink(idx);
+				lru_push_head(idx);
+			}
+			return &neighbor_client[idx];
+		}
+	}
+	return NULL;
+}
+
+/* new cache entry of the MAC, replaces the least recently seen client when full */
+ipa_neighbor_client* IPACM_Neighbor::insert_client(uint8_t *mac_addr)
+{
+	int idx, bucket;
+	ipa_neighbor_client *client;
+
+	if(neighbor_hash == NULL)
+	{
+		return NULL;
+	}
+
+	if(free_head != IPA_NEIGHBOR_INVALID)
+	{
+		idx = free_head;
+		free_head = neighbor_client[idx].hash_next;
+		stats.active++;
+		if(stats.active > stats.peak)
+		{
+			stats.peak = stats.active;
+		}
+	}
+	else
+	{
+		idx = lru_tail;
+		IPACMDBG_H("neighbor cache full, replace client %02x:%02x:%02x:%02x:%02x:%02x idle %llu us\n",
+			neighbor_client[idx].mac_addr[0], neighbor_client[idx].mac_addr[1], neighbor_client[idx].mac_addr[2],
+			neighbor_client[idx].mac_addr[3], neighbor_client[idx].mac_addr[4], neighbor_client[idx].mac_addr[5],
+			(unsigned long long)(IPACM_EvtStats::now_usec() - neighbor_client[idx].last_usec));
+		hash_unlink(idx);
+		lru_unlink(idx);
+		stats.evicted++;
+	}
+
+	client = &neighbor_client[idx];
+	memset(client, 0, sizeof(*client));
+	memcpy(client->mac_addr, mac_addr, sizeof(client->mac_addr));
+	client->first_usec = IPACM_EvtStats::now_usec();
+	client->last_usec = client->first_usec;
+
+	bucket = neigh_hash_mac(mac_addr) & hash_mask;
+	client->hash_next = neighbor_hash[bucket];
+	neighbor_hash[bucket] = idx;
+	lru_push_head(idx);
+	stats.inserted++;
+	return client;
+}
+
+void IPACM_Neighbor::delete_client(ipa_neighbor_client *client)
+{
+	int idx = client - neighbor_client;
+
+	hash_unlink(idx);
+	lru_unlink(idx);
+	memset(client, 0, sizeof(*client));
+	client->hash_next = free_head;
+	free_head = idx;
+	stats.active--;
+	stats.deleted++;
+	return;
+}
+
+int IPACM_Neighbor::dump(char *buf, int len)
+{
+	int ret;
+
+	ret = snprintf(buf, len, "neighbor active=%u peak=%u max=%u lookups=%llu hits=%llu inserted=%u deleted=%u evicted=%u\n",
+		stats.active, stats.peak, stats.capacity, (unsigned long long)stats.lookups,
+		(unsigned long long)stats.hits, stats.inserted, stats.deleted, stats.evicted);
+	if(ret >= len)
+	{
+		ret = len - 1;
+	}
+	return ret;
+}
+
 void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 {
 	ipacm_event_data_all *data_all = NULL;
 	int i, ipa_interface_index;
 	ipacm_cmd_q_data evt_data;
-	int num_neighbor_client_temp = num_neighbor_client;
+	ipa_neighbor_client *client;
 
 	IPACMDBG("Recieved event %d\n", event);
 
@@ -96,58 +314,55 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 				}
 			}
 
-			for (i = 0; i < num_neighbor_client_temp; i++)
+			/* find the client */
+			client = find_client(client_mac_addr);
+			if (client != NULL)
 			{
-				/* find the client */
-				if (memcmp(neighbor_client[i].mac_addr, client_mac_addr, sizeof(neighbor_client[i].mac_addr)) == 0)
+				/* check if iface is not bridge interface*/
+				if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name) != 0)
 				{
-					/* check if iface is not bridge interface*/
-					if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name) != 0)
+					/* use previous ipv4 first */
+					if(data->if_index != client->iface_index)
 					{
-						/* use previous ipv4 first */
-						if(data->if_index != neighbor_client[i].iface_index)
-						{
-							IPACMERR("update new kernel iface index \n");
-							neighbor_client[i].iface_index = data->if_index;
-						}
+						IPACMERR("update new kernel iface index \n");
+						client->iface_index = data->if_index;
+					}
 
-						/* check if client associated with previous network interface */
-						if(ipa_interface_index != neighbor_client[i].ipa_if_num)
+					/* check if client associated with previous network interface */
+					if(ipa_interface_index != client->ipa_if_num)
+					{
+						IPACMERR("client associate to different AP \n");
+						return;
+					}
+
+					if (client->v4_addr != 0) /* not 0.0.0.0 */
+					{
+						evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
+						data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
+						if (data_all == NULL)
 						{
-							IPACMERR("client associate to different AP \n");
+							IPACMERR("Unable to allocate memory\n");
 							return;
 						}
-
-						if (neighbor_client[i].v4_addr != 0) /* not 0.0.0.0 */
-						{
-							evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
-							data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
-							if (data_all == NULL)
-							{
-								IPACMERR("Unable to allocate memory\n");
-								return;
-							}
-							data_all->iptype = IPA_IP_v4;
-							data_all->if_index = neighbor_client[i].iface_index;
-							data_all->ipv4_addr = neighbor_client[i].v4_addr; //use previous ipv4 address
-							memcpy(data_all->mac_addr,
-									neighbor_client[i].mac_addr,
-												sizeof(data_all->mac_addr));
-							evt_data.evt_data = (void *)data_all;
-							IPACM_EvtDispatcher::PostEvt(&evt_data);
-							/* ask for replaced iface name*/
-							ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
-							/* check for failure return */
-							if (IPACM_FAILURE == ipa_interface_index) {
-								IPACMERR("not supported iface id: %d\n", data_all->if_index);
-							} else {
-								IPACMDBG_H("Posted event %d, with %s for ipv4 client re-connect\n",
-									evt_data.event,
-									IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name);
-							}
+						data_all->iptype = IPA_IP_v4;
+						data_all->if_index = client->iface_index;
+						data_all->ipv4_addr = client->v4_addr; //use previous ipv4 address
+						memcpy(data_all->mac_addr,
+								client->mac_addr,
+											sizeof(data_all->mac_addr));
+						evt_data.evt_data = (void *)data_all;
+						IPACM_EvtDispatcher::PostEvt(&evt_data);
+						/* ask for replaced iface name*/
+						ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
+						/* check for failure return */
+						if (IPACM_FAILURE == ipa_interface_index) {
+							IPACMERR("not supported iface id: %d\n", data_all->if_index);
+						} else {
+							IPACMDBG_H("Posted event %d, with %s for ipv4 client re-connect\n",
+								evt_data.event,
+								IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name);
 						}
 					}
-					break;
 				}
 			}
 		}
@@ -186,40 +401,37 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 					if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name) == 0)
 					{
 						/* searh if seen this client or not*/
-						for (i = 0; i < num_neighbor_client_temp; i++)
+						client = find_client(data->mac_addr);
+						if (client != NULL)
 						{
-							if (memcmp(neighbor_client[i].mac_addr, data->mac_addr, sizeof(neighbor_client[i].mac_addr)) == 0)
+							data->if_index = client->iface_index;
+							client->v4_addr = data->ipv4_addr; // cache client's previous ipv4 address
+							/* construct IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT command and insert to command-queue */
+							if (event == IPA_NEW_NEIGH_EVENT)
+								evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
+							else
+								/* not to clean-up the client mac cache on bridge0 delneigh */
+								evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
+							data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
+							if (data_all == NULL)
 							{
-								data->if_index = neighbor_client[i].iface_index;
-								neighbor_client[i].v4_addr = data->ipv4_addr; // cache client's previous ipv4 address
-								/* construct IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT command and insert to command-queue */
-								if (event == IPA_NEW_NEIGH_EVENT)
-									evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
-								else
-									/* not to clean-up the client mac cache on bridge0 delneigh */
-									evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
-								data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
-								if (data_all == NULL)
-								{
-									IPACMERR("Unable to allocate memory\n");
-									return;
-								}
-								memcpy(data_all, data, sizeof(ipacm_event_data_all));
-								evt_data.evt_data = (void *)data_all;
-								IPACM_EvtDispatcher::PostEvt(&evt_data);
+								IPACMERR("Unable to allocate memory\n");
+								return;
+							}
+							memcpy(data_all, data, sizeof(ipacm_event_data_all));
+							evt_data.evt_data = (void *)data_all;
+							IPACM_EvtDispatcher::PostEvt(&evt_data);
 
-								/* ask for replaced iface name*/
-								ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
-								/* check for failure return */
-								if (IPACM_FAILURE == ipa_interface_index) {
-									IPACMERR("not supported iface id: %d\n", data_all->if_index);
-								} else {
-									IPACMDBG_H("Posted event %d,\
-										with %s for ipv4\n",
-										evt_data.event,
-										IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name);
-								}
-								break;
+							/* ask for replaced iface name*/
+							ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
+							/* check for failure return */
+							if (IPACM_FAILURE == ipa_interface_index) {
+								IPACMERR("not supported iface id: %d\n", data_all->if_index);
+							} else {
+								IPACMDBG_H("Posted event %d,\
+									with %s for ipv4\n",
+									evt_data.event,
+									IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name);
 							}
 						}
 					}
@@ -231,104 +443,38 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 							evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
 							/* Also save to cache for ipv4 */
 							/*searh if seen this client or not*/
-							for (i = 0; i < num_neighbor_client_temp; i++)
+							client = find_client(data->mac_addr);
+							if (client == NULL)
 							{
-								/* find the client */
-								if (memcmp(neighbor_client[i].mac_addr, data->mac_addr, sizeof(neighbor_client[i].mac_addr)) == 0)
-								{
-									/* update the network interface client associated */
-									neighbor_client[i].iface_index = data->if_index;
-									neighbor_client[i].ipa_if_num = ipa_interface_index;
-									neighbor_client[i].v4_addr = data->ipv4_addr; // cache client's previous ipv4 address
-									IPACMDBG_H("update cache %d-entry, with %s iface, ipv4 address: 0x%x\n",
-													i,
-													IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name,
-													data->ipv4_addr);
-									break;
-								}
+								/* not find client */
+								client = insert_client(data->mac_addr);
 							}
-							/* not find client */
-							if (i == num_neighbor_client_temp)
+							if (client != NULL)
 							{
-								if (num_neighbor_client_temp < IPA_MAX_NUM_NEIGHBOR_CLIENTS)
-								{
-									memcpy(neighbor_client[num_neighbor_client_temp].mac_addr,
-												data->mac_addr,
-												sizeof(data->mac_addr));
-									neighbor_client[num_neighbor_client_temp].iface_index = data->if_index;
-									/* cache the network interface client associated */
-									neighbor_client[num_neighbor_client_temp].ipa_if_num = ipa_interface_index;
-									neighbor_client[num_neighbor_client_temp].v4_addr = data->ipv4_addr;
-									num_neighbor_client++;
-									IPACMDBG_H("Cache client MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d\n",
-												neighbor_client[num_neighbor_client_temp].mac_addr[0],
-												neighbor_client[num_neighbor_client_temp].mac_addr[1],
-												neighbor_client[num_neighbor_client_temp].mac_addr[2],
-												neighbor_client[num_neighbor_client_temp].mac_addr[3],
-												neighbor_client[num_neighbor_client_temp].mac_addr[4],
-												neighbor_client[num_neighbor_client_temp].mac_addr[5],
-												num_neighbor_client);
-								}
-								else
-								{
-
-									IPACMERR("error:  neighbor client oversize! recycle %d-st entry ! \n", circular_index);
-									memcpy(neighbor_client[circular_index].mac_addr,
-												data->mac_addr,
-												sizeof(data->mac_addr));
-									neighbor_client[circular_index].iface_index = data->if_index;
-									/* cache the network interface client associated */
-									neighbor_client[circular_index].ipa_if_num = ipa_interface_index;
-									neighbor_client[circular_index].v4_addr = 0;
-									IPACMDBG_H("Copy wlan-iface client MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d, circular %d\n",
-													neighbor_client[circular_index].mac_addr[0],
-													neighbor_client[circular_index].mac_addr[1],
-													neighbor_client[circular_index].mac_addr[2],
-													neighbor_client[circular_index].mac_addr[3],
-													neighbor_client[circular_index].mac_addr[4],
-													neighbor_client[circular_index].mac_addr[5],
-													num_neighbor_client,
-													circular_index);
-									circular_index++;
-								}
+								/* update the network interface client associated */
+								client->iface_index = data->if_index;
+								client->ipa_if_num = ipa_interface_index;
+								client->v4_addr = data->ipv4_addr; // cache client's previous ipv4 address
+								IPACMDBG_H("Cache client MAC %02x:%02x:%02x:%02x:%02x:%02x with %s iface, ipv4 address: 0x%x, total client: %u\n",
+												client->mac_addr[0], client->mac_addr[1], client->mac_addr[2],
+												client->mac_addr[3], client->mac_addr[4], client->mac_addr[5],
+												IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name,
+												data->ipv4_addr, stats.active);
 							}
 						}
 						else
 						{
 							evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
 							/*searh if seen this client or not*/
-							for (i = 0; i < num_neighbor_client_temp; i++)
+							client = find_client(data->mac_addr);
+							if (client != NULL)
 							{
-								/* find the client */
-								if (memcmp(neighbor_client[i].mac_addr, data->mac_addr, sizeof(neighbor_client[i].mac_addr)) == 0)
-								{
-									IPACMDBG_H("Clean %d-st Cached client-MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d\n",
-												i,
-												neighbor_client[i].mac_addr[0],
-												neighbor_client[i].mac_addr[1],
-												neighbor_client[i].mac_addr[2],
-												neighbor_client[i].mac_addr[3],
-												neighbor_client[i].mac_addr[4],
-												neighbor_client[i].mac_addr[5],
-												num_neighbor_client);
-
-									memset(neighbor_client[i].mac_addr, 0, sizeof(neighbor_client[i].mac_addr));
-									neighbor_client[i].iface_index = 0;
-									neighbor_client[i].v4_addr = 0;
-									neighbor_client[i].ipa_if_num = 0;
-									for (; i < num_neighbor_client_temp - 1; i++)
-									{
-										memcpy(neighbor_client[i].mac_addr,
-													neighbor_client[i+1].mac_addr,
-													sizeof(neighbor_client[i].mac_addr));
-										neighbor_client[i].iface_index = neighbor_client[i+1].iface_index;
-										neighbor_client[i].v4_addr = neighbor_client[i+1].v4_addr;
-										neighbor_client[i].ipa_if_num = neighbor_client[i+1].ipa_if_num;
-									}
-									num_neighbor_client--;
-									IPACMDBG_H(" total number of left cased clients: %d\n", num_neighbor_client);
-									break;
-								}
+								IPACMDBG_H("Clean Cached client-MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %u\n",
+											client->mac_addr[0], client->mac_addr[1], client->mac_addr[2],
+											client->mac_addr[3], client->mac_addr[4], client->mac_addr[5],
+											stats.active);
+								delete_client(client);
+								IPACMDBG_H(" total number of left cased clients: %u\n", stats.active);
 							}
 							/* not find client, no need clean-up */
 						}
@@ -358,36 +504,33 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 					if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name) == 0)
 					{
 						/* searh if seen this client or not*/
-						for (i = 0; i < num_neighbor_client_temp; i++)
+						client = find_client(data->mac_addr);
+						if (client != NULL)
 						{
-							if (memcmp(neighbor_client[i].mac_addr, data->mac_addr, sizeof(neighbor_client[i].mac_addr)) == 0)
+							data->if_index = client->iface_index;
+							/* construct IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT command and insert to command-queue */
+							if (event == IPA_NEW_NEIGH_EVENT) evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
+							else evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
+							data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
+							if (data_all == NULL)
 							{
-								data->if_index = neighbor_client[i].iface_index;
-								/* construct IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT command and insert to command-queue */
-								if (event == IPA_NEW_NEIGH_EVENT) evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
-								else evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
-								data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
-								if (data_all == NULL)
-								{
-									IPACMERR("Unable to allocate memory\n");
-									return;
-								}
-								memcpy(data_all, data, sizeof(ipacm_event_data_all));
-								evt_data.evt_data = (void *)data_all;
-								IPACM_EvtDispatcher::PostEvt(&evt_data);
-								/* ask for replaced iface name*/
-								ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
-								/* check for failure return */
-								if (IPACM_FAILURE == ipa_interface_index) {
-									IPACMERR("not supported iface id: %d\n", data_all->if_index);
-								} else {
-									IPACMDBG_H("Posted event %d,\
-										with %s for ipv6\n",
-										evt_data.event,
-										IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name);
-								}
-								break;
-							};
+								IPACMERR("Unable to allocate memory\n");
+								return;
+							}
+							memcpy(data_all, data, sizeof(ipacm_event_data_all));
+							evt_data.evt_data = (void *)data_all;
+							IPACM_EvtDispatcher::PostEvt(&evt_data);
+							/* ask for replaced iface name*/
+							ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
+							/* check for failure return */
+							if (IPACM_FAILURE == ipa_interface_index) {
+								IPACMERR("not supported iface id: %d\n", data_all->if_index);
+							} else {
+								IPACMDBG_H("Posted event %d,\
+									with %s for ipv6\n",
+									evt_data.event,
+									IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name);
+							}
 						}
 					}
 					else
@@ -415,150 +558,93 @@ void IPACM_Neighbor::event_callback(ipa_cm_event_id event, void *param)
 				{
 					IPACMDBG(" Got Neighbor event with no ipv6/ipv4 address \n");
 					/*no ipv6 in data searh if seen this client or not*/
-					for (i = 0; i < num_neighbor_client_temp; i++)
+					client = find_client(data->mac_addr);
+					if (client != NULL)
 					{
-						/* find the client */
-						if (memcmp(neighbor_client[i].mac_addr, data->mac_addr, sizeof(neighbor_client[i].mac_addr)) == 0)
+						IPACMDBG_H(" find client, MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %u\n",
+											client->mac_addr[0], client->mac_addr[1], client->mac_addr[2],
+											client->mac_addr[3], client->mac_addr[4], client->mac_addr[5],
+											stats.active);
+						/* check if iface is not bridge interface*/
+						if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name) != 0)
 						{
-							IPACMDBG_H(" find %d-st client, MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d\n",
-												i,
-												neighbor_client[i].mac_addr[0],
-												neighbor_client[i].mac_addr[1],
-												neighbor_client[i].mac_addr[2],
-												neighbor_client[i].mac_addr[3],
-												neighbor_client[i].mac_addr[4],
-												neighbor_client[i].mac_addr[5],
-												num_neighbor_client);
-							/* check if iface is not bridge interface*/
-							if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name) != 0)
+							/* use previous ipv4 first */
+							if(data->if_index != client->iface_index)
 							{
-								/* use previous ipv4 first */
-								if(data->if_index != neighbor_client[i].iface_index)
-								{
-									IPACMDBG_H("update new kernel iface index \n");
-									neighbor_client[i].iface_index = data->if_index;
-								}
-
-								/* check if client associated with previous network interface */
-								if(ipa_interface_index != neighbor_client[i].ipa_if_num)
-								{
-									IPACMDBG_H("client associate to different AP \n");
-								}
+								IPACMDBG_H("update new kernel iface index \n");
+								client->iface_index = data->if_index;
+							}
 
-								if (neighbor_client[i].v4_addr != 0) /* not 0.0.0.0 */
-								{
-									/* construct IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT command and insert to command-queue */
-									if (event == IPA_NEW_NEIGH_EVENT)
-										evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
-									else
-										evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
-									data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
-									if (data_all == NULL)
-									{
-										IPACMERR("Unable to allocate memory\n");
-										return;
-									}
-									data_all->iptype = IPA_IP_v4;
-									data_all->if_index = neighbor_client[i].iface_index;
-									data_all->ipv4_addr = neighbor_client[i].v4_addr; //use previous ipv4 address
-									memcpy(data_all->mac_addr,
-											neighbor_client[i].mac_addr,
-														sizeof(data_all->mac_addr));
-									evt_data.evt_data = (void *)data_all;
-									IPACM_EvtDispatcher::PostEvt(&evt_data);
-									/* ask for replaced iface name*/
-									ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
-									/* check for failure return */
-									if (IPACM_FAILURE == ipa_interface_index) {
-										IPACMERR("not supported iface id: %d\n", data_all->if_index);
-									} else {
-										IPACMDBG_H("Posted event %d,\
-											with %s for ipv4 client re-connect\n",
-											evt_data.event,
-											IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name);
-									}
-								}
+							/* check if client associated with previous network interface */
+							if(ipa_interface_index != client->ipa_if_num)
+							{
+								IPACMDBG_H("client associate to different AP \n");
 							}
-							/* delete cache neighbor entry */
-							if (event == IPA_DEL_NEIGH_EVENT)
+
+							if (client->v4_addr != 0) /* not 0.0.0.0 */
 							{
-								IPACMDBG_H("Clean %d-st Cached client-MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d\n",
-										i,
-										neighbor_client[i].mac_addr[0],
-										neighbor_client[i].mac_addr[1],
-										neighbor_client[i].mac_addr[2],
-										neighbor_client[i].mac_addr[3],
-										neighbor_client[i].mac_addr[4],
-										neighbor_client[i].mac_addr[5],
-										num_neighbor_client);
-
-								memset(neighbor_client[i].mac_addr, 0, sizeof(neighbor_client[i].mac_addr));
-								neighbor_client[i].iface_index = 0;
-								neighbor_client[i].v4_addr = 0;
-								neighbor_client[i].ipa_if_num = 0;
-								for (; i < num_neighbor_client_temp - 1; i++)
+								/* construct IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT command and insert to command-queue */
+								if (event == IPA_NEW_NEIGH_EVENT)
+									evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_ADD_EVENT;
+								else
+									evt_data.event = IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT;
+								data_all = (ipacm_event_data_all *)malloc(sizeof(ipacm_event_data_all));
+								if (data_all == NULL)
 								{
-									memcpy(neighbor_client[i].mac_addr,
-												neighbor_client[i+1].mac_addr,
-												sizeof(neighbor_client[i].mac_addr));
-									neighbor_client[i].iface_index = neighbor_client[i+1].iface_index;
-									neighbor_client[i].v4_addr = neighbor_client[i+1].v4_addr;
-									neighbor_client[i].ipa_if_num = neighbor_client[i+1].ipa_if_num;
+									IPACMERR("Unable to allocate memory\n");
+									return;
+								}
+								data_all->iptype = IPA_IP_v4;
+								data_all->if_index = client->iface_index;
+								data_all->ipv4_addr = client->v4_addr; //use previous ipv4 address
+								memcpy(data_all->mac_addr,
+										client->mac_addr,
+													sizeof(data_all->mac_addr));
+								evt_data.evt_data = (void *)data_all;
+								IPACM_EvtDispatcher::PostEvt(&evt_data);
+								/* ask for replaced iface name*/
+								ipa_interface_index = IPACM_Iface::iface_ipa_index_query(data_all->if_index);
+								/* check for failure return */
+								if (IPACM_FAILURE == ipa_interface_index) {
+									IPACMERR("not supported iface id: %d\n", data_all->if_index);
+								} else {
+									IPACMDBG_H("Posted event %d,\
+										with %s for ipv4 client re-connect\n",
+										evt_data.event,
+										IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name);
 								}
-								num_neighbor_client--;
-								IPACMDBG_H(" total number of left cased clients: %d\n", num_neighbor_client);
 							}
-							break;
+						}
+						/* delete cache neighbor entry */
+						if (event == IPA_DEL_NEIGH_EVENT)
+						{
+							IPACMDBG_H("Clean Cached client-MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %u\n",
+									client->mac_addr[0], client->mac_addr[1], client->mac_addr[2],
+									client->mac_addr[3], client->mac_addr[4], client->mac_addr[5],
+									stats.active);
+							delete_client(client);
+							IPACMDBG_H(" total number of left cased clients: %u\n", stats.active);
 						}
 					}
 					/* not find client */
-					if ((i == num_neighbor_client_temp) && (event == IPA_NEW_NEIGH_EVENT))
+					else if (event == IPA_NEW_NEIGH_EVENT)
 					{
 						/* check if iface is not bridge interface*/
 						if (strcmp(IPACM_Iface::ipacmcfg->ipa_virtual_iface_name, IPACM_Iface::ipacmcfg->iface_table[ipa_interface_index].iface_name) != 0)
 						{
-							if (num_neighbor_client_temp < IPA_MAX_NUM_NEIGHBOR_CLIENTS)
+							client = insert_client(data->mac_addr);
+							if (client != NULL)
 							{
-								memcpy(neighbor_client[num_neighbor_client_temp].mac_addr,
-											data->mac_addr,
-											sizeof(data->mac_addr));
-								neighbor_client[num_neighbor_client_temp].iface_index = data->if_index;
+								client->iface_index = data->if_index;
 								/* cache the network interface client associated */
-								neighbor_client[num_neighbor_client_temp].ipa_if_num = ipa_interface_index;
-								neighbor_client[num_neighbor_client_temp].v4_addr = 0;
-								num_neighbor_client++;
-								IPACMDBG_H("Copy client MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d\n",
-												neighbor_client[num_neighbor_client_temp].mac_addr[0],
-												neighbor_client[num_neighbor_client_temp].mac_addr[1],
-												neighbor_client[num_neighbor_client_temp].mac_addr[2],
-												neighbor_client[num_neighbor_client_temp].mac_addr[3],
-												neighbor_client[num_neighbor_client_temp].mac_addr[4],
-												neighbor_client[num_neighbor_client_temp].mac_addr[5],
-												num_neighbor_client);
-								return;
-							}
-							else
-							{
-								IPACMERR("error:  neighbor client oversize! recycle %d-st entry ! \n", circular_index);
-								memcpy(neighbor_client[circular_index].mac_addr,
-											data->mac_addr,
-											sizeof(data->mac_addr));
-								neighbor_client[circular_index].iface_index = data->if_index;
-								/* cache the network interface client associated */
-								neighbor_client[circular_index].ipa_if_num = ipa_interface_index;
-								neighbor_client[circular_index].v4_addr = 0;
-								IPACMDBG_H("Copy wlan-iface client MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %d, circular %d\n",
-												neighbor_client[circular_index].mac_addr[0],
-												neighbor_client[circular_index].mac_addr[1],
-												neighbor_client[circular_index].mac_addr[2],
-												neighbor_client[circular_index].mac_addr[3],
-												neighbor_client[circular_index].mac_addr[4],
-												neighbor_client[circular_index].mac_addr[5],
-												num_neighbor_client,
-												circular_index);
-								circular_index++;
-								return;
+								client->ipa_if_num = ipa_interface_index;
+								client->v4_addr = 0;
+								IPACMDBG_H("Copy client MAC %02x:%02x:%02x:%02x:%02x:%02x\n, total client: %u\n",
+												client->mac_addr[0], client->mac_addr[1], client->mac_addr[2],
+												client->mac_addr[3], client->mac_addr[4], client->mac_addr[5],
+												stats.active);
 							}
+							return;
 						}
 					}
 				}
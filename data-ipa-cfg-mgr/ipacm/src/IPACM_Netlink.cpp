@@ -46,6 +46,8 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Netlink.h"
 #include "IPACM_EvtDispatcher.h"
 #include "IPACM_Log.h"
+#include "IPACM_Startup.h"
+#include "IPACM_EvtStats.h"
 
 int ipa_get_if_name(char *if_name, int if_index);
 int find_mask(int ip_v4_last, int *mask_value);
@@ -1637,6 +1639,7 @@ int ipa_nl_listener_init
 {
 	ipa_nl_sk_info_t sk_info;
 	int ret_val;
+	uint64_t start = IPACM_EvtStats::now_usec();
 
 	memset(&sk_info, 0, sizeof(ipa_nl_sk_info_t));
 	IPACMDBG_H("Entering IPA NL listener init\n");
@@ -1660,6 +1663,7 @@ int ipa_nl_listener_init
 		close(sk_info.sk_fd);
 		return IPACM_FAILURE;
 	}
+	IPACM_Startup::Stage("netlink socket", start);
 
 	/* Start the socket listener thread */
 	ret_val = ipa_nl_sock_listener_start(sk_fdset);
@@ -0,0 +1,558 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_Replay.cpp
+
+	@brief
+	ipacm_replay: feeds an IPACM event recording, or a synthetic IPv6
+	conntrack stream, through the listeners against the emulated IPA
+	device and reports events/sec, ioctls per event and the per-event
+	latency histograms. With -k it checks the conntrack kernel filters
+	against captured ctnetlink events instead.
+
+	@Author
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include "IPACM_CmdQueue.h"
+#include "IPACM_EvtDispatcher.h"
+#include "IPACM_EvtRecord.h"
+#include "IPACM_EvtStats.h"
+#include "IPACM_ReplayStubs.h"
+#include "IPACM_Defs.h"
+#include "IPACM_Neighbor.h"
+#include "IPACM_IfaceManager.h"
+#include "IPACM_ConntrackListener.h"
+#include "IPACM_ConntrackClient.h"
+#include "IPACM_Config.h"
+#include "IPACM_V6FlowTable.h"
+#include "IPACM_Log.h"
+
+#ifdef FEATURE_ETH_BRIDGE_LE
+#include "IPACM_LanToLan.h"
+#endif
+
+uint32_t ipacm_event_stats[IPACM_EVENT_MAX];
+
+/* synthetic IPv6 stream: every 4th client has no routing rule, every
+   8th flow is opened from the remote side */
+#define IPACM_REPLAY_V6_CLIENTS 16
+#define IPACM_REPLAY_V6_FLOW_EVENTS 8
+
+typedef struct
+{
+	uint32_t fed;
+	uint32_t skipped;
+	uint32_t processed;
+	uint32_t derived_recorded;
+	uint64_t recorded_usec;
+} ipacm_replay_stats;
+
+/* wan address of the captured ctnetlink events, the remote 8.8.8.8
+   is made a local address for the second pass */
+#define IPACM_REPLAY_CT_WAN_ADDR 0x64400005
+#define IPACM_REPLAY_CT_REMOTE_ADDR 0x08080808
+
+typedef struct
+{
+	const char *desc;
+	int tcp;	/* expected tcp filter result, -1: passes with the ipv6 flow table */
+	int udp;
+	const char *hex;
+} ipacm_replay_ct_msg;
+
+/* events of 192.168.1.2 to 8.8.8.8 with 100.64.0.5 as wan address,
+   read from the kernel's NFNLGRP_CONNTRACK_* groups */
+static const ipacm_replay_ct_msg ipacm_replay_ct_msgs[] =
+{
+	{ "tcp established, source nat", 1, 0,
+		"e80000000001000600000000718d6cea02000000340001801400018008000100"
+		"c0a8010208000200080808081c0002800500010006000000060002009c400000"
+		"0600030001bb0000340002801400018008000100080808080800020064400005"
+		"1c00028005000100060000000600020001bb0000060003009c40000008000c00"
+		"3ba2175608000300000001980800070000000258300004802c00018005000100"
+		"0300000005000200000000000500030000000000060004000000000006000500"
+		"000000001c001880080001000000000008000200000000000800030000000000"
+		"0800080000000000" },
+	{ "tcp established, wan address", 1, 0,
+		"e80000000001000600000000718d6cea02000000340001801400018008000100"
+		"6440000508000200080808081c0002800500010006000000060002009c410000"
+		"0600030001bb0000340002801400018008000100080808080800020064400005"
+		"1c00028005000100060000000600020001bb0000060003009c41000008000c00"
+		"3a3dc07c08000300000000080800070000000258300004802c00018005000100"
+		"0300000005000200000000000500030000000000060004000000000006000500"
+		"000000001c001880080001000000000008000200000000000800030000000000"
+		"0800080000000000" },
+	{ "tcp established, lan to lan", 0, 0,
+		"e80000000001000600000000718d6cea02000000340001801400018008000100"
+		"c0a8010208000200c0a801031c0002800500010006000000060002009c420000"
+		"0600030000160000340002801400018008000100c0a8010308000200c0a80102"
+		"1c00028005000100060000000600020000160000060003009c42000008000c00"
+		"7bd2a91608000300000000080800070000000258300004802c00018005000100"
+		"0300000005000200000000000500030000000000060004000000000006000500"
+		"000000001c001880080001000000000008000200000000000800030000000000"
+		"0800080000000000" },
+	{ "tcp syn sent, source nat", 0, 0,
+		"e80000000001000600000000718d6cea02000000340001801400018008000100"
+		"c0a8010208000200080808081c0002800500010006000000060002009c430000"
+		"0600030001bb0000340002801400018008000100080808080800020064400005"
+		"1c00028005000100060000000600020001bb0000060003009c43000008000c00"
+		"13db67f008000300000001980800070000000258300004802c00018005000100"
+		"0100000005000200000000000500030000000000060004000000000006000500"
+		"000000001c001880080001000000000008000200000000000800030000000000"
+		"0800080000000000" },
+	{ "udp, source nat", 0, 1,
+		"b80000000001000600000000718d6cea02000000340001801400018008000100"
+		"c0a8010208000200080808081c0002800500010011000000060002009c440000"
+		"0600030000350000340002801400018008000100080808080800020064400005"
+		"1c00028005000100110000000600020000350000060003009c44000008000c00"
+		"2ab07fae080003000000019808000700000002581c0018800800010000000000"
+		"080002000000000008000300000000000800080000000000" },
+	{ "tcp destroy, source nat", 1, 0,
+		"a40000000201000000000000718d6cea02000000340001801400018008000100"
+		"c0a8010208000200080808081c0002800500010006000000060002009c400000"
+		"0600030001bb0000340002801400018008000100080808080800020064400005"
+		"1c00028005000100060000000600020001bb0000060003009c40000008000c00"
+		"3ba2175608000300000003980800070000000258100004800c00018005000100"
+		"03000000" },
+	{ "ipv6 tcp established", -1, 0,
+		"1801000000010006000000002dba2cbd0a0000004c0001802c00018014000300"
+		"20010db800000000000000000000000214000400200148600000000000000000"
+		"000088881c0002800500010006000000060002009c4a00000600030001bb0000"
+		"4c0002802c000180140003002001486000000000000000000000888814000400"
+		"20010db80000000000000000000000021c000280050001000600000006000200"
+		"01bb0000060003009c4a000008000c00019b6532080003000000000808000700"
+		"00000258300004802c0001800500010003000000050002000000000005000300"
+		"00000000060004000000000006000500000000001c0018800800010000000000"
+		"080002000000000008000300000000000800080000000000" },
+};
+
+static void ipacm_replay_usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-v] [-c IPACM_cfg.xml] [-n loops] [-6 flows] [recording]\n", prog);
+	fprintf(stderr, "       %s [-v] [-c IPACM_cfg.xml] -k\n", prog);
+}
+
+static uint8_t* ipacm_replay_load(const char *path, long *size)
+{
+	FILE *fp;
+	uint8_t *buf;
+	ipacm_evt_rec_file_hdr hdr;
+
+	fp = fopen(path, "r");
+	if(fp == NULL)
+	{
+		fprintf(stderr, "unable to open %s (%s)\n", path, strerror(errno));
+		return NULL;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	*size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if(*size < (long)sizeof(hdr))
+	{
+		fprintf(stderr, "%s is not an event recording\n", path);
+		fclose(fp);
+		return NULL;
+	}
+
+	buf = (uint8_t *)malloc(*size);
+	if(buf == NULL || fread(buf, *size, 1, fp) != 1)
+	{
+		fprintf(stderr, "unable to read %s\n", path);
+		free(buf);
+		fclose(fp);
+		return NULL;
+	}
+	fclose(fp);
+
+	memcpy(&hdr, buf, sizeof(hdr));
+	if(hdr.magic != IPACM_EVT_REC_MAGIC || hdr.version != IPACM_EVT_REC_VERSION)
+	{
+		fprintf(stderr, "%s: bad magic or version\n", path);
+		free(buf);
+		return NULL;
+	}
+	if(hdr.event_max != IPACM_EVENT_MAX)
+	{
+		fprintf(stderr, "%s: recorded with %d events, this build has %d\n", path,
+			hdr.event_max, IPACM_EVENT_MAX);
+		free(buf);
+		return NULL;
+	}
+
+	return buf;
+}
+
+/* walk the records, feed the external ones when feed is set */
+static int ipacm_replay_run(const uint8_t *buf, long size, bool feed, ipacm_replay_stats *stats)
+{
+	long off = sizeof(ipacm_evt_rec_file_hdr);
+	ipacm_evt_rec_hdr rec;
+	ipacm_evt_rec_iface iface;
+	ipacm_cmd_q_data evt_data;
+
+	while(off + (long)sizeof(rec) <= size)
+	{
+		memcpy(&rec, buf + off, sizeof(rec));
+		off += sizeof(rec);
+		if(off + rec.len > size)
+		{
+			fprintf(stderr, "truncated record at offset %ld\n", off);
+			return IPACM_FAILURE;
+		}
+
+		if(!feed)
+		{
+			if(rec.type == IPACM_EVT_REC_IFACE && rec.len == sizeof(iface))
+			{
+				memcpy(&iface, buf + off, sizeof(iface));
+				iface.if_name[sizeof(iface.if_name) - 1] = '\0';
+				ipacm_stub_add_iface(iface.if_index, iface.if_name);
+			}
+			else if(rec.type == IPACM_EVT_REC_EVENT && (rec.flags & IPACM_EVT_REC_F_DERIVED))
+			{
+				stats->derived_recorded++;
+			}
+			stats->recorded_usec = rec.ts_usec;
+		}
+		else if(rec.type == IPACM_EVT_REC_EVENT && !(rec.flags & IPACM_EVT_REC_F_DERIVED))
+		{
+			memset(&evt_data, 0, sizeof(evt_data));
+			evt_data.event = (ipa_cm_event_id)rec.event;
+			if(rec.event >= IPACM_EVENT_MAX ||
+				 IPACM_EvtRecord::Decode(&rec, buf + off, &evt_data.evt_data) != IPACM_SUCCESS)
+			{
+				stats->skipped++;
+			}
+			else if(IPACM_EvtDispatcher::PostEvt(&evt_data) != IPACM_SUCCESS)
+			{
+				free(evt_data.evt_data);
+				stats->skipped++;
+			}
+			else
+			{
+				stats->fed++;
+				stats->processed += MessageQueue::Drain();
+			}
+		}
+
+		off += rec.len;
+	}
+
+	return IPACM_SUCCESS;
+}
+
+/* 2001:db8:0:net::host in network byte order, or host order for
+   IPACM_V6FlowTable when to_net is false */
+static void ipacm_replay_v6_addr(uint32_t *addr, uint32_t net, uint32_t host, bool to_net)
+{
+	addr[0] = to_net ? htonl(0x20010db8) : 0x20010db8;
+	addr[1] = to_net ? htonl(net) : net;
+	addr[2] = 0;
+	addr[3] = to_net ? htonl(host) : host;
+}
+
+/* IPA_PROCESS_CT_MESSAGE_V6 events of 'flows' concurrent flows: each flow
+   is opened, updated and destroyed in IPACM_REPLAY_V6_FLOW_EVENTS events,
+   flows are picked at random so their lifetimes overlap */
+static int ipacm_replay_v6_stream(int flows, ipacm_replay_stats *stats)
+{
+	uint32_t client[4], remote[4];
+	uint8_t *left;
+	unsigned int seed = 1;
+	ipacm_cmd_q_data evt_data;
+	ipacm_ct_evt_data *ct_data;
+	struct nf_conntrack *ct;
+	int cnt, flow;
+	uint8_t proto;
+
+	left = (uint8_t *)calloc(flows, sizeof(uint8_t));
+	if(left == NULL)
+	{
+		fprintf(stderr, "unable to allocate %d flows\n", flows);
+		return IPACM_FAILURE;
+	}
+
+	for(cnt = 0; cnt < IPACM_REPLAY_V6_CLIENTS; cnt++)
+	{
+		if(cnt % 4 != 3)
+		{
+			ipacm_replay_v6_addr(client, 1, cnt + 1, false);
+			IPACM_V6FlowTable::AddRoutedAddr(client);
+		}
+	}
+
+	for(cnt = 0; cnt < flows * IPACM_REPLAY_V6_FLOW_EVENTS; cnt++)
+	{
+		flow = rand_r(&seed) % flows;
+		ct = nfct_new();
+		ct_data = (ipacm_ct_evt_data *)malloc(sizeof(ipacm_ct_evt_data));
+		if(ct == NULL || ct_data == NULL)
+		{
+			fprintf(stderr, "unable to allocate conntrack event\n");
+			if(ct != NULL)
+			{
+				nfct_destroy(ct);
+			}
+			free(ct_data);
+			free(left);
+			return IPACM_FAILURE;
+		}
+
+		if(left[flow] == 0)
+		{
+			ct_data->type = NFCT_T_NEW;
+			left[flow] = IPACM_REPLAY_V6_FLOW_EVENTS - 1;
+		}
+		else
+		{
+			ct_data->type = (--left[flow] == 0) ? NFCT_T_DESTROY : NFCT_T_UPDATE;
+		}
+
+		ipacm_replay_v6_addr(client, 1, flow % IPACM_REPLAY_V6_CLIENTS + 1, true);
+		ipacm_replay_v6_addr(remote, 0xffff, flow + 1, true);
+		proto = (flow % 3) ? IPPROTO_TCP : IPPROTO_UDP;
+		nfct_set_attr_u8(ct, ATTR_ORIG_L3PROTO, AF_INET6);
+		nfct_set_attr_u8(ct, ATTR_REPL_L3PROTO, AF_INET6);
+		nfct_set_attr_u8(ct, ATTR_ORIG_L4PROTO, proto);
+		nfct_set_attr(ct, ATTR_ORIG_IPV6_SRC, (flow % 8 == 7) ? remote : client);
+		nfct_set_attr(ct, ATTR_ORIG_IPV6_DST, (flow % 8 == 7) ? client : remote);
+		nfct_set_attr_u16(ct, ATTR_ORIG_PORT_SRC, htons(1024 + flow % 60000));
+		nfct_set_attr_u16(ct, ATTR_ORIG_PORT_DST, htons((proto == IPPROTO_TCP) ? 443 : 53));
+		if(proto == IPPROTO_TCP)
+		{
+			nfct_set_attr_u8(ct, ATTR_TCP_STATE, TCP_CONNTRACK_ESTABLISHED);
+		}
+
+		memset(&evt_data, 0, sizeof(evt_data));
+		ct_data->ct = ct;
+		evt_data.event = IPA_PROCESS_CT_MESSAGE_V6;
+		evt_data.evt_data = (void *)ct_data;
+		if(IPACM_EvtDispatcher::PostEvt(&evt_data) != IPACM_SUCCESS)
+		{
+			nfct_destroy(ct);
+			free(ct_data);
+			stats->skipped++;
+			continue;
+		}
+		stats->fed++;
+		stats->processed += MessageQueue::Drain();
+	}
+
+	free(left);
+	return IPACM_SUCCESS;
+}
+
+/* run every captured event through both kernel filters, returns the
+   number of unexpected results */
+static int ipacm_replay_ct_filter_pass(bool remote_local)
+{
+	uint8_t msg[512];
+	const char *hex;
+	int cnt, len, tcp, udp, exp_tcp, exp_udp, failed = 0;
+	unsigned int val;
+
+	for(cnt = 0; cnt < (int)(sizeof(ipacm_replay_ct_msgs) / sizeof(ipacm_replay_ct_msgs[0])); cnt++)
+	{
+		hex = ipacm_replay_ct_msgs[cnt].hex;
+		for(len = 0; len < (int)sizeof(msg) && sscanf(hex + 2 * len, "%2x", &val) == 1; len++)
+		{
+			msg[len] = val;
+		}
+
+		exp_tcp = ipacm_replay_ct_msgs[cnt].tcp;
+		exp_udp = ipacm_replay_ct_msgs[cnt].udp;
+		if(exp_tcp < 0)
+		{
+			exp_tcp = IPACM_V6FlowTable::IsEnabled() ? 1 : 0;
+		}
+		else if(remote_local)
+		{
+			exp_tcp = 0;
+			exp_udp = 0;
+		}
+
+		tcp = IPACM_ConntrackClient::RunKernelFilter(IPPROTO_TCP, msg, len);
+		udp = IPACM_ConntrackClient::RunKernelFilter(IPPROTO_UDP, msg, len);
+		if(tcp != exp_tcp || udp != exp_udp)
+		{
+			failed++;
+		}
+		fprintf(stderr, "%-32s tcp %-6s udp %-6s %s\n", ipacm_replay_ct_msgs[cnt].desc,
+			(tcp < 0) ? "error" : (tcp ? "ACCEPT" : "DROP"),
+			(udp < 0) ? "error" : (udp ? "ACCEPT" : "DROP"),
+			(tcp != exp_tcp || udp != exp_udp) ? "FAILED" : "ok");
+	}
+
+	return failed;
+}
+
+int main(int argc, char **argv)
+{
+	int opt, loops = 1, v6_flows = 0, i;
+	bool verbose = false, ct_filter = false;
+	const char *cfg_file = NULL;
+	const char *recording = NULL;
+	uint8_t *buf = NULL;
+	long size = 0;
+	uint64_t start, elapsed;
+	ipacm_replay_stats stats;
+
+	while((opt = getopt(argc, argv, "vc:n:6:k")) != -1)
+	{
+		switch(opt)
+		{
+		case 'v':
+			verbose = true;
+			break;
+		case 'c':
+			cfg_file = optarg;
+			break;
+		case 'n':
+			loops = atoi(optarg);
+			break;
+		case '6':
+			v6_flows = atoi(optarg);
+			break;
+		case 'k':
+			ct_filter = true;
+			break;
+		default:
+			ipacm_replay_usage(argv[0]);
+			return IPACM_FAILURE;
+		}
+	}
+
+	if(optind < argc)
+	{
+		recording = argv[optind];
+	}
+	if((recording == NULL && v6_flows <= 0 && !ct_filter) || loops <= 0 || v6_flows < 0)
+	{
+		ipacm_replay_usage(argv[0]);
+		return IPACM_FAILURE;
+	}
+
+	/* IPACM logs to stdout, the report goes to stderr */
+	if(!verbose && freopen("/dev/null", "w", stdout) == NULL)
+	{
+		fprintf(stderr, "unable to silence ipacm logs\n");
+	}
+
+	if(cfg_file != NULL)
+	{
+		IPACM_Config::config_file = cfg_file;
+		if(IPACM_Iface::ipacmcfg != NULL)
+		{
+			IPACM_Iface::ipacmcfg->Init();
+		}
+	}
+	if(IPACM_Iface::ipacmcfg == NULL)
+	{
+		IPACM_Iface::ipacmcfg = IPACM_Config::GetInstance();
+	}
+	if(IPACM_Iface::ipacmcfg == NULL)
+	{
+		fprintf(stderr, "unable to load %s\n", IPACM_Config::config_file);
+		return IPACM_FAILURE;
+	}
+
+	memset(&stats, 0, sizeof(stats));
+	if(recording != NULL)
+	{
+		buf = ipacm_replay_load(recording, &size);
+		if(buf == NULL)
+		{
+			return IPACM_FAILURE;
+		}
+		ipacm_replay_run(buf, size, false, &stats);
+	}
+
+	new IPACM_Neighbor();
+	new IPACM_IfaceManager();
+#ifdef FEATURE_ETH_BRIDGE_LE
+	new IPACM_LanToLan();
+#endif
+	CtList = new IPACM_ConntrackListener();
+
+	if(ct_filter)
+	{
+		IPACM_ConntrackClient::UpdateWanAddr(IPACM_REPLAY_CT_WAN_ADDR);
+		fprintf(stderr, "conntrack kernel filters, ipv6 flow table %s\n",
+			IPACM_V6FlowTable::IsEnabled() ? "enabled" : "disabled");
+		i = ipacm_replay_ct_filter_pass(false);
+		IPACM_ConntrackClient::AddIgnoreAddr(IPACM_REPLAY_CT_REMOTE_ADDR);
+		fprintf(stderr, "with 8.8.8.8 as local address\n");
+		i += ipacm_replay_ct_filter_pass(true);
+		fprintf(stderr, "%d unexpected filter result(s)\n", i);
+		return (i == 0) ? IPACM_SUCCESS : IPACM_FAILURE;
+	}
+
+	ipacm_stub_reset_stats();
+	start = IPACM_EvtStats::now_usec();
+	for(i = 0; i < loops; i++)
+	{
+		if(buf != NULL && ipacm_replay_run(buf, size, true, &stats) != IPACM_SUCCESS)
+		{
+			break;
+		}
+		if(v6_flows > 0 && ipacm_replay_v6_stream(v6_flows, &stats) != IPACM_SUCCESS)
+		{
+			break;
+		}
+	}
+	elapsed = IPACM_EvtStats::now_usec() - start;
+
+	if(recording != NULL)
+	{
+		fprintf(stderr, "recording: %s, %llu ms, %u listener generated events\n", recording,
+			(unsigned long long)stats.recorded_usec / 1000, stats.derived_recorded);
+	}
+	if(v6_flows > 0)
+	{
+		fprintf(stderr, "synthetic ipv6: %d flows, %d events per flow, table %s\n", v6_flows,
+			IPACM_REPLAY_V6_FLOW_EVENTS, IPACM_V6FlowTable::IsEnabled() ? "enabled" : "disabled");
+	}
+	fprintf(stderr, "replayed: %d loop(s), fed=%u skipped=%u dispatched=%u (generated %u)\n",
+		loops, stats.fed, stats.skipped, stats.processed, stats.processed - stats.fed);
+	fprintf(stderr, "elapsed: %llu us, %.0f events/sec\n", (unsigned long long)elapsed,
+		elapsed ? (double)stats.fed * 1000000 / elapsed : 0.0);
+	ipacm_stub_dump_stats(stderr, stats.fed);
+	fflush(stderr);
+	IPACM_EvtStats::dump(STDERR_FILENO);
+
+	free(buf);
+	return IPACM_SUCCESS;
+}
@@ -0,0 +1,545 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_ReplayStubs.cpp
+
+	@brief
+	This file implements the IPA device emulation used by ipacm_replay.
+
+	open(), close() and ioctl() are interposed at link time: requests on
+	the IPA device nodes (IPACM_Filtering, IPACM_Routing, IPACM_Header,
+	IPACM_Iface, ipanat) are answered here with fresh handles and are
+	counted, everything else goes to the kernel.
+
+	@Author
+
+*/
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <net/if.h>
+#include <linux/msm_ipa.h>
+#include "IPACM_ReplayStubs.h"
+#include "IPACM_Defs.h"
+#include "IPACM_Conntrack_NATApp.h"
+
+#define IPACM_STUB_NAT_DEV "/dev/ipaNatTable"
+#define IPACM_STUB_ETH_HDR_LEN 14
+
+typedef struct
+{
+	int if_index;
+	char if_name[IF_NAMESIZE];
+} ipacm_stub_iface;
+
+static const char *ipacm_stub_dev[] =
+{
+	"/dev/ipa",
+	"/dev/wwan_ioctl",
+	"/dev/odu_ipa_bridge"
+};
+
+static ipacm_stub_iface stub_iface[IPACM_STUB_MAX_IFACE];
+static int stub_num_iface = 0;
+static int stub_fd[IPACM_STUB_MAX_FD];
+static int stub_num_fd = 0;
+static size_t stub_nat_size = 0;
+static uint32_t stub_next_hdl = 1;
+static ipacm_stub_ioctl_stats stub_stats;
+
+#define IPACM_STUB_IOC(x) { x, #x }
+static const struct
+{
+	unsigned long req;
+	const char *name;
+} ipacm_stub_ioc_names[] =
+{
+	IPACM_STUB_IOC(IPA_IOC_ADD_HDR),
+	IPACM_STUB_IOC(IPA_IOC_DEL_HDR),
+	IPACM_STUB_IOC(IPA_IOC_ADD_RT_RULE),
+	IPACM_STUB_IOC(IPA_IOC_DEL_RT_RULE),
+	IPACM_STUB_IOC(IPA_IOC_ADD_FLT_RULE),
+	IPACM_STUB_IOC(IPA_IOC_DEL_FLT_RULE),
+	IPACM_STUB_IOC(IPA_IOC_COMMIT_HDR),
+	IPACM_STUB_IOC(IPA_IOC_RESET_HDR),
+	IPACM_STUB_IOC(IPA_IOC_COMMIT_RT),
+	IPACM_STUB_IOC(IPA_IOC_RESET_RT),
+	IPACM_STUB_IOC(IPA_IOC_COMMIT_FLT),
+	IPACM_STUB_IOC(IPA_IOC_RESET_FLT),
+	IPACM_STUB_IOC(IPA_IOC_GET_RT_TBL),
+	IPACM_STUB_IOC(IPA_IOC_PUT_RT_TBL),
+	IPACM_STUB_IOC(IPA_IOC_COPY_HDR),
+	IPACM_STUB_IOC(IPA_IOC_QUERY_INTF),
+	IPACM_STUB_IOC(IPA_IOC_QUERY_INTF_TX_PROPS),
+	IPACM_STUB_IOC(IPA_IOC_QUERY_INTF_RX_PROPS),
+	IPACM_STUB_IOC(IPA_IOC_QUERY_INTF_EXT_PROPS),
+	IPACM_STUB_IOC(IPA_IOC_GET_HDR),
+	IPACM_STUB_IOC(IPA_IOC_ALLOC_NAT_MEM),
+	IPACM_STUB_IOC(IPA_IOC_V4_INIT_NAT),
+	IPACM_STUB_IOC(IPA_IOC_NAT_DMA),
+	IPACM_STUB_IOC(IPA_IOC_V4_DEL_NAT),
+	IPACM_STUB_IOC(IPA_IOC_GET_NAT_OFFSET),
+	IPACM_STUB_IOC(IPA_IOC_GENERATE_FLT_EQ),
+	IPACM_STUB_IOC(IPA_IOC_QUERY_EP_MAPPING),
+	IPACM_STUB_IOC(IPA_IOC_QUERY_RT_TBL_INDEX),
+	IPACM_STUB_IOC(IPA_IOC_WRITE_QMAPID),
+	IPACM_STUB_IOC(IPA_IOC_MDFY_FLT_RULE),
+	IPACM_STUB_IOC(IPA_IOC_MDFY_RT_RULE),
+	IPACM_STUB_IOC(IPA_IOC_ADD_HDR_PROC_CTX),
+	IPACM_STUB_IOC(IPA_IOC_DEL_HDR_PROC_CTX),
+	IPACM_STUB_IOC(IPA_IOC_RM_ADD_DEPENDENCY),
+	IPACM_STUB_IOC(IPA_IOC_RM_DEL_DEPENDENCY),
+#ifdef FEATURE_IPA_V3
+	IPACM_STUB_IOC(IPA_IOC_ADD_FLT_RULE_AFTER),
+#endif
+};
+
+int ipacm_stub_add_iface(int if_index, const char *if_name)
+{
+	int i;
+
+	for(i = 0; i < stub_num_iface; i++)
+	{
+		if(stub_iface[i].if_index == if_index)
+		{
+			break;
+		}
+	}
+
+	if(i == IPACM_STUB_MAX_IFACE)
+	{
+		return IPACM_FAILURE;
+	}
+
+	stub_iface[i].if_index = if_index;
+	strlcpy(stub_iface[i].if_name, if_name, sizeof(stub_iface[i].if_name));
+	if(i == stub_num_iface)
+	{
+		stub_num_iface++;
+	}
+	return IPACM_SUCCESS;
+}
+
+void ipacm_stub_get_stats(ipacm_stub_ioctl_stats *stats)
+{
+	memcpy(stats, &stub_stats, sizeof(stub_stats));
+}
+
+void ipacm_stub_reset_stats(void)
+{
+	memset(&stub_stats, 0, sizeof(stub_stats));
+}
+
+void ipacm_stub_dump_stats(FILE *fp, uint32_t events)
+{
+	unsigned int i;
+	uint32_t cnt;
+
+	fprintf(fp, "ioctls: ipa=%u other=%u per-event=%.2f\n", stub_stats.ipa, stub_stats.other,
+		events ? (double)stub_stats.ipa / events : 0.0);
+	for(i = 0; i < sizeof(ipacm_stub_ioc_names) / sizeof(ipacm_stub_ioc_names[0]); i++)
+	{
+		cnt = stub_stats.nr[_IOC_NR(ipacm_stub_ioc_names[i].req) % IPACM_STUB_IOC_NR_MAX];
+		if(cnt > 0)
+		{
+			fprintf(fp, "  %-28s %u\n", ipacm_stub_ioc_names[i].name, cnt);
+		}
+	}
+}
+
+static bool ipacm_stub_is_fake(int fd)
+{
+	int i;
+
+	for(i = 0; i < stub_num_fd; i++)
+	{
+		if(stub_fd[i] == fd)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/* unlinked temporary file, mmap-able for the NAT table */
+static int ipacm_stub_open_dev(const char *path)
+{
+	char tmpl[] = "/tmp/ipacm_replay_XXXXXX";
+	int fd;
+
+	if(stub_num_fd == IPACM_STUB_MAX_FD)
+	{
+		errno = EMFILE;
+		return -1;
+	}
+
+	fd = mkstemp(tmpl);
+	if(fd < 0)
+	{
+		return -1;
+	}
+	unlink(tmpl);
+
+	if(strncmp(path, IPACM_STUB_NAT_DEV, strlen(IPACM_STUB_NAT_DEV)) == 0 && stub_nat_size > 0)
+	{
+		if(ftruncate(fd, stub_nat_size) < 0)
+		{
+			syscall(SYS_close, fd);
+			return -1;
+		}
+	}
+
+	stub_fd[stub_num_fd++] = fd;
+	return fd;
+}
+
+static bool ipacm_stub_is_dev(const char *path)
+{
+	unsigned int i;
+
+	for(i = 0; i < sizeof(ipacm_stub_dev) / sizeof(ipacm_stub_dev[0]); i++)
+	{
+		if(strncmp(path, ipacm_stub_dev[i], strlen(ipacm_stub_dev[i])) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void ipacm_stub_fill_tx(struct ipa_ioc_query_intf_tx_props *tx_prop)
+{
+	uint32_t i;
+
+	for(i = 0; i < tx_prop->num_tx_props; i++)
+	{
+		memset(&tx_prop->tx[i], 0, sizeof(tx_prop->tx[i]));
+		tx_prop->tx[i].ip = (i % 2) ? IPA_IP_v6 : IPA_IP_v4;
+		tx_prop->tx[i].dst_pipe = IPA_CLIENT_APPS_LAN_CONS;
+		tx_prop->tx[i].alt_dst_pipe = IPA_CLIENT_APPS_LAN_CONS;
+		tx_prop->tx[i].hdr_l2_type = IPA_HDR_L2_ETHERNET_II;
+		snprintf(tx_prop->tx[i].hdr_name, sizeof(tx_prop->tx[i].hdr_name), "%s_%s",
+			tx_prop->name, (i % 2) ? "v6" : "v4");
+	}
+}
+
+static void ipacm_stub_fill_rx(struct ipa_ioc_query_intf_rx_props *rx_prop)
+{
+	uint32_t i;
+
+	for(i = 0; i < rx_prop->num_rx_props; i++)
+	{
+		memset(&rx_prop->rx[i], 0, sizeof(rx_prop->rx[i]));
+		rx_prop->rx[i].ip = (i % 2) ? IPA_IP_v6 : IPA_IP_v4;
+		rx_prop->rx[i].src_pipe = IPA_CLIENT_APPS_LAN_WAN_PROD;
+		rx_prop->rx[i].hdr_l2_type = IPA_HDR_L2_ETHERNET_II;
+	}
+}
+
+static int ipacm_stub_ipa_ioctl(unsigned long req, void *arg)
+{
+	int i;
+
+	stub_stats.ipa++;
+	stub_stats.nr[_IOC_NR(req) % IPACM_STUB_IOC_NR_MAX]++;
+
+	switch(req)
+	{
+	case IPA_IOC_QUERY_INTF:
+		((struct ipa_ioc_query_intf *)arg)->num_tx_props = 2;
+		((struct ipa_ioc_query_intf *)arg)->num_rx_props = 2;
+		((struct ipa_ioc_query_intf *)arg)->num_ext_props = 0;
+		((struct ipa_ioc_query_intf *)arg)->excp_pipe = IPA_CLIENT_APPS_LAN_CONS;
+		break;
+
+	case IPA_IOC_QUERY_INTF_TX_PROPS:
+		ipacm_stub_fill_tx((struct ipa_ioc_query_intf_tx_props *)arg);
+		break;
+
+	case IPA_IOC_QUERY_INTF_RX_PROPS:
+		ipacm_stub_fill_rx((struct ipa_ioc_query_intf_rx_props *)arg);
+		break;
+
+	case IPA_IOC_ADD_HDR:
+	{
+		struct ipa_ioc_add_hdr *hdr = (struct ipa_ioc_add_hdr *)arg;
+		for(i = 0; i < hdr->num_hdrs; i++)
+		{
+			hdr->hdr[i].hdr_hdl = stub_next_hdl++;
+			hdr->hdr[i].status = 0;
+		}
+		break;
+	}
+
+	case IPA_IOC_ADD_HDR_PROC_CTX:
+	{
+		struct ipa_ioc_add_hdr_proc_ctx *ctx = (struct ipa_ioc_add_hdr_proc_ctx *)arg;
+		for(i = 0; i < ctx->num_proc_ctxs; i++)
+		{
+			ctx->proc_ctx[i].proc_ctx_hdl = stub_next_hdl++;
+			ctx->proc_ctx[i].status = 0;
+		}
+		break;
+	}
+
+	case IPA_IOC_ADD_RT_RULE:
+	{
+		struct ipa_ioc_add_rt_rule *rt = (struct ipa_ioc_add_rt_rule *)arg;
+		for(i = 0; i < rt->num_rules; i++)
+		{
+			rt->rules[i].rt_rule_hdl = stub_next_hdl++;
+			rt->rules[i].status = 0;
+		}
+		break;
+	}
+
+	case IPA_IOC_ADD_FLT_RULE:
+	{
+		struct ipa_ioc_add_flt_rule *flt = (struct ipa_ioc_add_flt_rule *)arg;
+		for(i = 0; i < flt->num_rules; i++)
+		{
+			flt->rules[i].flt_rule_hdl = stub_next_hdl++;
+			flt->rules[i].status = 0;
+		}
+		break;
+	}
+
+#ifdef FEATURE_IPA_V3
+	case IPA_IOC_ADD_FLT_RULE_AFTER:
+	{
+		struct ipa_ioc_add_flt_rule_after *flt = (struct ipa_ioc_add_flt_rule_after *)arg;
+		for(i = 0; i < flt->num_rules; i++)
+		{
+			flt->rules[i].flt_rule_hdl = stub_next_hdl++;
+			flt->rules[i].status = 0;
+		}
+		break;
+	}
+#endif
+
+	case IPA_IOC_MDFY_FLT_RULE:
+	{
+		struct ipa_ioc_mdfy_flt_rule *flt = (struct ipa_ioc_mdfy_flt_rule *)arg;
+		for(i = 0; i < flt->num_rules; i++)
+		{
+			flt->rules[i].status = 0;
+		}
+		break;
+	}
+
+	case IPA_IOC_MDFY_RT_RULE:
+	{
+		struct ipa_ioc_mdfy_rt_rule *rt = (struct ipa_ioc_mdfy_rt_rule *)arg;
+		for(i = 0; i < rt->num_rules; i++)
+		{
+			rt->rules[i].status = 0;
+		}
+		break;
+	}
+
+	case IPA_IOC_DEL_HDR:
+	{
+		struct ipa_ioc_del_hdr *del = (struct ipa_ioc_del_hdr *)arg;
+		for(i = 0; i < del->num_hdls; i++)
+		{
+			del->hdl[i].status = 0;
+		}
+		break;
+	}
+
+	case IPA_IOC_DEL_HDR_PROC_CTX:
+	{
+		struct ipa_ioc_del_hdr_proc_ctx *del = (struct ipa_ioc_del_hdr_proc_ctx *)arg;
+		for(i = 0; i < del->num_hdls; i++)
+		{
+			del->hdl[i].status = 0;
+		}
+		break;
+	}
+
+	case IPA_IOC_DEL_RT_RULE:
+	{
+		struct ipa_ioc_del_rt_rule *del = (struct ipa_ioc_del_rt_rule *)arg;
+		for(i = 0; i < del->num_hdls; i++)
+		{
+			del->hdl[i].status = 0;
+		}
+		break;
+	}
+
+	case IPA_IOC_DEL_FLT_RULE:
+	{
+		struct ipa_ioc_del_flt_rule *del = (struct ipa_ioc_del_flt_rule *)arg;
+		for(i = 0; i < del->num_hdls; i++)
+		{
+			del->hdl[i].status = 0;
+		}
+		break;
+	}
+
+	case IPA_IOC_GET_HDR:
+		((struct ipa_ioc_get_hdr *)arg)->hdl = stub_next_hdl++;
+		break;
+
+	case IPA_IOC_GET_RT_TBL:
+		((struct ipa_ioc_get_rt_tbl *)arg)->hdl = stub_next_hdl++;
+		break;
+
+	case IPA_IOC_QUERY_RT_TBL_INDEX:
+		((struct ipa_ioc_get_rt_tbl_indx *)arg)->idx = 1;
+		break;
+
+	case IPA_IOC_COPY_HDR:
+	{
+		struct ipa_ioc_copy_hdr *copy = (struct ipa_ioc_copy_hdr *)arg;
+		memset(copy->hdr, 0, sizeof(copy->hdr));
+		copy->hdr_len = IPACM_STUB_ETH_HDR_LEN;
+		copy->type = IPA_HDR_L2_ETHERNET_II;
+		copy->is_partial = 1;
+		copy->is_eth2_ofst_valid = 1;
+		copy->eth2_ofst = 0;
+		break;
+	}
+
+	case IPA_IOC_QUERY_EP_MAPPING:
+		/* argument is the client type, answer with a pipe number */
+		return (int)((uintptr_t)arg % 20) + 1;
+
+	case IPA_IOC_ALLOC_NAT_MEM:
+	{
+		struct ipa_ioc_nat_alloc_mem *mem = (struct ipa_ioc_nat_alloc_mem *)arg;
+		strlcpy(mem->dev_name, IPACM_STUB_NAT_DEV, sizeof(mem->dev_name));
+		mem->offset = 0;
+		stub_nat_size = mem->size;
+		break;
+	}
+
+	case IPA_IOC_GET_NAT_OFFSET:
+		*(uint32_t *)arg = 0;
+		break;
+
+	default:
+		/* commit, reset, nat dma, rm dependency, wwan ioctls: nothing to answer */
+		break;
+	}
+
+	return 0;
+}
+
+static int ipacm_stub_ifreq(int fd, unsigned long req, struct ifreq *ifr)
+{
+	int i;
+
+	for(i = 0; i < stub_num_iface; i++)
+	{
+		if(req == SIOCGIFNAME && stub_iface[i].if_index == ifr->ifr_ifindex)
+		{
+			strlcpy(ifr->ifr_name, stub_iface[i].if_name, sizeof(ifr->ifr_name));
+			return 0;
+		}
+		if(req == SIOCGIFINDEX && strncmp(stub_iface[i].if_name, ifr->ifr_name, sizeof(ifr->ifr_name)) == 0)
+		{
+			ifr->ifr_ifindex = stub_iface[i].if_index;
+			return 0;
+		}
+	}
+
+	return syscall(SYS_ioctl, fd, req, ifr);
+}
+
+extern "C" int open(const char *path, int flags, ...)
+{
+	va_list ap;
+	mode_t mode = 0;
+
+	if(flags & O_CREAT)
+	{
+		va_start(ap, flags);
+		mode = va_arg(ap, int);
+		va_end(ap);
+	}
+
+	if(path != NULL && ipacm_stub_is_dev(path))
+	{
+		return ipacm_stub_open_dev(path);
+	}
+
+	/* replays start without nat checkpoint and leave the real one alone */
+	if(path != NULL && strcmp(path, IPACM_NAT_CACHE_FILE) == 0)
+	{
+		return ipacm_stub_open_dev(path);
+	}
+
+	return syscall(SYS_openat, AT_FDCWD, path, flags, mode);
+}
+
+extern "C" int close(int fd)
+{
+	int i;
+
+	for(i = 0; i < stub_num_fd; i++)
+	{
+		if(stub_fd[i] == fd)
+		{
+			stub_fd[i] = stub_fd[--stub_num_fd];
+			break;
+		}
+	}
+
+	return syscall(SYS_close, fd);
+}
+
+extern "C" int ioctl(int fd, unsigned long req, ...)
+{
+	va_list ap;
+	void *arg;
+
+	va_start(ap, req);
+	arg = va_arg(ap, void *);
+	va_end(ap);
+
+	if(ipacm_stub_is_fake(fd))
+	{
+		return ipacm_stub_ipa_ioctl(req, arg);
+	}
+
+	stub_stats.other++;
+	if(req == SIOCGIFNAME || req == SIOCGIFINDEX)
+	{
+		return ipacm_stub_ifreq(fd, req, (struct ifreq *)arg);
+	}
+
+	return syscall(SYS_ioctl, fd, req, arg);
+}
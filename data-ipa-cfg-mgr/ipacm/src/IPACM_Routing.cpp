@@ -246,6 +246,73 @@ fail:
 	return res;
 }
 
+bool IPACM_Routing::DeleteRoutingHdls(uint32_t *rt_rule_hdls, ipa_ip_type ip, int num_rules)
+{
+	struct ipa_ioc_del_rt_rule *rt_rule;
+	bool res = true;
+	int len = 0, cnt = 0, batch = 0, i;
+
+	if (num_rules <= 0)
+	{
+		return res;
+	}
+
+	batch = (num_rules < IPA_MAX_DEL_HDLS) ? num_rules : IPA_MAX_DEL_HDLS;
+	len = (sizeof(struct ipa_ioc_del_rt_rule)) + (batch * sizeof(struct ipa_rt_rule_del));
+	rt_rule = (struct ipa_ioc_del_rt_rule *)malloc(len);
+	if (rt_rule == NULL)
+	{
+		IPACMERR("unable to allocate memory for del route rule\n");
+		return false;
+	}
+
+	/* num_hdls is 8 bits wide in the ioctl, so large sets go in chunks */
+	while (cnt < num_rules)
+	{
+		memset(rt_rule, 0, len);
+		rt_rule->commit = 1;
+		rt_rule->ip = ip;
+
+		while (cnt < num_rules && rt_rule->num_hdls < batch)
+		{
+			if (rt_rule_hdls[cnt] != 0)
+			{
+				rt_rule->hdl[rt_rule->num_hdls].status = -1;
+				rt_rule->hdl[rt_rule->num_hdls].hdl = rt_rule_hdls[cnt];
+				rt_rule->num_hdls++;
+			}
+			cnt++;
+		}
+
+		if (rt_rule->num_hdls == 0)
+		{
+			continue;
+		}
+
+		IPACMDBG_H("Deleting %d route hdls with ip type: %d\n", rt_rule->num_hdls, ip);
+		if (false == DeleteRoutingRule(rt_rule))
+		{
+			PERROR("Routing rule deletion failed!\n");
+			res = false;
+			continue;
+		}
+
+		for (i = 0; i < rt_rule->num_hdls; i++)
+		{
+			if (rt_rule->hdl[i].status)
+			{
+				IPACMERR("Route hdl:(0x%x) deletion failed! status: %d\n",
+								 rt_rule->hdl[i].hdl, rt_rule->hdl[i].status);
+				res = false;
+			}
+		}
+	}
+
+	free(rt_rule);
+
+	return res;
+}
+
 bool IPACM_Routing::ModifyRoutingRule(struct ipa_ioc_mdfy_rt_rule *mdfyRules)
 {
 	int retval = 0, cnt;
@@ -0,0 +1,186 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_Startup.cpp
+
+	@brief
+	This file implements the IPACM startup profiler and readiness gate.
+
+	main() runs the configuration parse, the firewall parse, the device
+	opens and the thread spawns concurrently. Threads which need the
+	configuration park in WaitReady(); netlink and driver events raised
+	meanwhile stay in the kernel or in the MessageQueue until Ready().
+
+	@Author
+
+*/
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include "IPACM_Startup.h"
+#include "IPACM_EvtStats.h"
+#include "IPACM_Log.h"
+
+static const char *ipacm_startup_milestone_name[IPACM_STARTUP_MILESTONE_MAX] =
+{
+	"first wan up",
+	"first nat rule"
+};
+
+uint64_t IPACM_Startup::begin_usec = 0;
+uint64_t IPACM_Startup::boot_usec = 0;
+int IPACM_Startup::num_stages = 0;
+ipacm_startup_stage IPACM_Startup::stages[IPACM_STARTUP_MAX_STAGES];
+uint64_t IPACM_Startup::milestones[IPACM_STARTUP_MILESTONE_MAX];
+volatile bool IPACM_Startup::ready = false;
+uint64_t IPACM_Startup::ready_usec = 0;
+pthread_mutex_t IPACM_Startup::lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t IPACM_Startup::cond = PTHREAD_COND_INITIALIZER;
+
+void IPACM_Startup::Begin(void)
+{
+	struct timespec ts;
+
+	begin_usec = IPACM_EvtStats::now_usec();
+	if(clock_gettime(CLOCK_BOOTTIME, &ts) == 0)
+	{
+		boot_usec = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+	}
+	IPACMDBG_H("ipacm started %llu ms after boot\n", (unsigned long long)(boot_usec / 1000));
+	return;
+}
+
+void IPACM_Startup::Stage(const char *name, uint64_t start_usec)
+{
+	uint64_t now = IPACM_EvtStats::now_usec();
+	ipacm_startup_stage *stage;
+
+	if(begin_usec == 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&lock);
+	if(num_stages < IPACM_STARTUP_MAX_STAGES)
+	{
+		stage = &stages[num_stages++];
+		strlcpy(stage->name, name, sizeof(stage->name));
+		if(pthread_getname_np(pthread_self(), stage->thread, sizeof(stage->thread)) != 0)
+		{
+			strlcpy(stage->thread, "?", sizeof(stage->thread));
+		}
+		stage->start_usec = start_usec - begin_usec;
+		stage->end_usec = now - begin_usec;
+	}
+	pthread_mutex_unlock(&lock);
+
+	IPACMDBG_H("startup stage %s took %llu us\n", name, (unsigned long long)(now - start_usec));
+	return;
+}
+
+void IPACM_Startup::Ready(void)
+{
+	int i;
+
+	pthread_mutex_lock(&lock);
+	ready_usec = IPACM_EvtStats::now_usec() - begin_usec;
+	ready = true;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+
+	IPACMDBG_H("ipacm ready %llu us after start\n", (unsigned long long)ready_usec);
+	for(i = 0; i < num_stages; i++)
+	{
+		IPACMDBG_H("  %-20s +%8llu us %8llu us (%s)\n", stages[i].name,
+			(unsigned long long)stages[i].start_usec,
+			(unsigned long long)(stages[i].end_usec - stages[i].start_usec), stages[i].thread);
+	}
+	return;
+}
+
+void IPACM_Startup::WaitReady(void)
+{
+	if(ready)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&lock);
+	while(!ready)
+	{
+		pthread_cond_wait(&cond, &lock);
+	}
+	pthread_mutex_unlock(&lock);
+	return;
+}
+
+void IPACM_Startup::Milestone(ipacm_startup_milestone id)
+{
+	uint64_t elapsed;
+
+	if(begin_usec == 0 || milestones[id] != 0)
+	{
+		return;
+	}
+
+	elapsed = IPACM_EvtStats::now_usec() - begin_usec;
+	if(!__sync_bool_compare_and_swap(&milestones[id], 0, elapsed))
+	{
+		return;
+	}
+	IPACMDBG_H("startup milestone %s: %llu ms after start, %llu ms after boot\n",
+		ipacm_startup_milestone_name[id], (unsigned long long)(elapsed / 1000),
+		(unsigned long long)((boot_usec + elapsed) / 1000));
+	return;
+}
+
+int IPACM_Startup::dump(char *buf, int len)
+{
+	int i, ret = 0;
+
+	ret += snprintf(buf + ret, len - ret, "startup boot_ms=%llu ready_us=%llu\n",
+		(unsigned long long)(boot_usec / 1000), (unsigned long long)ready_usec);
+	for(i = 0; i < num_stages && ret < len; i++)
+	{
+		ret += snprintf(buf + ret, len - ret, "startup stage %s start_us=%llu dur_us=%llu thread=%s\n",
+			stages[i].name, (unsigned long long)stages[i].start_usec,
+			(unsigned long long)(stages[i].end_usec - stages[i].start_usec), stages[i].thread);
+	}
+	for(i = 0; i < IPACM_STARTUP_MILESTONE_MAX && ret < len; i++)
+	{
+		ret += snprintf(buf + ret, len - ret, "startup milestone %s us=%llu\n",
+			ipacm_startup_milestone_name[i], (unsigned long long)milestones[i]);
+	}
+	if(ret >= len)
+	{
+		ret = len - 1;
+	}
+	return ret;
+}
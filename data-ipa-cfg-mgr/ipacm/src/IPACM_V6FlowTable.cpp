@@ -0,0 +1,695 @@
+/*
+Copyright (c) 2013-2016, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_V6FlowTable.cpp
+
+	@brief
+	This file implements the IPv6 flow table of the conntrack listener:
+	a bounded pool of flows indexed by 5-tuple which records, per flow,
+	whether its downlink hits an installed IPA client routing rule and
+	passes the wan firewall filter rules, and the resulting offload
+	hit ratios.
+
+	@Author
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include "IPACM_V6FlowTable.h"
+#include "IPACM_EvtStats.h"
+#include "IPACM_Log.h"
+
+#define V6FLOW_HASH_MULT 0x9E3779B1
+#define V6FLOW_INVALID (-1)
+
+pthread_mutex_t IPACM_V6FlowTable::table_lock = PTHREAD_MUTEX_INITIALIZER;
+ipacm_v6flow *IPACM_V6FlowTable::pool = NULL;
+int IPACM_V6FlowTable::max_flows = 0;
+int *IPACM_V6FlowTable::bucket = NULL;
+int IPACM_V6FlowTable::bucket_shift = 0;
+int IPACM_V6FlowTable::free_head = V6FLOW_INVALID;
+int IPACM_V6FlowTable::lru_head = V6FLOW_INVALID;
+int IPACM_V6FlowTable::lru_tail = V6FLOW_INVALID;
+ipacm_v6flow_stats IPACM_V6FlowTable::stats;
+uint32_t IPACM_V6FlowTable::rule_gen = 0;
+uint32_t IPACM_V6FlowTable::routed_addr[IPACM_V6FLOW_ROUTED_SLOTS][4];
+int IPACM_V6FlowTable::num_routed = 0;
+bool IPACM_V6FlowTable::fw_enable = false;
+bool IPACM_V6FlowTable::fw_accept = false;
+int IPACM_V6FlowTable::num_fw_rules = 0;
+struct ipa_rule_attrib IPACM_V6FlowTable::fw_rules[IPACM_MAX_FIREWALL_ENTRIES];
+
+static const char *v6flow_class_name[IPACM_V6FLOW_CLASS_MAX] =
+{
+	"slow",
+	"filtered",
+	"offloaded"
+};
+
+static inline uint32_t v6flow_mix(uint32_t hash, uint32_t word)
+{
+	hash = (hash ^ word) * V6FLOW_HASH_MULT;
+	return hash ^ (hash >> 16);
+}
+
+static inline bool v6flow_addr_equal(const uint32_t *a, const uint32_t *b)
+{
+	return (a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3]);
+}
+
+static inline bool v6flow_key_equal(const ipacm_v6flow_key *a, const ipacm_v6flow_key *b)
+{
+	return (a->sport == b->sport && a->dport == b->dport && a->proto == b->proto &&
+		v6flow_addr_equal(a->src, b->src) && v6flow_addr_equal(a->dst, b->dst));
+}
+
+static inline int v6flow_routed_home(const uint32_t *addr)
+{
+	uint32_t hash = 0;
+	int cnt;
+
+	for(cnt = 0; cnt < 4; cnt++)
+	{
+		hash = v6flow_mix(hash, addr[cnt]);
+	}
+	return hash >> (32 - IPACM_V6FLOW_ROUTED_SHIFT);
+}
+
+static void v6flow_ntop(const uint32_t *addr, char *buf, int len)
+{
+	uint32_t net[4];
+	int cnt;
+
+	for(cnt = 0; cnt < 4; cnt++)
+	{
+		net[cnt] = htonl(addr[cnt]);
+	}
+	if(inet_ntop(AF_INET6, net, buf, len) == NULL)
+	{
+		strlcpy(buf, "?", len);
+	}
+}
+
+int IPACM_V6FlowTable::Init(int cfg_max)
+{
+	int cnt;
+
+	if(cfg_max <= 0)
+	{
+		IPACMDBG_H("IPv6 flow tracking disabled\n");
+		return IPACM_SUCCESS;
+	}
+
+	pthread_mutex_lock(&table_lock);
+	if(pool != NULL)
+	{
+		pthread_mutex_unlock(&table_lock);
+		return IPACM_SUCCESS;
+	}
+
+	/* at most one flow per bucket on average */
+	bucket_shift = 1;
+	while((1 << bucket_shift) < cfg_max && bucket_shift < 24)
+	{
+		bucket_shift++;
+	}
+
+	bucket = (int *)malloc(sizeof(int) << bucket_shift);
+	ipacm_v6flow *flows = (ipacm_v6flow *)calloc(cfg_max, sizeof(ipacm_v6flow));
+	if(bucket == NULL || flows == NULL)
+	{
+		IPACMERR("unable to allocate %d IPv6 flows\n", cfg_max);
+		free(bucket);
+		free(flows);
+		bucket = NULL;
+		pthread_mutex_unlock(&table_lock);
+		return IPACM_FAILURE;
+	}
+
+	for(cnt = 0; cnt < (1 << bucket_shift); cnt++)
+	{
+		bucket[cnt] = V6FLOW_INVALID;
+	}
+	for(cnt = 0; cnt < cfg_max; cnt++)
+	{
+		flows[cnt].hash_next = (cnt + 1 < cfg_max) ? cnt + 1 : V6FLOW_INVALID;
+	}
+	free_head = 0;
+	lru_head = V6FLOW_INVALID;
+	lru_tail = V6FLOW_INVALID;
+	memset(&stats, 0, sizeof(stats));
+	max_flows = cfg_max;
+	pool = flows;
+	pthread_mutex_unlock(&table_lock);
+
+	IPACMDBG_H("tracking up to %d IPv6 flows in %d buckets\n", cfg_max, 1 << bucket_shift);
+	return IPACM_SUCCESS;
+}
+
+uint32_t IPACM_V6FlowTable::HashKey(const ipacm_v6flow_key *key)
+{
+	uint32_t hash = key->proto;
+	int cnt;
+
+	for(cnt = 0; cnt < 4; cnt++)
+	{
+		hash = v6flow_mix(hash, key->src[cnt]);
+		hash = v6flow_mix(hash, key->dst[cnt]);
+	}
+	hash = v6flow_mix(hash, ((uint32_t)key->sport << 16) | key->dport);
+	return hash >> (32 - bucket_shift);
+}
+
+int IPACM_V6FlowTable::Find(const ipacm_v6flow_key *key, uint32_t hash)
+{
+	int idx;
+
+	for(idx = bucket[hash]; idx != V6FLOW_INVALID; idx = pool[idx].hash_next)
+	{
+		if(v6flow_key_equal(&pool[idx].key, key))
+		{
+			return idx;
+		}
+	}
+	return V6FLOW_INVALID;
+}
+
+void IPACM_V6FlowTable::LruUnlink(int idx)
+{
+	ipacm_v6flow *flow = &pool[idx];
+
+	if(flow->lru_prev != V6FLOW_INVALID)
+	{
+		pool[flow->lru_prev].lru_next = flow->lru_next;
+	}
+	else
+	{
+		lru_head = flow->lru_next;
+	}
+	if(flow->lru_next != V6FLOW_INVALID)
+	{
+		pool[flow->lru_next].lru_prev = flow->lru_prev;
+	}
+	else
+	{
+		lru_tail = flow->lru_prev;
+	}
+	return;
+}
+
+void IPACM_V6FlowTable::LruPushHead(int idx)
+{
+	pool[idx].lru_prev = V6FLOW_INVALID;
+	pool[idx].lru_next = lru_head;
+	if(lru_head != V6FLOW_INVALID)
+	{
+		pool[lru_head].lru_prev = idx;
+	}
+	else
+	{
+		lru_tail = idx;
+	}
+	lru_head = idx;
+	return;
+}
+
+/* unlink the flow from its bucket and the lru and free its slot */
+void IPACM_V6FlowTable::Remove(int idx)
+{
+	ipacm_v6flow *flow = &pool[idx];
+	int *link = &bucket[HashKey(&flow->key)];
+
+	while(*link != V6FLOW_INVALID && *link != idx)
+	{
+		link = &pool[*link].hash_next;
+	}
+	if(*link == idx)
+	{
+		*link = flow->hash_next;
+	}
+	LruUnlink(idx);
+
+	stats.active--;
+	stats.active_cls[flow->cls]--;
+
+	flow->hash_next = free_head;
+	free_head = idx;
+	return;
+}
+
+/* free slot, the least recently seen flow is evicted when full */
+int IPACM_V6FlowTable::Alloc(void)
+{
+	int idx;
+
+	if(free_head == V6FLOW_INVALID)
+	{
+		IPACMDBG("IPv6 flow table full, evicting least recent flow\n");
+		Remove(lru_tail);
+		stats.evicted++;
+	}
+
+	idx = free_head;
+	free_head = pool[idx].hash_next;
+	return idx;
+}
+
+int IPACM_V6FlowTable::FindRouted(const uint32_t *addr)
+{
+	int slot = v6flow_routed_home(addr);
+	int cnt;
+
+	for(cnt = 0; cnt < IPACM_V6FLOW_ROUTED_SLOTS; cnt++)
+	{
+		if(v6flow_addr_equal(routed_addr[slot], addr))
+		{
+			return slot;
+		}
+		if((routed_addr[slot][0] | routed_addr[slot][1] |
+			routed_addr[slot][2] | routed_addr[slot][3]) == 0)
+		{
+			break;
+		}
+		slot = (slot + 1) & (IPACM_V6FLOW_ROUTED_SLOTS - 1);
+	}
+	return V6FLOW_INVALID;
+}
+
+bool IPACM_V6FlowTable::IsRouted(const uint32_t *addr)
+{
+	if((addr[0] | addr[1] | addr[2] | addr[3]) == 0)
+	{
+		return false;
+	}
+	return (FindRouted(addr) != V6FLOW_INVALID);
+}
+
+void IPACM_V6FlowTable::AddRoutedAddr(const uint32_t *addr)
+{
+	int slot;
+
+	if((addr[0] | addr[1] | addr[2] | addr[3]) == 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&table_lock);
+	if(FindRouted(addr) != V6FLOW_INVALID)
+	{
+		pthread_mutex_unlock(&table_lock);
+		return;
+	}
+	if(num_routed >= IPACM_V6FLOW_ROUTED_MAX)
+	{
+		IPACMERR("routed address set full, flows of 0x%x:%x:%x:%x count as slow path\n",
+			addr[0], addr[1], addr[2], addr[3]);
+		pthread_mutex_unlock(&table_lock);
+		return;
+	}
+
+	slot = v6flow_routed_home(addr);
+	while((routed_addr[slot][0] | routed_addr[slot][1] |
+		routed_addr[slot][2] | routed_addr[slot][3]) != 0)
+	{
+		slot = (slot + 1) & (IPACM_V6FLOW_ROUTED_SLOTS - 1);
+	}
+	memcpy(routed_addr[slot], addr, sizeof(routed_addr[slot]));
+	num_routed++;
+	rule_gen++;
+	pthread_mutex_unlock(&table_lock);
+
+	IPACMDBG("routed v6 addr 0x%x:%x:%x:%x added, %d in total\n",
+		addr[0], addr[1], addr[2], addr[3], num_routed);
+	return;
+}
+
+void IPACM_V6FlowTable::DelRoutedAddr(const uint32_t *addr)
+{
+	const int mask = IPACM_V6FLOW_ROUTED_SLOTS - 1;
+	int slot, next, home;
+
+	pthread_mutex_lock(&table_lock);
+	slot = FindRouted(addr);
+	if(slot == V6FLOW_INVALID)
+	{
+		pthread_mutex_unlock(&table_lock);
+		return;
+	}
+
+	/* shift back the entries of the probe sequence so lookups never
+	   stop at the hole */
+	next = (slot + 1) & mask;
+	while((routed_addr[next][0] | routed_addr[next][1] |
+		routed_addr[next][2] | routed_addr[next][3]) != 0)
+	{
+		home = v6flow_routed_home(routed_addr[next]);
+		if(((next - home) & mask) >= ((next - slot) & mask))
+		{
+			memcpy(routed_addr[slot], routed_addr[next], sizeof(routed_addr[slot]));
+			slot = next;
+		}
+		next = (next + 1) & mask;
+	}
+	memset(routed_addr[slot], 0, sizeof(routed_addr[slot]));
+	num_routed--;
+	rule_gen++;
+	pthread_mutex_unlock(&table_lock);
+
+	IPACMDBG("routed v6 addr 0x%x:%x:%x:%x deleted, %d in total\n",
+		addr[0], addr[1], addr[2], addr[3], num_routed);
+	return;
+}
+
+void IPACM_V6FlowTable::SetFirewall(const IPACM_firewall_conf_t *fw)
+{
+	int cnt;
+
+	pthread_mutex_lock(&table_lock);
+	fw_enable = fw->firewall_enable;
+	fw_accept = fw->rule_action_accept;
+	num_fw_rules = 0;
+	for(cnt = 0; cnt < fw->num_extd_firewall_entries && cnt < IPACM_MAX_FIREWALL_ENTRIES; cnt++)
+	{
+		if(fw->extd_firewall_entries[cnt].ip_vsn == 6)
+		{
+			memcpy(&fw_rules[num_fw_rules++], &fw->extd_firewall_entries[cnt].attrib,
+				sizeof(fw_rules[0]));
+		}
+	}
+	rule_gen++;
+	pthread_mutex_unlock(&table_lock);
+
+	IPACMDBG_H("v6 firewall enable=%d accept=%d with %d rules\n", fw_enable, fw_accept, num_fw_rules);
+	return;
+}
+
+/* dl is the flow as the wan filter rules see it, towards the client */
+bool IPACM_V6FlowTable::MatchFirewall(const struct ipa_rule_attrib *attrib, const ipacm_v6flow_key *dl)
+{
+	uint32_t mask = attrib->attrib_mask;
+	int cnt;
+
+	if(mask & IPA_FLT_NEXT_HDR)
+	{
+		if(attrib->u.v6.next_hdr == IPACM_FIREWALL_IPPROTO_TCP_UDP)
+		{
+			if(dl->proto != IPPROTO_TCP && dl->proto != IPPROTO_UDP)
+			{
+				return false;
+			}
+		}
+		else if(attrib->u.v6.next_hdr != dl->proto)
+		{
+			return false;
+		}
+	}
+
+	for(cnt = 0; cnt < 4; cnt++)
+	{
+		if((mask & IPA_FLT_SRC_ADDR) &&
+			 (dl->src[cnt] & attrib->u.v6.src_addr_mask[cnt]) !=
+			 (attrib->u.v6.src_addr[cnt] & attrib->u.v6.src_addr_mask[cnt]))
+		{
+			return false;
+		}
+		if((mask & IPA_FLT_DST_ADDR) &&
+			 (dl->dst[cnt] & attrib->u.v6.dst_addr_mask[cnt]) !=
+			 (attrib->u.v6.dst_addr[cnt] & attrib->u.v6.dst_addr_mask[cnt]))
+		{
+			return false;
+		}
+	}
+
+	if((mask & IPA_FLT_SRC_PORT) && dl->sport != attrib->src_port)
+	{
+		return false;
+	}
+	if((mask & IPA_FLT_SRC_PORT_RANGE) &&
+		 (dl->sport < attrib->src_port_lo || dl->sport > attrib->src_port_hi))
+	{
+		return false;
+	}
+	if((mask & IPA_FLT_DST_PORT) && dl->dport != attrib->dst_port)
+	{
+		return false;
+	}
+	if((mask & IPA_FLT_DST_PORT_RANGE) &&
+		 (dl->dport < attrib->dst_port_lo || dl->dport > attrib->dst_port_hi))
+	{
+		return false;
+	}
+
+	/* icmp and esp fields never match a tcp or udp flow, traffic class
+	   and flow label are per packet and taken as matching */
+	if(mask & (IPA_FLT_TYPE | IPA_FLT_CODE | IPA_FLT_SPI))
+	{
+		return false;
+	}
+	return true;
+}
+
+/* Client downlink goes through the wan filter rules to the client
+   routing rule in rt_tbl_wan_v6. Flows between two clients use
+   rt_tbl_v6, whose client rules point to the apps processor. */
+ipacm_v6flow_class IPACM_V6FlowTable::Classify(const ipacm_v6flow_key *key)
+{
+	bool src_routed = IsRouted(key->src);
+	bool dst_routed = IsRouted(key->dst);
+	bool matched = false;
+	ipacm_v6flow_key dl;
+	int cnt;
+
+	if(src_routed == dst_routed)
+	{
+		return IPACM_V6FLOW_SLOW;
+	}
+
+	if(src_routed)
+	{
+		/* client opened the flow, downlink is the reply direction */
+		memcpy(dl.src, key->dst, sizeof(dl.src));
+		memcpy(dl.dst, key->src, sizeof(dl.dst));
+		dl.sport = key->dport;
+		dl.dport = key->sport;
+		dl.proto = key->proto;
+	}
+	else
+	{
+		memcpy(&dl, key, sizeof(dl));
+	}
+
+	if(!fw_enable)
+	{
+		return IPACM_V6FLOW_OFFLOADED;
+	}
+
+	for(cnt = 0; cnt < num_fw_rules; cnt++)
+	{
+		if(MatchFirewall(&fw_rules[cnt], &dl))
+		{
+			matched = true;
+			break;
+		}
+	}
+
+	/* accept mode routes matched flows, drop mode routes the others */
+	return (matched == fw_accept) ? IPACM_V6FLOW_OFFLOADED : IPACM_V6FLOW_FILTERED;
+}
+
+void IPACM_V6FlowTable::Refresh(ipacm_v6flow *flow)
+{
+	ipacm_v6flow_class cls;
+
+	if(flow->rule_gen == rule_gen)
+	{
+		return;
+	}
+
+	cls = Classify(&flow->key);
+	if(cls != flow->cls)
+	{
+		stats.active_cls[flow->cls]--;
+		stats.active_cls[cls]++;
+		stats.reclassified++;
+		flow->cls = cls;
+	}
+	flow->rule_gen = rule_gen;
+	return;
+}
+
+ipacm_v6flow_class IPACM_V6FlowTable::Track(const ipacm_v6flow_key *key, ipacm_v6flow_evt evt)
+{
+	ipacm_v6flow *flow;
+	ipacm_v6flow_class cls;
+	uint64_t now;
+	uint32_t hash;
+	int idx;
+
+	if(pool == NULL)
+	{
+		return IPACM_V6FLOW_SLOW;
+	}
+
+	now = IPACM_EvtStats::now_usec();
+	pthread_mutex_lock(&table_lock);
+	stats.events++;
+
+	hash = HashKey(key);
+	idx = Find(key, hash);
+	if(idx == V6FLOW_INVALID)
+	{
+		if(evt == IPACM_V6FLOW_EVT_DESTROY)
+		{
+			stats.untracked++;
+			pthread_mutex_unlock(&table_lock);
+			return IPACM_V6FLOW_SLOW;
+		}
+
+		/* updates of unknown flows start tracking too, the kernel
+		   filter drops tcp events before the connection is established */
+		idx = Alloc();
+		flow = &pool[idx];
+		memcpy(&flow->key, key, sizeof(flow->key));
+		flow->hash_next = bucket[hash];
+		bucket[hash] = idx;
+		LruPushHead(idx);
+		flow->cls = Classify(key);
+		flow->rule_gen = rule_gen;
+		flow->events = 0;
+		flow->hit_events = 0;
+		flow->first_usec = now;
+
+		stats.created++;
+		stats.active++;
+		stats.active_cls[flow->cls]++;
+		if(stats.active > stats.peak)
+		{
+			stats.peak = stats.active;
+		}
+		IPACMDBG("new v6 flow proto %d port %d->%d is %s, %u active\n", key->proto,
+			key->sport, key->dport, v6flow_class_name[flow->cls], stats.active);
+	}
+	else
+	{
+		flow = &pool[idx];
+		Refresh(flow);
+		if(lru_head != idx)
+		{
+			LruUnlink(idx);
+			LruPushHead(idx);
+		}
+	}
+
+	cls = (ipacm_v6flow_class)flow->cls;
+	flow->events++;
+	flow->last_usec = now;
+	if(cls == IPACM_V6FLOW_OFFLOADED)
+	{
+		flow->hit_events++;
+		stats.hit_events++;
+	}
+
+	if(evt == IPACM_V6FLOW_EVT_DESTROY)
+	{
+		Remove(idx);
+		stats.destroyed++;
+	}
+	pthread_mutex_unlock(&table_lock);
+
+	return cls;
+}
+
+int IPACM_V6FlowTable::dump(char *buf, int len)
+{
+	char src[INET6_ADDRSTRLEN], dst[INET6_ADDRSTRLEN], line[256];
+	ipacm_v6flow *flow;
+	uint64_t now;
+	int n, idx, cnt, line_len;
+
+	if(len <= 0)
+	{
+		return 0;
+	}
+
+	pthread_mutex_lock(&table_lock);
+	if(pool == NULL)
+	{
+		pthread_mutex_unlock(&table_lock);
+		n = snprintf(buf, len, "v6flow disabled\n");
+		return (n < len) ? n : len - 1;
+	}
+
+	/* flows are classified lazily, bring them all up to date */
+	for(idx = lru_head; idx != V6FLOW_INVALID; idx = pool[idx].lru_next)
+	{
+		Refresh(&pool[idx]);
+	}
+
+	n = snprintf(buf, len,
+		"v6flow active=%u peak=%u max=%d created=%u destroyed=%u evicted=%u untracked=%u\n"
+		"v6flow offloaded=%u filtered=%u slow=%u reclassified=%u hit_ratio=%.1f%%\n"
+		"v6flow events=%llu hit=%llu event_hit_ratio=%.1f%% routed_addrs=%d fw_rules=%d\n",
+		stats.active, stats.peak, max_flows, stats.created, stats.destroyed,
+		stats.evicted, stats.untracked,
+		stats.active_cls[IPACM_V6FLOW_OFFLOADED], stats.active_cls[IPACM_V6FLOW_FILTERED],
+		stats.active_cls[IPACM_V6FLOW_SLOW], stats.reclassified,
+		stats.active ? (double)stats.active_cls[IPACM_V6FLOW_OFFLOADED] * 100 / stats.active : 0.0,
+		(unsigned long long)stats.events, (unsigned long long)stats.hit_events,
+		stats.events ? (double)stats.hit_events * 100 / stats.events : 0.0,
+		num_routed, fw_enable ? num_fw_rules : 0);
+
+	/* whole lines only, the listing stops when buf is full */
+	now = IPACM_EvtStats::now_usec();
+	for(idx = lru_head, cnt = 0; idx != V6FLOW_INVALID && cnt < IPACM_V6FLOW_DUMP_FLOWS && n < len;
+		idx = pool[idx].lru_next, cnt++)
+	{
+		flow = &pool[idx];
+		v6flow_ntop(flow->key.src, src, sizeof(src));
+		v6flow_ntop(flow->key.dst, dst, sizeof(dst));
+		line_len = snprintf(line, sizeof(line),
+			"  flow proto=%u [%s]:%u -> [%s]:%u %s events=%u hit=%u age=%llus idle=%llus\n",
+			flow->key.proto, src, flow->key.sport, dst, flow->key.dport,
+			v6flow_class_name[flow->cls], flow->events, flow->hit_events,
+			(unsigned long long)(now - flow->first_usec) / 1000000,
+			(unsigned long long)(now - flow->last_usec) / 1000000);
+		if(line_len >= (int)sizeof(line) || n + line_len >= len)
+		{
+			break;
+		}
+		memcpy(buf + n, line, line_len + 1);
+		n += line_len;
+	}
+	pthread_mutex_unlock(&table_lock);
+
+	return (n < len) ? n : len - 1;
+}
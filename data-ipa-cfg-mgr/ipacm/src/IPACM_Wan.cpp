@@ -49,7 +49,9 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Config.h"
 #include "IPACM_Defs.h"
 #include <IPACM_ConntrackListener.h>
+#include "IPACM_V6FlowTable.h"
 #include "linux/ipa_qmi_service_v01.h"
+#include "IPACM_Startup.h"
 
 bool IPACM_Wan::wan_up = false;
 bool IPACM_Wan::wan_up_v6 = false;
@@ -1236,6 +1238,7 @@ int IPACM_Wan::handle_route_add_evt(ipa_ip_type iptype)
 
 	is_default_gateway = true;
 	IPACMDBG_H("Default route is added to iface %s.\n", dev_name);
+	IPACM_Startup::Milestone(IPACM_STARTUP_FIRST_WAN_UP);
 
 	if(IPACM_Iface::ipacmcfg->iface_table[ipa_if_num].if_mode == BRIDGE)
 	{
@@ -1922,10 +1925,10 @@ int IPACM_Wan::config_dft_firewall_rules(ipa_ip_type iptype)
 
 	/* default firewall is disable and the rule action is drop */
 	memset(&firewall_config, 0, sizeof(firewall_config));
-	strlcpy(firewall_config.firewall_config_file, "/etc/mobileap_firewall.xml", sizeof(firewall_config.firewall_config_file));
+	strlcpy(firewall_config.firewall_config_file, IPACM_FIREWALL_XML_FILE, sizeof(firewall_config.firewall_config_file));
 
 	IPACMDBG_H("Firewall XML file is %s \n", firewall_config.firewall_config_file);
-	if (IPACM_SUCCESS == IPACM_read_firewall_xml(firewall_config.firewall_config_file, &firewall_config))
+	if (IPACM_SUCCESS == IPACM_read_firewall_xml_cached(firewall_config.firewall_config_file, &firewall_config))
 	{
 		IPACMDBG_H("QCMAP Firewall XML read OK \n");
 		/* find the number of v4/v6 firewall rules */
@@ -1947,6 +1950,11 @@ int IPACM_Wan::config_dft_firewall_rules(ipa_ip_type iptype)
 		IPACMERR("QCMAP Firewall XML read failed, no that file, use default configuration \n");
 	}
 
+	if(iptype == IPA_IP_v6)
+	{
+		IPACM_V6FlowTable::SetFirewall(&firewall_config);
+	}
+
 	/* construct ipa_ioc_add_flt_rule with N firewall rules */
 	ipa_ioc_add_flt_rule *m_pFilteringTable = NULL;
 	len = sizeof(struct ipa_ioc_add_flt_rule) + 1 * sizeof(struct ipa_flt_rule_add);
@@ -2647,10 +2655,10 @@ int IPACM_Wan::config_dft_firewall_rules_ex(struct ipa_flt_rule_add *rules, int
 
 	/* default firewall is disable and the rule action is drop */
 	memset(&firewall_config, 0, sizeof(firewall_config));
-	strlcpy(firewall_config.firewall_config_file, "/etc/mobileap_firewall.xml", sizeof(firewall_config.firewall_config_file));
+	strlcpy(firewall_config.firewall_config_file, IPACM_FIREWALL_XML_FILE, sizeof(firewall_config.firewall_config_file));
 
 	IPACMDBG_H("Firewall XML file is %s \n", firewall_config.firewall_config_file);
-	if (IPACM_SUCCESS == IPACM_read_firewall_xml(firewall_config.firewall_config_file, &firewall_config))
+	if (IPACM_SUCCESS == IPACM_read_firewall_xml_cached(firewall_config.firewall_config_file, &firewall_config))
 	{
 		IPACMDBG_H("QCMAP Firewall XML read OK \n");
 	}
@@ -2659,6 +2667,11 @@ int IPACM_Wan::config_dft_firewall_rules_ex(struct ipa_flt_rule_add *rules, int
 		IPACMERR("QCMAP Firewall XML read failed, no that file, use default configuration \n");
 	}
 
+	if(iptype == IPA_IP_v6)
+	{
+		IPACM_V6FlowTable::SetFirewall(&firewall_config);
+	}
+
 	/* add IPv6 frag rule when firewall is enabled*/
 	if(iptype == IPA_IP_v6 &&
 			firewall_config.firewall_enable == true &&
@@ -4317,12 +4330,7 @@ int IPACM_Wan::handle_down_evt()
 	if (ip_type != IPA_IP_v6)
 	{
 		IPACMDBG_H("Delete default v4 routing rules\n");
-		if (m_routing.DeleteRoutingHdl(dft_rt_rule_hdl[0], IPA_IP_v4) == false)
-		{
-		   IPACMERR("Routing rule deletion failed!\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_RT, IPA_IP_v4, dft_rt_rule_hdl[0]);
 	}
 
 	/* delete default v6 RT rule */
@@ -4330,17 +4338,8 @@ int IPACM_Wan::handle_down_evt()
 	{
 		IPACMDBG_H("Delete default v6 routing rules\n");
 		/* May have multiple ipv6 iface-routing rules*/
-		for (i = 0; i < 2*num_dft_rt_v6; i++)
-		{
-			if (m_routing.DeleteRoutingHdl(dft_rt_rule_hdl[MAX_DEFAULT_v4_ROUTE_RULES+i], IPA_IP_v6) == false)
-			{
-				IPACMERR("Routing rule deletion failed!\n");
-				res = IPACM_FAILURE;
-				goto fail;
-			}
-		}
-
-		IPACMDBG_H("finished delete default v6 RT rules\n ");
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_RT, IPA_IP_v6,
+			&dft_rt_rule_hdl[MAX_DEFAULT_v4_ROUTE_RULES], 2*num_dft_rt_v6);
 	}
 
 
@@ -4355,41 +4354,22 @@ int IPACM_Wan::handle_down_evt()
 				CtList->HandleSTAClientDelEvt(get_client_memptr(wan_client, i)->v4_addr);
 			}
 
-			if (delete_wan_rtrules(i, IPA_IP_v4))
-			{
-				IPACMERR("unbale to delete wan-client v4 route rules for index %d\n", i);
-				res = IPACM_FAILURE;
-				goto fail;
-			}
-
-			if (delete_wan_rtrules(i, IPA_IP_v6))
-			{
-				IPACMERR("unbale to delete ecm-client v6 route rules for index %d\n", i);
-				res = IPACM_FAILURE;
-				goto fail;
-			}
+			delete_wan_rtrules(i, IPA_IP_v4, true);
+			delete_wan_rtrules(i, IPA_IP_v6, true);
 
 			IPACMDBG_H("Delete %d client header\n", num_wan_client);
 
 
 			if(get_client_memptr(wan_client, i)->ipv4_header_set == true)
 			{
-				if (m_header.DeleteHeaderHdl(get_client_memptr(wan_client, i)->hdr_hdl_v4)
-					== false)
-				{
-					res = IPACM_FAILURE;
-					goto fail;
-				}
+				hdl_batch.add(IPACM_HDL_OWNER_CLIENT(i), IPACM_HDL_HDR, IPA_IP_MAX,
+					get_client_memptr(wan_client, i)->hdr_hdl_v4);
 			}
 
 			if(get_client_memptr(wan_client, i)->ipv6_header_set == true)
 			{
-			if (m_header.DeleteHeaderHdl(get_client_memptr(wan_client, i)->hdr_hdl_v6)
-					== false)
-			{
-				res = IPACM_FAILURE;
-				goto fail;
-			}
+				hdl_batch.add(IPACM_HDL_OWNER_CLIENT(i), IPACM_HDL_HDR, IPA_IP_MAX,
+					get_client_memptr(wan_client, i)->hdr_hdl_v6);
 			}
 	} /* end of for loop */
 
@@ -4405,60 +4385,42 @@ int IPACM_Wan::handle_down_evt()
 	/* free filter rule handlers */
 	if (ip_type != IPA_IP_v6 && rx_prop != NULL)
 	{
-		if (m_filtering.DeleteFilteringHdls(dft_v4fl_rule_hdl,
-																				IPA_IP_v4,
-																				IPV4_DEFAULT_FILTERTING_RULES) == false)
-		{
-			IPACMERR("Error Delete Filtering rules, aborting...\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v4,
+			dft_v4fl_rule_hdl, IPV4_DEFAULT_FILTERTING_RULES);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v4, IPV4_DEFAULT_FILTERTING_RULES);
-
-		IPACMDBG_H("finished delete default v4 filtering rules\n ");
 	}
 
 
 	if (ip_type != IPA_IP_v4 && rx_prop != NULL)
 	{
-		if (m_filtering.DeleteFilteringHdls(dft_v6fl_rule_hdl,
-																				IPA_IP_v6,
-																				IPV6_DEFAULT_FILTERTING_RULES) == false)
-		{
-			IPACMERR("ErrorDeleting Filtering rule, aborting...\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v6,
+			dft_v6fl_rule_hdl, IPV6_DEFAULT_FILTERTING_RULES);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v6, IPV6_DEFAULT_FILTERTING_RULES);
 
 		if(num_ipv6_dest_flt_rule > 0 && num_ipv6_dest_flt_rule <= MAX_DEFAULT_v6_ROUTE_RULES)
 		{
-			if(m_filtering.DeleteFilteringHdls(ipv6_dest_flt_rule_hdl,  IPA_IP_v6, num_ipv6_dest_flt_rule) == false)
-			{
-				IPACMERR("Failed to delete ipv6 dest flt rules.\n");
-				res = IPACM_FAILURE;
-				goto fail;
-			}
+			hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v6,
+				ipv6_dest_flt_rule_hdl, num_ipv6_dest_flt_rule);
 			IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v6, num_ipv6_dest_flt_rule);
 		}
-		IPACMDBG_H("finished delete default v6 filtering rules\n ");
 	}
-	if(hdr_proc_hdl_dummy_v6)
+	hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_PROC_CTX, IPA_IP_MAX, hdr_proc_hdl_dummy_v6);
+	hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_HDR, IPA_IP_MAX, hdr_hdl_dummy_v6);
+
+	/* default rules, wan-client rules and headers go in one delete per type */
+	if (hdl_batch.flush(IPACM_HDL_OWNER_ANY))
 	{
-		if(m_header.DeleteHeaderProcCtx(hdr_proc_hdl_dummy_v6) == false)
-		{
-			IPACMERR("Failed to delete hdr_proc_hdl_dummy_v6\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		IPACMERR("Failed to delete wan iface rules and headers\n");
+		res = IPACM_FAILURE;
 	}
-	if(hdr_hdl_dummy_v6)
+	else
 	{
-		if (m_header.DeleteHeaderHdl(hdr_hdl_dummy_v6) == false)
+		for (i = 0; i < num_wan_client; i++)
 		{
-			IPACMERR("Failed to delete hdr_hdl_dummy_v6\n");
-			res = IPACM_FAILURE;
-			goto fail;
+			clear_wan_rtrules(i, IPA_IP_v4);
+			clear_wan_rtrules(i, IPA_IP_v6);
+			get_client_memptr(wan_client, i)->ipv4_header_set = false;
+			get_client_memptr(wan_client, i)->ipv6_header_set = false;
 		}
 	}
 fail:
@@ -48,6 +48,7 @@ Skylar Chang
 #include <IPACM_Wan.h>
 #include <IPACM_Lan.h>
 #include <IPACM_IfaceManager.h>
+#include <IPACM_EvtExecutor.h>
 #include <IPACM_ConntrackListener.h>
 
 
@@ -537,7 +538,10 @@ void IPACM_Wlan::event_callback(ipa_cm_event_id event, void *param)
 					}
 				}
 				IPACMDBG_H("Received IPA_WLAN_CLIENT_ADD_EVENT\n");
+				/* total_num_wifi_clients budget is shared by all wlan ifaces */
+				IPACM_EvtExecutor::LockShared();
 				handle_wlan_client_init_ex(data);
+				IPACM_EvtExecutor::UnlockShared();
 			}
 		}
 		break;
@@ -593,7 +597,9 @@ void IPACM_Wlan::event_callback(ipa_cm_event_id event, void *param)
 						IPACMDBG_H("Adding Route Rules\n");
 						handle_wlan_client_route_rule(data->mac_addr, IPA_IP_v4);
 						IPACMDBG_H("Adding Nat Rules\n");
+						IPACM_EvtExecutor::LockShared();
 						Nat_App->ResetPwrSaveIf(get_client_memptr(wlan_client, wlan_index)->v4_addr);
+						IPACM_EvtExecutor::UnlockShared();
 					}
 
 					if(get_client_memptr(wlan_client, wlan_index)->ipv6_set != 0) /* for ipv6 */
@@ -1022,7 +1028,7 @@ int IPACM_Wlan::handle_wlan_client_init_ex(ipacm_event_data_wlan_ex *data)
 		get_client_memptr(wlan_client, num_wifi_client)->power_save_set=false;
 		num_wifi_client++;
 		header_name_count++; //keep increasing header_name_count
-		IPACM_Wlan::total_num_wifi_clients++;
+		__sync_fetch_and_add(&IPACM_Wlan::total_num_wifi_clients, 1);
 		res = IPACM_SUCCESS;
 		IPACMDBG_H("Wifi client number: %d\n", num_wifi_client);
 	}
@@ -1370,6 +1376,12 @@ int IPACM_Wlan::handle_wlan_client_route_rule(uint8_t *mac_addr, ipa_ip_type ipt
 		}
 		else
 		{
+			/* downlink of these addresses is now routed by IPA */
+			for(v6_num = get_client_memptr(wlan_client, wlan_index)->route_rule_set_v6;
+				v6_num < get_client_memptr(wlan_client, wlan_index)->ipv6_set; v6_num++)
+			{
+				IPACM_V6FlowTable::AddRoutedAddr(get_client_memptr(wlan_client, wlan_index)->v6_addr[v6_num]);
+			}
 			get_client_memptr(wlan_client, wlan_index)->route_rule_set_v6 = get_client_memptr(wlan_client, wlan_index)->ipv6_set;
 		}
 	}
@@ -1396,7 +1408,9 @@ int IPACM_Wlan::handle_wlan_client_pwrsave(uint8_t *mac_addr)
 	    if(get_client_memptr(wlan_client, clt_indx)->ipv4_set == true)
 	    {
 			IPACMDBG_H("Deleting Nat Rules\n");
+			IPACM_EvtExecutor::LockShared();
 			Nat_App->UpdatePwrSaveIf(get_client_memptr(wlan_client, clt_indx)->v4_addr);
+			IPACM_EvtExecutor::UnlockShared();
  	     }
 
 		IPACMDBG_H("Deleting default qos Route Rules\n");
@@ -1435,38 +1449,32 @@ int IPACM_Wlan::handle_wlan_client_down_evt(uint8_t *mac_addr)
 			CtList->HandleNeighIpAddrDelEvt(get_client_memptr(wlan_client, clt_indx)->v4_addr);
  	}
 
-	if (delete_default_qos_rtrules(clt_indx, IPA_IP_v4))
-	{
-		IPACMERR("unbale to delete v4 default qos route rules for index: %d\n", clt_indx);
-		return IPACM_FAILURE;
-	}
-
-	if (delete_default_qos_rtrules(clt_indx, IPA_IP_v6))
-	{
-		IPACMERR("unbale to delete v6 default qos route rules for indexn: %d\n", clt_indx);
-		return IPACM_FAILURE;
-	}
+	/* route rules and headers of the client go in one delete per type */
+	delete_default_qos_rtrules(clt_indx, IPA_IP_v4, true);
+	delete_default_qos_rtrules(clt_indx, IPA_IP_v6, true);
 
 	/* Delete wlan client header */
 	if(get_client_memptr(wlan_client, clt_indx)->ipv4_header_set == true)
 	{
-	if (m_header.DeleteHeaderHdl(get_client_memptr(wlan_client, clt_indx)->hdr_hdl_v4)
-			== false)
-	{
-		return IPACM_FAILURE;
-	}
-		get_client_memptr(wlan_client, clt_indx)->ipv4_header_set = false;
+		hdl_batch.add(IPACM_HDL_OWNER_CLIENT(clt_indx), IPACM_HDL_HDR, IPA_IP_MAX,
+			get_client_memptr(wlan_client, clt_indx)->hdr_hdl_v4);
 	}
 
 	if(get_client_memptr(wlan_client, clt_indx)->ipv6_header_set == true)
 	{
-	if (m_header.DeleteHeaderHdl(get_client_memptr(wlan_client, clt_indx)->hdr_hdl_v6)
-			== false)
+		hdl_batch.add(IPACM_HDL_OWNER_CLIENT(clt_indx), IPACM_HDL_HDR, IPA_IP_MAX,
+			get_client_memptr(wlan_client, clt_indx)->hdr_hdl_v6);
+	}
+
+	/* the client keeps its flags if this fails, so that the next down event
+	   deletes the same handles again */
+	if (hdl_batch.flush(IPACM_HDL_OWNER_CLIENT(clt_indx)))
 	{
+		IPACMERR("unable to delete route rules and headers for index: %d\n", clt_indx);
 		return IPACM_FAILURE;
 	}
-		get_client_memptr(wlan_client, clt_indx)->ipv6_header_set = false;
-	}
+	clear_default_qos_rtrules(clt_indx, IPA_IP_v4);
+	clear_default_qos_rtrules(clt_indx, IPA_IP_v6);
 
 	/* Reset ip_set to 0*/
 	get_client_memptr(wlan_client, clt_indx)->ipv4_set = false;
@@ -1522,7 +1530,7 @@ int IPACM_Wlan::handle_wlan_client_down_evt(uint8_t *mac_addr)
 
 	IPACMDBG_H(" %d wifi client deleted successfully \n", num_wifi_client);
 	num_wifi_client = num_wifi_client - 1;
-	IPACM_Wlan::total_num_wifi_clients = IPACM_Wlan::total_num_wifi_clients - 1;
+	__sync_fetch_and_sub(&IPACM_Wlan::total_num_wifi_clients, 1);
 	IPACMDBG_H(" Number of wifi client: %d\n", num_wifi_client);
 
 	return IPACM_SUCCESS;
@@ -1559,66 +1567,33 @@ int IPACM_Wlan::handle_down_evt()
 	if (ip_type != IPA_IP_v6 && rx_prop != NULL)
 	{
 		/* delete IPv4 icmp filter rules */
-		if(m_filtering.DeleteFilteringHdls(ipv4_icmp_flt_rule_hdl, IPA_IP_v4, NUM_IPV4_ICMP_FLT_RULE) == false)
-		{
-			IPACMERR("Error Deleting ICMPv4 Filtering Rule, aborting...\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v4, ipv4_icmp_flt_rule_hdl, NUM_IPV4_ICMP_FLT_RULE);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v4, NUM_IPV4_ICMP_FLT_RULE);
 
-		if (m_filtering.DeleteFilteringHdls(dft_v4fl_rule_hdl, IPA_IP_v4, IPV4_DEFAULT_FILTERTING_RULES) == false)
-		{
-			IPACMERR("Error Deleting Filtering Rule, aborting...\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v4, dft_v4fl_rule_hdl, IPV4_DEFAULT_FILTERTING_RULES);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v4, IPV4_DEFAULT_FILTERTING_RULES);
-		IPACMDBG_H("Deleted default v4 filter rules successfully.\n");
 
 		/* delete private-ipv4 filter rules */
 #ifdef FEATURE_IPA_ANDROID
-		if(m_filtering.DeleteFilteringHdls(private_fl_rule_hdl, IPA_IP_v4, IPA_MAX_PRIVATE_SUBNET_ENTRIES) == false)
-		{
-			IPACMERR("Error deleting private subnet IPv4 flt rules.\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v4, private_fl_rule_hdl, IPA_MAX_PRIVATE_SUBNET_ENTRIES);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v4, IPA_MAX_PRIVATE_SUBNET_ENTRIES);
 #else
 		num_private_subnet_fl_rule = IPACM_Iface::ipacmcfg->ipa_num_private_subnet > IPA_MAX_PRIVATE_SUBNET_ENTRIES?
 			IPA_MAX_PRIVATE_SUBNET_ENTRIES : IPACM_Iface::ipacmcfg->ipa_num_private_subnet;
-		if(m_filtering.DeleteFilteringHdls(private_fl_rule_hdl, IPA_IP_v4, num_private_subnet_fl_rule) == false)
-		{
-			IPACMERR("Error deleting private subnet flt rules, aborting...\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v4, private_fl_rule_hdl, num_private_subnet_fl_rule);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v4, num_private_subnet_fl_rule);
 #endif
-		IPACMDBG_H("Deleted private subnet v4 filter rules successfully.\n");
 	}
 
 	/* Delete v6 filtering rules */
 	if (ip_type != IPA_IP_v4 && rx_prop != NULL)
 	{
 		/* delete icmp filter rules */
-		if(m_filtering.DeleteFilteringHdls(ipv6_icmp_flt_rule_hdl, IPA_IP_v6, NUM_IPV6_ICMP_FLT_RULE) == false)
-		{
-			IPACMERR("Error Deleting ICMPv6 Filtering Rule, aborting...\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v6, ipv6_icmp_flt_rule_hdl, NUM_IPV6_ICMP_FLT_RULE);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v6, NUM_IPV6_ICMP_FLT_RULE);
 
-		if (m_filtering.DeleteFilteringHdls(dft_v6fl_rule_hdl, IPA_IP_v6, IPV6_DEFAULT_FILTERTING_RULES) == false)
-		{
-			IPACMERR("Error Adding RuleTable(1) to Filtering, aborting...\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_FLT, IPA_IP_v6, dft_v6fl_rule_hdl, IPV6_DEFAULT_FILTERTING_RULES);
 		IPACM_Iface::ipacmcfg->decreaseFltRuleCount(rx_prop->rx[0].src_pipe, IPA_IP_v6, IPV6_DEFAULT_FILTERTING_RULES);
-		IPACMDBG_H("Deleted default v6 filter rules successfully.\n");
 	}
 	IPACMDBG_H("finished delete filtering rules\n ");
 
@@ -1626,13 +1601,7 @@ int IPACM_Wlan::handle_down_evt()
 	if (ip_type != IPA_IP_v6)
 	{
 		IPACMDBG_H("Delete default v4 routing rules\n");
-		if (m_routing.DeleteRoutingHdl(dft_rt_rule_hdl[0], IPA_IP_v4)
-				== false)
-		{
-			IPACMERR("Routing rule deletion failed!\n");
-			res = IPACM_FAILURE;
-			goto fail;
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_RT, IPA_IP_v4, dft_rt_rule_hdl[0]);
 	}
 
 	/* Delete default v6 RT rule */
@@ -1640,16 +1609,15 @@ int IPACM_Wlan::handle_down_evt()
 	{
 		IPACMDBG_H("Delete default v6 routing rules\n");
 		/* May have multiple ipv6 iface-RT rules */
-		for (i = 0; i < 2*num_dft_rt_v6; i++)
-		{
-			if (m_routing.DeleteRoutingHdl(dft_rt_rule_hdl[MAX_DEFAULT_v4_ROUTE_RULES+i], IPA_IP_v6)
-					== false)
-			{
-				IPACMERR("Routing rule deletion failed!\n");
-				res = IPACM_FAILURE;
-				goto fail;
-			}
-		}
+		hdl_batch.add(IPACM_HDL_OWNER_IFACE, IPACM_HDL_RT, IPA_IP_v6,
+			&dft_rt_rule_hdl[MAX_DEFAULT_v4_ROUTE_RULES], 2*num_dft_rt_v6);
+	}
+
+	/* default filter and routing rules go in one delete per type */
+	if (hdl_batch.flush(IPACM_HDL_OWNER_IFACE))
+	{
+		IPACMERR("Failed to delete default iface rules\n");
+		res = IPACM_FAILURE;
 	}
 	IPACMDBG_H("finished deleting default RT rules\n ");
 
@@ -1686,39 +1654,41 @@ fail:
 			CtList->HandleNeighIpAddrDelEvt(get_client_memptr(wlan_client, i)->v4_addr);
 		}
 
-		if (delete_default_qos_rtrules(i, IPA_IP_v4))
-		{
-			IPACMERR("unbale to delete v4 default qos route rules for index: %d\n", i);
-			res = IPACM_FAILURE;
-		}
-
-		if (delete_default_qos_rtrules(i, IPA_IP_v6))
-		{
-			IPACMERR("unbale to delete v6 default qos route rules for index: %d\n", i);
-			res = IPACM_FAILURE;
-		}
+		delete_default_qos_rtrules(i, IPA_IP_v4, true);
+		delete_default_qos_rtrules(i, IPA_IP_v6, true);
 
 		IPACMDBG_H("Delete %d client header\n", num_wifi_client);
 
 		if(get_client_memptr(wlan_client, i)->ipv4_header_set == true)
 		{
-			if (m_header.DeleteHeaderHdl(get_client_memptr(wlan_client, i)->hdr_hdl_v4)
-				== false)
-			{
-				res = IPACM_FAILURE;
-			}
+			hdl_batch.add(IPACM_HDL_OWNER_CLIENT(i), IPACM_HDL_HDR, IPA_IP_MAX,
+				get_client_memptr(wlan_client, i)->hdr_hdl_v4);
 		}
 
 		if(get_client_memptr(wlan_client, i)->ipv6_header_set == true)
 		{
-			if (m_header.DeleteHeaderHdl(get_client_memptr(wlan_client, i)->hdr_hdl_v6)
-					== false)
-			{
-				res = IPACM_FAILURE;
-			}
+			hdl_batch.add(IPACM_HDL_OWNER_CLIENT(i), IPACM_HDL_HDR, IPA_IP_MAX,
+				get_client_memptr(wlan_client, i)->hdr_hdl_v6);
 		}
 	} /* end of for loop */
 
+	/* every client (and the iface itself after an early exit) at once */
+	if (hdl_batch.flush(IPACM_HDL_OWNER_ANY))
+	{
+		IPACMERR("unable to delete wifi-client route rules and headers\n");
+		res = IPACM_FAILURE;
+	}
+	else
+	{
+		for (i = 0; i < num_wifi_client; i++)
+		{
+			clear_default_qos_rtrules(i, IPA_IP_v4);
+			clear_default_qos_rtrules(i, IPA_IP_v6);
+			get_client_memptr(wlan_client, i)->ipv4_header_set = false;
+			get_client_memptr(wlan_client, i)->ipv6_header_set = false;
+		}
+	}
+
 	/* check software routing fl rule hdl */
 	if (softwarerouting_act == true && rx_prop != NULL )
 	{
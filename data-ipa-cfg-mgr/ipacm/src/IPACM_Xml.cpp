@@ -40,6 +40,8 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 #include "IPACM_Xml.h"
 #include "IPACM_Log.h"
@@ -175,7 +177,12 @@ static int ipacm_cfg_xml_parse_tree
 						IPACM_util_icmp_string((char*)xml_node->name, IPACMALG_TAG) == 0 ||
 						IPACM_util_icmp_string((char*)xml_node->name, ALG_TAG) == 0 ||
 						IPACM_util_icmp_string((char*)xml_node->name, IPACMNat_TAG) == 0 ||
-						IPACM_util_icmp_string((char*)xml_node->name, IP_PassthroughFlag_TAG) == 0)
+						IPACM_util_icmp_string((char*)xml_node->name, IP_PassthroughFlag_TAG) == 0 ||
+						IPACM_util_icmp_string((char*)xml_node->name, IPACMDebug_TAG) == 0 ||
+						IPACM_util_icmp_string((char*)xml_node->name, IPACMEvent_TAG) == 0 ||
+						IPACM_util_icmp_string((char*)xml_node->name, IPACMLanToLan_TAG) == 0 ||
+						IPACM_util_icmp_string((char*)xml_node->name, IPACMV6Flow_TAG) == 0 ||
+						IPACM_util_icmp_string((char*)xml_node->name, IPACMNeighbor_TAG) == 0)
 				{
 					if (0 == IPACM_util_icmp_string((char*)xml_node->name, IFACE_TAG))
 					{
@@ -218,6 +225,30 @@ static int ipacm_cfg_xml_parse_tree
 						}
 					}
 				}
+				else if (IPACM_util_icmp_string((char*)xml_node->name, RecordEvents_TAG) == 0)
+				{
+					content = IPACM_read_content_element(xml_node);
+					if (content)
+					{
+						str_size = strlen(content);
+						memset(content_buf, 0, sizeof(content_buf));
+						memcpy(content_buf, (void *)content, str_size);
+						config->record_events = (atoi(content_buf) != 0);
+						IPACMDBG_H("Record events %d\n", config->record_events);
+					}
+				}
+				else if (IPACM_util_icmp_string((char*)xml_node->name, WorkerThreads_TAG) == 0)
+				{
+					content = IPACM_read_content_element(xml_node);
+					if (content)
+					{
+						str_size = strlen(content);
+						memset(content_buf, 0, sizeof(content_buf));
+						memcpy(content_buf, (void *)content, str_size);
+						config->event_workers = atoi(content_buf);
+						IPACMDBG_H("Event worker threads %d\n", config->event_workers);
+					}
+				}
 				else if (IPACM_util_icmp_string((char*)xml_node->name, ODUMODE_TAG) == 0)
 				{
 					IPACMDBG_H("inside ODU-XML\n");
@@ -439,6 +470,66 @@ static int ipacm_cfg_xml_parse_tree
 						IPACMDBG_H("Nat Table Max Entries %d\n", config->nat_max_entries);
 					}
 				}
+				else if (IPACM_util_icmp_string((char*)xml_node->name, NAT_MaxPendingEntries_TAG) == 0)
+				{
+					content = IPACM_read_content_element(xml_node);
+					if (content)
+					{
+						str_size = strlen(content);
+						memset(content_buf, 0, sizeof(content_buf));
+						memcpy(content_buf, (void *)content, str_size);
+						config->nat_pending_max_entries = atoi(content_buf);
+						IPACMDBG_H("Nat Pending Max Entries %d\n", config->nat_pending_max_entries);
+					}
+				}
+				else if (IPACM_util_icmp_string((char*)xml_node->name, L2L_MaxClients_TAG) == 0)
+				{
+					content = IPACM_read_content_element(xml_node);
+					if (content)
+					{
+						str_size = strlen(content);
+						memset(content_buf, 0, sizeof(content_buf));
+						memcpy(content_buf, (void *)content, str_size);
+						config->lan2lan_max_client = atoi(content_buf);
+						IPACMDBG_H("LanToLan Max Clients %d\n", config->lan2lan_max_client);
+					}
+				}
+				else if (IPACM_util_icmp_string((char*)xml_node->name, L2L_MaxIfaces_TAG) == 0)
+				{
+					content = IPACM_read_content_element(xml_node);
+					if (content)
+					{
+						str_size = strlen(content);
+						memset(content_buf, 0, sizeof(content_buf));
+						memcpy(content_buf, (void *)content, str_size);
+						config->lan2lan_max_iface = atoi(content_buf);
+						IPACMDBG_H("LanToLan Max Ifaces %d\n", config->lan2lan_max_iface);
+					}
+				}
+				else if (IPACM_util_icmp_string((char*)xml_node->name, V6Flow_MaxFlows_TAG) == 0)
+				{
+					content = IPACM_read_content_element(xml_node);
+					if (content)
+					{
+						str_size = strlen(content);
+						memset(content_buf, 0, sizeof(content_buf));
+						memcpy(content_buf, (void *)content, str_size);
+						config->v6flow_max_flows = atoi(content_buf);
+						IPACMDBG_H("IPv6 Max Flows %d\n", config->v6flow_max_flows);
+					}
+				}
+				else if (IPACM_util_icmp_string((char*)xml_node->name, Neighbor_MaxNeighbors_TAG) == 0)
+				{
+					content = IPACM_read_content_element(xml_node);
+					if (content)
+					{
+						str_size = strlen(content);
+						memset(content_buf, 0, sizeof(content_buf));
+						memcpy(content_buf, (void *)content, str_size);
+						config->neighbor_max_client = atoi(content_buf);
+						IPACMDBG_H("Neighbor Max Clients %d\n", config->neighbor_max_client);
+					}
+				}
 			}
 			break;
 		default:
@@ -483,6 +574,61 @@ int IPACM_read_firewall_xml(char *xml_file, IPACM_firewall_conf_t *config)
 	return ret_val;
 }
 
+static pthread_mutex_t firewall_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static IPACM_firewall_conf_t *firewall_cache = NULL;
+static struct stat firewall_cache_st;
+
+int IPACM_read_firewall_xml_cached(char *xml_file, IPACM_firewall_conf_t *config)
+{
+	struct stat st;
+	int ret_val;
+
+	IPACM_ASSERT(xml_file != NULL);
+	IPACM_ASSERT(config != NULL);
+
+	if (stat(xml_file, &st) != 0)
+	{
+		return IPACM_read_firewall_xml(xml_file, config);
+	}
+
+	/* a parse already running on another thread is waited for */
+	pthread_mutex_lock(&firewall_cache_lock);
+	if (firewall_cache != NULL &&
+			!strncmp(firewall_cache->firewall_config_file, xml_file, sizeof(firewall_cache->firewall_config_file)) &&
+			st.st_ino == firewall_cache_st.st_ino &&
+			st.st_size == firewall_cache_st.st_size &&
+			st.st_mtime == firewall_cache_st.st_mtime &&
+			st.st_mtim.tv_nsec == firewall_cache_st.st_mtim.tv_nsec)
+	{
+		memcpy(config, firewall_cache, sizeof(IPACM_firewall_conf_t));
+		pthread_mutex_unlock(&firewall_cache_lock);
+		IPACMDBG_H("Firewall XML %s unchanged, use the parsed copy\n", xml_file);
+		return IPACM_SUCCESS;
+	}
+
+	ret_val = IPACM_read_firewall_xml(xml_file, config);
+	if (ret_val == IPACM_SUCCESS)
+	{
+		if (firewall_cache == NULL)
+		{
+			firewall_cache = (IPACM_firewall_conf_t *)malloc(sizeof(IPACM_firewall_conf_t));
+		}
+		if (firewall_cache != NULL)
+		{
+			memcpy(firewall_cache, config, sizeof(IPACM_firewall_conf_t));
+			strlcpy(firewall_cache->firewall_config_file, xml_file, sizeof(firewall_cache->firewall_config_file));
+			memcpy(&firewall_cache_st, &st, sizeof(st));
+		}
+	}
+	else if (firewall_cache != NULL)
+	{
+		free(firewall_cache);
+		firewall_cache = NULL;
+	}
+	pthread_mutex_unlock(&firewall_cache_lock);
+
+	return ret_val;
+}
 
 /* This function traverses the firewall xml tree */
 static int IPACM_firewall_xml_parse_tree
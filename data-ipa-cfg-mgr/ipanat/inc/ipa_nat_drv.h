@@ -86,6 +86,25 @@ int ipa_nat_add_ipv4_rule(uint32_t table_handle,
 				const ipa_nat_ipv4_rule * rule,
 				uint32_t *rule_handle);
 
+/**
+ * ipa_nat_add_ipv4_rules() - to insert a batch of ipv4 rules
+ * @table_handle: [in] handle of ipv4 nat table
+ * @rules: [in]  Array of new rules
+ * @number_of_rules: [in] number of rules in the array
+ * @rule_handles: [out] Return the handle of each rule, 0 if
+ *                that rule could not be added
+ *
+ * To insert several ipv4 nat rules into ipv4 nat table while
+ * enabling them with as few dma commands as possible. Rules whose
+ * dma command fails are removed from the table again
+ *
+ * Returns:	number of rules added, negative on failure
+ */
+int ipa_nat_add_ipv4_rules(uint32_t table_handle,
+				const ipa_nat_ipv4_rule *rules,
+				uint16_t number_of_rules,
+				uint32_t *rule_handles);
+
 /**
  * ipa_nat_del_ipv4_rule() - to delete ipv4 nat rule
  * @table_handle: [in] handle of ipv4 nat table
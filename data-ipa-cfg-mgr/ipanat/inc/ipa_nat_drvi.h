@@ -73,6 +73,9 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define IPA_NAT_RULE_FLAG_FIELD_SIZE       2
 #define IPA_NAT_RULE_NEXTFIELD_FIELD_SIZE  2
 
+/* Upper bound on rules enabled by a single IPA_IOC_NAT_DMA on bulk add */
+#define IPA_NAT_MAX_DMA_CMD_ENTRIES 32
+
 #define IPA_NAT_FLAG_ENABLE_BIT_MASK  0x8000
 #define IPA_NAT_FLAG_DISABLE_BIT_MASK 0x0000
 
@@ -294,6 +297,15 @@ struct ipa_nat_indx_tbl_meta_info {
 	uint16_t prev_index;
 };
 
+/* Rule written by a bulk add whose enable bit is still pending */
+struct ipa_nat_rsvd_rule {
+	uint16_t tbl_entry;
+	uint16_t prev_index;
+	uint16_t indx_tbl_entry;
+	uint16_t indx_prev_index;
+	uint16_t clnt_indx;
+};
+
 struct ipa_nat_ip4_table_cache {
 	uint8_t valid;
 	uint32_t public_addr;
@@ -320,6 +332,11 @@ struct ipa_nat_ip4_table_cache {
 
 	uint16_t cur_tbl_cnt;
 	uint16_t cur_expn_tbl_cnt;
+
+	/* Entries claimed by a bulk add that are not enabled yet, so
+		 later rules of the same batch do not reuse them */
+	struct ipa_nat_rsvd_rule rsvd_rules[IPA_NAT_MAX_DMA_CMD_ENTRIES];
+	uint16_t rsvd_cnt;
 };
 
 struct ipa_nat_cache {
@@ -406,6 +423,11 @@ int ipa_nati_add_ipv4_rule(uint32_t tbl_hdl,
 				const ipa_nat_ipv4_rule *clnt_rule,
 				uint32_t *rule_hdl);
 
+int ipa_nati_add_ipv4_rules(uint32_t tbl_hdl,
+				const ipa_nat_ipv4_rule *clnt_rules,
+				uint16_t cnt,
+				uint32_t *rule_hdls);
+
 int ipa_nati_generate_rule(uint32_t tbl_hdl,
 				const ipa_nat_ipv4_rule *clnt_rule,
 				struct ipa_nat_sw_rule *rule,
@@ -413,8 +435,7 @@ int ipa_nati_generate_rule(uint32_t tbl_hdl,
 				uint16_t *tbl_entry,
 				uint16_t *indx_tbl_entry);
 
-uint16_t ipa_nati_expn_tbl_free_entry(struct ipa_nat_rule *expn_tbl,
-				uint16_t size);
+uint16_t ipa_nati_expn_tbl_free_entry(struct ipa_nat_ip4_table_cache *tbl_ptr);
 
 uint16_t ipa_nati_generate_tbl_rule(const ipa_nat_ipv4_rule *clnt_rule,
 				struct ipa_nat_sw_rule *sw_rule,
@@ -445,6 +466,10 @@ void ipa_nati_write_next_index(uint8_t tbl_indx,
 int ipa_nati_post_ipv4_dma_cmd(uint8_t tbl_indx,
 				uint16_t entry);
 
+int ipa_nati_post_ipv4_dma_cmds(uint8_t tbl_indx,
+				const uint16_t *entries,
+				uint16_t cnt);
+
 int ipa_nati_del_ipv4_rule(uint32_t tbl_hdl,
 				uint32_t rule_hdl);
 
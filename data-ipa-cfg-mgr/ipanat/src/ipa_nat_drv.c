@@ -115,6 +115,41 @@ int ipa_nat_add_ipv4_rule(uint32_t tbl_hdl,
   return 0;
 }
 
+/**
+ * ipa_nat_add_ipv4_rules() - to insert a batch of ipv4 rules
+ * @table_handle: [in] handle of ipv4 nat table
+ * @rules: [in]  Array of new rules
+ * @number_of_rules: [in] number of rules in the array
+ * @rule_handles: [out] Return the handle of each rule, 0 if
+ *                that rule could not be added
+ *
+ * To insert several ipv4 nat rules into ipv4 nat table while
+ * enabling them with as few dma commands as possible. Rules whose
+ * dma command fails are removed from the table again
+ *
+ * Returns:	number of rules added, negative on failure
+ */
+int ipa_nat_add_ipv4_rules(uint32_t tbl_hdl,
+		const ipa_nat_ipv4_rule *clnt_rules,
+		uint16_t number_of_rules,
+		uint32_t *rule_hdls)
+{
+  int result;
+
+  if (IPA_NAT_INVALID_NAT_ENTRY == tbl_hdl ||
+      tbl_hdl > IPA_NAT_MAX_IP4_TBLS || NULL == rule_hdls ||
+      NULL == clnt_rules || 0 == number_of_rules) {
+    IPAERR("invalide parameters passed \n");
+    return -EINVAL;
+  }
+  IPADBG("Passed Table handle: 0x%x with %d rules\n", tbl_hdl, number_of_rules);
+
+  result = ipa_nati_add_ipv4_rules(tbl_hdl, clnt_rules,
+                                   number_of_rules, rule_hdls);
+  IPADBG("added %d of %d rules\n", result, number_of_rules);
+
+  return result;
+}
 
 /**
  * ipa_nat_del_ipv4_rule() - to delete ipv4 nat rule
@@ -1061,6 +1061,177 @@ int ipa_nati_add_ipv4_rule(uint32_t tbl_hdl,
 	return 0;
 }
 
+/**
+ * ipa_nati_release_rsvd_rules() - undo rules of a failed bulk add
+ * @tbl_hdl: [in] nat table handle
+ *
+ * Clears the table and index entries written for the rules that
+ * are still reserved and unlinks them from their predecessors
+ *
+ * Returns: None
+ */
+static void ipa_nati_release_rsvd_rules(uint32_t tbl_hdl)
+{
+	struct ipa_nat_ip4_table_cache *tbl_ptr;
+	struct ipa_nat_rsvd_rule *rsvd;
+	struct ipa_nat_rule *tbl;
+	struct ipa_nat_indx_tbl_rule *indx_tbl;
+	nat_table_type tbl_type;
+	uint8_t tbl_indx = (uint8_t)(tbl_hdl - 1);
+	uint32_t offset;
+	uint16_t entry;
+
+	tbl_ptr = &ipv4_nat_cache.ip4_tbl[tbl_indx];
+
+	/* Walk backwards so a rule chained behind another rule of the
+		 same batch is unlinked before its predecessor */
+	while (tbl_ptr->rsvd_cnt > 0) {
+		rsvd = &tbl_ptr->rsvd_rules[--tbl_ptr->rsvd_cnt];
+		IPADBG("releasing entry:%d, index entry: %d\n",
+					 rsvd->tbl_entry, rsvd->indx_tbl_entry);
+
+		/* Restore the next index of the predecessors */
+		if (IPA_NAT_INVALID_NAT_ENTRY != rsvd->prev_index) {
+			entry = rsvd->prev_index;
+			tbl_type = IPA_NAT_BASE_TBL;
+			if (entry >= tbl_ptr->table_entries) {
+				tbl_type = IPA_NAT_EXPN_TBL;
+				entry -= tbl_ptr->table_entries;
+			}
+			offset = ipa_nati_get_entry_offset(tbl_ptr, tbl_type, entry);
+			offset += IPA_NAT_RULE_NEXT_FIELD_OFFSET;
+			ipa_nati_write_next_index(tbl_indx, tbl_type,
+																IPA_NAT_INVALID_NAT_ENTRY, offset);
+		}
+
+		if (IPA_NAT_INVALID_NAT_ENTRY != rsvd->indx_prev_index) {
+			entry = rsvd->indx_prev_index;
+			tbl_type = IPA_NAT_INDX_TBL;
+			if (entry >= tbl_ptr->table_entries) {
+				tbl_type = IPA_NAT_INDEX_EXPN_TBL;
+				entry -= tbl_ptr->table_entries;
+			}
+			offset = ipa_nati_get_index_entry_offset(tbl_ptr, tbl_type, entry);
+			offset += IPA_NAT_INDEX_RULE_NEXT_FIELD_OFFSET;
+			ipa_nati_write_next_index(tbl_indx, tbl_type,
+																IPA_NAT_INVALID_NAT_ENTRY, offset);
+		}
+
+		/* Clear the entries, the rule itself was never enabled */
+		entry = rsvd->tbl_entry;
+		tbl = (struct ipa_nat_rule *)tbl_ptr->ipv4_rules_addr;
+		if (entry >= tbl_ptr->table_entries) {
+			tbl = (struct ipa_nat_rule *)tbl_ptr->ipv4_expn_rules_addr;
+			entry -= tbl_ptr->table_entries;
+		}
+		memset(&tbl[entry], 0, sizeof(struct ipa_nat_rule));
+
+		entry = rsvd->indx_tbl_entry;
+		indx_tbl = (struct ipa_nat_indx_tbl_rule *)tbl_ptr->index_table_addr;
+		if (entry >= tbl_ptr->table_entries) {
+			indx_tbl = (struct ipa_nat_indx_tbl_rule *)tbl_ptr->index_table_expn_addr;
+			entry -= tbl_ptr->table_entries;
+			tbl_ptr->index_expn_table_meta[entry].prev_index = 0;
+		}
+		memset(&indx_tbl[entry], 0, sizeof(struct ipa_nat_indx_tbl_rule));
+	}
+}
+
+static int ipa_nati_enable_ipv4_rules(uint32_t tbl_hdl,
+				uint32_t *rule_hdls)
+{
+	struct ipa_nat_ip4_table_cache *tbl_ptr;
+	uint16_t entries[IPA_NAT_MAX_DMA_CMD_ENTRIES];
+	uint16_t cnt;
+	int added = 0;
+
+	tbl_ptr = &ipv4_nat_cache.ip4_tbl[tbl_hdl-1];
+	for (cnt = 0; cnt < tbl_ptr->rsvd_cnt; cnt++) {
+		entries[cnt] = tbl_ptr->rsvd_rules[cnt].tbl_entry;
+	}
+
+	if (ipa_nati_post_ipv4_dma_cmds((uint8_t)(tbl_hdl - 1), entries, tbl_ptr->rsvd_cnt)) {
+		IPAERR("unable to post dma command for %d rules\n", tbl_ptr->rsvd_cnt);
+		ipa_nati_release_rsvd_rules(tbl_hdl);
+		return 0;
+	}
+
+	for (cnt = 0; cnt < tbl_ptr->rsvd_cnt; cnt++) {
+		rule_hdls[tbl_ptr->rsvd_rules[cnt].clnt_indx] =
+			ipa_nati_make_rule_hdl((uint16_t)tbl_hdl, entries[cnt]);
+		if (!rule_hdls[tbl_ptr->rsvd_rules[cnt].clnt_indx]) {
+			IPAERR("unable to generate rule handle\n");
+			continue;
+		}
+		added++;
+	}
+	tbl_ptr->rsvd_cnt = 0;
+
+	return added;
+}
+
+int ipa_nati_add_ipv4_rules(uint32_t tbl_hdl,
+				const ipa_nat_ipv4_rule *clnt_rules,
+				uint16_t cnt,
+				uint32_t *rule_hdls)
+{
+	struct ipa_nat_ip4_table_cache *tbl_ptr;
+	struct ipa_nat_sw_rule sw_rule;
+	struct ipa_nat_indx_tbl_sw_rule index_sw_rule;
+	struct ipa_nat_rsvd_rule *rsvd;
+	uint16_t new_entry, new_index_tbl_entry;
+	uint16_t cnt_i;
+	int added = 0;
+
+	tbl_ptr = &ipv4_nat_cache.ip4_tbl[tbl_hdl-1];
+	tbl_ptr->rsvd_cnt = 0;
+
+	for (cnt_i = 0; cnt_i < cnt; cnt_i++) {
+		rule_hdls[cnt_i] = 0;
+
+		memset(&sw_rule, 0, sizeof(sw_rule));
+		memset(&index_sw_rule, 0, sizeof(index_sw_rule));
+
+		/* Generate rule from client input */
+		if (ipa_nati_generate_rule(tbl_hdl, &clnt_rules[cnt_i],
+						&sw_rule, &index_sw_rule,
+						&new_entry, &new_index_tbl_entry)) {
+			IPAERR("unable to generate rule %d\n", cnt_i);
+			continue;
+		}
+
+		ipa_nati_copy_ipv4_rule_to_hw(tbl_ptr, &sw_rule, new_entry, (uint8_t)(tbl_hdl-1));
+		ipa_nati_copy_ipv4_index_rule_to_hw(tbl_ptr,
+																				&index_sw_rule,
+																				new_index_tbl_entry,
+																				(uint8_t)(tbl_hdl-1));
+
+		/* Reserve the entry until the dma enables it */
+		IPADBG("new entry:%d, new index entry: %d\n", new_entry, new_index_tbl_entry);
+		rsvd = &tbl_ptr->rsvd_rules[tbl_ptr->rsvd_cnt++];
+		rsvd->tbl_entry = new_entry;
+		rsvd->prev_index = sw_rule.prev_index;
+		rsvd->indx_tbl_entry = new_index_tbl_entry;
+		rsvd->indx_prev_index = index_sw_rule.prev_index;
+		rsvd->clnt_indx = cnt_i;
+
+		/* Enable the generated rules with one dma command per batch */
+		if (tbl_ptr->rsvd_cnt == IPA_NAT_MAX_DMA_CMD_ENTRIES) {
+			added += ipa_nati_enable_ipv4_rules(tbl_hdl, rule_hdls);
+		}
+	}
+
+	if (tbl_ptr->rsvd_cnt > 0) {
+		added += ipa_nati_enable_ipv4_rules(tbl_hdl, rule_hdls);
+	}
+
+#ifdef NAT_DUMP
+	ipa_nat_dump_ipv4_table(tbl_hdl);
+#endif
+
+	return added;
+}
+
 int ipa_nati_generate_rule(uint32_t tbl_hdl,
 				const ipa_nat_ipv4_rule *clnt_rule,
 				struct ipa_nat_sw_rule *rule,
@@ -1106,6 +1277,29 @@ int ipa_nati_generate_rule(uint32_t tbl_hdl,
 	return 0;
 }
 
+/* returns 1 if the table entry is enabled or reserved by a bulk add */
+static uint8_t ipa_nati_is_tbl_entry_used(struct ipa_nat_ip4_table_cache *tbl_ptr,
+						uint16_t entry)
+{
+	struct ipa_nat_rule *tbl;
+	uint16_t cnt;
+
+	for (cnt = 0; cnt < tbl_ptr->rsvd_cnt; cnt++) {
+		if (tbl_ptr->rsvd_rules[cnt].tbl_entry == entry) {
+			return 1;
+		}
+	}
+
+	if (entry >= tbl_ptr->table_entries) {
+		tbl = (struct ipa_nat_rule *)tbl_ptr->ipv4_expn_rules_addr;
+		entry -= tbl_ptr->table_entries;
+	} else {
+		tbl = (struct ipa_nat_rule *)tbl_ptr->ipv4_rules_addr;
+	}
+
+	return Read16BitFieldValue(tbl[entry].ip_cksm_enbl, ENABLE_FIELD) ? 1 : 0;
+}
+
 uint16_t ipa_nati_generate_tbl_rule(const ipa_nat_ipv4_rule *clnt_rule,
 						struct ipa_nat_sw_rule *sw_rule,
 						struct ipa_nat_ip4_table_cache *tbl_ptr)
@@ -1163,8 +1357,7 @@ uint16_t ipa_nati_generate_tbl_rule(const ipa_nat_ipv4_rule *clnt_rule,
 
 	/* check whether there is any collision
 		 if no collision return */
-	if (!Read16BitFieldValue(tbl[new_entry].ip_cksm_enbl,
-													 ENABLE_FIELD)) {
+	if (!ipa_nati_is_tbl_entry_used(tbl_ptr, new_entry)) {
 		sw_rule->prev_index = 0;
 		IPADBG("Destination Nat New Entry Index %d\n", new_entry);
 		return new_entry;
@@ -1197,8 +1390,7 @@ uint16_t ipa_nati_generate_tbl_rule(const ipa_nat_ipv4_rule *clnt_rule,
 	}
 
 	/* On collision check for the free entry in expansion table */
-	new_entry = ipa_nati_expn_tbl_free_entry(expn_tbl,
-					tbl_ptr->expn_table_entries);
+	new_entry = ipa_nati_expn_tbl_free_entry(tbl_ptr);
 
 	if (IPA_NAT_INVALID_NAT_ENTRY == new_entry) {
 		/* Expansion table is full return*/
@@ -1214,14 +1406,13 @@ uint16_t ipa_nati_generate_tbl_rule(const ipa_nat_ipv4_rule *clnt_rule,
 }
 
 /* returns expn table entry index */
-uint16_t ipa_nati_expn_tbl_free_entry(struct ipa_nat_rule *expn_tbl,
-						uint16_t size)
+uint16_t ipa_nati_expn_tbl_free_entry(struct ipa_nat_ip4_table_cache *tbl_ptr)
 {
 	int cnt;
 
-	for (cnt = 1; cnt < size; cnt++) {
-		if (!Read16BitFieldValue(expn_tbl[cnt].ip_cksm_enbl,
-														 ENABLE_FIELD)) {
+	for (cnt = 1; cnt < tbl_ptr->expn_table_entries; cnt++) {
+		if (!ipa_nati_is_tbl_entry_used(tbl_ptr,
+						(uint16_t)(cnt + tbl_ptr->table_entries))) {
 			IPADBG("new expansion table entry index %d\n", cnt);
 			return cnt;
 		}
@@ -1463,53 +1654,70 @@ void ipa_nati_copy_ipv4_index_rule_to_hw(
 
 int ipa_nati_post_ipv4_dma_cmd(uint8_t tbl_indx,
 				uint16_t entry)
+{
+	return ipa_nati_post_ipv4_dma_cmds(tbl_indx, &entry, 1);
+}
+
+int ipa_nati_post_ipv4_dma_cmds(uint8_t tbl_indx,
+				const uint16_t *entries,
+				uint16_t cnt)
 {
 	struct ipa_ioc_nat_dma_cmd *cmd;
 	struct ipa_nat_rule *tbl_ptr;
 	uint32_t offset = ipv4_nat_cache.ip4_tbl[tbl_indx].tbl_addr_offset;
+	uint16_t entry, cnt_i;
 	int ret = 0;
 
+	if (NULL == entries || 0 == cnt || cnt > IPA_NAT_MAX_DMA_CMD_ENTRIES) {
+		IPAERR("invalid parameters, dma entries: %d\n", cnt);
+		return -EINVAL;
+	}
+
 	cmd = (struct ipa_ioc_nat_dma_cmd *)
 	malloc(sizeof(struct ipa_ioc_nat_dma_cmd)+
-				 sizeof(struct ipa_ioc_nat_dma_one));
+				 (cnt * sizeof(struct ipa_ioc_nat_dma_one)));
 	if (NULL == cmd) {
 		IPAERR("unable to allocate memory\n");
 		return -ENOMEM;
 	}
 
-	if (entry < ipv4_nat_cache.ip4_tbl[tbl_indx].table_entries) {
-		tbl_ptr =
-			 (struct ipa_nat_rule *)ipv4_nat_cache.ip4_tbl[tbl_indx].ipv4_rules_addr;
+	for (cnt_i = 0; cnt_i < cnt; cnt_i++) {
+		entry = entries[cnt_i];
 
-		cmd->dma[0].table_index = tbl_indx;
-		cmd->dma[0].base_addr = IPA_NAT_BASE_TBL;
-		cmd->dma[0].data = IPA_NAT_FLAG_ENABLE_BIT_MASK;
+		if (entry < ipv4_nat_cache.ip4_tbl[tbl_indx].table_entries) {
+			tbl_ptr =
+				 (struct ipa_nat_rule *)ipv4_nat_cache.ip4_tbl[tbl_indx].ipv4_rules_addr;
 
-		cmd->dma[0].offset = (char *)&tbl_ptr[entry] - (char *)tbl_ptr;
-		cmd->dma[0].offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
-	} else {
-		tbl_ptr =
-			 (struct ipa_nat_rule *)ipv4_nat_cache.ip4_tbl[tbl_indx].ipv4_expn_rules_addr;
-		entry = entry - ipv4_nat_cache.ip4_tbl[tbl_indx].table_entries;
+			cmd->dma[cnt_i].table_index = tbl_indx;
+			cmd->dma[cnt_i].base_addr = IPA_NAT_BASE_TBL;
+			cmd->dma[cnt_i].data = IPA_NAT_FLAG_ENABLE_BIT_MASK;
 
-		cmd->dma[0].table_index = tbl_indx;
-		cmd->dma[0].base_addr = IPA_NAT_EXPN_TBL;
-		cmd->dma[0].data = IPA_NAT_FLAG_ENABLE_BIT_MASK;
+			cmd->dma[cnt_i].offset = (char *)&tbl_ptr[entry] - (char *)tbl_ptr;
+			cmd->dma[cnt_i].offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
+		} else {
+			tbl_ptr =
+				 (struct ipa_nat_rule *)ipv4_nat_cache.ip4_tbl[tbl_indx].ipv4_expn_rules_addr;
+			entry = entry - ipv4_nat_cache.ip4_tbl[tbl_indx].table_entries;
+
+			cmd->dma[cnt_i].table_index = tbl_indx;
+			cmd->dma[cnt_i].base_addr = IPA_NAT_EXPN_TBL;
+			cmd->dma[cnt_i].data = IPA_NAT_FLAG_ENABLE_BIT_MASK;
 
-		cmd->dma[0].offset = (char *)&tbl_ptr[entry] - (char *)tbl_ptr;
-		cmd->dma[0].offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
-		cmd->dma[0].offset += offset;
+			cmd->dma[cnt_i].offset = (char *)&tbl_ptr[entry] - (char *)tbl_ptr;
+			cmd->dma[cnt_i].offset += IPA_NAT_RULE_FLAG_FIELD_OFFSET;
+			cmd->dma[cnt_i].offset += offset;
+		}
 	}
 
-	cmd->entries = 1;
+	cmd->entries = (uint8_t)cnt;
 	if (ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_NAT_DMA, cmd)) {
-		perror("ipa_nati_post_ipv4_dma_cmd(): ioctl error value");
+		perror("ipa_nati_post_ipv4_dma_cmds(): ioctl error value");
 		IPAERR("unable to call dma icotl\n");
 		IPADBG("ipa fd %d\n", ipv4_nat_cache.ipa_fd);
 		ret = -EIO;
 		goto fail;
 	}
-	IPADBG("posted IPA_IOC_NAT_DMA to kernel successfully during add operation\n");
+	IPADBG("posted IPA_IOC_NAT_DMA with %d entries to kernel successfully during add operation\n", cnt);
 
 
 fail:
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of The Linux Foundation nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*=========================================================================*/
+/*!
+	@file
+	ipa_nat_test023.c
+
+	@brief
+	Verify the following scenario:
+	1. Add ipv4 table
+	2. Add 4 rules that hash to the same base entry in one batch
+	3. Check every rule got its own entry holding its private ip
+	4. Delete the 4 rules
+	5. Delete ipv4 table
+*/
+/*=========================================================================*/
+
+#include "ipa_nat_drv.h"
+#include "ipa_nat_drvi.h"
+#include "ipa_nat_test.h"
+
+extern struct ipa_nat_cache ipv4_nat_cache;
+
+#define IPA_NAT_TEST023_RULES 4
+
+int ipa_nat_test023(int total_entries, u32 tbl_hdl, u8 sep)
+{
+	int ret, cnt, cnt2;
+	u32 rule_hdl[IPA_NAT_TEST023_RULES];
+	ipa_nat_ipv4_rule ipv4_rule[IPA_NAT_TEST023_RULES];
+	struct ipa_nat_rule *tbl_ptr;
+	u16 tbl_entry;
+	u8 expn_tbl;
+
+	u32 pub_ip_add = 0x011617c0;   /* "192.23.22.1" */
+
+	/* Same target and public port so all rules collide in base table */
+	for (cnt = 0; cnt < IPA_NAT_TEST023_RULES; cnt++)
+	{
+		ipv4_rule[cnt].target_ip = 0xC1171601; /* 193.23.22.1 */
+		ipv4_rule[cnt].target_port = 1234;
+		ipv4_rule[cnt].private_ip = 0xC2171601 + cnt; /* 194.23.22.1+ */
+		ipv4_rule[cnt].private_port = 5678 + cnt;
+		ipv4_rule[cnt].protocol = IPPROTO_TCP;
+		ipv4_rule[cnt].public_port = 9050;
+	}
+
+	IPADBG("%s():\n",__FUNCTION__);
+
+	if(sep)
+	{
+		ret = ipa_nat_add_ipv4_tbl(pub_ip_add, total_entries, &tbl_hdl);
+		CHECK_ERR1(ret, tbl_hdl);
+	}
+
+	ret = ipa_nat_add_ipv4_rules(tbl_hdl, ipv4_rule,
+				IPA_NAT_TEST023_RULES, rule_hdl);
+	CHECK_ERR1(ret != IPA_NAT_TEST023_RULES, tbl_hdl);
+
+	for (cnt = 0; cnt < IPA_NAT_TEST023_RULES; cnt++)
+	{
+		ipa_nati_parse_ipv4_rule_hdl((u8)(tbl_hdl - 1), (u16)rule_hdl[cnt],
+				&expn_tbl, &tbl_entry);
+		tbl_ptr = (struct ipa_nat_rule *)(expn_tbl ?
+				ipv4_nat_cache.ip4_tbl[tbl_hdl - 1].ipv4_expn_rules_addr :
+				ipv4_nat_cache.ip4_tbl[tbl_hdl - 1].ipv4_rules_addr);
+
+		/* A rule overwritten by a later one of the batch shows up here */
+		ret = (tbl_ptr[tbl_entry].private_ip != ipv4_rule[cnt].private_ip);
+		CHECK_ERR1(ret, tbl_hdl);
+		ret = !Read16BitFieldValue(tbl_ptr[tbl_entry].ip_cksm_enbl, ENABLE_FIELD);
+		CHECK_ERR1(ret, tbl_hdl);
+
+		for (cnt2 = 0; cnt2 < cnt; cnt2++)
+		{
+			ret = (rule_hdl[cnt2] == rule_hdl[cnt]);
+			CHECK_ERR1(ret, tbl_hdl);
+		}
+	}
+
+	for (cnt = 0; cnt < IPA_NAT_TEST023_RULES; cnt++)
+	{
+		ret = ipa_nat_del_ipv4_rule(tbl_hdl, rule_hdl[cnt]);
+		CHECK_ERR1(ret, tbl_hdl);
+	}
+
+	if(sep)
+	{
+		ret = ipa_nat_del_ipv4_tbl(tbl_hdl);
+		CHECK_ERR(ret);
+	}
+
+	return 0;
+}
@@ -626,6 +626,18 @@ int main(int argc, char* argv[])
 				IPAERR("ipa_nat_test0%d Fail\n", exec);
 			}
 			exec++;
+
+			IPADBG("\n\nExecuting ipa_nat_test0%d\n", exec);
+			ret = ipa_nat_test023(total_entries, tbl_hdl, sep);
+			if (!ret)
+			{
+				pass++;
+			}
+			else
+			{
+				IPAERR("ipa_nat_test0%d Fail\n", exec);
+			}
+			exec++;
 		}
 
 		if (!sep)
@@ -146,4 +146,14 @@ DEFAULT_IMPL(false)
 void LocAdapterBase::
     reportGnssMeasurementData(GnssData &gnssMeasurementData)
 DEFAULT_IMPL()
+
+void LocAdapterBase::
+    reportGnssMeasurement(GnssSvMeasurementSet &svMeasurementSet,
+                          GnssData *gnssMeasurementData)
+{
+    reportSvMeasurement(svMeasurementSet);
+    if (NULL != gnssMeasurementData) {
+        reportGnssMeasurementData(*gnssMeasurementData);
+    }
+}
 } // namespace loc_core
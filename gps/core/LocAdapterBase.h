@@ -124,6 +124,10 @@ public:
     inline virtual bool isInSession() { return false; }
     ContextBase* getContext() const { return mContext; }
     virtual void reportGnssMeasurementData(GnssData &gnssMeasurementData);
+    // SV measurement set and GnssData converted from the same measurement
+    // report; gnssMeasurementData is NULL when the report carries none.
+    virtual void reportGnssMeasurement(GnssSvMeasurementSet &svMeasurementSet,
+                                       GnssData *gnssMeasurementData);
 };
 
 } // namespace loc_core
@@ -30,6 +30,10 @@
 #define LOG_TAG "LocSvc_LocApiBase"
 
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <LocApiBase.h>
 #include <LocAdapterBase.h>
 #include <platform_lib_log_util.h>
@@ -401,6 +405,16 @@ void LocApiBase::reportGnssMeasurementData(GnssData &gnssMeasurementData)
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportGnssMeasurementData(gnssMeasurementData));
 }
 
+void LocApiBase::reportGnssMeasurement(GnssSvMeasurementSet &svMeasurementSet,
+                                       GnssData *gnssMeasurementData)
+{
+    // loop through adapters, and deliver both views of the report together.
+    TO_ALL_LOCADAPTERS(
+        mLocAdapters[i]->reportGnssMeasurement(svMeasurementSet,
+                                               gnssMeasurementData)
+    );
+}
+
 enum loc_api_adapter_err LocApiBase::
    open(LOC_API_ADAPTER_EVENT_MASK_T mask)
 DEFAULT_IMPL(LOC_API_ADAPTER_ERR_SUCCESS)
@@ -441,6 +455,38 @@ enum loc_api_adapter_err LocApiBase::
     setXtraData(char* data, int length)
 DEFAULT_IMPL(LOC_API_ADAPTER_ERR_SUCCESS)
 
+// Injects the file straight from its mapping; the mapping is private so
+// the file is never written, and nothing is copied unless setXtraData()
+// writes into the buffer.
+enum loc_api_adapter_err LocApiBase::
+    setXtraDataFromFile(const char* path)
+{
+    enum loc_api_adapter_err ret = LOC_API_ADAPTER_ERR_FAILURE;
+    struct stat st;
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) {
+        LOC_LOGE("%s:%d]: cannot open %s", __func__, __LINE__, path);
+        return ret;
+    }
+
+    if (0 == fstat(fd, &st) && st.st_size > 0 && st.st_size <= INT32_MAX) {
+        void* data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED != data) {
+            ret = setXtraData((char*)data, (int)st.st_size);
+            munmap(data, st.st_size);
+        } else {
+            LOC_LOGE("%s:%d]: cannot map %s", __func__, __LINE__, path);
+        }
+    } else {
+        LOC_LOGE("%s:%d]: bad XTRA file %s", __func__, __LINE__, path);
+    }
+
+    ::close(fd);
+    return ret;
+}
+
 enum loc_api_adapter_err LocApiBase::
     requestXtraServer()
 DEFAULT_IMPL(LOC_API_ADAPTER_ERR_SUCCESS)
@@ -135,6 +135,8 @@ public:
     void requestNiNotify(GpsNiNotification &notify, const void* data);
     void saveSupportedMsgList(uint64_t supportedMsgList);
     void reportGnssMeasurementData(GnssData &gnssMeasurementData);
+    void reportGnssMeasurement(GnssSvMeasurementSet &svMeasurementSet,
+                               GnssData *gnssMeasurementData);
     void saveSupportedFeatureList(uint8_t *featureList);
 
     // downward calls
@@ -159,6 +161,8 @@ public:
         setTime(GpsUtcTime time, int64_t timeReference, int uncertainty);
     virtual enum loc_api_adapter_err
         setXtraData(char* data, int length);
+    virtual enum loc_api_adapter_err
+        setXtraDataFromFile(const char* path);
     virtual enum loc_api_adapter_err
         requestXtraServer();
     virtual enum loc_api_adapter_err
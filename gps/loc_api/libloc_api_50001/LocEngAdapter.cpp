@@ -588,6 +588,15 @@ void LocEngAdapter::reportGnssMeasurementData(GnssData &gnssMeasurementData)
                                            gnssMeasurementData));
 }
 
+// Both halves of one measurement report go out in a single message, which
+// hands the SV set to ULP and then GnssData to the framework on the msg task.
+void LocEngAdapter::reportGnssMeasurement(GnssSvMeasurementSet &svMeasurementSet,
+                                          GnssData *gnssMeasurementData)
+{
+    sendMsg(new LocEngReportGnssMeasurement(this, svMeasurementSet,
+                                           gnssMeasurementData));
+}
+
 /*
   Set Gnss Constellation Config
  */
@@ -145,6 +145,11 @@ public:
     {
         return mLocApi->setXtraData(data, length);
     }
+    inline enum loc_api_adapter_err
+        setXtraDataFromFile(const char* path)
+    {
+        return mLocApi->setXtraDataFromFile(path);
+    }
     inline enum loc_api_adapter_err
         requestXtraServer()
     {
@@ -295,6 +300,8 @@ public:
     virtual bool reportDataCallOpened();
     virtual bool reportDataCallClosed();
     virtual void reportGnssMeasurementData(GnssData &gnssMeasurementData);
+    virtual void reportGnssMeasurement(GnssSvMeasurementSet &svMeasurementSet,
+                                       GnssData *gnssMeasurementData);
 
     inline const LocPosMode& getPositionMode() const
     {return mFixCriteria;}
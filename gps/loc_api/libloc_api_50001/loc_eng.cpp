@@ -758,6 +758,8 @@ struct LocEngSensorPerfControlConfig : public LocMsg {
 };
 
 //        case LOC_ENG_MSG_REPORT_POSITION:
+LOC_POOL_DEFINE(LocEngReportPosition, 4);
+
 LocEngReportPosition::LocEngReportPosition(LocAdapterBase* adapter,
                                            UlpLocation &loc,
                                            GpsLocationExtended &locExtended,
@@ -862,6 +864,8 @@ void LocEngReportPosition::send() const {
 
 
 //        case LOC_ENG_MSG_REPORT_SV:
+LOC_POOL_DEFINE(LocEngReportSv, 4);
+
 LocEngReportSv::LocEngReportSv(LocAdapterBase* adapter,
                                GnssSvStatus &sv,
                                GpsLocationExtended &locExtended,
@@ -924,6 +928,8 @@ inline void LocEngReportStatus::log() const {
 }
 
 //        case LOC_ENG_MSG_REPORT_NMEA:
+LOC_POOL_DEFINE(LocEngReportNmea, 16);
+
 LocEngReportNmea::LocEngReportNmea(void* locEng,
                                    const char* data, int len) :
     LocMsg(), mLocEng(locEng), mNmea(new char[len]), mLen(len)
@@ -1669,15 +1675,37 @@ struct LocEngGnssConstellationConfig : public LocMsg {
 };
 
 //        case LOC_ENG_MSG_REPORT_GNSS_MEASUREMENT:
+// one per indication, and an epoch arrives as up to 4 back to back
+LOC_POOL_DEFINE(LocEngReportGnssMeasurement, 4);
+
 LocEngReportGnssMeasurement::LocEngReportGnssMeasurement(void* locEng,
                                                        GnssData &gnssData) :
-    LocMsg(), mLocEng(locEng), mGnssData(gnssData)
+    LocMsg(), mLocEng(locEng), mAdapter(NULL),
+    mHasGnssData(true), mGnssData(gnssData)
+{
+    locallog();
+}
+LocEngReportGnssMeasurement::LocEngReportGnssMeasurement(LocEngAdapter* adapter,
+                                                       GnssSvMeasurementSet &svMeasurementSet,
+                                                       GnssData* gnssData) :
+    LocMsg(), mLocEng(adapter->getOwner()), mAdapter(adapter),
+    mSvMeasurementSet(svMeasurementSet), mHasGnssData(NULL != gnssData)
 {
+    // GnssData is only there for GPS reports, don't copy it otherwise
+    if (mHasGnssData) {
+        mGnssData = *gnssData;
+    }
     locallog();
 }
 void LocEngReportGnssMeasurement::proc() const {
     loc_eng_data_s_type* locEng = (loc_eng_data_s_type*) mLocEng;
-    if (locEng->mute_session_state != LOC_MUTE_SESS_IN_SESSION)
+    if (NULL != mAdapter) {
+        // SV set goes to ULP ahead of the GnssData of the same report
+        mAdapter->reportSvMeasurement(
+            (GnssSvMeasurementSet&)mSvMeasurementSet);
+    }
+    if (mHasGnssData &&
+        locEng->mute_session_state != LOC_MUTE_SESS_IN_SESSION)
     {
         if (locEng->gnss_measurement_cb != NULL) {
             LOC_LOGV("Calling gnss_measurement_cb");
@@ -1687,6 +1715,11 @@ void LocEngReportGnssMeasurement::proc() const {
 }
 void LocEngReportGnssMeasurement::locallog() const {
     IF_LOC_LOGV {
+        if (!mHasGnssData) {
+            LOC_LOGV("%s:%d]: SV measurement set only, #of SV: %d\n",
+                     __func__, __LINE__, mSvMeasurementSet.gnssMeas.numSvs);
+            return;
+        }
         LOC_LOGV("%s:%d]: Received in GPS HAL."
                  "GNSS Measurements count: %d \n",
                  __func__, __LINE__, mGnssData.measurement_count);
@@ -185,6 +185,8 @@ int  loc_eng_xtra_init (loc_eng_data_s_type &loc_eng_data,
                        GpsXtraExtCallbacks* callbacks);
 int  loc_eng_xtra_inject_data(loc_eng_data_s_type &loc_eng_data,
                              char* data, int length);
+int  loc_eng_xtra_inject_file(loc_eng_data_s_type &loc_eng_data,
+                             const char* path);
 int  loc_eng_xtra_request_server(loc_eng_data_s_type &loc_eng_data);
 void loc_eng_xtra_version_check(loc_eng_data_s_type &loc_eng_data, int check);
 
@@ -37,6 +37,7 @@
 #include <loc_eng_log.h>
 #include <loc_eng.h>
 #include <MsgTask.h>
+#include <LocPool.h>
 #include <LocEngAdapter.h>
 #include <platform_lib_includes.h>
 
@@ -101,6 +102,8 @@ struct LocEngReportPosition : public LocMsg {
     void locallog() const;
     virtual void log() const;
     void send() const;
+    // sent for every fix, recycled through a pool
+    LOC_POOL_DECLARE(LocEngReportPosition)
 };
 
 struct LocEngReportSv : public LocMsg {
@@ -116,6 +119,8 @@ struct LocEngReportSv : public LocMsg {
     void locallog() const;
     virtual void log() const;
     void send() const;
+    // sent for every SV report, recycled through a pool
+    LOC_POOL_DECLARE(LocEngReportSv)
 };
 
 struct LocEngReportStatus : public LocMsg {
@@ -141,6 +146,8 @@ struct LocEngReportNmea : public LocMsg {
     virtual void proc() const;
     void locallog() const;
     virtual void log() const;
+    // sent for every NMEA sentence, recycled through a pool
+    LOC_POOL_DECLARE(LocEngReportNmea)
 };
 
 struct LocEngReportXtraServer : public LocMsg {
@@ -291,12 +298,21 @@ struct LocEngGetZpp : public LocMsg {
 
 struct LocEngReportGnssMeasurement : public LocMsg {
     void* mLocEng;
-    const GnssData mGnssData;
+    // set when the report carries an SV measurement set for ULP
+    LocEngAdapter* mAdapter;
+    GnssSvMeasurementSet mSvMeasurementSet;
+    const bool mHasGnssData;
+    GnssData mGnssData;
     LocEngReportGnssMeasurement(void* locEng,
                                GnssData &gnssData);
+    LocEngReportGnssMeasurement(LocEngAdapter* adapter,
+                               GnssSvMeasurementSet &svMeasurementSet,
+                               GnssData* gnssData);
     virtual void proc() const;
     void locallog() const;
     virtual void log() const;
+    // sent for every measurement report, recycled through a pool
+    LOC_POOL_DECLARE(LocEngReportGnssMeasurement)
 };
 
 #ifdef __cplusplus
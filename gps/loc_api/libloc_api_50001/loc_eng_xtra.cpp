@@ -81,6 +81,32 @@ struct LocEngInjectXtraData : public LocMsg {
     }
 };
 
+struct LocEngInjectXtraFile : public LocMsg {
+    LocEngAdapter* mAdapter;
+    char* mPath;
+    inline LocEngInjectXtraFile(LocEngAdapter* adapter,
+                                const char* path):
+        LocMsg(), mAdapter(adapter),
+        mPath(new char[strlen(path) + 1])
+    {
+        strcpy(mPath, path);
+        locallog();
+    }
+    inline ~LocEngInjectXtraFile()
+    {
+        delete[] mPath;
+    }
+    inline virtual void proc() const {
+        mAdapter->setXtraDataFromFile(mPath);
+    }
+    inline  void locallog() const {
+        LOC_LOGV("path: %s", mPath);
+    }
+    inline virtual void log() const {
+        locallog();
+    }
+};
+
 struct LocEngSetXtraVersionCheck : public LocMsg {
     LocEngAdapter *mAdapter;
     int mCheck;
@@ -169,6 +195,32 @@ int loc_eng_xtra_inject_data(loc_eng_data_s_type &loc_eng_data,
     return 0;
 }
 /*===========================================================================
+FUNCTION    loc_eng_xtra_inject_file
+
+DESCRIPTION
+   Injects the XTRA file at path into the engine, mapping the file on the
+   engine thread instead of copying its data into the message.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   0
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+int loc_eng_xtra_inject_file(loc_eng_data_s_type &loc_eng_data,
+                             const char* path)
+{
+    ENTRY_LOG();
+    LocEngAdapter* adapter = loc_eng_data.adapter;
+    adapter->sendMsg(new LocEngInjectXtraFile(adapter, path));
+    EXIT_LOG(%d, 0);
+    return 0;
+}
+/*===========================================================================
 FUNCTION    loc_eng_xtra_request_server
 
 DESCRIPTION
@@ -35,6 +35,10 @@ LOCAL_CFLAGS += \
     -fno-short-enums \
     -D_ANDROID_
 
+ifeq ($(TARGET_BUILD_VARIANT),user)
+   LOCAL_CFLAGS += -DTARGET_BUILD_VARIANT_USER
+endif
+
 LOCAL_COPY_HEADERS_TO:= libloc_api_v02/
 
 LOCAL_COPY_HEADERS:= \
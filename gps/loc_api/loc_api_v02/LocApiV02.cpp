@@ -34,6 +34,9 @@
 #include <string.h>
 #include <math.h>
 #include <dlfcn.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
 
 #include <hardware/gps.h>
 
@@ -97,11 +100,128 @@ const struct conf_scaler_to_68_pair confScalers[CONF_SCALER_ARRAY_MAX] = {
 
 /*fixed timestamp uncertainty 10 milli second */
 static int ap_timestamp_uncertainty = 0;
+/* XTRA parts injected without waiting for the indication of the previous
+   ones; 1 injects one part at a time */
+static int xtra_inject_window = 1;
 static loc_param_s_type gps_conf_param_table[] =
 {
-        {"AP_TIMESTAMP_UNCERTAINTY",&ap_timestamp_uncertainty,NULL,'n'}
+        {"AP_TIMESTAMP_UNCERTAINTY",&ap_timestamp_uncertainty,NULL,'n'},
+        {"XTRA_INJECT_WINDOW",&xtra_inject_window,NULL,'n'}
 };
 
+#define XTRA_INJECT_WINDOW_MAX      (8)
+/* times a part that was not acknowledged is injected again */
+#define XTRA_INJECT_PART_RETRIES    (2)
+
+/* longest setXtraData() waits for an injected part to complete; each part
+   is completed or timed out by loc_api_sync_req within
+   LOC_ENGINE_SYNC_REQUEST_TIMEOUT, so this only expires if that is stuck */
+#define XTRA_INJECT_WAIT_TIMEOUT    (2 * LOC_ENGINE_SYNC_REQUEST_TIMEOUT)
+
+/* XTRA injection in progress, shared with the indication callbacks; the
+   caller and every part in flight hold a reference, so a caller that gave
+   up waiting leaves the state to the last callback to free */
+typedef struct {
+    pthread_mutex_t         mutex;
+    pthread_cond_t          cond;       /* CLOCK_MONOTONIC */
+    uint16_t                refs;
+    uint16_t                totalParts;
+    uint16_t                inFlight;
+    uint16_t                acked;
+    bool*                   partAcked;
+    locClientStatusEnumType status;     /* last failure */
+} XtraInjectStateType;
+
+static XtraInjectStateType* xtraInjectStateCreate(uint16_t total_parts)
+{
+    XtraInjectStateType* state = new XtraInjectStateType;
+    pthread_condattr_t attr;
+
+    pthread_mutex_init(&state->mutex, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&state->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    state->refs = 1;
+    state->totalParts = total_parts;
+    state->inFlight = 0;
+    state->acked = 0;
+    state->partAcked = new bool[total_parts]();
+    state->status = eLOC_CLIENT_SUCCESS;
+    return state;
+}
+
+/* drops one reference, freeing the state with the last one */
+static void xtraInjectStateRelease(XtraInjectStateType* state)
+{
+    pthread_mutex_lock(&state->mutex);
+    bool last = (0 == --state->refs);
+    pthread_mutex_unlock(&state->mutex);
+
+    if (last) {
+        delete[] state->partAcked;
+        pthread_cond_destroy(&state->cond);
+        pthread_mutex_destroy(&state->mutex);
+        delete state;
+    }
+}
+
+/* waits with state->mutex held until at most max parts are in flight;
+   returns false if that takes longer than XTRA_INJECT_WAIT_TIMEOUT */
+static bool xtraInjectWaitInFlight(XtraInjectStateType* state, int max)
+{
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += XTRA_INJECT_WAIT_TIMEOUT / 1000;
+    deadline.tv_nsec += (XTRA_INJECT_WAIT_TIMEOUT % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    while (state->inFlight > max) {
+        if (ETIMEDOUT == pthread_cond_timedwait(&state->cond, &state->mutex,
+                                                &deadline)) {
+            return state->inFlight <= max;
+        }
+    }
+    return true;
+}
+
+/* completion of one injected XTRA part; parts are matched to indications
+   by the part number the indication carries */
+static void xtraInjectIndCb(void* cb_data, locClientStatusEnumType status,
+                            uint32_t ind_id, const void* ind_payload_ptr,
+                            uint32_t ind_payload_size)
+{
+    XtraInjectStateType* state = (XtraInjectStateType*)cb_data;
+    const qmiLocInjectPredictedOrbitsDataIndMsgT_v02* ind =
+        (const qmiLocInjectPredictedOrbitsDataIndMsgT_v02*)ind_payload_ptr;
+
+    pthread_mutex_lock(&state->mutex);
+    if (eLOC_CLIENT_SUCCESS == status && NULL != ind &&
+        eQMI_LOC_SUCCESS_V02 == ind->status && ind->partNum_valid &&
+        ind->partNum >= 1 && ind->partNum <= state->totalParts) {
+        if (!state->partAcked[ind->partNum - 1]) {
+            state->partAcked[ind->partNum - 1] = true;
+            state->acked++;
+        }
+    } else {
+        LOC_LOGE("%s:%d]: failed status = %s, ind.status = %s, ind.partNum = %d\n",
+                 __func__, __LINE__, loc_get_v02_client_status_name(status),
+                 (NULL != ind) ? loc_get_v02_qmi_status_name(ind->status) : "none",
+                 (NULL != ind && ind->partNum_valid) ? ind->partNum : -1);
+        state->status = (eLOC_CLIENT_SUCCESS != status) ?
+            status : eLOC_CLIENT_FAILURE_GENERAL;
+    }
+    state->inFlight--;
+    pthread_cond_signal(&state->cond);
+    pthread_mutex_unlock(&state->mutex);
+
+    xtraInjectStateRelease(state);
+}
+
 /* static event callbacks that call the LocApiV02 callbacks*/
 
 /* global event callback, call the eventCb function in loc api adapter v02
@@ -1282,18 +1402,35 @@ enum loc_api_adapter_err LocApiV02 :: setXtraData(
   char* data, int length)
 {
   locClientStatusEnumType status = eLOC_CLIENT_SUCCESS;
-  int     total_parts;
-  uint8_t   part;
-  uint16_t  len_injected;
+  uint16_t  total_parts;
+  uint16_t  part;
+  uint16_t  acked_parts;
+  uint32_t  offset;
+  uint32_t  retries = 0;
+  int       window = xtra_inject_window;
+  bool      timed_out = false;
+  struct timespec start, end;
 
   locClientReqUnionType req_union;
   qmiLocInjectPredictedOrbitsDataReqMsgT_v02 inject_xtra;
-  qmiLocInjectPredictedOrbitsDataIndMsgT_v02 inject_xtra_ind;
-
-  req_union.pInjectPredictedOrbitsDataReq = &inject_xtra;
+  XtraInjectStateType* state;
 
   LOC_LOGD("%s:%d]: xtra size = %d\n", __func__, __LINE__, length);
 
+  if (length <= 0) {
+    return LOC_API_ADAPTER_ERR_INVALID_PARAMETER;
+  }
+  if (window < 1) {
+    window = 1;
+  } else if (window > XTRA_INJECT_WINDOW_MAX) {
+    window = XTRA_INJECT_WINDOW_MAX;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  req_union.pInjectPredictedOrbitsDataReq = &inject_xtra;
+
+  memset(&inject_xtra, 0, sizeof(inject_xtra));
   inject_xtra.formatType_valid = 1;
   inject_xtra.formatType = eQMI_LOC_PREDICTED_ORBITS_XTRA_V02;
   inject_xtra.totalSize = length;
@@ -1302,53 +1439,118 @@ enum loc_api_adapter_err LocApiV02 :: setXtraData(
 
   inject_xtra.totalParts = total_parts;
 
-  len_injected = 0; // O bytes injected
+  state = xtraInjectStateCreate(total_parts);
 
-  // XTRA injection starts with part 1
-  for (part = 1; part <= total_parts; part++)
+  // Inject every part not acknowledged yet, keeping up to window parts
+  // waiting for their indications; parts that fail are injected again in
+  // the next round
+  for (uint32_t round = 0; round <= XTRA_INJECT_PART_RETRIES && !timed_out;
+       round++)
   {
-    inject_xtra.partNum = part;
-
-    if (QMI_LOC_MAX_PREDICTED_ORBITS_PART_LEN_V02 > (length - len_injected))
-    {
-      inject_xtra.partData_len = length - len_injected;
+    pthread_mutex_lock(&state->mutex);
+    acked_parts = state->acked;
+    pthread_mutex_unlock(&state->mutex);
+    if (acked_parts == total_parts) {
+      break;
     }
-    else
+
+    // XTRA injection starts with part 1
+    for (part = 1; part <= total_parts; part++)
     {
-      inject_xtra.partData_len = QMI_LOC_MAX_PREDICTED_ORBITS_PART_LEN_V02;
-    }
+      pthread_mutex_lock(&state->mutex);
+      if (!xtraInjectWaitInFlight(state, window - 1)) {
+        pthread_mutex_unlock(&state->mutex);
+        timed_out = true;
+        break;
+      }
+      bool acked = state->partAcked[part - 1];
+      if (!acked) {
+        // the reference is dropped by xtraInjectIndCb()
+        state->inFlight++;
+        state->refs++;
+      }
+      pthread_mutex_unlock(&state->mutex);
 
-    // copy data into the message
-    memcpy(inject_xtra.partData, data+len_injected, inject_xtra.partData_len);
+      if (acked) {
+        continue;
+      }
+      if (round > 0) {
+        retries++;
+      }
 
-    LOC_LOGD("[%s:%d] part %d/%d, len = %d, total injected = %d\n",
-                  __func__, __LINE__,
-                  inject_xtra.partNum, total_parts, inject_xtra.partData_len,
-                  len_injected);
+      offset = (uint32_t)(part - 1) * QMI_LOC_MAX_PREDICTED_ORBITS_PART_LEN_V02;
+      inject_xtra.partNum = part;
+      inject_xtra.partData_len = length - offset;
+      if (inject_xtra.partData_len > QMI_LOC_MAX_PREDICTED_ORBITS_PART_LEN_V02)
+      {
+        inject_xtra.partData_len = QMI_LOC_MAX_PREDICTED_ORBITS_PART_LEN_V02;
+      }
 
-    memset(&inject_xtra_ind, 0, sizeof(inject_xtra_ind));
-    status = loc_sync_send_req( clientHandle,
-                                QMI_LOC_INJECT_PREDICTED_ORBITS_DATA_REQ_V02,
-                                req_union, LOC_ENGINE_SYNC_REQUEST_TIMEOUT,
-                                QMI_LOC_INJECT_PREDICTED_ORBITS_DATA_IND_V02,
-                                &inject_xtra_ind);
+      // copy data into the message
+      memcpy(inject_xtra.partData, data + offset, inject_xtra.partData_len);
 
-    if (status != eLOC_CLIENT_SUCCESS ||
-        eQMI_LOC_SUCCESS_V02 != inject_xtra_ind.status ||
-        inject_xtra.partNum != inject_xtra_ind.partNum)
-    {
-      LOC_LOGE ("%s:%d]: failed status = %s, inject_pos_ind.status = %s,"
-                     " part num = %d, ind.partNum = %d\n", __func__, __LINE__,
-                loc_get_v02_client_status_name(status),
-                loc_get_v02_qmi_status_name(inject_xtra_ind.status),
-                inject_xtra.partNum, inject_xtra_ind.partNum);
-    } else {
-      len_injected += inject_xtra.partData_len;
-      LOC_LOGD("%s:%d]: XTRA injected length: %d\n", __func__, __LINE__,
-               len_injected);
+      LOC_LOGD("[%s:%d] part %d/%d, len = %d, offset = %d\n",
+                    __func__, __LINE__,
+                    inject_xtra.partNum, total_parts, inject_xtra.partData_len,
+                    offset);
+
+      // the request is encoded before this returns, so inject_xtra can be
+      // reused for the next part right away
+      status = loc_async_send_req(clientHandle,
+                                  QMI_LOC_INJECT_PREDICTED_ORBITS_DATA_REQ_V02,
+                                  req_union, LOC_ENGINE_SYNC_REQUEST_TIMEOUT,
+                                  QMI_LOC_INJECT_PREDICTED_ORBITS_DATA_IND_V02,
+                                  xtraInjectIndCb, state);
+
+      if (status != eLOC_CLIENT_SUCCESS)
+      {
+        LOC_LOGE ("%s:%d]: failed status = %s, part num = %d\n",
+                  __func__, __LINE__,
+                  loc_get_v02_client_status_name(status), part);
+        pthread_mutex_lock(&state->mutex);
+        state->inFlight--;
+        state->status = status;
+        pthread_mutex_unlock(&state->mutex);
+        xtraInjectStateRelease(state);
+      }
+    }
+
+    if (!timed_out) {
+      pthread_mutex_lock(&state->mutex);
+      timed_out = !xtraInjectWaitInFlight(state, 0);
+      pthread_mutex_unlock(&state->mutex);
     }
   }
 
+  pthread_mutex_lock(&state->mutex);
+  acked_parts = state->acked;
+  if (timed_out) {
+    status = eLOC_CLIENT_FAILURE_TIMEOUT;
+  } else if (acked_parts == total_parts) {
+    status = eLOC_CLIENT_SUCCESS;
+  } else if (eLOC_CLIENT_SUCCESS == (status = state->status)) {
+    status = eLOC_CLIENT_FAILURE_GENERAL;
+  }
+  pthread_mutex_unlock(&state->mutex);
+
+  // parts still in flight after a timeout keep the state alive until
+  // their callbacks run
+  xtraInjectStateRelease(state);
+
+  if (timed_out) {
+    LOC_LOGE("%s:%d]: XTRA parts not completed in %d ms, giving up\n",
+             __func__, __LINE__, XTRA_INJECT_WAIT_TIMEOUT);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  int64_t elapsedMs = (int64_t)(end.tv_sec - start.tv_sec) * 1000 +
+                      (end.tv_nsec - start.tv_nsec) / 1000000;
+  LOC_LOGI("%s:%d]: XTRA %d bytes, %d/%d parts injected, window %d, "
+           "%u retries, %lld ms, %lld KB/s\n", __func__, __LINE__,
+           length, acked_parts, total_parts, window, retries,
+           (long long)elapsedMs,
+           (long long)((elapsedMs > 0) ? (int64_t)length / elapsedMs : 0));
+
   return convertErr(status);
 }
 
@@ -2472,12 +2674,82 @@ void  LocApiV02 :: reportSv (
   }
 }
 
-/* convert satellite measurementreport to loc eng format and  send the converted
-   report to loc eng */
-void  LocApiV02 :: reportSvMeasurement (
-  const qmiLocEventGnssSvMeasInfoIndMsgT_v02 *gnss_raw_measurement_ptr)
+/* convert one satellite measurement from QMI LOC to loc eng format */
+void LocApiV02 :: convertSvMeasurement (Gnss_SVMeasurementStructType& svMeasurement,
+    const qmiLocSVMeasurementStructT_v02& qmiSvMeasurement)
+{
+  svMeasurement.size         = sizeof(Gnss_SVMeasurementStructType);
+  svMeasurement.gnssSvId     = qmiSvMeasurement.gnssSvId;
+  svMeasurement.gloFrequency = qmiSvMeasurement.gloFrequency;
+
+  if(qmiSvMeasurement.validMask & QMI_LOC_SV_LOSSOFLOCK_VALID_V02)
+  {
+    svMeasurement.lossOfLock = (bool)qmiSvMeasurement.lossOfLock;
+  }
+
+  svMeasurement.svStatus = (Gnss_LocSvSearchStatusEnumT)qmiSvMeasurement.svStatus;
+
+  if(qmiSvMeasurement.validMask & QMI_LOC_SV_HEALTH_VALID_V02)
+  {
+    svMeasurement.healthStatus_valid = 1;
+    svMeasurement.healthStatus = (uint8_t)qmiSvMeasurement.healthStatus;
+  }
+  svMeasurement.svInfoMask  = (Gnss_LocSvInfoMaskT)qmiSvMeasurement.svInfoMask;
+  svMeasurement.CNo         = qmiSvMeasurement.CNo;
+  svMeasurement.gloRfLoss   = qmiSvMeasurement.gloRfLoss;
+  svMeasurement.measLatency = qmiSvMeasurement.measLatency;
+
+  /*SVTimeSpeed*/
+  svMeasurement.svTimeSpeed.size            = sizeof(Gnss_LocSVTimeSpeedStructType);
+  svMeasurement.svTimeSpeed.svMs            = qmiSvMeasurement.svTimeSpeed.svTimeMs;
+  svMeasurement.svTimeSpeed.svSubMs         = qmiSvMeasurement.svTimeSpeed.svTimeSubMs;
+  svMeasurement.svTimeSpeed.svTimeUncMs     = qmiSvMeasurement.svTimeSpeed.svTimeUncMs;
+  svMeasurement.svTimeSpeed.dopplerShift    = qmiSvMeasurement.svTimeSpeed.dopplerShift;
+  svMeasurement.svTimeSpeed.dopplerShiftUnc = qmiSvMeasurement.svTimeSpeed.dopplerShiftUnc;
+
+  svMeasurement.measurementStatus = (uint32_t)qmiSvMeasurement.measurementStatus;
+
+  if(qmiSvMeasurement.validMask & QMI_LOC_SV_MULTIPATH_EST_VALID_V02)
+  {
+    svMeasurement.multipathEstValid = 1;
+    svMeasurement.multipathEstimate = qmiSvMeasurement.multipathEstimate;
+  }
+  if(qmiSvMeasurement.validMask & QMI_LOC_SV_FINE_SPEED_VALID_V02)
+  {
+    svMeasurement.fineSpeedValid = 1;
+    svMeasurement.fineSpeed      = qmiSvMeasurement.fineSpeed;
+  }
+  if(qmiSvMeasurement.validMask & QMI_LOC_SV_FINE_SPEED_UNC_VALID_V02)
+  {
+    svMeasurement.fineSpeedUncValid = 1;
+    svMeasurement.fineSpeedUnc      = qmiSvMeasurement.fineSpeedUnc;
+  }
+  if(qmiSvMeasurement.validMask & QMI_LOC_SV_CARRIER_PHASE_VALID_V02)
+  {
+    svMeasurement.carrierPhaseValid = 1;
+    svMeasurement.carrierPhase      = qmiSvMeasurement.carrierPhase;
+  }
+  if(qmiSvMeasurement.validMask & QMI_LOC_SV_SV_DIRECTION_VALID_V02)
+  {
+    svMeasurement.svDirectionValid = 1;
+    svMeasurement.svElevation      = qmiSvMeasurement.svElevation;
+    svMeasurement.svAzimuth        = qmiSvMeasurement.svAzimuth;
+  }
+  if(qmiSvMeasurement.validMask & QMI_LOC_SV_CYCLESLIP_COUNT_VALID_V02)
+  {
+    svMeasurement.cycleSlipCountValid = 1;
+    svMeasurement.cycleSlipCount      = qmiSvMeasurement.cycleSlipCount;
+  }
+}
+
+/* convert a GNSS measurement report to both the SV measurement set and the
+   GnssData measurements in a single pass over the SV list. Returns true if
+   gnssMeasurementData was filled, i.e. the report carries GPS measurements */
+bool LocApiV02 :: convertGnssMeasurementReport (
+  const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_raw_measurement,
+  GnssSvMeasurementSet& svMeasurementSet,
+  GnssData& gnssMeasurementData)
 {
-  GnssSvMeasurementSet                 svMeasurementSet;
   memset(&svMeasurementSet, 0, sizeof(GnssSvMeasurementSet));
   svMeasurementSet.size = sizeof(svMeasurementSet);
 
@@ -2495,289 +2767,239 @@ void  LocApiV02 :: reportSvMeasurement (
             svMeasurementSet.timeStamp.apTimeStamp.tv_nsec);
 
   LOC_LOGI("[SvMeas] SeqNum: %d, MaxMsgNum: %d, MeasValid: %d, #of SV: %d\n",
-           gnss_raw_measurement_ptr->seqNum,
-           gnss_raw_measurement_ptr->maxMessageNum,
-           gnss_raw_measurement_ptr->svMeasurement_valid,
-           (gnss_raw_measurement_ptr->svMeasurement_valid)?
-           gnss_raw_measurement_ptr->svMeasurement_len : 0);
+           gnss_raw_measurement.seqNum,
+           gnss_raw_measurement.maxMessageNum,
+           gnss_raw_measurement.svMeasurement_valid,
+           (gnss_raw_measurement.svMeasurement_valid)?
+           gnss_raw_measurement.svMeasurement_len : 0);
 
-  svMeasurementSet.seqNum           = gnss_raw_measurement_ptr->seqNum;
-  svMeasurementSet.maxMessageNum    = gnss_raw_measurement_ptr->maxMessageNum;
+  svMeasurementSet.seqNum           = gnss_raw_measurement.seqNum;
+  svMeasurementSet.maxMessageNum    = gnss_raw_measurement.maxMessageNum;
 
-  if(1 == gnss_raw_measurement_ptr->rcvrClockFrequencyInfo_valid)
+  if(1 == gnss_raw_measurement.rcvrClockFrequencyInfo_valid)
   {
     qmiLocRcvrClockFrequencyInfoStructT_v02* rcvClockFreqInfo =
-      (qmiLocRcvrClockFrequencyInfoStructT_v02*) &gnss_raw_measurement_ptr->rcvrClockFrequencyInfo;
+      (qmiLocRcvrClockFrequencyInfoStructT_v02*) &gnss_raw_measurement.rcvrClockFrequencyInfo;
 
     svMeasurementSet.clockFreq.size         = sizeof(Gnss_LocRcvrClockFrequencyInfoStructType);
-    svMeasurementSet.clockFreqValid         = gnss_raw_measurement_ptr->rcvrClockFrequencyInfo_valid;
+    svMeasurementSet.clockFreqValid         = gnss_raw_measurement.rcvrClockFrequencyInfo_valid;
     svMeasurementSet.clockFreq.clockDrift   =
-        gnss_raw_measurement_ptr->rcvrClockFrequencyInfo.clockDrift;
+        gnss_raw_measurement.rcvrClockFrequencyInfo.clockDrift;
     svMeasurementSet.clockFreq.clockDriftUnc =
-        gnss_raw_measurement_ptr->rcvrClockFrequencyInfo.clockDriftUnc;
+        gnss_raw_measurement.rcvrClockFrequencyInfo.clockDriftUnc;
     svMeasurementSet.clockFreq.sourceOfFreq = (Gnss_LocSourceofFreqEnumType)
-        gnss_raw_measurement_ptr->rcvrClockFrequencyInfo.sourceOfFreq;
+        gnss_raw_measurement.rcvrClockFrequencyInfo.sourceOfFreq;
 
     LOC_LOGV("FreqInfo:: Drift: %f, DriftUnc: %f",
              svMeasurementSet.clockFreq.clockDrift,
              svMeasurementSet.clockFreq.clockDriftUnc);
   }
 
-  if((1 == gnss_raw_measurement_ptr->leapSecondInfo_valid) &&
-     (0 == gnss_raw_measurement_ptr->leapSecondInfo.leapSecUnc) )
+  if((1 == gnss_raw_measurement.leapSecondInfo_valid) &&
+     (0 == gnss_raw_measurement.leapSecondInfo.leapSecUnc) )
   {
     qmiLocLeapSecondInfoStructT_v02* leapSecond =
-      (qmiLocLeapSecondInfoStructT_v02*)&gnss_raw_measurement_ptr->leapSecondInfo;
+      (qmiLocLeapSecondInfoStructT_v02*)&gnss_raw_measurement.leapSecondInfo;
 
     svMeasurementSet.leapSec.size       = sizeof(Gnss_LeapSecondInfoStructType);
-    svMeasurementSet.leapSecValid       = (bool)gnss_raw_measurement_ptr->leapSecondInfo_valid;
-    svMeasurementSet.leapSec.leapSec    = gnss_raw_measurement_ptr->leapSecondInfo.leapSec;
-    svMeasurementSet.leapSec.leapSecUnc = gnss_raw_measurement_ptr->leapSecondInfo.leapSecUnc;
+    svMeasurementSet.leapSecValid       = (bool)gnss_raw_measurement.leapSecondInfo_valid;
+    svMeasurementSet.leapSec.leapSec    = gnss_raw_measurement.leapSecondInfo.leapSec;
+    svMeasurementSet.leapSec.leapSecUnc = gnss_raw_measurement.leapSecondInfo.leapSecUnc;
     LOC_LOGV("leapSecondInfo:: leapSec: %d, leapSecUnc: %d",
       svMeasurementSet.leapSec.leapSec, svMeasurementSet.leapSec.leapSecUnc);
   }
 
-  if(1 == gnss_raw_measurement_ptr->gpsGloInterSystemBias_valid)
+  if(1 == gnss_raw_measurement.gpsGloInterSystemBias_valid)
   {
     qmiLocInterSystemBiasStructT_v02* interSystemBias =
-      (qmiLocInterSystemBiasStructT_v02*)&gnss_raw_measurement_ptr->gpsGloInterSystemBias;
+      (qmiLocInterSystemBiasStructT_v02*)&gnss_raw_measurement.gpsGloInterSystemBias;
 
     getInterSystemTimeBias("gpsGloInterSystemBias",
                            svMeasurementSet.gpsGloInterSystemBias, interSystemBias);
   }
 
-  if(1 == gnss_raw_measurement_ptr->gpsBdsInterSystemBias_valid)
+  if(1 == gnss_raw_measurement.gpsBdsInterSystemBias_valid)
   {
     qmiLocInterSystemBiasStructT_v02* interSystemBias =
-      (qmiLocInterSystemBiasStructT_v02*)&gnss_raw_measurement_ptr->gpsBdsInterSystemBias;
+      (qmiLocInterSystemBiasStructT_v02*)&gnss_raw_measurement.gpsBdsInterSystemBias;
 
     getInterSystemTimeBias("gpsBdsInterSystemBias",
                            svMeasurementSet.gpsBdsInterSystemBias, interSystemBias);
   }
 
-  if(1 == gnss_raw_measurement_ptr->gpsGalInterSystemBias_valid)
+  if(1 == gnss_raw_measurement.gpsGalInterSystemBias_valid)
   {
     qmiLocInterSystemBiasStructT_v02* interSystemBias =
-      (qmiLocInterSystemBiasStructT_v02*)&gnss_raw_measurement_ptr->gpsGalInterSystemBias;
+      (qmiLocInterSystemBiasStructT_v02*)&gnss_raw_measurement.gpsGalInterSystemBias;
 
     getInterSystemTimeBias("gpsGalInterSystemBias",
                            svMeasurementSet.gpsGalInterSystemBias, interSystemBias);
   }
 
-  if(1 == gnss_raw_measurement_ptr->bdsGloInterSystemBias_valid)
+  if(1 == gnss_raw_measurement.bdsGloInterSystemBias_valid)
   {
     qmiLocInterSystemBiasStructT_v02* interSystemBias =
-      (qmiLocInterSystemBiasStructT_v02*)&gnss_raw_measurement_ptr->bdsGloInterSystemBias;
+      (qmiLocInterSystemBiasStructT_v02*)&gnss_raw_measurement.bdsGloInterSystemBias;
 
     getInterSystemTimeBias("bdsGloInterSystemBias",
                            svMeasurementSet.bdsGloInterSystemBias, interSystemBias);
   }
 
-  if(1 == gnss_raw_measurement_ptr->galGloInterSystemBias_valid)
+  if(1 == gnss_raw_measurement.galGloInterSystemBias_valid)
   {
     qmiLocInterSystemBiasStructT_v02* interSystemBias =
-      (qmiLocInterSystemBiasStructT_v02*)&gnss_raw_measurement_ptr->galGloInterSystemBias;
+      (qmiLocInterSystemBiasStructT_v02*)&gnss_raw_measurement.galGloInterSystemBias;
 
     getInterSystemTimeBias("galGloInterSystemBias",
                            svMeasurementSet.galGloInterSystemBias, interSystemBias);
   }
 
-  if(1 == gnss_raw_measurement_ptr->galBdsInterSystemBias_valid)
+  if(1 == gnss_raw_measurement.galBdsInterSystemBias_valid)
   {
     qmiLocInterSystemBiasStructT_v02* interSystemBias =
-      (qmiLocInterSystemBiasStructT_v02*)&gnss_raw_measurement_ptr->galBdsInterSystemBias;
+      (qmiLocInterSystemBiasStructT_v02*)&gnss_raw_measurement.galBdsInterSystemBias;
 
     getInterSystemTimeBias("galBdsInterSystemBias",
                            svMeasurementSet.galBdsInterSystemBias,interSystemBias);
   }
 
   svMeasurementSet.gnssMeas.size  = sizeof(Gnss_SVMeasurementStructType);
-  svMeasurementSet.gnssMeas.system  = (Gnss_LocSvSystemEnumType)gnss_raw_measurement_ptr->system;
+  svMeasurementSet.gnssMeas.system  = (Gnss_LocSvSystemEnumType)gnss_raw_measurement.system;
 
-  if(1 == gnss_raw_measurement_ptr->systemTime_valid)
+  if(1 == gnss_raw_measurement.systemTime_valid)
   {
-    svMeasurementSet.gnssMeas.isSystemTimeValid = gnss_raw_measurement_ptr->systemTime_valid;
+    svMeasurementSet.gnssMeas.isSystemTimeValid = gnss_raw_measurement.systemTime_valid;
     svMeasurementSet.gnssMeas.systemTime.size        = sizeof(Gnss_LocSystemTimeStructType);
 
     svMeasurementSet.gnssMeas.systemTime.systemWeek  =
-        gnss_raw_measurement_ptr->systemTime.systemWeek;
+        gnss_raw_measurement.systemTime.systemWeek;
 
     svMeasurementSet.gnssMeas.systemTime.systemMsec  =
-        gnss_raw_measurement_ptr->systemTime.systemMsec;
+        gnss_raw_measurement.systemTime.systemMsec;
 
     svMeasurementSet.gnssMeas.systemTime.systemClkTimeBias  =
-        gnss_raw_measurement_ptr->systemTime.systemClkTimeBias;
+        gnss_raw_measurement.systemTime.systemClkTimeBias;
 
     svMeasurementSet.gnssMeas.systemTime.systemClkTimeUncMs =
-        gnss_raw_measurement_ptr->systemTime.systemClkTimeUncMs;
+        gnss_raw_measurement.systemTime.systemClkTimeUncMs;
   }
 
-  if(1 == gnss_raw_measurement_ptr->gloTime_valid)
+  if(1 == gnss_raw_measurement.gloTime_valid)
   {
-    svMeasurementSet.gnssMeas.isGloTime_valid     = gnss_raw_measurement_ptr->gloTime_valid;
+    svMeasurementSet.gnssMeas.isGloTime_valid     = gnss_raw_measurement.gloTime_valid;
     svMeasurementSet.gnssMeas.gloTime.size        = sizeof(Gnss_LocGloTimeStructType);
 
-    svMeasurementSet.gnssMeas.gloTime.gloDays     = gnss_raw_measurement_ptr->gloTime.gloDays;
-    svMeasurementSet.gnssMeas.gloTime.gloFourYear = gnss_raw_measurement_ptr->gloTime.gloFourYear;
-    svMeasurementSet.gnssMeas.gloTime.gloMsec     = gnss_raw_measurement_ptr->gloTime.gloMsec;
-    svMeasurementSet.gnssMeas.gloTime.gloClkTimeBias    = gnss_raw_measurement_ptr->gloTime.gloClkTimeBias;
-    svMeasurementSet.gnssMeas.gloTime.gloClkTimeUncMs   = gnss_raw_measurement_ptr->gloTime.gloClkTimeUncMs;
+    svMeasurementSet.gnssMeas.gloTime.gloDays     = gnss_raw_measurement.gloTime.gloDays;
+    svMeasurementSet.gnssMeas.gloTime.gloFourYear = gnss_raw_measurement.gloTime.gloFourYear;
+    svMeasurementSet.gnssMeas.gloTime.gloMsec     = gnss_raw_measurement.gloTime.gloMsec;
+    svMeasurementSet.gnssMeas.gloTime.gloClkTimeBias    = gnss_raw_measurement.gloTime.gloClkTimeBias;
+    svMeasurementSet.gnssMeas.gloTime.gloClkTimeUncMs   = gnss_raw_measurement.gloTime.gloClkTimeUncMs;
   }
 
-  if(1 == gnss_raw_measurement_ptr->systemTimeExt_valid)
+  if(1 == gnss_raw_measurement.systemTimeExt_valid)
   {
-    svMeasurementSet.gnssMeas.isSystemTimeExt_valid  = gnss_raw_measurement_ptr->systemTimeExt_valid;
+    svMeasurementSet.gnssMeas.isSystemTimeExt_valid  = gnss_raw_measurement.systemTimeExt_valid;
     svMeasurementSet.gnssMeas.systemTimeExt.size     = sizeof(Gnss_LocGnssTimeExtStructType);
 
-    svMeasurementSet.gnssMeas.systemTimeExt.refFCount   = gnss_raw_measurement_ptr->systemTimeExt.refFCount;
+    svMeasurementSet.gnssMeas.systemTimeExt.refFCount   = gnss_raw_measurement.systemTimeExt.refFCount;
 
     svMeasurementSet.gnssMeas.systemTimeExt.systemRtc_valid  =
-      gnss_raw_measurement_ptr->systemTimeExt.systemRtc_valid;
+      gnss_raw_measurement.systemTimeExt.systemRtc_valid;
 
     svMeasurementSet.gnssMeas.systemTimeExt.systemRtcMs =
-      gnss_raw_measurement_ptr->systemTimeExt.systemRtcMs;
+      gnss_raw_measurement.systemTimeExt.systemRtcMs;
 
     svMeasurementSet.gnssMeas.systemTimeExt.sourceOfTime  =
-      gnss_raw_measurement_ptr->systemTimeExt.sourceOfTime;
+      gnss_raw_measurement.systemTimeExt.sourceOfTime;
 
   }
 
 
-  if(1 == gnss_raw_measurement_ptr->svMeasurement_valid)
-  {
+  bool isGps = (eQMI_LOC_SV_SYSTEM_GPS_V02 == gnss_raw_measurement.system);
+  uint32_t svMeasurement_len = 0;
 
-    svMeasurementSet.gnssMeas.numSvs = gnss_raw_measurement_ptr->svMeasurement_len;
-    svMeasurementSet.gnssMeasValid   = gnss_raw_measurement_ptr->svMeasurement_valid;
+  // GnssData is only reported for GPS, skip clearing it for other systems
+  if(isGps)
+  {
+    memset(&gnssMeasurementData, 0, sizeof(GnssData));
+    gnssMeasurementData.size = sizeof(GnssData);
+  }
 
-    if(gnss_raw_measurement_ptr->svMeasurement_len > GNSS_LOC_SV_MEAS_LIST_MAX_SIZE)
+  if(1 == gnss_raw_measurement.svMeasurement_valid)
+  {
+    svMeasurement_len = gnss_raw_measurement.svMeasurement_len;
+    if(svMeasurement_len > GNSS_LOC_SV_MEAS_LIST_MAX_SIZE)
     {
       //This should not happen normally, anycase limit to Max List Size
-      svMeasurementSet.gnssMeas.numSvs = GNSS_LOC_SV_MEAS_LIST_MAX_SIZE;
+      svMeasurement_len = GNSS_LOC_SV_MEAS_LIST_MAX_SIZE;
+    }
+    svMeasurementSet.gnssMeasValid = gnss_raw_measurement.svMeasurement_valid;
+    if(isGps)
+    {
+      gnssMeasurementData.measurement_count = svMeasurement_len;
     }
-    svMeasurementSet.gnssMeas.numSvs = gnss_raw_measurement_ptr->svMeasurement_len;
-    svMeasurementSet.gnssMeasValid   = gnss_raw_measurement_ptr->svMeasurement_valid;
 
-    uint32_t i = 0, cnt=0;
-    for(i=0;i<gnss_raw_measurement_ptr->svMeasurement_len;i++)
+    uint32_t i = 0, cnt = 0;
+    for(i = 0; i < svMeasurement_len; i++)
     {
-      svMeasurementSet.gnssMeas.svMeasurement[i].size = sizeof(Gnss_SVMeasurementStructType);
+      const qmiLocSVMeasurementStructT_v02& qmiSvMeasurement =
+        gnss_raw_measurement.svMeasurement[i];
 
-      if((0 != gnss_raw_measurement_ptr->svMeasurement[i].gnssSvId) &&
-         (0 != gnss_raw_measurement_ptr->svMeasurement[i].measurementStatus))
+      if(isGps)
       {
-        svMeasurementSet.gnssMeas.svMeasurement[i].gnssSvId =
-                 gnss_raw_measurement_ptr->svMeasurement[i].gnssSvId;
-
-        svMeasurementSet.gnssMeas.svMeasurement[i].gloFrequency =
-                 gnss_raw_measurement_ptr->svMeasurement[i].gloFrequency;
-
-        if(gnss_raw_measurement_ptr->svMeasurement[i].validMask & QMI_LOC_SV_LOSSOFLOCK_VALID_V02)
-        {
-          svMeasurementSet.gnssMeas.svMeasurement[i].lossOfLock = (bool)
-                 gnss_raw_measurement_ptr->svMeasurement[i].lossOfLock;
-        }
-
-        svMeasurementSet.gnssMeas.svMeasurement[i].svStatus = (Gnss_LocSvSearchStatusEnumT)
-                         gnss_raw_measurement_ptr->svMeasurement[i].svStatus;
-
-        if(gnss_raw_measurement_ptr->svMeasurement[i].validMask & QMI_LOC_SV_HEALTH_VALID_V02)
-        {
-          svMeasurementSet.gnssMeas.svMeasurement[i].healthStatus_valid = 1;
-          svMeasurementSet.gnssMeas.svMeasurement[i].healthStatus = (uint8_t)gnss_raw_measurement_ptr->svMeasurement[i].healthStatus;
-        }
-        svMeasurementSet.gnssMeas.svMeasurement[i].svInfoMask = (Gnss_LocSvInfoMaskT)
-                 gnss_raw_measurement_ptr->svMeasurement[i].svInfoMask;
-
-        svMeasurementSet.gnssMeas.svMeasurement[i].CNo =
-                 gnss_raw_measurement_ptr->svMeasurement[i].CNo;
-
-        svMeasurementSet.gnssMeas.svMeasurement[i].gloRfLoss =
-                 gnss_raw_measurement_ptr->svMeasurement[i].gloRfLoss;
-
-        svMeasurementSet.gnssMeas.svMeasurement[i].measLatency =
-                 gnss_raw_measurement_ptr->svMeasurement[i].measLatency;
-
-        /*SVTimeSpeed*/
-        svMeasurementSet.gnssMeas.svMeasurement[i].svTimeSpeed.size = sizeof(Gnss_LocSVTimeSpeedStructType);
-        svMeasurementSet.gnssMeas.svMeasurement[i].svTimeSpeed.svMs =
-                 gnss_raw_measurement_ptr->svMeasurement[i].svTimeSpeed.svTimeMs;
-        svMeasurementSet.gnssMeas.svMeasurement[i].svTimeSpeed.svSubMs =
-                 gnss_raw_measurement_ptr->svMeasurement[i].svTimeSpeed.svTimeSubMs;
-        svMeasurementSet.gnssMeas.svMeasurement[i].svTimeSpeed.svTimeUncMs =
-                 gnss_raw_measurement_ptr->svMeasurement[i].svTimeSpeed.svTimeUncMs;
-        svMeasurementSet.gnssMeas.svMeasurement[i].svTimeSpeed.dopplerShift =
-                 gnss_raw_measurement_ptr->svMeasurement[i].svTimeSpeed.dopplerShift;
-        svMeasurementSet.gnssMeas.svMeasurement[i].svTimeSpeed.dopplerShiftUnc=
-                 gnss_raw_measurement_ptr->svMeasurement[i].svTimeSpeed.dopplerShiftUnc;
-
-        svMeasurementSet.gnssMeas.svMeasurement[i].measurementStatus =
-                 (uint32_t)gnss_raw_measurement_ptr->svMeasurement[i].measurementStatus;
-
-        if(gnss_raw_measurement_ptr->svMeasurement[i].validMask & QMI_LOC_SV_MULTIPATH_EST_VALID_V02)
-        {
-          svMeasurementSet.gnssMeas.svMeasurement[i].multipathEstValid = 1;
-          svMeasurementSet.gnssMeas.svMeasurement[i].multipathEstimate =
-            gnss_raw_measurement_ptr->svMeasurement[i].multipathEstimate;
-        }
-
-        if(gnss_raw_measurement_ptr->svMeasurement[i].validMask & QMI_LOC_SV_FINE_SPEED_VALID_V02)
-        {
-          svMeasurementSet.gnssMeas.svMeasurement[i].fineSpeedValid = 1;
-
-          svMeasurementSet.gnssMeas.svMeasurement[i].fineSpeed  =
-            gnss_raw_measurement_ptr->svMeasurement[i].fineSpeed;
-        }
-        if(gnss_raw_measurement_ptr->svMeasurement[i].validMask & QMI_LOC_SV_FINE_SPEED_UNC_VALID_V02)
-        {
-           svMeasurementSet.gnssMeas.svMeasurement[i].fineSpeedUncValid = 1;
-
-          svMeasurementSet.gnssMeas.svMeasurement[i].fineSpeedUnc =
-            gnss_raw_measurement_ptr->svMeasurement[i].fineSpeedUnc;
-        }
-        if(gnss_raw_measurement_ptr->svMeasurement[i].validMask & QMI_LOC_SV_CARRIER_PHASE_VALID_V02)
-        {
-          svMeasurementSet.gnssMeas.svMeasurement[i].carrierPhaseValid = 1;
-
-          svMeasurementSet.gnssMeas.svMeasurement[i].carrierPhase =
-            gnss_raw_measurement_ptr->svMeasurement[i].carrierPhase;
-        }
-        if(gnss_raw_measurement_ptr->svMeasurement[i].validMask & QMI_LOC_SV_SV_DIRECTION_VALID_V02)
-        {
-          svMeasurementSet.gnssMeas.svMeasurement[i].svDirectionValid = 1;
-
-          svMeasurementSet.gnssMeas.svMeasurement[i].svElevation =
-            gnss_raw_measurement_ptr->svMeasurement[i].svElevation;
-          svMeasurementSet.gnssMeas.svMeasurement[i].svAzimuth =
-            gnss_raw_measurement_ptr->svMeasurement[i].svAzimuth;
-        }
-        if(gnss_raw_measurement_ptr->svMeasurement[i].validMask & QMI_LOC_SV_CYCLESLIP_COUNT_VALID_V02)
-        {
-          svMeasurementSet.gnssMeas.svMeasurement[i].cycleSlipCountValid = 1;
-          svMeasurementSet.gnssMeas.svMeasurement[i].cycleSlipCount =
-            gnss_raw_measurement_ptr->svMeasurement[i].cycleSlipCount;
-        }
+        convertGnssMeasurements(gnssMeasurementData.measurements[i],
+                                qmiSvMeasurement);
+      }
 
+      if((0 != qmiSvMeasurement.gnssSvId) &&
+         (0 != qmiSvMeasurement.measurementStatus))
+      {
+        convertSvMeasurement(svMeasurementSet.gnssMeas.svMeasurement[cnt],
+                             qmiSvMeasurement);
         cnt++;
-
       }
-
-      svMeasurementSet.gnssMeas.numSvs = cnt;   /*set the measurement length to the actual SVId's filled in the array*/
-
     }
+    /*set the measurement length to the actual SVId's filled in the array*/
+    svMeasurementSet.gnssMeas.numSvs = cnt;
 
-    if(gnss_raw_measurement_ptr->svMeasurement_len != cnt)
+    if(gnss_raw_measurement.svMeasurement_len != cnt)
     {
       LOC_LOGW("[SV_MEAS_QMI] #of SV in QMI: %d, Valid SV-id Count: %d",
-                 gnss_raw_measurement_ptr->svMeasurement_len,cnt );
+                 gnss_raw_measurement.svMeasurement_len,cnt );
     }
-
-  } //if svClockMeasurement_valid
+  }
   else
   {
     LOC_LOGV("%s] [SV_MEAS] SV Measurement Not Valid", __func__);
   }
+
+  if(0 == svMeasurement_len || !isGps)
+  {
+    LOC_LOGV ("%s:%d]: There is no GNSS measurement.\n",
+              __func__, __LINE__);
+    return false;
+  }
+
+  // the GPS clock time reading, converted once per report
+  convertGnssClock(gnssMeasurementData.clock, gnss_raw_measurement);
+  return true;
+}
+
+/* convert a GNSS measurement report and send the SV measurement set and
+   GnssData measurements to loc eng together */
+void  LocApiV02 :: reportGnssMeasurement (
+  const qmiLocEventGnssSvMeasInfoIndMsgT_v02 *gnss_raw_measurement_ptr)
+{
+  GnssSvMeasurementSet svMeasurementSet;
+  GnssData gnssMeasurementData;
+
+  bool hasGnssData = convertGnssMeasurementReport(*gnss_raw_measurement_ptr,
+                                                  svMeasurementSet,
+                                                  gnssMeasurementData);
+
   //Report SV measurement irrespective of #of SVs for APDR
-  LocApiBase::reportSvMeasurement(svMeasurementSet);
+  LocApiBase::reportGnssMeasurement(svMeasurementSet,
+                                    hasGnssData ? &gnssMeasurementData : NULL);
 }
 
 /* convert satellite polynomial to loc eng format and  send the converted
@@ -3315,58 +3537,6 @@ bool LocApiV02 :: convertNiNotifyVerifyType (
    return true;
 }
 
-/* convert and report GNSS measurement data to loc eng */
-void LocApiV02 :: reportGnssMeasurementData(
-  const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_measurement_report_ptr)
-{
-    LOC_LOGV ("%s:%d]: entering\n", __func__, __LINE__);
-
-    GnssData gnssMeasurementData;
-    memset (&gnssMeasurementData, 0, sizeof(GnssData));
-
-    int svMeasurment_len = 0;
-
-    // size
-    gnssMeasurementData.size = sizeof(GnssData);
-
-    // number of measurements
-    if (gnss_measurement_report_ptr.svMeasurement_valid) {
-        svMeasurment_len =
-            gnss_measurement_report_ptr.svMeasurement_len;
-        gnssMeasurementData.measurement_count = svMeasurment_len;
-        LOC_LOGV ("%s:%d]: there are %d SV measurements\n",
-                  __func__, __LINE__, svMeasurment_len);
-    } else {
-        LOC_LOGV ("%s:%d]: there is no valid SV measurements\n",
-                  __func__, __LINE__);
-    }
-
-    if (svMeasurment_len != 0 &&
-        gnss_measurement_report_ptr.system == eQMI_LOC_SV_SYSTEM_GPS_V02) {
-
-        // the array of measurements
-        int index = 0;
-        while(svMeasurment_len > 0) {
-            convertGnssMeasurements(gnssMeasurementData.measurements[index],
-                                   gnss_measurement_report_ptr.svMeasurement[index]);
-            index++;
-            svMeasurment_len--;
-        }
-
-        // the GPS clock time reading
-        convertGnssClock(gnssMeasurementData.clock,
-                        gnss_measurement_report_ptr);
-
-        // calling the base
-        LOC_LOGV ("%s:%d]: calling LocApiBase::reportGnssMeasurementData.\n",
-                  __func__, __LINE__);
-        LocApiBase::reportGnssMeasurementData(gnssMeasurementData);
-    } else {
-        LOC_LOGV ("%s:%d]: There is no GNSS measurement.\n",
-                  __func__, __LINE__);
-    }
-}
-
 /*convert GnssMeasurement type from QMI LOC to loc eng format*/
 void LocApiV02 :: convertGnssMeasurements (GnssMeasurement& gnssMeasurement,
     const qmiLocSVMeasurementStructT_v02& gnss_measurement_info)
@@ -3689,8 +3859,7 @@ void LocApiV02 :: eventCb(locClientHandleType clientHandle,
     case QMI_LOC_EVENT_GNSS_MEASUREMENT_REPORT_IND_V02:
       LOC_LOGD("%s:%d]: GNSS Measurement Report\n", __func__,
                __LINE__);
-      reportSvMeasurement(eventPayload.pGnssSvRawInfoEvent);
-      reportGnssMeasurementData(*eventPayload.pGnssSvRawInfoEvent); /*TBD merge into one function*/
+      reportGnssMeasurement(eventPayload.pGnssSvRawInfoEvent);
       break;
 
     case QMI_LOC_EVENT_SV_POLYNOMIAL_REPORT_IND_V02:
@@ -86,6 +86,10 @@ private:
   static void convertGnssMeasurements (GnssMeasurement& gnssMeasurement,
       const qmiLocSVMeasurementStructT_v02& gnss_measurement_info);
 
+  /* convert one satellite measurement from QMI LOC to loc eng format */
+  static void convertSvMeasurement (Gnss_SVMeasurementStructType& svMeasurement,
+      const qmiLocSVMeasurementStructT_v02& qmiSvMeasurement);
+
   /*convert GnssClock type from QMI LOC to loc eng format*/
   void convertGnssClock (GnssClock& gnssClock,
       const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_measurement_info);
@@ -104,7 +108,9 @@ private:
      report to loc eng */
   void reportSv (const qmiLocEventGnssSvInfoIndMsgT_v02 *gnss_report_ptr);
 
-  void reportSvMeasurement (
+  /* convert a GNSS measurement report and send the SV measurement set and
+     GnssData measurements to loc eng together */
+  void reportGnssMeasurement (
   const qmiLocEventGnssSvMeasInfoIndMsgT_v02 *gnss_raw_measurement_ptr);
 
   void  reportSvPolynomial (
@@ -137,14 +143,17 @@ private:
   void reportXtraServerUrl(
     const qmiLocEventInjectPredictedOrbitsReqIndMsgT_v02* server_request_ptr);
 
-  /* convert and report GNSS measurement data to loc eng */
-  void reportGnssMeasurementData(
-    const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_measurement_report_ptr);
-
   bool registerEventMask(locClientEventMaskType qmiMask);
   locClientEventMaskType adjustMaskForNoSession(locClientEventMaskType qmiMask);
   void cacheGnssMeasurementSupport();
 
+  /* convert a GNSS measurement report to both the SV measurement set and
+     the GnssData measurements in one pass; true if GnssData was filled */
+  bool convertGnssMeasurementReport (
+    const qmiLocEventGnssSvMeasInfoIndMsgT_v02& gnss_raw_measurement,
+    GnssSvMeasurementSet& svMeasurementSet,
+    GnssData& gnssMeasurementData);
+
 protected:
   virtual enum loc_api_adapter_err
     open(LOC_API_ADAPTER_EVENT_MASK_T mask);
@@ -26,13 +26,17 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <errno.h>
-#include <sys/time.h>
+#include <time.h>
 #include <string.h>
 #include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 #include <loc_cfg.h>
 #include "loc_api_v02_client.h"
 #include "loc_api_sync_req.h"
@@ -46,41 +50,76 @@
 #define LOG_TAG "LocSvc_api_v02"
 #include "loc_util_log.h"
 
-#define LOC_SYNC_REQ_BUFFER_SIZE 8
 #define GPS_CONF_FILE "/etc/gps.conf"
-pthread_mutex_t  loc_sync_call_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-static bool loc_sync_call_initialized = false;
+/* Waiters are kept in a hash keyed by (client handle, ind id), one lock
+   per stripe, so an indication only takes the lock of its own stripe and
+   looks at the few waiters that hash there. Must be a power of 2. */
+#define LOC_SYNC_REQ_STRIPES 16
 
-typedef struct {
-   pthread_mutex_t         sync_req_lock;
+/* Number of retries of locClientSendReq on a transient failure */
+#define LOC_SYNC_REQ_SEND_RETRIES 5
 
-   /* Client ID */
-   locClientHandleType     client_handle;
+typedef struct loc_sync_waiter_s {
+   /* stripe list; pprev is NULL once the waiter has been claimed */
+   struct loc_sync_waiter_s  *next;
+   struct loc_sync_waiter_s  **pprev;
 
-   /*  waiting conditional variable */
-   pthread_cond_t          ind_arrived_cond;
+   locClientHandleType       client_handle;
+   uint32_t                  ind_id;       /* ind to wait for */
+   uint32_t                  req_id;       /* sync request */
 
-   /* Callback waiting data block, protected by loc_cb_data_mutex */
-   bool                    ind_is_selected;              /* is cb selected? */
-   bool                    ind_is_waiting;               /* is waiting?     */
-   bool                    ind_has_arrived;              /* callback has arrived */
-   uint32_t                req_id;                    /*  sync request */
-   void                    *recv_ind_payload_ptr; /* received  payload */
-   uint32_t                recv_ind_id;      /* received  ind   */
+   /* synchronous waiter: where the payload is copied to, and the futex
+      word the caller sleeps on, set to 1 when the ind has arrived */
+   void                      *recv_ind_payload_ptr;
+   volatile int32_t          ind_has_arrived;
 
-} loc_sync_req_data_s_type;
+   /* asynchronous waiter: callback, and its place in the timeout list */
+   loc_async_req_cb          cb;
+   void                      *cb_data;
+   struct timespec           expire_time;  /* CLOCK_MONOTONIC */
+   struct loc_sync_waiter_s  *async_next;
+   struct loc_sync_waiter_s  **async_pprev;
+} loc_sync_waiter_s_type;
 
 typedef struct {
-   bool                        in_use;  /* at least one sync call is active */
-   bool                        slot_in_use[LOC_SYNC_REQ_BUFFER_SIZE];
-   loc_sync_req_data_s_type    slots[LOC_SYNC_REQ_BUFFER_SIZE];
-} loc_sync_req_array_s_type;
+   pthread_mutex_t           lock;
+   loc_sync_waiter_s_type    *head;
+} loc_sync_stripe_s_type;
+
+static loc_sync_stripe_s_type loc_sync_stripes[LOC_SYNC_REQ_STRIPES];
+static pthread_once_t loc_sync_once = PTHREAD_ONCE_INIT;
+
+/* Asynchronous waiters, by when they time out, and spare waiter records.
+   The records are allocated as needed and never freed. */
+static pthread_mutex_t loc_async_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  loc_async_cond;
+static loc_sync_waiter_s_type *loc_async_list = NULL;
+static loc_sync_waiter_s_type *loc_async_free = NULL;
+static pthread_once_t loc_async_once = PTHREAD_ONCE_INIT;
+
+static inline long loc_sync_futex(volatile int32_t *addr, int op, int32_t val,
+                                  const struct timespec *timeout)
+{
+   return syscall(__NR_futex, addr, op, val, timeout, NULL, 0);
+}
 
-/***************************************************************************
- *                 DATA FOR ASYNCHRONOUS RPC PROCESSING
- **************************************************************************/
-loc_sync_req_array_s_type loc_sync_array;
+static inline loc_sync_stripe_s_type* loc_sync_stripe(
+      locClientHandleType client_handle, uint32_t ind_id)
+{
+   uintptr_t key = ((uintptr_t)client_handle >> 4) ^ (ind_id * 0x9E3779B1u);
+   return &loc_sync_stripes[(key ^ (key >> 16)) & (LOC_SYNC_REQ_STRIPES - 1)];
+}
+
+static void loc_sync_once_init()
+{
+   int i;
+   for (i = 0; i < LOC_SYNC_REQ_STRIPES; i++)
+   {
+      pthread_mutex_init(&loc_sync_stripes[i].lock, NULL);
+      loc_sync_stripes[i].head = NULL;
+   }
+}
 
 /*===========================================================================
 
@@ -103,46 +142,77 @@ void loc_sync_req_init()
 {
    LOC_LOGV(" %s:%d]:\n", __func__, __LINE__);
    UTIL_READ_CONF_DEFAULT(GPS_CONF_FILE);
-   pthread_mutex_lock(&loc_sync_call_mutex);
-   if(true == loc_sync_call_initialized)
-   {
-      LOC_LOGD("%s:%d]:already initialized\n", __func__, __LINE__);
-      pthread_mutex_unlock(&loc_sync_call_mutex);
-      return;
-   }
+   pthread_once(&loc_sync_once, loc_sync_once_init);
+}
 
-   loc_sync_array.in_use = false;
+/*===========================================================================
 
-   memset(loc_sync_array.slot_in_use, 0, sizeof(loc_sync_array.slot_in_use));
+FUNCTION    loc_sync_add_waiter / loc_sync_claim_waiter
 
-   int i;
-   for (i = 0; i < LOC_SYNC_REQ_BUFFER_SIZE; i++)
-   {
-      loc_sync_req_data_s_type *slot = &loc_sync_array.slots[i];
+DESCRIPTION
+   Adds a waiter to its stripe; claims it back out of the stripe. Whoever
+   claims a waiter, the indication or the timeout, completes it.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   loc_sync_claim_waiter: true if claimed here, false if already claimed
+
+SIDE EFFECTS
+   N/A
 
-      pthread_mutex_init(&slot->sync_req_lock, NULL);
-      pthread_cond_init(&slot->ind_arrived_cond, NULL);
+===========================================================================*/
+static void loc_sync_add_waiter(loc_sync_waiter_s_type *waiter)
+{
+   loc_sync_stripe_s_type *stripe =
+      loc_sync_stripe(waiter->client_handle, waiter->ind_id);
 
-      slot->client_handle = LOC_CLIENT_INVALID_HANDLE_VALUE;
-      slot->ind_is_selected = false;       /* is ind selected? */
-      slot->ind_is_waiting  = false;       /* is waiting?     */
-      slot->ind_has_arrived = false;       /* callback has arrived */
-      slot->recv_ind_id = 0;       /* ind to wait for   */
-      slot->recv_ind_payload_ptr = NULL;
-      slot->req_id =  0;   /* req id   */
+   pthread_mutex_lock(&stripe->lock);
+   waiter->next = stripe->head;
+   if (NULL != waiter->next)
+   {
+      waiter->next->pprev = &waiter->next;
    }
+   waiter->pprev = &stripe->head;
+   stripe->head = waiter;
+   pthread_mutex_unlock(&stripe->lock);
+}
 
-   loc_sync_call_initialized = true;
-   pthread_mutex_unlock(&loc_sync_call_mutex);
+static inline void loc_sync_unlink_waiter(loc_sync_waiter_s_type *waiter)
+{
+   *waiter->pprev = waiter->next;
+   if (NULL != waiter->next)
+   {
+      waiter->next->pprev = waiter->pprev;
+   }
+   waiter->pprev = NULL;
 }
 
+static bool loc_sync_claim_waiter(loc_sync_waiter_s_type *waiter)
+{
+   bool claimed = false;
+   loc_sync_stripe_s_type *stripe =
+      loc_sync_stripe(waiter->client_handle, waiter->ind_id);
+
+   pthread_mutex_lock(&stripe->lock);
+   if (NULL != waiter->pprev)
+   {
+      loc_sync_unlink_waiter(waiter);
+      claimed = true;
+   }
+   pthread_mutex_unlock(&stripe->lock);
+
+   return claimed;
+}
 
 /*===========================================================================
 
 FUNCTION    loc_sync_process_ind
 
 DESCRIPTION
-   Wakes up blocked API calls to check if the needed callback has arrived
+   Wakes up the blocked API call, or calls back the asynchronous request,
+   waiting for this indication
 
 DEPENDENCIES
    N/A
@@ -161,318 +231,378 @@ void loc_sync_process_ind(
       uint32_t               ind_payload_size  /* payload size         */
 )
 {
+   loc_sync_stripe_s_type *stripe;
+   loc_sync_waiter_s_type *waiter, *found = NULL;
 
    LOC_LOGV("%s:%d]: received indication, handle = %p ind_id = %u \n",
                  __func__,__LINE__, client_handle, ind_id);
 
-   pthread_mutex_lock(&loc_sync_call_mutex);
+   pthread_once(&loc_sync_once, loc_sync_once_init);
+   stripe = loc_sync_stripe(client_handle, ind_id);
 
-   if (!loc_sync_array.in_use)
+   pthread_mutex_lock(&stripe->lock);
+
+   /* waiters are added at the head, so the last match is the oldest */
+   for (waiter = stripe->head; NULL != waiter; waiter = waiter->next)
    {
-      LOC_LOGD("%s:%d]: loc_sync_array not in use \n",
-                    __func__, __LINE__);
-      pthread_mutex_unlock(&loc_sync_call_mutex);
-      return;
+      if (waiter->client_handle == client_handle && waiter->ind_id == ind_id)
+      {
+         found = waiter;
+      }
    }
 
-   bool in_use = false, consumed = false;
-   int i;
-
-   for (i = 0; i < LOC_SYNC_REQ_BUFFER_SIZE && !consumed; i++)
+   if (NULL == found)
    {
-      loc_sync_req_data_s_type *slot = &loc_sync_array.slots[i];
-
-      in_use |= loc_sync_array.slot_in_use[i];
+      pthread_mutex_unlock(&stripe->lock);
+      LOC_LOGV("%s:%d]: no waiter for ind %u \n", __func__, __LINE__, ind_id);
+      return;
+   }
 
-      pthread_mutex_lock(&slot->sync_req_lock);
+   loc_sync_unlink_waiter(found);
 
-      if ( (loc_sync_array.slot_in_use[i]) && (slot->client_handle == client_handle)
-            && (ind_id == slot->recv_ind_id) && (!slot->ind_has_arrived))
+   if (NULL == found->cb)
+   {
+      if (NULL != found->recv_ind_payload_ptr &&
+          NULL != ind_payload_ptr && ind_payload_size > 0)
       {
-         LOC_LOGV("%s:%d]: found slot %d selected for ind %u \n",
-                       __func__, __LINE__, i, ind_id);
+         LOC_LOGV("%s:%d]: copying ind payload size = %u \n",
+                       __func__, __LINE__, ind_payload_size);
 
-         if( NULL != slot->recv_ind_payload_ptr &&
-                 NULL != ind_payload_ptr && ind_payload_size > 0 )
-         {
-            LOC_LOGV("%s:%d]: copying ind payload size = %zu \n",
-                          __func__, __LINE__, ind_payload_size);
-
-            memcpy(slot->recv_ind_payload_ptr, ind_payload_ptr, ind_payload_size);
+         memcpy(found->recv_ind_payload_ptr, ind_payload_ptr, ind_payload_size);
+      }
 
-            consumed = true;
-         }
-         /* Received a callback while waiting, wake up thread to check it */
-         if (slot->ind_is_waiting)
-         {
-            slot->recv_ind_id = ind_id;
+      /* Wake the caller while still holding the stripe lock; it takes the
+         lock before returning, so its waiter outlives this wake up */
+      __atomic_store_n(&found->ind_has_arrived, 1, __ATOMIC_RELEASE);
+      loc_sync_futex(&found->ind_has_arrived, FUTEX_WAKE_PRIVATE, 1, NULL);
+      pthread_mutex_unlock(&stripe->lock);
+      return;
+   }
 
-            pthread_cond_signal(&slot->ind_arrived_cond);
-         }
-         else
-         {
-            /* If callback arrives before wait, remember it */
-            LOC_LOGV("%s:%d]: ind %u arrived before wait was called \n",
-                          __func__, __LINE__, ind_id);
+   pthread_mutex_unlock(&stripe->lock);
 
-            slot->ind_has_arrived = true;
-         }
-      }
-      pthread_mutex_unlock(&slot->sync_req_lock);
+   /* asynchronous request: this claimed it, so take it off the timeout
+      list and hand the payload to the callback in place */
+   pthread_mutex_lock(&loc_async_mutex);
+   *found->async_pprev = found->async_next;
+   if (NULL != found->async_next)
+   {
+      found->async_next->async_pprev = found->async_pprev;
    }
+   pthread_mutex_unlock(&loc_async_mutex);
 
-   if (!in_use) {
-      loc_sync_array.in_use = false;
-   }
+   found->cb(found->cb_data, eLOC_CLIENT_SUCCESS, ind_id,
+             ind_payload_ptr, ind_payload_size);
 
-   pthread_mutex_unlock(&loc_sync_call_mutex);
+   pthread_mutex_lock(&loc_async_mutex);
+   found->next = loc_async_free;
+   loc_async_free = found;
+   pthread_mutex_unlock(&loc_async_mutex);
 }
 
 /*===========================================================================
 
-FUNCTION    loc_alloc_slot
+FUNCTION    loc_sync_wait_for_ind
 
 DESCRIPTION
-   Allocates a buffer slot for the synchronous API call
+   Waits for the indication of a waiter added with loc_sync_add_waiter.
+   The wait expires in timeout_msec milliseconds, and the waiter is then
+   claimed back.
 
 DEPENDENCIES
    N/A
 
 RETURN VALUE
-   Select ID (>=0)     : successful
-   -1                  : buffer full
+  0 on SUCCESS, -ve value on failure
 
 SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static int loc_alloc_slot()
+static int loc_sync_wait_for_ind(
+      loc_sync_waiter_s_type *waiter,
+      uint32_t timeout_msec
+)
 {
-   int i, select_id = -1; /* no free buffer */
+   struct timespec now, expire_time, remaining;
+   int ret_val = 0;
 
-   pthread_mutex_lock(&loc_sync_call_mutex);
+   clock_gettime(CLOCK_MONOTONIC, &expire_time);
+   expire_time.tv_sec  += timeout_msec / 1000;
+   expire_time.tv_nsec += (timeout_msec % 1000) * 1000000;
+   if (expire_time.tv_nsec >= 1000000000)
+   {
+      expire_time.tv_sec++;
+      expire_time.tv_nsec -= 1000000000;
+   }
 
-   for (i = 0; i < LOC_SYNC_REQ_BUFFER_SIZE; i++)
+   while (0 == __atomic_load_n(&waiter->ind_has_arrived, __ATOMIC_ACQUIRE))
    {
-      if (!loc_sync_array.slot_in_use[i])
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      remaining.tv_sec  = expire_time.tv_sec - now.tv_sec;
+      remaining.tv_nsec = expire_time.tv_nsec - now.tv_nsec;
+      if (remaining.tv_nsec < 0)
+      {
+         remaining.tv_sec--;
+         remaining.tv_nsec += 1000000000;
+      }
+      if (remaining.tv_sec < 0)
       {
-         select_id = i;
-         loc_sync_array.slot_in_use[i] = 1;
-         loc_sync_array.in_use = true;
+         ret_val = -ETIMEDOUT;
          break;
       }
+      loc_sync_futex(&waiter->ind_has_arrived, FUTEX_WAIT_PRIVATE, 0, &remaining);
    }
 
-   pthread_mutex_unlock(&loc_sync_call_mutex);
-   LOC_LOGV("%s:%d]: returning slot %d\n",
-                 __func__, __LINE__, select_id);
-   return select_id;
+   /* Either way, wait for loc_sync_process_ind to be done with the waiter;
+      if nothing claimed it, the wait timed out */
+   if (loc_sync_claim_waiter(waiter))
+   {
+      LOC_LOGE("%s:%d]: timed out for ind_id %s\n",
+                 __func__, __LINE__, loc_get_v02_event_name(waiter->ind_id));
+      ret_val = -ETIMEDOUT;
+   }
+   else
+   {
+      ret_val = 0;
+   }
+
+   return ret_val;
 }
 
 /*===========================================================================
 
-FUNCTION    loc_free_slot
+FUNCTION    loc_sync_send_with_retry
 
 DESCRIPTION
-   Frees a buffer slot after the synchronous API call
+   Sends the request, retrying a few times on transient failures
 
 DEPENDENCIES
    N/A
 
 RETURN VALUE
-   None
+   Loc API 2.0 status of the last try
 
 SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static void loc_free_slot(int select_id)
+static locClientStatusEnumType loc_sync_send_with_retry
+(
+      locClientHandleType       client_handle,
+      uint32_t                  req_id,
+      locClientReqUnionType     req_payload
+)
 {
-   int i;
-   loc_sync_req_data_s_type *slot;
-
-   pthread_mutex_lock(&loc_sync_call_mutex);
-
-   LOC_LOGD("%s:%d]: freeing slot %d\n", __func__, __LINE__, select_id);
+   locClientStatusEnumType status;
+   int sendReqRetryRem = LOC_SYNC_REQ_SEND_RETRIES; // Number of retries remaining
 
-   loc_sync_array.slot_in_use[select_id] = 0;
-
-   slot = &loc_sync_array.slots[select_id];
-
-   slot->client_handle = LOC_CLIENT_INVALID_HANDLE_VALUE;
-   slot->ind_is_selected = false;       /* is ind selected? */
-   slot->ind_is_waiting  = false;       /* is waiting?     */
-   slot->ind_has_arrived = false;       /* callback has arrived */
-   slot->recv_ind_id = 0;       /* ind to wait for   */
-   slot->recv_ind_payload_ptr = NULL;
-   slot->req_id =  0;
-
-   // check if all slots are now free
-   for (i = 0; i < LOC_SYNC_REQ_BUFFER_SIZE; i++)
-   {
-      if (loc_sync_array.slot_in_use[i]) break;
-   }
-
-   if (i >= LOC_SYNC_REQ_BUFFER_SIZE)
+   do
    {
-      loc_sync_array.in_use = false;
-   }
+      status = locClientSendReq (client_handle, req_id, req_payload);
+      LOC_LOGV("%s:%d]: req_id = %u, locClientSendReq returned %d\n",
+                    __func__, __LINE__, req_id, status);
+   } while(( status == eLOC_CLIENT_FAILURE_ENGINE_BUSY ||
+                 status == eLOC_CLIENT_FAILURE_PHONE_OFFLINE ||
+                 status == eLOC_CLIENT_FAILURE_INTERNAL ) &&
+             sendReqRetryRem-- > 0);
 
-   pthread_mutex_unlock(&loc_sync_call_mutex);
+   return status;
 }
 
 /*===========================================================================
 
-FUNCTION    loc_sync_select_ind
+FUNCTION    loc_sync_send_req
 
 DESCRIPTION
-   Selects which indication to wait for.
-
+   Synchronous req call (thread safe)
 
 DEPENDENCIES
    N/A
 
 RETURN VALUE
-   Select ID (>=0)     : successful
-   -ENOMEM                  : out of buffer
+   Loc API 2.0 status
 
 SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static int loc_sync_select_ind(
-      locClientHandleType       client_handle,   /* Client handle */
-      uint32_t                  ind_id,  /* ind Id wait for */
-      uint32_t                  req_id,   /* req id */
-      void *                    ind_payload_ptr /* ptr where payload should be copied to*/
+locClientStatusEnumType loc_sync_send_req
+(
+      locClientHandleType       client_handle,
+      uint32_t                  req_id,        /* req id */
+      locClientReqUnionType     req_payload,
+      uint32_t                  timeout_msec,
+      uint32_t                  ind_id,  //ind ID to block for, usually the same as req_id */
+      void                      *ind_payload_ptr /* can be NULL*/
 )
 {
-   int select_id = loc_alloc_slot();
+   locClientStatusEnumType status;
+   loc_sync_waiter_s_type waiter;
+   int rc;
 
    LOC_LOGV("%s:%d]: client handle %p, ind_id %u, req_id %u \n",
                  __func__, __LINE__, client_handle, ind_id, req_id);
 
-   if (select_id < 0)
-   {
-      LOC_LOGE("%s:%d]: buffer full for this synchronous req %s \n",
-                 __func__, __LINE__, loc_get_v02_event_name(req_id));
-      return -ENOMEM;
-   }
+   pthread_once(&loc_sync_once, loc_sync_once_init);
 
-   loc_sync_req_data_s_type *slot = &loc_sync_array.slots[select_id];
+   // Select the indication we are waiting for, before it can arrive
+   memset(&waiter, 0, sizeof(waiter));
+   waiter.client_handle = client_handle;
+   waiter.ind_id = ind_id;
+   waiter.req_id = req_id;
+   waiter.recv_ind_payload_ptr = ind_payload_ptr;
+   loc_sync_add_waiter(&waiter);
 
-   pthread_mutex_lock(&slot->sync_req_lock);
+   status = loc_sync_send_with_retry(client_handle, req_id, req_payload);
 
-   slot->client_handle = client_handle;
-   slot->ind_is_selected = true;
-   slot->ind_is_waiting = false;
-   slot->ind_has_arrived = false;
+   if (status != eLOC_CLIENT_SUCCESS)
+   {
+      loc_sync_claim_waiter(&waiter);
+      return status;
+   }
 
-   slot->recv_ind_id = ind_id;
-   slot->req_id      = req_id;
-   slot->recv_ind_payload_ptr = ind_payload_ptr; //store the payload ptr
+   // Wait for the indication callback
+   if ((rc = loc_sync_wait_for_ind(&waiter, timeout_msec)) < 0)
+   {
+      status = (rc == -ETIMEDOUT) ?
+         eLOC_CLIENT_FAILURE_TIMEOUT : eLOC_CLIENT_FAILURE_INTERNAL;
 
-   pthread_mutex_unlock(&slot->sync_req_lock);
+      // Callback waiting failed
+      LOC_LOGE("%s:%d]: loc_api_wait_for_ind failed, err %d, "
+               "status %s", __func__, __LINE__, rc,
+               loc_get_v02_client_status_name(status));
+   }
+   else
+   {
+      LOC_LOGV("%s:%d]: success (req_id %u)\n", __func__, __LINE__, req_id);
+   }
 
-   return select_id;
+   return status;
 }
 
-
 /*===========================================================================
 
-FUNCTION    loc_sync_wait_for_ind
+FUNCTION    loc_async_timeout_thread
 
 DESCRIPTION
-   Waits for a selected indication. The wait expires in timeout_seconds seconds.
-   If the function is called before an existing wait has finished, it will
-   immediately return error.
+   Completes the asynchronous requests whose indication did not arrive in
+   time, sleeping until the earliest of them is due
 
 DEPENDENCIES
    N/A
 
 RETURN VALUE
-  0 on SUCCESS, -ve value on failure
+   none
 
 SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static int loc_sync_wait_for_ind(
-      int select_id,        /* ID from loc_sync_select_ind() */
-      int timeout_seconds,  /* Timeout in this number of seconds  */
-      uint32_t ind_id
-)
+static void* loc_async_timeout_thread(void *arg)
 {
-   if (select_id < 0 || select_id >= LOC_SYNC_REQ_BUFFER_SIZE || !loc_sync_array.slot_in_use[select_id])
-   {
-      LOC_LOGE("%s:%d]: invalid select_id: %d \n",
-                    __func__, __LINE__, select_id);
-
-      return (-EINVAL);
-   }
+   loc_sync_waiter_s_type *waiter, *next, *expired;
+   struct timespec now, earliest;
+   bool has_earliest;
 
-   loc_sync_req_data_s_type *slot = &loc_sync_array.slots[select_id];
+   pthread_mutex_lock(&loc_async_mutex);
 
-   int ret_val = 0;  /* the return value of this function: 0 = no error */
-   int rc;          /* return code from pthread calls */
+   for (;;)
+   {
+      expired = NULL;
+      has_earliest = false;
+      clock_gettime(CLOCK_MONOTONIC, &now);
 
-   struct timeval present_time;
-   struct timespec expire_time;
+      for (waiter = loc_async_list; NULL != waiter; waiter = next)
+      {
+         next = waiter->async_next;
 
-   pthread_mutex_lock(&slot->sync_req_lock);
+         if (waiter->expire_time.tv_sec > now.tv_sec ||
+             (waiter->expire_time.tv_sec == now.tv_sec &&
+              waiter->expire_time.tv_nsec > now.tv_nsec))
+         {
+            if (!has_earliest ||
+                waiter->expire_time.tv_sec < earliest.tv_sec ||
+                (waiter->expire_time.tv_sec == earliest.tv_sec &&
+                 waiter->expire_time.tv_nsec < earliest.tv_nsec))
+            {
+               earliest = waiter->expire_time;
+               has_earliest = true;
+            }
+         }
+         /* an expired waiter that the indication already claimed is left
+            for loc_sync_process_ind to take off the list */
+         else if (loc_sync_claim_waiter(waiter))
+         {
+            *waiter->async_pprev = waiter->async_next;
+            if (NULL != waiter->async_next)
+            {
+               waiter->async_next->async_pprev = waiter->async_pprev;
+            }
+            waiter->async_next = expired;
+            expired = waiter;
+         }
+      }
 
-  do
-  {
-      if (slot->ind_has_arrived)
+      if (NULL != expired)
       {
-         ret_val = 0;    /* success */
-         break;
+         pthread_mutex_unlock(&loc_async_mutex);
+         for (waiter = expired; NULL != waiter; waiter = next)
+         {
+            next = waiter->async_next;
+            LOC_LOGE("%s:%d]: timed out for ind_id %s\n", __func__, __LINE__,
+                     loc_get_v02_event_name(waiter->ind_id));
+            waiter->cb(waiter->cb_data, eLOC_CLIENT_FAILURE_TIMEOUT,
+                       waiter->ind_id, NULL, 0);
+         }
+         pthread_mutex_lock(&loc_async_mutex);
+         for (waiter = expired; NULL != waiter; waiter = next)
+         {
+            next = waiter->async_next;
+            waiter->next = loc_async_free;
+            loc_async_free = waiter;
+         }
+         continue;
       }
 
-      if (slot->ind_is_waiting)
+      if (has_earliest)
       {
-         LOC_LOGW("%s:%d]: already waiting in this slot %d\n", __func__,
-                       __LINE__, select_id);
-         ret_val = -EBUSY; // busy
-         break;
+         pthread_cond_timedwait(&loc_async_cond, &loc_async_mutex, &earliest);
       }
-
-      /* Calculate absolute expire time */
-      gettimeofday(&present_time, NULL);
-      expire_time.tv_sec  = present_time.tv_sec;
-      expire_time.tv_nsec = present_time.tv_usec * 1000;
-      expire_time.tv_sec += timeout_seconds;
-
-      /* Take new wait request */
-      slot->ind_is_waiting = true;
-
-      /* Waiting */
-      rc = pthread_cond_timedwait(&slot->ind_arrived_cond,
-            &slot->sync_req_lock, &expire_time);
-
-      slot->ind_is_waiting = false;
-
-      if(rc == ETIMEDOUT)
+      else
       {
-         LOC_LOGE("%s:%d]: slot %d, timed out for ind_id %s\n",
-                    __func__, __LINE__, select_id, loc_get_v02_event_name(ind_id));
-         ret_val = -ETIMEDOUT; //time out
+         pthread_cond_wait(&loc_async_cond, &loc_async_mutex);
       }
+   }
+
+   return NULL;
+}
 
-  } while (0);
+static void loc_async_once_init()
+{
+   pthread_condattr_t attr;
+   pthread_t thread;
 
-   pthread_mutex_unlock(&slot->sync_req_lock);
-   loc_free_slot(select_id);
+   pthread_condattr_init(&attr);
+   pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+   pthread_cond_init(&loc_async_cond, &attr);
+   pthread_condattr_destroy(&attr);
 
-   return ret_val;
+   if (0 != pthread_create(&thread, NULL, loc_async_timeout_thread, NULL))
+   {
+      LOC_LOGE("%s:%d]: failed to start the timeout thread\n",
+               __func__, __LINE__);
+      return;
+   }
+   pthread_detach(thread);
 }
 
 /*===========================================================================
 
-FUNCTION    loc_sync_send_req
+FUNCTION    loc_async_send_req
 
 DESCRIPTION
-   Synchronous req call (thread safe)
+   Asynchronous req call (thread safe)
 
 DEPENDENCIES
    N/A
@@ -484,72 +614,316 @@ SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-locClientStatusEnumType loc_sync_send_req
+locClientStatusEnumType loc_async_send_req
 (
       locClientHandleType       client_handle,
       uint32_t                  req_id,        /* req id */
       locClientReqUnionType     req_payload,
       uint32_t                  timeout_msec,
-      uint32_t                  ind_id,  //ind ID to block for, usually the same as req_id */
-      void                      *ind_payload_ptr /* can be NULL*/
+      uint32_t                  ind_id,  //ind ID to wait for, usually the same as req_id */
+      loc_async_req_cb          cb,
+      void                      *cb_data
 )
 {
-   locClientStatusEnumType status = eLOC_CLIENT_SUCCESS ;
-   int select_id;
-   int rc = 0;
-   int sendReqRetryRem = 5; // Number of retries remaining
+   locClientStatusEnumType status;
+   loc_sync_waiter_s_type *waiter;
 
-   // Select the callback we are waiting for
-   select_id = loc_sync_select_ind(client_handle, ind_id, req_id,
-                                   ind_payload_ptr);
+   LOC_LOGV("%s:%d]: client handle %p, ind_id %u, req_id %u \n",
+                 __func__, __LINE__, client_handle, ind_id, req_id);
 
-   if (select_id >= 0)
+   if (NULL == cb)
    {
-      // Loop to retry few times in case of failures
-      do
-      {
-         status =  locClientSendReq (client_handle, req_id, req_payload);
-         LOC_LOGV("%s:%d]: select_id = %d,locClientSendReq returned %d\n",
-                       __func__, __LINE__, select_id, status);
+      return eLOC_CLIENT_FAILURE_INVALID_PARAMETER;
+   }
 
-         if (status == eLOC_CLIENT_SUCCESS )
-         {
-            // Wait for the indication callback
-            if (( rc = loc_sync_wait_for_ind( select_id,
-                                              timeout_msec / 1000,
-                                              ind_id) ) < 0)
-            {
-               if ( rc == -ETIMEDOUT)
-                  status = eLOC_CLIENT_FAILURE_TIMEOUT;
-               else
-                  status = eLOC_CLIENT_FAILURE_INTERNAL;
-
-               // Callback waiting failed
-               LOC_LOGE("%s:%d]: loc_api_wait_for_ind failed, err %d, "
-                        "select id %d, status %s", __func__, __LINE__, rc ,
-                        select_id, loc_get_v02_client_status_name(status));
-            }
-            else
-            {
-               status =  eLOC_CLIENT_SUCCESS;
-               LOC_LOGV("%s:%d]: success (select id %d)\n",
-                             __func__, __LINE__, select_id);
-            }
-         }
+   pthread_once(&loc_sync_once, loc_sync_once_init);
+   pthread_once(&loc_async_once, loc_async_once_init);
 
-      } while(( status == eLOC_CLIENT_FAILURE_ENGINE_BUSY ||
-                    status == eLOC_CLIENT_FAILURE_PHONE_OFFLINE ||
-                    status == eLOC_CLIENT_FAILURE_INTERNAL ) &&
-                sendReqRetryRem-- > 0);
+   pthread_mutex_lock(&loc_async_mutex);
+   waiter = loc_async_free;
+   if (NULL != waiter)
+   {
+      loc_async_free = waiter->next;
+   }
+   pthread_mutex_unlock(&loc_async_mutex);
 
-      if (status != eLOC_CLIENT_SUCCESS )
+   if (NULL == waiter)
+   {
+      waiter = (loc_sync_waiter_s_type *)malloc(sizeof(*waiter));
+      if (NULL == waiter)
       {
-         loc_free_slot(select_id);
+         LOC_LOGE("%s:%d]: out of memory for req %s \n",
+                  __func__, __LINE__, loc_get_v02_event_name(req_id));
+         return eLOC_CLIENT_FAILURE_NOT_ENOUGH_MEMORY;
       }
+   }
 
-   } /* select id */
+   memset(waiter, 0, sizeof(*waiter));
+   waiter->client_handle = client_handle;
+   waiter->ind_id = ind_id;
+   waiter->req_id = req_id;
+   waiter->cb = cb;
+   waiter->cb_data = cb_data;
+
+   clock_gettime(CLOCK_MONOTONIC, &waiter->expire_time);
+   waiter->expire_time.tv_sec  += timeout_msec / 1000;
+   waiter->expire_time.tv_nsec += (timeout_msec % 1000) * 1000000;
+   if (waiter->expire_time.tv_nsec >= 1000000000)
+   {
+      waiter->expire_time.tv_sec++;
+      waiter->expire_time.tv_nsec -= 1000000000;
+   }
+
+   /* The waiter goes into its stripe and the timeout list together, so
+      the timeout thread never sees it before it can be claimed, and an
+      indication claiming it waits for it to be on the timeout list */
+   pthread_mutex_lock(&loc_async_mutex);
+   loc_sync_add_waiter(waiter);
+   waiter->async_next = loc_async_list;
+   if (NULL != waiter->async_next)
+   {
+      waiter->async_next->async_pprev = &waiter->async_next;
+   }
+   waiter->async_pprev = &loc_async_list;
+   loc_async_list = waiter;
+   pthread_cond_signal(&loc_async_cond);
+   pthread_mutex_unlock(&loc_async_mutex);
+
+   status = loc_sync_send_with_retry(client_handle, req_id, req_payload);
+
+   if (status != eLOC_CLIENT_SUCCESS)
+   {
+      if (!loc_sync_claim_waiter(waiter))
+      {
+         /* an indication or the timeout got to it first, and the callback
+            completes the request */
+         return eLOC_CLIENT_SUCCESS;
+      }
+      pthread_mutex_lock(&loc_async_mutex);
+      *waiter->async_pprev = waiter->async_next;
+      if (NULL != waiter->async_next)
+      {
+         waiter->async_next->async_pprev = waiter->async_pprev;
+      }
+      waiter->next = loc_async_free;
+      loc_async_free = waiter;
+      pthread_mutex_unlock(&loc_async_mutex);
+   }
 
    return status;
 }
 
+#ifdef __LOC_DEBUG__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Host test with a fake locClientSendReq: request ids below
+   LOC_SYNC_TEST_UNANSWERED are answered from another thread a few ms
+   later with the payload id * 7, the others are never answered. */
+#define LOC_SYNC_TEST_UNANSWERED 1000
+#define LOC_SYNC_TEST_THREADS    8
+#define LOC_SYNC_TEST_ROUNDS     500
+
+typedef struct {
+   locClientHandleType client_handle;
+   uint32_t ind_id;
+} loc_sync_test_ind;
+
+static int32_t loc_sync_test_ok, loc_sync_test_bad, loc_sync_test_timeouts;
+
+static void* loc_sync_test_deliver(void *arg)
+{
+   loc_sync_test_ind *ind = (loc_sync_test_ind *)arg;
+   uint32_t payload = ind->ind_id * 7;
+
+   usleep(1000 + rand() % 3000);
+   loc_sync_process_ind(ind->client_handle, ind->ind_id, &payload, sizeof(payload));
+   free(ind);
+   return NULL;
+}
+
+locClientStatusEnumType locClientSendReq(locClientHandleType client_handle,
+                                         uint32_t req_id,
+                                         locClientReqUnionType req_payload)
+{
+   loc_sync_test_ind *ind;
+   pthread_t thread;
+
+   (void)req_payload;
+   if (req_id >= LOC_SYNC_TEST_UNANSWERED)
+   {
+      return eLOC_CLIENT_SUCCESS;
+   }
+
+   ind = (loc_sync_test_ind *)malloc(sizeof(*ind));
+   if (NULL == ind)
+   {
+      return eLOC_CLIENT_FAILURE_NOT_ENOUGH_MEMORY;
+   }
+   ind->client_handle = client_handle;
+   ind->ind_id = req_id;
+   if (0 != pthread_create(&thread, NULL, loc_sync_test_deliver, ind))
+   {
+      free(ind);
+      return eLOC_CLIENT_FAILURE_INTERNAL;
+   }
+   pthread_detach(thread);
+   return eLOC_CLIENT_SUCCESS;
+}
+
+static void loc_sync_test_cb(void *cb_data, locClientStatusEnumType status,
+                             uint32_t ind_id, const void *ind_payload_ptr,
+                             uint32_t ind_payload_size)
+{
+   (void)cb_data;
+   if (eLOC_CLIENT_SUCCESS == status && sizeof(uint32_t) == ind_payload_size &&
+       ind_id * 7 == *(const uint32_t *)ind_payload_ptr)
+   {
+      __atomic_add_fetch(&loc_sync_test_ok, 1, __ATOMIC_RELAXED);
+   }
+   else if (eLOC_CLIENT_FAILURE_TIMEOUT == status && NULL == ind_payload_ptr)
+   {
+      __atomic_add_fetch(&loc_sync_test_timeouts, 1, __ATOMIC_RELAXED);
+   }
+   else
+   {
+      __atomic_add_fetch(&loc_sync_test_bad, 1, __ATOMIC_RELAXED);
+   }
+}
+
+/* answered synchronous requests, then one that times out */
+static void* loc_sync_test_sync_thread(void *arg)
+{
+   long n = (long)arg;
+   locClientHandleType client_handle = (locClientHandleType)(0x1000 + (n % 3) * 16);
+   locClientReqUnionType req_payload;
+   uint32_t req_id, payload;
+   int i;
+
+   memset(&req_payload, 0, sizeof(req_payload));
+   for (i = 0; i < 50; i++)
+   {
+      req_id = n * 20 + i % 20 + 1;
+      payload = 0;
+      if (eLOC_CLIENT_SUCCESS == loc_sync_send_req(client_handle, req_id, req_payload,
+                                                   1000, req_id, &payload) &&
+          req_id * 7 == payload)
+      {
+         __atomic_add_fetch(&loc_sync_test_ok, 1, __ATOMIC_RELAXED);
+      }
+      else
+      {
+         __atomic_add_fetch(&loc_sync_test_bad, 1, __ATOMIC_RELAXED);
+      }
+   }
+
+   req_id = LOC_SYNC_TEST_UNANSWERED + n;
+   if (eLOC_CLIENT_FAILURE_TIMEOUT == loc_sync_send_req(client_handle, req_id, req_payload,
+                                                        50, req_id, &payload))
+   {
+      __atomic_add_fetch(&loc_sync_test_timeouts, 1, __ATOMIC_RELAXED);
+   }
+   return NULL;
+}
+
+/* asynchronous requests that are due as soon as they are sent */
+static void* loc_sync_test_expired_thread(void *arg)
+{
+   long n = (long)arg;
+   locClientReqUnionType req_payload;
+   uint32_t req_id = LOC_SYNC_TEST_UNANSWERED + 100 + n;
+
+   memset(&req_payload, 0, sizeof(req_payload));
+   loc_async_send_req((locClientHandleType)0x2000, req_id, req_payload, 0,
+                      req_id, loc_sync_test_cb, NULL);
+   return NULL;
+}
+
+/* wait up to timeout_msec for 'expected' timeouts, returns the count seen */
+static int32_t loc_sync_test_wait_timeouts(int32_t expected, int timeout_msec)
+{
+   int32_t seen;
+
+   while ((seen = __atomic_load_n(&loc_sync_test_timeouts, __ATOMIC_RELAXED)) < expected &&
+          timeout_msec-- > 0)
+   {
+      usleep(1000);
+   }
+   return seen;
+}
+
+// compilation: gcc -D__LOC_DEBUG__ -fsanitize=thread -g -I. -I../../utils -I../../utils/platform_lib_abstractions/loc_pla/include loc_api_sync_req.c -lpthread
+// test: ./a.out, with stubs of the QMI headers on a host
+int main()
+{
+   pthread_t threads[LOC_SYNC_TEST_THREADS];
+   locClientReqUnionType req_payload;
+   int32_t expected, seen, ok, bad;
+   long i;
+   int round, errors = 0;
+
+   loc_sync_req_init();
+   memset(&req_payload, 0, sizeof(req_payload));
+
+   /* answered and timed out requests, synchronous and asynchronous mixed */
+   for (i = 0; i < 200; i++)
+   {
+      loc_async_send_req((locClientHandleType)0x2000, i % 50 + 1, req_payload, 1000,
+                         i % 50 + 1, loc_sync_test_cb, NULL);
+   }
+   for (i = 0; i < 20; i++)
+   {
+      loc_async_send_req((locClientHandleType)0x2000, LOC_SYNC_TEST_UNANSWERED + 50 + i,
+                         req_payload, 100 + i * 10, LOC_SYNC_TEST_UNANSWERED + 50 + i,
+                         loc_sync_test_cb, NULL);
+   }
+   for (i = 0; i < LOC_SYNC_TEST_THREADS; i++)
+   {
+      pthread_create(&threads[i], NULL, loc_sync_test_sync_thread, (void *)i);
+   }
+   for (i = 0; i < LOC_SYNC_TEST_THREADS; i++)
+   {
+      pthread_join(threads[i], NULL);
+   }
+   expected = 20 + LOC_SYNC_TEST_THREADS;
+   if (loc_sync_test_wait_timeouts(expected, 2000) != expected)
+   {
+      errors++;
+   }
+   ok = __atomic_load_n(&loc_sync_test_ok, __ATOMIC_RELAXED);
+   bad = __atomic_load_n(&loc_sync_test_bad, __ATOMIC_RELAXED);
+   printf("mixed: ok %d/%d, timeouts %d/%d, bad %d\n", ok,
+          200 + 50 * LOC_SYNC_TEST_THREADS,
+          __atomic_load_n(&loc_sync_test_timeouts, __ATOMIC_RELAXED), expected, bad);
+   if (ok != 200 + 50 * LOC_SYNC_TEST_THREADS || bad != 0)
+   {
+      errors++;
+   }
+
+   /* bursts of already expired requests racing the timeout thread, each
+      has to time out even when no later request wakes the thread up */
+   for (round = 0; round < LOC_SYNC_TEST_ROUNDS && 0 == errors; round++)
+   {
+      for (i = 0; i < LOC_SYNC_TEST_THREADS; i++)
+      {
+         pthread_create(&threads[i], NULL, loc_sync_test_expired_thread, (void *)i);
+      }
+      for (i = 0; i < LOC_SYNC_TEST_THREADS; i++)
+      {
+         pthread_join(threads[i], NULL);
+      }
+      expected += LOC_SYNC_TEST_THREADS;
+      seen = loc_sync_test_wait_timeouts(expected, 1000);
+      if (seen != expected)
+      {
+         printf("expired: round %d stalled, timeouts %d/%d\n", round, seen, expected);
+         errors++;
+      }
+   }
+   printf("expired: %d rounds of %d requests\n", round, LOC_SYNC_TEST_THREADS);
+
+   return errors ? 1 : 0;
+}
 
+#endif
@@ -85,6 +85,31 @@ extern locClientStatusEnumType loc_sync_send_req
       void                      *ind_payload_ptr /* can be NULL*/
 );
 
+/* Completion of an asynchronous request. status is eLOC_CLIENT_SUCCESS with
+   the indication payload, only valid during the call, or
+   eLOC_CLIENT_FAILURE_TIMEOUT with NULL. Called on the thread delivering
+   the indication, or on the timeout thread. */
+typedef void (*loc_async_req_cb)(
+      void                      *cb_data,
+      locClientStatusEnumType   status,
+      uint32_t                  ind_id,
+      const void                *ind_payload_ptr,
+      uint32_t                  ind_payload_size
+);
+
+/* Thread safe asynchronous request. cb is called exactly once if this
+   returns eLOC_CLIENT_SUCCESS, possibly before it returns; never otherwise */
+extern locClientStatusEnumType loc_async_send_req
+(
+      locClientHandleType       client_handle,
+      uint32_t                  req_id,        /* req id */
+      locClientReqUnionType     req_payload,
+      uint32_t                  timeout_msec,
+      uint32_t                  ind_id,  //ind ID to wait for, usually the same as req_id */
+      loc_async_req_cb          cb,
+      void                      *cb_data
+);
+
 #ifdef __cplusplus
 }
 #endif
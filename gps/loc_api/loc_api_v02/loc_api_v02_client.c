@@ -32,6 +32,7 @@
 
 #include <stdbool.h>
 #include <inttypes.h>
+#include <pthread.h>
 
 #include "qmi_client.h"
 #include "qmi_idl_lib.h"
@@ -642,6 +643,48 @@ static const locClientRespIndTableStructT locClientRespIndTable[]= {
 /** whether indication is an event or a response */
 typedef enum { eventIndType =0, respIndType = 1 } locClientIndEnumT;
 
+/* QMI_LOC indication IDs are dense and small, so each indication table is
+   also indexed directly by ID. An index entry holds the position of the
+   ID in its table plus one, or 0 if the table does not have it. IDs at or
+   beyond LOC_CLIENT_IND_ID_MAX are looked up in the tables directly. */
+#define LOC_CLIENT_IND_ID_MAX (0x0100)
+
+#define LOC_CLIENT_EVENT_IND_TABLE_SIZE \
+  (sizeof(locClientEventIndTable)/sizeof(locClientEventIndTableStructT))
+#define LOC_CLIENT_RESP_IND_TABLE_SIZE \
+  (sizeof(locClientRespIndTable)/sizeof(locClientRespIndTableStructT))
+
+static uint16_t locClientEventIndIdx[LOC_CLIENT_IND_ID_MAX];
+static uint16_t locClientRespIndIdx[LOC_CLIENT_IND_ID_MAX];
+static pthread_once_t locClientIndIdxOnce = PTHREAD_ONCE_INIT;
+
+/* Decode buffers for indications come from a few size classes. Each class
+   caches up to LOC_CLIENT_IND_BUF_MAX_FREE buffers, which covers the
+   indications QCCI delivers one at a time. Indications larger than the
+   biggest class are malloc'd and freed as before. */
+#define LOC_CLIENT_IND_BUF_CLASSES  (4)
+#define LOC_CLIENT_IND_BUF_MAX_FREE (2)
+
+typedef struct locClientIndBufStructT
+{
+  struct locClientIndBufStructT *pNext;
+}locClientIndBufStructT;
+
+typedef struct
+{
+  size_t                  bufSize;
+  uint32_t                freeCount;
+  locClientIndBufStructT *pFree;
+}locClientIndBufClassStructT;
+
+static locClientIndBufClassStructT locClientIndBufClass[LOC_CLIENT_IND_BUF_CLASSES] = {
+  { 256,   0, NULL },
+  { 1024,  0, NULL },
+  { 4096,  0, NULL },
+  { 16384, 0, NULL }
+};
+static pthread_mutex_t locClientIndBufMutex = PTHREAD_MUTEX_INITIALIZER;
+
 
 /** @struct locClientInternalState
  */
@@ -674,6 +717,34 @@ struct locClientCbDataStructT
  *
  *==========================================================================*/
 
+/** locClientIndIdxInit
+ *  @brief builds the direct indexes of the event and response
+ *         indication tables. Where an ID repeats in a table, the
+ *         first entry wins, as with a linear search. */
+
+static void locClientIndIdxInit(void)
+{
+  size_t idx = 0;
+
+  for(idx = 0; idx < LOC_CLIENT_EVENT_IND_TABLE_SIZE; idx++)
+  {
+    uint32_t indId = locClientEventIndTable[idx].eventId;
+    if(indId < LOC_CLIENT_IND_ID_MAX && 0 == locClientEventIndIdx[indId])
+    {
+      locClientEventIndIdx[indId] = (uint16_t)(idx + 1);
+    }
+  }
+
+  for(idx = 0; idx < LOC_CLIENT_RESP_IND_TABLE_SIZE; idx++)
+  {
+    uint32_t indId = locClientRespIndTable[idx].respIndId;
+    if(indId < LOC_CLIENT_IND_ID_MAX && 0 == locClientRespIndIdx[indId])
+    {
+      locClientRespIndIdx[indId] = (uint16_t)(idx + 1);
+    }
+  }
+}
+
 /** locClientGetSizeAndTypeByIndId
  *  @brief this function gets the size and the type (event,
  *         response)of the indication structure from its ID
@@ -690,9 +761,6 @@ static bool locClientGetSizeAndTypeByIndId (uint32_t indId, size_t *pIndSize,
   if(true == locClientGetSizeByEventIndId(indId, pIndSize))
   {
     *pIndType = eventIndType;
-
-    LOC_LOGV("%s:%d]: indId %d is an event size = %d\n", __func__, __LINE__,
-                  indId, (uint32_t)*pIndSize);
     return true;
   }
 
@@ -700,9 +768,6 @@ static bool locClientGetSizeAndTypeByIndId (uint32_t indId, size_t *pIndSize,
   if(true == locClientGetSizeByRespIndId(indId, pIndSize))
   {
     *pIndType = respIndType;
-
-    LOC_LOGV("%s:%d]: indId %d is a resp size = %d\n", __func__, __LINE__,
-                  indId, (uint32_t)*pIndSize);
     return true;
   }
 
@@ -711,6 +776,84 @@ static bool locClientGetSizeAndTypeByIndId (uint32_t indId, size_t *pIndSize,
   return false;
 }
 
+/** locClientIndBufAlloc
+ *  @brief gets a decode buffer of at least indSize bytes, from
+ *         the smallest size class that fits when there is one
+ *  @param [in] indSize  size of the decoded indication
+ *  @return buffer, or NULL if allocation failed */
+
+static void* locClientIndBufAlloc(size_t indSize)
+{
+  locClientIndBufStructT *pBuf = NULL;
+  uint32_t cls = 0;
+
+  for(cls = 0; cls < LOC_CLIENT_IND_BUF_CLASSES; cls++)
+  {
+    if(indSize <= locClientIndBufClass[cls].bufSize)
+    {
+      break;
+    }
+  }
+
+  if(cls == LOC_CLIENT_IND_BUF_CLASSES)
+  {
+    return malloc(indSize);
+  }
+
+  pthread_mutex_lock(&locClientIndBufMutex);
+  pBuf = locClientIndBufClass[cls].pFree;
+  if(NULL != pBuf)
+  {
+    locClientIndBufClass[cls].pFree = pBuf->pNext;
+    locClientIndBufClass[cls].freeCount--;
+  }
+  pthread_mutex_unlock(&locClientIndBufMutex);
+
+  if(NULL == pBuf)
+  {
+    pBuf = (locClientIndBufStructT *)malloc(locClientIndBufClass[cls].bufSize);
+  }
+  return pBuf;
+}
+
+/** locClientIndBufFree
+ *  @brief returns a buffer from locClientIndBufAlloc. indSize
+ *         must be the size it was allocated with.
+ *  @param [in] pIndBuf  buffer to release
+ *  @param [in] indSize  size of the decoded indication */
+
+static void locClientIndBufFree(void *pIndBuf, size_t indSize)
+{
+  locClientIndBufStructT *pBuf = (locClientIndBufStructT *)pIndBuf;
+  uint32_t cls = 0;
+
+  for(cls = 0; cls < LOC_CLIENT_IND_BUF_CLASSES; cls++)
+  {
+    if(indSize <= locClientIndBufClass[cls].bufSize)
+    {
+      break;
+    }
+  }
+
+  if(cls < LOC_CLIENT_IND_BUF_CLASSES)
+  {
+    pthread_mutex_lock(&locClientIndBufMutex);
+    if(locClientIndBufClass[cls].freeCount < LOC_CLIENT_IND_BUF_MAX_FREE)
+    {
+      pBuf->pNext = locClientIndBufClass[cls].pFree;
+      locClientIndBufClass[cls].pFree = pBuf;
+      locClientIndBufClass[cls].freeCount++;
+      pBuf = NULL;
+    }
+    pthread_mutex_unlock(&locClientIndBufMutex);
+  }
+
+  if(NULL != pBuf)
+  {
+    free(pBuf);
+  }
+}
+
 /** checkQmiMsgsSupported
  @brief check the qmi service is supported or not.
  @param [in] pResponse  pointer to the response received from
@@ -933,7 +1076,7 @@ static void locClientIndCb
     void *indBuffer = NULL;
 
     // decode the indication
-    indBuffer = malloc(indSize);
+    indBuffer = locClientIndBufAlloc(indSize);
 
     if(NULL == indBuffer)
     {
@@ -1025,7 +1168,7 @@ static void locClientIndCb
     }
     if(indBuffer)
     {
-      free (indBuffer);
+      locClientIndBufFree(indBuffer, indSize);
     }
   }
   else // Id not found
@@ -2236,7 +2379,7 @@ locClientStatusEnumType locClientSupportMsgCheck(
 
 bool locClientGetSizeByRespIndId(uint32_t respIndId, size_t *pRespIndSize)
 {
-  size_t idx = 0, respIndTableSize = 0;
+  size_t idx = 0;
 
   // Validate input arguments
   if(pRespIndSize == NULL)
@@ -2245,8 +2388,20 @@ bool locClientGetSizeByRespIndId(uint32_t respIndId, size_t *pRespIndSize)
     return false;
   }
 
-  respIndTableSize = (sizeof(locClientRespIndTable)/sizeof(locClientRespIndTableStructT));
-  for(idx=0; idx<respIndTableSize; idx++ )
+  pthread_once(&locClientIndIdxOnce, locClientIndIdxInit);
+
+  if(respIndId < LOC_CLIENT_IND_ID_MAX)
+  {
+    idx = locClientRespIndIdx[respIndId];
+    if(0 == idx)
+    {
+      return false;
+    }
+    *pRespIndSize = locClientRespIndTable[idx - 1].respIndSize;
+    return true;
+  }
+
+  for(idx=0; idx<LOC_CLIENT_RESP_IND_TABLE_SIZE; idx++ )
   {
     if(respIndId == locClientRespIndTable[idx].respIndId)
     {
@@ -2273,7 +2428,7 @@ bool locClientGetSizeByRespIndId(uint32_t respIndId, size_t *pRespIndSize)
 */
 bool locClientGetSizeByEventIndId(uint32_t eventIndId, size_t *pEventIndSize)
 {
-  size_t idx = 0, eventIndTableSize = 0;
+  size_t idx = 0;
 
   // Validate input arguments
   if(pEventIndSize == NULL)
@@ -2282,11 +2437,21 @@ bool locClientGetSizeByEventIndId(uint32_t eventIndId, size_t *pEventIndSize)
     return false;
   }
 
-  // look in the event table
-  eventIndTableSize =
-    (sizeof(locClientEventIndTable)/sizeof(locClientEventIndTableStructT));
+  pthread_once(&locClientIndIdxOnce, locClientIndIdxInit);
 
-  for(idx=0; idx<eventIndTableSize; idx++ )
+  if(eventIndId < LOC_CLIENT_IND_ID_MAX)
+  {
+    idx = locClientEventIndIdx[eventIndId];
+    if(0 == idx)
+    {
+      return false;
+    }
+    *pEventIndSize = locClientEventIndTable[idx - 1].eventSize;
+    return true;
+  }
+
+  // look in the event table
+  for(idx=0; idx<LOC_CLIENT_EVENT_IND_TABLE_SIZE; idx++ )
   {
     if(eventIndId == locClientEventIndTable[idx].eventId)
     {
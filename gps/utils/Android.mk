@@ -15,12 +15,16 @@ LOCAL_SHARED_LIBRARIES := \
 
 LOCAL_SRC_FILES += \
     loc_log.cpp \
+    loc_log_async.c \
     loc_cfg.cpp \
     msg_q.c \
+    mpsc_q.c \
     linked_list.c \
     loc_target.cpp \
     platform_lib_abstractions/elapsed_millis_since_boot.cpp \
     LocHeap.cpp \
+    LocPool.cpp \
+    LocTimerWheel.cpp \
     LocTimer.cpp \
     LocThread.cpp \
     MsgTask.cpp \
@@ -44,12 +48,16 @@ LOCAL_C_INCLUDES:= \
 LOCAL_COPY_HEADERS_TO:= gps.utils/
 LOCAL_COPY_HEADERS:= \
    loc_log.h \
+   loc_log_async.h \
    loc_cfg.h \
    log_util.h \
    linked_list.h \
    msg_q.h \
+   mpsc_q.h \
    MsgTask.h \
    LocHeap.h \
+   LocPool.h \
+   LocTimerWheel.h \
    LocThread.h \
    LocTimer.h \
    loc_target.h \
@@ -26,252 +26,138 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *
  */
+#include <stdlib.h>
 #include <LocHeap.h>
 
-class LocHeapNode {
-    friend class LocHeap;
-
-    // size of of the subtree, excluding self, 1 if no subtree
-    int mSize;
-    LocHeapNode* mLeft;
-    LocHeapNode* mRight;
-    LocRankable* mData;
-public:
-    inline LocHeapNode(LocRankable& data) :
-        mSize(1), mLeft(NULL), mRight(NULL), mData(&data) {}
-    ~LocHeapNode();
-
-    // this only swaps the data of the two nodes, so no
-    // detach / re-attached is necessary
-    void swap(LocHeapNode& node);
-
-    LocRankable* detachData();
-
-    // push a node into the tree stucture, keeping sorted by rank
-    void push(LocHeapNode& node);
-
-    // pop the head node out of the tree stucture. keeping sorted by rank
-    static LocHeapNode* pop(LocHeapNode*& top);
-
-    // remove a specific node from the tree
-    // returns the pointer to the node removed, which would be either the
-    //         same as input (if successfully removed); or NULL (if failed).
-    static LocHeapNode* remove(LocHeapNode*& top, LocRankable& data);
-
-    // convenience method to compare data ranking
-    inline bool outRanks(LocHeapNode& node) { return mData->outRanks(*node.mData); }
-    inline bool outRanks(LocRankable& data) { return mData->outRanks(data); }
-
-    // checks if mSize is correct, AND this node is the highest ranking
-    // of the entire subtree
-    bool checkNodes();
-
-    inline int getSize() { return mSize; }
-};
-
-inline
-LocHeapNode::~LocHeapNode() {
-    if (mLeft) {
-        delete mLeft;
-        mLeft = NULL;
-    }
-    if (mRight) {
-        delete mRight;
-        mRight = NULL;
-    }
-    if (mData) {
-        mData = NULL;
-    }
-}
+#define LOC_HEAP_INIT_CAPACITY 16
 
-inline
-void LocHeapNode::swap(LocHeapNode& node) {
-    LocRankable* tmpData = node.mData;
-    node.mData = mData;
-    mData = tmpData;
-}
-
-inline
-LocRankable* LocHeapNode::detachData()  {
-    LocRankable* data = mData;
-    mData = NULL;
-    return data;
-}
-
-// push keeps the tree sorted by rank, it also tries to balance the
-// tree by adding the new node to the smaller of the subtrees.
-// The pointer to the tree and internal links never change. If the
-// mData of tree top ranks lower than that of the incoming node,
-// mData will be swapped with that of the incoming node to ensure
-// ranking, no restructuring the container nodes.
-void LocHeapNode::push(LocHeapNode& node) {
-    // ensure the current node ranks higher than in the incoming one
-    if (node.outRanks(*this)) {
-        swap(node);
-    }
-
-    // now drop the new node (ensured lower than *this) into a subtree
-    if (NULL == mLeft) {
-        mLeft = &node;
-    } else if (NULL == mRight) {
-        mRight = &node;
-    } else if (mLeft->mSize <= mRight->mSize) {
-        mLeft->push(node);
-    } else {
-        mRight->push(node);
-    }
-    mSize++;
-}
-
-// pop keeps the tree sorted by rank, but it does not try to balance
-// the tree. It recursively swaps with the higher ranked top of the
-// subtrees.
-// The return is a popped out node from leaf level, that has the data
-// swapped all the way down from the top. The pinter to the tree and
-// internal links will not be changed or restructured, except for the
-// node that is popped out.
-// If the return pointer == this, this the last node in the tree.
-LocHeapNode* LocHeapNode::pop(LocHeapNode*& top) {
-    // we know the top has the highest ranking at this point, else
-    // the tree is broken. This top will be popped out.  But we need
-    // a node from the left or right child, whichever ranks higher,
-    // to replace the current top. This then will need to be done
-    // recursively to the leaf level. So we swap the mData of the
-    // current top node all the way down to the leaf level.
-    LocHeapNode* poppedNode = top;
-    // top is losing a node in its subtree
-    top->mSize--;
-    if (top->mLeft || top->mRight) {
-        // if mLeft is NULL, mRight for sure is NOT NULL, take that;
-        // else if mRight is NULL, mLeft for sure is NOT, take that;
-        // else we take the address of whatever has higher ranking mData
-        LocHeapNode*& subTop = (NULL == top->mLeft) ? top->mRight :
-            ((NULL == top->mRight) ? top->mLeft :
-             (top->mLeft->outRanks(*(top->mRight)) ? top->mLeft : top->mRight));
-        // swap mData, the tree top gets updated with the new data.
-        top->swap(*subTop);
-        // pop out from the subtree
-        poppedNode = pop(subTop);
-    } else {
-        // if the top has only single node
-        // detach the poppedNode from the tree
-        // subTop is the reference of ether mLeft or mRight
-        // NOT a local stack pointer. so it MUST be NULL'ed here.
-        top = NULL;
+// parent of index i is (i - 1) / 2, children are 2i + 1 and 2i + 2.
+// The node moving around is held aside and written once into its final
+// slot, everything it passes is shifted by one level.
+void LocHeap::siftUp(uint32_t index) {
+    LocRankable* node = mArray[index];
+    while (index > 0) {
+        uint32_t parent = (index - 1) >> 1;
+        if (!node->outRanks(*mArray[parent])) {
+            break;
+        }
+        place(index, mArray[parent]);
+        index = parent;
     }
-
-    return poppedNode;
+    place(index, node);
 }
 
-// navigating through the tree and find the node that hass the input
-// data. Since this is a heap, we do recursive linear search.
-// returns the pointer to the node removed, which would be either the
-//         same as input (if successfully removed); or NULL (if failed).
-LocHeapNode* LocHeapNode::remove(LocHeapNode*& top, LocRankable& data) {
-    LocHeapNode* removedNode = NULL;
-    // this is the node, by address
-    if (&data == (LocRankable*)(top->mData)) {
-        // pop this node out
-        removedNode = pop(top);
-    } else if (!data.outRanks(*top->mData)) {
-        // subtrees might have this node
-        if (top->mLeft) {
-            removedNode = remove(top->mLeft, data);
+void LocHeap::siftDown(uint32_t index) {
+    LocRankable* node = mArray[index];
+    for (;;) {
+        uint32_t child = (index << 1) + 1;
+        if (child >= mSize) {
+            break;
         }
-        // if we did not find in mLeft, and mRight is not empty
-        if (!removedNode && top->mRight) {
-            removedNode = remove(top->mRight, data);
+        // take whichever child ranks higher
+        if (child + 1 < mSize && mArray[child + 1]->outRanks(*mArray[child])) {
+            child++;
         }
-
-        // top lost a node in its subtree
-        if (removedNode) {
-            top->mSize--;
+        if (!mArray[child]->outRanks(*node)) {
+            break;
         }
+        place(index, mArray[child]);
+        index = child;
     }
-
-    return removedNode;
+    place(index, node);
 }
 
-// checks if mSize is correct, AND this node is the highest ranking
-// of the entire subtree
-bool LocHeapNode::checkNodes() {
-    // size of the current subtree
-    int totalSize = mSize;
-    if (mLeft) {
-        // check the consistency of left subtree
-        if (mLeft->outRanks(*this) || !mLeft->checkNodes()) {
-            return false;
-        }
-        // subtract the size of left subtree (with subtree head)
-        totalSize -= mLeft->mSize;
-    }
-
-    if (mRight) {
-        // check the consistency of right subtree
-        if (mRight->outRanks(*this) || !mRight->checkNodes()) {
-            return false;
+LocRankable* LocHeap::removeAt(uint32_t index) {
+    LocRankable* node = mArray[index];
+    mSize--;
+    if (index != mSize) {
+        // fill the hole with the last node, which may have to go either way
+        place(index, mArray[mSize]);
+        if (index > 0 && mArray[index]->outRanks(*mArray[(index - 1) >> 1])) {
+            siftUp(index);
+        } else {
+            siftDown(index);
         }
-        // subtract the size of right subtree (with subtree head)
-        totalSize -= mRight->mSize;
     }
-
-    // for the tree nodes to consistent, totalSize must be 1 now
-    return totalSize == 1;
+    mArray[mSize] = NULL;
+    node->mHeapIndex = -1;
+    return node;
 }
 
 LocHeap::~LocHeap() {
-    if (mTree) {
-        delete mTree;
+    // nodes are owned by the client, just let go of them
+    for (uint32_t i = 0; i < mSize; i++) {
+        mArray[i]->mHeapIndex = -1;
     }
+    free(mArray);
 }
 
-void LocHeap::push(LocRankable& node) {
-    LocHeapNode* heapNode = new LocHeapNode(node);
-    if (!mTree) {
-        mTree = heapNode;
-    } else {
-        mTree->push(*heapNode);
+bool LocHeap::push(LocRankable& node) {
+    if (node.inHeap()) {
+        return false;
+    }
+    if (mSize == mCapacity) {
+        uint32_t capacity = mCapacity ? (mCapacity << 1) : LOC_HEAP_INIT_CAPACITY;
+        LocRankable** array = (LocRankable**)realloc(mArray, capacity * sizeof(LocRankable*));
+        if (NULL == array) {
+            // mArray is still intact, the heap just does not get node
+            return false;
+        }
+        mArray = array;
+        mCapacity = capacity;
     }
+    place(mSize, &node);
+    mSize++;
+    siftUp(mSize - 1);
+    return true;
 }
 
 LocRankable* LocHeap::peek() {
-    LocRankable* top = NULL;
-    if (mTree) {
-        top = mTree->mData;
-    }
-    return top;
+    return mSize ? mArray[0] : NULL;
 }
 
 LocRankable* LocHeap::pop() {
-    LocRankable* locNode = NULL;
-    if (mTree) {
-        // mTree may become NULL after this call
-        LocHeapNode* heapNode = LocHeapNode::pop(mTree);
-        locNode = heapNode->detachData();
-        delete heapNode;
-    }
-    return locNode;
+    return mSize ? removeAt(0) : NULL;
 }
 
 LocRankable* LocHeap::remove(LocRankable& rankable) {
-    LocRankable* locNode = NULL;
-    if (mTree) {
-        // mTree may become NULL after this call
-        LocHeapNode* heapNode = LocHeapNode::remove(mTree, rankable);
-        if (heapNode) {
-            locNode = heapNode->detachData();
-            delete heapNode;
-        }
+    int index = rankable.mHeapIndex;
+    // the index may belong to another heap, so make sure it is our node
+    if (index < 0 || (uint32_t)index >= mSize || mArray[index] != &rankable) {
+        return NULL;
+    }
+    return removeAt((uint32_t)index);
+}
+
+bool LocHeap::update(LocRankable& rankable) {
+    int index = rankable.mHeapIndex;
+    if (index < 0 || (uint32_t)index >= mSize || mArray[index] != &rankable) {
+        return false;
     }
-    return locNode;
+    if (index > 0 && rankable.outRanks(*mArray[(index - 1) >> 1])) {
+        siftUp((uint32_t)index);
+    } else {
+        siftDown((uint32_t)index);
+    }
+    return true;
 }
 
 #ifdef __LOC_UNIT_TEST__
+// checks that every node sits where its index says and that no node
+// outranks its parent
 bool LocHeap::checkTree() {
-    return ((NULL == mTree) || mTree->checkNodes());
+    for (uint32_t i = 0; i < mSize; i++) {
+        if (mArray[i]->mHeapIndex != (int)i) {
+            return false;
+        }
+        if (i > 0 && mArray[i]->outRanks(*mArray[(i - 1) >> 1])) {
+            return false;
+        }
+    }
+    return true;
 }
 uint32_t LocHeap::getTreeSize() {
-    return (NULL == mTree) ? 0 : mTree->getSize();
+    return mSize;
 }
 #endif
 
@@ -284,17 +170,22 @@ uint32_t LocHeap::getTreeSize() {
 class LocHeapDebug : public LocHeap {
 public:
     bool checkTree() {
-        return ((NULL == mTree) || mTree->checkNodes());
+        for (uint32_t i = 1; i < mSize; i++) {
+            if (mArray[i]->outRanks(*mArray[(i - 1) >> 1])) {
+                return false;
+            }
+        }
+        return true;
     }
 
     uint32_t getTreeSize() {
-        return (NULL == mTree) ? 0 : (mTree->getSize());
+        return mSize;
     }
 };
 
 class LocHeapDebugData : public LocRankable {
-    const int mID;
 public:
+    int mID;
     LocHeapDebugData(int id) : mID(id) {}
     inline virtual int ranks(LocRankable& rankable) {
         LocHeapDebugData* testData = dynamic_cast<LocHeapDebugData*>(&rankable);
@@ -302,9 +193,84 @@ public:
     }
 };
 
+static double getNowNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// arm / cancel rates the timer container sees, with 10k timers armed:
+// arm them all, cancel + re-arm random ones (what geofence / AGPS
+// restarts do), cancel them all in random order, then arm and expire.
+static bool benchmark(int timers, int churn) {
+    LocHeapDebug heap;
+    LocHeapDebugData** data = new LocHeapDebugData*[timers];
+    double start;
+    bool ok = true;
+
+    for (int i = 0; i < timers; i++) {
+        data[i] = new LocHeapDebugData(rand());
+    }
+
+    start = getNowNs();
+    for (int i = 0; i < timers; i++) {
+        heap.push(*data[i]);
+    }
+    printf("arm:          %8.1f ns/op\n", (getNowNs() - start) / timers);
+    ok = ok && heap.checkTree();
+    // a node already in the heap is not added again
+    ok = ok && !heap.push(*data[0]) && heap.getTreeSize() == (uint32_t)timers;
+
+    start = getNowNs();
+    for (int i = 0; i < churn; i++) {
+        LocHeapDebugData* timer = data[rand() % timers];
+        heap.remove(*timer);
+        timer->mID = rand();
+        heap.push(*timer);
+    }
+    printf("cancel+rearm: %8.1f ns/op\n", (getNowNs() - start) / churn);
+    ok = ok && heap.checkTree() && heap.getTreeSize() == (uint32_t)timers;
+
+    start = getNowNs();
+    for (int i = 0; i < timers; i++) {
+        int j = rand() % timers;
+        LocHeapDebugData* tmp = data[i];
+        data[i] = data[j];
+        data[j] = tmp;
+    }
+    for (int i = 0; i < timers; i++) {
+        if (heap.remove(*data[i]) != data[i]) {
+            ok = false;
+        }
+    }
+    printf("cancel:       %8.1f ns/op (incl. shuffle)\n", (getNowNs() - start) / timers);
+    ok = ok && heap.getTreeSize() == 0;
+
+    for (int i = 0; i < timers; i++) {
+        heap.push(*data[i]);
+    }
+    start = getNowNs();
+    int last = -1;
+    for (LocRankable* node = heap.pop(); NULL != node; node = heap.pop()) {
+        LocHeapDebugData* timer = (LocHeapDebugData*)node;
+        if (timer->mID < last) {
+            ok = false;
+        }
+        last = timer->mID;
+    }
+    printf("expire:       %8.1f ns/op\n", (getNowNs() - start) / timers);
+
+    for (int i = 0; i < timers; i++) {
+        delete data[i];
+    }
+    delete[] data;
+    return ok;
+}
+
 // For Linux command line testing:
 // compilation: g++ -D__LOC_HOST_DEBUG__ -D__LOC_DEBUG__ -g -I. -I../../../../vendor/qcom/proprietary/gps-internal/unit-tests/fakes_for_host -I../../../../system/core/include LocHeap.cpp
 // test: valgrind --leak-check=full ./a.out 100
+// benchmark: ./a.out 0 10000
 int main(int argc, char** argv) {
     srand(time(NULL));
     int tries = atoi(argv[1]);
@@ -348,6 +314,15 @@ int main(int argc, char** argv) {
         delete data;
     }
 
+    if (argc > 2) {
+        int timers = atoi(argv[2]);
+        if (!benchmark(timers, timers * 10)) {
+            printf("!!!!!!!!!!benchmark heap check failed!!!!!!!\n");
+        } else {
+            printf("benchmark success!\n");
+        }
+    }
+
     return 0;
 }
 
@@ -30,11 +30,17 @@
 #define __LOC_HEAP__
 
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
 // abstract class to be implemented by client to provide a rankable class
 class LocRankable {
+    friend class LocHeap;
+    // slot of this obj in the heap array, -1 when not in any heap.
+    // Lets the heap find an obj without searching for it.
+    int mHeapIndex;
 public:
+    inline LocRankable() : mHeapIndex(-1) {}
     virtual inline ~LocRankable() {}
 
     // method to rank objects of such type for sorting purposes.
@@ -46,29 +52,44 @@ public:
 
     // convenient method to rank objects of such type for sorting purposes.
     inline bool outRanks(LocRankable& rankable) { return ranks(rankable) > 0; }
-};
 
-// opaque class to provide service implementation.
-class LocHeapNode;
+    // true if the obj currently sits in a heap
+    inline bool inHeap() const { return mHeapIndex >= 0; }
+};
 
-// a heap whose left and right children are not sorted. It is sorted only vertically,
-// i.e. parent always ranks higher than children, if they exist. Ranking algorithm is
-// implemented in Rankable. The reason that there is no sort between children is to
-// help beter balance the tree with lower cost. When a node is pushed to the tree,
-// it is guaranteed that the subtree that is smaller gets to have the new node.
+// an array backed binary heap, sorted only vertically, i.e. parent always
+// ranks higher than children, if they exist. Ranking algorithm is implemented
+// in Rankable. Each node keeps its own array index, so remove() and update()
+// go straight to the node and only sift it up or down, O(log n). The array
+// grows by doubling and is reused, so push does not allocate per node.
 class LocHeap {
 protected:
-    LocHeapNode* mTree;
+    LocRankable** mArray;
+    uint32_t mSize;
+    uint32_t mCapacity;
+
+    // move the node at index up / down until the ranking holds again
+    void siftUp(uint32_t index);
+    void siftDown(uint32_t index);
+    // place node at index and record the index in the node
+    inline void place(uint32_t index, LocRankable* node) {
+        mArray[index] = node;
+        node->mHeapIndex = (int)index;
+    }
+    // take the node at index out of the array, keeping the heap sorted
+    LocRankable* removeAt(uint32_t index);
 public:
-    inline LocHeap() : mTree(NULL) {}
+    inline LocHeap() : mArray(NULL), mSize(0), mCapacity(0) {}
     ~LocHeap();
 
-    // push keeps the tree sorted by rank, it also tries to balance the
-    // tree by adding the new node to the smaller of the subtrees.
+    // push keeps the tree sorted by rank.
     // node is reference to an obj that is managed by client, that client
     //      creates and destroyes. The destroy should happen after the
-    //      node is popped out from the heap.
-    void push(LocRankable& node);
+    //      node is popped out from the heap. A node can only be in one
+    //      heap at a time; pushing a node already in a heap is ignored.
+    // Returns true if node was added; false if it already is in a heap or
+    //         the heap could not grow, in which case node is not in it.
+    bool push(LocRankable& node);
 
     // Peeks the node data on tree top, which has currently the highest ranking
     // There is no change the tree structure with this operation
@@ -76,17 +97,22 @@ public:
     //         the tree top.
     LocRankable* peek();
 
-    // pop keeps the tree sorted by rank, but it does not try to balance
-    // the tree.
+    // pop keeps the tree sorted by rank.
     // Return - pointer to the node popped out, or NULL if heap is already empty
     LocRankable* pop();
 
-    // navigating through the tree and find the node that ranks the same
-    // as the input data, then remove it from the tree. Rank is implemented
-    // by rankable obj.
-    // returns the pointer to the node removed; or NULL (if failed).
+    // remove the given node from the tree, found by its stored index.
+    // returns the pointer to the node removed; or NULL (if it is not in
+    // this heap).
     LocRankable* remove(LocRankable& rankable);
 
+    // re-sort the given node after its ranking has changed.
+    // returns false if the node is not in this heap.
+    bool update(LocRankable& rankable);
+
+    inline bool empty() const { return 0 == mSize; }
+    inline uint32_t size() const { return mSize; }
+
 #ifdef __LOC_UNIT_TEST__
     bool checkTree();
     uint32_t getTreeSize();
@@ -0,0 +1,103 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#define LOG_NDDEBUG 0
+#define LOG_TAG "LocSvc_LocPool"
+
+#include <new>
+#include <LocPool.h>
+#include <platform_lib_includes.h>
+
+// the stats are logged every so many gets
+#define LOC_POOL_DUMP_PERIOD 1024
+
+void* LocPool::get(size_t size) {
+    void* block = NULL;
+    bool toDump = false;
+
+    if (size == mObjSize) {
+        pthread_mutex_lock(&mMutex);
+        if (mFree) {
+            block = mFree;
+            mFree = *(void**)block;
+            mFreeCount--;
+            mHits++;
+        }
+        mGets++;
+        if (++mInUse > mPeakInUse) {
+            mPeakInUse = mInUse;
+        }
+        toDump = (0 == (mGets % LOC_POOL_DUMP_PERIOD));
+        pthread_mutex_unlock(&mMutex);
+
+        if (toDump) {
+            dump();
+        }
+    }
+
+    if (NULL == block) {
+        block = ::operator new(size);
+    }
+    return block;
+}
+
+void LocPool::put(void* block, size_t size) {
+    if (NULL == block) {
+        return;
+    }
+
+    if (size == mObjSize) {
+        pthread_mutex_lock(&mMutex);
+        mInUse--;
+        if (mFreeCount < mMaxFree) {
+            *(void**)block = mFree;
+            mFree = block;
+            mFreeCount++;
+            block = NULL;
+        }
+        pthread_mutex_unlock(&mMutex);
+    }
+
+    if (block) {
+        ::operator delete(block);
+    }
+}
+
+void LocPool::dump() {
+    pthread_mutex_lock(&mMutex);
+    uint32_t gets = mGets;
+    uint32_t hits = mHits;
+    uint32_t inUse = mInUse;
+    uint32_t peakInUse = mPeakInUse;
+    uint32_t freeCount = mFreeCount;
+    pthread_mutex_unlock(&mMutex);
+
+    LOC_LOGD("%s: %s (%u bytes) - %u gets, %u%% recycled, %u in use, peak %u, %u free",
+             __FUNCTION__, mName, (uint32_t)mObjSize, gets,
+             gets ? (uint32_t)((uint64_t)hits * 100 / gets) : 0,
+             inUse, peakInUse, freeCount);
+}
@@ -0,0 +1,82 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __LOC_POOL_H__
+#define __LOC_POOL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+// A freelist of same size memory blocks for one type of objs, typically a
+// LocMsg that gets created in one thread and deleted in the MsgTask thread
+// at a steady rate. Freed blocks are kept for reuse, up to mMaxFree of them;
+// blocks of any other size go straight to the heap. Both get() and put()
+// may be called from any thread.
+// This is a plain aggregate, so that the pools, defined by LOC_POOL_DEFINE(),
+// are statically initialized and usable before any constructor runs.
+struct LocPool {
+    pthread_mutex_t mMutex;
+    // freed blocks, linked through their first word
+    void* mFree;
+    uint32_t mFreeCount;
+    // stats
+    uint32_t mGets;
+    uint32_t mHits;
+    uint32_t mInUse;
+    uint32_t mPeakInUse;
+    const char* const mName;
+    const size_t mObjSize;
+    const uint32_t mMaxFree;
+
+    // get a block of size bytes, recycled if possible
+    void* get(size_t size);
+    // return a block obtained from get() with the same size
+    void put(void* block, size_t size);
+    // log the stats
+    void dump();
+};
+
+// Declares, inside a class body, the operator new / delete that route the
+// allocation of objs of the class through its LocPool. The class must have
+// a virtual destructor if it is deleted through a base pointer, e.g. LocMsg.
+#define LOC_POOL_DECLARE(T)                                                  \
+    static LocPool sPool;                                                    \
+    inline static void* operator new(size_t size) {                          \
+        return sPool.get(size);                                              \
+    }                                                                        \
+    inline static void operator delete(void* block, size_t size) {           \
+        sPool.put(block, size);                                              \
+    }
+
+// Defines the LocPool of a class, keeping up to maxFree freed objs.
+#define LOC_POOL_DEFINE(T, maxFree)                                          \
+    LocPool T::sPool = {                                                     \
+        PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0, 0, 0, 0, #T, sizeof(T), (maxFree) \
+    }
+
+#endif //__LOC_POOL_H__
@@ -36,10 +36,14 @@
 #include <sys/epoll.h>
 #include <LocTimer.h>
 #include <LocHeap.h>
+#include <LocTimerWheel.h>
 #include <LocThread.h>
 #include <LocSharedLock.h>
 #include <MsgTask.h>
 
+// mArmedTick of a container whose fd is not set
+#define LOC_TIMER_DISARMED ((uint64_t)-1)
+
 #ifdef __HOST_UNIT_TEST__
 #define EPOLLWAKEUP 0
 #define CLOCK_BOOTTIME CLOCK_MONOTONIC
@@ -69,7 +73,11 @@ LocTimerContainer - core of the timer service. It is a container (derived from
                     each (those that expire the soonest) to kernel via services
                     provided by LocTimerPollTask. All the heap management on the
                     LocTimerDelegate objs are done in the MsgTask context, such
-                    that synchronization is ensured.
+                    that synchronization is ensured. Instead of the heap, a
+                    container can keep its timers in a LocTimerWheel, rounding
+                    their time outs up to the wheel tick, so that timers due
+                    within one tick expire together on a single wakeup. None
+                    does by default, see loc_timer_set_slack().
 LocTimerPollTask - is a class that wraps timerfd and epoll POXIS APIs. It also
                    both implements LocRunnalbe with epoll_wait() in the run()
                    method. It is also a LocThread client, so as to loop the run
@@ -100,10 +108,28 @@ class LocTimerContainer : public LocHeap {
     static MsgTask* mMsgTask;
     // Poll task to provide epoll call and threading to poll.
     static LocTimerPollTask* mPollTask;
+    // wheel tick of each container before it gets created, 0 for a heap
+    static uint32_t mSwTickMs;
+    static uint32_t mHwTickMs;
     // timer / alarm fd
     int mDevFd;
+    // name of the container in the logs
+    const char* mName;
+    // timer wheel in place of the heap, NULL if the heap is used
+    LocTimerWheel* mWheel;
+    uint32_t mTickMs;
+    // wheel tick the fd is set to, LOC_TIMER_DISARMED if none
+    uint64_t mArmedTick;
+    // wakeup counters, and those of the current / last minute
+    uint32_t mWakeups;
+    uint32_t mExpirations;
+    uint32_t mMinWakeups;
+    uint32_t mMinExpirations;
+    uint32_t mLastMinWakeups;
+    uint32_t mLastMinExpirations;
+    uint64_t mMinStartMs;
     // ctor
-    LocTimerContainer(bool wakeOnExpire);
+    LocTimerContainer(bool wakeOnExpire, uint32_t tickMs);
     // dtor
     ~LocTimerContainer();
     static MsgTask* getMsgTaskLocked();
@@ -112,10 +138,21 @@ class LocTimerContainer : public LocHeap {
     LocTimerDelegate* popIfOutRanks(LocTimerDelegate& timer);
     // update the timer POSIX calls with updated soonest timer spec
     void updateSoonestTime(LocTimerDelegate* priorTop);
+    // wheel counterparts of the heap push / remove / pop
+    void wheelAdd(LocTimerDelegate& timer);
+    void wheelRemove(LocTimerDelegate& timer);
+    uint32_t wheelExpire();
+    // update the timer POSIX calls with the soonest tick of the wheel
+    void updateWheelTime();
+    // count a wakeup and the timers expired on it
+    void countWakeup(uint32_t expirations);
 
 public:
     // factory method to control the creation of mSwTimers / mHwTimers
     static LocTimerContainer* get(bool wakeOnExpire);
+    // select heap (0) or wheel tick for a container not yet created
+    static bool setTick(bool wakeOnExpire, uint32_t tickMs);
+    static void getStats(bool wakeOnExpire, loc_timer_stats& stats);
 
     LocTimerDelegate* getSoonestTimer();
     int getTimerFd();
@@ -170,8 +207,9 @@ public:
 // Internal class of timer obj. It gets born when client calls LocTimer::start();
 // and gets deleted when client calls LocTimer::stop() or when the it expire()'s.
 // This class implements LocRankable::ranks() so that when an obj is added into
-// the container (of LocHeap), it gets placed in sorted order.
-class LocTimerDelegate : public LocRankable {
+// the container (of LocHeap), it gets placed in sorted order. It is also a
+// LocWheelNode, for containers that keep their timers in a LocTimerWheel.
+class LocTimerDelegate : public LocRankable, public LocWheelNode {
     friend class LocTimerContainer;
     friend class LocTimer;
     LocTimer* mClient;
@@ -203,12 +241,25 @@ LocTimerContainer* LocTimerContainer::mSwTimers = NULL;
 LocTimerContainer* LocTimerContainer::mHwTimers = NULL;
 MsgTask* LocTimerContainer::mMsgTask = NULL;
 LocTimerPollTask* LocTimerContainer::mPollTask = NULL;
+uint32_t LocTimerContainer::mSwTickMs = LOC_TIMER_DEFAULT_SLACK_MSEC;
+uint32_t LocTimerContainer::mHwTickMs = 0;
+
+static inline uint64_t getNowMs() {
+    struct timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
 
 // ctor - initialize timer heaps
 // A container for swTimer (timer) is created, when wakeOnExpire is true; or
 // HwTimer (alarm), when wakeOnExpire is false.
-LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
-    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)) {
+LocTimerContainer::LocTimerContainer(bool wakeOnExpire, uint32_t tickMs) :
+    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)),
+    mName(wakeOnExpire ? "alarms" : "timers"),
+    mWheel(tickMs ? new LocTimerWheel(getNowMs() / tickMs) : NULL),
+    mTickMs(tickMs), mArmedTick(LOC_TIMER_DISARMED),
+    mWakeups(0), mExpirations(0), mMinWakeups(0), mMinExpirations(0),
+    mLastMinWakeups(0), mLastMinExpirations(0), mMinStartMs(getNowMs()) {
 
     if ((-1 == mDevFd) && (errno == EINVAL)) {
         LOC_LOGW("%s: timerfd_create failure, fallback to CLOCK_MONOTONIC - %s",
@@ -230,6 +281,7 @@ LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
 inline
 LocTimerContainer::~LocTimerContainer() {
     close(mDevFd);
+    delete mWheel;
 }
 
 LocTimerContainer* LocTimerContainer::get(bool wakeOnExpire) {
@@ -240,7 +292,8 @@ LocTimerContainer* LocTimerContainer::get(bool wakeOnExpire) {
         pthread_mutex_lock(&mMutex);
         // let's check one more time to be safe
         if (!container) {
-            container = new LocTimerContainer(wakeOnExpire);
+            container = new LocTimerContainer(wakeOnExpire,
+                                              wakeOnExpire ? mHwTickMs : mSwTickMs);
             // timerfd_create failure
             if (-1 == container->getTimerFd()) {
                 delete container;
@@ -252,6 +305,30 @@ LocTimerContainer* LocTimerContainer::get(bool wakeOnExpire) {
     return container;
 }
 
+bool LocTimerContainer::setTick(bool wakeOnExpire, uint32_t tickMs) {
+    pthread_mutex_lock(&mMutex);
+    // the choice is fixed once the container exists
+    bool success = (NULL == (wakeOnExpire ? mHwTimers : mSwTimers));
+    if (success) {
+        (wakeOnExpire ? mHwTickMs : mSwTickMs) = tickMs;
+    }
+    pthread_mutex_unlock(&mMutex);
+    return success;
+}
+
+// the counters are only written in the MsgTask context, a read here may be
+// one wakeup behind, which is fine for statistics.
+void LocTimerContainer::getStats(bool wakeOnExpire, loc_timer_stats& stats) {
+    LocTimerContainer* container = wakeOnExpire ? mHwTimers : mSwTimers;
+    memset(&stats, 0, sizeof(stats));
+    if (container) {
+        stats.wakeups = container->mWakeups;
+        stats.expirations = container->mExpirations;
+        stats.wakeups_per_min = container->mLastMinWakeups;
+        stats.expirations_per_min = container->mLastMinExpirations;
+    }
+}
+
 MsgTask* LocTimerContainer::getMsgTaskLocked() {
     // it is cheap to check pointer first than locking mutext unconditionally
     if (!mMsgTask) {
@@ -305,18 +382,109 @@ void LocTimerContainer::updateSoonestTime(LocTimerDelegate* priorTop) {
     }
 }
 
+// timer wheel ticks are counted in mTickMs since boot. A timer gets the
+// first tick at or after its time out, so it never expires early. Only a
+// timer landing before the armed tick needs the fd updated; timers landing
+// on or after it just join the wheel.
+void LocTimerContainer::wheelAdd(LocTimerDelegate& timer) {
+    uint64_t futureMs = (uint64_t)timer.mFutureTime.tv_sec * 1000 +
+        (timer.mFutureTime.tv_nsec + 999999) / 1000000;
+    uint64_t tick = (futureMs + mTickMs - 1) / mTickMs;
+
+    // an idle wheel may be far behind, catch it up before adding
+    mWheel->reset(getNowMs() / mTickMs);
+    mWheel->add((LocWheelNode&)timer, tick);
+    if (tick < mArmedTick) {
+        updateWheelTime();
+    }
+}
+
+void LocTimerContainer::wheelRemove(LocTimerDelegate& timer) {
+    // the fd needs no update, unless the timer was the one it is set for
+    if (mWheel->remove((LocWheelNode&)timer) && timer.getTick() == mArmedTick) {
+        updateWheelTime();
+    }
+}
+
+uint32_t LocTimerContainer::wheelExpire() {
+    uint32_t expirations = 0;
+    LocWheelNode* node = mWheel->advance(getNowMs() / mTickMs);
+    while (node) {
+        LocTimerDelegate* timer = static_cast<LocTimerDelegate*>(node);
+        // the timer delegate obj gets deleted only after this call, in the
+        // MsgTimerRemove msg its expire() sends, so the list stays intact.
+        node = node->getNext();
+        timer->expire();
+        expirations++;
+    }
+    // expire() has disarmed the fd
+    mArmedTick = LOC_TIMER_DISARMED;
+    updateWheelTime();
+    return expirations;
+}
+
+void LocTimerContainer::updateWheelTime() {
+    uint64_t tick;
+    struct itimerspec delay = {0};
+
+    if (!mWheel->nextTick(tick)) {
+        if (LOC_TIMER_DISARMED != mArmedTick) {
+            mPollTask->removePoll(*this);
+            mArmedTick = LOC_TIMER_DISARMED;
+            timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
+        }
+    } else if (tick != mArmedTick) {
+        uint64_t tickMs = tick * mTickMs;
+        // do this first to avoid race condition, in case settime is called
+        // with too small an interval
+        mPollTask->addPoll(*this);
+        mArmedTick = tick;
+        delay.it_value.tv_sec = tickMs / 1000;
+        delay.it_value.tv_nsec = (tickMs % 1000) * 1000000;
+        timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
+    }
+}
+
+// each expire() is one wakeup of the poll thread. Once a minute the counts
+// of the minute are kept for loc_timer_get_stats() and logged.
+void LocTimerContainer::countWakeup(uint32_t expirations) {
+    uint64_t nowMs = getNowMs();
+
+    mWakeups++;
+    mExpirations += expirations;
+    mMinWakeups++;
+    mMinExpirations += expirations;
+    if (nowMs - mMinStartMs >= 60000) {
+        mLastMinWakeups = mMinWakeups;
+        mLastMinExpirations = mMinExpirations;
+        LOC_LOGD("%s: %s - %u wakeups, %u expirations in the last minute",
+                 __FUNCTION__, mName, mLastMinWakeups, mLastMinExpirations);
+        mMinWakeups = 0;
+        mMinExpirations = 0;
+        mMinStartMs = nowMs;
+    }
+}
+
 // all the heap management is done in the MsgTask context.
 inline
 void LocTimerContainer::add(LocTimerDelegate& timer) {
     struct MsgTimerPush : public LocMsg {
         LocTimerContainer* mTimerContainer;
-        LocHeapNode* mTree;
         LocTimerDelegate* mTimer;
         inline MsgTimerPush(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
+            if (mTimerContainer->mWheel) {
+                mTimerContainer->wheelAdd(*mTimer);
+                return;
+            }
             LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
-            mTimerContainer->push((LocRankable&)(*mTimer));
+            if (!mTimerContainer->push((LocRankable&)(*mTimer))) {
+                // the timer will not expire, stop() still deletes it
+                LOC_LOGE("%s: %s - unable to add timer %p",
+                         __FUNCTION__, mTimerContainer->mName, mTimer);
+                return;
+            }
             mTimerContainer->updateSoonestTime(priorTop);
         }
     };
@@ -332,10 +500,17 @@ void LocTimerContainer::remove(LocTimerDelegate& timer) {
         inline MsgTimerRemove(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
+            if (mTimerContainer->mWheel) {
+                mTimerContainer->wheelRemove(*mTimer);
+                // all timers are deleted here, and only here.
+                delete mTimer;
+                return;
+            }
             LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
 
             // update soonest timer only if mTimer is actually removed from
-            // mTimerContainer AND mTimer is not priorTop.
+            // mTimerContainer AND mTimer is not priorTop. The delegate knows
+            // its own heap slot, so this does not search the heap.
             if (priorTop == ((LocHeap*)mTimerContainer)->remove((LocRankable&)*mTimer)) {
                 // if passing in NULL, we tell updateSoonestTime to update
                 // kernel with the current top timer interval.
@@ -358,7 +533,12 @@ void LocTimerContainer::expire() {
         inline MsgTimerExpire(LocTimerContainer& container) :
             LocMsg(), mTimerContainer(&container) {}
         inline virtual void proc() const {
+            if (mTimerContainer->mWheel) {
+                mTimerContainer->countWakeup(mTimerContainer->wheelExpire());
+                return;
+            }
             struct timespec now;
+            uint32_t expirations = 0;
             // get time spec of now
             clock_gettime(CLOCK_BOOTTIME, &now);
             LocTimerDelegate timerOfNow(now);
@@ -369,8 +549,10 @@ void LocTimerContainer::expire() {
                  timer = mTimerContainer->popIfOutRanks(timerOfNow)) {
                 // the timer delegate obj will be deleted before the return of this call
                 timer->expire();
+                expirations++;
             }
             mTimerContainer->updateSoonestTime(NULL);
+            mTimerContainer->countWakeup(expirations);
         }
     };
 
@@ -382,7 +564,7 @@ void LocTimerContainer::expire() {
 
 LocTimerDelegate* LocTimerContainer::popIfOutRanks(LocTimerDelegate& timer) {
     LocTimerDelegate* poppedNode = NULL;
-    if (mTree && !timer.outRanks(*peek())) {
+    if (!empty() && !timer.outRanks(*peek())) {
         poppedNode = (LocTimerDelegate*)(pop());
     }
 
@@ -637,6 +819,18 @@ void loc_timer_stop(void*&  handle)
     }
 }
 
+bool loc_timer_set_slack(bool wake_on_expire, uint32_t tick_msec)
+{
+    return LocTimerContainer::setTick(wake_on_expire, tick_msec);
+}
+
+void loc_timer_get_stats(bool wake_on_expire, loc_timer_stats* stats)
+{
+    if (stats) {
+        LocTimerContainer::getStats(wake_on_expire, *stats);
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////
 // This section above wraps for the C style APIs
 //////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,293 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+#include <LocTimerWheel.h>
+
+// width of one slot, in ticks, at the given level
+#define LOC_WHEEL_SLOT_TICKS(level) (1ULL << (LOC_WHEEL_LEVEL_BITS * (level)))
+// farthest distance from the current tick the wheel can hold
+#define LOC_WHEEL_MAX_DELTA (LOC_WHEEL_SLOT_TICKS(LOC_WHEEL_LEVELS) - 1)
+
+LocTimerWheel::LocTimerWheel(uint64_t startTick) :
+    mCurTick(startTick), mSize(0) {
+    memset(mLevelSize, 0, sizeof(mLevelSize));
+    memset(mSlots, 0, sizeof(mSlots));
+}
+
+void LocTimerWheel::link(LocWheelNode& node) {
+    // overdue nodes go into the current slot and take its tick, so that
+    // nextTick() never reports a tick the wheel is already past. Nodes
+    // beyond the reach of the top level go into its farthest slot, to be
+    // placed again later.
+    if (node.mTick < mCurTick) {
+        node.mTick = mCurTick;
+    }
+    uint64_t tick = node.mTick;
+    uint64_t delta = tick - mCurTick;
+    if (delta > LOC_WHEEL_MAX_DELTA) {
+        delta = LOC_WHEEL_MAX_DELTA;
+        tick = mCurTick + delta;
+    }
+
+    int level = 0;
+    while (level < LOC_WHEEL_LEVELS - 1 && delta >= LOC_WHEEL_SLOT_TICKS(level + 1)) {
+        level++;
+    }
+    LocWheelNode** head =
+        &mSlots[level][(tick >> (LOC_WHEEL_LEVEL_BITS * level)) & LOC_WHEEL_SLOT_MASK];
+
+    node.mNext = *head;
+    if (node.mNext) {
+        node.mNext->mPprev = &node.mNext;
+    }
+    node.mPprev = head;
+    *head = &node;
+    node.mLevel = level;
+    mLevelSize[level]++;
+}
+
+void LocTimerWheel::unlink(LocWheelNode& node) {
+    *node.mPprev = node.mNext;
+    if (node.mNext) {
+        node.mNext->mPprev = node.mPprev;
+    }
+    mLevelSize[node.mLevel]--;
+    node.mNext = NULL;
+    node.mPprev = NULL;
+    node.mLevel = -1;
+}
+
+void LocTimerWheel::cascade(int level, uint32_t slot) {
+    LocWheelNode* node = mSlots[level][slot];
+    mSlots[level][slot] = NULL;
+    while (node) {
+        LocWheelNode* next = node->mNext;
+        mLevelSize[level]--;
+        link(*node);
+        node = next;
+    }
+}
+
+void LocTimerWheel::add(LocWheelNode& node, uint64_t tick) {
+    if (!node.inWheel()) {
+        node.mTick = tick;
+        link(node);
+        mSize++;
+    }
+}
+
+bool LocTimerWheel::remove(LocWheelNode& node) {
+    bool removed = false;
+    if (node.inWheel()) {
+        unlink(node);
+        mSize--;
+        removed = true;
+    }
+    return removed;
+}
+
+LocWheelNode* LocTimerWheel::advance(uint64_t nowTick) {
+    LocWheelNode* expired = NULL;
+
+    while (mSize > 0 && mCurTick <= nowTick) {
+        // everything in the current level 0 slot is due
+        LocWheelNode** head = &mSlots[0][mCurTick & LOC_WHEEL_SLOT_MASK];
+        while (*head) {
+            LocWheelNode* node = *head;
+            unlink(*node);
+            mSize--;
+            node->mNext = expired;
+            expired = node;
+        }
+
+        if (0 == mLevelSize[0]) {
+            // nothing more until the next revolution, skip the empty slots
+            uint64_t nextRevolution = (mCurTick | LOC_WHEEL_SLOT_MASK) + 1;
+            mCurTick = nextRevolution <= nowTick ? nextRevolution : nowTick + 1;
+        } else {
+            mCurTick++;
+        }
+
+        // starting a level 0 revolution, pull the next slot of each level
+        // above down, for as long as the level below also wrapped around.
+        // This is done as soon as the boundary is reached, so that slots
+        // a level above the current one never hold nodes due this revolution.
+        uint32_t slot = mCurTick & LOC_WHEEL_SLOT_MASK;
+        for (int level = 1; 0 == slot && level < LOC_WHEEL_LEVELS; level++) {
+            slot = (mCurTick >> (LOC_WHEEL_LEVEL_BITS * level)) & LOC_WHEEL_SLOT_MASK;
+            cascade(level, slot);
+        }
+    }
+
+    if (0 == mSize && mCurTick <= nowTick) {
+        mCurTick = nowTick + 1;
+    }
+
+    return expired;
+}
+
+// The first occupied slot of a level, counting from the current position,
+// holds the earliest nodes of that level. On level 0 the current slot itself
+// is due now; on the levels above the current slot was cascaded already, so
+// anything in it is a full revolution ahead and is looked at last.
+bool LocTimerWheel::nextTick(uint64_t& tick) const {
+    bool found = false;
+
+    for (int level = 0; level < LOC_WHEEL_LEVELS; level++) {
+        if (0 == mLevelSize[level]) {
+            continue;
+        }
+        uint32_t cur = (mCurTick >> (LOC_WHEEL_LEVEL_BITS * level)) & LOC_WHEEL_SLOT_MASK;
+        uint32_t first = (0 == level) ? 0 : 1;
+        for (uint32_t i = first; i < first + LOC_WHEEL_SLOTS; i++) {
+            const LocWheelNode* node = mSlots[level][(cur + i) & LOC_WHEEL_SLOT_MASK];
+            if (node) {
+                for (; node; node = node->mNext) {
+                    if (!found || node->mTick < tick) {
+                        tick = node->mTick;
+                        found = true;
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    return found;
+}
+
+void LocTimerWheel::reset(uint64_t startTick) {
+    if (0 == mSize) {
+        mCurTick = startTick;
+    }
+}
+
+#ifdef __LOC_DEBUG__
+#include <stdio.h>
+#include <stdlib.h>
+
+class LocWheelTest : public LocWheelNode {
+public:
+    const uint32_t mId;
+    inline LocWheelTest(uint32_t id) : LocWheelNode(), mId(id) {}
+};
+
+// a node added with its tick already passed is due on the current tick,
+// and nextTick() reports that tick rather than the passed one, which the
+// wheel would never reach again.
+static int testOverdue() {
+    LocTimerWheel wheel(1000);
+    LocWheelTest late(0), later(1);
+    uint64_t next = 0;
+
+    // an empty wheel moves on to the tick after the one advanced to
+    wheel.advance(1999);
+    wheel.add(late, 1500);
+    wheel.add(later, 2001);
+    if (!wheel.nextTick(next) || 2000 != next || 2000 != late.getTick()) {
+        printf("ERROR: overdue node reported at %llu, tick %llu\n",
+               (unsigned long long)next, (unsigned long long)late.getTick());
+        return 1;
+    }
+    if (NULL != wheel.advance(next - 1) || &late != wheel.advance(next) ||
+        !wheel.nextTick(next) || 2001 != next) {
+        printf("ERROR: overdue node not expired on tick 2000, next %llu\n",
+               (unsigned long long)next);
+        return 1;
+    }
+    wheel.remove(later);
+    printf("overdue node expired on tick 2000\n");
+    return 0;
+}
+
+// For Linux command line testing:
+// compilation: g++ -D__LOC_DEBUG__ -g -I. -o LocTimerWheel LocTimerWheel.cpp
+// execution: ./LocTimerWheel 0 10000
+//     1st arg is the seed, 2nd is the number of nodes. Nodes are spread over
+//     all levels, a quarter of them removed again, and the wheel is turned in
+//     random steps, checking every node expires on its own tick exactly once.
+//     Then a node is added with its tick already passed.
+int main(int argc, char** argv) {
+    unsigned int seed = (argc > 1) ? atoi(argv[1]) : 0;
+    uint32_t tries = (argc > 2) ? atoi(argv[2]) : 10000;
+    srand(seed);
+
+    LocTimerWheel wheel(12345);
+    LocWheelTest** nodes = new LocWheelTest*[tries];
+    bool* removed = new bool[tries];
+    uint64_t lastTick = 0;
+    for (uint32_t i = 0; i < tries; i++) {
+        nodes[i] = new LocWheelTest(i);
+        // mix of near and far ticks, so that every level gets some
+        uint64_t tick = 12345 + ((uint64_t)rand() % (1ULL << (6 * (1 + rand() % 4))));
+        wheel.add(*nodes[i], tick);
+        removed[i] = (0 == rand() % 4);
+        if (tick > lastTick) {
+            lastTick = tick;
+        }
+    }
+    for (uint32_t i = 0; i < tries; i++) {
+        if (removed[i] && !wheel.remove(*nodes[i])) {
+            printf("ERROR: node %u not in the wheel\n", i);
+            return 1;
+        }
+    }
+
+    uint32_t expiredCount = 0;
+    uint64_t now = 12345;
+    while (!wheel.empty()) {
+        uint64_t next = 0;
+        wheel.nextTick(next);
+        now += 1 + rand() % 200;
+        for (LocWheelNode* node = wheel.advance(now); node; ) {
+            LocWheelTest* test = (LocWheelTest*)node;
+            node = node->getNext();
+            if (removed[test->mId] || test->getTick() > now || test->getTick() < next) {
+                printf("ERROR: node %u tick %llu expired at %llu, next %llu\n", test->mId,
+                       (unsigned long long)test->getTick(), (unsigned long long)now,
+                       (unsigned long long)next);
+                return 1;
+            }
+            removed[test->mId] = true;
+            expiredCount++;
+        }
+    }
+
+    printf("%u nodes expired by tick %llu, last tick %llu\n", expiredCount,
+           (unsigned long long)now, (unsigned long long)lastTick);
+    for (uint32_t i = 0; i < tries; i++) {
+        if (!removed[i]) {
+            printf("ERROR: node %u never expired\n", i);
+        }
+        delete nodes[i];
+    }
+    delete[] nodes;
+    delete[] removed;
+    return testOverdue();
+}
+#endif
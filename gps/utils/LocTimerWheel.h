@@ -0,0 +1,108 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __LOC_TIMER_WHEEL__
+#define __LOC_TIMER_WHEEL__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// each level of the wheel has 2^LOC_WHEEL_LEVEL_BITS slots
+#define LOC_WHEEL_LEVEL_BITS 6
+#define LOC_WHEEL_SLOTS (1 << LOC_WHEEL_LEVEL_BITS)
+#define LOC_WHEEL_SLOT_MASK (LOC_WHEEL_SLOTS - 1)
+#define LOC_WHEEL_LEVELS 4
+
+// base class of the objs a LocTimerWheel holds. The wheel links the objs
+// through these fields, so adding / removing an obj never allocates.
+class LocWheelNode {
+    friend class LocTimerWheel;
+    LocWheelNode* mNext;
+    // points at whichever pointer points at this node, slot head or mNext
+    LocWheelNode** mPprev;
+    uint64_t mTick;
+    // level of the wheel this node sits in, -1 when not in any wheel
+    int mLevel;
+public:
+    inline LocWheelNode() : mNext(NULL), mPprev(NULL), mTick(0), mLevel(-1) {}
+
+    // true if the obj currently sits in a wheel
+    inline bool inWheel() const { return mLevel >= 0; }
+    // tick the obj expires on
+    inline uint64_t getTick() const { return mTick; }
+    // next node in the list returned by LocTimerWheel::advance()
+    inline LocWheelNode* getNext() const { return mNext; }
+};
+
+// A hierarchical timer wheel. Level 0 has one slot per tick, each level above
+// has slots LOC_WHEEL_SLOTS times as wide as the level below. A node goes into
+// the lowest level that covers its distance from the current tick; when the
+// wheel turns past a slot boundary of an upper level, that slot's nodes are
+// moved down a level. add() and remove() are O(1) regardless of the number of
+// nodes, and all nodes due on the same tick expire together.
+// The wheel does not know about time; ticks are whatever unit the client uses.
+class LocTimerWheel {
+    // the tick the next advance() starts from
+    uint64_t mCurTick;
+    uint32_t mSize;
+    uint32_t mLevelSize[LOC_WHEEL_LEVELS];
+    LocWheelNode* mSlots[LOC_WHEEL_LEVELS][LOC_WHEEL_SLOTS];
+
+    // put the node into the slot matching its tick relative to mCurTick
+    void link(LocWheelNode& node);
+    void unlink(LocWheelNode& node);
+    // move the nodes in the given slot of the given level down the wheel
+    void cascade(int level, uint32_t slot);
+public:
+    LocTimerWheel(uint64_t startTick);
+
+    // add a node that expires on the given tick. Ticks earlier than the
+    // current one expire on the next advance(). Adding a node already in a
+    // wheel is ignored.
+    void add(LocWheelNode& node, uint64_t tick);
+
+    // remove the given node from the wheel.
+    // returns false if the node is not in this wheel.
+    bool remove(LocWheelNode& node);
+
+    // turn the wheel up to and including nowTick. Returns the nodes that
+    // are due, linked through getNext(), or NULL if none is. The returned
+    // nodes are no longer in the wheel.
+    LocWheelNode* advance(uint64_t nowTick);
+
+    // get the earliest tick any node in the wheel expires on.
+    // returns false if the wheel is empty.
+    bool nextTick(uint64_t& tick) const;
+
+    // restart the wheel from the given tick, only if it is empty
+    void reset(uint64_t startTick);
+
+    inline bool empty() const { return 0 == mSize; }
+    inline uint32_t size() const { return mSize; }
+};
+
+#endif //__LOC_TIMER_WHEEL__
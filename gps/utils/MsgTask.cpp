@@ -31,17 +31,13 @@
 
 #include <unistd.h>
 #include <MsgTask.h>
-#include <msg_q.h>
 #include <loc_log.h>
 #include <platform_lib_includes.h>
 
-static void LocMsgDestroy(void* msg) {
-    delete (LocMsg*)msg;
-}
-
 MsgTask::MsgTask(LocThread::tCreate tCreator,
                  const char* threadName, bool joinable) :
-    mQ(msg_q_init2()), mThread(new LocThread()) {
+    mThread(new LocThread()) {
+    mpsc_q_init(&mQ);
     if (!mThread->start(tCreator, threadName, this, joinable)) {
         delete mThread;
         mThread = NULL;
@@ -49,7 +45,8 @@ MsgTask::MsgTask(LocThread::tCreate tCreator,
 }
 
 MsgTask::MsgTask(const char* threadName, bool joinable) :
-    mQ(msg_q_init2()), mThread(new LocThread()) {
+    mThread(new LocThread()) {
+    mpsc_q_init(&mQ);
     if (!mThread->start(threadName, this, joinable)) {
         delete mThread;
         mThread = NULL;
@@ -57,12 +54,15 @@ MsgTask::MsgTask(const char* threadName, bool joinable) :
 }
 
 MsgTask::~MsgTask() {
-    msg_q_flush((void*)mQ);
-    msg_q_destroy((void**)&mQ);
+    // the thread is gone, drop whatever was never processed
+    for (mpsc_q_node* node = mpsc_q_try_pop(&mQ); NULL != node;
+         node = mpsc_q_try_pop(&mQ)) {
+        delete static_cast<LocMsg*>(node);
+    }
 }
 
 void MsgTask::destroy() {
-    msg_q_unblock((void*)mQ);
+    mpsc_q_unblock(&mQ);
     if (mThread) {
         LocThread* thread = mThread;
         mThread = NULL;
@@ -73,7 +73,11 @@ void MsgTask::destroy() {
 }
 
 void MsgTask::sendMsg(const LocMsg* msg) const {
-    msg_q_snd((void*)mQ, (void*)msg, LocMsgDestroy);
+    LocMsg* locMsg = const_cast<LocMsg*>(msg);
+    if (0 != mpsc_q_push(&mQ, locMsg)) {
+        LOC_LOGE("%s:%d] msg task unblocked, dropping msg\n", __func__, __LINE__);
+        delete locMsg;
+    }
 }
 
 void MsgTask::prerun() {
@@ -83,11 +87,9 @@ void MsgTask::prerun() {
 
 bool MsgTask::run() {
     LOC_LOGV("MsgTask::loop() listening ...\n");
-    LocMsg* msg;
-    msq_q_err_type result = msg_q_rcv((void*)mQ, (void **)&msg);
-    if (eMSG_Q_SUCCESS != result) {
-        LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
-                 loc_get_msg_q_status(result));
+    LocMsg* msg = static_cast<LocMsg*>(mpsc_q_pop(&mQ));
+    if (NULL == msg) {
+        LOC_LOGE("%s:%d] fail receiving msg: queue unblocked\n", __func__, __LINE__);
         return false;
     }
 
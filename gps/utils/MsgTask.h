@@ -30,8 +30,10 @@
 #define __MSG_TASK__
 
 #include <LocThread.h>
+#include <mpsc_q.h>
 
-struct LocMsg {
+// the mpsc_q_node base is the queue hook, sending a msg allocates nothing
+struct LocMsg : public mpsc_q_node {
     inline LocMsg() {}
     inline virtual ~LocMsg() {}
     virtual void proc() const = 0;
@@ -39,7 +41,7 @@ struct LocMsg {
 };
 
 class MsgTask : public LocRunnable {
-    const void* mQ;
+    mutable mpsc_q mQ;
     LocThread* mThread;
     friend class LocThreadDelegate;
 protected:
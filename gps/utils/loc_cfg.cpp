@@ -37,6 +37,10 @@
 #include <ctype.h>
 #include <unistd.h>
 #include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <loc_cfg.h>
 #include <platform_lib_includes.h>
 #include <loc_misc_utils.h>
@@ -71,6 +75,35 @@ typedef struct loc_param_v_type
     double param_double_value;
 }loc_param_v_type;
 
+/* Parsed config file store. Each file is parsed once and its items are kept
+   in a hash table keyed by parameter name, so that the repeated reads of the
+   same file, e.g. gps.conf by loc_eng, LocApiV02 and loc_sync_req, fill their
+   tables from memory. A file is parsed again only if it changed on disk. */
+#define LOC_CFG_HASH_BUCKETS 64
+
+typedef struct loc_cfg_item
+{
+    struct loc_cfg_item* next;
+    uint32_t hash;
+    loc_param_v_type value;
+}loc_cfg_item;
+
+typedef struct loc_cfg_file
+{
+    struct loc_cfg_file* next;
+    char* file_name;
+    /* identity of the file content that was parsed */
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime_sec;
+    long mtime_nsec;
+    loc_cfg_item* buckets[LOC_CFG_HASH_BUCKETS];
+}loc_cfg_file;
+
+static pthread_mutex_t loc_cfg_mutex = PTHREAD_MUTEX_INITIALIZER;
+static loc_cfg_file* loc_cfg_files = NULL;
+
 /*===========================================================================
 FUNCTION loc_set_config_entry
 
@@ -158,6 +191,68 @@ int loc_set_config_entry(const loc_param_s_type* config_entry, loc_param_v_type*
     return ret;
 }
 
+/*===========================================================================
+FUNCTION loc_parse_conf_item
+
+DESCRIPTION
+   Takes a line of configuration item and splits it into the parameter name
+   and its string, integer and floating point values.
+
+PARAMETERS:
+   input_buf : buffer contanis config item, tokenized in place
+   config_value: parsed item, pointing into input_buf
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   0: if the line holds an item
+  -1: otherwise
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static int loc_parse_conf_item(char* input_buf, loc_param_v_type* config_value)
+{
+    int ret = -1;
+    char *lasts;
+
+    memset(config_value, 0, sizeof(*config_value));
+
+    /* Separate variable and value */
+    config_value->param_name = strtok_r(input_buf, "=", &lasts);
+    /* skip lines that do not contain "=" */
+    if (config_value->param_name) {
+        config_value->param_str_value = strtok_r(NULL, "=", &lasts);
+
+        /* skip lines that do not contain two operands */
+        if (config_value->param_str_value) {
+            /* Trim leading and trailing spaces */
+            loc_util_trim_space(config_value->param_name);
+            loc_util_trim_space(config_value->param_str_value);
+
+            /* Parse numerical value */
+            if ((strlen(config_value->param_str_value) >=3) &&
+                (config_value->param_str_value[0] == '0') &&
+                (tolower(config_value->param_str_value[1]) == 'x'))
+            {
+                /* hex */
+                config_value->param_int_value =
+                    (int) strtol(&config_value->param_str_value[2], (char**) NULL, 16);
+            }
+            else {
+                config_value->param_double_value =
+                    (double) atof(config_value->param_str_value); /* float */
+                config_value->param_int_value =
+                    atoi(config_value->param_str_value); /* dec */
+            }
+            ret = 0;
+        }
+    }
+
+    return ret;
+}
+
 /*===========================================================================
 FUNCTION loc_fill_conf_item
 
@@ -186,41 +281,13 @@ int loc_fill_conf_item(char* input_buf,
     int ret = 0;
 
     if (input_buf && config_table) {
-        char *lasts;
         loc_param_v_type config_value;
-        memset(&config_value, 0, sizeof(config_value));
-
-        /* Separate variable and value */
-        config_value.param_name = strtok_r(input_buf, "=", &lasts);
-        /* skip lines that do not contain "=" */
-        if (config_value.param_name) {
-            config_value.param_str_value = strtok_r(NULL, "=", &lasts);
-
-            /* skip lines that do not contain two operands */
-            if (config_value.param_str_value) {
-                /* Trim leading and trailing spaces */
-                loc_util_trim_space(config_value.param_name);
-                loc_util_trim_space(config_value.param_str_value);
-
-                /* Parse numerical value */
-                if ((strlen(config_value.param_str_value) >=3) &&
-                    (config_value.param_str_value[0] == '0') &&
-                    (tolower(config_value.param_str_value[1]) == 'x'))
-                {
-                    /* hex */
-                    config_value.param_int_value = (int) strtol(&config_value.param_str_value[2],
-                                                                (char**) NULL, 16);
-                }
-                else {
-                    config_value.param_double_value = (double) atof(config_value.param_str_value); /* float */
-                    config_value.param_int_value = atoi(config_value.param_str_value); /* dec */
-                }
 
-                for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
-                {
-                    if(!loc_set_config_entry(&config_table[i], &config_value)) {
-                        ret += 1;
-                    }
+        if (0 == loc_parse_conf_item(input_buf, &config_value)) {
+            for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
+            {
+                if(!loc_set_config_entry(&config_table[i], &config_value)) {
+                    ret += 1;
                 }
             }
         }
@@ -355,6 +422,330 @@ int loc_update_conf(const char* conf_data, int32_t length,
     return ret;
 }
 
+/*===========================================================================
+FUNCTION loc_cfg_hash
+
+DESCRIPTION
+   FNV-1a hash of a parameter name, to index the parsed config items.
+
+PARAMETERS:
+   name: parameter name
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   hash value
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static uint32_t loc_cfg_hash(const char* name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*===========================================================================
+FUNCTION loc_cfg_free_file
+
+DESCRIPTION
+   Frees a parsed config file and all its items.
+
+PARAMETERS:
+   conf_file: parsed file
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static void loc_cfg_free_file(loc_cfg_file* conf_file)
+{
+    for (int i = 0; i < LOC_CFG_HASH_BUCKETS; i++) {
+        loc_cfg_item* item = conf_file->buckets[i];
+        while (item) {
+            loc_cfg_item* next = item->next;
+            free(item);
+            item = next;
+        }
+    }
+    free(conf_file->file_name);
+    free(conf_file);
+}
+
+/*===========================================================================
+FUNCTION loc_cfg_add_item
+
+DESCRIPTION
+   Adds a parsed item to the hash table of a config file. The item is put
+   in front of its chain, so when a parameter is set more than once in the
+   file, the last setting is the one found.
+
+PARAMETERS:
+   conf_file: parsed file
+   config_value: parsed item, its strings are copied
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   0: success
+  -1: out of memory
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static int loc_cfg_add_item(loc_cfg_file* conf_file, const loc_param_v_type* config_value)
+{
+    size_t name_len = strlen(config_value->param_name) + 1;
+    size_t str_len = strlen(config_value->param_str_value) + 1;
+    /* the strings are kept in the same allocation, right after the item */
+    loc_cfg_item* item = (loc_cfg_item*)malloc(sizeof(loc_cfg_item) + name_len + str_len);
+
+    if (NULL == item) {
+        return -1;
+    }
+
+    item->value = *config_value;
+    item->value.param_name = (char*)(item + 1);
+    item->value.param_str_value = item->value.param_name + name_len;
+    memcpy(item->value.param_name, config_value->param_name, name_len);
+    memcpy(item->value.param_str_value, config_value->param_str_value, str_len);
+    item->hash = loc_cfg_hash(item->value.param_name);
+
+    loc_cfg_item** bucket = &conf_file->buckets[item->hash % LOC_CFG_HASH_BUCKETS];
+    item->next = *bucket;
+    *bucket = item;
+    return 0;
+}
+
+/*===========================================================================
+FUNCTION loc_cfg_find_item
+
+DESCRIPTION
+   Looks up a parameter in a parsed config file.
+
+PARAMETERS:
+   conf_file: parsed file
+   name: parameter name
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   the item, or NULL if the file does not set the parameter
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static loc_cfg_item* loc_cfg_find_item(loc_cfg_file* conf_file, const char* name)
+{
+    uint32_t hash = loc_cfg_hash(name);
+    loc_cfg_item* item = conf_file->buckets[hash % LOC_CFG_HASH_BUCKETS];
+
+    while (item && (item->hash != hash || strcmp(item->value.param_name, name) != 0)) {
+        item = item->next;
+    }
+    return item;
+}
+
+/*===========================================================================
+FUNCTION loc_cfg_parse_file
+
+DESCRIPTION
+   Maps a config file into memory and parses all its items. Lines are
+   handled as loc_read_conf_r() does with fgets(), i.e. a line longer than
+   LOC_MAX_PARAM_LINE - 1 characters is cut into pieces of that length.
+
+PARAMETERS:
+   conf_file_name: configuration file to read
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   the parsed file, or NULL if the file can not be read
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static loc_cfg_file* loc_cfg_parse_file(const char* conf_file_name)
+{
+    struct timespec start, end;
+    struct stat st;
+    uint32_t num_items = 0;
+    loc_cfg_file* conf_file = NULL;
+    int fd;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if ((fd = open(conf_file_name, O_RDONLY)) < 0) {
+        return NULL;
+    }
+
+    if (0 == fstat(fd, &st) &&
+        NULL != (conf_file = (loc_cfg_file*)calloc(1, sizeof(loc_cfg_file))) &&
+        NULL != (conf_file->file_name = strdup(conf_file_name)))
+    {
+        conf_file->dev = st.st_dev;
+        conf_file->ino = st.st_ino;
+        conf_file->size = st.st_size;
+        conf_file->mtime_sec = st.st_mtim.tv_sec;
+        conf_file->mtime_nsec = st.st_mtim.tv_nsec;
+
+        /* an empty file has no items, and can not be mapped */
+        const char* data = NULL;
+        if (st.st_size > 0) {
+            data = (const char*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (MAP_FAILED == data) {
+                LOC_LOGE("%s: mmap %s failure - %s", __FUNCTION__, conf_file_name,
+                         strerror(errno));
+                data = NULL;
+            }
+        }
+
+        if (data) {
+            char input_buf[LOC_MAX_PARAM_LINE];
+            off_t pos = 0;
+
+            while (pos < st.st_size) {
+                /* copy one line, as fgets would, so it can be tokenized */
+                size_t len = 0;
+                while (pos < st.st_size && len < LOC_MAX_PARAM_LINE - 1) {
+                    char c = data[pos++];
+                    input_buf[len++] = c;
+                    if ('\n' == c) {
+                        break;
+                    }
+                }
+                input_buf[len] = '\0';
+
+                loc_param_v_type config_value;
+                if (0 == loc_parse_conf_item(input_buf, &config_value) &&
+                    0 == loc_cfg_add_item(conf_file, &config_value)) {
+                    num_items++;
+                }
+            }
+            munmap((void*)data, st.st_size);
+        } else if (st.st_size > 0) {
+            loc_cfg_free_file(conf_file);
+            conf_file = NULL;
+        }
+    } else if (conf_file) {
+        free(conf_file);
+        conf_file = NULL;
+    }
+    close(fd);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (conf_file) {
+        LOC_LOGD("%s: parsed %s, %u items in %ld us", __FUNCTION__, conf_file_name, num_items,
+                 (long)((end.tv_sec - start.tv_sec) * 1000000 +
+                        (end.tv_nsec - start.tv_nsec) / 1000));
+    }
+    return conf_file;
+}
+
+/*===========================================================================
+FUNCTION loc_cfg_get_file
+
+DESCRIPTION
+   Gets the parsed content of a config file from the store, parsing the file
+   if it is not in the store yet, or if it has changed since it was parsed.
+   Must be called with loc_cfg_mutex held.
+
+PARAMETERS:
+   conf_file_name: configuration file to read
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   the parsed file, or NULL if the file can not be read
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static loc_cfg_file* loc_cfg_get_file(const char* conf_file_name)
+{
+    struct stat st;
+    loc_cfg_file** link = &loc_cfg_files;
+
+    while (*link && strcmp((*link)->file_name, conf_file_name) != 0) {
+        link = &(*link)->next;
+    }
+
+    if (0 != stat(conf_file_name, &st)) {
+        st.st_ino = 0;
+    }
+
+    if (*link) {
+        loc_cfg_file* conf_file = *link;
+        if (0 != st.st_ino &&
+            conf_file->dev == st.st_dev && conf_file->ino == st.st_ino &&
+            conf_file->size == st.st_size &&
+            conf_file->mtime_sec == st.st_mtim.tv_sec &&
+            conf_file->mtime_nsec == st.st_mtim.tv_nsec) {
+            return conf_file;
+        }
+        /* the file is gone, or has changed */
+        *link = conf_file->next;
+        loc_cfg_free_file(conf_file);
+    }
+
+    loc_cfg_file* conf_file = NULL;
+    if (0 != st.st_ino && NULL != (conf_file = loc_cfg_parse_file(conf_file_name))) {
+        conf_file->next = loc_cfg_files;
+        loc_cfg_files = conf_file;
+    }
+    return conf_file;
+}
+
+/*===========================================================================
+FUNCTION loc_cfg_fill_table
+
+DESCRIPTION
+   Sets the entries of a configuration table from a parsed config file.
+
+PARAMETERS:
+   conf_file: parsed file
+   config_table: table definition of strings to places to store information
+   table_length: length of the configuration table
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static void loc_cfg_fill_table(loc_cfg_file* conf_file,
+                               const loc_param_s_type* config_table, uint32_t table_length)
+{
+    for (uint32_t i = 0; i < table_length; i++) {
+        /* Clear validity bit */
+        if (NULL != config_table[i].param_set) {
+            *(config_table[i].param_set) = 0;
+        }
+
+        loc_cfg_item* item = loc_cfg_find_item(conf_file, config_table[i].param_name);
+        if (item) {
+            loc_set_config_entry(&config_table[i], &item->value);
+        }
+    }
+}
+
 /*===========================================================================
 FUNCTION loc_read_conf
 
@@ -362,6 +753,8 @@ DESCRIPTION
    Reads the specified configuration file and sets defined values based on
    the passed in configuration table. This table maps strings to values to
    set along with the type of each of these values.
+   The file is parsed only on the first call, or when it has changed on disk
+   since; all other calls look the table entries up in the parsed items.
 
 PARAMETERS:
    conf_file_name: configuration file to read
@@ -380,21 +773,89 @@ SIDE EFFECTS
 void loc_read_conf(const char* conf_file_name, const loc_param_s_type* config_table,
                    uint32_t table_length)
 {
-    FILE *conf_fp = NULL;
-    char *lasts;
-    loc_param_v_type config_value;
-    uint32_t i;
+    loc_cfg_file* conf_file;
 
-    if((conf_fp = fopen(conf_file_name, "r")) != NULL)
+    pthread_mutex_lock(&loc_cfg_mutex);
+    if((conf_file = loc_cfg_get_file(conf_file_name)) != NULL)
     {
         LOC_LOGD("%s: using %s", __FUNCTION__, conf_file_name);
         if(table_length && config_table) {
-            loc_read_conf_r(conf_fp, config_table, table_length);
-            rewind(conf_fp);
+            loc_cfg_fill_table(conf_file, config_table, table_length);
         }
-        loc_read_conf_r(conf_fp, loc_param_table, loc_param_num);
-        fclose(conf_fp);
+        loc_cfg_fill_table(conf_file, loc_param_table, loc_param_num);
     }
+    pthread_mutex_unlock(&loc_cfg_mutex);
     /* Initialize logging mechanism with parsed data */
     loc_logger_init(DEBUG_LEVEL, TIMESTAMP);
 }
+
+#ifdef __LOC_DEBUG__
+
+static double loc_cfg_elapsed_us(struct timespec* from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000000.0 + (now.tv_nsec - from->tv_nsec) / 1000.0;
+}
+
+// For Linux command line testing:
+// compilation:
+//     g++ -D__LOC_DEBUG__ -g -I. -I../../../../system/core/include -lpthread
+//         loc_cfg.cpp loc_log.cpp loc_misc_utils.cpp
+// execution: ./a.out ../etc/gps.conf 100
+//     Reads the file the given number of times into a gps.conf style table,
+//     as the loc modules do at startup, first with the fopen() / fgets()
+//     parsing of loc_read_conf_r(), then through the parsed config store,
+//     and checks both fill the table the same way.
+int main(int argc, char** argv)
+{
+    const char* conf_file_name = (argc > 1) ? argv[1] : "/etc/gps.conf";
+    int tries = (argc > 2) ? atoi(argv[2]) : 100;
+    uint32_t supl_ver[2] = {0}, capabilities[2] = {0}, lock[2] = {0};
+    char xtra[2][LOC_MAX_PARAM_STRING + 1] = {{0}};
+    uint8_t xtra_set[2] = {0};
+    const loc_param_s_type conf_table[2][4] = {
+        {{"SUPL_VER",      &supl_ver[0],     NULL,         'n'},
+         {"CAPABILITIES",  &capabilities[0], NULL,         'n'},
+         {"GPS_LOCK",      &lock[0],         NULL,         'n'},
+         {"XTRA_SERVER_1", xtra[0],          &xtra_set[0], 's'}},
+        {{"SUPL_VER",      &supl_ver[1],     NULL,         'n'},
+         {"CAPABILITIES",  &capabilities[1], NULL,         'n'},
+         {"GPS_LOCK",      &lock[1],         NULL,         'n'},
+         {"XTRA_SERVER_1", xtra[1],          &xtra_set[1], 's'}},
+    };
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < tries; i++) {
+        FILE* conf_fp = fopen(conf_file_name, "r");
+        if (NULL == conf_fp) {
+            printf("can not open %s\n", conf_file_name);
+            return 1;
+        }
+        loc_read_conf_r(conf_fp, conf_table[0], 4);
+        rewind(conf_fp);
+        loc_read_conf_r(conf_fp, loc_param_table, loc_param_num);
+        fclose(conf_fp);
+    }
+    double legacy_us = loc_cfg_elapsed_us(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    loc_read_conf(conf_file_name, conf_table[1], 4);
+    double first_us = loc_cfg_elapsed_us(&start);
+    for (int i = 1; i < tries; i++) {
+        loc_read_conf(conf_file_name, conf_table[1], 4);
+    }
+    double cached_us = loc_cfg_elapsed_us(&start);
+
+    printf("%d reads of %s: fgets %.1f us/read, store %.1f us/read (first %.1f us)\n",
+           tries, conf_file_name, legacy_us / tries, cached_us / tries, first_us);
+
+    if (supl_ver[0] != supl_ver[1] || capabilities[0] != capabilities[1] ||
+        lock[0] != lock[1] || xtra_set[0] != xtra_set[1] || strcmp(xtra[0], xtra[1]) != 0) {
+        printf("ERROR: tables differ\n");
+        return 1;
+    }
+    return 0;
+}
+#endif
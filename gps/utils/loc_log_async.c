@@ -0,0 +1,1137 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "loc_log_async.h"
+
+#define LOG_TAG "LocSvc_utils_log"
+#include <platform_lib_includes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+
+/*
+ * Each logging thread owns a ring of records, written only by that thread,
+ * so pushing a record takes no lock. A record holds the format pointer, the
+ * time, and the arguments in their raw binary form; the log thread walks the
+ * format again to format them. Records never wrap around the ring end, a
+ * padding record fills the rest instead.
+ *
+ * The ring is read by the log thread, and by its owner when it logs an
+ * error; ring->lock is held by whichever of the two is reading. The log
+ * thread sleeps until a record goes into an empty ring, then lets records
+ * collect for LOC_LOG_FLUSH_MS, or until a ring is half full, before writing
+ * them all out.
+ */
+
+#define LOC_LOG_RING_SIZE    (16 * 1024)      /* per thread, power of 2 */
+#define LOC_LOG_RING_MASK    (LOC_LOG_RING_SIZE - 1)
+#define LOC_LOG_MAX_RECORD   512              /* incl. header, larger ones are */
+                                              /* written on the calling thread */
+#define LOC_LOG_MAX_LINE     1024
+#define LOC_LOG_MAX_BIG_RECORD (4 * LOC_LOG_MAX_LINE)
+#define LOC_LOG_MAX_SPEC     32
+#define LOC_LOG_FLUSH_MS     20
+#define LOC_LOG_CACHE_LINE   64
+#define LOC_LOG_ALIGN(x)     (((x) + 7) & ~7u)
+/* string length marking the loc_log_async_timestamp argument */
+#define LOC_LOG_TS_STR       0xffff
+
+const char loc_log_async_timestamp[] = "<timestamp>";
+
+typedef struct loc_log_rec {
+   uint32_t size;             /* of the whole record, 8 aligned */
+   uint8_t level;             /* 0 for a padding record */
+   uint8_t truncated;         /* arguments did not all fit */
+   uint16_t data_size;        /* bytes of raw arguments */
+   const char* tag;
+   const char* fmt;
+   struct timespec ts;
+   /* raw arguments follow */
+} loc_log_rec;
+
+typedef struct loc_log_ring {
+   struct loc_log_ring* next;
+   volatile uint32_t head;    /* running byte count written by the owner */
+   uint32_t records;
+   volatile uint32_t dropped;
+   char pad0[LOC_LOG_CACHE_LINE - sizeof(void*) - 3 * sizeof(uint32_t)];
+   volatile uint32_t tail;    /* running byte count read, under lock */
+   uint32_t dropped_seen;     /* under lock */
+   volatile int32_t dead;     /* owner thread has exited */
+   pthread_mutex_t lock;      /* held while reading the ring */
+   char buf[LOC_LOG_RING_SIZE] __attribute__((aligned(8)));
+} loc_log_ring;
+
+/* argument kinds, by conversion and length modifier */
+enum {
+   LOC_LOG_ARG_NONE,
+   LOC_LOG_ARG_INT,
+   LOC_LOG_ARG_LONG,
+   LOC_LOG_ARG_LLONG,
+   LOC_LOG_ARG_SIZE,
+   LOC_LOG_ARG_DOUBLE,
+   LOC_LOG_ARG_LDOUBLE,
+   LOC_LOG_ARG_STR,
+   LOC_LOG_ARG_PTR
+};
+
+typedef struct {
+   const char* start;         /* the '%' */
+   uint32_t len;
+   int stars;                 /* '*' width / precision ints before the value */
+   int kind;
+} loc_log_spec;
+
+static pthread_once_t loc_log_once = PTHREAD_ONCE_INIT;
+static pthread_key_t loc_log_key;
+static pthread_mutex_t loc_log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t loc_log_cond;       /* CLOCK_MONOTONIC */
+static loc_log_ring* volatile loc_log_rings = NULL;
+/* a ring has records for the log thread; set under loc_log_mutex, read
+   without it by loc_log_async() */
+static volatile int loc_log_pending = 0;
+/* under loc_log_mutex: a ring is half full, its records should not wait */
+static int loc_log_urgent = 0;
+/* counters of the rings already freed */
+static uint32_t loc_log_freed_records = 0;
+static uint32_t loc_log_freed_dropped = 0;
+
+/*===========================================================================
+FUNCTION    loc_log_next_spec
+
+DESCRIPTION
+   Finds the next conversion in a printf format, and the kind of argument
+   it takes. "%%" is returned as a conversion without argument.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   pointer past the conversion, or NULL if there are no more
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static const char* loc_log_next_spec(const char* fmt, loc_log_spec* spec)
+{
+   const char* p = strchr(fmt, '%');
+   int longs = 0, size = 0, ldouble = 0;
+
+   if( p == NULL )
+   {
+      return NULL;
+   }
+
+   spec->start = p++;
+   spec->stars = 0;
+
+   while( *p && strchr("-+ #0'", *p) ) p++;
+   if( *p == '*' ) { spec->stars++; p++; }
+   while( *p >= '0' && *p <= '9' ) p++;
+   if( *p == '.' )
+   {
+      p++;
+      if( *p == '*' ) { spec->stars++; p++; }
+      while( *p >= '0' && *p <= '9' ) p++;
+   }
+   for( ; *p && strchr("hlqLjzt", *p); p++ )
+   {
+      if( *p == 'l' ) longs++;
+      else if( *p == 'q' ) longs = 2;
+      else if( *p == 'L' ) ldouble = 1;
+      else if( *p == 'j' || *p == 'z' || *p == 't' ) size = 1;
+   }
+
+   switch( *p )
+   {
+   case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+      spec->kind = size ? LOC_LOG_ARG_SIZE :
+                   (longs >= 2 || ldouble) ? LOC_LOG_ARG_LLONG :
+                   (longs == 1 && *p != 'c') ? LOC_LOG_ARG_LONG : LOC_LOG_ARG_INT;
+      break;
+   case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+      spec->kind = ldouble ? LOC_LOG_ARG_LDOUBLE : LOC_LOG_ARG_DOUBLE;
+      break;
+   case 's':
+      spec->kind = longs ? LOC_LOG_ARG_PTR : LOC_LOG_ARG_STR;
+      break;
+   case 'p': case 'n':
+      spec->kind = LOC_LOG_ARG_PTR;
+      break;
+   case '\0':
+      /* a lone '%' at the end */
+      spec->kind = LOC_LOG_ARG_NONE;
+      spec->len = p - spec->start;
+      return p;
+   default:
+      spec->kind = LOC_LOG_ARG_NONE;
+      break;
+   }
+   p++;
+   spec->len = p - spec->start;
+   return p;
+}
+
+/*===========================================================================
+FUNCTION    loc_log_encode
+
+DESCRIPTION
+   Copies the arguments of a format into a record, each in its raw form:
+   integers as int64_t, floating point as (long) double, pointers as is, and
+   strings as a uint16_t length followed by the text.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   bytes used, *truncated set if not all arguments fit
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static uint32_t loc_log_encode(char* out, uint32_t room, const char* fmt, va_list ap,
+                               uint8_t* truncated)
+{
+   uint32_t used = 0;
+   loc_log_spec spec;
+
+   *truncated = 0;
+   while( (fmt = loc_log_next_spec(fmt, &spec)) != NULL )
+   {
+      int i;
+      for( i = 0; i < spec.stars; i++ )
+      {
+         int64_t v = va_arg(ap, int);
+         if( used + sizeof(v) > room ) goto full;
+         memcpy(out + used, &v, sizeof(v));
+         used += sizeof(v);
+      }
+
+      switch( spec.kind )
+      {
+      case LOC_LOG_ARG_INT:
+      case LOC_LOG_ARG_LONG:
+      case LOC_LOG_ARG_LLONG:
+      case LOC_LOG_ARG_SIZE:
+      {
+         int64_t v = (spec.kind == LOC_LOG_ARG_INT) ? (int64_t)va_arg(ap, int) :
+                     (spec.kind == LOC_LOG_ARG_LONG) ? (int64_t)va_arg(ap, long) :
+                     (spec.kind == LOC_LOG_ARG_LLONG) ? (int64_t)va_arg(ap, long long) :
+                     (int64_t)va_arg(ap, size_t);
+         if( used + sizeof(v) > room ) goto full;
+         memcpy(out + used, &v, sizeof(v));
+         used += sizeof(v);
+         break;
+      }
+      case LOC_LOG_ARG_DOUBLE:
+      {
+         double v = va_arg(ap, double);
+         if( used + sizeof(v) > room ) goto full;
+         memcpy(out + used, &v, sizeof(v));
+         used += sizeof(v);
+         break;
+      }
+      case LOC_LOG_ARG_LDOUBLE:
+      {
+         long double v = va_arg(ap, long double);
+         if( used + sizeof(v) > room ) goto full;
+         memcpy(out + used, &v, sizeof(v));
+         used += sizeof(v);
+         break;
+      }
+      case LOC_LOG_ARG_PTR:
+      {
+         void* v = va_arg(ap, void*);
+         if( used + sizeof(v) > room ) goto full;
+         memcpy(out + used, &v, sizeof(v));
+         used += sizeof(v);
+         break;
+      }
+      case LOC_LOG_ARG_STR:
+      {
+         const char* s = va_arg(ap, const char*);
+         uint16_t len;
+         if( used + sizeof(len) > room ) goto full;
+         if( s == loc_log_async_timestamp )
+         {
+            len = LOC_LOG_TS_STR;
+            memcpy(out + used, &len, sizeof(len));
+            used += sizeof(len);
+            break;
+         }
+         if( s == NULL )
+         {
+            s = "(null)";
+         }
+         len = (uint16_t)strnlen(s, room - used - sizeof(len));
+         memcpy(out + used, &len, sizeof(len));
+         memcpy(out + used + sizeof(len), s, len);
+         used += sizeof(len) + len;
+         if( s[len] != '\0' ) goto full;
+         break;
+      }
+      default:
+         break;
+      }
+   }
+   return used;
+
+full:
+   *truncated = 1;
+   return used;
+}
+
+/*===========================================================================
+FUNCTION    loc_log_decode
+
+DESCRIPTION
+   Formats a record into text, the reverse of loc_log_encode().
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_log_decode(const loc_log_rec* rec, char* line, uint32_t line_size)
+{
+   const char* data = (const char*)(rec + 1);
+   const char* end = data + rec->data_size;
+   const char* fmt = rec->fmt;
+   const char* next;
+   uint32_t n = 0;
+   loc_log_spec spec;
+
+#define LOC_LOG_ROOM (n < line_size ? line_size - n : 0)
+#define LOC_LOG_ADD(len) do { int _l = (len); if( _l > 0 ) n += _l; } while( 0 )
+#define LOC_LOG_TAKE(var) \
+   do { if( data + sizeof(var) > end ) goto out; \
+        memcpy(&(var), data, sizeof(var)); data += sizeof(var); } while( 0 )
+#define LOC_LOG_PRINT(val) \
+   LOC_LOG_ADD(spec.stars == 0 ? snprintf(line + n, LOC_LOG_ROOM, sb, val) : \
+               spec.stars == 1 ? snprintf(line + n, LOC_LOG_ROOM, sb, (int)star[0], val) : \
+               snprintf(line + n, LOC_LOG_ROOM, sb, (int)star[0], (int)star[1], val))
+
+   while( (next = loc_log_next_spec(fmt, &spec)) != NULL )
+   {
+      char sb[LOC_LOG_MAX_SPEC];
+      int64_t star[2] = {0, 0};
+      int i, stars = spec.stars;
+
+      /* the literal text up to the conversion */
+      LOC_LOG_ADD(snprintf(line + n, LOC_LOG_ROOM, "%.*s", (int)(spec.start - fmt), fmt));
+      fmt = next;
+
+      if( spec.len >= sizeof(sb) )
+      {
+         /* too long to copy, the value is still taken from the record and
+            shown with the bare conversion, without flags, width or precision */
+         static const char* const mod[] = { "", "", "l", "ll", "z", "", "L", "", "" };
+         snprintf(sb, sizeof(sb), "%%%s%c", mod[spec.kind], spec.start[spec.len - 1]);
+         spec.len = strlen(sb);
+         spec.stars = 0;
+      }
+      else
+      {
+         memcpy(sb, spec.start, spec.len);
+         sb[spec.len] = '\0';
+      }
+
+      for( i = 0; i < stars; i++ )
+      {
+         LOC_LOG_TAKE(star[i]);
+      }
+
+      switch( spec.kind )
+      {
+      case LOC_LOG_ARG_INT:
+      case LOC_LOG_ARG_LONG:
+      case LOC_LOG_ARG_LLONG:
+      case LOC_LOG_ARG_SIZE:
+      {
+         int64_t v;
+         LOC_LOG_TAKE(v);
+         if( spec.kind == LOC_LOG_ARG_INT ) LOC_LOG_PRINT((int)v);
+         else if( spec.kind == LOC_LOG_ARG_LONG ) LOC_LOG_PRINT((long)v);
+         else if( spec.kind == LOC_LOG_ARG_LLONG ) LOC_LOG_PRINT((long long)v);
+         else LOC_LOG_PRINT((size_t)v);
+         break;
+      }
+      case LOC_LOG_ARG_DOUBLE:
+      {
+         double v;
+         LOC_LOG_TAKE(v);
+         LOC_LOG_PRINT(v);
+         break;
+      }
+      case LOC_LOG_ARG_LDOUBLE:
+      {
+         long double v;
+         LOC_LOG_TAKE(v);
+         LOC_LOG_PRINT(v);
+         break;
+      }
+      case LOC_LOG_ARG_PTR:
+      {
+         void* v;
+         LOC_LOG_TAKE(v);
+         /* %n is not written to, %ls is shown as a pointer */
+         if( sb[spec.len - 1] == 'n' ) break;
+         if( sb[spec.len - 1] == 's' ) { sb[0] = '%'; sb[1] = 'p'; sb[2] = '\0'; spec.stars = 0; }
+         LOC_LOG_PRINT(v);
+         break;
+      }
+      case LOC_LOG_ARG_STR:
+      {
+         char str[LOC_LOG_MAX_LINE];
+         uint16_t len;
+         LOC_LOG_TAKE(len);
+         if( len == LOC_LOG_TS_STR )
+         {
+            /* as get_timestamp() does */
+            time_t sec = rec->ts.tv_sec;
+            snprintf(str, sizeof(str), "%02d:%02d:%02d.%06ld",
+                     (int)(sec / 3600 % 24), (int)(sec % 3600 / 60), (int)(sec % 60),
+                     rec->ts.tv_nsec / 1000);
+         }
+         else
+         {
+            if( data + len > end ) goto out;
+            /* a longer string would not fit in the line either */
+            memcpy(str, data, (len < sizeof(str)) ? len : sizeof(str) - 1);
+            str[(len < sizeof(str)) ? len : sizeof(str) - 1] = '\0';
+            data += len;
+         }
+         LOC_LOG_PRINT(str);
+         break;
+      }
+      default:
+         /* "%%" and the like take no argument */
+         LOC_LOG_ADD(snprintf(line + n, LOC_LOG_ROOM, sb, 0));
+         break;
+      }
+   }
+   LOC_LOG_ADD(snprintf(line + n, LOC_LOG_ROOM, "%s", fmt));
+   if( !rec->truncated )
+   {
+      return;
+   }
+
+out:
+   LOC_LOG_ADD(snprintf(line + n, LOC_LOG_ROOM, "...<truncated>"));
+
+#undef LOC_LOG_PRINT
+#undef LOC_LOG_TAKE
+#undef LOC_LOG_ADD
+#undef LOC_LOG_ROOM
+}
+
+/*===========================================================================
+FUNCTION    loc_log_write
+
+DESCRIPTION
+   Writes a line of text to the log, as the ALOGx macros would.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_log_write(int level, const char* tag, const char* text)
+{
+#ifndef USE_GLIB
+   static const int prio[] = {
+      ANDROID_LOG_ERROR, ANDROID_LOG_ERROR, ANDROID_LOG_WARN,
+      ANDROID_LOG_INFO, ANDROID_LOG_DEBUG, ANDROID_LOG_VERBOSE
+   };
+   __android_log_write(prio[level <= LOC_LOG_LEVEL_V ? level : LOC_LOG_LEVEL_E],
+                       tag ? tag : "", text);
+#else
+   (void)level;
+   fprintf(stdout, "%s (%d): %s\n", tag ? tag : "", getpid(), text);
+#endif
+}
+
+/*===========================================================================
+FUNCTION    loc_log_peek
+
+DESCRIPTION
+   Skips the padding at the tail of a ring, and reports the records dropped
+   since the last call. The caller holds ring->lock.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   the oldest record of the ring, or NULL if it is empty
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static const loc_log_rec* loc_log_peek(loc_log_ring* ring, char* line, uint32_t line_size)
+{
+   uint32_t dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+   const loc_log_rec* rec;
+
+   if( dropped != ring->dropped_seen )
+   {
+      snprintf(line, line_size, "W/%s: %u records dropped, log ring full",
+               __func__, dropped - ring->dropped_seen);
+      loc_log_write(LOC_LOG_LEVEL_W, LOG_TAG, line);
+      ring->dropped_seen = dropped;
+   }
+
+   while( ring->tail != __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) )
+   {
+      rec = (const loc_log_rec*)(ring->buf + (ring->tail & LOC_LOG_RING_MASK));
+      if( rec->level != 0 )
+      {
+         return rec;
+      }
+      __atomic_store_n(&ring->tail, ring->tail + rec->size, __ATOMIC_RELEASE);
+   }
+   return NULL;
+}
+
+/*===========================================================================
+FUNCTION    loc_log_pop
+
+DESCRIPTION
+   Writes out the oldest record of a ring, as returned by loc_log_peek(),
+   and frees its space. The caller holds ring->lock.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_log_pop(loc_log_ring* ring, const loc_log_rec* rec, char* line,
+                        uint32_t line_size)
+{
+   loc_log_decode(rec, line, line_size);
+   loc_log_write(rec->level, rec->tag, line);
+   __atomic_store_n(&ring->tail, ring->tail + rec->size, __ATOMIC_RELEASE);
+}
+
+/*===========================================================================
+FUNCTION    loc_log_drain
+
+DESCRIPTION
+   Writes out the records of all rings, oldest first, and frees the rings of
+   threads that have exited once they are empty. Log thread only.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_log_drain(void)
+{
+   static char line[LOC_LOG_MAX_LINE];
+   loc_log_ring* ring;
+   loc_log_ring** link;
+
+   for( ;; )
+   {
+      loc_log_ring* oldest = NULL;
+      struct timespec oldest_ts = {0, 0};
+      const loc_log_rec* rec;
+
+      /* rings are only ever added at the list head, walking from a snapshot
+         of it is safe without loc_log_mutex */
+      for( ring = loc_log_rings; ring != NULL; ring = ring->next )
+      {
+         pthread_mutex_lock(&ring->lock);
+         rec = loc_log_peek(ring, line, sizeof(line));
+         if( rec != NULL &&
+             (oldest == NULL || rec->ts.tv_sec < oldest_ts.tv_sec ||
+              (rec->ts.tv_sec == oldest_ts.tv_sec && rec->ts.tv_nsec < oldest_ts.tv_nsec)) )
+         {
+            oldest = ring;
+            oldest_ts = rec->ts;
+         }
+         pthread_mutex_unlock(&ring->lock);
+      }
+
+      if( oldest == NULL )
+      {
+         break;
+      }
+
+      /* its owner may have written the record out meanwhile, the one now at
+         the tail is then the oldest left in the ring */
+      pthread_mutex_lock(&oldest->lock);
+      if( (rec = loc_log_peek(oldest, line, sizeof(line))) != NULL )
+      {
+         loc_log_pop(oldest, rec, line, sizeof(line));
+      }
+      pthread_mutex_unlock(&oldest->lock);
+   }
+
+   /* free the drained rings of exited threads */
+   pthread_mutex_lock(&loc_log_mutex);
+   for( link = (loc_log_ring**)&loc_log_rings; (ring = *link) != NULL; )
+   {
+      if( __atomic_load_n(&ring->dead, __ATOMIC_ACQUIRE) &&
+          ring->tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) )
+      {
+         *link = ring->next;
+         loc_log_freed_records += ring->records;
+         loc_log_freed_dropped += ring->dropped;
+         pthread_mutex_destroy(&ring->lock);
+         free(ring);
+      }
+      else
+      {
+         link = &ring->next;
+      }
+   }
+   pthread_mutex_unlock(&loc_log_mutex);
+}
+
+/*===========================================================================
+FUNCTION    loc_log_queued
+
+DESCRIPTION
+   Checks whether any ring has records left. Log thread only, with
+   loc_log_mutex held.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   1 if a ring has records, 0 otherwise
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static int loc_log_queued(void)
+{
+   loc_log_ring* ring;
+
+   for( ring = loc_log_rings; ring != NULL; ring = ring->next )
+   {
+      if( __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) !=
+          __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) )
+      {
+         return 1;
+      }
+   }
+   return 0;
+}
+
+static void* loc_log_thread(void* arg)
+{
+   (void)arg;
+   pthread_mutex_lock(&loc_log_mutex);
+   for( ;; )
+   {
+      /* nothing to do until a record is pushed */
+      while( !loc_log_pending )
+      {
+         pthread_cond_wait(&loc_log_cond, &loc_log_mutex);
+      }
+
+      /* let records collect, unless a ring is getting full */
+      if( !loc_log_urgent )
+      {
+         struct timespec until;
+         clock_gettime(CLOCK_MONOTONIC, &until);
+         until.tv_nsec += LOC_LOG_FLUSH_MS * 1000000L;
+         if( until.tv_nsec >= 1000000000L )
+         {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+         }
+         while( !loc_log_urgent &&
+                pthread_cond_timedwait(&loc_log_cond, &loc_log_mutex, &until) != ETIMEDOUT )
+         {
+         }
+      }
+      loc_log_urgent = 0;
+      pthread_mutex_unlock(&loc_log_mutex);
+
+      loc_log_drain();
+
+      pthread_mutex_lock(&loc_log_mutex);
+      /* records pushed while loc_log_pending was still set did not wake the
+         thread. Pairs with the fence in loc_log_async(): either those
+         records are seen here, or their push sees the flag clear. */
+      __atomic_store_n(&loc_log_pending, 0, __ATOMIC_RELAXED);
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      if( loc_log_queued() )
+      {
+         __atomic_store_n(&loc_log_pending, 1, __ATOMIC_RELAXED);
+      }
+   }
+   return NULL;
+}
+
+/*===========================================================================
+FUNCTION    loc_log_wake
+
+DESCRIPTION
+   Tells the log thread there are records to write; urgent when a ring is
+   half full, so the records do not wait for LOC_LOG_FLUSH_MS.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_log_wake(int urgent)
+{
+   pthread_mutex_lock(&loc_log_mutex);
+   if( !loc_log_pending || (urgent && !loc_log_urgent) )
+   {
+      __atomic_store_n(&loc_log_pending, 1, __ATOMIC_RELAXED);
+      loc_log_urgent |= urgent;
+      pthread_cond_signal(&loc_log_cond);
+   }
+   pthread_mutex_unlock(&loc_log_mutex);
+}
+
+static void loc_log_thread_exit(void* data)
+{
+   loc_log_ring* ring = (loc_log_ring*)data;
+   __atomic_store_n(&ring->dead, 1, __ATOMIC_RELEASE);
+   /* the ring is freed by the log thread once it is empty */
+   loc_log_wake(0);
+}
+
+static void loc_log_init(void)
+{
+   pthread_t thread;
+   pthread_condattr_t attr;
+
+   pthread_condattr_init(&attr);
+   pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+   pthread_cond_init(&loc_log_cond, &attr);
+   pthread_condattr_destroy(&attr);
+
+   pthread_key_create(&loc_log_key, loc_log_thread_exit);
+   if( pthread_create(&thread, NULL, loc_log_thread, NULL) == 0 )
+   {
+      pthread_detach(thread);
+   }
+}
+
+/*===========================================================================
+FUNCTION    loc_log_get_ring
+
+DESCRIPTION
+   Gets the ring of the calling thread, creating it on the first call.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   the ring, or NULL if out of memory
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static loc_log_ring* loc_log_get_ring(void)
+{
+   loc_log_ring* ring;
+
+   pthread_once(&loc_log_once, loc_log_init);
+   ring = (loc_log_ring*)pthread_getspecific(loc_log_key);
+   if( ring == NULL && (ring = (loc_log_ring*)calloc(1, sizeof(loc_log_ring))) != NULL )
+   {
+      pthread_mutex_init(&ring->lock, NULL);
+      pthread_setspecific(loc_log_key, ring);
+      pthread_mutex_lock(&loc_log_mutex);
+      ring->next = loc_log_rings;
+      __atomic_store_n(&loc_log_rings, ring, __ATOMIC_RELEASE);
+      pthread_mutex_unlock(&loc_log_mutex);
+   }
+   return ring;
+}
+
+/*===========================================================================
+FUNCTION    loc_log_flush_own
+
+DESCRIPTION
+   Writes out the records of the calling thread's ring on the calling
+   thread. Only that ring is read, so the time taken is bounded by its size.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_log_flush_own(loc_log_ring* ring)
+{
+   char line[LOC_LOG_MAX_LINE];
+   const loc_log_rec* rec;
+
+   /* only this thread moves head, so an empty ring stays empty */
+   if( __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == ring->head )
+   {
+      return;
+   }
+
+   pthread_mutex_lock(&ring->lock);
+   while( (rec = loc_log_peek(ring, line, sizeof(line))) != NULL )
+   {
+      loc_log_pop(ring, rec, line, sizeof(line));
+   }
+   pthread_mutex_unlock(&ring->lock);
+}
+
+/*===========================================================================
+FUNCTION    loc_log_write_big
+
+DESCRIPTION
+   Writes a record too big for the ring on the calling thread, after the
+   records the thread queued before it, as the synchronous macros would.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_log_write_big(loc_log_ring* ring, const loc_log_rec* hdr, va_list ap)
+{
+   union {
+      loc_log_rec rec;
+      char raw[LOC_LOG_MAX_BIG_RECORD];
+   } u;
+   char line[LOC_LOG_MAX_LINE];
+
+   loc_log_flush_own(ring);
+
+   u.rec = *hdr;
+   u.rec.data_size = (uint16_t)loc_log_encode(u.raw + sizeof(loc_log_rec),
+                                              sizeof(u) - sizeof(loc_log_rec), hdr->fmt, ap,
+                                              &u.rec.truncated);
+   loc_log_decode(&u.rec, line, sizeof(line));
+   loc_log_write(u.rec.level, u.rec.tag, line);
+}
+
+/* ----------------------- END INTERNAL FUNCTIONS ---------------------------------------- */
+
+/*===========================================================================
+
+  FUNCTION:   loc_log_async
+
+  ===========================================================================*/
+void loc_log_async(int level, const char* tag, const char* fmt, ...)
+{
+   union {
+      loc_log_rec rec;
+      char raw[LOC_LOG_MAX_RECORD];
+   } u;
+   loc_log_ring* ring = loc_log_get_ring();
+   uint32_t head, used, offset, pad, size;
+   va_list ap;
+
+   if( ring == NULL )
+   {
+      return;
+   }
+
+   u.rec.level = (uint8_t)level;
+   u.rec.tag = tag;
+   u.rec.fmt = fmt;
+   clock_gettime(CLOCK_REALTIME, &u.rec.ts);
+   va_start(ap, fmt);
+   u.rec.data_size = (uint16_t)loc_log_encode(u.raw + sizeof(loc_log_rec),
+                                              sizeof(u) - sizeof(loc_log_rec), fmt, ap,
+                                              &u.rec.truncated);
+   va_end(ap);
+   if( u.rec.truncated )
+   {
+      va_start(ap, fmt);
+      loc_log_write_big(ring, &u.rec, ap);
+      va_end(ap);
+      return;
+   }
+   size = LOC_LOG_ALIGN(sizeof(loc_log_rec) + u.rec.data_size);
+   u.rec.size = size;
+
+   /* only this thread moves head, the readers only move tail forward */
+   head = ring->head;
+   used = head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+   offset = head & LOC_LOG_RING_MASK;
+   pad = (offset + size > LOC_LOG_RING_SIZE) ? LOC_LOG_RING_SIZE - offset : 0;
+
+   if( used + pad + size > LOC_LOG_RING_SIZE )
+   {
+      __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+      return;
+   }
+
+   if( pad )
+   {
+      loc_log_rec* filler = (loc_log_rec*)(ring->buf + offset);
+      filler->size = pad;
+      filler->level = 0;
+      offset = 0;
+   }
+   memcpy(ring->buf + offset, u.raw, sizeof(loc_log_rec) + u.rec.data_size);
+   ring->records++;
+   __atomic_store_n(&ring->head, head + pad + size, __ATOMIC_RELEASE);
+
+   /* pairs with the fence in loc_log_thread(): the log thread is woken
+      up unless it is bound to see the record */
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   if( !__atomic_load_n(&loc_log_pending, __ATOMIC_RELAXED) )
+   {
+      loc_log_wake(0);
+   }
+   else if( used < LOC_LOG_RING_SIZE / 2 && used + pad + size >= LOC_LOG_RING_SIZE / 2 )
+   {
+      loc_log_wake(1);
+   }
+}
+
+/*===========================================================================
+
+  FUNCTION:   loc_log_async_flush
+
+  ===========================================================================*/
+void loc_log_async_flush(void)
+{
+   loc_log_ring* ring;
+
+   pthread_once(&loc_log_once, loc_log_init);
+   ring = (loc_log_ring*)pthread_getspecific(loc_log_key);
+   if( ring != NULL )
+   {
+      loc_log_flush_own(ring);
+   }
+}
+
+/*===========================================================================
+
+  FUNCTION:   loc_log_async_get_stats
+
+  ===========================================================================*/
+void loc_log_async_get_stats(loc_log_async_stats* stats)
+{
+   loc_log_ring* ring;
+
+   if( stats == NULL )
+   {
+      return;
+   }
+
+   pthread_mutex_lock(&loc_log_mutex);
+   stats->records = loc_log_freed_records;
+   stats->dropped = loc_log_freed_dropped;
+   stats->threads = 0;
+   for( ring = loc_log_rings; ring != NULL; ring = ring->next )
+   {
+      stats->records += ring->records;
+      stats->dropped += ring->dropped;
+      stats->threads++;
+   }
+   pthread_mutex_unlock(&loc_log_mutex);
+}
+
+#ifdef __LOC_DEBUG__
+
+static uint32_t loc_log_encode_test(char* out, uint32_t room, uint8_t* truncated,
+                                    const char* fmt, ...)
+{
+   uint32_t used;
+   va_list ap;
+
+   va_start(ap, fmt);
+   used = loc_log_encode(out, room, fmt, ap, truncated);
+   va_end(ap);
+   return used;
+}
+
+static double loc_log_elapsed_ns(const struct timespec* from)
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (now.tv_sec - from->tv_sec) * 1e9 + (now.tv_nsec - from->tv_nsec);
+}
+
+/* For Linux command line testing:
+   compilation: gcc -D__LOC_DEBUG__ -DUSE_GLIB -DOFF_TARGET -O2 -I. \
+                -Iplatform_lib_abstractions/loc_pla/include loc_log_async.c -lpthread
+   execution: ./a.out 100000 > /dev/null
+   First checks a record with a conversion too long to copy, that a record
+   too big for the ring is written whole, and that the sleeping log thread
+   writes a record without a flush. Then compares the time the calling thread
+   spends on an NMEA style record when pushed to the ring, with formatting
+   and writing it in place as the synchronous macros do. Batches of 50
+   records are timed with CLOCK_MONOTONIC, the ring is flushed between the
+   batches and that is not counted, and the fastest batch is reported next
+   to the mean. A batch stays under half a ring, so it does not wake the log
+   thread to write the ring out in the middle of it. */
+int main(int argc, char** argv)
+{
+   int tries = (argc > 1) ? atoi(argv[1]) : 100000;
+   double async_ns = 0, sync_ns = 0, async_min = 0, sync_min = 0, ns;
+   char line[LOC_LOG_MAX_LINE];
+   union {
+      loc_log_rec rec;
+      char raw[LOC_LOG_MAX_RECORD];
+   } u;
+   struct timespec start;
+   loc_log_async_stats stats;
+   loc_log_ring* ring;
+   static char big[LOC_LOG_MAX_LINE - 64];
+   char* out;
+   FILE* tmp;
+   int i, j, fd;
+
+   /* the value of an oversized conversion must not shift the ones after it */
+   static const char long_fmt[] = "%-0000000000000000000000000000000008d|%d|%s";
+   memset(&u, 0, sizeof(u));
+   u.rec.fmt = long_fmt;
+   u.rec.data_size = loc_log_encode_test(u.raw + sizeof(loc_log_rec),
+                                         sizeof(u) - sizeof(loc_log_rec), &u.rec.truncated,
+                                         long_fmt, 1, 2, "three");
+   loc_log_decode(&u.rec, line, sizeof(line));
+   if( strcmp(line, "1|2|three") != 0 )
+   {
+      fprintf(stderr, "oversized conversion: got \"%s\"\n", line);
+      return 1;
+   }
+
+   /* a record too big for the ring is written on this thread, not cut */
+   memset(big, 'x', sizeof(big) - 1);
+   big[sizeof(big) - 2] = 'y';
+   out = (char*)calloc(1, 4 * sizeof(big));
+   tmp = tmpfile();
+   fflush(stdout);
+   fd = dup(1);
+   dup2(fileno(tmp), 1);
+   loc_log_async(LOC_LOG_LEVEL_D, LOG_TAG, "D/big %s|%d", big, 7);
+   fflush(stdout);
+   dup2(fd, 1);
+   close(fd);
+   rewind(tmp);
+   fread(out, 1, 4 * sizeof(big) - 1, tmp);
+   fclose(tmp);
+   if( strstr(out, big) == NULL || strstr(out, "y|7") == NULL )
+   {
+      fprintf(stderr, "big record: got \"%s\"\n", out);
+      return 1;
+   }
+   free(out);
+
+   /* the log thread sleeps with nothing queued, and a record going into an
+      empty ring wakes it */
+   loc_log_async(LOC_LOG_LEVEL_D, LOG_TAG, "D/%s: wake", __func__);
+   ring = (loc_log_ring*)pthread_getspecific(loc_log_key);
+   for( i = 0; i < 100 && __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) != ring->head; i++ )
+   {
+      usleep(10000);
+   }
+   if( i == 100 )
+   {
+      fprintf(stderr, "record not written within 1 s\n");
+      return 1;
+   }
+
+   for( j = 0; j < tries; j += 50 )
+   {
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for( i = j; i < j + 50; i++ )
+      {
+         loc_log_async(LOC_LOG_LEVEL_D, LOG_TAG, "D/%s: $GPGSV,3,1,11,%d,%d,%d,%d*%02X",
+                       __func__, i, 45, 120, 38, i & 0xff);
+      }
+      ns = loc_log_elapsed_ns(&start);
+      async_ns += ns;
+      async_min = (j == 0 || ns < async_min) ? ns : async_min;
+      loc_log_async_flush();
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for( i = j; i < j + 50; i++ )
+      {
+         snprintf(line, sizeof(line), "D/%s: $GPGSV,3,1,11,%d,%d,%d,%d*%02X",
+                  __func__, i, 45, 120, 38, i & 0xff);
+         loc_log_write(LOC_LOG_LEVEL_D, LOG_TAG, line);
+      }
+      ns = loc_log_elapsed_ns(&start);
+      sync_ns += ns;
+      sync_min = (j == 0 || ns < sync_min) ? ns : sync_min;
+   }
+
+   loc_log_async_get_stats(&stats);
+   fprintf(stderr, "%d records: push %.0f ns (fastest batch %.0f), "
+           "format and write in place %.0f ns (%.0f); %u dropped\n",
+           tries, async_ns / tries, async_min / 50, sync_ns / tries, sync_min / 50,
+           stats.dropped);
+   return 0;
+}
+#endif
@@ -0,0 +1,128 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __LOC_LOG_ASYNC_H__
+#define __LOC_LOG_ASYNC_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+/* levels of the records, the same numbers loc_logger.DEBUG_LEVEL uses */
+#define LOC_LOG_LEVEL_E 1
+#define LOC_LOG_LEVEL_W 2
+#define LOC_LOG_LEVEL_I 3
+#define LOC_LOG_LEVEL_D 4
+#define LOC_LOG_LEVEL_V 5
+
+/** Passed as the argument of a "%s", it is replaced with the time the record
+    was logged, in the get_timestamp() format. */
+extern const char loc_log_async_timestamp[];
+
+typedef struct {
+   uint32_t records;    /* records logged */
+   uint32_t dropped;    /* records lost because the thread's ring was full */
+   uint32_t threads;    /* threads with a ring */
+} loc_log_async_stats;
+
+/*===========================================================================
+FUNCTION    loc_log_async
+
+DESCRIPTION
+   Logs a record without formatting it. The format pointer and the raw
+   arguments, with the text of "%s" arguments copied, are pushed into a ring
+   owned by the calling thread; a log thread formats the records of all rings
+   in time order and writes them to the log. The first call on a thread
+   allocates its ring, later calls do not allocate, and only lock to wake
+   the log thread when it sleeps. When the ring is full the record is
+   dropped and counted. A record too big for the ring is formatted and
+   written on the calling thread instead.
+
+   level: LOC_LOG_LEVEL_x priority to write the record with
+   tag:   log tag, must be a string literal
+   fmt:   printf format, must be a string literal
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_log_async(int level, const char* tag, const char* fmt, ...)
+   __attribute__((format(printf, 3, 4)));
+
+/*===========================================================================
+FUNCTION    loc_log_async_flush
+
+DESCRIPTION
+   Writes out the records the calling thread logged before the call, on the
+   calling thread. The records of other threads are left to the log thread,
+   and may be written after the ones of the calling thread.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_log_async_flush(void);
+
+/*===========================================================================
+FUNCTION    loc_log_async_get_stats
+
+DESCRIPTION
+   Gets the counters of the async log.
+
+   stats: filled with the counters
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_log_async_get_stats(loc_log_async_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __LOC_LOG_ASYNC_H__ */
@@ -66,6 +66,42 @@ void* loc_timer_start(uint64_t delay_msec,
 */
 void loc_timer_stop(void*& handle);
 
+/*
+    Default tick of the timer wheel that keeps the timers started with
+    wake_on_expire false. 0 keeps them in a heap, each expiring at its own
+    time. A process that can take the lateness opts in with
+    loc_timer_set_slack(), its timers then expire on the first tick at or
+    after their time out, so those due within the same tick share one wakeup.
+*/
+#define LOC_TIMER_DEFAULT_SLACK_MSEC 0
+
+/*
+    wake_on_expire:     selects the container of timers, as in loc_timer_start().
+    tick_msec:          0 to keep the timers sorted in a heap, each expiring at
+                        its own time; otherwise to keep them in a timer wheel of
+                        tick_msec granularity.
+    Must be called before the first timer of that container is started.
+    Returns true on success; false if the container is already in use.
+*/
+bool loc_timer_set_slack(bool wake_on_expire, uint32_t tick_msec);
+
+typedef struct {
+    /* times the timer / alarm fd fired, since the first timer was started */
+    uint32_t wakeups;
+    /* timers expired, since the first timer was started */
+    uint32_t expirations;
+    /* wakeups and expirations counted over the last full minute */
+    uint32_t wakeups_per_min;
+    uint32_t expirations_per_min;
+} loc_timer_stats;
+
+/*
+    wake_on_expire:     selects the container of timers, as in loc_timer_start().
+    stats:              filled with the counters of that container, all 0 if
+                        no such timer has ever been started.
+*/
+void loc_timer_get_stats(bool wake_on_expire, loc_timer_stats* stats);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
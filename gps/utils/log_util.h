@@ -33,6 +33,7 @@
 #ifndef USE_GLIB
 #include <utils/Log.h>
 #endif /* USE_GLIB */
+#include <loc_log_async.h>
 
 #ifdef USE_GLIB
 
@@ -93,40 +94,70 @@ extern char* get_timestamp(char* str, unsigned long buf_size);
 
 #ifndef DEBUG_DMN_LOC_API
 
+/* Least severe level whose calls are compiled in, 1 (E) to 5 (V). The calls
+   of the levels above it compile to nothing, whatever DEBUG_LEVEL is set to
+   at run time. User builds keep E, W and I only. */
+#ifndef LOC_LOG_MIN_LEVEL
+#ifdef TARGET_BUILD_VARIANT_USER
+#define LOC_LOG_MIN_LEVEL 3
+#else
+#define LOC_LOG_MIN_LEVEL 5
+#endif
+#endif /* LOC_LOG_MIN_LEVEL */
+
+/* The records are handed to the async backend in loc_log_async.c, which
+   formats and writes them on its own thread. Define LOC_LOG_SYNC to format
+   and write them on the calling thread instead. Errors and warnings are
+   always written on the calling thread, so they are out before a crash;
+   an error first writes out the records its thread queued before it. */
+#ifndef LOC_LOG_SYNC
+#define LOC_LOG_OUT(LEVEL, ALOG, ...) loc_log_async(LEVEL, LOG_TAG, __VA_ARGS__)
+#define LOC_LOG_OUT_ERR(ALOG, ...) do { loc_log_async_flush(); ALOG(__VA_ARGS__); } while (0)
+#else
+#define LOC_LOG_OUT(LEVEL, ALOG, ...) ALOG(__VA_ARGS__)
+#define LOC_LOG_OUT_ERR(ALOG, ...) ALOG(__VA_ARGS__)
+#endif /* LOC_LOG_SYNC */
+#define LOC_LOG_OUT_WARN(ALOG, ...) ALOG(__VA_ARGS__)
+
 /* LOGGING MACROS */
 /*loc_logger.DEBUG_LEVEL is initialized to 0xff in loc_cfg.cpp
   if that value remains unchanged, it means gps.conf did not
   provide a value and we default to the initial value to use
   Android's logging levels*/
-#define IF_LOC_LOGE if((loc_logger.DEBUG_LEVEL >= 1) && (loc_logger.DEBUG_LEVEL <= 5))
+#define IF_LOC_LOGE if((LOC_LOG_MIN_LEVEL >= 1) && (loc_logger.DEBUG_LEVEL >= 1) && (loc_logger.DEBUG_LEVEL <= 5))
 
-#define IF_LOC_LOGW if((loc_logger.DEBUG_LEVEL >= 2) && (loc_logger.DEBUG_LEVEL <= 5))
+#define IF_LOC_LOGW if((LOC_LOG_MIN_LEVEL >= 2) && (loc_logger.DEBUG_LEVEL >= 2) && (loc_logger.DEBUG_LEVEL <= 5))
 
-#define IF_LOC_LOGI if((loc_logger.DEBUG_LEVEL >= 3) && (loc_logger.DEBUG_LEVEL <= 5))
+#define IF_LOC_LOGI if((LOC_LOG_MIN_LEVEL >= 3) && (loc_logger.DEBUG_LEVEL >= 3) && (loc_logger.DEBUG_LEVEL <= 5))
 
-#define IF_LOC_LOGD if((loc_logger.DEBUG_LEVEL >= 4) && (loc_logger.DEBUG_LEVEL <= 5))
+#define IF_LOC_LOGD if((LOC_LOG_MIN_LEVEL >= 4) && (loc_logger.DEBUG_LEVEL >= 4) && (loc_logger.DEBUG_LEVEL <= 5))
 
-#define IF_LOC_LOGV if((loc_logger.DEBUG_LEVEL >= 5) && (loc_logger.DEBUG_LEVEL <= 5))
+#define IF_LOC_LOGV if((LOC_LOG_MIN_LEVEL >= 5) && (loc_logger.DEBUG_LEVEL >= 5) && (loc_logger.DEBUG_LEVEL <= 5))
 
 #define LOC_LOGE(...) \
-IF_LOC_LOGE { ALOGE("E/" __VA_ARGS__); } \
-else if (loc_logger.DEBUG_LEVEL == 0xff) { ALOGE("E/" __VA_ARGS__); }
+IF_LOC_LOGE { LOC_LOG_OUT_ERR(ALOGE, "E/" __VA_ARGS__); } \
+else if ((LOC_LOG_MIN_LEVEL >= 1) && (loc_logger.DEBUG_LEVEL == 0xff)) \
+{ LOC_LOG_OUT_ERR(ALOGE, "E/" __VA_ARGS__); }
 
 #define LOC_LOGW(...) \
-IF_LOC_LOGW { ALOGE("W/" __VA_ARGS__); }  \
-else if (loc_logger.DEBUG_LEVEL == 0xff) { ALOGW("W/" __VA_ARGS__); }
+IF_LOC_LOGW { LOC_LOG_OUT_WARN(ALOGE, "W/" __VA_ARGS__); }  \
+else if ((LOC_LOG_MIN_LEVEL >= 2) && (loc_logger.DEBUG_LEVEL == 0xff)) \
+{ LOC_LOG_OUT_WARN(ALOGW, "W/" __VA_ARGS__); }
 
 #define LOC_LOGI(...) \
-IF_LOC_LOGI { ALOGE("I/" __VA_ARGS__); }   \
-else if (loc_logger.DEBUG_LEVEL == 0xff) { ALOGI("I/" __VA_ARGS__); }
+IF_LOC_LOGI { LOC_LOG_OUT(LOC_LOG_LEVEL_E, ALOGE, "I/" __VA_ARGS__); }   \
+else if ((LOC_LOG_MIN_LEVEL >= 3) && (loc_logger.DEBUG_LEVEL == 0xff)) \
+{ LOC_LOG_OUT(LOC_LOG_LEVEL_I, ALOGI, "I/" __VA_ARGS__); }
 
 #define LOC_LOGD(...) \
-IF_LOC_LOGD { ALOGE("D/" __VA_ARGS__); }   \
-else if (loc_logger.DEBUG_LEVEL == 0xff) { ALOGD("D/" __VA_ARGS__); }
+IF_LOC_LOGD { LOC_LOG_OUT(LOC_LOG_LEVEL_E, ALOGE, "D/" __VA_ARGS__); }   \
+else if ((LOC_LOG_MIN_LEVEL >= 4) && (loc_logger.DEBUG_LEVEL == 0xff)) \
+{ LOC_LOG_OUT(LOC_LOG_LEVEL_D, ALOGD, "D/" __VA_ARGS__); }
 
 #define LOC_LOGV(...) \
-IF_LOC_LOGV { ALOGE("V/" __VA_ARGS__); }   \
-else if (loc_logger.DEBUG_LEVEL == 0xff) { ALOGV("V/" __VA_ARGS__); }
+IF_LOC_LOGV { LOC_LOG_OUT(LOC_LOG_LEVEL_E, ALOGE, "V/" __VA_ARGS__); }   \
+else if ((LOC_LOG_MIN_LEVEL >= 5) && (loc_logger.DEBUG_LEVEL == 0xff)) \
+{ LOC_LOG_OUT(LOC_LOG_LEVEL_V, ALOGV, "V/" __VA_ARGS__); }
 
 #else /* DEBUG_DMN_LOC_API */
 
@@ -147,12 +178,21 @@ else if (loc_logger.DEBUG_LEVEL == 0xff) { ALOGV("V/" __VA_ARGS__); }
  *                          LOGGING IMPROVEMENT MACROS
  *
  *============================================================================*/
-#define LOG_(LOC_LOG, ID, WHAT, SPEC, VAL)                                    \
+/* errors are written on the calling thread, and take their time there */
+#define LOC_LOG_TIMESTAMP_NOW(ts) get_timestamp(ts, sizeof(ts))
+#if !defined(DEBUG_DMN_LOC_API) && !defined(LOC_LOG_SYNC)
+/* the record carries its time, the log thread formats it */
+#define LOC_LOG_TIMESTAMP(ts) ((void)(ts), loc_log_async_timestamp)
+#else
+#define LOC_LOG_TIMESTAMP(ts) LOC_LOG_TIMESTAMP_NOW(ts)
+#endif
+
+#define LOG_(LOC_LOG, LOC_TS, ID, WHAT, SPEC, VAL)                            \
     do {                                                                      \
         if (loc_logger.TIMESTAMP) {                                           \
             char ts[32];                                                      \
             LOC_LOG("[%s] %s %s line %d " #SPEC,                              \
-                     get_timestamp(ts, sizeof(ts)), ID, WHAT, __LINE__, VAL); \
+                     LOC_TS(ts), ID, WHAT, __LINE__, VAL);                    \
         } else {                                                              \
             LOC_LOG("%s %s line %d " #SPEC,                                   \
                      ID, WHAT, __LINE__, VAL);                                \
@@ -165,9 +205,9 @@ else if (loc_logger.DEBUG_LEVEL == 0xff) { ALOGV("V/" __VA_ARGS__); }
 #define LOC_LOGd(tag,fmt,...) LOC_LOGD(LOC_LOG_HEAD(tag,fmt), __func__, __LINE__, ##__VA_ARGS__)
 #define LOC_LOGe(tag,fmt,...) LOC_LOGE(LOC_LOG_HEAD(tag,fmt), __func__, __LINE__, ##__VA_ARGS__)
 
-#define LOG_I(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGI, ID, WHAT, SPEC, VAL)
-#define LOG_V(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGV, ID, WHAT, SPEC, VAL)
-#define LOG_E(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGE, ID, WHAT, SPEC, VAL)
+#define LOG_I(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGI, LOC_LOG_TIMESTAMP, ID, WHAT, SPEC, VAL)
+#define LOG_V(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGV, LOC_LOG_TIMESTAMP, ID, WHAT, SPEC, VAL)
+#define LOG_E(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGE, LOC_LOG_TIMESTAMP_NOW, ID, WHAT, SPEC, VAL)
 
 #define ENTRY_LOG() LOG_V(ENTRY_TAG, __func__, %s, "")
 #define EXIT_LOG(SPEC, VAL) LOG_V(EXIT_TAG, __func__, SPEC, VAL)
@@ -0,0 +1,371 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mpsc_q.h"
+
+#define LOG_TAG "LocSvc_utils_mpsc_q"
+#include <platform_lib_includes.h>
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/*
+ * Intrusive MPSC list after Vyukov: producers swap themselves into head
+ * and then link the previous node to themselves, the consumer walks from
+ * tail. Between the swap and the link the list is briefly cut, which the
+ * consumer sees as "busy" rather than empty and simply retries.
+ */
+
+static inline long mpsc_q_futex(volatile int32_t* addr, int op, int32_t val)
+{
+   return syscall(__NR_futex, addr, op, val, NULL, NULL, 0);
+}
+
+static inline void mpsc_q_link(mpsc_q* q, mpsc_q_node* node)
+{
+   mpsc_q_node* prev;
+
+   node->mpsc_next = NULL;
+   prev = __atomic_exchange_n(&q->head, node, __ATOMIC_ACQ_REL);
+   __atomic_store_n(&prev->mpsc_next, node, __ATOMIC_RELEASE);
+}
+
+/*===========================================================================
+FUNCTION    mpsc_q_take
+
+DESCRIPTION
+   Pops the oldest node. *busy is set when the queue is not empty but a
+   producer has not finished linking its node yet.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   oldest node or NULL
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static mpsc_q_node* mpsc_q_take(mpsc_q* q, int* busy)
+{
+   mpsc_q_node* tail = q->tail;
+   mpsc_q_node* next = __atomic_load_n(&tail->mpsc_next, __ATOMIC_ACQUIRE);
+
+   *busy = 0;
+
+   if( tail == &q->stub )
+   {
+      if( next == NULL )
+      {
+         /* empty unless a producer has swapped head but not linked yet */
+         *busy = (__atomic_load_n(&q->head, __ATOMIC_ACQUIRE) != tail);
+         return NULL;
+      }
+      q->tail = next;
+      tail = next;
+      next = __atomic_load_n(&tail->mpsc_next, __ATOMIC_ACQUIRE);
+   }
+
+   if( next != NULL )
+   {
+      q->tail = next;
+      return tail;
+   }
+
+   if( tail != __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) )
+   {
+      *busy = 1;
+      return NULL;
+   }
+
+   /* tail is the last node, put the stub behind it so it can be handed out */
+   mpsc_q_link(q, &q->stub);
+
+   next = __atomic_load_n(&tail->mpsc_next, __ATOMIC_ACQUIRE);
+   if( next != NULL )
+   {
+      q->tail = next;
+      return tail;
+   }
+
+   *busy = 1;
+   return NULL;
+}
+
+/* ----------------------- END INTERNAL FUNCTIONS ---------------------------------------- */
+
+/*===========================================================================
+
+  FUNCTION:   mpsc_q_init
+
+  ===========================================================================*/
+void mpsc_q_init(mpsc_q* q)
+{
+   q->stub.mpsc_next = NULL;
+   q->head = &q->stub;
+   q->tail = &q->stub;
+   q->parked = 0;
+   q->unblocked = 0;
+}
+
+/*===========================================================================
+
+  FUNCTION:   mpsc_q_push
+
+  ===========================================================================*/
+int mpsc_q_push(mpsc_q* q, mpsc_q_node* node)
+{
+   if( __atomic_load_n(&q->unblocked, __ATOMIC_ACQUIRE) )
+   {
+      return -1;
+   }
+
+   mpsc_q_link(q, node);
+
+   /* pairs with the fence in mpsc_q_pop: either the consumer sees the node
+      before it sleeps or we see it parked */
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   if( __atomic_load_n(&q->parked, __ATOMIC_RELAXED) &&
+       __atomic_exchange_n(&q->parked, 0, __ATOMIC_ACQ_REL) )
+   {
+      mpsc_q_futex(&q->parked, FUTEX_WAKE_PRIVATE, 1);
+   }
+
+   return 0;
+}
+
+/*===========================================================================
+
+  FUNCTION:   mpsc_q_try_pop
+
+  ===========================================================================*/
+mpsc_q_node* mpsc_q_try_pop(mpsc_q* q)
+{
+   int busy;
+   return mpsc_q_take(q, &busy);
+}
+
+/*===========================================================================
+
+  FUNCTION:   mpsc_q_pop
+
+  ===========================================================================*/
+mpsc_q_node* mpsc_q_pop(mpsc_q* q)
+{
+   mpsc_q_node* node;
+   int busy;
+
+   for( ;; )
+   {
+      if( __atomic_load_n(&q->unblocked, __ATOMIC_ACQUIRE) )
+      {
+         return NULL;
+      }
+
+      node = mpsc_q_take(q, &busy);
+      if( node != NULL )
+      {
+         return node;
+      }
+      if( busy )
+      {
+         /* a producer is between its swap and its link, a few cycles */
+         sched_yield();
+         continue;
+      }
+
+      __atomic_store_n(&q->parked, 1, __ATOMIC_RELAXED);
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+      node = mpsc_q_take(q, &busy);
+      if( node != NULL || busy || __atomic_load_n(&q->unblocked, __ATOMIC_ACQUIRE) )
+      {
+         __atomic_store_n(&q->parked, 0, __ATOMIC_RELAXED);
+         if( node != NULL )
+         {
+            return node;
+         }
+         continue;
+      }
+
+      /* returns at once if a producer already cleared parked */
+      mpsc_q_futex(&q->parked, FUTEX_WAIT_PRIVATE, 1);
+      __atomic_store_n(&q->parked, 0, __ATOMIC_RELAXED);
+   }
+}
+
+/*===========================================================================
+
+  FUNCTION:   mpsc_q_unblock
+
+  ===========================================================================*/
+void mpsc_q_unblock(mpsc_q* q)
+{
+   __atomic_store_n(&q->unblocked, 1, __ATOMIC_RELEASE);
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   __atomic_store_n(&q->parked, 0, __ATOMIC_RELAXED);
+   mpsc_q_futex(&q->parked, FUTEX_WAKE_PRIVATE, INT_MAX);
+}
+
+#ifdef __LOC_DEBUG__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include "msg_q.h"
+
+#define MPSC_Q_BENCH_MSGS 1000000
+
+typedef struct mpsc_q_bench_msg {
+   mpsc_q_node node;
+   int producer;
+   int seq;
+} mpsc_q_bench_msg;
+
+typedef struct mpsc_q_bench_arg {
+   mpsc_q* q;
+   void* msg_q;
+   mpsc_q_bench_msg* msgs;
+   int producer;
+   int count;
+} mpsc_q_bench_arg;
+
+static void* mpsc_q_bench_producer(void* data)
+{
+   mpsc_q_bench_arg* arg = (mpsc_q_bench_arg*)data;
+   int i;
+
+   for( i = 0; i < arg->count; i++ )
+   {
+      arg->msgs[i].producer = arg->producer;
+      arg->msgs[i].seq = i;
+      if( arg->msg_q != NULL )
+      {
+         msg_q_snd(arg->msg_q, &arg->msgs[i], NULL);
+      }
+      else
+      {
+         mpsc_q_push(arg->q, &arg->msgs[i].node);
+      }
+   }
+   return NULL;
+}
+
+static double mpsc_q_bench_now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* one consumer drains what nproducers push, checking per producer FIFO */
+static int mpsc_q_bench_run(int nproducers, int use_msg_q)
+{
+   mpsc_q q;
+   void* mq = NULL;
+   pthread_t threads[4];
+   mpsc_q_bench_arg args[4];
+   int last[4];
+   int per = MPSC_Q_BENCH_MSGS / nproducers;
+   int total = per * nproducers;
+   int i, errors = 0;
+   double start, elapsed;
+
+   mpsc_q_init(&q);
+   if( use_msg_q )
+   {
+      mq = (void*)msg_q_init2();
+   }
+
+   start = mpsc_q_bench_now();
+   for( i = 0; i < nproducers; i++ )
+   {
+      args[i].q = &q;
+      args[i].msg_q = mq;
+      args[i].msgs = (mpsc_q_bench_msg*)calloc(per, sizeof(mpsc_q_bench_msg));
+      args[i].producer = i;
+      args[i].count = per;
+      last[i] = -1;
+      pthread_create(&threads[i], NULL, mpsc_q_bench_producer, &args[i]);
+   }
+
+   for( i = 0; i < total; i++ )
+   {
+      mpsc_q_bench_msg* msg;
+      if( use_msg_q )
+      {
+         msg_q_rcv(mq, (void**)&msg);
+      }
+      else
+      {
+         msg = (mpsc_q_bench_msg*)mpsc_q_pop(&q);
+      }
+      if( msg->seq != last[msg->producer] + 1 )
+      {
+         errors++;
+      }
+      last[msg->producer] = msg->seq;
+   }
+   elapsed = mpsc_q_bench_now() - start;
+
+   for( i = 0; i < nproducers; i++ )
+   {
+      pthread_join(threads[i], NULL);
+      free(args[i].msgs);
+   }
+   if( use_msg_q )
+   {
+      msg_q_destroy(&mq);
+   }
+
+   printf("%-7s producers=%d msgs=%d %.0f msgs/s %.1f ns/msg %s\n",
+          use_msg_q ? "msg_q" : "mpsc_q", nproducers, total, total / elapsed,
+          elapsed * 1e9 / total, errors ? "ORDER ERRORS" : "ok");
+   return errors;
+}
+
+// For Linux command line testing:
+// compilation: gcc -D__LOC_HOST_DEBUG__ -D__LOC_DEBUG__ -O2 -I. -Iplatform_lib_abstractions/loc_pla/include mpsc_q.c msg_q.c -lpthread
+// test: ./a.out
+int main()
+{
+   int n, errors = 0;
+
+   for( n = 1; n <= 4; n <<= 1 )
+   {
+      errors += mpsc_q_bench_run(n, 0);
+      errors += mpsc_q_bench_run(n, 1);
+   }
+   return errors ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,169 @@
+/* Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MPSC_Q_H__
+#define __MPSC_Q_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+#define MPSC_Q_CACHE_LINE 64
+
+/** Hook embedded in every queued object, the queue never allocates */
+typedef struct mpsc_q_node {
+   struct mpsc_q_node* volatile mpsc_next;
+} mpsc_q_node;
+
+/** Intrusive multi producer, single consumer queue.
+    Producers only touch head, the consumer only touches tail; they live
+    on separate cache lines so senders do not bounce the reader's line. */
+typedef struct mpsc_q {
+   mpsc_q_node* volatile head;      /* last pushed node, swapped by producers */
+   char pad0[MPSC_Q_CACHE_LINE - sizeof(mpsc_q_node*)];
+   mpsc_q_node* tail;               /* next node to pop, consumer only */
+   mpsc_q_node stub;                /* keeps the list non-empty */
+   volatile int32_t parked;         /* futex word, 1 while the consumer sleeps */
+   volatile int32_t unblocked;      /* set once by mpsc_q_unblock */
+} mpsc_q;
+
+/*===========================================================================
+FUNCTION    mpsc_q_init
+
+DESCRIPTION
+   Initializes an empty queue in caller provided storage.
+
+   q: queue to initialize
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void mpsc_q_init(mpsc_q* q);
+
+/*===========================================================================
+FUNCTION    mpsc_q_push
+
+DESCRIPTION
+   Appends node to the queue and wakes the consumer if it is parked.
+   Safe to call from any number of threads at once; never blocks and
+   never allocates.
+
+   q:    queue to add the node to
+   node: hook of the object to queue, owned by the queue until popped
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   0 on success; -1 if the queue has been unblocked, in which case node
+   was not queued and still belongs to the caller
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+int mpsc_q_push(mpsc_q* q, mpsc_q_node* node);
+
+/*===========================================================================
+FUNCTION    mpsc_q_try_pop
+
+DESCRIPTION
+   Removes the oldest node without blocking. Consumer thread only.
+
+   q: queue to take the node from
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   oldest node; NULL if the queue is empty or a producer is half way
+   through a push
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+mpsc_q_node* mpsc_q_try_pop(mpsc_q* q);
+
+/*===========================================================================
+FUNCTION    mpsc_q_pop
+
+DESCRIPTION
+   Removes the oldest node, parking on a futex while the queue is empty.
+   Consumer thread only.
+
+   q: queue to take the node from
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   oldest node; NULL once the queue has been unblocked
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+mpsc_q_node* mpsc_q_pop(mpsc_q* q);
+
+/*===========================================================================
+FUNCTION    mpsc_q_unblock
+
+DESCRIPTION
+   Stops the queue. A parked consumer wakes up and gets NULL, further
+   pushes fail. Nodes still queued are left for the owner to drain with
+   mpsc_q_try_pop once the consumer is gone.
+
+   q: queue to unblock
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void mpsc_q_unblock(mpsc_q* q);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __MPSC_Q_H__ */
@@ -30,57 +30,23 @@
 
 #define LOG_TAG "LocSvc_utils_q"
 #include <platform_lib_includes.h>
-#include "linked_list.h"
+#include "mpsc_q.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <pthread.h>
+
+/* msg_q is kept as a thin wrapper around mpsc_q for C callers that queue
+   arbitrary pointers. Each message still needs a small element to carry
+   its hook and dealloc function; MsgTask queues LocMsg directly instead. */
+typedef struct msg_q_elem {
+   mpsc_q_node node;                /* must stay first */
+   void* msg_obj;
+   void (*dealloc)(void*);
+} msg_q_elem;
 
 typedef struct msg_q {
-   void* msg_list;                  /* Linked list to store information */
-   pthread_cond_t  list_cond;       /* Condition variable for waiting on msg queue */
-   pthread_mutex_t list_mutex;      /* Mutex for exclusive access to message queue */
-   int unblocked;                   /* Has this message queue been unblocked? */
+   mpsc_q q;                        /* lock-free storage, single reader */
 } msg_q;
 
-/*===========================================================================
-FUNCTION    convert_linked_list_err_type
-
-DESCRIPTION
-   Converts from one set of enum values to another.
-
-   linked_list_val: Value to convert to msg_q_enum_type
-
-DEPENDENCIES
-   N/A
-
-RETURN VALUE
-   Corresponding linked_list_enum_type in msg_q_enum_type
-
-SIDE EFFECTS
-   N/A
-
-===========================================================================*/
-static msq_q_err_type convert_linked_list_err_type(linked_list_err_type linked_list_val)
-{
-   switch( linked_list_val )
-   {
-   case eLINKED_LIST_SUCCESS:
-      return eMSG_Q_SUCCESS;
-   case eLINKED_LIST_INVALID_PARAMETER:
-      return eMSG_Q_INVALID_PARAMETER;
-   case eLINKED_LIST_INVALID_HANDLE:
-      return eMSG_Q_INVALID_HANDLE;
-   case eLINKED_LIST_UNAVAILABLE_RESOURCE:
-      return eMSG_Q_UNAVAILABLE_RESOURCE;
-   case eLINKED_LIST_INSUFFICIENT_BUFFER:
-      return eMSG_Q_INSUFFICIENT_BUFFER;
-
-   case eLINKED_LIST_FAILURE_GENERAL:
-   default:
-      return eMSG_Q_FAILURE_GENERAL;
-   }
-}
-
 /* ----------------------- END INTERNAL FUNCTIONS ---------------------------------------- */
 
 /*===========================================================================
@@ -104,31 +70,7 @@ msq_q_err_type msg_q_init(void** msg_q_data)
       return eMSG_Q_FAILURE_GENERAL;
    }
 
-   if( linked_list_init(&tmp_msg_q->msg_list) != 0 )
-   {
-      LOC_LOGE("%s: Unable to initialize storage list!\n", __FUNCTION__);
-      free(tmp_msg_q);
-      return eMSG_Q_FAILURE_GENERAL;
-   }
-
-   if( pthread_mutex_init(&tmp_msg_q->list_mutex, NULL) != 0 )
-   {
-      LOC_LOGE("%s: Unable to initialize list mutex!\n", __FUNCTION__);
-      linked_list_destroy(&tmp_msg_q->msg_list);
-      free(tmp_msg_q);
-      return eMSG_Q_FAILURE_GENERAL;
-   }
-
-   if( pthread_cond_init(&tmp_msg_q->list_cond, NULL) != 0 )
-   {
-      LOC_LOGE("%s: Unable to initialize msg q cond var!\n", __FUNCTION__);
-      linked_list_destroy(&tmp_msg_q->msg_list);
-      pthread_mutex_destroy(&tmp_msg_q->list_mutex);
-      free(tmp_msg_q);
-      return eMSG_Q_FAILURE_GENERAL;
-   }
-
-   tmp_msg_q->unblocked = 0;
+   mpsc_q_init(&tmp_msg_q->q);
 
    *msg_q_data = tmp_msg_q;
 
@@ -162,13 +104,7 @@ msq_q_err_type msg_q_destroy(void** msg_q_data)
       return eMSG_Q_INVALID_HANDLE;
    }
 
-   msg_q* p_msg_q = (msg_q*)*msg_q_data;
-
-   linked_list_destroy(&p_msg_q->msg_list);
-   pthread_mutex_destroy(&p_msg_q->list_mutex);
-   pthread_cond_destroy(&p_msg_q->list_cond);
-
-   p_msg_q->unblocked = 0;
+   msg_q_flush(*msg_q_data);
 
    free(*msg_q_data);
    *msg_q_data = NULL;
@@ -183,7 +119,7 @@ msq_q_err_type msg_q_destroy(void** msg_q_data)
   ===========================================================================*/
 msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*))
 {
-   msq_q_err_type rv;
+   msg_q_elem* elem;
    if( msg_q_data == NULL )
    {
       LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
@@ -197,26 +133,27 @@ msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*)
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
-   pthread_mutex_lock(&p_msg_q->list_mutex);
    LOC_LOGV("%s: Sending message with handle = 0x%08X\n", __FUNCTION__, msg_obj);
 
-   if( p_msg_q->unblocked )
+   elem = (msg_q_elem*)malloc(sizeof(msg_q_elem));
+   if( elem == NULL )
    {
-      LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
-      pthread_mutex_unlock(&p_msg_q->list_mutex);
+      LOC_LOGE("%s: Unable to allocate space for message element!\n", __FUNCTION__);
       return eMSG_Q_UNAVAILABLE_RESOURCE;
    }
+   elem->msg_obj = msg_obj;
+   elem->dealloc = dealloc;
 
-   rv = convert_linked_list_err_type(linked_list_add(p_msg_q->msg_list, msg_obj, dealloc));
-
-   /* Show data is in the message queue. */
-   pthread_cond_signal(&p_msg_q->list_cond);
-
-   pthread_mutex_unlock(&p_msg_q->list_mutex);
+   if( mpsc_q_push(&p_msg_q->q, &elem->node) != 0 )
+   {
+      LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+      free(elem);
+      return eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
 
    LOC_LOGV("%s: Finished Sending message with handle = 0x%08X\n", __FUNCTION__, msg_obj);
 
-   return rv;
+   return eMSG_Q_SUCCESS;
 }
 
 /*===========================================================================
@@ -226,7 +163,7 @@ msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*)
   ===========================================================================*/
 msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
 {
-   msq_q_err_type rv;
+   msg_q_elem* elem;
    if( msg_q_data == NULL )
    {
       LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
@@ -243,28 +180,20 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
 
    LOC_LOGV("%s: Waiting on message\n", __FUNCTION__);
 
-   pthread_mutex_lock(&p_msg_q->list_mutex);
-
-   if( p_msg_q->unblocked )
+   /* Wait for data in the message queue */
+   elem = (msg_q_elem*)mpsc_q_pop(&p_msg_q->q);
+   if( elem == NULL )
    {
       LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
-      pthread_mutex_unlock(&p_msg_q->list_mutex);
       return eMSG_Q_UNAVAILABLE_RESOURCE;
    }
 
-   /* Wait for data in the message queue */
-   while( linked_list_empty(p_msg_q->msg_list) && !p_msg_q->unblocked )
-   {
-      pthread_cond_wait(&p_msg_q->list_cond, &p_msg_q->list_mutex);
-   }
-
-   rv = convert_linked_list_err_type(linked_list_remove(p_msg_q->msg_list, msg_obj));
+   *msg_obj = elem->msg_obj;
+   free(elem);
 
-   pthread_mutex_unlock(&p_msg_q->list_mutex);
+   LOC_LOGV("%s: Received message 0x%08X rv = %d\n", __FUNCTION__, *msg_obj, eMSG_Q_SUCCESS);
 
-   LOC_LOGV("%s: Received message 0x%08X rv = %d\n", __FUNCTION__, *msg_obj, rv);
-
-   return rv;
+   return eMSG_Q_SUCCESS;
 }
 
 /*===========================================================================
@@ -274,7 +203,7 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
   ===========================================================================*/
 msq_q_err_type msg_q_flush(void* msg_q_data)
 {
-   msq_q_err_type rv;
+   msg_q_elem* elem;
    if ( msg_q_data == NULL )
    {
       LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
@@ -285,16 +214,20 @@ msq_q_err_type msg_q_flush(void* msg_q_data)
 
    LOC_LOGD("%s: Flushing Message Queue\n", __FUNCTION__);
 
-   pthread_mutex_lock(&p_msg_q->list_mutex);
-
-   /* Remove all elements from the list */
-   rv = convert_linked_list_err_type(linked_list_flush(p_msg_q->msg_list));
-
-   pthread_mutex_unlock(&p_msg_q->list_mutex);
+   /* Remove all elements from the queue, only safe from the reader or
+      once the reader is gone */
+   while( (elem = (msg_q_elem*)mpsc_q_try_pop(&p_msg_q->q)) != NULL )
+   {
+      if( elem->dealloc != NULL )
+      {
+         elem->dealloc(elem->msg_obj);
+      }
+      free(elem);
+   }
 
    LOC_LOGD("%s: Message Queue flushed\n", __FUNCTION__);
 
-   return rv;
+   return eMSG_Q_SUCCESS;
 }
 
 /*===========================================================================
@@ -311,23 +244,16 @@ msq_q_err_type msg_q_unblock(void* msg_q_data)
    }
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
-   pthread_mutex_lock(&p_msg_q->list_mutex);
 
-   if( p_msg_q->unblocked )
+   if( p_msg_q->q.unblocked )
    {
       LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
-      pthread_mutex_unlock(&p_msg_q->list_mutex);
       return eMSG_Q_UNAVAILABLE_RESOURCE;
    }
 
    LOC_LOGD("%s: Unblocking Message Queue\n", __FUNCTION__);
-   /* Unblocking message queue */
-   p_msg_q->unblocked = 1;
-
-   /* Allow all the waiters to wake up */
-   pthread_cond_broadcast(&p_msg_q->list_cond);
-
-   pthread_mutex_unlock(&p_msg_q->list_mutex);
+   /* Unblocking message queue, allow all the waiters to wake up */
+   mpsc_q_unblock(&p_msg_q->q);
 
    LOC_LOGD("%s: Message Queue unblocked\n", __FUNCTION__);
 
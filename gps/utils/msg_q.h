@@ -141,6 +141,7 @@ FUNCTION    msg_q_rcv
 DESCRIPTION
    Retrieves data from the message queue. msg_obj is the oldest message received
    and pointer is simply removed from message queue.
+   Only a single thread may receive from a given queue.
 
    msg_q_data: Message Queue to copy data from into msgp.
    msg_obj:    Pointer to space to copy msg_q contents to.
@@ -162,6 +163,7 @@ FUNCTION    msg_q_flush
 
 DESCRIPTION
    Function removes all elements from the message queue.
+   Must be called from the receiving thread or after it has stopped.
 
    msg_q_data: Message Queue to remove elements from.
 